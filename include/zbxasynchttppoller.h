@@ -27,6 +27,7 @@ typedef struct
 	struct event_base			*ev;
 	struct event				*curl_timeout;
 	CURLM					*curl_handle;
+	CURLSH					*curl_share;
 	process_httpagent_result_callback_fn	process_httpagent_result;
 	httpagent_action_callback_fn		http_agent_action;
 	void					*http_agent_arg;
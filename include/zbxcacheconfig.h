@@ -780,7 +780,7 @@ void	zbx_dc_sync_kvs_paths(const struct zbx_json_parse *jp_kvs_paths, const zbx_
 		const char *config_ssl_key_location);
 void	zbx_dc_config_get_hostids_by_revision(zbx_uint64_t new_revision, zbx_vector_uint64_t *hostids);
 int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_get_config_forks_f get_config_forks,
-		zbx_uint64_t conf_cache_size, const char *hostname, char **error);
+		zbx_uint64_t conf_cache_size, const char *hostname, const char *snapshot_file, char **error);
 void	zbx_free_configuration_cache(void);
 
 void	zbx_dc_config_get_triggers_by_triggerids(zbx_dc_trigger_t *triggers, const zbx_uint64_t *triggerids,
@@ -1000,6 +1000,8 @@ int	zbx_dc_set_interfaces_availability(zbx_vector_availability_ptr_t *availabili
 int	zbx_dc_reset_interfaces_availability(zbx_vector_availability_ptr_t *interfaces);
 
 void	zbx_dc_config_history_sync_get_actions_eval(zbx_vector_action_eval_ptr_t *actions, unsigned char opflags);
+int	zbx_dc_config_history_sync_get_actions_eval_by_revision(zbx_vector_action_eval_ptr_t *actions,
+		unsigned char opflags, zbx_uint64_t *revision);
 
 int	zbx_dc_get_interfaces_availability(zbx_vector_availability_ptr_t *interfaces, int *ts);
 void	zbx_dc_touch_interfaces_availability(const zbx_vector_uint64_t *interfaceids);
@@ -1013,6 +1015,9 @@ void	zbx_dc_correlation_rules_get(zbx_correlation_rules_t *rules);
 
 void	zbx_dc_get_nested_hostgroupids(zbx_uint64_t *groupids, int groupids_num, zbx_vector_uint64_t *nested_groupids);
 void	zbx_dc_get_hostids_by_group_name(const char *name, zbx_vector_uint64_t *hostids);
+void	zbx_dc_get_hostgroup_hostids(zbx_uint64_t groupid, const zbx_vector_uint64_t *hostids,
+		zbx_vector_uint64_t *group_hostids);
+int	zbx_dc_check_functions_hostgroup(const zbx_vector_uint64_t *functionids, zbx_uint64_t groupid);
 
 void	zbx_free_item_tag(zbx_item_tag_t *item_tag);
 
@@ -1081,6 +1086,7 @@ typedef struct
 	zbx_uint64_t	connector;
 	zbx_uint64_t	proxy_group;		/* summary revision of all proxy groups */
 	zbx_uint64_t	proxy;			/* summary revision of all proxies */
+	zbx_uint64_t	action;			/* actions, action operations and conditions revision */
 }
 zbx_dc_revision_t;
 
@@ -120,4 +120,7 @@ void	zbx_vc_flush_stats(void);
 
 void	zbx_vc_add_new_items(const zbx_vector_uint64_pair_t *items);
 
+int	zbx_vc_snapshot_write(const char *filename, const char *ha_node_name, char **error);
+int	zbx_vc_snapshot_load(const char *filename, const char *ha_node_name, int min_time, char **error);
+
 #endif
@@ -623,6 +623,7 @@ typedef void	(*zbx_reset_event_recovery_func_t)(void);
 typedef void	(*zbx_export_events_func_t)(int events_export_enabled, zbx_vector_connector_filter_t *connector_filters,
 		unsigned char **data, size_t *data_alloc, size_t *data_offset);
 typedef void	(*zbx_events_update_itservices_func_t)(void);
+typedef void	(*zbx_events_update_problem_index_func_t)(void);
 
 typedef struct
 {
@@ -632,6 +633,7 @@ typedef struct
 	zbx_reset_event_recovery_func_t		reset_event_recovery_cb;
 	zbx_export_events_func_t		export_events_cb;
 	zbx_events_update_itservices_func_t	events_update_itservices_cb;
+	zbx_events_update_problem_index_func_t	events_update_problem_index_cb;
 } zbx_events_funcs_t;
 
 /* events callbacks end */
@@ -40,6 +40,21 @@ typedef struct
 }
 zbx_fping_host_t;
 
+/* hosts pinged with the same ping parameters */
+typedef struct
+{
+	zbx_fping_host_t	*hosts;
+	int			hosts_count;
+	int			requests_count;
+	int			period;
+	int			size;
+	int			timeout;
+	unsigned char		allow_redirect;
+	int			ret;		/* ping result: SUCCEED, NOTSUPPORTED or FAIL */
+	char			*error;		/* error message if ping result is NOTSUPPORTED */
+}
+zbx_fping_batch_t;
+
 typedef enum
 {
 	ICMPPING = 0,
@@ -75,5 +90,6 @@ void	zbx_init_icmpping_env(const char *prefix, long int id);
 
 int	zbx_ping(zbx_fping_host_t *hosts, int hosts_count, int requests_count, int period, int size, int timeout,
 		unsigned char allow_redirect, int rdns, char *error, size_t max_error_len);
+void	zbx_ping_batches(zbx_fping_batch_t *batches, int batches_num);
 
 #endif
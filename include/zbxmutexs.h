@@ -52,6 +52,7 @@ typedef enum
 	ZBX_MUTEX_REMOTE_COMMANDS,
 	ZBX_MUTEX_PROXY_BUFFER,
 	ZBX_MUTEX_VPS_MONITOR,
+	ZBX_MUTEX_SNMP_INDEX,
 	/* NOTE: Do not forget to sync changes here with mutex names in diag_add_locks_info()! */
 	ZBX_MUTEX_COUNT
 }
@@ -62,6 +63,7 @@ typedef enum
 	ZBX_RWLOCK_CONFIG = 0,
 	ZBX_RWLOCK_CONFIG_HISTORY,
 	ZBX_RWLOCK_VALUECACHE,
+	ZBX_RWLOCK_PROBLEM_INDEX,
 	ZBX_RWLOCK_COUNT,
 }
 zbx_rwlock_name_t;
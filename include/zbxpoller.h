@@ -17,6 +17,8 @@
 
 #include "zbxcacheconfig.h"
 #include "module.h"
+#include "zbxshmem.h"
+#include "zbxjson.h"
 
 ZBX_PTR_VECTOR_DECL(agent_result_ptr, AGENT_RESULT*)
 
@@ -83,4 +85,21 @@ void	zbx_shutdown_library_mt_snmp(const char *progname);
 
 void	zbx_clear_cache_snmp(unsigned char process_type, int process_num);
 
+typedef struct
+{
+	zbx_uint64_t	tables_num;
+	zbx_uint64_t	mappings_num;
+	zbx_uint64_t	hits;
+	zbx_uint64_t	misses;
+	zbx_uint64_t	expired;
+	zbx_uint64_t	updates;
+	zbx_uint64_t	low_memory;
+}
+zbx_snmp_index_cache_stats_t;
+
+int	zbx_snmp_index_cache_init(zbx_uint64_t cache_size, char **error);
+void	zbx_snmp_index_cache_destroy(void);
+int	zbx_snmp_index_cache_get_stats(zbx_snmp_index_cache_stats_t *stats, zbx_shmem_stats_t *mem);
+int	zbx_diag_add_snmpcache_info(const struct zbx_json_parse *jp, struct zbx_json *json, char **error);
+
 #endif /* ZABBIX_ZBX_POLLER_H*/
@@ -51,6 +51,8 @@ typedef struct
 	zbx_vector_prometheus_row_t		rows;
 	zbx_vector_prometheus_label_index_t	indexes;
 	zbx_hashset_t				hints;
+	zbx_hashset_t				strings;	/* interned metric and label names */
+	zbx_hashset_t				metrics;	/* rows indexed by metric name */
 	pthread_mutex_t				index_lock;
 }
 zbx_prometheus_t;
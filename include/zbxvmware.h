@@ -507,6 +507,15 @@ zbx_vmware_data_tags_t;
 
 typedef struct zbx_vmware_job zbx_vmware_job_t;
 
+/* vmware PropertyCollector change tracking state kept between service updates */
+typedef struct
+{
+	char	*cookie;	/* session cookie of the property filter owner */
+	char	*filter;	/* PropertyFilter object id */
+	char	*version;	/* data version of the last processed update */
+}
+zbx_vmware_changes_t;
+
 /* vmware service data */
 typedef struct
 {
@@ -567,6 +576,9 @@ typedef struct
 
 	/* vmware entity (vm, hv etc) and linked tags */
 	zbx_vmware_data_tags_t		data_tags;
+
+	/* inventory change tracking state */
+	zbx_vmware_changes_t		changes;
 }
 zbx_vmware_service_t;
 
@@ -162,6 +162,9 @@ typedef struct
 	zbx_ipc_client_t	*client;
 
 	zbx_am_alert_t		*alert;
+
+	/* media type of the last alert sent to alerter */
+	zbx_uint64_t		mediatypeid;
 }
 zbx_am_alerter_t;
 
@@ -1037,6 +1040,38 @@ static zbx_am_alerter_t	*am_get_alerter_by_client(zbx_am_t *manager, zbx_ipc_cli
 	return *alerter;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets free alerter, preferring the one that sent the last alert    *
+ *          of the same media type                                            *
+ *                                                                            *
+ * Parameters: manager     - [IN]                                             *
+ *             mediatypeid - [IN] media type of alert to be sent              *
+ *                                                                            *
+ * Return value: free alerter or NULL if all alerters are busy                *
+ *                                                                            *
+ * Comments: Alerters keep scripting environment with cached HTTP             *
+ *           connections between webhook runs, so sending alerts of the same  *
+ *           media type to the same alerter allows reusing keep-alive         *
+ *           connections to the webhook endpoint.                             *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_am_alerter_t	*am_pop_free_alerter(zbx_am_t *manager, zbx_uint64_t mediatypeid)
+{
+	for (int i = 0; i < manager->next_alerter_index; i++)
+	{
+		zbx_am_alerter_t	*alerter = manager->alerters.values[i];
+
+		if (NULL == alerter->alert && mediatypeid == alerter->mediatypeid)
+		{
+			zbx_queue_ptr_remove_value(&manager->free_alerters, alerter);
+			return alerter;
+		}
+	}
+
+	return (zbx_am_alerter_t *)zbx_queue_ptr_pop(&manager->free_alerters);
+}
+
 #if defined(HAVE_MYSQL)
 #	define ZBX_DATABASE_TYPE "MySQL"
 #elif defined(HAVE_ORACLE)
@@ -1175,6 +1210,8 @@ static int	am_init(zbx_am_t *manager, zbx_get_config_forks_f get_forks_cb, char
 		zbx_am_alerter_t	*alerter = (zbx_am_alerter_t *)zbx_malloc(NULL, sizeof(zbx_am_alerter_t));
 
 		alerter->client = NULL;
+		alerter->alert = NULL;
+		alerter->mediatypeid = 0;
 
 		zbx_vector_am_alerter_ptr_append(&manager->alerters, alerter);
 	}
@@ -1558,6 +1595,7 @@ static int	am_process_alert(zbx_am_t *manager, zbx_am_alerter_t *alerter, zbx_am
 	}
 
 	alerter->alert = alert;
+	alerter->mediatypeid = alert->mediatypeid;
 	zbx_ipc_client_send(alerter->client, command, data, data_len);
 	zbx_free(data);
 
@@ -2391,13 +2429,15 @@ ZBX_THREAD_ENTRY(zbx_alert_manager_thread, args)
 
 		while (SUCCEED == am_check_queue(&manager, now))
 		{
-			if (NULL == (alerter = (zbx_am_alerter_t *)zbx_queue_ptr_pop(&manager.free_alerters)))
+			if (SUCCEED == zbx_queue_ptr_empty(&manager.free_alerters))
 				break;
 
 			zbx_am_alert_t	*alert;
 			if (NULL == (alert = am_pop_alert(&manager)))
 				break;
 
+			alerter = am_pop_free_alerter(&manager, alert->mediatypeid);
+
 			if (FAIL == am_process_alert(&manager, alerter, alert, scripts_path))
 				zbx_queue_ptr_push(&manager.free_alerters, alerter);
 		}
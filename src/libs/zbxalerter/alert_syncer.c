@@ -725,6 +725,29 @@ static void	am_db_validate_tags_for_update(zbx_vector_events_tags_t *update_even
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds committed problem tags to open problem index                 *
+ *                                                                            *
+ * Parameters: events_tags         - [IN] added event tags                    *
+ *             add_problem_tags_cb - [IN] callback to add problem tags        *
+ *                                                                            *
+ ******************************************************************************/
+static void	am_problem_index_add_tags(const zbx_vector_events_tags_t *events_tags,
+		zbx_add_problem_tags_func_t add_problem_tags_cb)
+{
+	if (NULL == add_problem_tags_cb)
+		return;
+
+	for (int i = 0; i < events_tags->values_num; i++)
+	{
+		const zbx_event_tags_t	*event_tags = events_tags->values[i];
+
+		if (0 != event_tags->need_to_add_problem_tag)
+			add_problem_tags_cb(event_tags->eventid, &event_tags->tags);
+	}
+}
+
 static void	am_service_add_event_tags(zbx_vector_events_tags_t *events_tags)
 {
 	unsigned char	*data = NULL;
@@ -749,13 +772,16 @@ static void	am_service_add_event_tags(zbx_vector_events_tags_t *events_tags)
  *                                                                            *
  * Purpose: flushes alert results to database                                 *
  *                                                                            *
- * Parameters: mediatypes - [IN]                                              *
- *             data       - [IN] serialized alert results                     *
+ * Parameters: mediatypes          - [IN]                                     *
+ *             data                - [IN] serialized alert results            *
+ *             add_problem_tags_cb - [IN] callback to add problem tags to     *
+ *                                        open problem index                  *
  *                                                                            *
  * Return value: count of results                                             *
  *                                                                            *
  ******************************************************************************/
-static int	am_db_flush_results(zbx_hashset_t *mediatypes, const unsigned char *data)
+static int	am_db_flush_results(zbx_hashset_t *mediatypes, const unsigned char *data,
+		zbx_add_problem_tags_func_t add_problem_tags_cb)
 {
 	int				results_num;
 	zbx_vector_events_tags_t	update_events_tags;
@@ -842,7 +868,10 @@ static int	am_db_flush_results(zbx_hashset_t *mediatypes, const unsigned char *d
 		while (ZBX_DB_DOWN == (ret = zbx_db_commit()));
 
 		if (ZBX_DB_OK == ret)
+		{
+			am_problem_index_add_tags(&update_events_tags, add_problem_tags_cb);
 			am_service_add_event_tags(&update_events_tags);
+		}
 
 		for (int i = 0; i < results_num; i++)
 		{
@@ -1090,7 +1119,8 @@ ZBX_THREAD_ENTRY(zbx_alert_syncer_thread, args)
 					req_alerts = 1;
 					break;
 				case ZBX_IPC_ALERTER_RESULTS:
-					results_num = am_db_flush_results(&amdb.mediatypes, message->data);
+					results_num = am_db_flush_results(&amdb.mediatypes, message->data,
+							alert_syncer_args_in->add_problem_tags_cb);
 					break;
 				default:
 					zabbix_log(LOG_LEVEL_WARNING, "unrecognized message in alert syncer %d",
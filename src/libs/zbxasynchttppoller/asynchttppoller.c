@@ -199,6 +199,40 @@ static int	handle_socket(CURL *easy, curl_socket_t s, int action, void *userp, v
 	return 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates cURL share handle for easy handles of the multi session   *
+ *                                                                            *
+ * Return value: share handle or NULL if sharing is not available             *
+ *                                                                            *
+ * Comments: Connections are already cached by the multi handle, sharing      *
+ *           TLS sessions allows new connections to the same origin to resume *
+ *           the session instead of performing full handshake. The multi      *
+ *           session is used by a single thread, so no locking is required.   *
+ *                                                                            *
+ ******************************************************************************/
+static CURLSH	*async_httpagent_share_create(void)
+{
+	CURLSH		*share;
+	CURLSHcode	err;
+
+	if (NULL == (share = curl_share_init()))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot initialize cURL share handle");
+		return NULL;
+	}
+
+	if (CURLSHE_OK != (err = curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot set cURL share option: %s", curl_share_strerror(err));
+		curl_share_cleanup(share);
+
+		return NULL;
+	}
+
+	return share;
+}
+
 void	zbx_async_httpagent_init(void)
 {
 	CURLcode	err;
@@ -222,6 +256,7 @@ zbx_asynchttppoller_config	*zbx_async_httpagent_create(struct event_base *ev,
 	asynchttppoller_config->http_agent_action = httpagent_action_callback;
 	asynchttppoller_config->http_agent_arg = arg;
 	asynchttppoller_config->ev = ev;
+	asynchttppoller_config->curl_share = NULL;
 
 	if (NULL == (asynchttppoller_config->curl_handle = curl_multi_init()))
 	{
@@ -229,6 +264,16 @@ zbx_asynchttppoller_config	*zbx_async_httpagent_create(struct event_base *ev,
 		goto err;
 	}
 
+/* multiplexing was added in 7.43.0 (0x072b00) and is enabled by default since 7.62.0 */
+#if LIBCURL_VERSION_NUM >= 0x072b00
+	if (CURLM_OK != (merr = curl_multi_setopt(asynchttppoller_config->curl_handle, CURLMOPT_PIPELINING,
+			CURLPIPE_MULTIPLEX)))
+	{
+		*error = zbx_dsprintf(*error, "cannot set CURLMOPT_PIPELINING: %s", curl_multi_strerror(merr));
+		goto err;
+	}
+#endif
+
 	if (CURLM_OK != (merr = curl_multi_setopt(asynchttppoller_config->curl_handle, CURLMOPT_SOCKETFUNCTION,
 			handle_socket)))
 	{
@@ -263,6 +308,8 @@ zbx_asynchttppoller_config	*zbx_async_httpagent_create(struct event_base *ev,
 		goto err;
 	}
 
+	asynchttppoller_config->curl_share = async_httpagent_share_create();
+
 	return asynchttppoller_config;
 err:
 	if (NULL != asynchttppoller_config->curl_handle)
@@ -278,6 +325,9 @@ void	zbx_async_httpagent_clean(zbx_asynchttppoller_config *asynchttppoller_confi
 	if (NULL != asynchttppoller_config->curl_handle)
 		curl_multi_cleanup(asynchttppoller_config->curl_handle);
 
+	if (NULL != asynchttppoller_config->curl_share)
+		curl_share_cleanup(asynchttppoller_config->curl_share);
+
 	if (NULL != asynchttppoller_config->curl_timeout)
 		event_free(asynchttppoller_config->curl_timeout);
 }
@@ -124,6 +124,7 @@ int	sync_in_progress = 0;
 #define ZBX_SNMP_OID_TYPE_MACRO		2
 #define ZBX_SNMP_OID_TYPE_WALK		3
 #define ZBX_SNMP_OID_TYPE_GET		4
+#define ZBX_SNMP_OID_TYPE_DISCOVERY	5
 
 /* trigger is functional unless its expression contains disabled or not monitored items */
 #define TRIGGER_FUNCTIONAL_TRUE		0
@@ -496,6 +497,14 @@ static unsigned char	poller_by_item(unsigned char type, const char *key, unsigne
 				return ZBX_POLLER_TYPE_SNMP;
 			}
 
+			/* walk based OIDs are preferably processed by asynchronous pollers, */
+			/* normal pollers can still process them when there are none         */
+			if ((ZBX_SNMP_OID_TYPE_DYNAMIC == snmp_oid_type || ZBX_SNMP_OID_TYPE_DISCOVERY == snmp_oid_type) &&
+					0 != get_config_forks_cb(ZBX_PROCESS_TYPE_SNMP_POLLER))
+			{
+				return ZBX_POLLER_TYPE_SNMP;
+			}
+
 			if (0 == get_config_forks_cb(ZBX_PROCESS_TYPE_POLLER))
 				break;
 
@@ -557,8 +566,8 @@ static zbx_uint64_t	get_item_nextcheck_seed(ZBX_DC_ITEM *item, zbx_uint64_t inte
 	{
 		ZBX_DC_SNMPINTERFACE	*snmp;
 
-		if (ZBX_SNMP_OID_TYPE_WALK == item->itemtype.snmpitem->snmp_oid_type ||
-				ZBX_SNMP_OID_TYPE_GET == item->itemtype.snmpitem->snmp_oid_type)
+		if (ZBX_SNMP_OID_TYPE_NORMAL != item->itemtype.snmpitem->snmp_oid_type &&
+				ZBX_SNMP_OID_TYPE_MACRO != item->itemtype.snmpitem->snmp_oid_type)
 		{
 			return item->itemid;
 		}
@@ -3405,6 +3414,11 @@ static void	dc_item_type_update(int found, ZBX_DC_ITEM *item, zbx_item_type_t *o
 					item->itemtype.snmpitem->snmp_oid_type = ZBX_SNMP_OID_TYPE_WALK;
 				else if (0 == strncmp(item->itemtype.snmpitem->snmp_oid, "get[", ZBX_CONST_STRLEN("get[")))
 					item->itemtype.snmpitem->snmp_oid_type = ZBX_SNMP_OID_TYPE_GET;
+				else if (0 == strncmp(item->itemtype.snmpitem->snmp_oid, "discovery[",
+						ZBX_CONST_STRLEN("discovery[")))
+				{
+					item->itemtype.snmpitem->snmp_oid_type = ZBX_SNMP_OID_TYPE_DISCOVERY;
+				}
 				else if (NULL != strchr(item->itemtype.snmpitem->snmp_oid, '{'))
 					item->itemtype.snmpitem->snmp_oid_type = ZBX_SNMP_OID_TYPE_MACRO;
 				else if (NULL != strchr(item->itemtype.snmpitem->snmp_oid, '['))
@@ -8237,6 +8251,14 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 	DCsync_action_conditions(&action_condition_sync);
 	action_condition_sec2 = zbx_time() - sec;
 
+	if (0 != action_sync.add_num + action_sync.update_num + action_sync.remove_num +
+			action_op_sync.add_num + action_op_sync.update_num + action_op_sync.remove_num +
+			action_condition_sync.add_num + action_condition_sync.update_num +
+			action_condition_sync.remove_num)
+	{
+		config->revision.action = new_revision;
+	}
+
 	sec = zbx_time();
 	/* relies on triggers, must be after DCsync_triggers() */
 	DCsync_trigger_tags(&trigger_tag_sync);
@@ -8652,11 +8674,9 @@ out:
 	switch (dberr)
 	{
 		case ZBX_DB_OK:
-			if (ZBX_DBSYNC_INIT != changelog_sync_mode)
-			{
-				zbx_dbsync_env_flush_changelog();
-			}
-			else
+			zbx_dbsync_env_flush_changelog();
+
+			if (ZBX_DBSYNC_INIT == changelog_sync_mode)
 			{
 				/* set changelog initialized only if database records were synced and */
 				/* next time differential sync must be used                           */
@@ -9124,7 +9144,7 @@ size_t	zbx_maintenance_update_flags_num(void)
  *                                                                            *
  ******************************************************************************/
 int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_get_config_forks_f get_config_forks,
-		zbx_uint64_t conf_cache_size, const char *hostname, char **error)
+		zbx_uint64_t conf_cache_size, const char *hostname, const char *snapshot_file, char **error)
 {
 	int	i, ret;
 
@@ -9316,6 +9336,7 @@ int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_ge
 	if (0 != get_config_forks_cb(ZBX_PROCESS_TYPE_TIMER))
 	{
 		config->maintenance_update = ZBX_FLAG_MAINTENANCE_UPDATE_NONE;
+		config->maintenance_nextcheck = 0;
 		config->maintenance_update_flags = (zbx_uint64_t *)__config_shmem_malloc_func(NULL,
 				sizeof(zbx_uint64_t) * zbx_maintenance_update_flags_num());
 		memset(config->maintenance_update_flags, 0, sizeof(zbx_uint64_t) * zbx_maintenance_update_flags_num());
@@ -9340,7 +9361,7 @@ int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_ge
 	config->proxy_failover_delay = ZBX_PG_DEFAULT_FAILOVER_DELAY;
 	config->proxy_lastonline = 0;
 
-	zbx_dbsync_env_init(config);
+	zbx_dbsync_env_init(config, snapshot_file);
 
 #undef CREATE_HASHSET
 #undef CREATE_HASHSET_EXT
@@ -11729,8 +11750,7 @@ int	zbx_dc_config_get_poller_items(unsigned char poller_type, int config_timeout
 			if (ZBX_POLLER_TYPE_NORMAL == poller_type && ITEM_TYPE_SNMP == dc_item->type &&
 					0 == (ZBX_FLAG_DISCOVERY_RULE & dc_item->flags))
 			{
-				if (ZBX_SNMP_OID_TYPE_NORMAL == dc_item->itemtype.snmpitem->snmp_oid_type ||
-						ZBX_SNMP_OID_TYPE_DYNAMIC == dc_item->itemtype.snmpitem->snmp_oid_type)
+				if (ZBX_SNMP_OID_TYPE_NORMAL == dc_item->itemtype.snmpitem->snmp_oid_type)
 				{
 					max_items = DCconfig_get_suggested_snmp_vars_nolock(dc_item->interfaceid, NULL);
 				}
@@ -14697,6 +14717,114 @@ void	zbx_dc_get_hostids_by_group_name(const char *name, zbx_vector_uint64_t *hos
 	zbx_vector_uint64_uniq(hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets hosts from the specified list that belong to the group or    *
+ *          its nested groups                                                 *
+ *                                                                            *
+ * Parameter: groupid       - [IN] the group identifier                       *
+ *            hostids       - [IN] the host identifiers to check              *
+ *            group_hostids - [OUT] the hosts belonging to the group          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_get_hostgroup_hostids(zbx_uint64_t groupid, const zbx_vector_uint64_t *hostids,
+		zbx_vector_uint64_t *group_hostids)
+{
+	zbx_vector_uint64_t	groupids;
+
+	zbx_vector_uint64_create(&groupids);
+
+	WRLOCK_CACHE;
+
+	dc_get_nested_hostgroupids(groupid, &groupids);
+
+	for (int i = 0; i < groupids.values_num; i++)
+	{
+		const zbx_dc_hostgroup_t	*group;
+
+		if (NULL == (group = (const zbx_dc_hostgroup_t *)zbx_hashset_search(&config->hostgroups,
+				&groupids.values[i])))
+		{
+			continue;
+		}
+
+		for (int j = 0; j < hostids->values_num; j++)
+		{
+			if (NULL != zbx_hashset_search(&group->hostids, &hostids->values[j]))
+				zbx_vector_uint64_append(group_hostids, hostids->values[j]);
+		}
+	}
+
+	UNLOCK_CACHE;
+
+	zbx_vector_uint64_destroy(&groupids);
+
+	zbx_vector_uint64_sort(group_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(group_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if host of any of the specified functions belongs to the   *
+ *          group or its nested groups                                        *
+ *                                                                            *
+ * Parameter: functionids - [IN] the function identifiers                     *
+ *            groupid     - [IN] the group identifier                         *
+ *                                                                            *
+ * Return value: SUCCEED - at least one function host belongs to the group    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_check_functions_hostgroup(const zbx_vector_uint64_t *functionids, zbx_uint64_t groupid)
+{
+	int			ret = FAIL;
+	zbx_vector_uint64_t	groupids;
+
+	zbx_vector_uint64_create(&groupids);
+
+	WRLOCK_CACHE;
+
+	dc_get_nested_hostgroupids(groupid, &groupids);
+
+	for (int i = 0; i < functionids->values_num && SUCCEED != ret; i++)
+	{
+		const ZBX_DC_FUNCTION	*dc_function;
+		const ZBX_DC_ITEM	*dc_item;
+
+		if (NULL == (dc_function = (const ZBX_DC_FUNCTION *)zbx_hashset_search(&config->functions,
+				&functionids->values[i])))
+		{
+			continue;
+		}
+
+		if (NULL == (dc_item = (const ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &dc_function->itemid)))
+			continue;
+
+		for (int j = 0; j < groupids.values_num; j++)
+		{
+			const zbx_dc_hostgroup_t	*group;
+
+			if (NULL == (group = (const zbx_dc_hostgroup_t *)zbx_hashset_search(&config->hostgroups,
+					&groupids.values[j])))
+			{
+				continue;
+			}
+
+			if (NULL != zbx_hashset_search(&group->hostids, &dc_item->hostid))
+			{
+				ret = SUCCEED;
+				break;
+			}
+		}
+	}
+
+	UNLOCK_CACHE;
+
+	zbx_vector_uint64_destroy(&groupids);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: gets active proxy data by its name from configuration cache       *
@@ -839,6 +839,7 @@ typedef struct
 	int			active_until;
 	int			running_since;
 	int			running_until;
+	int			nextcheck;	/* time of the next possible maintenance state change */
 	zbx_vector_uint64_t	groupids;
 	zbx_vector_uint64_t	hostids;
 	zbx_vector_ptr_t	tags;
@@ -978,6 +979,8 @@ typedef struct
 	zbx_uint64_t		*maintenance_update_flags;	/* Array of flags to manage timer maintenance updates.*/
 								/* Each array member contains 0/1 flag for 64 timers  */
 								/* indicating if the timer must process maintenance.  */
+	int			maintenance_nextcheck;		/* time of the next possible maintenance state   */
+								/* change of any maintenance                      */
 
 	char			*session_token;
 
@@ -103,6 +103,10 @@ void	DCsync_maintenances(zbx_dbsync_t *sync)
 		ZBX_STR2UCHAR(maintenance->tags_evaltype, row[4]);
 		maintenance->active_since = atoi(row[2]);
 		maintenance->active_until = atoi(row[3]);
+
+		/* force maintenance state recalculation */
+		maintenance->nextcheck = 0;
+		config->maintenance_nextcheck = 0;
 	}
 
 	/* remove deleted maintenances */
@@ -303,6 +307,9 @@ void	DCsync_maintenance_periods(zbx_dbsync_t *sync)
 
 		if (0 == found)
 			zbx_vector_ptr_append(&maintenance->periods, period);
+
+		maintenance->nextcheck = 0;
+		config->maintenance_nextcheck = 0;
 	}
 
 	/* remove deleted maintenance tags */
@@ -323,6 +330,9 @@ void	DCsync_maintenance_periods(zbx_dbsync_t *sync)
 
 			if (FAIL != index)
 				zbx_vector_ptr_remove_noorder(&maintenance->periods, index);
+
+			maintenance->nextcheck = 0;
+			config->maintenance_nextcheck = 0;
 		}
 
 		zbx_hashset_remove_direct(&config->maintenance_periods, period);
@@ -688,6 +698,40 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates the next time when the specified maintenance period    *
+ *          can start                                                         *
+ *                                                                            *
+ * Parameter: period - [IN] the maintenance period                            *
+ *            now    - [IN] current time                                      *
+ *                                                                            *
+ * Return value: The time of today's period start time occurrence if it is    *
+ *               still ahead, otherwise the start of the next day.            *
+ *                                                                            *
+ * Comments: dc_check_maintenance_period() checks the period start time       *
+ *           occurrence of the current day (also for periods started the day  *
+ *           before), so the period state must be recalculated at both of     *
+ *           these times.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static time_t	dc_maintenance_period_next_start(const zbx_dc_maintenance_period_t *period, time_t now)
+{
+	struct tm	tm;
+	int		seconds;
+	time_t		day_start, period_start;
+
+	tm = *localtime(&now);
+	seconds = tm.tm_hour * SEC_PER_HOUR + tm.tm_min * SEC_PER_MIN + tm.tm_sec;
+	day_start = dc_subtract_time(now, seconds, &tm);
+	period_start = dc_subtract_time(day_start, -period->start_time, &tm);
+
+	if (now < period_start)
+		return period_start;
+
+	return dc_subtract_time(day_start, -SEC_PER_DAY, &tm);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: sets maintenance update flags for all timers                      *
@@ -834,6 +878,9 @@ int	zbx_dc_maintenance_check_immediate_update(void)
  * Comments: This function calculates if any maintenance period is running    *
  *           and based on that sets current maintenance state - running/idle  *
  *           and period start/end time.                                       *
+ *           Together with the state the time of the next possible state      *
+ *           change is calculated, so maintenances are recalculated only when *
+ *           some of their periods start or end or the configuration changes. *
  *                                                                            *
  ******************************************************************************/
 int	zbx_dc_update_maintenances(zbx_maintenance_timer_t maintenance_timer)
@@ -841,9 +888,11 @@ int	zbx_dc_update_maintenances(zbx_maintenance_timer_t maintenance_timer)
 	zbx_dc_maintenance_t		*maintenance;
 	zbx_dc_maintenance_period_t	*period;
 	zbx_hashset_iter_t		iter;
-	int				i, running_num = 0, started_num = 0, stopped_num = 0, ret = FAIL;
+	int				i, running_num = 0, started_num = 0, stopped_num = 0, checked_num = 0,
+					ret = FAIL;
 	unsigned char			state;
-	time_t				now, period_start, period_end, running_since, running_until;
+	time_t				now, period_start, period_end, running_since, running_until, nextcheck,
+					maintenance_nextcheck;
 	zbx_dc_config_t			*config = get_dc_config();
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -859,15 +908,43 @@ int	zbx_dc_update_maintenances(zbx_maintenance_timer_t maintenance_timer)
 			ret = SUCCEED;
 	}
 
+	/* maintenance states cannot change before the earliest scheduled recalculation, */
+	/* unless system time was moved backwards                                        */
+	maintenance_nextcheck = config->maintenance_nextcheck;
+
+	if (now < maintenance_nextcheck && maintenance_nextcheck - now <= SEC_PER_DAY)
+		goto out;
+
+	maintenance_nextcheck = now + SEC_PER_DAY;
+
 	zbx_hashset_iter_reset(&config->maintenances, &iter);
 	while (NULL != (maintenance = (zbx_dc_maintenance_t *)zbx_hashset_iter_next(&iter)))
 	{
+		if (now < maintenance->nextcheck && maintenance->nextcheck - now <= SEC_PER_DAY)
+		{
+			if (ZBX_MAINTENANCE_RUNNING == maintenance->state)
+				running_num++;
+
+			if (maintenance->nextcheck < maintenance_nextcheck)
+				maintenance_nextcheck = maintenance->nextcheck;
+
+			continue;
+		}
+
+		checked_num++;
 		state = ZBX_MAINTENANCE_IDLE;
 		running_since = 0;
 		running_until = 0;
+		nextcheck = now + SEC_PER_DAY;
 
-		if (now >= maintenance->active_since && now < maintenance->active_until)
+		if (now < maintenance->active_since)
+		{
+			nextcheck = MIN(nextcheck, maintenance->active_since);
+		}
+		else if (now < maintenance->active_until)
 		{
+			nextcheck = MIN(nextcheck, maintenance->active_until);
+
 			/* find the longest running maintenance period */
 			for (i = 0; i < maintenance->periods.values_num; i++)
 			{
@@ -882,10 +959,25 @@ int	zbx_dc_update_maintenances(zbx_maintenance_timer_t maintenance_timer)
 						running_since = period_start;
 						running_until = period_end;
 					}
+
+					nextcheck = MIN(nextcheck, period_end);
 				}
+				else if (TIMEPERIOD_TYPE_ONETIME == period->type && now < period->start_date)
+					nextcheck = MIN(nextcheck, period->start_date);
+
+				nextcheck = MIN(nextcheck, dc_maintenance_period_next_start(period, now));
 			}
 		}
 
+		/* recalculate during the next update if the next state change time cannot be determined */
+		if (nextcheck <= now)
+			nextcheck = now + 1;
+
+		maintenance->nextcheck = (int)nextcheck;
+
+		if (nextcheck < maintenance_nextcheck)
+			maintenance_nextcheck = nextcheck;
+
 		if (state == ZBX_MAINTENANCE_RUNNING)
 		{
 			if (ZBX_MAINTENANCE_IDLE == maintenance->state)
@@ -930,6 +1022,8 @@ int	zbx_dc_update_maintenances(zbx_maintenance_timer_t maintenance_timer)
 		}
 	}
 
+	config->maintenance_nextcheck = (int)maintenance_nextcheck;
+out:
 	if (MAINTENANCE_TIMER_PENDING == maintenance_timer)
 		config->maintenance_update = ZBX_FLAG_MAINTENANCE_UPDATE_NONE;
 	else
@@ -937,8 +1031,8 @@ int	zbx_dc_update_maintenances(zbx_maintenance_timer_t maintenance_timer)
 
 	UNLOCK_CACHE;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() started:%d stopped:%d running:%d", __func__,
-			started_num, stopped_num, running_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() checked:%d started:%d stopped:%d running:%d nextcheck:%d",
+			__func__, checked_num, started_num, stopped_num, running_num, (int)maintenance_nextcheck);
 
 	return ret;
 }
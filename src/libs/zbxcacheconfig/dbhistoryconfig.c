@@ -505,6 +505,59 @@ void	zbx_dc_config_history_sync_get_actions_eval(zbx_vector_action_eval_ptr_t *a
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() actions:%d", __func__, actions->values_num);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets action evaluation data if actions were changed since the     *
+ *          specified revision                                                *
+ *                                                                            *
+ * Parameters: actions  - [OUT] action evaluation data                        *
+ *             opflags  - [IN] flags specifying which actions to get based on *
+ *                             their operation classes                        *
+ *                             (see ZBX_ACTION_OPCLASS_* defines)             *
+ *             revision - [IN/OUT] the action revision known to caller,       *
+ *                                 updated with current revision              *
+ *                                                                            *
+ * Return value: SUCCEED - actions were changed and returned                  *
+ *               FAIL    - actions were not changed since the revision        *
+ *                                                                            *
+ * Comments: The returned actions must be freed with zbx_action_eval_free()   *
+ *           function later.                                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dc_config_history_sync_get_actions_eval_by_revision(zbx_vector_action_eval_ptr_t *actions,
+		unsigned char opflags, zbx_uint64_t *revision)
+{
+	const zbx_dc_action_t	*dc_action;
+	zbx_hashset_iter_t	iter;
+	zbx_dc_config_t		*dc_config = get_dc_config();
+	int			ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() revision:" ZBX_FS_UI64, __func__, *revision);
+
+	RDLOCK_CACHE_CONFIG_HISTORY;
+
+	if (dc_config->revision.action != *revision)
+	{
+		zbx_hashset_iter_reset(&dc_config->actions, &iter);
+
+		while (NULL != (dc_action = (const zbx_dc_action_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (0 != (opflags & dc_action->opflags))
+				zbx_vector_action_eval_ptr_append(actions, dc_action_eval_create(dc_action));
+		}
+
+		*revision = dc_config->revision.action;
+		ret = SUCCEED;
+	}
+
+	UNLOCK_CACHE_CONFIG_HISTORY;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s actions:%d", __func__, zbx_result_string(ret),
+			actions->values_num);
+
+	return ret;
+}
+
 /*
  *
  * The following functions are used to get data from configuration cache
@@ -18,6 +18,7 @@
 
 #include "zbx_host_constants.h"
 #include "zbx_trigger_constants.h"
+#include "zbx_item_constants.h"
 #include "zbxcrypto.h"
 #include "zbxeval.h"
 #include "zbxnum.h"
@@ -26,6 +27,7 @@
 #include "zbxstr.h"
 #include "zbxinterface.h"
 #include "zbxip.h"
+#include "version.h"
 #include <stddef.h>
 
 /* global correlation constants */
@@ -63,6 +65,47 @@
 
 #define ZBX_DBSYNC_BATCH_SIZE			1000
 
+/* items table columns selected by zbx_dbsync_compare_items() */
+#define ZBX_DBSYNC_ITEM_COLUMNS											\
+		"i.itemid,i.hostid,i.status,i.type,i.value_type,i.key_,i.snmp_oid,i.ipmi_sensor,i.delay,"	\
+		"i.trapper_hosts,i.logtimefmt,i.params,ir.state,i.authtype,i.username,i.password,"		\
+		"i.publickey,i.privatekey,i.flags,i.interfaceid,ir.lastlogsize,ir.mtime,"			\
+		"i.history,i.trends,i.inventory_link,i.valuemapid,i.units,ir.error,i.jmx_endpoint,"		\
+		"i.master_itemid,i.timeout,i.url,i.query_fields,i.posts,i.status_codes,"			\
+		"i.follow_redirects,i.post_type,i.http_proxy,i.headers,i.retrieve_mode,"			\
+		"i.request_method,i.output_format,i.ssl_cert_file,i.ssl_key_file,i.ssl_key_password,"		\
+		"i.verify_peer,i.verify_host,i.allow_traps,i.templateid,null"
+
+/* configuration snapshot streams of changelog based changesets */
+#define ZBX_DBSYNC_STREAM_NONE			0
+#define ZBX_DBSYNC_STREAM_HOSTS			1
+#define ZBX_DBSYNC_STREAM_HOST_TAGS		2
+#define ZBX_DBSYNC_STREAM_ITEMS			3
+#define ZBX_DBSYNC_STREAM_PROTOTYPE_ITEMS	4
+#define ZBX_DBSYNC_STREAM_ITEM_TAGS		5
+#define ZBX_DBSYNC_STREAM_ITEM_PREPROCS		6
+#define ZBX_DBSYNC_STREAM_TRIGGERS		7
+#define ZBX_DBSYNC_STREAM_TRIGGER_TAGS		8
+#define ZBX_DBSYNC_STREAM_FUNCTIONS		9
+#define ZBX_DBSYNC_STREAM_DRULES		10
+#define ZBX_DBSYNC_STREAM_DCHECKS		11
+#define ZBX_DBSYNC_STREAM_HTTPTESTS		12
+#define ZBX_DBSYNC_STREAM_HTTPTEST_FIELDS	13
+#define ZBX_DBSYNC_STREAM_HTTPSTEPS		14
+#define ZBX_DBSYNC_STREAM_HTTPSTEP_FIELDS	15
+#define ZBX_DBSYNC_STREAM_CONNECTORS		16
+#define ZBX_DBSYNC_STREAM_CONNECTOR_TAGS	17
+#define ZBX_DBSYNC_STREAM_PROXY_GROUPS		18
+/* number of snapshot streams - keep in sync with above defines */
+#define ZBX_DBSYNC_STREAM_COUNT			19
+
+/* configuration snapshot states */
+#define ZBX_DBSYNC_SNAPSHOT_OFF		0	/* snapshot is disabled */
+#define ZBX_DBSYNC_SNAPSHOT_IDLE	1	/* no snapshot operation is in progress */
+#define ZBX_DBSYNC_SNAPSHOT_BASE	2	/* rows of full synchronization are written to new snapshot */
+#define ZBX_DBSYNC_SNAPSHOT_LOADED	3	/* rows are taken from loaded snapshot */
+#define ZBX_DBSYNC_SNAPSHOT_APPEND	4	/* changed rows are appended to snapshot */
+
 typedef struct
 {
 	zbx_uint64_t	changelogid;
@@ -94,9 +137,53 @@ typedef struct
 
 	zbx_vector_dbsync_t 			syncs;
 	zbx_vector_dbsync_obj_changelog_t	changelog;
+
+	/* all changed object identifiers, used to filter out outdated rows of loaded snapshot */
+	zbx_vector_uint64_t			objectids;
 }
 zbx_dbsync_journal_t;
 
+typedef struct
+{
+	zbx_uint64_t	rowid;
+
+	/* the raw row - column pointers followed by column values in the same allocation */
+	char		**row;
+}
+zbx_dbsync_snapshot_row_t;
+
+typedef struct
+{
+	zbx_hashset_t	rows;
+	int		columns_num;
+}
+zbx_dbsync_snapshot_stream_t;
+
+typedef struct
+{
+	char				*filename;
+	char				*tmpname;
+	FILE				*file;
+
+	/* the snapshot state, see ZBX_DBSYNC_SNAPSHOT_* defines */
+	unsigned char			state;
+
+	/* set when configuration synchronization succeeded and snapshot changes must be committed */
+	unsigned char			commit;
+
+	/* set after the first attempt to load snapshot */
+	unsigned char			load_tried;
+
+	/* the size of snapshot base, 0 if there is no valid snapshot file to append changes to */
+	zbx_uint64_t			base_size;
+
+	/* the snapshot file size after the last commit */
+	zbx_uint64_t			commit_offset;
+
+	zbx_dbsync_snapshot_stream_t	streams[ZBX_DBSYNC_STREAM_COUNT];
+}
+zbx_dbsync_snapshot_t;
+
 typedef struct
 {
 	zbx_hashset_t			strpool;
@@ -107,6 +194,8 @@ typedef struct
 	zbx_dbsync_journal_t		journals[ZBX_DBSYNC_OBJ_COUNT];
 
 	zbx_vector_dbsync_t		changelog_dbsyncs;
+
+	zbx_dbsync_snapshot_t		snapshot;
 }
 zbx_dbsync_env_t;
 
@@ -269,37 +358,1135 @@ static void	dbsync_prepare(zbx_dbsync_t *sync, int columns_num, zbx_dbsync_prepr
 	memset(sync->row, 0, sizeof(char *) * (size_t)columns_num);
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: applies necessary pre-processing before row is compared/used      *
- *                                                                            *
- * Parameter: sync - [IN] the changeset                                       *
- *            row  - [IN/OUT] the data row                                    *
- *                                                                            *
- * Return value: the resulting row                                            *
- *                                                                            *
- ******************************************************************************/
-static char	**dbsync_preproc_row(zbx_dbsync_t *sync, char **row)
-{
-	int	i;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies necessary pre-processing before row is compared/used      *
+ *                                                                            *
+ * Parameter: sync - [IN] the changeset                                       *
+ *            row  - [IN/OUT] the data row                                    *
+ *                                                                            *
+ * Return value: the resulting row                                            *
+ *                                                                            *
+ ******************************************************************************/
+static char	**dbsync_preproc_row(zbx_dbsync_t *sync, char **row)
+{
+	int	i;
+
+	if (NULL == sync->preproc_row_func)
+		return row;
+
+	/* row is unchanged, preprocessing was not performed */
+	if (row == sync->preproc_row_func(sync, row))
+		return row;
+
+	/* free the resources allocated by last preprocessing call */
+	zbx_vector_ptr_clear_ext(&sync->columns, zbx_ptr_free);
+
+	for (i = 0; i < sync->columns_num; i++)
+	{
+		if (sync->row[i] != row[i])
+			zbx_vector_ptr_append(&sync->columns, sync->row[i]);
+	}
+
+	return sync->row;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Configuration snapshot keeps raw rows of the tables synchronized using     *
+ * changelog, allowing to restore configuration cache after restart by        *
+ * reading from database only the rows changed since the snapshot was taken.  *
+ *                                                                            *
+ * Snapshot file format:                                                      *
+ *   header    - signature, format version and Zabbix version                 *
+ *   records   - sequence of the following records:                           *
+ *     row       - stream, tag, row identifier and raw column values          *
+ *     changelog - identifier and clock of processed changelog record         *
+ *     commit    - time of successful configuration synchronization           *
+ *                                                                            *
+ * The file starts with snapshot base written after full synchronization.     *
+ * Every incremental synchronization appends changed rows and processed       *
+ * changelog records followed by commit record. Records after the last commit *
+ * record are ignored when loading snapshot.                                  *
+ *                                                                            *
+ ******************************************************************************/
+
+#define ZBX_DBSYNC_SNAPSHOT_SIGNATURE		"ZBXCCSNP"
+#define ZBX_DBSYNC_SNAPSHOT_SIGNATURE_LEN	ZBX_CONST_STRLEN(ZBX_DBSYNC_SNAPSHOT_SIGNATURE)
+#define ZBX_DBSYNC_SNAPSHOT_VERSION		1
+#define ZBX_DBSYNC_SNAPSHOT_BUFFER_SIZE		(ZBX_MEBIBYTE)
+#define ZBX_DBSYNC_SNAPSHOT_STRING_MAX		(ZBX_GIBIBYTE)
+#define ZBX_DBSYNC_SNAPSHOT_COLUMNS_MAX		1000
+#define ZBX_DBSYNC_SNAPSHOT_NULL_STRING		0xffffffff
+
+#define ZBX_DBSYNC_SNAPSHOT_RECORD_ROW		'R'
+#define ZBX_DBSYNC_SNAPSHOT_RECORD_CHANGELOG	'L'
+#define ZBX_DBSYNC_SNAPSHOT_RECORD_COMMIT	'C'
+
+/* snapshot is compacted when appended records exceed its base size by more than this */
+#define ZBX_DBSYNC_SNAPSHOT_COMPACT_SIZE	(16 * ZBX_MEBIBYTE)
+
+/* snapshot can be used only while the changelog records it depends on cannot be pruned */
+#define ZBX_DBSYNC_SNAPSHOT_MAX_AGE	(ZBX_DBSYNC_CHANGELOG_MAX_AGE - 2 * ZBX_DBSYNC_CHANGELOG_PRUNE_INTERVAL)
+
+static void	dbsync_snapshot_write_data(FILE *f, const void *data, size_t size)
+{
+	if (0 != size)
+		fwrite(data, size, 1, f);
+}
+
+static void	dbsync_snapshot_write_string(FILE *f, const char *str)
+{
+	zbx_uint32_t	len;
+
+	if (NULL == str)
+	{
+		len = ZBX_DBSYNC_SNAPSHOT_NULL_STRING;
+		dbsync_snapshot_write_data(f, &len, sizeof(len));
+		return;
+	}
+
+	len = (zbx_uint32_t)strlen(str);
+	dbsync_snapshot_write_data(f, &len, sizeof(len));
+	dbsync_snapshot_write_data(f, str, len);
+}
+
+static int	dbsync_snapshot_read_data(FILE *f, void *data, size_t size)
+{
+	if (0 != size && 1 != fread(data, size, 1, f))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes row record to snapshot file                                *
+ *                                                                            *
+ * Parameters: f           - [IN] the snapshot file                           *
+ *             stream      - [IN] the snapshot stream                         *
+ *             tag         - [IN] the row tag (see ZBX_DBSYNC_ROW_ defines)   *
+ *             rowid       - [IN] the row identifier                          *
+ *             columns_num - [IN] the number of columns                       *
+ *             row         - [IN] the raw row, NULL for removed rows          *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_write_row(FILE *f, unsigned char stream, unsigned char tag, zbx_uint64_t rowid,
+		int columns_num, char **row)
+{
+	unsigned char	type = ZBX_DBSYNC_SNAPSHOT_RECORD_ROW;
+	zbx_uint32_t	num = (NULL != row ? (zbx_uint32_t)columns_num : 0);
+	zbx_uint32_t	i;
+
+	dbsync_snapshot_write_data(f, &type, sizeof(type));
+	dbsync_snapshot_write_data(f, &stream, sizeof(stream));
+	dbsync_snapshot_write_data(f, &tag, sizeof(tag));
+	dbsync_snapshot_write_data(f, &rowid, sizeof(rowid));
+	dbsync_snapshot_write_data(f, &num, sizeof(num));
+
+	for (i = 0; i < num; i++)
+		dbsync_snapshot_write_string(f, row[i]);
+}
+
+static void	dbsync_snapshot_write_changelog(FILE *f, const zbx_dbsync_changelog_t *changelog)
+{
+	unsigned char	type = ZBX_DBSYNC_SNAPSHOT_RECORD_CHANGELOG;
+
+	dbsync_snapshot_write_data(f, &type, sizeof(type));
+	dbsync_snapshot_write_data(f, &changelog->changelogid, sizeof(changelog->changelogid));
+	dbsync_snapshot_write_data(f, &changelog->clock, sizeof(changelog->clock));
+}
+
+static void	dbsync_snapshot_write_commit(FILE *f)
+{
+	unsigned char	type = ZBX_DBSYNC_SNAPSHOT_RECORD_COMMIT;
+	int		now;
+
+	now = (int)time(NULL);
+
+	dbsync_snapshot_write_data(f, &type, sizeof(type));
+	dbsync_snapshot_write_data(f, &now, sizeof(now));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies row into single allocation                                 *
+ *                                                                            *
+ ******************************************************************************/
+static char	**dbsync_snapshot_row_dup(char **row, int columns_num)
+{
+	size_t	size, len;
+	int	i;
+	char	**dst, *ptr;
+
+	size = sizeof(char *) * (size_t)columns_num;
+
+	for (i = 0; i < columns_num; i++)
+	{
+		if (NULL != row[i])
+			size += strlen(row[i]) + 1;
+	}
+
+	dst = (char **)zbx_malloc(NULL, size);
+	ptr = (char *)(dst + columns_num);
+
+	for (i = 0; i < columns_num; i++)
+	{
+		if (NULL == row[i])
+		{
+			dst[i] = NULL;
+			continue;
+		}
+
+		len = strlen(row[i]) + 1;
+		memcpy(ptr, row[i], len);
+		dst[i] = ptr;
+		ptr += len;
+	}
+
+	return dst;
+}
+
+static void	dbsync_snapshot_streams_init(zbx_dbsync_snapshot_stream_t *streams)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_DBSYNC_STREAM_COUNT; i++)
+	{
+		zbx_hashset_create(&streams[i].rows, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		streams[i].columns_num = 0;
+	}
+}
+
+static void	dbsync_snapshot_streams_destroy(zbx_dbsync_snapshot_stream_t *streams)
+{
+	int				i;
+	zbx_hashset_iter_t		iter;
+	zbx_dbsync_snapshot_row_t	*srow;
+
+	for (i = 0; i < ZBX_DBSYNC_STREAM_COUNT; i++)
+	{
+		zbx_hashset_iter_reset(&streams[i].rows, &iter);
+		while (NULL != (srow = (zbx_dbsync_snapshot_row_t *)zbx_hashset_iter_next(&iter)))
+			zbx_free(srow->row);
+
+		zbx_hashset_destroy(&streams[i].rows);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets stream row, taking ownership of the row                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_stream_set(zbx_dbsync_snapshot_stream_t *stream, zbx_uint64_t rowid, char **row)
+{
+	zbx_dbsync_snapshot_row_t	*srow, srow_local;
+
+	if (NULL != (srow = (zbx_dbsync_snapshot_row_t *)zbx_hashset_search(&stream->rows, &rowid)))
+	{
+		zbx_free(srow->row);
+		srow->row = row;
+		return;
+	}
+
+	srow_local.rowid = rowid;
+	srow_local.row = row;
+	zbx_hashset_insert(&stream->rows, &srow_local, sizeof(srow_local));
+}
+
+static void	dbsync_snapshot_stream_remove(zbx_dbsync_snapshot_stream_t *stream, zbx_uint64_t rowid)
+{
+	zbx_dbsync_snapshot_row_t	*srow;
+
+	if (NULL != (srow = (zbx_dbsync_snapshot_row_t *)zbx_hashset_search(&stream->rows, &rowid)))
+	{
+		zbx_free(srow->row);
+		zbx_hashset_remove_direct(&stream->rows, srow);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads row record columns into single allocation                   *
+ *                                                                            *
+ * Parameters: f           - [IN] the snapshot file                           *
+ *             columns_num - [IN] the number of columns                       *
+ *             buf         - [IN/OUT] the read buffer                         *
+ *             buf_alloc   - [IN/OUT] the read buffer size                    *
+ *             offsets     - [IN/OUT] the column offset buffer                *
+ *             row         - [OUT] the row (optional)                         *
+ *                                                                            *
+ * Return value: SUCCEED - the columns were read successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_read_columns(FILE *f, int columns_num, char **buf, size_t *buf_alloc,
+		zbx_vector_uint64_t *offsets, char ***row)
+{
+	zbx_uint32_t	len;
+	size_t		offset = 0;
+	int		i;
+	char		*ptr;
+
+	zbx_vector_uint64_clear(offsets);
+
+	for (i = 0; i < columns_num; i++)
+	{
+		if (SUCCEED != dbsync_snapshot_read_data(f, &len, sizeof(len)))
+			return FAIL;
+
+		if (ZBX_DBSYNC_SNAPSHOT_NULL_STRING == len)
+		{
+			zbx_vector_uint64_append(offsets, ZBX_DBSYNC_SNAPSHOT_NULL_STRING);
+			continue;
+		}
+
+		if (ZBX_DBSYNC_SNAPSHOT_STRING_MAX < len)
+			return FAIL;
+
+		if (*buf_alloc < offset + len + 1)
+		{
+			while (*buf_alloc < offset + len + 1)
+				*buf_alloc *= 2;
+
+			*buf = (char *)zbx_realloc(*buf, *buf_alloc);
+		}
+
+		if (SUCCEED != dbsync_snapshot_read_data(f, *buf + offset, len))
+			return FAIL;
+
+		zbx_vector_uint64_append(offsets, offset);
+		offset += len;
+		(*buf)[offset++] = '\0';
+	}
+
+	if (NULL == row)
+		return SUCCEED;
+
+	*row = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)columns_num + offset);
+	ptr = (char *)(*row + columns_num);
+	memcpy(ptr, *buf, offset);
+
+	for (i = 0; i < columns_num; i++)
+	{
+		if (ZBX_DBSYNC_SNAPSHOT_NULL_STRING == offsets->values[i])
+			(*row)[i] = NULL;
+		else
+			(*row)[i] = ptr + offsets->values[i];
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads snapshot records                                            *
+ *                                                                            *
+ * Parameters: f           - [IN] the snapshot file positioned after header   *
+ *             records_num - [IN] the number of records to read, 0 to scan    *
+ *                                the whole file without loading rows         *
+ *             streams     - [OUT] the snapshot streams (optional)            *
+ *             changelog   - [OUT] the processed changelog records (optional) *
+ *             min_clock   - [IN] the minimum clock of changelog records to   *
+ *                                load                                        *
+ *             commit_records_num - [OUT] the number of records up to and     *
+ *                                        including the last commit record    *
+ *             commit_time        - [OUT] the time of the last commit         *
+ *             max_changelogid    - [OUT] the largest committed changelog     *
+ *                                        identifier                          *
+ *                                                                            *
+ * Return value: SUCCEED - the records were read successfully                 *
+ *               FAIL    - the snapshot file is corrupted                     *
+ *                                                                            *
+ * Comments: When scanning the reading stops at the first incomplete record,  *
+ *           which can be left by interrupted write.                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_read_records(FILE *f, zbx_uint64_t records_num, zbx_dbsync_snapshot_stream_t *streams,
+		zbx_hashset_t *changelog, int min_clock, zbx_uint64_t *commit_records_num, int *commit_time,
+		zbx_uint64_t *max_changelogid)
+{
+	int			ret = FAIL;
+	char			*buf;
+	size_t			buf_alloc = ZBX_KIBIBYTE;
+	zbx_uint64_t		changelogid_max = 0, num = 0;
+	zbx_vector_uint64_t	offsets;
+
+	buf = (char *)zbx_malloc(NULL, buf_alloc);
+	zbx_vector_uint64_create(&offsets);
+
+	for (; 0 == records_num || num < records_num; num++)
+	{
+		unsigned char		type, stream, tag;
+		zbx_uint64_t		rowid;
+		zbx_uint32_t		columns_num;
+		zbx_dbsync_changelog_t	changelog_local;
+		int			now;
+		char			**row = NULL;
+
+		if (SUCCEED != dbsync_snapshot_read_data(f, &type, sizeof(type)))
+			goto out;
+
+		switch (type)
+		{
+			case ZBX_DBSYNC_SNAPSHOT_RECORD_ROW:
+				if (SUCCEED != dbsync_snapshot_read_data(f, &stream, sizeof(stream)) ||
+						SUCCEED != dbsync_snapshot_read_data(f, &tag, sizeof(tag)) ||
+						SUCCEED != dbsync_snapshot_read_data(f, &rowid, sizeof(rowid)) ||
+						SUCCEED != dbsync_snapshot_read_data(f, &columns_num,
+								sizeof(columns_num)))
+				{
+					goto out;
+				}
+
+				if (ZBX_DBSYNC_STREAM_NONE == stream || ZBX_DBSYNC_STREAM_COUNT <= stream ||
+						ZBX_DBSYNC_SNAPSHOT_COLUMNS_MAX < columns_num)
+				{
+					goto out;
+				}
+
+				if (SUCCEED != dbsync_snapshot_read_columns(f, (int)columns_num, &buf, &buf_alloc,
+						&offsets, NULL == streams ? NULL : &row))
+				{
+					goto out;
+				}
+
+				if (NULL == streams)
+					break;
+
+				if (ZBX_DBSYNC_ROW_REMOVE == tag)
+				{
+					dbsync_snapshot_stream_remove(&streams[stream], rowid);
+					break;
+				}
+
+				if (0 == streams[stream].columns_num)
+				{
+					streams[stream].columns_num = (int)columns_num;
+				}
+				else if (streams[stream].columns_num != (int)columns_num)
+				{
+					zbx_free(row);
+					goto out;
+				}
+
+				dbsync_snapshot_stream_set(&streams[stream], rowid, row);
+				break;
+			case ZBX_DBSYNC_SNAPSHOT_RECORD_CHANGELOG:
+				if (SUCCEED != dbsync_snapshot_read_data(f, &changelog_local.changelogid,
+						sizeof(changelog_local.changelogid)) ||
+						SUCCEED != dbsync_snapshot_read_data(f, &changelog_local.clock,
+								sizeof(changelog_local.clock)))
+				{
+					goto out;
+				}
+
+				if (changelog_local.changelogid > changelogid_max)
+					changelogid_max = changelog_local.changelogid;
+
+				if (NULL != changelog && changelog_local.clock >= min_clock)
+					zbx_hashset_insert(changelog, &changelog_local, sizeof(changelog_local));
+				break;
+			case ZBX_DBSYNC_SNAPSHOT_RECORD_COMMIT:
+				if (SUCCEED != dbsync_snapshot_read_data(f, &now, sizeof(now)))
+					goto out;
+
+				if (NULL != commit_records_num)
+					*commit_records_num = num + 1;
+				if (NULL != commit_time)
+					*commit_time = now;
+				if (NULL != max_changelogid)
+					*max_changelogid = changelogid_max;
+				break;
+			default:
+				goto out;
+		}
+	}
+
+	ret = SUCCEED;
+out:
+	/* incomplete records are expected only at the end of scanned file */
+	if (0 == records_num)
+		ret = SUCCEED;
+
+	zbx_vector_uint64_destroy(&offsets);
+	zbx_free(buf);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads committed snapshot data from file                           *
+ *                                                                            *
+ * Parameters: streams         - [OUT] the snapshot streams                   *
+ *             changelog       - [OUT] the processed changelog records        *
+ *                                     (optional)                             *
+ *             min_clock       - [IN] the minimum clock of changelog records  *
+ *                                    to load                                 *
+ *             commit_time     - [OUT] the time of the last commit            *
+ *             max_changelogid - [OUT] the largest committed changelog        *
+ *                                     identifier                             *
+ *             error           - [OUT] the error message                      *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was read successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_read(zbx_dbsync_snapshot_stream_t *streams, zbx_hashset_t *changelog, int min_clock,
+		int *commit_time, zbx_uint64_t *max_changelogid, char **error)
+{
+	const char	*filename = dbsync_env.snapshot.filename;
+	FILE		*f;
+	int		ret = FAIL;
+	long		data_offset;
+	zbx_uint64_t	records_num = 0;
+	zbx_uint32_t	format_version, len;
+	char		signature[ZBX_DBSYNC_SNAPSHOT_SIGNATURE_LEN], version[] = ZABBIX_VERSION,
+			file_version[sizeof(version)];
+
+	if (NULL == (f = fopen(filename, "rb")))
+	{
+		*error = zbx_dsprintf(*error, "cannot open file: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	setvbuf(f, NULL, _IOFBF, ZBX_DBSYNC_SNAPSHOT_BUFFER_SIZE);
+
+	if (SUCCEED != dbsync_snapshot_read_data(f, signature, sizeof(signature)) ||
+			0 != memcmp(signature, ZBX_DBSYNC_SNAPSHOT_SIGNATURE, sizeof(signature)) ||
+			SUCCEED != dbsync_snapshot_read_data(f, &format_version, sizeof(format_version)) ||
+			SUCCEED != dbsync_snapshot_read_data(f, &len, sizeof(len)))
+	{
+		*error = zbx_strdup(*error, "invalid file header");
+		goto out;
+	}
+
+	if (ZBX_DBSYNC_SNAPSHOT_VERSION != format_version || sizeof(version) - 1 != len ||
+			SUCCEED != dbsync_snapshot_read_data(f, file_version, len) ||
+			0 != memcmp(version, file_version, len))
+	{
+		*error = zbx_strdup(*error, "snapshot was created by different Zabbix version");
+		goto out;
+	}
+
+	data_offset = ftell(f);
+
+	dbsync_snapshot_read_records(f, 0, NULL, NULL, 0, &records_num, commit_time, max_changelogid);
+
+	if (0 == records_num)
+	{
+		*error = zbx_strdup(*error, "snapshot does not contain committed data");
+		goto out;
+	}
+
+	if (0 != fseek(f, data_offset, SEEK_SET) || SUCCEED != dbsync_snapshot_read_records(f, records_num,
+			streams, changelog, min_clock, NULL, NULL, NULL))
+	{
+		*error = zbx_strdup(*error, "invalid snapshot record");
+		goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	fclose(f);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds column index in comma separated select column list          *
+ *                                                                            *
+ * Parameters: columns - [IN] select column list                              *
+ *             name    - [IN] column name                                     *
+ *                                                                            *
+ * Return value: column index or FAIL if column was not found                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_column_index(const char *columns, const char *name)
+{
+	size_t		len = strlen(name);
+	int		index = 0;
+	const char	*ptr = columns;
+
+	while (1)
+	{
+		if (0 == strncmp(ptr, name, len) && (',' == ptr[len] || '\0' == ptr[len]))
+			return index;
+
+		if (NULL == (ptr = strchr(ptr, ',')))
+			return FAIL;
+
+		ptr++;
+		index++;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates item runtime data in loaded snapshot                      *
+ *                                                                            *
+ * Parameters: stream - [IN/OUT] items stream                                 *
+ *             error  - [OUT]                                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the runtime data was updated                       *
+ *               FAIL    - snapshot item rows do not match item select        *
+ *                                                                            *
+ * Comments: Item runtime data changes are not registered in changelog, so    *
+ *           they are read from database for all items.                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_update_item_rtdata(zbx_dbsync_snapshot_stream_t *stream, char **error)
+{
+	/* item_rtdata columns in the same order as selected from item_rtdata table */
+	static const char		*names[] = {"ir.state", "ir.lastlogsize", "ir.mtime", "ir.error"};
+	static char			*defaults[] = {"0", "0", "0", ""};
+
+	zbx_db_result_t			result;
+	zbx_db_row_t			dbrow;
+	zbx_hashset_t			rtdata;
+	zbx_hashset_iter_t		iter;
+	zbx_dbsync_snapshot_row_t	*srow, srow_local, *rt;
+	size_t				i;
+	int				columns[ARRSIZE(names)];
+
+	for (i = 0; i < ARRSIZE(names); i++)
+	{
+		if (FAIL == (columns[i] = dbsync_column_index(ZBX_DBSYNC_ITEM_COLUMNS, names[i])) ||
+				stream->columns_num <= columns[i])
+		{
+			*error = zbx_dsprintf(*error, "snapshot items do not contain column \"%s\"", names[i]);
+			return FAIL;
+		}
+	}
+
+	zbx_hashset_create(&rtdata, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	result = zbx_db_select("select itemid,state,lastlogsize,mtime,error from item_rtdata"
+			" where state<>%d or lastlogsize<>0 or mtime<>0", ITEM_STATE_NORMAL);
+
+	while (NULL != (dbrow = zbx_db_fetch(result)))
+	{
+		ZBX_STR2UINT64(srow_local.rowid, dbrow[0]);
+		srow_local.row = dbsync_snapshot_row_dup(dbrow + 1, (int)ARRSIZE(columns));
+		zbx_hashset_insert(&rtdata, &srow_local, sizeof(srow_local));
+	}
+	zbx_db_free_result(result);
+
+	zbx_hashset_iter_reset(&stream->rows, &iter);
+	while (NULL != (srow = (zbx_dbsync_snapshot_row_t *)zbx_hashset_iter_next(&iter)))
+	{
+		char	**values, **row, **dup;
+
+		if (NULL != (rt = (zbx_dbsync_snapshot_row_t *)zbx_hashset_search(&rtdata, &srow->rowid)))
+			values = rt->row;
+		else
+			values = defaults;
+
+		for (i = 0; i < ARRSIZE(columns); i++)
+		{
+			if (NULL == srow->row[columns[i]] || NULL == values[i] ||
+					0 != strcmp(srow->row[columns[i]], values[i]))
+			{
+				break;
+			}
+		}
+
+		if (ARRSIZE(columns) == i)
+			continue;
+
+		row = (char **)zbx_malloc(NULL, sizeof(char *) * (size_t)stream->columns_num);
+		memcpy(row, srow->row, sizeof(char *) * (size_t)stream->columns_num);
+
+		for (i = 0; i < ARRSIZE(columns); i++)
+			row[columns[i]] = values[i];
+
+		/* row references strings of the old row, so it must be copied before freeing old row */
+		dup = dbsync_snapshot_row_dup(row, stream->columns_num);
+		zbx_free(row);
+		zbx_free(srow->row);
+		srow->row = dup;
+	}
+
+	zbx_hashset_iter_reset(&rtdata, &iter);
+	while (NULL != (rt = (zbx_dbsync_snapshot_row_t *)zbx_hashset_iter_next(&iter)))
+		zbx_free(rt->row);
+
+	zbx_hashset_destroy(&rtdata);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads snapshot if it can be used to restore configuration cache   *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was loaded                            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_load(void)
+{
+	zbx_dbsync_snapshot_t	*snapshot = &dbsync_env.snapshot;
+	zbx_hashset_t		changelog;
+	zbx_hashset_iter_t	iter;
+	zbx_dbsync_changelog_t	*changelog_rec;
+	zbx_db_result_t		result;
+	zbx_db_row_t		row;
+	zbx_uint64_t		max_changelogid = 0, db_max_changelogid = 0;
+	int			now, commit_time = 0, ret = FAIL;
+	char			*error = NULL;
+
+	if (0 != access(snapshot->filename, F_OK))
+		return FAIL;
+
+	now = (int)time(NULL);
+
+	dbsync_snapshot_streams_init(snapshot->streams);
+	zbx_hashset_create(&changelog, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	if (SUCCEED != dbsync_snapshot_read(snapshot->streams, &changelog, now - ZBX_DBSYNC_CHANGELOG_MAX_AGE,
+			&commit_time, &max_changelogid, &error))
+	{
+		goto out;
+	}
+
+	if (now - commit_time > ZBX_DBSYNC_SNAPSHOT_MAX_AGE || commit_time > now)
+	{
+		error = zbx_strdup(error, "snapshot is outdated");
+		goto out;
+	}
+
+	result = zbx_db_select("select max(changelogid) from changelog");
+
+	if (NULL != (row = zbx_db_fetch(result)))
+		ZBX_DBROW2UINT64(db_max_changelogid, row[0]);
+
+	zbx_db_free_result(result);
+
+	/* the database changelog must contain all changes registered after snapshot was taken */
+	if (max_changelogid > db_max_changelogid)
+	{
+		error = zbx_strdup(error, "database changelog does not match snapshot");
+		goto out;
+	}
+
+	if (SUCCEED != dbsync_snapshot_update_item_rtdata(&snapshot->streams[ZBX_DBSYNC_STREAM_ITEMS], &error))
+		goto out;
+
+	zbx_hashset_iter_reset(&changelog, &iter);
+	while (NULL != (changelog_rec = (zbx_dbsync_changelog_t *)zbx_hashset_iter_next(&iter)))
+		zbx_hashset_insert(&dbsync_env.changelog, changelog_rec, sizeof(zbx_dbsync_changelog_t));
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "loaded configuration snapshot \"%s\" taken %d seconds ago",
+			snapshot->filename, now - commit_time);
+
+	ret = SUCCEED;
+out:
+	if (SUCCEED != ret)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot load configuration snapshot \"%s\": %s", snapshot->filename,
+				error);
+		zbx_free(error);
+		dbsync_snapshot_streams_destroy(snapshot->streams);
+	}
+
+	zbx_hashset_destroy(&changelog);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: disables snapshot and removes snapshot files                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_disable(const char *error)
+{
+	zbx_dbsync_snapshot_t	*snapshot = &dbsync_env.snapshot;
+
+	zabbix_log(LOG_LEVEL_WARNING, "configuration snapshot \"%s\" is disabled: %s", snapshot->filename, error);
+
+	if (NULL != snapshot->file)
+	{
+		fclose(snapshot->file);
+		snapshot->file = NULL;
+	}
+
+	if (ZBX_DBSYNC_SNAPSHOT_LOADED == snapshot->state)
+		dbsync_snapshot_streams_destroy(snapshot->streams);
+
+	unlink(snapshot->tmpname);
+	unlink(snapshot->filename);
+
+	snapshot->state = ZBX_DBSYNC_SNAPSHOT_OFF;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates temporary snapshot file and writes its header             *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_create(void)
+{
+	zbx_dbsync_snapshot_t	*snapshot = &dbsync_env.snapshot;
+	zbx_uint32_t		format_version = ZBX_DBSYNC_SNAPSHOT_VERSION;
+	char			*error, version[] = ZABBIX_VERSION;
+	int			fd;
+
+	/* snapshot contains credentials, remove leftover file so it is recreated readable by owner only */
+	unlink(snapshot->tmpname);
+
+	if (-1 == (fd = open(snapshot->tmpname, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)) ||
+			NULL == (snapshot->file = fdopen(fd, "wb")))
+	{
+		error = zbx_dsprintf(NULL, "cannot create file \"%s\": %s", snapshot->tmpname,
+				zbx_strerror(errno));
+
+		if (-1 != fd)
+			close(fd);
+
+		dbsync_snapshot_disable(error);
+		zbx_free(error);
+
+		return FAIL;
+	}
+
+	setvbuf(snapshot->file, NULL, _IOFBF, ZBX_DBSYNC_SNAPSHOT_BUFFER_SIZE);
+
+	dbsync_snapshot_write_data(snapshot->file, ZBX_DBSYNC_SNAPSHOT_SIGNATURE, ZBX_DBSYNC_SNAPSHOT_SIGNATURE_LEN);
+	dbsync_snapshot_write_data(snapshot->file, &format_version, sizeof(format_version));
+	dbsync_snapshot_write_string(snapshot->file, version);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes processed changelog and commit record to temporary         *
+ *          snapshot file and replaces the snapshot with it                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_commit_base(void)
+{
+	zbx_dbsync_snapshot_t	*snapshot = &dbsync_env.snapshot;
+	zbx_hashset_iter_t	iter;
+	zbx_dbsync_changelog_t	*changelog;
+	long			size;
+	char			*error = NULL;
+
+	zbx_hashset_iter_reset(&dbsync_env.changelog, &iter);
+	while (NULL != (changelog = (zbx_dbsync_changelog_t *)zbx_hashset_iter_next(&iter)))
+		dbsync_snapshot_write_changelog(snapshot->file, changelog);
+
+	dbsync_snapshot_write_commit(snapshot->file);
+
+	if (0 != fflush(snapshot->file) || 0 != ferror(snapshot->file) || -1 == (size = ftell(snapshot->file)))
+	{
+		error = zbx_dsprintf(NULL, "cannot write file \"%s\": %s", snapshot->tmpname, zbx_strerror(errno));
+		goto out;
+	}
+
+	if (0 != fclose(snapshot->file))
+	{
+		snapshot->file = NULL;
+		error = zbx_dsprintf(NULL, "cannot close file \"%s\": %s", snapshot->tmpname, zbx_strerror(errno));
+		goto out;
+	}
+
+	snapshot->file = NULL;
+
+	if (0 != rename(snapshot->tmpname, snapshot->filename))
+	{
+		error = zbx_dsprintf(NULL, "cannot rename file \"%s\" to \"%s\": %s", snapshot->tmpname,
+				snapshot->filename, zbx_strerror(errno));
+		goto out;
+	}
+
+	snapshot->base_size = (zbx_uint64_t)size;
+	snapshot->commit_offset = (zbx_uint64_t)size;
+	snapshot->state = ZBX_DBSYNC_SNAPSHOT_IDLE;
+out:
+	if (NULL != error)
+	{
+		dbsync_snapshot_disable(error);
+		zbx_free(error);
+
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes snapshot base from snapshot streams                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_snapshot_write_base(zbx_dbsync_snapshot_stream_t *streams)
+{
+	unsigned char			i;
+	zbx_hashset_iter_t		iter;
+	zbx_dbsync_snapshot_row_t	*srow;
+
+	if (SUCCEED != dbsync_snapshot_create())
+		return FAIL;
+
+	for (i = 0; i < ZBX_DBSYNC_STREAM_COUNT; i++)
+	{
+		zbx_hashset_iter_reset(&streams[i].rows, &iter);
+		while (NULL != (srow = (zbx_dbsync_snapshot_row_t *)zbx_hashset_iter_next(&iter)))
+		{
+			dbsync_snapshot_write_row(dbsync_env.snapshot.file, i, ZBX_DBSYNC_ROW_ADD, srow->rowid,
+					streams[i].columns_num, srow->row);
+		}
+	}
+
+	return dbsync_snapshot_commit_base();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: rewrites snapshot without superseded records                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_compact(void)
+{
+	zbx_dbsync_snapshot_stream_t	streams[ZBX_DBSYNC_STREAM_COUNT];
+	int				commit_time;
+	zbx_uint64_t			max_changelogid;
+	char				*error = NULL;
+
+	dbsync_snapshot_streams_init(streams);
+
+	if (SUCCEED == dbsync_snapshot_read(streams, NULL, 0, &commit_time, &max_changelogid, &error))
+	{
+		if (SUCCEED == dbsync_snapshot_write_base(streams))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "compacted configuration snapshot to " ZBX_FS_UI64 " bytes",
+					dbsync_env.snapshot.base_size);
+		}
+	}
+	else
+	{
+		dbsync_snapshot_disable(error);
+		zbx_free(error);
+	}
+
+	dbsync_snapshot_streams_destroy(streams);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares snapshot for configuration synchronization               *
+ *                                                                            *
+ * Parameters: mode - [IN] the changelog synchronization mode                 *
+ *                                                                            *
+ * Return value: the mode changelog must be read with                         *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	dbsync_snapshot_prepare(unsigned char mode)
+{
+	zbx_dbsync_snapshot_t	*snapshot = &dbsync_env.snapshot;
+	long			size;
+	char			*error;
+
+	snapshot->commit = 0;
+
+	if (ZBX_DBSYNC_SNAPSHOT_IDLE != snapshot->state)
+		return mode;
+
+	if (ZBX_DBSYNC_INIT == mode)
+	{
+		if (0 == snapshot->load_tried)
+		{
+			snapshot->load_tried = 1;
+
+			if (SUCCEED == dbsync_snapshot_load())
+			{
+				snapshot->state = ZBX_DBSYNC_SNAPSHOT_LOADED;
+
+				/* changes since the snapshot was taken are read from changelog */
+				return ZBX_DBSYNC_UPDATE;
+			}
+		}
+
+		if (SUCCEED == dbsync_snapshot_create())
+			snapshot->state = ZBX_DBSYNC_SNAPSHOT_BASE;
+
+		return mode;
+	}
+
+	if (0 == snapshot->base_size)
+		return mode;
+
+	if (NULL == (snapshot->file = fopen(snapshot->filename, "ab")))
+	{
+		error = zbx_dsprintf(NULL, "cannot open file: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	if (0 != fseek(snapshot->file, 0, SEEK_END) || -1 == (size = ftell(snapshot->file)))
+	{
+		error = zbx_dsprintf(NULL, "cannot get file size: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	/* discard data left after the last commit, otherwise appended records would be ignored when loading */
+	if ((zbx_uint64_t)size != snapshot->commit_offset &&
+			0 != ftruncate(fileno(snapshot->file), (off_t)snapshot->commit_offset))
+	{
+		error = zbx_dsprintf(NULL, "cannot truncate file: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	setvbuf(snapshot->file, NULL, _IOFBF, ZBX_DBSYNC_SNAPSHOT_BUFFER_SIZE);
+	snapshot->state = ZBX_DBSYNC_SNAPSHOT_APPEND;
+
+	return mode;
+fail:
+	dbsync_snapshot_disable(error);
+	zbx_free(error);
+
+	return mode;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: registers row change in snapshot                                  *
+ *                                                                            *
+ * Parameters: sync  - [IN] the changeset                                     *
+ *             rowid - [IN] the row identifier                                *
+ *             tag   - [IN] the row tag (see ZBX_DBSYNC_ROW_ defines)         *
+ *             dbrow - [IN] the raw database row, NULL for removed rows       *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_add_row(zbx_dbsync_t *sync, zbx_uint64_t rowid, unsigned char tag,
+		const zbx_db_row_t dbrow)
+{
+	zbx_dbsync_snapshot_t	*snapshot = &dbsync_env.snapshot;
+
+	if (ZBX_DBSYNC_STREAM_NONE == sync->stream)
+		return;
+
+	switch (snapshot->state)
+	{
+		case ZBX_DBSYNC_SNAPSHOT_BASE:
+		case ZBX_DBSYNC_SNAPSHOT_APPEND:
+			dbsync_snapshot_write_row(snapshot->file, sync->stream, tag, rowid, sync->columns_num, dbrow);
+			break;
+		case ZBX_DBSYNC_SNAPSHOT_LOADED:
+			if (ZBX_DBSYNC_ROW_REMOVE == tag)
+			{
+				dbsync_snapshot_stream_remove(&snapshot->streams[sync->stream], rowid);
+			}
+			else
+			{
+				dbsync_snapshot_stream_set(&snapshot->streams[sync->stream], rowid,
+						dbsync_snapshot_row_dup(dbrow, sync->columns_num));
+			}
+			break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: registers processed changelog record in snapshot                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_add_changelog(const zbx_dbsync_changelog_t *changelog)
+{
+	/* snapshot base gets all processed changelog records when it's committed */
+	if (ZBX_DBSYNC_SNAPSHOT_APPEND == dbsync_env.snapshot.state)
+		dbsync_snapshot_write_changelog(dbsync_env.snapshot.file, changelog);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: commits snapshot changes made during successful configuration     *
+ *          synchronization or discards them otherwise                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_snapshot_finish(void)
+{
+	zbx_dbsync_snapshot_t	*snapshot = &dbsync_env.snapshot;
+	long			size = 0;
+	char			*error = NULL;
+
+	switch (snapshot->state)
+	{
+		case ZBX_DBSYNC_SNAPSHOT_BASE:
+			if (0 != snapshot->commit)
+			{
+				if (SUCCEED == dbsync_snapshot_commit_base())
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "written configuration snapshot of " ZBX_FS_UI64
+							" bytes", snapshot->base_size);
+				}
+				break;
+			}
+
+			fclose(snapshot->file);
+			snapshot->file = NULL;
+			unlink(snapshot->tmpname);
+			snapshot->state = ZBX_DBSYNC_SNAPSHOT_IDLE;
+			break;
+		case ZBX_DBSYNC_SNAPSHOT_LOADED:
+			if (0 != snapshot->commit)
+			{
+				zbx_dbsync_snapshot_stream_t	streams[ZBX_DBSYNC_STREAM_COUNT];
+
+				/* loaded streams are freed before writing, so the state is reset first */
+				memcpy(streams, snapshot->streams, sizeof(streams));
+				snapshot->state = ZBX_DBSYNC_SNAPSHOT_IDLE;
+				dbsync_snapshot_write_base(streams);
+				dbsync_snapshot_streams_destroy(streams);
+				break;
+			}
+
+			dbsync_snapshot_streams_destroy(snapshot->streams);
+			snapshot->state = ZBX_DBSYNC_SNAPSHOT_IDLE;
+			break;
+		case ZBX_DBSYNC_SNAPSHOT_APPEND:
+			if (0 != snapshot->commit)
+				dbsync_snapshot_write_commit(snapshot->file);
+
+			if (0 != fflush(snapshot->file) || 0 != ferror(snapshot->file) ||
+					-1 == (size = ftell(snapshot->file)))
+			{
+				error = zbx_dsprintf(NULL, "cannot write file: %s", zbx_strerror(errno));
+			}
+			else if (0 == snapshot->commit && (zbx_uint64_t)size != snapshot->commit_offset &&
+					0 != ftruncate(fileno(snapshot->file), (off_t)snapshot->commit_offset))
+			{
+				error = zbx_dsprintf(NULL, "cannot truncate file: %s", zbx_strerror(errno));
+			}
+
+			if (NULL != error)
+			{
+				dbsync_snapshot_disable(error);
+				zbx_free(error);
+				break;
+			}
 
-	if (NULL == sync->preproc_row_func)
-		return row;
+			fclose(snapshot->file);
+			snapshot->file = NULL;
+			snapshot->state = ZBX_DBSYNC_SNAPSHOT_IDLE;
 
-	/* row is unchanged, preprocessing was not performed */
-	if (row == sync->preproc_row_func(sync, row))
-		return row;
+			if (0 == snapshot->commit)
+				break;
 
-	/* free the resources allocated by last preprocessing call */
-	zbx_vector_ptr_clear_ext(&sync->columns, zbx_ptr_free);
+			snapshot->commit_offset = (zbx_uint64_t)size;
 
-	for (i = 0; i < sync->columns_num; i++)
-	{
-		if (sync->row[i] != row[i])
-			zbx_vector_ptr_append(&sync->columns, sync->row[i]);
+			if (snapshot->commit_offset > snapshot->base_size * 2 + ZBX_DBSYNC_SNAPSHOT_COMPACT_SIZE)
+				dbsync_snapshot_compact();
+			break;
 	}
 
-	return sync->row;
+	snapshot->commit = 0;
 }
 
 static void	dbsync_journal_init(zbx_dbsync_journal_t *journal)
@@ -311,6 +1498,8 @@ static void	dbsync_journal_init(zbx_dbsync_journal_t *journal)
 	zbx_vector_dbsync_create(&journal->syncs);
 
 	zbx_vector_dbsync_obj_changelog_create(&journal->changelog);
+
+	zbx_vector_uint64_create(&journal->objectids);
 }
 
 static void	dbsync_journal_destroy(zbx_dbsync_journal_t *journal)
@@ -322,12 +1511,34 @@ static void	dbsync_journal_destroy(zbx_dbsync_journal_t *journal)
 	zbx_vector_dbsync_destroy(&journal->syncs);
 
 	zbx_vector_dbsync_obj_changelog_destroy(&journal->changelog);
+
+	zbx_vector_uint64_destroy(&journal->objectids);
 }
 
-void	zbx_dbsync_env_init(zbx_dc_config_t *cache)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes synchronization environment                           *
+ *                                                                            *
+ * Parameters: cache         - [IN] the configuration cache                   *
+ *             snapshot_file - [IN] the configuration snapshot file, NULL if  *
+ *                                  snapshot is disabled                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_init(zbx_dc_config_t *cache, const char *snapshot_file)
 {
 	dbsync_env.cache = cache;
 	zbx_hashset_create(&dbsync_env.changelog, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	memset(&dbsync_env.snapshot, 0, sizeof(dbsync_env.snapshot));
+
+	if (NULL != snapshot_file)
+	{
+		dbsync_env.snapshot.filename = zbx_strdup(NULL, snapshot_file);
+		dbsync_env.snapshot.tmpname = zbx_dsprintf(NULL, "%s.tmp", snapshot_file);
+		dbsync_env.snapshot.state = ZBX_DBSYNC_SNAPSHOT_IDLE;
+	}
+	else
+		dbsync_env.snapshot.state = ZBX_DBSYNC_SNAPSHOT_OFF;
 }
 
 /******************************************************************************
@@ -451,7 +1662,7 @@ int	zbx_dbsync_env_prepare(unsigned char mode)
 	for (i = 0; i < ARRSIZE(dbsync_env.journals); i++)
 		dbsync_journal_init(&dbsync_env.journals[i]);
 
-	if (ZBX_DBSYNC_INIT == mode)
+	if (ZBX_DBSYNC_INIT == dbsync_snapshot_prepare(mode))
 	{
 		result = zbx_db_select("select changelogid,clock from changelog");
 
@@ -517,6 +1728,18 @@ int	zbx_dbsync_env_prepare(unsigned char mode)
 		dbsync_remove_duplicate_ids(&dbsync_env.journals[i].inserts, &dbsync_env.journals[i].deletes);
 		dbsync_remove_duplicate_ids(&dbsync_env.journals[i].updates, &dbsync_env.journals[i].deletes);
 		dbsync_remove_duplicate_ids(&dbsync_env.journals[i].updates, &dbsync_env.journals[i].inserts);
+
+		if (ZBX_DBSYNC_SNAPSHOT_LOADED == dbsync_env.snapshot.state)
+		{
+			zbx_dbsync_journal_t	*journal = &dbsync_env.journals[i];
+
+			zbx_vector_uint64_append_array(&journal->objectids, journal->inserts.values,
+					journal->inserts.values_num);
+			zbx_vector_uint64_append_array(&journal->objectids, journal->updates.values,
+					journal->updates.values_num);
+			zbx_vector_uint64_append_array(&journal->objectids, journal->deletes.values,
+					journal->deletes.values_num);
+		}
 	}
 
 	zbx_vector_dbsync_create(&dbsync_env.changelog_dbsyncs);
@@ -532,7 +1755,7 @@ static void	dbsync_env_flush_journal(zbx_dbsync_journal_t *journal)
 	if (0 == journal->changelog.values_num)
 		return;
 
-	objects_num = journal->inserts.values_num + journal->updates.values_num;
+	objects_num = journal->inserts.values_num + journal->updates.values_num + journal->deletes.values_num;
 
 	for (i = 0; i < journal->syncs.values_num; i++)
 		objects_num += journal->syncs.values[i]->rows.values_num;
@@ -556,12 +1779,17 @@ static void	dbsync_env_flush_journal(zbx_dbsync_journal_t *journal)
 	for (i = 0; i < journal->updates.values_num; i++)
 		zbx_hashset_insert(&objectids, &journal->updates.values[i], sizeof(journal->updates.values[i]));
 
+	/* journals without changesets are not read when loading configuration from snapshot */
+	for (i = 0; i < journal->deletes.values_num; i++)
+		zbx_hashset_insert(&objectids, &journal->deletes.values[i], sizeof(journal->deletes.values[i]));
+
 	for (i = 0; i < journal->changelog.values_num; i++)
 	{
 		if (NULL != zbx_hashset_search(&objectids, &journal->changelog.values[i].objectid))
 		{
 			zbx_hashset_insert(&dbsync_env.changelog, &journal->changelog.values[i].changelog,
 					sizeof(zbx_dbsync_changelog_t));
+			dbsync_snapshot_add_changelog(&journal->changelog.values[i].changelog);
 		}
 	}
 
@@ -575,6 +1803,8 @@ void	zbx_dbsync_env_flush_changelog(void)
 	for (i = 0; i < (int)ARRSIZE(dbsync_env.journals); i++)
 		dbsync_env_flush_journal(&dbsync_env.journals[i]);
 
+	dbsync_env.snapshot.commit = 1;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() changelog  : %d (%d slots)", __func__,
 			dbsync_env.changelog.num_data, dbsync_env.changelog.num_slots);
 
@@ -587,6 +1817,7 @@ void	zbx_dbsync_env_clear(void)
 	zbx_vector_dbsync_destroy(&dbsync_env.changelog_dbsyncs);
 
 	dbsync_prune_changelog();
+	dbsync_snapshot_finish();
 
 	zbx_hashset_destroy(&dbsync_env.strpool);
 
@@ -636,7 +1867,7 @@ static int	dbsync_get_rows(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, si
 	char			**row;
 	size_t			sql_offset_reset = *sql_offset;
 	zbx_uint64_t		rowid, *batch;
-	int			batch_size;
+	int			batch_size, i;
 	zbx_vector_uint64_t	read_ids;
 
 	zbx_vector_uint64_create(&read_ids);
@@ -657,6 +1888,8 @@ static int	dbsync_get_rows(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, si
 		while (NULL != (dbrow = zbx_db_fetch(result)))
 		{
 			ZBX_STR2UINT64(rowid, dbrow[0]);
+			dbsync_snapshot_add_row(sync, rowid, tag, dbrow);
+
 			if (NULL != (row = dbsync_preproc_row(sync, dbrow)))
 				dbsync_add_row(sync, rowid, tag, row);
 
@@ -668,6 +1901,10 @@ static int	dbsync_get_rows(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, si
 	zbx_vector_uint64_sort(&read_ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 	dbsync_remove_duplicate_ids(ids, &read_ids);
 
+	/* objects no longer matching the query must not be restored from snapshot */
+	for (i = 0; i < ids->values_num; i++)
+		dbsync_snapshot_add_row(sync, ids->values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
+
 	zbx_vector_uint64_destroy(&read_ids);
 
 	return SUCCEED;
@@ -720,7 +1957,10 @@ static int	dbsync_read_journal(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc
 	}
 
 	for (i = 0; i < journal->deletes.values_num; i++)
+	{
+		dbsync_snapshot_add_row(sync, journal->deletes.values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
 		dbsync_add_row(sync, journal->deletes.values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
+	}
 
 	/* the obtained object identifiers are removed from journal */
 	sync->add_num = (zbx_uint64_t)(inserts_num - journal->inserts.values_num);
@@ -731,6 +1971,120 @@ static int	dbsync_read_journal(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read query data from loaded configuration snapshot and rows       *
+ *          changed since the snapshot was taken                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_read_snapshot(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const char *field, const char *keyword, const char *order_field, zbx_dbsync_journal_t *journal)
+{
+	zbx_dbsync_snapshot_stream_t	*stream = &dbsync_env.snapshot.streams[sync->stream];
+	zbx_dbsync_snapshot_row_t	*srow;
+	zbx_hashset_iter_t		iter;
+	char				**row;
+	int				i;
+
+	if (0 != stream->rows.num_data && stream->columns_num != sync->columns_num)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		dbsync_snapshot_disable("unexpected number of columns");
+
+		if (NULL == (sync->dbresult = zbx_db_select("%s", *sql)))
+			return FAIL;
+
+		return SUCCEED;
+	}
+
+	stream->columns_num = sync->columns_num;
+
+	/* the rows are provided from memory, the same way as in the case of incremental sync */
+	sync->mode = ZBX_DBSYNC_UPDATE;
+	zbx_vector_ptr_create(&sync->rows);
+	sync->row_index = -1;
+
+	zbx_vector_dbsync_append(&journal->syncs, sync);
+
+	for (i = 0; i < journal->objectids.values_num; i++)
+		dbsync_snapshot_stream_remove(stream, journal->objectids.values[i]);
+
+	zbx_vector_ptr_reserve(&sync->rows, (size_t)stream->rows.num_data);
+
+	zbx_hashset_iter_reset(&stream->rows, &iter);
+	while (NULL != (srow = (zbx_dbsync_snapshot_row_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL != (row = dbsync_preproc_row(sync, srow->row)))
+			dbsync_add_row(sync, srow->rowid, ZBX_DBSYNC_ROW_ADD, row);
+	}
+
+	/* configuration cache is empty, so changed objects are added */
+	if (0 != journal->inserts.values_num || 0 != journal->updates.values_num)
+	{
+		zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, ' ');
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, keyword);
+
+		if (0 != journal->inserts.values_num)
+		{
+			if (FAIL == dbsync_get_rows(sync, sql, sql_alloc, sql_offset, field, order_field,
+					&journal->inserts, ZBX_DBSYNC_ROW_ADD))
+			{
+				return FAIL;
+			}
+		}
+
+		if (0 != journal->updates.values_num)
+		{
+			if (FAIL == dbsync_get_rows(sync, sql, sql_alloc, sql_offset, field, order_field,
+					&journal->updates, ZBX_DBSYNC_ROW_ADD))
+			{
+				return FAIL;
+			}
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read query data of table using changelog                          *
+ *                                                                            *
+ * Parameters: sync        - [OUT] the changeset                              *
+ *             sql         - [IN/OUT] the base query                          *
+ *             sql_alloc   - [IN/OUT]                                         *
+ *             sql_offset  - [IN/OUT]                                         *
+ *             field       - [IN] the object identifier field                 *
+ *             keyword     - [IN] the keyword to append object filter with    *
+ *             order_field - [IN] the field to order rows by (optional)       *
+ *             object      - [IN] the changelog object                        *
+ *                                (see ZBX_DBSYNC_OBJ_* defines)              *
+ *             stream      - [IN] the snapshot stream                         *
+ *                                (see ZBX_DBSYNC_STREAM_* defines)           *
+ *                                                                            *
+ * Return value: SUCCEED - the changeset was successfully calculated          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_read_changelog(zbx_dbsync_t *sync, char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const char *field, const char *keyword, const char *order_field, int object, unsigned char stream)
+{
+	zbx_dbsync_journal_t	*journal = &dbsync_env.journals[ZBX_DBSYNC_JOURNAL(object)];
+
+	sync->stream = stream;
+
+	if (ZBX_DBSYNC_INIT != sync->mode)
+		return dbsync_read_journal(sync, sql, sql_alloc, sql_offset, field, keyword, order_field, journal);
+
+	if (ZBX_DBSYNC_STREAM_NONE != stream && ZBX_DBSYNC_SNAPSHOT_LOADED == dbsync_env.snapshot.state)
+		return dbsync_read_snapshot(sync, sql, sql_alloc, sql_offset, field, keyword, order_field, journal);
+
+	if (NULL == (sync->dbresult = zbx_db_select("%s", *sql)))
+		return FAIL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: initializes changeset                                             *
@@ -747,6 +2101,7 @@ static void	dbsync_init(zbx_dbsync_t *sync, unsigned char mode)
 
 	sync->row = NULL;
 	sync->preproc_row_func = NULL;
+	sync->stream = ZBX_DBSYNC_STREAM_NONE;
 	zbx_vector_ptr_create(&sync->columns);
 
 	if (ZBX_DBSYNC_UPDATE == sync->mode)
@@ -819,6 +2174,19 @@ void	zbx_dbsync_clear(zbx_dbsync_t *sync)
 	}
 	else
 	{
+		if (NULL != sync->dbresult && ZBX_DBSYNC_STREAM_NONE != sync->stream)
+		{
+			zbx_db_row_t	dbrow;
+			zbx_uint64_t	rowid;
+
+			/* rows not retrieved by configuration cache still must be written to snapshot */
+			while (NULL != (dbrow = zbx_db_fetch(sync->dbresult)))
+			{
+				ZBX_STR2UINT64(rowid, dbrow[0]);
+				dbsync_snapshot_add_row(sync, rowid, ZBX_DBSYNC_ROW_ADD, dbrow);
+			}
+		}
+
 		zbx_db_free_result(sync->dbresult);
 		sync->dbresult = NULL;
 	}
@@ -881,6 +2249,12 @@ int	zbx_dbsync_next(zbx_dbsync_t *sync, zbx_uint64_t *rowid, char ***row, unsign
 			return FAIL;
 		}
 
+		if (ZBX_DBSYNC_STREAM_NONE != sync->stream)
+		{
+			ZBX_STR2UINT64(*rowid, dbrow[0]);
+			dbsync_snapshot_add_row(sync, *rowid, ZBX_DBSYNC_ROW_ADD, dbrow);
+		}
+
 		*row = dbsync_preproc_row(sync, dbrow);
 
 		*rowid = 0;
@@ -1093,16 +2467,8 @@ int	zbx_dbsync_compare_hosts(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 21, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "hostid", "and", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOST)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "hostid", "and", NULL,
+			ZBX_DBSYNC_OBJ_HOST, ZBX_DBSYNC_STREAM_HOSTS);
 	zbx_free(sql);
 
 	return ret;
@@ -1833,29 +3199,14 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 	int	ret = SUCCEED;
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-			"select i.itemid,i.hostid,i.status,i.type,i.value_type,i.key_,i.snmp_oid,i.ipmi_sensor,i.delay,"
-				"i.trapper_hosts,i.logtimefmt,i.params,ir.state,i.authtype,i.username,i.password,"
-				"i.publickey,i.privatekey,i.flags,i.interfaceid,ir.lastlogsize,ir.mtime,"
-				"i.history,i.trends,i.inventory_link,i.valuemapid,i.units,ir.error,i.jmx_endpoint,"
-				"i.master_itemid,i.timeout,i.url,i.query_fields,i.posts,i.status_codes,"
-				"i.follow_redirects,i.post_type,i.http_proxy,i.headers,i.retrieve_mode,"
-				"i.request_method,i.output_format,i.ssl_cert_file,i.ssl_key_file,i.ssl_key_password,"
-				"i.verify_peer,i.verify_host,i.allow_traps,i.templateid,null"
+			"select " ZBX_DBSYNC_ITEM_COLUMNS
 			" from items i"
 			" join item_rtdata ir on i.itemid=ir.itemid");
 
 	dbsync_prepare(sync, 50, dbsync_item_preproc_row);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "i.itemid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_ITEM)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "i.itemid", "where", NULL,
+			ZBX_DBSYNC_OBJ_ITEM, ZBX_DBSYNC_STREAM_ITEMS);
 	zbx_free(sql);
 
 	return ret;
@@ -2034,16 +3385,8 @@ int	zbx_dbsync_compare_prototype_items(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 3, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "i.itemid", "and", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_ITEM)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "i.itemid", "and", NULL,
+			ZBX_DBSYNC_OBJ_ITEM, ZBX_DBSYNC_STREAM_PROTOTYPE_ITEMS);
 	zbx_free(sql);
 
 	return ret;
@@ -2150,16 +3493,8 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 20, dbsync_trigger_preproc_row);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "triggerid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_TRIGGER)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "triggerid", "where", NULL,
+			ZBX_DBSYNC_OBJ_TRIGGER, ZBX_DBSYNC_STREAM_TRIGGERS);
 	zbx_free(sql);
 
 	return ret;
@@ -2292,16 +3627,8 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 5, dbsync_function_preproc_row);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "functionid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_FUNCTION)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "functionid", "where", NULL,
+			ZBX_DBSYNC_OBJ_FUNCTION, ZBX_DBSYNC_STREAM_FUNCTIONS);
 	zbx_free(sql);
 
 	return ret;
@@ -2721,16 +4048,8 @@ int	zbx_dbsync_compare_trigger_tags(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 4, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "triggertagid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_TRIGGER_TAG)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "triggertagid", "where", NULL,
+			ZBX_DBSYNC_OBJ_TRIGGER_TAG, ZBX_DBSYNC_STREAM_TRIGGER_TAGS);
 	zbx_free(sql);
 
 	return ret;
@@ -2756,16 +4075,8 @@ int	zbx_dbsync_compare_item_tags(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 4, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "itemtagid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_ITEM_TAG)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "itemtagid", "where", NULL,
+			ZBX_DBSYNC_OBJ_ITEM_TAG, ZBX_DBSYNC_STREAM_ITEM_TAGS);
 	zbx_free(sql);
 
 	return ret;
@@ -2791,16 +4102,8 @@ int	zbx_dbsync_compare_host_tags(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 4, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "hosttagid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOST_TAG)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "hosttagid", "where", NULL,
+			ZBX_DBSYNC_OBJ_HOST_TAG, ZBX_DBSYNC_STREAM_HOST_TAGS);
 	zbx_free(sql);
 
 	return ret;
@@ -3237,16 +4540,8 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 7, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "item_preprocid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_ITEM_PREPROC)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "item_preprocid", "where", NULL,
+			ZBX_DBSYNC_OBJ_ITEM_PREPROC, ZBX_DBSYNC_STREAM_ITEM_PREPROCS);
 	zbx_free(sql);
 
 	return ret;
@@ -3916,17 +5211,8 @@ int	zbx_dbsync_prepare_drules(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 7, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "druleid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_DRULE)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "druleid", "where", NULL,
+			ZBX_DBSYNC_OBJ_DRULE, ZBX_DBSYNC_STREAM_DRULES);
 	zbx_free(sql);
 
 	return ret;
@@ -3956,16 +5242,8 @@ int	zbx_dbsync_prepare_dchecks(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 15, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "dcheckid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_DCHECK)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "dcheckid", "where", NULL,
+			ZBX_DBSYNC_OBJ_DCHECK, ZBX_DBSYNC_STREAM_DCHECKS);
 	zbx_free(sql);
 
 	return ret;
@@ -3991,16 +5269,8 @@ int	zbx_dbsync_prepare_httptests(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 4, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "httptestid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HTTPTEST)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "httptestid", "where", NULL,
+			ZBX_DBSYNC_OBJ_HTTPTEST, ZBX_DBSYNC_STREAM_HTTPTESTS);
 	zbx_free(sql);
 
 	return ret;
@@ -4026,16 +5296,8 @@ int	zbx_dbsync_prepare_httptest_fields(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 2, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "httptest_fieldid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HTTPTEST_FIELD)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "httptest_fieldid", "where", NULL,
+			ZBX_DBSYNC_OBJ_HTTPTEST_FIELD, ZBX_DBSYNC_STREAM_HTTPTEST_FIELDS);
 	zbx_free(sql);
 
 	return ret;
@@ -4060,16 +5322,8 @@ int	zbx_dbsync_prepare_httpsteps(zbx_dbsync_t *sync)
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select httpstepid,httptestid from httpstep");
 	dbsync_prepare(sync, 2, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "httpstepid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HTTPSTEP)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "httpstepid", "where", NULL,
+			ZBX_DBSYNC_OBJ_HTTPSTEP, ZBX_DBSYNC_STREAM_HTTPSTEPS);
 	zbx_free(sql);
 
 	return ret;
@@ -4094,16 +5348,8 @@ int	zbx_dbsync_prepare_httpstep_fields(zbx_dbsync_t *sync)
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select httpstep_fieldid,httpstepid from httpstep_field");
 	dbsync_prepare(sync, 2, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "httpstep_fieldid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HTTPSTEP_FIELD)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "httpstep_fieldid", "where", NULL,
+			ZBX_DBSYNC_OBJ_HTTPSTEP_FIELD, ZBX_DBSYNC_STREAM_HTTPSTEP_FIELDS);
 	zbx_free(sql);
 
 	return ret;
@@ -4134,16 +5380,8 @@ int	zbx_dbsync_compare_connectors(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 22, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "connectorid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_CONNECTOR)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "connectorid", "where", NULL,
+			ZBX_DBSYNC_OBJ_CONNECTOR, ZBX_DBSYNC_STREAM_CONNECTORS);
 	zbx_free(sql);
 
 	return ret;
@@ -4161,16 +5399,8 @@ int	zbx_dbsync_compare_connector_tags(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 5, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "connector_tagid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_CONNECTOR_TAG)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "connector_tagid", "where", NULL,
+			ZBX_DBSYNC_OBJ_CONNECTOR_TAG, ZBX_DBSYNC_STREAM_CONNECTOR_TAGS);
 	zbx_free(sql);
 
 	return ret;
@@ -4195,16 +5425,8 @@ int	zbx_dbsync_compare_proxies(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 27, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "p.proxyid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_PROXY)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "p.proxyid", "where", NULL,
+			ZBX_DBSYNC_OBJ_PROXY, ZBX_DBSYNC_STREAM_NONE);
 	zbx_free(sql);
 
 	return ret;
@@ -4231,16 +5453,8 @@ int	zbx_dbsync_prepare_proxy_group(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 4, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "proxy_groupid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_PROXY_GROUP)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "proxy_groupid", "where", NULL,
+			ZBX_DBSYNC_OBJ_PROXY_GROUP, ZBX_DBSYNC_STREAM_PROXY_GROUPS);
 	zbx_free(sql);
 
 	return ret;
@@ -4271,16 +5485,8 @@ int	zbx_dbsync_prepare_host_proxy(zbx_dbsync_t *sync)
 
 	dbsync_prepare(sync, 11, NULL);
 
-	if (ZBX_DBSYNC_INIT == sync->mode)
-	{
-		if (NULL == (sync->dbresult = zbx_db_select("%s", sql)))
-			ret = FAIL;
-		goto out;
-	}
-
-	ret = dbsync_read_journal(sync, &sql, &sql_alloc, &sql_offset, "hostproxyid", "where", NULL,
-			&dbsync_env.journals[ZBX_DBSYNC_JOURNAL(ZBX_DBSYNC_OBJ_HOST_PROXY)]);
-out:
+	ret = dbsync_read_changelog(sync, &sql, &sql_alloc, &sql_offset, "hostproxyid", "where", NULL,
+			ZBX_DBSYNC_OBJ_HOST_PROXY, ZBX_DBSYNC_STREAM_NONE);
 	zbx_free(sql);
 
 	return ret;
@@ -79,6 +79,9 @@ struct zbx_dbsync
 
 	unsigned char			type;
 
+	/* the configuration snapshot stream of changelog based changeset, 0 if not stored in snapshot */
+	unsigned char			stream;
+
 	/* the number of columns in diff */
 	int				columns_num;
 
@@ -106,7 +109,7 @@ struct zbx_dbsync
 	zbx_uint64_t	remove_num;
 };
 
-void	zbx_dbsync_env_init(zbx_dc_config_t *cache);
+void	zbx_dbsync_env_init(zbx_dc_config_t *cache, const char *snapshot_file);
 int	zbx_dbsync_env_prepare(unsigned char mode);
 void	zbx_dbsync_env_flush_changelog(void);
 void	zbx_dbsync_env_clear(void);
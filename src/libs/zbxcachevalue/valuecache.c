@@ -20,6 +20,8 @@
 #include "zbxalgo.h"
 #include "zbxhistory.h"
 #include "zbxshmem.h"
+#include "zbxstr.h"
+#include "version.h"
 
 /*
  * The cache (zbx_vc_cache_t) is organized as a hashset of item records (zbx_vc_item_t).
@@ -2357,6 +2359,257 @@ static size_t	vch_item_free_cache(zbx_vc_item_t *item)
 	return freed;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Value cache snapshot                                                       *
+ *                                                                            *
+ * The snapshot is a sequential binary file written on clean shutdown and     *
+ * loaded once on startup to avoid reading the history of all cached items   *
+ * from database after restart:                                               *
+ *                                                                            *
+ *   header - signature, format version, Zabbix version, HA node name, dump   *
+ *            time, cache hits/misses and number of items                     *
+ *   items  - item record (zbx_vc_item_t fields without chunk pointers)       *
+ *            followed by item values in ascending order                      *
+ *                                                                            *
+ ******************************************************************************/
+
+#define VC_SNAPSHOT_SIGNATURE		"ZBXVCSNP"
+#define VC_SNAPSHOT_SIGNATURE_LEN	ZBX_CONST_STRLEN(VC_SNAPSHOT_SIGNATURE)
+#define VC_SNAPSHOT_VERSION		1
+#define VC_SNAPSHOT_BUFFER_SIZE		(ZBX_MEBIBYTE)
+#define VC_SNAPSHOT_STRING_MAX		(ZBX_GIBIBYTE)
+#define VC_SNAPSHOT_NULL_STRING		0xffffffff
+
+static void	vc_snapshot_write_data(FILE *f, const void *data, size_t size)
+{
+	if (0 != size)
+		fwrite(data, size, 1, f);
+}
+
+static void	vc_snapshot_write_string(FILE *f, const char *str)
+{
+	zbx_uint32_t	len;
+
+	if (NULL == str)
+	{
+		len = VC_SNAPSHOT_NULL_STRING;
+		vc_snapshot_write_data(f, &len, sizeof(len));
+		return;
+	}
+
+	len = (zbx_uint32_t)strlen(str);
+	vc_snapshot_write_data(f, &len, sizeof(len));
+	vc_snapshot_write_data(f, str, len);
+}
+
+static int	vc_snapshot_read_data(FILE *f, void *data, size_t size)
+{
+	if (0 != size && 1 != fread(data, size, 1, f))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+static int	vc_snapshot_read_string(FILE *f, char **str)
+{
+	zbx_uint32_t	len;
+
+	if (SUCCEED != vc_snapshot_read_data(f, &len, sizeof(len)))
+		return FAIL;
+
+	if (VC_SNAPSHOT_NULL_STRING == len)
+	{
+		*str = NULL;
+		return SUCCEED;
+	}
+
+	if (VC_SNAPSHOT_STRING_MAX < len)
+		return FAIL;
+
+	*str = (char *)zbx_malloc(NULL, (size_t)len + 1);
+
+	if (SUCCEED != vc_snapshot_read_data(f, *str, len))
+	{
+		zbx_free(*str);
+		return FAIL;
+	}
+
+	(*str)[len] = '\0';
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes item and its cached values to snapshot file                *
+ *                                                                            *
+ * Parameters: f    - [IN] the snapshot file                                  *
+ *             item - [IN] the item                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_snapshot_write_item(FILE *f, const zbx_vc_item_t *item)
+{
+	const zbx_vc_chunk_t	*chunk;
+	int			i;
+
+	vc_snapshot_write_data(f, &item->itemid, sizeof(item->itemid));
+	vc_snapshot_write_data(f, &item->value_type, sizeof(item->value_type));
+	vc_snapshot_write_data(f, &item->status, sizeof(item->status));
+	vc_snapshot_write_data(f, &item->range_sync_hour, sizeof(item->range_sync_hour));
+	vc_snapshot_write_data(f, &item->last_accessed, sizeof(item->last_accessed));
+	vc_snapshot_write_data(f, &item->active_range, sizeof(item->active_range));
+	vc_snapshot_write_data(f, &item->daily_range, sizeof(item->daily_range));
+	vc_snapshot_write_data(f, &item->db_cached_from, sizeof(item->db_cached_from));
+	vc_snapshot_write_data(f, &item->last_hourly_num, sizeof(item->last_hourly_num));
+	vc_snapshot_write_data(f, &item->hourly_num, sizeof(item->hourly_num));
+	vc_snapshot_write_data(f, &item->hour, sizeof(item->hour));
+	vc_snapshot_write_data(f, &item->hits, sizeof(item->hits));
+	vc_snapshot_write_data(f, &item->values_total, sizeof(item->values_total));
+
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+	{
+		for (i = chunk->first_value; i <= chunk->last_value; i++)
+		{
+			const zbx_history_record_t	*record = &chunk->slots[i];
+
+			vc_snapshot_write_data(f, &record->timestamp.sec, sizeof(record->timestamp.sec));
+			vc_snapshot_write_data(f, &record->timestamp.ns, sizeof(record->timestamp.ns));
+
+			switch (item->value_type)
+			{
+				case ITEM_VALUE_TYPE_FLOAT:
+					vc_snapshot_write_data(f, &record->value.dbl, sizeof(record->value.dbl));
+					break;
+				case ITEM_VALUE_TYPE_UINT64:
+					vc_snapshot_write_data(f, &record->value.ui64, sizeof(record->value.ui64));
+					break;
+				case ITEM_VALUE_TYPE_STR:
+				case ITEM_VALUE_TYPE_TEXT:
+					vc_snapshot_write_string(f, record->value.str);
+					break;
+				case ITEM_VALUE_TYPE_LOG:
+					vc_snapshot_write_data(f, &record->value.log->timestamp,
+							sizeof(record->value.log->timestamp));
+					vc_snapshot_write_data(f, &record->value.log->logeventid,
+							sizeof(record->value.log->logeventid));
+					vc_snapshot_write_data(f, &record->value.log->severity,
+							sizeof(record->value.log->severity));
+					vc_snapshot_write_string(f, record->value.log->source);
+					vc_snapshot_write_string(f, record->value.log->value);
+					break;
+			}
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads item and its values from snapshot file                      *
+ *                                                                            *
+ * Parameters: f      - [IN] the snapshot file                                *
+ *             item   - [OUT] the item                                        *
+ *             values - [OUT] the item values in ascending order              *
+ *                                                                            *
+ * Return value: SUCCEED - the item was read successfully                     *
+ *               FAIL    - the snapshot file is truncated or corrupted        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_read_item(FILE *f, zbx_vc_item_t *item, zbx_vector_history_record_t *values)
+{
+	int	i, values_num;
+
+	memset(item, 0, sizeof(zbx_vc_item_t));
+
+	if (SUCCEED != vc_snapshot_read_data(f, &item->itemid, sizeof(item->itemid)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->value_type, sizeof(item->value_type)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->status, sizeof(item->status)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->range_sync_hour, sizeof(item->range_sync_hour)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->last_accessed, sizeof(item->last_accessed)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->active_range, sizeof(item->active_range)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->daily_range, sizeof(item->daily_range)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->db_cached_from, sizeof(item->db_cached_from)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->last_hourly_num, sizeof(item->last_hourly_num)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->hourly_num, sizeof(item->hourly_num)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->hour, sizeof(item->hour)) ||
+			SUCCEED != vc_snapshot_read_data(f, &item->hits, sizeof(item->hits)) ||
+			SUCCEED != vc_snapshot_read_data(f, &values_num, sizeof(values_num)))
+	{
+		return FAIL;
+	}
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+		case ITEM_VALUE_TYPE_UINT64:
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+		case ITEM_VALUE_TYPE_LOG:
+			break;
+		default:
+			return FAIL;
+	}
+
+	if (0 > values_num)
+		return FAIL;
+
+	for (i = 0; i < values_num; i++)
+	{
+		zbx_history_record_t	record;
+		zbx_log_value_t		*log;
+
+		if (SUCCEED != vc_snapshot_read_data(f, &record.timestamp.sec, sizeof(record.timestamp.sec)) ||
+				SUCCEED != vc_snapshot_read_data(f, &record.timestamp.ns, sizeof(record.timestamp.ns)))
+		{
+			return FAIL;
+		}
+
+		switch (item->value_type)
+		{
+			case ITEM_VALUE_TYPE_FLOAT:
+				if (SUCCEED != vc_snapshot_read_data(f, &record.value.dbl, sizeof(record.value.dbl)))
+					return FAIL;
+				break;
+			case ITEM_VALUE_TYPE_UINT64:
+				if (SUCCEED != vc_snapshot_read_data(f, &record.value.ui64, sizeof(record.value.ui64)))
+					return FAIL;
+				break;
+			case ITEM_VALUE_TYPE_STR:
+			case ITEM_VALUE_TYPE_TEXT:
+				if (SUCCEED != vc_snapshot_read_string(f, &record.value.str))
+					return FAIL;
+
+				if (NULL == record.value.str)
+					return FAIL;
+				break;
+			case ITEM_VALUE_TYPE_LOG:
+				log = (zbx_log_value_t *)zbx_malloc(NULL, sizeof(zbx_log_value_t));
+				log->source = NULL;
+				log->value = NULL;
+				record.value.log = log;
+
+				/* append before reading strings so that partially read log is freed by caller */
+				zbx_vector_history_record_append_ptr(values, &record);
+
+				if (SUCCEED != vc_snapshot_read_data(f, &log->timestamp, sizeof(log->timestamp)) ||
+						SUCCEED != vc_snapshot_read_data(f, &log->logeventid,
+								sizeof(log->logeventid)) ||
+						SUCCEED != vc_snapshot_read_data(f, &log->severity,
+								sizeof(log->severity)) ||
+						SUCCEED != vc_snapshot_read_string(f, &log->source) ||
+						SUCCEED != vc_snapshot_read_string(f, &log->value) || NULL == log->value)
+				{
+					return FAIL;
+				}
+				continue;
+		}
+
+		zbx_vector_history_record_append_ptr(values, &record);
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************************************************
  *                                                                                                                *
  * Public API                                                                                                     *
@@ -2923,3 +3176,276 @@ void	zbx_vc_add_new_items(const zbx_vector_uint64_pair_t *items)
 
 	UNLOCK_CACHE;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes value cache contents to snapshot file                      *
+ *                                                                            *
+ * Parameters: filename     - [IN] the snapshot file name                     *
+ *             ha_node_name - [IN] the HA node name (optional)                *
+ *             error        - [OUT] the error message                         *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was written successfully              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The snapshot is written to a temporary file which is renamed to  *
+ *           the target file name only after all data has been written.       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_snapshot_write(const char *filename, const char *ha_node_name, char **error)
+{
+	char			*tmpname, version[] = ZABBIX_VERSION;
+	FILE			*f;
+	int			ret = FAIL, now, fd;
+	zbx_uint32_t		format_version = VC_SNAPSHOT_VERSION;
+	zbx_uint64_t		items_num, values_num = 0;
+	zbx_hashset_iter_t	iter;
+	zbx_vc_item_t		*item;
+
+	if (NULL == vc_cache)
+		return SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() filename:%s", __func__, filename);
+
+	tmpname = zbx_dsprintf(NULL, "%s.tmp", filename);
+
+	/* snapshot contains history values, remove leftover file so it is recreated readable by owner only */
+	unlink(tmpname);
+
+	if (-1 == (fd = open(tmpname, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)) ||
+			NULL == (f = fdopen(fd, "wb")))
+	{
+		*error = zbx_dsprintf(*error, "cannot create file \"%s\": %s", tmpname, zbx_strerror(errno));
+
+		if (-1 != fd)
+			close(fd);
+
+		goto fail;
+	}
+
+	setvbuf(f, NULL, _IOFBF, VC_SNAPSHOT_BUFFER_SIZE);
+
+	now = (int)time(NULL);
+
+	RDLOCK_CACHE;
+
+	items_num = (zbx_uint64_t)vc_cache->items.num_data;
+
+	vc_snapshot_write_data(f, VC_SNAPSHOT_SIGNATURE, VC_SNAPSHOT_SIGNATURE_LEN);
+	vc_snapshot_write_data(f, &format_version, sizeof(format_version));
+	vc_snapshot_write_string(f, version);
+	vc_snapshot_write_string(f, ZBX_NULL2EMPTY_STR(ha_node_name));
+	vc_snapshot_write_data(f, &now, sizeof(now));
+	vc_snapshot_write_data(f, &vc_cache->hits, sizeof(vc_cache->hits));
+	vc_snapshot_write_data(f, &vc_cache->misses, sizeof(vc_cache->misses));
+	vc_snapshot_write_data(f, &items_num, sizeof(items_num));
+
+	zbx_hashset_iter_reset(&vc_cache->items, &iter);
+	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+	{
+		vc_snapshot_write_item(f, item);
+		values_num += (zbx_uint64_t)item->values_total;
+	}
+
+	UNLOCK_CACHE;
+
+	if (0 != fflush(f) || 0 != ferror(f))
+	{
+		*error = zbx_dsprintf(*error, "cannot write file \"%s\": %s", tmpname, zbx_strerror(errno));
+		fclose(f);
+		goto fail;
+	}
+
+	if (0 != fclose(f))
+	{
+		*error = zbx_dsprintf(*error, "cannot close file \"%s\": %s", tmpname, zbx_strerror(errno));
+		goto fail;
+	}
+
+	if (0 != rename(tmpname, filename))
+	{
+		*error = zbx_dsprintf(*error, "cannot rename file \"%s\" to \"%s\": %s", tmpname, filename,
+				zbx_strerror(errno));
+		goto fail;
+	}
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "value cache snapshot with " ZBX_FS_UI64 " items and " ZBX_FS_UI64
+			" values has been written to \"%s\"", items_num, values_num, filename);
+
+	ret = SUCCEED;
+fail:
+	if (SUCCEED != ret)
+		unlink(tmpname);
+
+	zbx_free(tmpname);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads value cache contents from snapshot file                     *
+ *                                                                            *
+ * Parameters: filename     - [IN] the snapshot file name                     *
+ *             ha_node_name - [IN] the HA node name (optional)                *
+ *             min_time     - [IN] the snapshot is discarded if it was        *
+ *                                 written before this time                   *
+ *             error        - [OUT] the error message                         *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was loaded or did not exist           *
+ *               FAIL    - the snapshot was discarded                         *
+ *                                                                            *
+ * Comments: The snapshot file is removed after loading, so that it cannot be *
+ *           loaded again after unclean shutdown when it no longer matches    *
+ *           history data in database.                                        *
+ *           Items already having cached values and items not fitting in the  *
+ *           cache are skipped.                                               *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_snapshot_load(const char *filename, const char *ha_node_name, int min_time, char **error)
+{
+	char				signature[VC_SNAPSHOT_SIGNATURE_LEN], *version = NULL, *node_name = NULL;
+	FILE				*f;
+	int				ret = FAIL, dump_time;
+	zbx_uint32_t			format_version;
+	zbx_uint64_t			hits, misses, items_num, i, items_loaded = 0, values_loaded = 0;
+	zbx_vector_history_record_t	values;
+
+	if (NULL == vc_cache)
+		return SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() filename:%s min_time:%d", __func__, filename, min_time);
+
+	if (NULL == (f = fopen(filename, "rb")))
+	{
+		if (ENOENT == errno)
+		{
+			ret = SUCCEED;
+			goto out;
+		}
+
+		*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", filename, zbx_strerror(errno));
+		goto remove;
+	}
+
+	setvbuf(f, NULL, _IOFBF, VC_SNAPSHOT_BUFFER_SIZE);
+
+	if (SUCCEED != vc_snapshot_read_data(f, signature, sizeof(signature)) ||
+			0 != memcmp(signature, VC_SNAPSHOT_SIGNATURE, VC_SNAPSHOT_SIGNATURE_LEN) ||
+			SUCCEED != vc_snapshot_read_data(f, &format_version, sizeof(format_version)) ||
+			VC_SNAPSHOT_VERSION != format_version ||
+			SUCCEED != vc_snapshot_read_string(f, &version) || NULL == version ||
+			SUCCEED != vc_snapshot_read_string(f, &node_name) || NULL == node_name ||
+			SUCCEED != vc_snapshot_read_data(f, &dump_time, sizeof(dump_time)) ||
+			SUCCEED != vc_snapshot_read_data(f, &hits, sizeof(hits)) ||
+			SUCCEED != vc_snapshot_read_data(f, &misses, sizeof(misses)) ||
+			SUCCEED != vc_snapshot_read_data(f, &items_num, sizeof(items_num)))
+	{
+		*error = zbx_strdup(*error, "invalid file format");
+		goto close;
+	}
+
+	if (0 != strcmp(version, ZABBIX_VERSION))
+	{
+		*error = zbx_dsprintf(*error, "snapshot was written by Zabbix server version %s", version);
+		goto close;
+	}
+
+	if (0 != strcmp(node_name, ZBX_NULL2EMPTY_STR(ha_node_name)))
+	{
+		*error = zbx_dsprintf(*error, "snapshot was written by HA node \"%s\"", node_name);
+		goto close;
+	}
+
+	if (dump_time < min_time)
+	{
+		*error = zbx_strdup(*error, "history has been updated by another HA node after snapshot was written");
+		goto close;
+	}
+
+	zbx_vector_history_record_create(&values);
+
+	ret = SUCCEED;
+
+	WRLOCK_CACHE;
+
+	vc_cache->hits += hits;
+	vc_cache->misses += misses;
+
+	for (i = 0; i < items_num; i++)
+	{
+		zbx_vc_item_t	item_local, *item;
+
+		if (SUCCEED != vc_snapshot_read_item(f, &item_local, &values))
+		{
+			if (0 != values.values_num)
+				vc_history_record_vector_clean(&values, item_local.value_type);
+
+			*error = zbx_strdup(*error, "invalid file format");
+			ret = FAIL;
+			break;
+		}
+
+		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
+		{
+			vc_history_record_vector_clean(&values, item_local.value_type);
+			break;
+		}
+
+		if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &item_local.itemid)))
+		{
+			if (0 != item->values_total || item->value_type != item_local.value_type)
+			{
+				vc_history_record_vector_clean(&values, item_local.value_type);
+				continue;
+			}
+
+			zbx_hashset_remove_direct(&vc_cache->items, item);
+		}
+
+		if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &item_local,
+				sizeof(item_local))))
+		{
+			vc_history_record_vector_clean(&values, item_local.value_type);
+			break;
+		}
+
+		if (0 != values.values_num && FAIL == vch_item_add_values_at_tail(item, values.values,
+				values.values_num))
+		{
+			vch_item_free_cache(item);
+			zbx_hashset_remove_direct(&vc_cache->items, item);
+			vc_history_record_vector_clean(&values, item_local.value_type);
+			break;
+		}
+
+		items_loaded++;
+		values_loaded += (zbx_uint64_t)values.values_num;
+
+		vc_history_record_vector_clean(&values, item_local.value_type);
+	}
+
+	UNLOCK_CACHE;
+
+	zbx_vector_history_record_destroy(&values);
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "loaded " ZBX_FS_UI64 " of " ZBX_FS_UI64 " items with " ZBX_FS_UI64
+			" values from value cache snapshot \"%s\"", items_loaded, items_num, values_loaded, filename);
+close:
+	fclose(f);
+remove:
+	if (0 != unlink(filename) && ENOENT != errno)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove value cache snapshot \"%s\": %s", filename,
+				zbx_strerror(errno));
+	}
+out:
+	zbx_free(node_name);
+	zbx_free(version);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
@@ -631,12 +631,13 @@ int	discovery_net_check_range(zbx_uint64_t druleid, zbx_discoverer_task_t *task,
 		zbx_discoverer_manager_t *dmanager, int worker_id, char **error)
 {
 	zbx_vector_discoverer_results_ptr_t	results;
+	zbx_vector_uint64_t			started_dcheckids;
 	discovery_poller_config_t		poller_config;
 #if defined(HAVE_LIBCURL)
 	zbx_asynchttppoller_config		*http_config = NULL;
 #endif
 	char					ip[ZBX_INTERFACE_IP_LEN_MAX], first_ip[ZBX_INTERFACE_IP_LEN_MAX];
-	int					ret = FAIL, abort = SUCCEED;
+	int					ret = FAIL, abort = SUCCEED, concurrency_limit, started_num = 0;
 	zbx_uint64_t				dec_counter = 0;
 
 	if (0 == log_worker_id)
@@ -652,6 +653,8 @@ int	discovery_net_check_range(zbx_uint64_t druleid, zbx_discoverer_task_t *task,
 	if (0 == concurrency_max)
 		concurrency_max = dmanager->queue.checks_per_worker_max;
 
+	concurrency_limit = concurrency_max;
+
 	if (SUCCEED != discovery_async_poller_init(dmanager, &poller_config))
 	{
 		*error = zbx_strdup(*error, "Cannot initialize discovery async poller.");
@@ -659,6 +662,7 @@ int	discovery_net_check_range(zbx_uint64_t druleid, zbx_discoverer_task_t *task,
 	}
 
 	zbx_vector_discoverer_results_ptr_create(&results);
+	zbx_vector_uint64_create(&started_dcheckids);
 	*first_ip = '\0';
 #ifdef HAVE_LIBCURL
 	if ((SVC_HTTP == GET_DTYPE(task) || SVC_HTTPS == GET_DTYPE(task)) &&
@@ -683,58 +687,93 @@ int	discovery_net_check_range(zbx_uint64_t druleid, zbx_discoverer_task_t *task,
 		zbx_vector_discoverer_results_ptr_append(&results, result);
 		dcheck = &task->ds_dchecks.values[task->range.state.index_dcheck]->dcheck;
 
-		switch (dcheck->type)
+		for (;;)
 		{
-			case SVC_SNMPv1:
-			case SVC_SNMPv2c:
-			case SVC_SNMPv3:
+			switch (dcheck->type)
+			{
+				case SVC_SNMPv1:
+				case SVC_SNMPv2c:
+				case SVC_SNMPv3:
 #ifdef HAVE_NETSNMP
-				ret = discovery_snmp(&poller_config, dcheck, ip,
-						(unsigned short)task->range.state.port, result, error);
+					ret = discovery_snmp(&poller_config, dcheck, ip,
+							(unsigned short)task->range.state.port, result, error);
 #else
-				ret = FAIL;
-				*error = zbx_strdup(*error, "Support for SNMP checks was not compiled in.");
+					ret = FAIL;
+					*error = zbx_strdup(*error, "Support for SNMP checks was not compiled in.");
 #endif
-				break;
-			case SVC_AGENT:
-				ret = discovery_agent(&poller_config, dcheck, ip,
-						(unsigned short)task->range.state.port, result, error);
-				break;
-			case SVC_HTTPS:
+					break;
+				case SVC_AGENT:
+					ret = discovery_agent(&poller_config, dcheck, ip,
+							(unsigned short)task->range.state.port, result, error);
+					break;
+				case SVC_HTTPS:
 #ifdef HAVE_LIBCURL
-			case SVC_HTTP:
-				ret = discovery_http(&poller_config, http_config, dcheck,
-						(unsigned short)task->range.state.port, result, error);
-				break;
+				case SVC_HTTP:
+					ret = discovery_http(&poller_config, http_config, dcheck,
+							(unsigned short)task->range.state.port, result, error);
+					break;
 #else
-				ret = FAIL;
-				*error = zbx_strdup(*error, "Support for HTTPS checks was not compiled in.");
-				break;
-			case SVC_HTTP:
+					ret = FAIL;
+					*error = zbx_strdup(*error, "Support for HTTPS checks was not compiled in.");
+					break;
+				case SVC_HTTP:
 #endif
-			case SVC_SSH:
-			case SVC_SMTP:
-			case SVC_FTP:
-			case SVC_POP:
-			case SVC_NNTP:
-			case SVC_IMAP:
-			case SVC_TCP:
-				ret = discovery_tcpsvc(&poller_config, dcheck, ip,
-						(unsigned short)task->range.state.port, result, error);
-				break;
-			case SVC_TELNET:
-				ret = discovery_telnet(&poller_config, dcheck, ip,
-						(unsigned short)task->range.state.port, result);
+				case SVC_SSH:
+				case SVC_SMTP:
+				case SVC_FTP:
+				case SVC_POP:
+				case SVC_NNTP:
+				case SVC_IMAP:
+				case SVC_TCP:
+					ret = discovery_tcpsvc(&poller_config, dcheck, ip,
+							(unsigned short)task->range.state.port, result, error);
+					break;
+				case SVC_TELNET:
+					ret = discovery_telnet(&poller_config, dcheck, ip,
+							(unsigned short)task->range.state.port, result);
+					break;
+				default:
+					ret = FAIL;
+					*error = zbx_dsprintf(*error, "Unsupported check type %u.", dcheck->type);
+			}
+
+			if (SUCCEED == ret || 0 == poller_config.processing || FAIL == zbx_vector_uint64_search(
+					&started_dcheckids, dcheck->dcheckid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
 				break;
-			default:
-				ret = FAIL;
-				*error = zbx_dsprintf(*error, "Unsupported check type %u.", dcheck->type);
+			}
+
+			/* start failures depend only on check configuration, so if the same check was      */
+			/* already started for other addresses it is limited by local resources held by the */
+			/* checks in progress - retry it after lowering the concurrency                     */
+			zabbix_log(LOG_LEVEL_DEBUG, "[%d] cannot start check for ip:%s with %d checks in progress: %s",
+					log_worker_id, ip, poller_config.processing, ZBX_NULL2EMPTY_STR(*error));
+			zbx_free(*error);
+
+			concurrency_limit = MAX(1, poller_config.processing / 2);
+			started_num = 0;
+
+			while (concurrency_limit <= poller_config.processing)
+				event_base_loop(poller_config.base, EVLOOP_ONCE);
 		}
 
 		if (FAIL == ret)
 			goto out;
 
-		while (concurrency_max == poller_config.processing)
+		if (FAIL == zbx_vector_uint64_search(&started_dcheckids, dcheck->dcheckid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		{
+			zbx_vector_uint64_append(&started_dcheckids, dcheck->dcheckid);
+		}
+
+		/* restore the concurrency after a round of checks has been started without errors */
+		if (concurrency_limit < concurrency_max && ++started_num >= concurrency_limit)
+		{
+			concurrency_limit = MIN(concurrency_max, concurrency_limit + MAX(1, concurrency_limit / 4));
+			started_num = 0;
+		}
+
+		while (concurrency_limit <= poller_config.processing)
 			event_base_loop(poller_config.base, EVLOOP_ONCE);
 
 		abort = discovery_net_check_result_flush(dmanager, task, &results, 0);
@@ -756,6 +795,7 @@ out:
 	discovery_net_check_result_flush(dmanager, task, &results, 1);
 	zbx_vector_discoverer_results_ptr_clear_ext(&results, results_free);	/* Incomplete results*/
 	zbx_vector_discoverer_results_ptr_destroy(&results);
+	zbx_vector_uint64_destroy(&started_dcheckids);
 #ifdef HAVE_LIBCURL
 	if (NULL != http_config)
 	{
@@ -40,6 +40,186 @@ typedef struct
 }
 zbx_es_obj_data_t;
 
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+
+/* maximum total size of scripts and their bytecode kept in bytecode cache */
+#define ZBX_ES_BYTECODE_CACHE_SIZE	(ZBX_MEBIBYTE * 16)
+
+/* compiled script, shared by all scripting engine environments of the process */
+typedef struct
+{
+	char		*script;
+	char		*code;
+	int		size;
+	zbx_uint64_t	lastaccess;
+}
+zbx_es_bytecode_t;
+
+typedef struct
+{
+	zbx_hashset_t	bytecodes;
+	size_t		size;
+	zbx_uint64_t	access;
+	int		initialized;
+}
+zbx_es_bytecode_cache_t;
+
+static zbx_es_bytecode_cache_t	es_bytecode_cache;
+static pthread_mutex_t		es_bytecode_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static zbx_hash_t	es_bytecode_hash(const void *d)
+{
+	const zbx_es_bytecode_t	*bytecode = (const zbx_es_bytecode_t *)d;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(bytecode->script);
+}
+
+static int	es_bytecode_compare(const void *d1, const void *d2)
+{
+	const zbx_es_bytecode_t	*bytecode1 = (const zbx_es_bytecode_t *)d1;
+	const zbx_es_bytecode_t	*bytecode2 = (const zbx_es_bytecode_t *)d2;
+
+	return strcmp(bytecode1->script, bytecode2->script);
+}
+
+static size_t	es_bytecode_size(const zbx_es_bytecode_t *bytecode)
+{
+	return strlen(bytecode->script) + 1 + (size_t)bytecode->size;
+}
+
+static void	es_bytecode_clear(void *d)
+{
+	zbx_es_bytecode_t	*bytecode = (zbx_es_bytecode_t *)d;
+
+	zbx_free(bytecode->script);
+	zbx_free(bytecode->code);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets copy of cached script bytecode                               *
+ *                                                                            *
+ * Parameters: script - [IN] the script                                       *
+ *             code   - [OUT] the bytecode                                    *
+ *             size   - [OUT] the size of bytecode                            *
+ *                                                                            *
+ * Return value: SUCCEED - the script bytecode was found in cache             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	es_bytecode_get(const char *script, char **code, int *size)
+{
+	zbx_es_bytecode_t	*bytecode, bytecode_local;
+	int			ret = FAIL;
+
+	pthread_mutex_lock(&es_bytecode_lock);
+
+	if (0 != es_bytecode_cache.initialized)
+	{
+		bytecode_local.script = (char *)script;
+
+		if (NULL != (bytecode = (zbx_es_bytecode_t *)zbx_hashset_search(&es_bytecode_cache.bytecodes,
+				&bytecode_local)))
+		{
+			bytecode->lastaccess = ++es_bytecode_cache.access;
+
+			*code = zbx_malloc(NULL, (size_t)bytecode->size);
+			memcpy(*code, bytecode->code, (size_t)bytecode->size);
+			*size = bytecode->size;
+
+			ret = SUCCEED;
+		}
+	}
+
+	pthread_mutex_unlock(&es_bytecode_lock);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds script bytecode to cache                                     *
+ *                                                                            *
+ * Parameters: script - [IN] the script                                       *
+ *             code   - [IN] the bytecode                                     *
+ *             size   - [IN] the size of bytecode                             *
+ *                                                                            *
+ * Comments: The least recently used scripts are removed from cache when its  *
+ *           size limit is reached.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	es_bytecode_add(const char *script, const char *code, int size)
+{
+	zbx_es_bytecode_t	bytecode_local;
+	size_t			bytecode_size;
+
+	bytecode_local.script = (char *)script;
+	bytecode_local.size = size;
+
+	if (ZBX_ES_BYTECODE_CACHE_SIZE < (bytecode_size = es_bytecode_size(&bytecode_local)))
+		return;
+
+	pthread_mutex_lock(&es_bytecode_lock);
+
+	if (0 == es_bytecode_cache.initialized)
+	{
+		zbx_hashset_create_ext(&es_bytecode_cache.bytecodes, 100, es_bytecode_hash, es_bytecode_compare,
+				es_bytecode_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+		es_bytecode_cache.initialized = 1;
+	}
+
+	/* the same script might have been compiled by other environment meanwhile */
+	if (NULL != zbx_hashset_search(&es_bytecode_cache.bytecodes, &bytecode_local))
+		goto out;
+
+	while (ZBX_ES_BYTECODE_CACHE_SIZE < es_bytecode_cache.size + bytecode_size)
+	{
+		zbx_hashset_iter_t	iter;
+		zbx_es_bytecode_t	*bytecode, *oldest = NULL;
+
+		zbx_hashset_iter_reset(&es_bytecode_cache.bytecodes, &iter);
+		while (NULL != (bytecode = (zbx_es_bytecode_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == oldest || bytecode->lastaccess < oldest->lastaccess)
+				oldest = bytecode;
+		}
+
+		es_bytecode_cache.size -= es_bytecode_size(oldest);
+		zbx_hashset_remove_direct(&es_bytecode_cache.bytecodes, oldest);
+	}
+
+	bytecode_local.script = zbx_strdup(NULL, script);
+	bytecode_local.code = zbx_malloc(NULL, (size_t)size);
+	memcpy(bytecode_local.code, code, (size_t)size);
+	bytecode_local.lastaccess = ++es_bytecode_cache.access;
+
+	zbx_hashset_insert(&es_bytecode_cache.bytecodes, &bytecode_local, sizeof(bytecode_local));
+	es_bytecode_cache.size += bytecode_size;
+out:
+	pthread_mutex_unlock(&es_bytecode_lock);
+}
+
+#else
+
+static int	es_bytecode_get(const char *script, char **code, int *size)
+{
+	ZBX_UNUSED(script);
+	ZBX_UNUSED(code);
+	ZBX_UNUSED(size);
+
+	return FAIL;
+}
+
+static void	es_bytecode_add(const char *script, const char *code, int size)
+{
+	ZBX_UNUSED(script);
+	ZBX_UNUSED(code);
+	ZBX_UNUSED(size);
+}
+
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: fatal error handler                                               *
@@ -360,6 +540,7 @@ int	zbx_es_init_env(zbx_es_t *es, const char *config_source_ip, char **error)
 out:
 	if (SUCCEED != ret)
 	{
+		zbx_es_destroy_httprequest(es);
 		zbx_es_debug_disable(es);
 		zbx_free(es->env->error);
 		zbx_free(es->env);
@@ -396,6 +577,7 @@ int	zbx_es_destroy_env(zbx_es_t *es, char **error)
 	}
 
 	duk_destroy_heap(es->env->ctx);
+	zbx_es_destroy_httprequest(es);
 	zbx_es_debug_disable(es);
 	zbx_free(es->env->browser_endpoint);
 	zbx_hashset_destroy(&es->env->objmap);
@@ -463,6 +645,8 @@ int	zbx_es_fatal_error(zbx_es_t *es)
  *                                                                            *
  * Comments: this function allocates the bytecode array, which must be        *
  *           freed by the caller after being used.                            *
+ *           Compiled bytecode is cached and shared by all environments of    *
+ *           the process, so the same script is compiled only once.           *
  *                                                                            *
  ******************************************************************************/
 int	zbx_es_compile(zbx_es_t *es, const char *script, char **code, int *size, char **error)
@@ -481,6 +665,13 @@ int	zbx_es_compile(zbx_es_t *es, const char *script, char **code, int *size, cha
 		goto out;
 	}
 
+	if (SUCCEED == es_bytecode_get(script, code, size))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() using cached bytecode", __func__);
+		ret = SUCCEED;
+		goto out;
+	}
+
 	if (0 != setjmp(es->env->loc))
 	{
 		*error = zbx_strdup(*error, es->env->error);
@@ -516,6 +707,7 @@ int	zbx_es_compile(zbx_es_t *es, const char *script, char **code, int *size, cha
 		*size = sz;
 		*code = zbx_malloc(NULL, sz);
 		memcpy(*code, buffer, sz);
+		es_bytecode_add(script, *code, *size);
 		ret = SUCCEED;
 	}
 	else
@@ -681,10 +873,10 @@ out:
 	duk_gc(es->env->ctx, 0);
 	duk_gc(es->env->ctx, 0);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s %s allocated memory: " ZBX_FS_SIZE_T
-			" max allocated or requested memory: " ZBX_FS_SIZE_T " max allowed memory: %d",
-			__func__, zbx_result_string(ret),
-			ZBX_NULL2EMPTY_STR(*error), (zbx_fs_size_t)es->env->total_alloc,
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s %s execution time: " ZBX_FS_UI64 " ms allocated memory: "
+			ZBX_FS_SIZE_T " max allocated or requested memory: " ZBX_FS_SIZE_T " max allowed memory: %d",
+			__func__, zbx_result_string(ret), ZBX_NULL2EMPTY_STR(*error),
+			zbx_get_duration_ms(&es->env->start_time), (zbx_fs_size_t)es->env->total_alloc,
 			(zbx_fs_size_t)es->env->max_total_alloc, ZBX_ES_MEMORY_LIMIT);
 	es->env->max_total_alloc = 0;
 
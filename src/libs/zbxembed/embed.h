@@ -63,6 +63,11 @@ struct zbx_es_env
 	int		constructor_chain;
 
 	zbx_hashset_t	objmap;
+
+#ifdef HAVE_LIBCURL
+	/* connection, DNS and TLS session caches shared by HttpRequest objects */
+	CURLSH		*curl_share;
+#endif
 };
 
 zbx_es_env_t	*zbx_es_get_env(duk_context *ctx);
@@ -182,6 +182,9 @@ static duk_ret_t	es_httprequest_ctor(duk_context *ctx)
 	ZBX_CURL_SETOPT(ctx, request->handle, CURLOPT_HEADERDATA, request, err);
 	ZBX_CURL_SETOPT(ctx, request->handle, CURLOPT_INTERFACE, env->config_source_ip, err);
 
+	if (NULL != env->curl_share)
+		ZBX_CURL_SETOPT(ctx, request->handle, CURLOPT_SHARE, env->curl_share, err);
+
 	duk_push_c_function(ctx, es_httprequest_dtor, 1);
 	duk_set_finalizer(ctx, -2);
 out:
@@ -786,6 +789,50 @@ out:
 	return 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates cURL share handle for HttpRequest objects of scripting    *
+ *          engine environment                                                *
+ *                                                                            *
+ * Comments: The environment is kept between script runs (for example by      *
+ *           alerters executing webhooks), so sharing connection cache allows *
+ *           keep-alive connections to the same endpoint to be reused by the  *
+ *           following requests instead of establishing a new TCP and TLS     *
+ *           session for every HttpRequest object. Cookies are not shared.    *
+ *           The environment is used by a single thread, so no locking is     *
+ *           required.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static CURLSH	*es_httprequest_share_create(void)
+{
+	CURLSH		*share;
+	CURLSHcode	err;
+
+	if (NULL == (share = curl_share_init()))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot initialize cURL share handle");
+		return NULL;
+	}
+
+	if (CURLSHE_OK != (err = curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS)) ||
+			CURLSHE_OK != (err = curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION)))
+	{
+		goto fail;
+	}
+
+/* connection cache sharing was added in 7.57.0 (0x073900) */
+#if LIBCURL_VERSION_NUM >= 0x073900
+	if (CURLSHE_OK != (err = curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT)))
+		goto fail;
+#endif
+	return share;
+fail:
+	zabbix_log(LOG_LEVEL_DEBUG, "cannot set cURL share option: %s", curl_share_strerror(err));
+	curl_share_cleanup(share);
+
+	return NULL;
+}
+
 static const duk_function_list_entry	httprequest_methods[] = {
 	{"addHeader", es_httprequest_add_header, 1},
 	{"clearHeader", es_httprequest_clear_header, 0},
@@ -864,7 +911,29 @@ int	zbx_es_init_httprequest(zbx_es_t *es, char **error)
 	duk_put_global_string(es->env->ctx, "HTTPAUTH_NEGOTIATE");
 	duk_push_number(es->env->ctx, ZBX_HTTPAUTH_NTLM);
 	duk_put_global_string(es->env->ctx, "HTTPAUTH_NTLM");
+
+	es->env->curl_share = es_httprequest_share_create();
 #endif
 
 	return SUCCEED;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: releases resources shared by HttpRequest objects                  *
+ *                                                                            *
+ * Comments: must be called after HttpRequest objects are destroyed           *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_es_destroy_httprequest(zbx_es_t *es)
+{
+#ifdef HAVE_LIBCURL
+	if (NULL != es->env->curl_share)
+	{
+		curl_share_cleanup(es->env->curl_share);
+		es->env->curl_share = NULL;
+	}
+#else
+	ZBX_UNUSED(es);
+#endif
+}
@@ -18,5 +18,6 @@
 #include "zbxembed.h"
 
 int	zbx_es_init_httprequest(zbx_es_t *es, char **error);
+void	zbx_es_destroy_httprequest(zbx_es_t *es);
 
 #endif
@@ -42,6 +42,8 @@ ZBX_THREAD_ENTRY(zbx_httppoller_thread, args)
 
 	const zbx_thread_httppoller_args	*httppoller_args_in = (const zbx_thread_httppoller_args *)
 						(((zbx_thread_args_t *)args)->args);
+	zbx_httptest_poller_t			*poller;
+	char					*error = NULL;
 
 	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(info->program_type),
 			server_num, get_process_type_string(process_type), process_num);
@@ -56,6 +58,13 @@ ZBX_THREAD_ENTRY(zbx_httppoller_thread, args)
 
 	zbx_db_connect(ZBX_DB_CONNECT_NORMAL);
 
+	if (NULL == (poller = httptest_poller_create(&error)))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize web scenario poller: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	while (ZBX_IS_RUNNING())
 	{
 		double	sec = zbx_time();
@@ -71,7 +80,7 @@ ZBX_THREAD_ENTRY(zbx_httppoller_thread, args)
 
 		if ((int)sec >= nextcheck)
 		{
-			httptests_count += process_httptests((int)sec, httppoller_args_in->config_source_ip,
+			httptests_count += process_httptests(poller, (int)sec, httppoller_args_in->config_source_ip,
 					httppoller_args_in->config_ssl_ca_location,
 					httppoller_args_in->config_ssl_cert_location,
 					httppoller_args_in->config_ssl_key_location, &nextcheck);
@@ -107,6 +116,8 @@ ZBX_THREAD_ENTRY(zbx_httppoller_thread, args)
 		zbx_sleep_loop(info, sleeptime);
 	}
 
+	httptest_poller_free(poller);
+
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
 
 	while (1)
@@ -34,6 +34,7 @@
 #include "zbxregexp.h"
 
 #include "zbxcurl.h"
+#include "zbxasynchttppoller.h"
 
 typedef struct
 {
@@ -572,588 +573,900 @@ out:
 	return ret;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: processes single scenario of HTTP test                            *
- *                                                                            *
- ******************************************************************************/
-static void	process_httptest(zbx_dc_host_t *host, zbx_httptest_t *httptest, int *delay,
-		const char *config_source_ip, const char *config_ssl_ca_location, const char *config_ssl_cert_location,
-		const char *config_ssl_key_location)
+struct zbx_httptest_poller
 {
+#ifdef HAVE_LIBCURL
+	struct event_base		*base;
+	zbx_asynchttppoller_config	*asynchttppoller_config;
+#endif
+	time_t				now;
+	int				processing;
+	int				finished;
+};
+
+typedef struct
+{
+	zbx_dc_host_t		host;
+	zbx_httptest_t		httptest;
 	zbx_db_result_t		result;
 	zbx_db_httpstep		db_httpstep;
-	char			*err_str = NULL, *buffer = NULL;
-	zbx_timespec_t		ts;
-	double			speed_download = 0;
-	int			speed_download_num = 0, lastfailedstep = 0;
+	char			*err_str;
+	double			speed_download;
+	int			speed_download_num;
+	int			lastfailedstep;
+	int			delay;
+	zbx_httptest_poller_t	*poller;
 #ifdef HAVE_LIBCURL
-	zbx_db_row_t		row;
+	zbx_httpstep_t		httpstep;
 	zbx_httpstat_t		stat;
+	CURL			*easyhandle;
+	struct curl_slist	*headers_slist;
+	zbx_http_response_t	body;
+	zbx_http_response_t	header;
 	char			errbuf[CURL_ERROR_SIZE];
-	CURL			*easyhandle = NULL;
-	CURLcode		err;
-	zbx_httpstep_t		httpstep;
-	zbx_http_response_t	body = {0}, header = {0};
 #endif
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() httptestid:" ZBX_FS_UI64 " name:'%s'",
-			__func__, httptest->httptest.httptestid, httptest->httptest.name);
+}
+zbx_httptest_context_t;
 
-	result = zbx_db_select(
-			"select httpstepid,no,name,url,timeout,posts,required,status_codes,post_type,follow_redirects,"
-				"retrieve_mode"
-			" from httpstep"
-			" where httptestid=" ZBX_FS_UI64
-			" order by no",
-			httptest->httptest.httptestid);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reports web scenario results, schedules next check and frees      *
+ *          web scenario context                                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	httptest_finish(zbx_httptest_context_t *context)
+{
+	zbx_timespec_t	ts;
+	zbx_httptest_t	*httptest = &context->httptest;
 
-	buffer = zbx_strdup(buffer, httptest->httptest.delay);
-	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-				&buffer, ZBX_MACRO_TYPE_COMMON, NULL, 0);
+	zbx_timespec(&ts);
 
-	/* Avoid the potential usage of uninitialized values when: */
-	/* 1) compile without libCURL support */
-	/* 2) update interval is invalid */
-	db_httpstep.name = NULL;
+	if (NULL != context->err_str)
+	{
+		if (0 >= context->lastfailedstep)
+		{
+			/* we are here because web scenario update interval is invalid, */
+			/* cURL initialization failed or we have been compiled without cURL library */
+
+			context->lastfailedstep = 1;
+		}
+
+		if (NULL != context->db_httpstep.name)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot process step \"%s\" of web scenario \"%s\" on host \"%s\": "
+					"%s", context->db_httpstep.name, httptest->httptest.name, context->host.name,
+					context->err_str);
+		}
+	}
+#ifdef HAVE_LIBCURL
+	if (NULL != context->easyhandle)
+		curl_easy_cleanup(context->easyhandle);
+#endif
+	zbx_db_free_result(context->result);
+
+	if (0 != context->speed_download_num)
+		context->speed_download /= context->speed_download_num;
 
-	if (SUCCEED != zbx_is_time_suffix(buffer, delay, ZBX_LENGTH_UNLIMITED))
+	process_test_data(httptest->httptest.httptestid, context->lastfailedstep, context->speed_download,
+			context->err_str, &ts);
+
+	zbx_dc_httptest_queue(context->poller->now, httptest->httptest.httptestid, context->delay);
+
+	zbx_free(context->err_str);
+	zbx_preprocessor_flush();
+
+	zbx_free(httptest->httptest.ssl_key_password);
+	zbx_free(httptest->httptest.ssl_key_file);
+	zbx_free(httptest->httptest.ssl_cert_file);
+	zbx_free(httptest->httptest.http_proxy);
+
+	if (HTTPTEST_AUTH_NONE != httptest->httptest.authentication)
 	{
-		err_str = zbx_dsprintf(err_str, "update interval \"%s\" is invalid", buffer);
-		lastfailedstep = -1;
-		*delay = ZBX_DEFAULT_INTERVAL;
-		goto httptest_error;
+		zbx_free(httptest->httptest.http_password);
+		zbx_free(httptest->httptest.http_user);
 	}
+	zbx_free(httptest->httptest.agent);
+	zbx_free(httptest->httptest.delay);
+	zbx_free(httptest->httptest.name);
+	zbx_free(httptest->headers);
+	httppairs_free(&httptest->variables);
+
+	/* clear the macro cache used in this HTTP test */
+	httptest_remove_macros(httptest);
+	zbx_vector_ptr_pair_destroy(&httptest->macros);
+
+	context->poller->processing--;
+	context->poller->finished++;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "finished processing httptestid:" ZBX_FS_UI64, httptest->httptest.httptestid);
+
+	zbx_free(context);
+}
 
 #ifdef HAVE_LIBCURL
-	if (NULL == (easyhandle = curl_easy_init()))
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees data of the current web scenario step                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	httpstep_clean(zbx_httptest_context_t *context)
+{
+	zbx_db_httpstep	*db_httpstep = &context->db_httpstep;
+	zbx_httpstep_t	*httpstep = &context->httpstep;
+
+	curl_slist_free_all(context->headers_slist);
+	context->headers_slist = NULL;
+
+	zbx_free(db_httpstep->status_codes);
+	zbx_free(db_httpstep->required);
+	zbx_free(db_httpstep->posts);
+	zbx_free(db_httpstep->url);
+
+	httppairs_free(&httpstep->variables);
+
+	if (ZBX_POSTTYPE_FORM == db_httpstep->post_type)
+		zbx_free(httpstep->posts);
+
+	zbx_free(httpstep->url);
+	zbx_free(httpstep->headers);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares next step of web scenario and adds it to the cURL multi  *
+ *          session                                                           *
+ *                                                                            *
+ * Parameters: context - [IN/OUT] web scenario context                        *
+ *                                                                            *
+ * Return value: SUCCEED - step was started                                   *
+ *               FAIL    - there are no more steps to execute or step failed  *
+ *                                                                            *
+ ******************************************************************************/
+static int	httpstep_start(zbx_httptest_context_t *context)
+{
+	zbx_db_row_t		row;
+	CURLcode		err;
+	CURLMcode		merr;
+	char			*header_cookie = NULL, *buffer = NULL;
+	zbx_curl_cb_t		curl_body_cb, curl_header_cb;
+	zbx_httptest_t		*httptest = &context->httptest;
+	zbx_db_httpstep		*db_httpstep = &context->db_httpstep;
+	zbx_httpstep_t		*httpstep = &context->httpstep;
+	CURL			*easyhandle = context->easyhandle;
+	zbx_dc_host_t		*host = &context->host;
+
+	if (NULL == (row = zbx_db_fetch(context->result)) || !ZBX_IS_RUNNING())
+		return FAIL;
+
+	ZBX_STR2UINT64(db_httpstep->httpstepid, row[0]);
+	db_httpstep->httptestid = httptest->httptest.httptestid;
+	db_httpstep->no = atoi(row[1]);
+	db_httpstep->name = row[2];
+
+	db_httpstep->url = zbx_strdup(NULL, row[3]);
+	zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL,
+			NULL, &db_httpstep->url, ZBX_MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+	http_substitute_variables(httptest, &db_httpstep->url);
+
+	db_httpstep->required = zbx_strdup(NULL, row[6]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL, NULL,
+			&db_httpstep->required, ZBX_MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+
+	db_httpstep->status_codes = zbx_strdup(NULL, row[7]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL, NULL,
+			NULL, &db_httpstep->status_codes, ZBX_MACRO_TYPE_COMMON, NULL, 0);
+
+	db_httpstep->post_type = atoi(row[8]);
+
+	if (ZBX_POSTTYPE_RAW == db_httpstep->post_type)
 	{
-		err_str = zbx_strdup(err_str, "cannot initialize cURL library");
-		goto clean;
+		db_httpstep->posts = zbx_strdup(NULL, row[5]);
+		zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL,
+				NULL, NULL, NULL, &db_httpstep->posts, ZBX_MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+		http_substitute_variables(httptest, &db_httpstep->posts);
 	}
+	else
+		db_httpstep->posts = NULL;
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROXY, httptest->httptest.http_proxy)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_COOKIEFILE, "")) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_USERAGENT, httptest->httptest.agent)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ACCEPT_ENCODING, "")))
+	if (SUCCEED != httpstep_load_pairs(host, httpstep))
 	{
-		err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-		goto clean;
+		context->err_str = zbx_strdup(context->err_str, "cannot load web scenario step data");
+		goto httpstep_error;
 	}
 
-	if (SUCCEED != zbx_curl_setopt_https(easyhandle, &err_str))
-		goto clean;
+	buffer = zbx_strdup(buffer, row[4]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL, NULL,
+			NULL, &buffer, ZBX_MACRO_TYPE_COMMON, NULL, 0);
 
-	if (SUCCEED != zbx_http_prepare_ssl(easyhandle, httptest->httptest.ssl_cert_file,
-			httptest->httptest.ssl_key_file, httptest->httptest.ssl_key_password,
-			httptest->httptest.verify_peer, httptest->httptest.verify_host, config_source_ip,
-			config_ssl_ca_location, config_ssl_cert_location, config_ssl_key_location, &err_str))
+	if (SUCCEED != zbx_is_time_suffix(buffer, &db_httpstep->timeout, ZBX_LENGTH_UNLIMITED))
 	{
-		goto clean;
+		context->err_str = zbx_dsprintf(context->err_str, "timeout \"%s\" is invalid", buffer);
+		goto httpstep_error;
 	}
-
-	httpstep.httptest = httptest;
-	httpstep.httpstep = &db_httpstep;
-
-	while (NULL != (row = zbx_db_fetch(result)) && ZBX_IS_RUNNING())
+	else if (db_httpstep->timeout < 1 || SEC_PER_HOUR < db_httpstep->timeout)
 	{
-		struct curl_slist	*headers_slist = NULL;
-		char			*header_cookie = NULL;
-		zbx_curl_cb_t		curl_body_cb, curl_header_cb;
-
-		/* NOTE: do not break or return from this block! */
-		/*       process_step_data() call is required! */
+		context->err_str = zbx_dsprintf(context->err_str, "timeout \"%s\" is out of 1-3600 seconds bounds",
+				buffer);
+		goto httpstep_error;
+	}
 
-		ZBX_STR2UINT64(db_httpstep.httpstepid, row[0]);
-		db_httpstep.httptestid = httptest->httptest.httptestid;
-		db_httpstep.no = atoi(row[1]);
-		db_httpstep.name = row[2];
+	db_httpstep->follow_redirects = atoi(row[9]);
+	db_httpstep->retrieve_mode = atoi(row[10]);
 
-		db_httpstep.url = zbx_strdup(NULL, row[3]);
-		zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL,
-				NULL, &db_httpstep.url, ZBX_MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
-		http_substitute_variables(httptest, &db_httpstep.url);
+	memset(&context->stat, 0, sizeof(context->stat));
 
-		db_httpstep.required = zbx_strdup(NULL, row[6]);
-		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL, NULL,
-				&db_httpstep.required, ZBX_MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() use step \"%s\"", __func__, db_httpstep->name);
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() use post \"%s\"", __func__, ZBX_NULL2EMPTY_STR(httpstep->posts));
 
-		db_httpstep.status_codes = zbx_strdup(NULL, row[7]);
-		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL, NULL,
-				NULL, &db_httpstep.status_codes, ZBX_MACRO_TYPE_COMMON, NULL, 0);
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_POSTFIELDS, httpstep->posts)))
+	{
+		context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		db_httpstep.post_type = atoi(row[8]);
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_POST, (NULL != httpstep->posts &&
+			'\0' != *httpstep->posts) ? 1L : 0L)))
+	{
+		context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		if (ZBX_POSTTYPE_RAW == db_httpstep.post_type)
-		{
-			db_httpstep.posts = zbx_strdup(NULL, row[5]);
-			zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL,
-					NULL, NULL, NULL, &db_httpstep.posts, ZBX_MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
-			http_substitute_variables(httptest, &db_httpstep.posts);
-		}
-		else
-			db_httpstep.posts = NULL;
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_FOLLOWLOCATION,
+			0 == db_httpstep->follow_redirects ? 0L : 1L)))
+	{
+		context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		if (SUCCEED != httpstep_load_pairs(host, &httpstep))
+	if (0 != db_httpstep->follow_redirects)
+	{
+		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
 		{
-			err_str = zbx_strdup(err_str, "cannot load web scenario step data");
+			context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
 			goto httpstep_error;
 		}
+	}
 
-		buffer = zbx_strdup(buffer, row[4]);
-		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL, NULL,
-				NULL, &buffer, ZBX_MACRO_TYPE_COMMON, NULL, 0);
+	/* headers defined in a step overwrite headers defined in scenario */
+	if (NULL != httpstep->headers && '\0' != *httpstep->headers)
+		add_http_headers(httpstep->headers, &context->headers_slist, &header_cookie);
+	else if (NULL != httptest->headers && '\0' != *httptest->headers)
+		add_http_headers(httptest->headers, &context->headers_slist, &header_cookie);
 
-		if (SUCCEED != zbx_is_time_suffix(buffer, &db_httpstep.timeout, ZBX_LENGTH_UNLIMITED))
-		{
-			err_str = zbx_dsprintf(err_str, "timeout \"%s\" is invalid", buffer);
-			goto httpstep_error;
-		}
-		else if (db_httpstep.timeout < 1 || SEC_PER_HOUR < db_httpstep.timeout)
-		{
-			err_str = zbx_dsprintf(err_str, "timeout \"%s\" is out of 1-3600 seconds bounds", buffer);
+	err = curl_easy_setopt(easyhandle, CURLOPT_COOKIE, header_cookie);
+	zbx_free(header_cookie);
+
+	if (CURLE_OK != err)
+	{
+		context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
+
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, context->headers_slist)))
+	{
+		context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
+
+	switch (db_httpstep->retrieve_mode)
+	{
+		case ZBX_RETRIEVE_MODE_CONTENT:
+			curl_header_cb = zbx_curl_ignore_cb;
+			curl_body_cb = zbx_curl_write_cb;
+			break;
+		case ZBX_RETRIEVE_MODE_BOTH:
+			curl_header_cb = curl_body_cb = zbx_curl_write_cb;
+			break;
+		case ZBX_RETRIEVE_MODE_HEADERS:
+			curl_header_cb = zbx_curl_write_cb;
+			curl_body_cb = zbx_curl_ignore_cb;
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			context->err_str = zbx_strdup(context->err_str, "invalid retrieve mode");
 			goto httpstep_error;
-		}
+	}
+
+	if (SUCCEED != zbx_http_prepare_callbacks(easyhandle, &context->header, &context->body, curl_header_cb,
+			curl_body_cb, context->errbuf, &context->err_str))
+	{
+		goto httpstep_error;
+	}
+
+	/* enable/disable fetching the body */
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_NOBODY,
+			ZBX_RETRIEVE_MODE_HEADERS == db_httpstep->retrieve_mode ? 1L : 0L)))
+	{
+		context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		db_httpstep.follow_redirects = atoi(row[9]);
-		db_httpstep.retrieve_mode = atoi(row[10]);
+	if (SUCCEED != zbx_http_prepare_auth(easyhandle, httptest->httptest.authentication,
+			httptest->httptest.http_user, httptest->httptest.http_password, NULL, &context->err_str))
+	{
+		goto httpstep_error;
+	}
 
-		memset(&stat, 0, sizeof(stat));
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() go to URL \"%s\"", __func__, httpstep->url);
 
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() use step \"%s\"", __func__, db_httpstep.name);
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() use post \"%s\"", __func__, ZBX_NULL2EMPTY_STR(httpstep.posts));
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, (long)db_httpstep->timeout)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, httpstep->url)))
+	{
+		context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
+		goto httpstep_error;
+	}
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_POSTFIELDS, httpstep.posts)))
-		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
-		}
+	memset(&context->header, 0, sizeof(context->header));
+	memset(&context->body, 0, sizeof(context->body));
+	context->errbuf[0] = '\0';
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_POST, (NULL != httpstep.posts &&
-				'\0' != *httpstep.posts) ? 1L : 0L)))
-		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
-		}
+	if (CURLM_OK != (merr = curl_multi_add_handle(context->poller->asynchttppoller_config->curl_handle,
+			easyhandle)))
+	{
+		context->err_str = zbx_dsprintf(context->err_str, "Cannot add a standard curl handle to the multi"
+				" stack: %s", curl_multi_strerror(merr));
+		goto httpstep_error;
+	}
 
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_FOLLOWLOCATION,
-				0 == db_httpstep.follow_redirects ? 0L : 1L)))
+	zbx_free(buffer);
+
+	return SUCCEED;
+httpstep_error:
+	zbx_free(buffer);
+	httpstep_clean(context);
+	context->lastfailedstep = db_httpstep->no;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes retrieved page of web scenario step                     *
+ *                                                                            *
+ * Parameters: context - [IN/OUT] web scenario context                        *
+ *             err     - [IN] cURL transfer result                            *
+ *                                                                            *
+ * Return value: SUCCEED - step was processed, continue with the next step    *
+ *               FAIL    - step failed or must be retried                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	httpstep_process(zbx_httptest_context_t *context, CURLcode err)
+{
+	zbx_timespec_t	ts;
+	zbx_httptest_t	*httptest = &context->httptest;
+	zbx_db_httpstep	*db_httpstep = &context->db_httpstep;
+	zbx_httpstep_t	*httpstep = &context->httpstep;
+	zbx_httpstat_t	*stat = &context->stat;
+	CURL		*easyhandle = context->easyhandle;
+
+	if (CURLE_OK == err)
+	{
+		char	*var_err_str = NULL, *data = NULL;
+
+		if (NULL != context->body.data)
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			zbx_http_convert_to_utf8(easyhandle, &context->body.data, &context->body.offset,
+					&context->body.allocated);
+			data = context->body.data;
 		}
 
-		if (0 != db_httpstep.follow_redirects)
+		if (NULL != context->header.data)
 		{
-			if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_MAXREDIRS, ZBX_CURLOPT_MAXREDIRS)))
+			if (NULL != context->body.data)
 			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-				goto httpstep_error;
+				zbx_strncpy_alloc(&context->header.data, &context->header.allocated,
+						&context->header.offset, context->body.data, context->body.offset);
 			}
+
+			data = context->header.data;
 		}
 
-		/* headers defined in a step overwrite headers defined in scenario */
-		if (NULL != httpstep.headers && '\0' != *httpstep.headers)
-			add_http_headers(httpstep.headers, &headers_slist, &header_cookie);
-		else if (NULL != httptest->headers && '\0' != *httptest->headers)
-			add_http_headers(httptest->headers, &headers_slist, &header_cookie);
+		if (NULL == data)
+			data = "";
 
-		err = curl_easy_setopt(easyhandle, CURLOPT_COOKIE, header_cookie);
-		zbx_free(header_cookie);
+		zabbix_log(LOG_LEVEL_TRACE, "%s() page.data from %s:'%s'", __func__, httpstep->url, data);
 
-		if (CURLE_OK != err)
+		/* first get the data that is needed even if step fails */
+		if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &stat->rspcode)))
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
 		}
-
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, headers_slist)))
+		else if ('\0' != *db_httpstep->status_codes &&
+				FAIL == zbx_int_in_list(db_httpstep->status_codes, stat->rspcode))
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			context->err_str = zbx_dsprintf(context->err_str, "response code \"%ld\" did not match any of"
+					" the required status codes \"%s\"", stat->rspcode, db_httpstep->status_codes);
 		}
 
-		switch (db_httpstep.retrieve_mode)
+		if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_TOTAL_TIME, &stat->total_time)) &&
+				NULL == context->err_str)
 		{
-			case ZBX_RETRIEVE_MODE_CONTENT:
-				curl_header_cb = zbx_curl_ignore_cb;
-				curl_body_cb = zbx_curl_write_cb;
-				break;
-			case ZBX_RETRIEVE_MODE_BOTH:
-				curl_header_cb = curl_body_cb = zbx_curl_write_cb;
-				break;
-			case ZBX_RETRIEVE_MODE_HEADERS:
-				curl_header_cb = zbx_curl_write_cb;
-				curl_body_cb = zbx_curl_ignore_cb;
-				break;
-			default:
-				THIS_SHOULD_NEVER_HAPPEN;
-				err_str = zbx_strdup(err_str, "invalid retrieve mode");
-				goto httpstep_error;
+			context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
 		}
 
-		if (SUCCEED != zbx_http_prepare_callbacks(easyhandle, &header, &body, curl_header_cb, curl_body_cb,
-				errbuf, &err_str))
+		if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_SPEED_DOWNLOAD_T,
+				&stat->speed_download)) && NULL == context->err_str)
 		{
-			goto httpstep_error;
+			context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
 		}
-
-		/* enable/disable fetching the body */
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_NOBODY,
-				ZBX_RETRIEVE_MODE_HEADERS == db_httpstep.retrieve_mode ? 1L : 0L)))
+		else
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
+			context->speed_download += (double)stat->speed_download;
+			context->speed_download_num++;
 		}
 
-		if (SUCCEED != zbx_http_prepare_auth(easyhandle, httptest->httptest.authentication,
-				httptest->httptest.http_user, httptest->httptest.http_password, NULL, &err_str))
+		/* required pattern */
+		if (NULL == context->err_str && '\0' != *db_httpstep->required &&
+				NULL == zbx_regexp_match(data, db_httpstep->required, NULL))
 		{
-			goto httpstep_error;
+			context->err_str = zbx_dsprintf(context->err_str, "required pattern \"%s\" was not found on %s",
+					db_httpstep->required, httpstep->url);
 		}
 
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() go to URL \"%s\"", __func__, httpstep.url);
-
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, (long)db_httpstep.timeout)) ||
-				CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, httpstep.url)))
+		/* variables defined in scenario */
+		if (NULL == context->err_str && FAIL == http_process_variables(httptest, &httptest->variables,
+				data, &var_err_str))
 		{
-			err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			goto httpstep_error;
-		}
+			char	*variables = NULL;
+			size_t	alloc_len = 0, offset;
 
-		/* try to retrieve page several times depending on number of retries */
-		do
-		{
-			memset(&header, 0, sizeof(header));
-			memset(&body, 0, sizeof(body));
-			errbuf[0] = '\0';
+			httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httptest->variables);
 
-			if (CURLE_OK == (err = curl_easy_perform(easyhandle)))
-				break;
+			context->err_str = zbx_dsprintf(context->err_str, "error in scenario variables \"%s\": %s",
+					variables, var_err_str);
 
-			zbx_free(body.data);
-			zbx_free(header.data);
+			zbx_free(variables);
 		}
-		while (0 < --httptest->httptest.retries);
 
-		if (CURLE_OK == err)
+		/* variables defined in a step */
+		if (NULL == context->err_str && FAIL == http_process_variables(httptest, &httpstep->variables, data,
+				&var_err_str))
 		{
-			char	*var_err_str = NULL, *data = NULL;
+			char	*variables = NULL;
+			size_t	alloc_len = 0, offset;
 
-			if (NULL != body.data)
-			{
-				zbx_http_convert_to_utf8(easyhandle, &body.data, &body.offset, &body.allocated);
-				data = body.data;
-			}
+			httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httpstep->variables);
 
-			if (NULL != header.data)
-			{
-				if (NULL != body.data)
-				{
-					zbx_strncpy_alloc(&header.data, &header.allocated, &header.offset, body.data,
-							body.offset);
-				}
+			context->err_str = zbx_dsprintf(context->err_str, "error in step variables \"%s\": %s",
+					variables, var_err_str);
 
-				data = header.data;
-			}
+			zbx_free(variables);
+		}
 
-			if (NULL == data)
-				data = "";
+		zbx_free(var_err_str);
 
-			zabbix_log(LOG_LEVEL_TRACE, "%s() page.data from %s:'%s'", __func__, httpstep.url, data);
+		zbx_timespec(&ts);
+		process_step_data(db_httpstep->httpstepid, stat, &ts);
 
-			/* first get the data that is needed even if step fails */
-			if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &stat.rspcode)))
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			}
-			else if ('\0' != *db_httpstep.status_codes &&
-					FAIL == zbx_int_in_list(db_httpstep.status_codes, stat.rspcode))
-			{
-				err_str = zbx_dsprintf(err_str, "response code \"%ld\" did not match any of the"
-						" required status codes \"%s\"", stat.rspcode,
-						db_httpstep.status_codes);
-			}
+		zbx_free(context->header.data);
+		zbx_free(context->body.data);
+	}
+	else
+	{
+		zbx_free(context->body.data);
+		zbx_free(context->header.data);
 
-			if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_TOTAL_TIME, &stat.total_time)) &&
-					NULL == err_str)
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			}
+		/* try to retrieve page several times depending on number of retries */
+		if (0 < --httptest->httptest.retries)
+			return FAIL;
 
-			if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_SPEED_DOWNLOAD_T,
-					&stat.speed_download)) && NULL == err_str)
-			{
-				err_str = zbx_strdup(err_str, curl_easy_strerror(err));
-			}
-			else
-			{
-				speed_download += (double)stat.speed_download;
-				speed_download_num++;
-			}
+		context->err_str = zbx_dsprintf(context->err_str, "%s", 0 < strlen(context->errbuf) ? context->errbuf :
+				curl_easy_strerror(err));
+	}
 
-			/* required pattern */
-			if (NULL == err_str && '\0' != *db_httpstep.required &&
-					NULL == zbx_regexp_match(data, db_httpstep.required, NULL))
-			{
-				err_str = zbx_dsprintf(err_str, "required pattern \"%s\" was not found on %s",
-						db_httpstep.required, httpstep.url);
-			}
+	httpstep_clean(context);
 
-			/* variables defined in scenario */
-			if (NULL == err_str && FAIL == http_process_variables(httptest, &httptest->variables,
-					data, &var_err_str))
-			{
-				char	*variables = NULL;
-				size_t	alloc_len = 0, offset;
+	if (NULL != context->err_str)
+	{
+		context->lastfailedstep = db_httpstep->no;
+		return FAIL;
+	}
 
-				httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httptest->variables);
+	return SUCCEED;
+}
 
-				err_str = zbx_dsprintf(err_str, "error in scenario variables \"%s\": %s", variables,
-						var_err_str);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: handles completed transfer of web scenario step and starts the    *
+ *          next step or finishes the web scenario                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_httpstep_result(CURL *easy_handle, CURLcode err, void *arg)
+{
+	zbx_httptest_context_t	*context;
+	zbx_httptest_poller_t	*poller = (zbx_httptest_poller_t *)arg;
+	CURLcode		err_info;
+	CURLMcode		merr;
 
-				zbx_free(variables);
-			}
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-			/* variables defined in a step */
-			if (NULL == err_str && FAIL == http_process_variables(httptest, &httpstep.variables, data,
-					&var_err_str))
-			{
-				char	*variables = NULL;
-				size_t	alloc_len = 0, offset;
+	if (CURLE_OK != (err_info = curl_easy_getinfo(easy_handle, CURLINFO_PRIVATE, &context)))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		zabbix_log(LOG_LEVEL_CRIT, "Cannot get pointer to private data: %s", curl_easy_strerror(err_info));
 
-				httpstep_pairs_join(&variables, &alloc_len, &offset, "=", " ", &httpstep.variables);
+		goto out;
+	}
 
-				err_str = zbx_dsprintf(err_str, "error in step variables \"%s\": %s", variables,
-						var_err_str);
+	curl_multi_remove_handle(poller->asynchttppoller_config->curl_handle, easy_handle);
 
-				zbx_free(variables);
-			}
+	if (SUCCEED == httpstep_process(context, err))
+	{
+		if (SUCCEED == httpstep_start(context))
+			goto out;
+	}
+	else if (NULL == context->err_str)
+	{
+		/* the step must be retried, its data is kept */
+		memset(&context->header, 0, sizeof(context->header));
+		memset(&context->body, 0, sizeof(context->body));
+		context->errbuf[0] = '\0';
 
-			zbx_free(var_err_str);
+		if (CURLM_OK == (merr = curl_multi_add_handle(poller->asynchttppoller_config->curl_handle,
+				easy_handle)))
+		{
+			goto out;
+		}
 
-			zbx_timespec(&ts);
-			process_step_data(db_httpstep.httpstepid, &stat, &ts);
+		context->err_str = zbx_dsprintf(context->err_str, "Cannot add a standard curl handle to the multi"
+				" stack: %s", curl_multi_strerror(merr));
+		httpstep_clean(context);
+		context->lastfailedstep = context->db_httpstep.no;
+	}
 
-			zbx_free(header.data);
-			zbx_free(body.data);
-		}
-		else
-			err_str = zbx_dsprintf(err_str, "%s", 0 < strlen(errbuf) ? errbuf : curl_easy_strerror(err));
-httpstep_error:
-		curl_slist_free_all(headers_slist);
-		zbx_free(db_httpstep.status_codes);
-		zbx_free(db_httpstep.required);
-		zbx_free(db_httpstep.posts);
-		zbx_free(db_httpstep.url);
+	httptest_finish(context);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+#endif	/* HAVE_LIBCURL */
 
-		httppairs_free(&httpstep.variables);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts processing of single scenario of HTTP test                 *
+ *                                                                            *
+ * Comments: The scenario context is freed either here, when the scenario     *
+ *           cannot be started, or when its last step is processed.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	httptest_start(zbx_httptest_context_t *context, const char *config_source_ip,
+		const char *config_ssl_ca_location, const char *config_ssl_cert_location,
+		const char *config_ssl_key_location)
+{
+	char			*buffer = NULL;
+	zbx_httptest_t		*httptest = &context->httptest;
+#ifdef HAVE_LIBCURL
+	CURLcode		err;
+	zbx_httptest_poller_t	*poller = context->poller;
+#endif
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() httptestid:" ZBX_FS_UI64 " name:'%s'",
+			__func__, httptest->httptest.httptestid, httptest->httptest.name);
 
-		if (ZBX_POSTTYPE_FORM == httpstep.httpstep->post_type)
-			zbx_free(httpstep.posts);
+	context->poller->processing++;
 
-		zbx_free(httpstep.url);
-		zbx_free(httpstep.headers);
+	context->result = zbx_db_select(
+			"select httpstepid,no,name,url,timeout,posts,required,status_codes,post_type,follow_redirects,"
+				"retrieve_mode"
+			" from httpstep"
+			" where httptestid=" ZBX_FS_UI64
+			" order by no",
+			httptest->httptest.httptestid);
 
-		if (NULL != err_str)
-		{
-			lastfailedstep = db_httpstep.no;
-			break;
-		}
+	buffer = zbx_strdup(buffer, httptest->httptest.delay);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &context->host.hostid, NULL, NULL, NULL, NULL, NULL,
+			NULL, NULL, &buffer, ZBX_MACRO_TYPE_COMMON, NULL, 0);
+
+	/* Avoid the potential usage of uninitialized values when: */
+	/* 1) compile without libCURL support */
+	/* 2) update interval is invalid */
+	context->db_httpstep.name = NULL;
+
+	if (SUCCEED != zbx_is_time_suffix(buffer, &context->delay, ZBX_LENGTH_UNLIMITED))
+	{
+		context->err_str = zbx_dsprintf(context->err_str, "update interval \"%s\" is invalid", buffer);
+		context->lastfailedstep = -1;
+		context->delay = ZBX_DEFAULT_INTERVAL;
+		goto httptest_error;
 	}
-clean:
-	curl_easy_cleanup(easyhandle);
-#else
-	ZBX_UNUSED(config_source_ip);
-	ZBX_UNUSED(config_ssl_ca_location);
-	ZBX_UNUSED(config_ssl_cert_location);
-	ZBX_UNUSED(config_ssl_key_location);
 
-	err_str = zbx_strdup(err_str, "cURL library is required for Web monitoring support");
-#endif	/* HAVE_LIBCURL */
+#ifdef HAVE_LIBCURL
+	if (NULL == (context->easyhandle = curl_easy_init()))
+	{
+		context->err_str = zbx_strdup(context->err_str, "cannot initialize cURL library");
+		goto httptest_error;
+	}
 
-httptest_error:
-	zbx_timespec(&ts);
+	/* the same easy handle is used for all steps of the scenario to keep its cookies */
+	if (CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PROXY,
+			httptest->httptest.http_proxy)) ||
+			CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_COOKIEFILE, "")) ||
+			CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_USERAGENT,
+			httptest->httptest.agent)) ||
+			CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_ACCEPT_ENCODING, "")) ||
+			CURLE_OK != (err = curl_easy_setopt(context->easyhandle, CURLOPT_PRIVATE, context)))
+	{
+		context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
+		goto httptest_error;
+	}
 
-	if (NULL != err_str)
+	if (NULL != poller->asynchttppoller_config->curl_share && CURLE_OK != (err = curl_easy_setopt(
+			context->easyhandle, CURLOPT_SHARE, poller->asynchttppoller_config->curl_share)))
 	{
-		if (0 >= lastfailedstep)
-		{
-			/* we are here because web scenario update interval is invalid, */
-			/* cURL initialization failed or we have been compiled without cURL library */
+		context->err_str = zbx_strdup(context->err_str, curl_easy_strerror(err));
+		goto httptest_error;
+	}
 
-			lastfailedstep = 1;
-		}
+	if (SUCCEED != zbx_curl_setopt_https(context->easyhandle, &context->err_str))
+		goto httptest_error;
 
-		if (NULL != db_httpstep.name)
-		{
-			zabbix_log(LOG_LEVEL_DEBUG, "cannot process step \"%s\" of web scenario \"%s\" on host \"%s\": "
-					"%s", db_httpstep.name, httptest->httptest.name, host->name, err_str);
-		}
+	if (SUCCEED != zbx_http_prepare_ssl(context->easyhandle, httptest->httptest.ssl_cert_file,
+			httptest->httptest.ssl_key_file, httptest->httptest.ssl_key_password,
+			httptest->httptest.verify_peer, httptest->httptest.verify_host, config_source_ip,
+			config_ssl_ca_location, config_ssl_cert_location, config_ssl_key_location, &context->err_str))
+	{
+		goto httptest_error;
 	}
-	zbx_db_free_result(result);
 
-	if (0 != speed_download_num)
-		speed_download /= speed_download_num;
+	context->httpstep.httptest = httptest;
+	context->httpstep.httpstep = &context->db_httpstep;
 
-	process_test_data(httptest->httptest.httptestid, lastfailedstep, speed_download, err_str, &ts);
+	if (SUCCEED == httpstep_start(context))
+	{
+		zbx_free(buffer);
+		goto out;
+	}
+#else
+	ZBX_UNUSED(config_source_ip);
+	ZBX_UNUSED(config_ssl_ca_location);
+	ZBX_UNUSED(config_ssl_cert_location);
+	ZBX_UNUSED(config_ssl_key_location);
 
+	context->err_str = zbx_strdup(context->err_str, "cURL library is required for Web monitoring support");
+#endif	/* HAVE_LIBCURL */
+httptest_error:
 	zbx_free(buffer);
-	zbx_free(err_str);
-	zbx_preprocessor_flush();
-
+	httptest_finish(context);
+#ifdef HAVE_LIBCURL
+out:
+#endif
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
 /******************************************************************************
  *                                                                            *
- * Parameters: now                      - [IN] current timestamp              *
- *             config_source_ip         - [IN]                                *
- *             config_ssl_ca_location   - [IN]                                *
- *             config_ssl_cert_location - [IN]                                *
- *             config_ssl_key_location  - [IN]                                *
- *             nextcheck                - [OUT]                               *
+ * Purpose: loads web scenario and creates its processing context             *
  *                                                                            *
- * Return value: number of processed httptests                                *
+ * Parameters: poller     - [IN] web scenario poller                          *
+ *             httptestid - [IN]                                              *
  *                                                                            *
- * Comments: always SUCCEED                                                   *
+ * Return value: web scenario context or NULL if it cannot be loaded          *
  *                                                                            *
  ******************************************************************************/
-int	process_httptests(int now, const char *config_source_ip, const char *config_ssl_ca_location,
-		const char *config_ssl_cert_location, const char *config_ssl_key_location, time_t *nextcheck)
+static zbx_httptest_context_t	*httptest_context_create(zbx_httptest_poller_t *poller, zbx_uint64_t httptestid)
 {
 	zbx_db_result_t		result;
 	zbx_db_row_t		row;
-	zbx_uint64_t		httptestid;
-	zbx_httptest_t		httptest;
-	zbx_dc_host_t		host;
-	int			httptests_count = 0;
-	zbx_dc_um_handle_t	*um_handle;
+	zbx_httptest_context_t	*context = NULL;
+	zbx_httptest_t		*httptest;
+	zbx_dc_host_t		*host;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	result = zbx_db_select(
+			"select h.hostid,h.host,h.name,t.httptestid,t.name,t.agent,"
+				"t.authentication,t.http_user,t.http_password,t.http_proxy,t.retries,"
+				"t.ssl_cert_file,t.ssl_key_file,t.ssl_key_password,t.verify_peer,"
+				"t.verify_host,t.delay"
+			" from httptest t,hosts h"
+			" where t.hostid=h.hostid"
+				" and t.httptestid=" ZBX_FS_UI64,
+			httptestid);
+
+	if (NULL == (row = zbx_db_fetch(result)))
+		goto out;
+
+	context = (zbx_httptest_context_t *)zbx_malloc(NULL, sizeof(zbx_httptest_context_t));
+	memset(context, 0, sizeof(zbx_httptest_context_t));
+	context->poller = poller;
 
-	if (SUCCEED != zbx_dc_httptest_next(now, &httptestid, nextcheck))
+	host = &context->host;
+	httptest = &context->httptest;
+
+	ZBX_STR2UINT64(host->hostid, row[0]);
+	zbx_strscpy(host->host, row[1]);
+	zbx_strlcpy_utf8(host->name, row[2], sizeof(host->name));
+
+	ZBX_STR2UINT64(httptest->httptest.httptestid, row[3]);
+	httptest->httptest.name = zbx_strdup(NULL, row[4]);
+
+	if (SUCCEED != httptest_load_pairs(host, httptest))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot process web scenario \"%s\" on host \"%s\": "
+				"cannot load web scenario data", httptest->httptest.name, host->name);
+		THIS_SHOULD_NEVER_HAPPEN;
+		zbx_free(httptest->httptest.name);
+		zbx_free(context);
 		goto out;
+	}
 
-	um_handle = zbx_dc_open_user_macros();
+	/* create macro cache to use in HTTP test */
+	zbx_vector_ptr_pair_create(&httptest->macros);
 
-	/* create macro cache to use in HTTP tests */
-	zbx_vector_ptr_pair_create(&httptest.macros);
+	httptest->httptest.agent = zbx_strdup(NULL, row[5]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL, NULL, NULL,
+			NULL, NULL, &httptest->httptest.agent, ZBX_MACRO_TYPE_COMMON, NULL, 0);
 
-	do
+	if (HTTPTEST_AUTH_NONE != (httptest->httptest.authentication = atoi(row[6])))
 	{
-		int	delay = 0;
-
-		result = zbx_db_select(
-				"select h.hostid,h.host,h.name,t.httptestid,t.name,t.agent,"
-					"t.authentication,t.http_user,t.http_password,t.http_proxy,t.retries,"
-					"t.ssl_cert_file,t.ssl_key_file,t.ssl_key_password,t.verify_peer,"
-					"t.verify_host,t.delay"
-				" from httptest t,hosts h"
-				" where t.hostid=h.hostid"
-					" and t.httptestid=" ZBX_FS_UI64,
-				httptestid);
-
-		if (NULL != (row = zbx_db_fetch(result)))
-		{
-			ZBX_STR2UINT64(host.hostid, row[0]);
-			zbx_strscpy(host.host, row[1]);
-			zbx_strlcpy_utf8(host.name, row[2], sizeof(host.name));
+		httptest->httptest.http_user = zbx_strdup(NULL, row[7]);
+		zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL,
+				NULL, NULL, NULL, NULL, NULL, &httptest->httptest.http_user,
+				ZBX_MACRO_TYPE_COMMON, NULL, 0);
+
+		httptest->httptest.http_password = zbx_strdup(NULL, row[8]);
+		zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL,
+				NULL, NULL, NULL, NULL, NULL, &httptest->httptest.http_password,
+				ZBX_MACRO_TYPE_COMMON, NULL, 0);
+	}
 
-			ZBX_STR2UINT64(httptest.httptest.httptestid, row[3]);
-			httptest.httptest.name = row[4];
+	if ('\0' != *row[9])
+	{
+		httptest->httptest.http_proxy = zbx_strdup(NULL, row[9]);
+		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL,
+				NULL, NULL, NULL, NULL, &httptest->httptest.http_proxy,
+				ZBX_MACRO_TYPE_COMMON, NULL, 0);
+	}
+	else
+		httptest->httptest.http_proxy = NULL;
 
-			if (SUCCEED != httptest_load_pairs(&host, &httptest))
-			{
-				zabbix_log(LOG_LEVEL_WARNING, "cannot process web scenario \"%s\" on host \"%s\": "
-						"cannot load web scenario data", httptest.httptest.name, host.name);
-				zbx_db_free_result(result);
-				THIS_SHOULD_NEVER_HAPPEN;
-				continue;
-			}
+	httptest->httptest.retries = atoi(row[10]);
 
-			httptest.httptest.agent = zbx_strdup(NULL, row[5]);
-			zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL, NULL, NULL,
-					NULL, NULL, &httptest.httptest.agent, ZBX_MACRO_TYPE_COMMON, NULL, 0);
+	httptest->httptest.ssl_cert_file = zbx_strdup(NULL, row[11]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL,
+			NULL, &httptest->httptest.ssl_cert_file, ZBX_MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
 
-			if (HTTPTEST_AUTH_NONE != (httptest.httptest.authentication = atoi(row[6])))
-			{
-				httptest.httptest.http_user = zbx_strdup(NULL, row[7]);
-				zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL,
-						NULL, NULL, NULL, NULL, NULL, &httptest.httptest.http_user,
-						ZBX_MACRO_TYPE_COMMON, NULL, 0);
-
-				httptest.httptest.http_password = zbx_strdup(NULL, row[8]);
-				zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL,
-						NULL, NULL, NULL, NULL, NULL, &httptest.httptest.http_password,
-						ZBX_MACRO_TYPE_COMMON, NULL, 0);
-			}
+	httptest->httptest.ssl_key_file = zbx_strdup(NULL, row[12]);
+	zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, host, NULL, NULL, NULL, NULL, NULL,
+			NULL, &httptest->httptest.ssl_key_file, ZBX_MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
 
-			if ('\0' != *row[9])
-			{
-				httptest.httptest.http_proxy = zbx_strdup(NULL, row[9]);
-				zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL,
-						NULL, NULL, NULL, NULL, &httptest.httptest.http_proxy,
-						ZBX_MACRO_TYPE_COMMON, NULL, 0);
-			}
-			else
-				httptest.httptest.http_proxy = NULL;
+	httptest->httptest.ssl_key_password = zbx_strdup(NULL, row[13]);
+	zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host->hostid, NULL, NULL, NULL,
+			NULL, NULL, NULL, NULL, &httptest->httptest.ssl_key_password,
+			ZBX_MACRO_TYPE_COMMON, NULL, 0);
 
-			httptest.httptest.retries = atoi(row[10]);
+	httptest->httptest.verify_peer = atoi(row[14]);
+	httptest->httptest.verify_host = atoi(row[15]);
 
-			httptest.httptest.ssl_cert_file = zbx_strdup(NULL, row[11]);
-			zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, &host, NULL, NULL, NULL, NULL, NULL,
-					NULL, &httptest.httptest.ssl_cert_file, ZBX_MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+	httptest->httptest.delay = zbx_strdup(NULL, row[16]);
 
-			httptest.httptest.ssl_key_file = zbx_strdup(NULL, row[12]);
-			zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, &host, NULL, NULL, NULL, NULL, NULL,
-					NULL, &httptest.httptest.ssl_key_file, ZBX_MACRO_TYPE_HTTPTEST_FIELD, NULL, 0);
+	/* add httptest variables to the current test macro cache */
+	http_process_variables(httptest, &httptest->variables, NULL, NULL);
+out:
+	zbx_db_free_result(result);
 
-			httptest.httptest.ssl_key_password = zbx_strdup(NULL, row[13]);
-			zbx_substitute_simple_macros_unmasked(NULL, NULL, NULL, NULL, &host.hostid, NULL, NULL, NULL,
-					NULL, NULL, NULL, NULL, &httptest.httptest.ssl_key_password,
-					ZBX_MACRO_TYPE_COMMON, NULL, 0);
+	return context;
+}
 
-			httptest.httptest.verify_peer = atoi(row[14]);
-			httptest.httptest.verify_host = atoi(row[15]);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates web scenario poller                                       *
+ *                                                                            *
+ * Parameters: error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: web scenario poller or NULL on error                         *
+ *                                                                            *
+ ******************************************************************************/
+zbx_httptest_poller_t	*httptest_poller_create(char **error)
+{
+	zbx_httptest_poller_t	*poller;
 
-			httptest.httptest.delay = row[16];
+	poller = (zbx_httptest_poller_t *)zbx_malloc(NULL, sizeof(zbx_httptest_poller_t));
+	memset(poller, 0, sizeof(zbx_httptest_poller_t));
 
-			/* add httptest variables to the current test macro cache */
-			http_process_variables(&httptest, &httptest.variables, NULL, NULL);
+#ifdef HAVE_LIBCURL
+	if (NULL == (poller->base = event_base_new()))
+	{
+		*error = zbx_strdup(*error, "cannot initialize event base");
+		zbx_free(poller);
 
-			process_httptest(&host, &httptest, &delay, config_source_ip, config_ssl_ca_location,
-					config_ssl_cert_location, config_ssl_key_location);
-			zbx_dc_httptest_queue(now, httptestid, delay);
+		return NULL;
+	}
+
+	zbx_async_httpagent_init();
+
+	if (NULL == (poller->asynchttppoller_config = zbx_async_httpagent_create(poller->base,
+			process_httpstep_result, NULL, poller, error)))
+	{
+		event_base_free(poller->base);
+		zbx_free(poller);
 
-			zbx_free(httptest.httptest.ssl_key_password);
-			zbx_free(httptest.httptest.ssl_key_file);
-			zbx_free(httptest.httptest.ssl_cert_file);
-			zbx_free(httptest.httptest.http_proxy);
+		return NULL;
+	}
+#else
+	ZBX_UNUSED(error);
+#endif
+	return poller;
+}
+
+void	httptest_poller_free(zbx_httptest_poller_t *poller)
+{
+#ifdef HAVE_LIBCURL
+	zbx_async_httpagent_clean(poller->asynchttppoller_config);
+	zbx_free(poller->asynchttppoller_config);
+	event_base_free(poller->base);
+#endif
+	zbx_free(poller);
+}
 
-			if (HTTPTEST_AUTH_NONE != httptest.httptest.authentication)
+/******************************************************************************
+ *                                                                            *
+ * Parameters: poller                   - [IN] web scenario poller            *
+ *             now                      - [IN] current timestamp              *
+ *             config_source_ip         - [IN]                                *
+ *             config_ssl_ca_location   - [IN]                                *
+ *             config_ssl_cert_location - [IN]                                *
+ *             config_ssl_key_location  - [IN]                                *
+ *             nextcheck                - [OUT]                               *
+ *                                                                            *
+ * Return value: number of processed httptests                                *
+ *                                                                            *
+ * Comments: Web scenarios are executed concurrently, up to                   *
+ *           HTTPTEST_CONCURRENCY_MAX at a time. Steps of each scenario are   *
+ *           executed in order using the same cURL easy handle.               *
+ *                                                                            *
+ ******************************************************************************/
+int	process_httptests(zbx_httptest_poller_t *poller, int now, const char *config_source_ip,
+		const char *config_ssl_ca_location, const char *config_ssl_cert_location,
+		const char *config_ssl_key_location, time_t *nextcheck)
+{
+/* each scenario in progress keeps its connection and step data */
+#define HTTPTEST_CONCURRENCY_MAX	200
+
+	zbx_uint64_t		httptestid;
+	zbx_httptest_context_t	*context;
+	int			httptests_count = 0, queue_empty = 0;
+	zbx_dc_um_handle_t	*um_handle;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	poller->now = now;
+	poller->finished = 0;
+
+	um_handle = zbx_dc_open_user_macros();
+
+	for (;;)
+	{
+		if (0 == queue_empty && HTTPTEST_CONCURRENCY_MAX > poller->processing && ZBX_IS_RUNNING())
+		{
+			if (SUCCEED == zbx_dc_httptest_next(now, &httptestid, nextcheck))
 			{
-				zbx_free(httptest.httptest.http_password);
-				zbx_free(httptest.httptest.http_user);
+				if (NULL != (context = httptest_context_create(poller, httptestid)))
+				{
+					httptest_start(context, config_source_ip, config_ssl_ca_location,
+							config_ssl_cert_location, config_ssl_key_location);
+					httptests_count++;	/* performance metric */
+				}
+
+				continue;
 			}
-			zbx_free(httptest.httptest.agent);
-			zbx_free(httptest.headers);
-			httppairs_free(&httptest.variables);
 
-			/* clear the macro cache used in this HTTP test */
-			httptest_remove_macros(&httptest);
+			queue_empty = 1;
+		}
 
-			httptests_count++;	/* performance metric */
+		if (0 == poller->processing)
+			break;
+#ifdef HAVE_LIBCURL
+		event_base_loop(poller->base, EVLOOP_ONCE);
+#endif
+		/* rescheduled scenarios might change the next check time */
+		if (0 != poller->finished)
+		{
+			queue_empty = 0;
+			poller->finished = 0;
 		}
-		zbx_db_free_result(result);
 	}
-	while (ZBX_IS_RUNNING() && SUCCEED == zbx_dc_httptest_next(now, &httptestid, nextcheck));
-
-	/* destroy the macro cache used in HTTP tests */
-	zbx_vector_ptr_pair_destroy(&httptest.macros);
 
 	zbx_dc_close_user_macros(um_handle);
-out:
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return httptests_count;
+#undef HTTPTEST_CONCURRENCY_MAX
 }
@@ -17,7 +17,12 @@
 
 #include "zbxcommon.h"
 
-int	process_httptests(int now, const char *config_source_ip, const char *config_ssl_ca_location,
-		const char *config_ssl_cert_location, const char *config_ssl_key_location, time_t *nextcheck);
+typedef struct zbx_httptest_poller zbx_httptest_poller_t;
+
+zbx_httptest_poller_t	*httptest_poller_create(char **error);
+void	httptest_poller_free(zbx_httptest_poller_t *poller);
+int	process_httptests(zbx_httptest_poller_t *poller, int now, const char *config_source_ip,
+		const char *config_ssl_ca_location, const char *config_ssl_cert_location,
+		const char *config_ssl_key_location, time_t *nextcheck);
 
 #endif
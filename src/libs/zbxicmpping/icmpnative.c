@@ -0,0 +1,744 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "icmpnative.h"
+
+#include "zbxcomms.h"
+#include "zbxalgo.h"
+#include "zbxstr.h"
+#include "zbxtime.h"
+
+/* In-process ICMP echo engine. Probes to all targets are sent from a single event loop using   */
+/* unprivileged ICMP datagram sockets (Linux ping sockets, net.ipv4.ping_group_range) or raw    */
+/* sockets when the process has enough privileges. Replies are matched to probes by the tag    */
+/* stored at the beginning of the echo request payload, so probes to any number of targets      */
+/* with different ping parameters can be outstanding at the same time.                          */
+
+#define ICMP_NATIVE_ECHO_REPLY		0
+#define ICMP_NATIVE_ECHO_REQUEST	8
+#define ICMP_NATIVE_ECHO6_REQUEST	128
+#define ICMP_NATIVE_ECHO6_REPLY		129
+
+#define ICMP_NATIVE_DEFAULT_PERIOD	1000	/* default interval between probes to one target (fping -p), ms */
+#define ICMP_NATIVE_DEFAULT_SIZE	56	/* default amount of probe data (fping -b), bytes               */
+#define ICMP_NATIVE_MAX_TIMEOUT		2000	/* maximum default probe timeout (fping -t with -C), ms         */
+#define ICMP_NATIVE_MAX_IPHDR_SIZE	60
+#define ICMP_NATIVE_SEND_BURST		128	/* number of probes sent before checking for replies            */
+#define ICMP_NATIVE_SEND_RETRY		0.001	/* delay before retrying send to a full socket buffer, sec       */
+#define ICMP_NATIVE_RCVBUF_SIZE		(4 * ZBX_MEBIBYTE)
+
+#define ICMP_NATIVE_SOCKET_IPV4		0
+#define ICMP_NATIVE_SOCKET_IPV6		1
+#define ICMP_NATIVE_SOCKET_COUNT	2
+
+typedef struct
+{
+	unsigned char	type;
+	unsigned char	code;
+	unsigned short	checksum;
+	unsigned short	id;
+	unsigned short	seq;
+}
+icmp_native_header_t;
+
+/* the probe tag stored at the beginning of echo request payload */
+typedef struct
+{
+	zbx_uint32_t	cookie;
+	zbx_uint32_t	target;
+	zbx_uint32_t	probe;
+}
+icmp_native_tag_t;
+
+typedef struct
+{
+	int		fd;
+	int		family;
+	int		type;		/* SOCK_DGRAM - ping socket, SOCK_RAW - raw socket */
+	unsigned short	seq;
+}
+icmp_native_socket_t;
+
+typedef struct
+{
+	zbx_fping_host_t	*host;
+	const zbx_fping_batch_t	*batch;
+	icmp_native_socket_t	*sock;
+	struct sockaddr_storage	addr;
+	socklen_t		addrlen;
+	double			*sent_at;	/* probe sending timestamps */
+	int			sent;		/* number of sent probes */
+	double			period;		/* interval between probes, sec */
+	double			timeout;	/* probe timeout, sec */
+	size_t			size;		/* amount of probe data, bytes */
+	double			nextsend;
+}
+icmp_native_target_t;
+
+typedef struct
+{
+	icmp_native_target_t	*targets;
+	int			targets_num;
+	icmp_native_socket_t	sockets[ICMP_NATIVE_SOCKET_COUNT];
+	zbx_binary_heap_t	queue;		/* targets ordered by the next probe sending time */
+	zbx_uint32_t		cookie;
+	unsigned short		id;
+	unsigned char		*packet;
+	size_t			packet_size;
+	int			pending;	/* number of probes waiting for reply */
+	double			deadline;	/* time when the last sent probe expires */
+}
+icmp_native_engine_t;
+
+static int	icmp_native_target_compare(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+
+	const icmp_native_target_t	*t1 = (const icmp_native_target_t *)e1->data;
+	const icmp_native_target_t	*t2 = (const icmp_native_target_t *)e2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(t1->nextsend, t2->nextsend);
+
+	return 0;
+}
+
+static void	icmp_native_target_queue(icmp_native_engine_t *engine, icmp_native_target_t *target)
+{
+	zbx_binary_heap_elem_t	elem = {0, (void *)target};
+
+	zbx_binary_heap_insert(&engine->queue, &elem);
+}
+
+static unsigned short	icmp_native_checksum(const unsigned char *data, size_t len)
+{
+	zbx_uint32_t	sum = 0;
+
+	for (; 1 < len; len -= 2, data += 2)
+		sum += (zbx_uint32_t)((data[0] << 8) | data[1]);
+
+	if (0 != len)
+		sum += (zbx_uint32_t)(data[0] << 8);
+
+	while (0 != (sum >> 16))
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return htons((unsigned short)~sum);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: opens ICMP socket of the specified address family                 *
+ *                                                                            *
+ * Parameters: sock          - [OUT] the socket                               *
+ *             family        - [IN] address family                            *
+ *             source_ip     - [IN] source address to bind to (optional)      *
+ *             error         - [OUT] error message                            *
+ *             max_error_len - [IN] length of error buffer                    *
+ *                                                                            *
+ * Return value: SUCCEED - socket was opened                                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Unprivileged ping socket is preferred, raw socket is used when   *
+ *           ping sockets are not supported or not allowed for the process    *
+ *           group.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_native_socket_open(icmp_native_socket_t *sock, int family, const char *source_ip, char *error,
+		size_t max_error_len)
+{
+	int	protocol, flags, rcvbuf = ICMP_NATIVE_RCVBUF_SIZE;
+
+#ifdef HAVE_IPV6
+	protocol = (AF_INET == family ? IPPROTO_ICMP : IPPROTO_ICMPV6);
+#else
+	protocol = IPPROTO_ICMP;
+#endif
+	sock->family = family;
+	sock->seq = 0;
+	sock->type = SOCK_DGRAM;
+
+	if (-1 == (sock->fd = socket(family, SOCK_DGRAM, protocol)))
+	{
+		sock->type = SOCK_RAW;
+
+		if (-1 == (sock->fd = socket(family, SOCK_RAW, protocol)))
+		{
+			zbx_snprintf(error, max_error_len, "cannot create %s socket: %s",
+					AF_INET == family ? "ICMP" : "ICMPv6", zbx_strerror(errno));
+			return FAIL;
+		}
+	}
+
+	if (-1 == (flags = fcntl(sock->fd, F_GETFL, 0)) || -1 == fcntl(sock->fd, F_SETFL, flags | O_NONBLOCK))
+	{
+		zbx_snprintf(error, max_error_len, "cannot set ICMP socket to non-blocking mode: %s",
+				zbx_strerror(errno));
+		goto fail;
+	}
+
+	/* replies from many targets can arrive while probes are being sent */
+	if (-1 == setsockopt(sock->fd, SOL_SOCKET, SO_RCVBUF, (const void *)&rcvbuf, sizeof(rcvbuf)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot set ICMP socket receive buffer size: %s", zbx_strerror(errno));
+	}
+
+	if (NULL != source_ip)
+	{
+		struct addrinfo	hints, *ai = NULL;
+		int		rc;
+
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = family;
+		hints.ai_flags = AI_NUMERICHOST;
+
+		if (0 != (rc = getaddrinfo(source_ip, NULL, &hints, &ai)))
+		{
+			zbx_snprintf(error, max_error_len, "cannot use source address \"%s\" for %s socket: %s",
+					source_ip, AF_INET == family ? "ICMP" : "ICMPv6", gai_strerror(rc));
+			goto fail;
+		}
+
+		rc = bind(sock->fd, ai->ai_addr, ai->ai_addrlen);
+		freeaddrinfo(ai);
+
+		if (-1 == rc)
+		{
+			zbx_snprintf(error, max_error_len, "cannot bind ICMP socket to \"%s\": %s", source_ip,
+					zbx_strerror(errno));
+			goto fail;
+		}
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "opened %s %s socket", AF_INET == family ? "ICMP" : "ICMPv6",
+			SOCK_DGRAM == sock->type ? "ping" : "raw");
+
+	return SUCCEED;
+fail:
+	close(sock->fd);
+	sock->fd = -1;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolves target address                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_native_target_resolve(icmp_native_target_t *target)
+{
+	struct addrinfo	hints, *ai = NULL;
+
+	memset(&hints, 0, sizeof(hints));
+#ifdef HAVE_IPV6
+	hints.ai_family = AF_UNSPEC;
+#else
+	hints.ai_family = AF_INET;
+#endif
+	hints.ai_socktype = SOCK_DGRAM;
+
+	if (0 != getaddrinfo(target->host->addr, NULL, &hints, &ai))
+		return FAIL;
+
+	memcpy(&target->addr, ai->ai_addr, ai->ai_addrlen);
+	target->addrlen = (socklen_t)ai->ai_addrlen;
+	freeaddrinfo(ai);
+
+	return SUCCEED;
+}
+
+static int	icmp_native_target_match_addr(const icmp_native_target_t *target, const struct sockaddr_storage *addr)
+{
+	if (addr->ss_family != target->addr.ss_family)
+		return FAIL;
+
+	if (AF_INET == addr->ss_family)
+	{
+		if (((const struct sockaddr_in *)addr)->sin_addr.s_addr !=
+				((const struct sockaddr_in *)&target->addr)->sin_addr.s_addr)
+		{
+			return FAIL;
+		}
+
+		return SUCCEED;
+	}
+#ifdef HAVE_IPV6
+	if (0 != memcmp(&((const struct sockaddr_in6 *)addr)->sin6_addr,
+			&((const struct sockaddr_in6 *)&target->addr)->sin6_addr, sizeof(struct in6_addr)))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+#else
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends the next probe to target                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the probe was sent or failed to be sent, in both   *
+ *                         cases it counts as sent                            *
+ *               FAIL    - socket send buffer is full, retry later            *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_native_probe_send(icmp_native_engine_t *engine, icmp_native_target_t *target, int index,
+		double now)
+{
+	icmp_native_header_t	header;
+	icmp_native_tag_t	tag;
+	icmp_native_socket_t	*sock = target->sock;
+	size_t			len = sizeof(header) + target->size;
+	ssize_t			rc;
+
+	header.type = (AF_INET == sock->family ? ICMP_NATIVE_ECHO_REQUEST : ICMP_NATIVE_ECHO6_REQUEST);
+	header.code = 0;
+	header.checksum = 0;
+	header.id = htons(engine->id);
+	header.seq = htons(sock->seq);
+
+	tag.cookie = engine->cookie;
+	tag.target = (zbx_uint32_t)index;
+	tag.probe = (zbx_uint32_t)target->sent;
+
+	memcpy(engine->packet, &header, sizeof(header));
+	memcpy(engine->packet + sizeof(header), &tag, sizeof(tag));
+
+	/* the kernel calculates checksum for ping sockets and ICMPv6 raw sockets */
+	if (AF_INET == sock->family && SOCK_RAW == sock->type)
+	{
+		header.checksum = icmp_native_checksum(engine->packet, len);
+		memcpy(engine->packet, &header, sizeof(header));
+	}
+
+	if (-1 == (rc = sendto(sock->fd, engine->packet, len, 0, (struct sockaddr *)&target->addr,
+			target->addrlen)))
+	{
+		if (EAGAIN == errno || EWOULDBLOCK == errno || ENOBUFS == errno)
+			return FAIL;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot send ICMP probe to \"%s\": %s", target->host->addr,
+				zbx_strerror(errno));
+	}
+
+	sock->seq++;
+	target->sent_at[target->sent++] = now;
+
+	if (-1 != rc)
+	{
+		engine->pending++;
+
+		if (engine->deadline < now + target->timeout)
+			engine->deadline = now + target->timeout;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends probes with expired sending time                            *
+ *                                                                            *
+ * Return value: SUCCEED - all due probes were sent                           *
+ *               FAIL    - the probe sending was interrupted to process       *
+ *                         replies                                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_native_send_due(icmp_native_engine_t *engine, double now)
+{
+	int	sent_num = 0;
+
+	while (SUCCEED != zbx_binary_heap_empty(&engine->queue))
+	{
+		zbx_binary_heap_elem_t	*elem;
+		icmp_native_target_t	*target;
+
+		elem = zbx_binary_heap_find_min(&engine->queue);
+		target = (icmp_native_target_t *)elem->data;
+
+		if (target->nextsend > now)
+			return SUCCEED;
+
+		if (ICMP_NATIVE_SEND_BURST <= sent_num)
+			return FAIL;
+
+		zbx_binary_heap_remove_min(&engine->queue);
+
+		if (SUCCEED != icmp_native_probe_send(engine, target, (int)(target - engine->targets), now))
+		{
+			target->nextsend = now + ICMP_NATIVE_SEND_RETRY;
+			icmp_native_target_queue(engine, target);
+
+			return SUCCEED;
+		}
+
+		sent_num++;
+
+		if (target->sent < target->batch->requests_count)
+		{
+			target->nextsend = target->sent_at[target->sent - 1] + target->period;
+			icmp_native_target_queue(engine, target);
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: receives and processes echo replies from ICMP socket              *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_native_recv(icmp_native_engine_t *engine, icmp_native_socket_t *sock, unsigned char *buffer,
+		size_t buffer_size)
+{
+	struct sockaddr_storage	from;
+	socklen_t		fromlen;
+	ssize_t			len;
+
+	for (;;)
+	{
+		icmp_native_header_t	header;
+		icmp_native_tag_t	tag;
+		icmp_native_target_t	*target;
+		zbx_fping_host_t	*host;
+		unsigned char		*ptr = buffer, expected_type;
+		double			now, sec;
+
+		fromlen = sizeof(from);
+
+		if (-1 == (len = recvfrom(sock->fd, buffer, buffer_size, 0, (struct sockaddr *)&from, &fromlen)))
+			break;
+
+		now = zbx_time();
+
+		/* IPv4 raw sockets receive packets with IP header */
+		if (AF_INET == sock->family && SOCK_RAW == sock->type)
+		{
+			size_t	hdrlen = (size_t)(buffer[0] & 0x0f) * 4;
+
+			if ((size_t)len < hdrlen)
+				continue;
+
+			ptr += hdrlen;
+			len -= (ssize_t)hdrlen;
+		}
+
+		if ((size_t)len < sizeof(header) + sizeof(tag))
+			continue;
+
+		memcpy(&header, ptr, sizeof(header));
+		memcpy(&tag, ptr + sizeof(header), sizeof(tag));
+
+		expected_type = (AF_INET == sock->family ? ICMP_NATIVE_ECHO_REPLY : ICMP_NATIVE_ECHO6_REPLY);
+
+		if (expected_type != header.type)
+			continue;
+
+		/* the ping socket identifier is assigned by kernel, which also filters replies */
+		if (SOCK_RAW == sock->type && engine->id != ntohs(header.id))
+			continue;
+
+		if (engine->cookie != tag.cookie || (zbx_uint32_t)engine->targets_num <= tag.target)
+			continue;
+
+		target = &engine->targets[tag.target];
+		host = target->host;
+
+		if (target->sock != sock || (zbx_uint32_t)target->sent <= tag.probe)
+			continue;
+
+		/* ignore duplicate responses */
+		if (0 != host->status[tag.probe])
+			continue;
+
+		if (target->timeout < (sec = now - target->sent_at[tag.probe]))
+			continue;
+
+		if (SUCCEED != icmp_native_target_match_addr(target, &from) && 0 == target->batch->allow_redirect)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "treating redirected response as target host \"%s\" down",
+					host->addr);
+			continue;
+		}
+
+		host->status[tag.probe] = 1;
+
+		if (0 == host->rcv || host->min > sec)
+			host->min = sec;
+		if (0 == host->rcv || host->max < sec)
+			host->max = sec;
+		host->sum += sec;
+		host->rcv++;
+
+		engine->pending--;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolves DNS names of pinged hosts                                *
+ *                                                                            *
+ * Comments: Similarly to fping -d option, names are set for all resolved     *
+ *           targets, but reverse lookups are made only for responding ones.  *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_native_resolve_names(icmp_native_engine_t *engine)
+{
+	for (int i = 0; i < engine->targets_num; i++)
+	{
+		icmp_native_target_t	*target = &engine->targets[i];
+		char			name[NI_MAXHOST];
+
+		if (NULL == target->sock)
+			continue;
+
+		if (0 == target->host->rcv || 0 != getnameinfo((struct sockaddr *)&target->addr, target->addrlen,
+				name, sizeof(name), NULL, 0, NI_NAMEREQD) ||
+				ZBX_MAX_DNSNAME_LEN < zbx_strlen_utf8(name))
+		{
+			*name = '\0';
+		}
+
+		target->host->dnsname = zbx_strdup(target->host->dnsname, name);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pings hosts with in-process ICMP engine                           *
+ *                                                                            *
+ * Parameters: batches       - [IN/OUT] hosts to ping grouped by ping         *
+ *                                      parameters                            *
+ *             batches_num   - [IN] number of batches                         *
+ *             rdns          - [IN] resolve DNS names of the pinged hosts     *
+ *             source_ip     - [IN] source address (optional)                 *
+ *             error         - [OUT] error message                            *
+ *             max_error_len - [IN] length of error buffer                    *
+ *                                                                            *
+ * Return value: SUCCEED      - hosts were pinged                             *
+ *               NOTSUPPORTED - unexpected error                              *
+ *               FAIL         - ICMP sockets cannot be used, external fping   *
+ *                              utility must be used instead                  *
+ *                                                                            *
+ * Comments: Results are stored in host structures the same way as when      *
+ *           pinging with fping.                                              *
+ *                                                                            *
+ ******************************************************************************/
+int	icmp_native_ping(zbx_fping_batch_t *batches, int batches_num, int rdns, const char *source_ip, char *error,
+		size_t max_error_len)
+{
+	icmp_native_engine_t	engine;
+	int			i, j, ret = SUCCEED, families[ICMP_NATIVE_SOCKET_COUNT] = {0};
+	unsigned char		*buffer = NULL;
+	size_t			buffer_size, size_max = 0;
+	double			now;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() batches:%d", __func__, batches_num);
+
+	memset(&engine, 0, sizeof(engine));
+
+	for (i = 0; i < ICMP_NATIVE_SOCKET_COUNT; i++)
+		engine.sockets[i].fd = -1;
+
+	for (i = 0; i < batches_num; i++)
+		engine.targets_num += batches[i].hosts_count;
+
+	engine.targets = (icmp_native_target_t *)zbx_calloc(NULL, (size_t)engine.targets_num,
+			sizeof(icmp_native_target_t));
+
+	for (i = 0, engine.targets_num = 0; i < batches_num; i++)
+	{
+		zbx_fping_batch_t	*batch = &batches[i];
+		int			period, timeout;
+		size_t			size;
+
+		period = (0 != batch->period ? batch->period : ICMP_NATIVE_DEFAULT_PERIOD);
+		timeout = (0 != batch->timeout ? batch->timeout : MIN(period, ICMP_NATIVE_MAX_TIMEOUT));
+		size = (0 != batch->size ? (size_t)batch->size : ICMP_NATIVE_DEFAULT_SIZE);
+
+		if (sizeof(icmp_native_tag_t) > size)
+			size = sizeof(icmp_native_tag_t);
+
+		if (size_max < size)
+			size_max = size;
+
+		for (j = 0; j < batch->hosts_count; j++)
+		{
+			icmp_native_target_t	*target = &engine.targets[engine.targets_num++];
+
+			target->host = &batch->hosts[j];
+			target->batch = batch;
+			target->period = period / 1000.0;
+			target->timeout = timeout / 1000.0;
+			target->size = size;
+
+			if (SUCCEED != icmp_native_target_resolve(target))
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "cannot resolve ICMP ping target \"%s\"", target->host->addr);
+				continue;
+			}
+
+			if (AF_INET == target->addr.ss_family)
+				families[ICMP_NATIVE_SOCKET_IPV4] = AF_INET;
+#ifdef HAVE_IPV6
+			else
+				families[ICMP_NATIVE_SOCKET_IPV6] = AF_INET6;
+#endif
+		}
+	}
+
+	for (i = 0; i < ICMP_NATIVE_SOCKET_COUNT; i++)
+	{
+		if (0 == families[i])
+			continue;
+
+		if (SUCCEED != icmp_native_socket_open(&engine.sockets[i], families[i], source_ip, error,
+				max_error_len))
+		{
+			ret = FAIL;
+			goto out;
+		}
+	}
+
+	engine.packet_size = sizeof(icmp_native_header_t) + size_max;
+	engine.packet = (unsigned char *)zbx_malloc(NULL, engine.packet_size);
+	memset(engine.packet, 0, engine.packet_size);
+
+	buffer_size = ICMP_NATIVE_MAX_IPHDR_SIZE + engine.packet_size;
+	buffer = (unsigned char *)zbx_malloc(NULL, buffer_size);
+
+	now = zbx_time();
+	engine.id = (unsigned short)(zbx_get_thread_id() & 0xffff);
+	engine.cookie = (zbx_uint32_t)zbx_get_thread_id() ^ (zbx_uint32_t)((now - (time_t)now) * 1000000000);
+	engine.deadline = now;
+
+	zbx_binary_heap_create(&engine.queue, icmp_native_target_compare, ZBX_BINARY_HEAP_OPTION_EMPTY);
+
+	for (i = 0; i < engine.targets_num; i++)
+	{
+		icmp_native_target_t	*target = &engine.targets[i];
+		zbx_fping_host_t	*host = target->host;
+
+		if (0 == target->addrlen)
+			continue;
+
+		target->sock = &engine.sockets[AF_INET == target->addr.ss_family ? ICMP_NATIVE_SOCKET_IPV4 :
+				ICMP_NATIVE_SOCKET_IPV6];
+		target->sent_at = (double *)zbx_malloc(NULL, sizeof(double) * (size_t)target->batch->requests_count);
+		target->nextsend = now;
+
+		host->status = (char *)zbx_malloc(host->status, (size_t)target->batch->requests_count);
+		memset(host->status, 0, (size_t)target->batch->requests_count);
+
+		icmp_native_target_queue(&engine, target);
+	}
+
+	for (;;)
+	{
+		zbx_pollfd_t		pds[ICMP_NATIVE_SOCKET_COUNT];
+		icmp_native_socket_t	*socks[ICMP_NATIVE_SOCKET_COUNT];
+		int			pds_num = 0, timeout, rc;
+		double			wait_until;
+
+		now = zbx_time();
+
+		if (SUCCEED == icmp_native_send_due(&engine, now))
+		{
+			if (SUCCEED == zbx_binary_heap_empty(&engine.queue))
+			{
+				if (0 == engine.pending || now >= engine.deadline)
+					break;
+
+				wait_until = engine.deadline;
+			}
+			else
+			{
+				wait_until = ((icmp_native_target_t *)zbx_binary_heap_find_min(&engine.queue)->data)->
+						nextsend;
+			}
+
+			timeout = (wait_until > now ? (int)((wait_until - now) * 1000) + 1 : 0);
+		}
+		else
+			timeout = 0;
+
+		for (i = 0; i < ICMP_NATIVE_SOCKET_COUNT; i++)
+		{
+			if (-1 == engine.sockets[i].fd)
+				continue;
+
+			socks[pds_num] = &engine.sockets[i];
+			pds[pds_num].fd = engine.sockets[i].fd;
+			pds[pds_num].events = POLLIN;
+			pds[pds_num].revents = 0;
+			pds_num++;
+		}
+
+		if (-1 == (rc = zbx_socket_poll(pds, (unsigned long)pds_num, timeout)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zbx_snprintf(error, max_error_len, "cannot wait for ICMP replies: %s", zbx_strerror(errno));
+			ret = NOTSUPPORTED;
+			goto clean;
+		}
+
+		if (0 == rc)
+			continue;
+
+		for (i = 0; i < pds_num; i++)
+		{
+			if (0 != (pds[i].revents & POLLIN))
+				icmp_native_recv(&engine, socks[i], buffer, buffer_size);
+		}
+	}
+
+	for (i = 0; i < engine.targets_num; i++)
+	{
+		icmp_native_target_t	*target = &engine.targets[i];
+
+		if (NULL != target->sock)
+			target->host->cnt += target->batch->requests_count;
+	}
+
+	if (0 != rdns)
+		icmp_native_resolve_names(&engine);
+clean:
+	zbx_binary_heap_destroy(&engine.queue);
+
+	for (i = 0; i < engine.targets_num; i++)
+	{
+		zbx_free(engine.targets[i].sent_at);
+		zbx_free(engine.targets[i].host->status);
+	}
+out:
+	for (i = 0; i < ICMP_NATIVE_SOCKET_COUNT; i++)
+	{
+		if (-1 != engine.sockets[i].fd)
+			close(engine.sockets[i].fd);
+	}
+
+	zbx_free(buffer);
+	zbx_free(engine.packet);
+	zbx_free(engine.targets);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
@@ -0,0 +1,23 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_ICMPNATIVE_H
+#define ZABBIX_ICMPNATIVE_H
+
+#include "zbxicmpping.h"
+
+int	icmp_native_ping(zbx_fping_batch_t *batches, int batches_num, int rdns, const char *source_ip, char *error,
+		size_t max_error_len);
+
+#endif
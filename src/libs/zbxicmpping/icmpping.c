@@ -13,6 +13,7 @@
 **/
 
 #include "zbxicmpping.h"
+#include "icmpnative.h"
 
 #ifdef HAVE_IPV6
 #	include "zbxcomms.h"
@@ -1199,23 +1200,89 @@ void	zbx_init_icmpping_env(const char *prefix, long int id)
  * Return value: SUCCEED - successfully processed hosts                       *
  *               NOTSUPPORTED - otherwise                                     *
  *                                                                            *
- * Comments: use external binary 'fping' to avoid superuser privileges        *
+ * Comments: Hosts are pinged with in-process ICMP engine using unprivileged  *
+ *           ping sockets or raw sockets. If neither of them are available    *
+ *           external binary 'fping' is used to avoid superuser privileges.   *
  *                                                                            *
  ******************************************************************************/
 int	zbx_ping(zbx_fping_host_t *hosts, int hosts_count, int requests_count, int period, int size, int timeout,
 		unsigned char allow_redirect, int rdns, char *error, size_t max_error_len)
 {
-	int	ret;
+	int			ret;
+	zbx_fping_batch_t	batch = {.hosts = hosts, .hosts_count = hosts_count, .requests_count = requests_count,
+					.period = period, .size = size, .timeout = timeout,
+					.allow_redirect = allow_redirect};
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts_count:%d", __func__, hosts_count);
 
-	if (NOTSUPPORTED == (ret = hosts_ping(hosts, hosts_count, requests_count, period, size, timeout,
-			allow_redirect, rdns, error, max_error_len)))
+	if (FAIL == (ret = icmp_native_ping(&batch, 1, rdns, config_icmpping->get_source_ip(), error,
+			max_error_len)))
 	{
-		zabbix_log(LOG_LEVEL_ERR, "%s", error);
+		zabbix_log(LOG_LEVEL_DEBUG, "%s, using fping", error);
+
+		ret = hosts_ping(hosts, hosts_count, requests_count, period, size, timeout, allow_redirect, rdns,
+				error, max_error_len);
 	}
 
+	if (NOTSUPPORTED == ret)
+		zabbix_log(LOG_LEVEL_ERR, "%s", error);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: ping multiple groups of hosts with different ping parameters      *
+ *                                                                            *
+ * Parameters: batches     - [IN/OUT] hosts to ping grouped by ping           *
+ *                                    parameters, see zbx_ping() for the      *
+ *                                    parameter description                   *
+ *             batches_num - [IN] number of batches                           *
+ *                                                                            *
+ * Comments: With in-process ICMP engine hosts of all batches are pinged      *
+ *           concurrently. Otherwise batches are pinged one by one with fping.*
+ *           The result of each batch is stored in its ret field, the error   *
+ *           message must be freed by the caller.                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ping_batches(zbx_fping_batch_t *batches, int batches_num)
+{
+	int	i, ret;
+	char	error[MAX_STRING_LEN];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() batches_num:%d", __func__, batches_num);
+
+	if (FAIL != (ret = icmp_native_ping(batches, batches_num, 0, config_icmpping->get_source_ip(), error,
+			sizeof(error))))
+	{
+		if (NOTSUPPORTED == ret)
+			zabbix_log(LOG_LEVEL_ERR, "%s", error);
+
+		for (i = 0; i < batches_num; i++)
+		{
+			if (NOTSUPPORTED == (batches[i].ret = ret))
+				batches[i].error = zbx_strdup(batches[i].error, error);
+		}
+
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s, using fping", error);
+
+	for (i = 0; i < batches_num; i++)
+	{
+		zbx_fping_batch_t	*batch = &batches[i];
+
+		if (NOTSUPPORTED == (batch->ret = hosts_ping(batch->hosts, batch->hosts_count, batch->requests_count,
+				batch->period, batch->size, batch->timeout, batch->allow_redirect, 0, error,
+				sizeof(error))))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "%s", error);
+			batch->error = zbx_strdup(batch->error, error);
+		}
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
@@ -89,79 +89,82 @@ clean:
  *                                                                            *
  * Purpose: processes new item values                                         *
  *                                                                            *
+ * Comments: items are sorted by address and batch hosts are created from     *
+ *           the items in the same order                                      *
+ *                                                                            *
  ******************************************************************************/
-static void	process_values(icmpitem_t *items, int first_index, int last_index, zbx_fping_host_t *hosts,
-		int hosts_count, zbx_timespec_t *ts, int ping_result, char *error)
+static void	process_values(icmpitem_t *items, int first_index, int last_index, const zbx_fping_batch_t *batch,
+		zbx_timespec_t *ts)
 {
+	const zbx_fping_host_t	*host = batch->hosts;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	for (int h = 0; h < hosts_count; h++)
+	for (int i = first_index; i < last_index; i++)
 	{
-		const zbx_fping_host_t	*host = &hosts[h];
-
-		if (NOTSUPPORTED == ping_result)
-		{
-			zabbix_log(LOG_LEVEL_DEBUG, "host [%s] %s", host->addr, error);
-		}
-		else
-		{
-			zabbix_log(LOG_LEVEL_DEBUG, "host [%s] cnt=%d rcv=%d"
-					" min=" ZBX_FS_DBL " max=" ZBX_FS_DBL " sum=" ZBX_FS_DBL,
-					host->addr, host->cnt, host->rcv, host->min, host->max, host->sum);
-		}
+		zbx_uint64_t		value_uint64;
+		double			value_dbl;
+		const icmpitem_t	*item = &items[i];
 
-		for (int i = first_index; i < last_index; i++)
+		if (i == first_index || 0 != strcmp(item->addr, items[i - 1].addr))
 		{
-			zbx_uint64_t		value_uint64;
-			double			value_dbl;
-			const icmpitem_t	*item = &items[i];
-
-			if (0 != strcmp(item->addr, host->addr))
-				continue;
+			if (i != first_index)
+				host++;
 
-			if (NOTSUPPORTED == ping_result)
+			if (NOTSUPPORTED == batch->ret)
 			{
-				process_value(item->itemid, NULL, NULL, ts, NOTSUPPORTED, error);
-				continue;
+				zabbix_log(LOG_LEVEL_DEBUG, "host [%s] %s", host->addr, batch->error);
 			}
-
-			if (0 == host->cnt)
+			else
 			{
-				process_value(item->itemid, NULL, NULL, ts, NOTSUPPORTED,
-						(char *)"Cannot send ICMP ping packets to this host.");
-				continue;
+				zabbix_log(LOG_LEVEL_DEBUG, "host [%s] cnt=%d rcv=%d"
+						" min=" ZBX_FS_DBL " max=" ZBX_FS_DBL " sum=" ZBX_FS_DBL,
+						host->addr, host->cnt, host->rcv, host->min, host->max, host->sum);
 			}
+		}
 
-			switch (item->icmpping)
-			{
-				case ICMPPING:
-					value_uint64 = (0 != host->rcv ? 1 : 0);
-					process_value(item->itemid, &value_uint64, NULL, ts, SUCCEED, NULL);
-					break;
-				case ICMPPINGSEC:
-					switch (item->type)
-					{
-						case ICMPPINGSEC_MIN:
-							value_dbl = host->min;
-							break;
-						case ICMPPINGSEC_MAX:
-							value_dbl = host->max;
-							break;
-						case ICMPPINGSEC_AVG:
-							value_dbl = (0 != host->rcv ? host->sum / host->rcv : 0);
-							break;
-					}
-
-					if (0 < value_dbl && zbx_get_float_epsilon() > value_dbl)
-						value_dbl = zbx_get_float_epsilon();
-
-					process_value(item->itemid, NULL, &value_dbl, ts, SUCCEED, NULL);
-					break;
-				case ICMPPINGLOSS:
-					value_dbl = (100 * (host->cnt - host->rcv)) / (double)host->cnt;
-					process_value(item->itemid, NULL, &value_dbl, ts, SUCCEED, NULL);
-					break;
-			}
+		if (NOTSUPPORTED == batch->ret)
+		{
+			process_value(item->itemid, NULL, NULL, ts, NOTSUPPORTED, batch->error);
+			continue;
+		}
+
+		if (0 == host->cnt)
+		{
+			process_value(item->itemid, NULL, NULL, ts, NOTSUPPORTED,
+					(char *)"Cannot send ICMP ping packets to this host.");
+			continue;
+		}
+
+		switch (item->icmpping)
+		{
+			case ICMPPING:
+				value_uint64 = (0 != host->rcv ? 1 : 0);
+				process_value(item->itemid, &value_uint64, NULL, ts, SUCCEED, NULL);
+				break;
+			case ICMPPINGSEC:
+				switch (item->type)
+				{
+					case ICMPPINGSEC_MIN:
+						value_dbl = host->min;
+						break;
+					case ICMPPINGSEC_MAX:
+						value_dbl = host->max;
+						break;
+					case ICMPPINGSEC_AVG:
+						value_dbl = (0 != host->rcv ? host->sum / host->rcv : 0);
+						break;
+				}
+
+				if (0 < value_dbl && zbx_get_float_epsilon() > value_dbl)
+					value_dbl = zbx_get_float_epsilon();
+
+				process_value(item->itemid, NULL, &value_dbl, ts, SUCCEED, NULL);
+				break;
+			case ICMPPINGLOSS:
+				value_dbl = (100 * (host->cnt - host->rcv)) / (double)host->cnt;
+				process_value(item->itemid, NULL, &value_dbl, ts, SUCCEED, NULL);
+				break;
 		}
 	}
 
@@ -326,79 +329,44 @@ out:
 #undef MIN_TIMEOUT
 }
 
-static int	get_icmpping_nearestindex(icmpitem_t *items, int items_count, int count, int interval, int size,
-		int timeout)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sorts items by ping parameters and address, so items that can be  *
+ *          pinged together are next to each other                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmpping_item_compare(const void *d1, const void *d2)
 {
-	int		first_index, last_index, index;
-	icmpitem_t	*item;
-
-	if (items_count == 0)
-		return 0;
-
-	first_index = 0;
-	last_index = items_count - 1;
+	const icmpitem_t	*i1 = (const icmpitem_t *)d1;
+	const icmpitem_t	*i2 = (const icmpitem_t *)d2;
 
-	while (1)
-	{
-		index = first_index + (last_index - first_index) / 2;
-		item = &items[index];
-
-		if (item->count == count && item->interval == interval && item->size == size &&
-				item->timeout == timeout)
-		{
-			return index;
-		}
-		else if (last_index == first_index)
-		{
-			if (item->count < count ||
-					(item->count == count && item->interval < interval) ||
-					(item->count == count && item->interval == interval && item->size < size) ||
-					(item->count == count && item->interval == interval && item->size == size &&
-					item->timeout < timeout))
-			{
-				index++;
-			}
+	ZBX_RETURN_IF_NOT_EQUAL(i1->count, i2->count);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->interval, i2->interval);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->size, i2->size);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->timeout, i2->timeout);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->allow_redirect, i2->allow_redirect);
 
-			return index;
-		}
-		else if (item->count < count ||
-				(item->count == count && item->interval < interval) ||
-				(item->count == count && item->interval == interval && item->size < size) ||
-				(item->count == count && item->interval == interval && item->size == size &&
-				item->timeout < timeout))
-		{
-			first_index = index + 1;
-		}
-		else
-		{
-			last_index = index;
-		}
-	}
+	return strcmp(i1->addr, i2->addr);
 }
 
 static void	add_icmpping_item(icmpitem_t **items, int *items_alloc, int *items_count, int count, int interval,
 		int size, int timeout, zbx_uint64_t itemid, char *addr, icmpping_t icmpping, icmppingsec_type_t type,
 		unsigned char allow_redirect)
 {
-	int		index;
 	icmpitem_t	*item;
 	size_t		sz;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() addr:'%s' count:%d interval:%d size:%d timeout:%d allow_redirect:%u",
 			__func__, addr, count, interval, size, timeout, allow_redirect);
 
-	index = get_icmpping_nearestindex(*items, *items_count, count, interval, size, timeout);
-
 	if (*items_alloc == *items_count)
 	{
-		*items_alloc += 4;
+		*items_alloc += MAX(4, *items_alloc / 2);
 		sz = *items_alloc * sizeof(icmpitem_t);
 		*items = (icmpitem_t *)zbx_realloc(*items, sz);
 	}
 
-	memmove(&(*items)[index + 1], &(*items)[index], sizeof(icmpitem_t) * (*items_count - index));
-
-	item = &(*items)[index];
+	item = &(*items)[*items_count];
 	item->count	= count;
 	item->interval	= interval;
 	item->size	= size;
@@ -493,75 +461,95 @@ static void	free_hosts(icmpitem_t **items, int *items_count)
 	*items_count = 0;
 }
 
-static void	add_pinger_host(zbx_fping_host_t **hosts, int *hosts_alloc, int *hosts_count, char *addr)
+static int	icmpping_items_batchable(const icmpitem_t *i1, const icmpitem_t *i2)
 {
-	zbx_fping_host_t	*h;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() addr:'%s'", __func__, addr);
-
-	for (int i = 0; i < *hosts_count; i++)
-	{
-		if (0 == strcmp(addr, (*hosts)[i].addr))
-			return;
-	}
-
-	(*hosts_count)++;
-
-	if (*hosts_alloc < *hosts_count)
+	if (i1->count != i2->count || i1->interval != i2->interval || i1->size != i2->size ||
+			i1->timeout != i2->timeout || i1->allow_redirect != i2->allow_redirect)
 	{
-		size_t	sz;
-
-		*hosts_alloc += 4;
-		sz = *hosts_alloc * sizeof(zbx_fping_host_t);
-		*hosts = (zbx_fping_host_t *)zbx_realloc(*hosts, sz);
+		return FAIL;
 	}
 
-	h = &(*hosts)[*hosts_count - 1];
-	memset(h, 0, sizeof(zbx_fping_host_t));
-	h->addr = addr;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pings hosts of all items grouped by ping parameters               *
+ *                                                                            *
+ * Comments: All groups are pinged at once, so with in-process ICMP engine    *
+ *           hosts with different ping parameters are pinged concurrently.    *
+ *                                                                            *
+ ******************************************************************************/
 static void	process_pinger_hosts(icmpitem_t *items, int items_count, int process_num, int process_type)
 {
-	int			ping_result, first_index = 0;
-	char			error[ZBX_ITEM_ERROR_LEN_MAX];
-	static zbx_fping_host_t	*hosts = NULL;
-	static int		hosts_alloc = 4;
-	int			hosts_count = 0;
+	zbx_fping_batch_t	*batches;
+	zbx_fping_host_t	*hosts;
+	int			*batch_index, batches_num = 0, hosts_num = 0;
 	zbx_timespec_t		ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	if (NULL == hosts)
-		hosts = (zbx_fping_host_t *)zbx_malloc(hosts, sizeof(zbx_fping_host_t) * hosts_alloc);
+	if (0 == items_count)
+		goto out;
+
+	qsort(items, (size_t)items_count, sizeof(icmpitem_t), icmpping_item_compare);
+
+	batches = (zbx_fping_batch_t *)zbx_malloc(NULL, sizeof(zbx_fping_batch_t) * (size_t)items_count);
+	batch_index = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)(items_count + 1));
+
+	/* batches are contiguous in sorted items, so their hosts are slices of the same array */
+	hosts = (zbx_fping_host_t *)zbx_malloc(NULL, sizeof(zbx_fping_host_t) * (size_t)items_count);
 
-	for (int i = 0; i < items_count && ZBX_IS_RUNNING(); i++)
+	for (int i = 0; i < items_count; i++)
 	{
-		add_pinger_host(&hosts, &hosts_alloc, &hosts_count, items[i].addr);
+		zbx_fping_batch_t	*batch;
 
-		if (i == items_count - 1 || items[i].count != items[i + 1].count ||
-				items[i].interval != items[i + 1].interval || items[i].size != items[i + 1].size ||
-				items[i].timeout != items[i + 1].timeout ||
-				items[i].allow_redirect != items[i + 1].allow_redirect)
+		if (0 != i && SUCCEED == icmpping_items_batchable(&items[i], &items[i - 1]))
 		{
-			zbx_setproctitle("%s #%d [pinging hosts]", get_process_type_string(process_type), process_num);
+			batch = &batches[batches_num - 1];
 
-			zbx_timespec(&ts);
+			if (0 == strcmp(items[i].addr, items[i - 1].addr))
+				continue;
+		}
+		else
+		{
+			batch_index[batches_num] = i;
+			batch = &batches[batches_num++];
+
+			memset(batch, 0, sizeof(zbx_fping_batch_t));
+			batch->requests_count = items[i].count;
+			batch->period = items[i].interval;
+			batch->size = items[i].size;
+			batch->timeout = items[i].timeout;
+			batch->allow_redirect = items[i].allow_redirect;
+			batch->hosts = &hosts[hosts_num];
+		}
 
-			ping_result = zbx_ping(hosts, hosts_count,
-						items[i].count, items[i].interval, items[i].size, items[i].timeout,
-						items[i].allow_redirect, 0, error, sizeof(error));
+		memset(&batch->hosts[batch->hosts_count], 0, sizeof(zbx_fping_host_t));
+		batch->hosts[batch->hosts_count++].addr = items[i].addr;
+		hosts_num++;
+	}
 
-			if (FAIL != ping_result)
-				process_values(items, first_index, i + 1, hosts, hosts_count, &ts, ping_result, error);
+	batch_index[batches_num] = items_count;
 
-			hosts_count = 0;
-			first_index = i + 1;
-		}
+	zbx_setproctitle("%s #%d [pinging hosts]", get_process_type_string(process_type), process_num);
+
+	zbx_timespec(&ts);
+
+	zbx_ping_batches(batches, batches_num);
+
+	for (int i = 0; i < batches_num; i++)
+	{
+		if (FAIL != batches[i].ret && ZBX_IS_RUNNING())
+			process_values(items, batch_index[i], batch_index[i + 1], &batches[i], &ts);
+
+		zbx_free(batches[i].error);
 	}
 
+	zbx_free(hosts);
+	zbx_free(batch_index);
+	zbx_free(batches);
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
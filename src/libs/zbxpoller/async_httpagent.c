@@ -29,7 +29,7 @@ void	zbx_async_check_httpagent_clean(zbx_httpagent_context *httpagent_context)
 
 int	zbx_async_check_httpagent(zbx_dc_item_t *item, AGENT_RESULT *result, const char *config_source_ip,
 		const char *config_ssl_ca_location, const char *config_ssl_cert_location,
-		const char *config_ssl_key_location, CURLM *curl_handle)
+		const char *config_ssl_key_location, CURLM *curl_handle, CURLSH *curl_share)
 {
 	char			*error = NULL;
 	zbx_httpagent_context	*httpagent_context = zbx_malloc(NULL, sizeof(zbx_httpagent_context));
@@ -70,6 +70,26 @@ int	zbx_async_check_httpagent(zbx_dc_item_t *item, AGENT_RESULT *result, const c
 		goto fail;
 	}
 
+	if (NULL != curl_share && CURLE_OK != (err = curl_easy_setopt(httpagent_context->http_context.easyhandle,
+			CURLOPT_SHARE, curl_share)))
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set share handle: %s", curl_easy_strerror(err)));
+
+		goto fail;
+	}
+
+/* waiting for multiplexed connection was added in 7.43.0 (0x072b00) */
+#if LIBCURL_VERSION_NUM >= 0x072b00
+	/* prefer waiting for connection to the same origin that can be multiplexed over opening a new one */
+	if (CURLE_OK != (err = curl_easy_setopt(httpagent_context->http_context.easyhandle, CURLOPT_PIPEWAIT, 1L)))
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set pipe wait option: %s",
+				curl_easy_strerror(err)));
+
+		goto fail;
+	}
+#endif
+
 	if (CURLM_OK != (merr = curl_multi_add_handle(curl_handle, httpagent_context->http_context.easyhandle)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot add a standard curl handle to the multi stack: %s",
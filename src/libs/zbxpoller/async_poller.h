@@ -47,6 +47,7 @@ typedef struct
 	zbx_hashset_t		interfaces;
 #ifdef HAVE_LIBCURL
 	CURLM			*curl_handle;
+	CURLSH			*curl_share;
 #endif
 }
 zbx_poller_config_t;
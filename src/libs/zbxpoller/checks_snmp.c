@@ -13,6 +13,7 @@
 **/
 
 #include "checks_snmp.h"
+#include "snmp_index_cache.h"
 
 #ifdef HAVE_NETSNMP
 
@@ -58,6 +59,10 @@
  * Zabbix revalidates each index before using it to get a value and rebuilds the index cache for the OID if the
  * index is invalid.
  *
+ * When SNMPIndexCacheSize is set the index tables are shared between poller processes in shared memory (see
+ * snmp_index_cache.c). The process local cache is then used only to collect the table while it is walked, the
+ * complete table replaces the shared one after the walk and the local copy is discarded.
+ *
  * Example
  * -------
  *
@@ -85,15 +90,16 @@
 
 /******************************************************************************
  *                                                                            *
- * This is zbx_snmp_walk() callback function prototype.                       *
+ * This is OID walk callback function prototype.                              *
  *                                                                            *
- * Parameters: arg      - [IN] user argument passed to zbx_snmp_walk()        *
+ * Parameters: arg      - [IN] user argument passed with walked OID           *
+ *             num      - [IN] position of walked OID in SNMP OID parameters  *
  *             snmp_oid - [IN] OID walk function is looking for               *
  *             index    - [IN] index of found OID                             *
  *             value    - [IN] OID value                                      *
  *                                                                            *
  ******************************************************************************/
-typedef void (zbx_snmp_walk_cb_func)(void *arg, const char *snmp_oid, const char *index, const char *value);
+typedef void (zbx_snmp_walk_cb_func)(void *arg, int num, const char *snmp_oid, const char *index, const char *value);
 
 typedef enum
 {
@@ -143,15 +149,79 @@ typedef struct
 	size_t			name_length;
 	int			running;
 	int			vars_num;
+	int			num;			/* position of OID in SNMP OID parameters */
+	int			max_repetitions;
+	int			max_repetitions_fail;	/* lowest number of repetitions that was too big */
+	int			check_oid_increase;
+	zbx_hashset_t		oids_seen;
+	char			*root_oid;		/* numeric root OID used to choose index */
+	size_t			root_string_len;
+	size_t			root_numeric_len;
+	char			*results;
+	size_t			results_alloc;
+	size_t			results_offset;
 	void			*arg;
 	char			*error;
-	netsnmp_large_fd_set	fdset;
 }
 zbx_bulkwalk_context_t;
 
 ZBX_PTR_VECTOR_DECL(bulkwalk_context, zbx_bulkwalk_context_t*)
 ZBX_PTR_VECTOR_IMPL(bulkwalk_context, zbx_bulkwalk_context_t*)
 
+/* discovered SNMP object, identified by its index */
+typedef struct
+{
+	/* object index returned by OID walk */
+	char	*index;
+
+	/* an array of OID values stored in the same order as defined in OID key */
+	char	**values;
+}
+zbx_snmp_dobject_t;
+
+ZBX_PTR_VECTOR_DECL(snmp_dobject_ptr, zbx_snmp_dobject_t*)
+ZBX_PTR_VECTOR_IMPL(snmp_dobject_ptr, zbx_snmp_dobject_t*)
+
+/* helper data structure used by snmp discovery */
+typedef struct
+{
+	/* discovered SNMP objects */
+	zbx_hashset_t		objects;
+
+	/* index (order) of discovered SNMP objects */
+	zbx_vector_snmp_dobject_ptr_t	index;
+
+	/* request data structure used to parse discovery OID key */
+	AGENT_REQUEST		request;
+}
+zbx_snmp_ddata_t;
+
+#define ZBX_SNMP_DYNAMIC_VERIFY	0
+#define ZBX_SNMP_DYNAMIC_WALK	1
+#define ZBX_SNMP_DYNAMIC_GET	2
+
+/* helper data structure used to get value of OID with dynamic index */
+typedef struct
+{
+	/* translated OID to get value from once index is known */
+	char	value_oid[ZBX_ITEM_SNMP_OID_LEN_MAX];
+
+	/* OID of table which contains indexes, as configured and translated */
+	char	index_oid[ZBX_ITEM_SNMP_OID_LEN_MAX];
+	char	index_oid_translated[ZBX_ITEM_SNMP_OID_LEN_MAX];
+
+	/* value for which to look up index */
+	char	index_value[ZBX_ITEM_SNMP_OID_LEN_MAX];
+
+	char	*index;
+	size_t	index_alloc;
+	int	index_valid;
+
+	/* ZBX_SNMP_DYNAMIC_* step being processed */
+	int	step;
+}
+zbx_snmp_dynamic_t;
+
 struct zbx_snmp_context
 {
 	void				*arg;
@@ -159,12 +229,11 @@ struct zbx_snmp_context
 	zbx_dc_item_context_t		item;
 	zbx_snmp_sess_t			ssp;
 	int				snmp_max_repetitions;
-	char				*results;
-	size_t				results_alloc;
-	size_t				results_offset;
 	zbx_vector_snmp_oid_t		param_oids;
 	zbx_vector_bulkwalk_context_t	bulkwalk_contexts;
-	int				i;
+	netsnmp_large_fd_set		fdset;
+	zbx_snmp_ddata_t		*ddata;
+	zbx_snmp_dynamic_t		*dynamic;
 	int				config_timeout;
 	int				probe;
 	unsigned char			snmp_version;
@@ -200,8 +269,10 @@ static char				snmp_rwlock_init_done;
 static zbx_hashset_t	engineid_cache;
 static int		engineid_cache_initialized = 0;
 
-#define ZBX_SNMP_GET	0
-#define ZBX_SNMP_WALK	1
+#define ZBX_SNMP_GET		0
+#define ZBX_SNMP_WALK		1
+#define ZBX_SNMP_DISCOVERY	2
+#define ZBX_SNMP_DYNAMIC	3
 
 #define	SNMP_MT_EXECLOCK					\
 	if (0 != snmp_rwlock_init_done)				\
@@ -494,21 +565,21 @@ static void	vector_snmp_oid_free(zbx_snmp_oid_t *ptr)
 	zbx_free(ptr);
 }
 
-static char	*get_item_community_context(const zbx_dc_item_t *item)
+static char	*get_context_community_context(const zbx_snmp_context_t *snmp_context)
 {
-	if (ZBX_IF_SNMP_VERSION_1 == item->snmp_version || ZBX_IF_SNMP_VERSION_2 == item->snmp_version)
-		return item->snmp_community;
-	else if (ZBX_IF_SNMP_VERSION_3 == item->snmp_version)
-		return item->snmpv3_contextname;
+	if (ZBX_IF_SNMP_VERSION_1 == snmp_context->snmp_version || ZBX_IF_SNMP_VERSION_2 == snmp_context->snmp_version)
+		return snmp_context->snmp_community;
+	else if (ZBX_IF_SNMP_VERSION_3 == snmp_context->snmp_version)
+		return snmp_context->snmpv3_contextname;
 
 	THIS_SHOULD_NEVER_HAPPEN;
 	exit(EXIT_FAILURE);
 }
 
-static char	*get_item_security_name(const zbx_dc_item_t *item)
+static char	*get_context_security_name(const zbx_snmp_context_t *snmp_context)
 {
-	if (ZBX_IF_SNMP_VERSION_3 == item->snmp_version)
-		return item->snmpv3_securityname;
+	if (ZBX_IF_SNMP_VERSION_3 == snmp_context->snmp_version)
+		return snmp_context->snmpv3_securityname;
 
 	return "";
 }
@@ -517,14 +588,14 @@ static char	*get_item_security_name(const zbx_dc_item_t *item)
  *                                                                            *
  * Purpose: retrieves index that matches value from relevant index cache      *
  *                                                                            *
- * Parameters: item      - [IN] Configuration of Zabbix item, contains        *
- *                              IP address, port, community string, context,  *
- *                              security name.                                *
- *             snmp_oid  - [IN] OID of table which contains indexes           *
- *             value     - [IN] value for which to look up index              *
- *             idx       - [IN/OUT] destination pointer for                   *
- *                                  heap-(re)allocated index                  *
- *             idx_alloc - [IN/OUT] size of (re)allocated index               *
+ * Parameters: snmp_context - [IN] SNMP check context, contains IP address,   *
+ *                                 port, community string, context, security  *
+ *                                 name.                                      *
+ *             snmp_oid     - [IN] OID of table which contains indexes        *
+ *             value        - [IN] value for which to look up index           *
+ *             idx          - [IN/OUT] destination pointer for                *
+ *                                     heap-(re)allocated index               *
+ *             idx_alloc    - [IN/OUT] size of (re)allocated index            *
  *                                                                            *
  * Return value: FAIL    - dynamic index cache is empty or cache does not     *
  *                         contain index matching value                       *
@@ -533,8 +604,8 @@ static char	*get_item_security_name(const zbx_dc_item_t *item)
  *                         heap-(re)allocated idx                             *
  *                                                                            *
  ******************************************************************************/
-static int	cache_get_snmp_index(const zbx_dc_item_t *item, const char *snmp_oid, const char *value, char **idx,
-		size_t *idx_alloc)
+static int	cache_get_snmp_index(const zbx_snmp_context_t *snmp_context, const char *snmp_oid, const char *value,
+		char **idx, size_t *idx_alloc)
 {
 	int			ret = FAIL;
 	zbx_snmpidx_main_key_t	*main_key, main_key_local;
@@ -546,12 +617,12 @@ static int	cache_get_snmp_index(const zbx_dc_item_t *item, const char *snmp_oid,
 	if (NULL == snmpidx.slots)
 		goto end;
 
-	main_key_local.addr = item->interface.addr;
-	main_key_local.port = item->interface.port;
+	main_key_local.addr = snmp_context->item.interface.addr;
+	main_key_local.port = snmp_context->item.interface.port;
 	main_key_local.oid = (char *)snmp_oid;
 
-	main_key_local.community_context = get_item_community_context(item);
-	main_key_local.security_name = get_item_security_name(item);
+	main_key_local.community_context = get_context_community_context(snmp_context);
+	main_key_local.security_name = get_context_security_name(snmp_context);
 
 	if (NULL == (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(&snmpidx, &main_key_local)))
 		goto end;
@@ -572,15 +643,15 @@ end:
  *                                                                            *
  * Purpose: stores index-value pair in relevant index cache                   *
  *                                                                            *
- * Parameters: item      - [IN] Configuration of Zabbix item, contains        *
- *                              IP address, port, community string, context,  *
- *                              security name.                                *
- *             snmp_oid  - [IN] OID of table which contains indexes           *
- *             index     - [IN] index part of index-value pair                *
- *             value     - [IN] value part of index-value pair                *
+ * Parameters: snmp_context - [IN] SNMP check context, contains IP address,   *
+ *                                 port, community string, context, security  *
+ *                                 name.                                      *
+ *             snmp_oid     - [IN] OID of table which contains indexes        *
+ *             index        - [IN] index part of index-value pair             *
+ *             value        - [IN] value part of index-value pair             *
  *                                                                            *
  ******************************************************************************/
-static void	cache_put_snmp_index(const zbx_dc_item_t *item, const char *snmp_oid, const char *index,
+static void	cache_put_snmp_index(const zbx_snmp_context_t *snmp_context, const char *snmp_oid, const char *index,
 		const char *value)
 {
 	zbx_snmpidx_main_key_t	*main_key, main_key_local;
@@ -595,20 +666,20 @@ static void	cache_put_snmp_index(const zbx_dc_item_t *item, const char *snmp_oid
 				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
 	}
 
-	main_key_local.addr = item->interface.addr;
-	main_key_local.port = item->interface.port;
+	main_key_local.addr = snmp_context->item.interface.addr;
+	main_key_local.port = snmp_context->item.interface.port;
 	main_key_local.oid = (char *)snmp_oid;
 
-	main_key_local.community_context = get_item_community_context(item);
-	main_key_local.security_name = get_item_security_name(item);
+	main_key_local.community_context = get_context_community_context(snmp_context);
+	main_key_local.security_name = get_context_security_name(snmp_context);
 
 	if (NULL == (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(&snmpidx, &main_key_local)))
 	{
-		main_key_local.addr = zbx_strdup(NULL, item->interface.addr);
+		main_key_local.addr = zbx_strdup(NULL, snmp_context->item.interface.addr);
 		main_key_local.oid = zbx_strdup(NULL, snmp_oid);
 
-		main_key_local.community_context = zbx_strdup(NULL, get_item_community_context(item));
-		main_key_local.security_name = zbx_strdup(NULL, get_item_security_name(item));
+		main_key_local.community_context = zbx_strdup(NULL, get_context_community_context(snmp_context));
+		main_key_local.security_name = zbx_strdup(NULL, get_context_security_name(snmp_context));
 
 		main_key_local.mappings = (zbx_hashset_t *)zbx_malloc(NULL, sizeof(zbx_hashset_t));
 		zbx_hashset_create_ext(main_key_local.mappings, 100,
@@ -639,16 +710,16 @@ static void	cache_put_snmp_index(const zbx_dc_item_t *item, const char *snmp_oid
  *                                                                            *
  * Purpose: deletes index-value mappings from specified index cache           *
  *                                                                            *
- * Parameters: item      - [IN] Configuration of Zabbix item, contains        *
- *                              IP address, port, community string, context,  *
- *                              security name.                                *
- *             snmp_oid  - [IN] OID of table which contains indexes           *
+ * Parameters: snmp_context - [IN] SNMP check context, contains IP address,   *
+ *                                 port, community string, context, security  *
+ *                                 name.                                      *
+ *             snmp_oid     - [IN] OID of table which contains indexes        *
  *                                                                            *
  * Comments: Does nothing if the index cache is empty or if it does not       *
  *           contain the cache for the specified OID.                         *
  *                                                                            *
  ******************************************************************************/
-static void	cache_del_snmp_index_subtree(const zbx_dc_item_t *item, const char *snmp_oid)
+static void	cache_del_snmp_index_subtree(const zbx_snmp_context_t *snmp_context, const char *snmp_oid)
 {
 	zbx_snmpidx_main_key_t	*main_key, main_key_local;
 
@@ -657,12 +728,12 @@ static void	cache_del_snmp_index_subtree(const zbx_dc_item_t *item, const char *
 	if (NULL == snmpidx.slots)
 		goto end;
 
-	main_key_local.addr = item->interface.addr;
-	main_key_local.port = item->interface.port;
+	main_key_local.addr = snmp_context->item.interface.addr;
+	main_key_local.port = snmp_context->item.interface.port;
 	main_key_local.oid = (char *)snmp_oid;
 
-	main_key_local.community_context = get_item_community_context(item);
-	main_key_local.security_name = get_item_security_name(item);
+	main_key_local.community_context = get_context_community_context(snmp_context);
+	main_key_local.security_name = get_context_security_name(snmp_context);
 
 	if (NULL == (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(&snmpidx, &main_key_local)))
 		goto end;
@@ -672,6 +743,97 @@ end:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+static void	snmp_index_key_init(zbx_snmp_index_key_t *key, const zbx_snmp_context_t *snmp_context,
+		const char *snmp_oid)
+{
+	key->addr = snmp_context->item.interface.addr;
+	key->port = snmp_context->item.interface.port;
+	key->community_context = get_context_community_context(snmp_context);
+	key->security_name = get_context_security_name(snmp_context);
+	key->oid = snmp_oid;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves index that matches value from shared index cache if it  *
+ *          is enabled or from process local index cache otherwise            *
+ *                                                                            *
+ * Parameters: snmp_context - [IN] SNMP check context                         *
+ *             snmp_oid     - [IN] OID of table which contains indexes        *
+ *             value        - [IN] value for which to look up index           *
+ *             idx          - [IN/OUT] destination pointer for                *
+ *                                     heap-(re)allocated index               *
+ *             idx_alloc    - [IN/OUT] size of (re)allocated index            *
+ *                                                                            *
+ * Return value: SUCCEED - idx contains found index                           *
+ *               FAIL    - index matching value is not cached                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_index_get(const zbx_snmp_context_t *snmp_context, const char *snmp_oid, const char *value,
+		char **idx, size_t *idx_alloc)
+{
+	zbx_snmp_index_key_t	key;
+
+	if (SUCCEED != zbx_snmp_index_cache_enabled())
+		return cache_get_snmp_index(snmp_context, snmp_oid, value, idx, idx_alloc);
+
+	snmp_index_key_init(&key, snmp_context, snmp_oid);
+
+	return zbx_snmp_index_cache_get(&key, value, idx, idx_alloc);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves index table collected in process local index cache during   *
+ *          walk to shared index cache                                        *
+ *                                                                            *
+ * Parameters: snmp_context - [IN] SNMP check context                         *
+ *             snmp_oid     - [IN] OID of table which contains indexes        *
+ *                                                                            *
+ * Comments: Does nothing if shared index cache is disabled.                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_index_publish(const zbx_snmp_context_t *snmp_context, const char *snmp_oid)
+{
+	zbx_snmpidx_main_key_t	*main_key, main_key_local;
+	zbx_snmpidx_mapping_t	*mapping;
+	zbx_snmp_index_key_t	key;
+	zbx_vector_ptr_pair_t	mappings;
+	zbx_hashset_iter_t	iter;
+
+	if (SUCCEED != zbx_snmp_index_cache_enabled())
+		return;
+
+	zbx_vector_ptr_pair_create(&mappings);
+
+	main_key_local.addr = snmp_context->item.interface.addr;
+	main_key_local.port = snmp_context->item.interface.port;
+	main_key_local.oid = (char *)snmp_oid;
+	main_key_local.community_context = get_context_community_context(snmp_context);
+	main_key_local.security_name = get_context_security_name(snmp_context);
+
+	if (NULL != snmpidx.slots && NULL != (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(&snmpidx,
+			&main_key_local)))
+	{
+		zbx_vector_ptr_pair_reserve(&mappings, (size_t)main_key->mappings->num_data);
+		zbx_hashset_iter_reset(main_key->mappings, &iter);
+
+		while (NULL != (mapping = (zbx_snmpidx_mapping_t *)zbx_hashset_iter_next(&iter)))
+		{
+			zbx_ptr_pair_t	pair = {mapping->value, mapping->index};
+
+			zbx_vector_ptr_pair_append(&mappings, pair);
+		}
+	}
+
+	snmp_index_key_init(&key, snmp_context, snmp_oid);
+	zbx_snmp_index_cache_set(&key, &mappings);
+
+	zbx_vector_ptr_pair_destroy(&mappings);
+
+	cache_del_snmp_index_subtree(snmp_context, snmp_oid);
+}
+
 static int	zbx_snmpv3_set_auth_protocol(unsigned char snmpv3_authprotocol, struct snmp_session *session)
 {
 /* item snmpv3 authentication protocol */
@@ -1406,291 +1568,6 @@ static int	zbx_oid_is_new(zbx_hashset_t *hs, size_t root_len, const oid *p_oid,
 #undef ZBX_OIDS_MAX_NUM
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: retrieves information by walking OID tree                         *
- *                                                                            *
- * Parameters: ssp           - [IN] SNMP session handle                       *
- *             item          - [IN] configuration of Zabbix item              *
- *             snmp_oid      - [IN] OID of table with values of interest      *
- *             error         - [OUT] buffer to store error message            *
- *             max_error_len - [IN] maximum error message length              *
- *             max_succeed   - [OUT] value of "max_repetitions" that succeeded*
- *             min_fail      - [OUT] value of "max_repetitions" that failed   *
- *             max_vars      - [IN] suggested value of "max_repetitions"      *
- *             bulk          - [IN] whether GetBulkRequest-PDU should be used *
- *             walk_cb_func  - [IN] callback function to process discovered   *
- *                                  OIDs and their values                     *
- *             walk_cb_arg   - [IN] argument to pass to callback function     *
- *                                                                            *
- * Return value: NOTSUPPORTED - OID does not exist, any other critical error  *
- *               NETWORK_ERROR - recoverable network error                    *
- *               CONFIG_ERROR - item configuration error                      *
- *               SUCCEED - if function successfully completed                 *
- *                                                                            *
- ******************************************************************************/
-static int	zbx_snmp_walk(zbx_snmp_sess_t ssp, const zbx_dc_item_t *item, const char *snmp_oid, char *error,
-		size_t max_error_len, int *max_succeed, int *min_fail, int max_vars, int bulk,
-		zbx_snmp_walk_cb_func walk_cb_func, void *walk_cb_arg)
-{
-	struct snmp_pdu		*pdu, *response;
-	oid			anOID[MAX_OID_LEN], rootOID[MAX_OID_LEN];
-	size_t			anOID_len = MAX_OID_LEN, rootOID_len = MAX_OID_LEN, root_string_len, root_numeric_len;
-	char			oid_index[MAX_STRING_LEN], root_oid[MAX_STRING_LEN];
-	struct variable_list	*var;
-	int			status, level, running, num_vars, check_oid_increase = 1, ret = SUCCEED;
-	AGENT_RESULT		snmp_result;
-	zbx_hashset_t		oids_seen;
-	struct snmp_session	*ss;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() type:%d OID:'%s' bulk:%d", __func__, (int)item->type, snmp_oid, bulk);
-
-	if (ZBX_IF_SNMP_VERSION_1 == item->snmp_version)	/* GetBulkRequest-PDU available since SNMPv2 */
-		bulk = SNMP_BULK_DISABLED;
-
-	/* create OID from string */
-	if (NULL == snmp_parse_oid(snmp_oid, rootOID, &rootOID_len))
-	{
-		zbx_snprintf(error, max_error_len, "snmp_parse_oid(): cannot parse OID \"%s\".", snmp_oid);
-		ret = CONFIG_ERROR;
-		goto out;
-	}
-
-	if (-1 == zbx_snmp_print_oid(oid_index, sizeof(oid_index), rootOID, rootOID_len, ZBX_OID_INDEX_STRING))
-	{
-		zbx_snprintf(error, max_error_len, "zbx_snmp_print_oid(): cannot print OID \"%s\" with string indices.",
-				snmp_oid);
-		ret = CONFIG_ERROR;
-		goto out;
-	}
-
-	root_string_len = strlen(oid_index);
-
-	if (-1 == zbx_snmp_print_oid(oid_index, sizeof(oid_index), rootOID, rootOID_len, ZBX_OID_INDEX_NUMERIC))
-	{
-		zbx_snprintf(error, max_error_len, "zbx_snmp_print_oid(): cannot print OID \"%s\""
-				" with numeric indices.", snmp_oid);
-		ret = CONFIG_ERROR;
-		goto out;
-	}
-
-	root_numeric_len = strlen(oid_index);
-
-	zbx_strlcpy(root_oid, oid_index, sizeof(root_oid));
-
-	/* copy rootOID to anOID */
-	memcpy(anOID, rootOID, rootOID_len * sizeof(oid));
-	anOID_len = rootOID_len;
-
-	/* initialize variables */
-	level = 0;
-	running = 1;
-
-	while (1 == running)
-	{
-		/* create PDU */
-		if (NULL == (pdu = snmp_pdu_create(SNMP_BULK_ENABLED == bulk ? SNMP_MSG_GETBULK : SNMP_MSG_GETNEXT)))
-		{
-			zbx_strlcpy(error, "snmp_pdu_create(): cannot create PDU object.", max_error_len);
-			ret = CONFIG_ERROR;
-			break;
-		}
-
-		if (NULL == snmp_add_null_var(pdu, anOID, anOID_len))	/* add OID as variable to PDU */
-		{
-			zbx_strlcpy(error, "snmp_add_null_var(): cannot add null variable.", max_error_len);
-			ret = CONFIG_ERROR;
-			snmp_free_pdu(pdu);
-			break;
-		}
-
-		if (SNMP_BULK_ENABLED == bulk)
-		{
-			pdu->non_repeaters = 0;
-			pdu->max_repetitions = max_vars;
-		}
-
-		ss = snmp_sess_session(ssp);
-		ss->retries = (0 == bulk || (1 == max_vars && 0 == level) ? 1 : 0);
-
-		/* communicate with agent */
-		status = snmp_sess_synch_response(ssp, pdu, &response);
-
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() snmp_sess_synch_response() status:%d s_snmp_errno:%d errstat:%ld"
-				" max_vars:%d", __func__, status, ss->s_snmp_errno,
-				NULL == response ? (long)-1 : response->errstat, max_vars);
-
-		if (1 < max_vars &&
-			((STAT_SUCCESS == status && SNMP_ERR_TOOBIG == response->errstat) || STAT_TIMEOUT == status))
-		{
-			/* The logic of iteratively reducing request size here is the same as in function */
-			/* zbx_snmp_get_values(). Please refer to the description there for explanation.  */
-reduce_max_vars:
-			if (*min_fail > max_vars)
-				*min_fail = max_vars;
-
-			if (0 == level)
-			{
-				max_vars /= 2;
-			}
-			else if (1 == level)
-			{
-				max_vars = 1;
-			}
-
-			level++;
-
-			goto next;
-		}
-		else if (STAT_SUCCESS != status || SNMP_ERR_NOERROR != response->errstat)
-		{
-			if (1 >= level && 1 < max_vars)
-				goto reduce_max_vars;
-
-			ret = zbx_get_snmp_response_error(ssp, &item->interface, status, response, error,
-					max_error_len);
-			running = 0;
-			goto next;
-		}
-
-		if (NULL == response->variables)
-		{
-			if (1 >= level && 1 < max_vars)
-				goto reduce_max_vars;
-
-			zbx_strlcpy(error, "No values received.", max_error_len);
-			ret = NOTSUPPORTED;
-			running = 0;
-			goto next;
-		}
-
-		/* process response */
-		for (num_vars = 0, var = response->variables; NULL != var; num_vars++, var = var->next_variable)
-		{
-			char		**str_res;
-			unsigned char	val_type;
-
-			/* verify if we are in the same subtree */
-			if (SNMP_ENDOFMIBVIEW == var->type || var->name_length < rootOID_len ||
-					0 != memcmp(rootOID, var->name, rootOID_len * sizeof(oid)))
-			{
-				/* reached the end or past this subtree */
-				running = 0;
-				break;
-			}
-			else if (SNMP_NOSUCHOBJECT != var->type && SNMP_NOSUCHINSTANCE != var->type)
-			{
-				/* not an exception value */
-
-				if (1 == check_oid_increase)	/* typical case */
-				{
-					int	res;
-
-					/* normally devices return OIDs in increasing order, */
-					/* snmp_oid_compare() will return -1 in this case */
-
-					if (-1 != (res = snmp_oid_compare(anOID, anOID_len, var->name,
-							var->name_length)))
-					{
-						if (0 == res)	/* got the same OID */
-						{
-							zbx_strlcpy(error, "OID not changing.", max_error_len);
-							ret = NOTSUPPORTED;
-							running = 0;
-							break;
-						}
-						else	/* 1 == res */
-						{
-							/* OID decreased. Disable further checks of increasing */
-							/* and set up a protection against endless looping. */
-
-							check_oid_increase = 0;
-							zbx_detect_loop_init(&oids_seen);
-						}
-					}
-				}
-
-				if (0 == check_oid_increase && FAIL == zbx_oid_is_new(&oids_seen, rootOID_len,
-						var->name, var->name_length))
-				{
-					zbx_strlcpy(error, "OID loop detected or too many OIDs.", max_error_len);
-					ret = NOTSUPPORTED;
-					running = 0;
-					break;
-				}
-
-				if (SUCCEED != zbx_snmp_choose_index(oid_index, sizeof(oid_index), var->name,
-						var->name_length, root_string_len, root_numeric_len, root_oid))
-				{
-					zbx_snprintf(error, max_error_len, "zbx_snmp_choose_index():"
-							" cannot choose appropriate index while walking for"
-							" OID \"%s\".", snmp_oid);
-					ret = NOTSUPPORTED;
-					running = 0;
-					break;
-				}
-
-				str_res = NULL;
-				zbx_init_agent_result(&snmp_result);
-
-				if (SUCCEED == zbx_snmp_set_result(var, &snmp_result, &val_type, ZBX_ASN_OCTET_STR_HEX))
-				{
-					if (ZBX_ISSET_TEXT(&snmp_result) && ZBX_SNMP_STR_HEX == val_type)
-						zbx_remove_chars(snmp_result.text, "\r\n");
-
-					str_res = ZBX_GET_STR_RESULT(&snmp_result);
-				}
-
-				if (NULL == str_res)
-				{
-					char	**msg;
-
-					msg = ZBX_GET_MSG_RESULT(&snmp_result);
-
-					zabbix_log(LOG_LEVEL_DEBUG, "cannot get index '%s' string value: %s",
-							oid_index, NULL != msg && NULL != *msg ? *msg : "(null)");
-				}
-				else
-					walk_cb_func(walk_cb_arg, snmp_oid, oid_index, snmp_result.str);
-
-				zbx_free_agent_result(&snmp_result);
-
-				/* go to next variable */
-				memcpy((char *)anOID, (char *)var->name, var->name_length * sizeof(oid));
-				anOID_len = var->name_length;
-			}
-			else
-			{
-				/* an exception value, so stop */
-				char	*errmsg;
-
-				errmsg = zbx_get_snmp_type_error(var->type);
-				zbx_strlcpy(error, errmsg, max_error_len);
-				zbx_free(errmsg);
-				ret = NOTSUPPORTED;
-				running = 0;
-				break;
-			}
-		}
-
-		if (*max_succeed < num_vars)
-			*max_succeed = num_vars;
-next:
-		if (NULL != response)
-			snmp_free_pdu(response);
-	}
-
-	if (0 == check_oid_increase)
-		zbx_hashset_destroy(&oids_seen);
-out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
-}
-
-#undef ZBX_OID_INDEX_STRING
-#undef ZBX_OID_INDEX_NUMERIC
-
 static int	zbx_snmp_get_values(zbx_snmp_sess_t ssp, const zbx_dc_item_t *items,
 		char oids[][ZBX_ITEM_SNMP_OID_LEN_MAX], AGENT_RESULT *results, int *errcodes,
 		unsigned char *query_and_ignore_type, int num, int level, char *error, size_t max_error_len,
@@ -2031,37 +1908,6 @@ static void	zbx_snmp_translate(char *oid_translated, const char *snmp_oid, size_
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() oid_translated:'%s'", __func__, oid_translated);
 }
 
-/* discovered SNMP object, identified by its index */
-typedef struct
-{
-	/* object index returned by zbx_snmp_walk */
-	char	*index;
-
-	/* an array of OID values stored in the same order as defined in OID key */
-	char	**values;
-}
-zbx_snmp_dobject_t;
-
-ZBX_PTR_VECTOR_DECL(snmp_dobject_ptr, zbx_snmp_dobject_t*)
-ZBX_PTR_VECTOR_IMPL(snmp_dobject_ptr, zbx_snmp_dobject_t*)
-
-/* helper data structure used by snmp discovery */
-typedef struct
-{
-	/* index of OID being currently processed (walked) */
-	int			num;
-
-	/* discovered SNMP objects */
-	zbx_hashset_t		objects;
-
-	/* index (order) of discovered SNMP objects */
-	zbx_vector_snmp_dobject_ptr_t	index;
-
-	/* request data structure used to parse discovery OID key */
-	AGENT_REQUEST		request;
-}
-zbx_snmp_ddata_t;
-
 /* discovery objects hashset support */
 static zbx_hash_t	zbx_snmp_dobject_hash(const void *data)
 {
@@ -2177,7 +2023,8 @@ static void	zbx_snmp_ddata_clean(zbx_snmp_ddata_t *data)
 	zbx_free_agent_request(&data->request);
 }
 
-static void	zbx_snmp_walk_discovery_cb(void *arg, const char *snmp_oid, const char *index, const char *value)
+static void	zbx_snmp_walk_discovery_cb(void *arg, int num, const char *snmp_oid, const char *index,
+		const char *value)
 {
 	zbx_snmp_ddata_t	*data = (zbx_snmp_ddata_t *)arg;
 	zbx_snmp_dobject_t	*obj;
@@ -2196,50 +2043,36 @@ static void	zbx_snmp_walk_discovery_cb(void *arg, const char *snmp_oid, const ch
 		zbx_vector_snmp_dobject_ptr_append(&data->index, obj);
 	}
 
-	obj->values[data->num] = zbx_strdup(NULL, value);
+	obj->values[num] = zbx_strdup(obj->values[num], value);
 }
 
-static int	zbx_snmp_process_discovery(zbx_snmp_sess_t ssp, const zbx_dc_item_t *item, AGENT_RESULT *result,
-		int *errcode, char *error, size_t max_error_len, int *max_succeed, int *min_fail, int max_vars,
-		int bulk)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: converts discovered SNMP objects to low-level discovery JSON      *
+ *                                                                            *
+ * Parameters: data   - [IN] snmp discovery data object                       *
+ *             result - [OUT]                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_ddata_set_result(const zbx_snmp_ddata_t *data, AGENT_RESULT *result)
 {
-	int			ret;
-	char			oid_translated[ZBX_ITEM_SNMP_OID_LEN_MAX];
-	struct zbx_json		js;
-	zbx_snmp_ddata_t	data;
-	zbx_snmp_dobject_t	*obj;
+	struct zbx_json	js;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (SUCCEED != (ret = zbx_snmp_ddata_init(&data, item->snmp_oid, error, max_error_len)))
-		goto out;
+	zbx_json_initarray(&js, ZBX_JSON_STAT_BUF_LEN);
 
-	for (data.num = 0; data.num < data.request.nparam / 2; data.num++)
+	for (int i = 0; i < data->index.values_num; i++)
 	{
-		zbx_snmp_translate(oid_translated, data.request.params[data.num * 2 + 1], sizeof(oid_translated));
-
-		if (SUCCEED != (ret = zbx_snmp_walk(ssp, item, oid_translated, error, max_error_len,
-				max_succeed, min_fail, max_vars, bulk, zbx_snmp_walk_discovery_cb, (void *)&data)))
-		{
-			goto clean;
-		}
-	}
-
-	zbx_json_initarray(&js, ZBX_JSON_STAT_BUF_LEN);
-
-	for (int i = 0; i < data.index.values_num; i++)
-	{
-		obj = (zbx_snmp_dobject_t *)data.index.values[i];
+		const zbx_snmp_dobject_t	*obj = data->index.values[i];
 
 		zbx_json_addobject(&js, NULL);
 		zbx_json_addstring(&js, "{#SNMPINDEX}", obj->index, ZBX_JSON_TYPE_STRING);
 
-		for (int j = 0; j < data.request.nparam / 2; j++)
+		for (int j = 0; j < data->request.nparam / 2; j++)
 		{
 			if (NULL == obj->values[j])
 				continue;
 
-			zbx_json_addstring(&js, data.request.params[j * 2], obj->values[j], ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(&js, data->request.params[j * 2], obj->values[j], ZBX_JSON_TYPE_STRING);
 		}
 		zbx_json_close(&js);
 	}
@@ -2249,20 +2082,13 @@ static int	zbx_snmp_process_discovery(zbx_snmp_sess_t ssp, const zbx_dc_item_t *
 	SET_TEXT_RESULT(result, zbx_strdup(NULL, js.buffer));
 
 	zbx_json_free(&js);
-clean:
-	zbx_snmp_ddata_clean(&data);
-out:
-	if (SUCCEED != (*errcode = ret))
-		SET_MSG_RESULT(result, zbx_strdup(NULL, error));
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
 }
 
-static void	zbx_snmp_walk_cache_cb(void *arg, const char *snmp_oid, const char *index, const char *value)
+static void	zbx_snmp_walk_cache_cb(void *arg, int num, const char *snmp_oid, const char *index, const char *value)
 {
-	cache_put_snmp_index((const zbx_dc_item_t *)arg, snmp_oid, index, value);
+	ZBX_UNUSED(num);
+
+	cache_put_snmp_index((const zbx_snmp_context_t *)arg, snmp_oid, index, value);
 }
 
 typedef struct
@@ -2272,9 +2098,12 @@ typedef struct
 	int	numeric_ts;
 	int	oid_format;
 	int	no_print_units;
+	int	dont_breakdown_oids;
 }
 zbx_snmp_format_opts_t;
 
+static ZBX_THREAD_LOCAL zbx_snmp_format_opts_t	default_opts;
+
 static void	snmp_bulkwalk_get_options(zbx_snmp_format_opts_t *opts)
 {
 	opts->numeric_oids = netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_PRINT_NUMERIC_OIDS);
@@ -2282,6 +2111,8 @@ static void	snmp_bulkwalk_get_options(zbx_snmp_format_opts_t *opts)
 	opts->numeric_ts = netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_NUMERIC_TIMETICKS);
 	opts->oid_format = netsnmp_ds_get_int(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_OID_OUTPUT_FORMAT);
 	opts->no_print_units = netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_DONT_PRINT_UNITS);
+	opts->dont_breakdown_oids = netsnmp_ds_get_boolean(NETSNMP_DS_LIBRARY_ID,
+			NETSNMP_DS_LIB_DONT_BREAKDOWN_OIDS);
 }
 
 static void	snmp_bulkwalk_set_options(zbx_snmp_format_opts_t *opts)
@@ -2291,6 +2122,30 @@ static void	snmp_bulkwalk_set_options(zbx_snmp_format_opts_t *opts)
 	netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_NUMERIC_TIMETICKS, opts->numeric_ts);
 	netsnmp_ds_set_int(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_OID_OUTPUT_FORMAT, opts->oid_format);
 	netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_DONT_PRINT_UNITS, opts->no_print_units);
+	netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_DONT_BREAKDOWN_OIDS, opts->dont_breakdown_oids);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: restores default Net-SNMP output format, so that indexes and      *
+ *          values of discovery and dynamic index walks are not affected by   *
+ *          numeric bulkwalk options                                          *
+ *                                                                            *
+ * Parameters: saved_opts - [OUT] current options to be restored by           *
+ *                                snmp_walk_format_end()                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_walk_format_begin(zbx_snmp_format_opts_t *saved_opts)
+{
+	snmp_bulkwalk_get_options(saved_opts);
+
+	if (1 == zbx_snmp_init_bulkwalk_done)
+		snmp_bulkwalk_set_options(&default_opts);
+}
+
+static void	snmp_walk_format_end(zbx_snmp_format_opts_t *saved_opts)
+{
+	snmp_bulkwalk_set_options(saved_opts);
 }
 
 static void	snmp_bulkwalk_remove_matching_oids(zbx_vector_snmp_oid_t *oids)
@@ -2565,16 +2420,79 @@ out:
 #undef TYPE_STR_STRING
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reduces number of repetitions of GetBulkRequest-PDU when the      *
+ *          response did not fit into a single message                        *
+ *                                                                            *
+ * Parameters: status           - [IN] response status                        *
+ *             response         - [IN]                                        *
+ *             bulkwalk_context - [IN/OUT]                                    *
+ *                                                                            *
+ * Return value: SUCCEED - request must be repeated with fewer repetitions    *
+ *               FAIL    - response must be processed as usual                *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_bulkwalk_reduce_repetitions(int status, const struct snmp_pdu *response,
+		zbx_bulkwalk_context_t *bulkwalk_context)
+{
+	if (SNMP_MSG_GETBULK != bulkwalk_context->pdu_type || 1 >= bulkwalk_context->max_repetitions)
+		return FAIL;
+
+	if (STAT_SUCCESS != status || SNMP_ERR_TOOBIG != response->errstat)
+		return FAIL;
+
+	bulkwalk_context->max_repetitions_fail = bulkwalk_context->max_repetitions;
+	bulkwalk_context->max_repetitions /= 2;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() response too big, max repetitions reduced to %d", __func__,
+			bulkwalk_context->max_repetitions);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: increases previously reduced number of repetitions after a full   *
+ *          response, staying below the number that was too big               *
+ *                                                                            *
+ * Parameters: bulkwalk_context - [IN/OUT]                                    *
+ *             vars_num         - [IN] number of variables in the response    *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_bulkwalk_restore_repetitions(zbx_bulkwalk_context_t *bulkwalk_context, int vars_num)
+{
+	int	max_repetitions;
+
+	if (SNMP_MSG_GETBULK != bulkwalk_context->pdu_type || 0 == bulkwalk_context->max_repetitions_fail ||
+			vars_num < bulkwalk_context->max_repetitions)
+	{
+		return;
+	}
+
+	max_repetitions = bulkwalk_context->max_repetitions_fail - 1;
+
+	if (bulkwalk_context->max_repetitions < max_repetitions)
+	{
+		bulkwalk_context->max_repetitions += (max_repetitions - bulkwalk_context->max_repetitions + 1) / 2;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() max repetitions increased to %d", __func__,
+				bulkwalk_context->max_repetitions);
+	}
+}
+
 static int	snmp_bulkwalk_handle_response(int status, struct snmp_pdu *response,
-		zbx_bulkwalk_context_t *bulkwalk_context, char **results, size_t *results_alloc,
-		size_t *results_offset, const zbx_snmp_sess_t ssp, const zbx_dc_interface_t *interface,
+		zbx_bulkwalk_context_t *bulkwalk_context, const zbx_snmp_sess_t ssp, const zbx_dc_interface_t *interface,
 		unsigned char snmp_oid_type, char *error, size_t max_error_len)
 {
 	struct variable_list	*var;
-	int			ret = SUCCEED;
+	int			ret = SUCCEED, vars_num = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	if (SUCCEED == snmp_bulkwalk_reduce_repetitions(status, response, bulkwalk_context))
+		goto out;
+
 	if (STAT_SUCCESS != status || SNMP_ERR_NOERROR != response->errstat)
 	{
 		ret = zbx_get_snmp_response_error(ssp, interface, status, response, error, max_error_len);
@@ -2613,8 +2531,8 @@ static int	snmp_bulkwalk_handle_response(int status, struct snmp_pdu *response,
 
 		if (ZBX_SNMP_GET == snmp_oid_type)
 		{
-			ret = snmp_get_value_from_var(var, results, results_alloc, results_offset, error,
-					max_error_len);
+			ret = snmp_get_value_from_var(var, &bulkwalk_context->results, &bulkwalk_context->results_alloc,
+					&bulkwalk_context->results_offset, error, max_error_len);
 			bulkwalk_context->running = 0;
 			break;
 		}
@@ -2625,6 +2543,7 @@ static int	snmp_bulkwalk_handle_response(int status, struct snmp_pdu *response,
 			char	buffer[MAX_STRING_LEN];
 
 			bulkwalk_context->vars_num++;
+			vars_num++;
 
 			if (SNMP_MSG_GET != bulkwalk_context->pdu_type)
 			{
@@ -2643,10 +2562,14 @@ static int	snmp_bulkwalk_handle_response(int status, struct snmp_pdu *response,
 			if (ASN_OCTET_STR == var->type)
 				snmp_quote_string_value(buffer, sizeof(buffer), var);
 
-			if (NULL != *results)
-				zbx_chrcpy_alloc(results, results_alloc, results_offset, '\n');
+			if (NULL != bulkwalk_context->results)
+			{
+				zbx_chrcpy_alloc(&bulkwalk_context->results, &bulkwalk_context->results_alloc,
+						&bulkwalk_context->results_offset, '\n');
+			}
 
-			zbx_strcpy_alloc(results, results_alloc, results_offset, buffer);
+			zbx_strcpy_alloc(&bulkwalk_context->results, &bulkwalk_context->results_alloc,
+					&bulkwalk_context->results_offset, buffer);
 
 			if (NULL == var->next_variable)
 			{
@@ -2660,6 +2583,312 @@ static int	snmp_bulkwalk_handle_response(int status, struct snmp_pdu *response,
 			break;
 		}
 	}
+
+	if (1 == bulkwalk_context->running)
+		snmp_bulkwalk_restore_repetitions(bulkwalk_context, vars_num);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s running:%d", __func__, zbx_result_string(ret),
+			bulkwalk_context->running);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares root OID strings used to choose index of walked OIDs     *
+ *                                                                            *
+ * Parameters: bulkwalk_context - [IN/OUT]                                    *
+ *             error            - [OUT] buffer to store error message         *
+ *             max_error_len    - [IN] maximum error message length           *
+ *                                                                            *
+ * Return value: SUCCEED - root OID strings were prepared                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_bulkwalk_index_init(zbx_bulkwalk_context_t *bulkwalk_context, char *error, size_t max_error_len)
+{
+	char			buffer[MAX_STRING_LEN];
+	zbx_snmp_oid_t		*p_oid = bulkwalk_context->p_oid;
+	zbx_snmp_format_opts_t	opts;
+	int			ret = FAIL;
+
+	snmp_walk_format_begin(&opts);
+
+	if (-1 == zbx_snmp_print_oid(buffer, sizeof(buffer), p_oid->root_oid, p_oid->root_oid_len,
+			ZBX_OID_INDEX_STRING))
+	{
+		zbx_snprintf(error, max_error_len, "zbx_snmp_print_oid(): cannot print OID \"%s\" with string indices.",
+				p_oid->str_oid);
+		goto out;
+	}
+
+	bulkwalk_context->root_string_len = strlen(buffer);
+
+	if (-1 == zbx_snmp_print_oid(buffer, sizeof(buffer), p_oid->root_oid, p_oid->root_oid_len,
+			ZBX_OID_INDEX_NUMERIC))
+	{
+		zbx_snprintf(error, max_error_len, "zbx_snmp_print_oid(): cannot print OID \"%s\""
+				" with numeric indices.", p_oid->str_oid);
+		goto out;
+	}
+
+	bulkwalk_context->root_numeric_len = strlen(buffer);
+	bulkwalk_context->root_oid = zbx_strdup(bulkwalk_context->root_oid, buffer);
+
+	ret = SUCCEED;
+out:
+	snmp_walk_format_end(&opts);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes value of OID with dynamic index - either the value of   *
+ *          cached index that is being verified or the final item value       *
+ *                                                                            *
+ * Parameters: snmp_context  - [IN/OUT]                                       *
+ *             var           - [IN] received variable                         *
+ *             error         - [OUT] buffer to store error message            *
+ *             max_error_len - [IN] maximum error message length              *
+ *                                                                            *
+ * Return value: SUCCEED      - value was processed successfully              *
+ *               NOTSUPPORTED - item value cannot be converted                *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_dynamic_process_value(zbx_snmp_context_t *snmp_context, const struct variable_list *var,
+		char *error, size_t max_error_len)
+{
+	zbx_snmp_dynamic_t	*dynamic = snmp_context->dynamic;
+	AGENT_RESULT		result;
+	unsigned char		val_type;
+	int			ret;
+
+	zbx_init_agent_result(&result);
+
+	ret = zbx_snmp_set_result(var, &result, &val_type, ZBX_ASN_OCTET_STR_HEX);
+
+	if (ZBX_ISSET_TEXT(&result) && ZBX_SNMP_STR_HEX == val_type)
+		zbx_remove_chars(result.text, "\r\n");
+
+	if (ZBX_SNMP_DYNAMIC_VERIFY == dynamic->step)
+	{
+		char	**str_res;
+
+		if (NULL != (str_res = ZBX_GET_STR_RESULT(&result)) && 0 == strcmp(*str_res, dynamic->index_value))
+			dynamic->index_valid = 1;
+
+		zbx_free_agent_result(&result);
+
+		return SUCCEED;
+	}
+
+	if (SUCCEED != ret)
+	{
+		char	**msg = ZBX_GET_MSG_RESULT(&result);
+
+		zbx_strlcpy(error, NULL != msg && NULL != *msg ? *msg : "Cannot get value.", max_error_len);
+		zbx_free_agent_result(&result);
+
+		return ret;
+	}
+
+	zbx_free_agent_result(&snmp_context->item.result);
+	snmp_context->item.result = result;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes response of discovery or dynamic index lookup request,  *
+ *          passing index and value of each walked OID to callback            *
+ *                                                                            *
+ * Parameters: status           - [IN] response status                        *
+ *             response         - [IN]                                        *
+ *             bulkwalk_context - [IN/OUT]                                    *
+ *             snmp_context     - [IN/OUT]                                    *
+ *             error            - [OUT] buffer to store error message         *
+ *             max_error_len    - [IN] maximum error message length           *
+ *                                                                            *
+ * Return value: SUCCEED - response was processed successfully                *
+ *               NOTSUPPORTED, NETWORK_ERROR, CONFIG_ERROR - otherwise        *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_bulkwalk_handle_index_response(int status, struct snmp_pdu *response,
+		zbx_bulkwalk_context_t *bulkwalk_context, zbx_snmp_context_t *snmp_context, char *error,
+		size_t max_error_len)
+{
+	struct variable_list	*var;
+	zbx_snmp_oid_t		*p_oid = bulkwalk_context->p_oid;
+	zbx_snmp_format_opts_t	opts;
+	zbx_snmp_walk_cb_func	*walk_cb;
+	void			*walk_cb_arg;
+	const char		*snmp_oid;
+	int			ret = SUCCEED, vars_num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (SUCCEED == snmp_bulkwalk_reduce_repetitions(status, response, bulkwalk_context))
+		goto out;
+
+	if (STAT_SUCCESS != status || SNMP_ERR_NOERROR != response->errstat)
+	{
+		ret = zbx_get_snmp_response_error(snmp_context->ssp, &snmp_context->item.interface, status, response,
+				error, max_error_len);
+		bulkwalk_context->running = 0;
+		goto out;
+	}
+
+	snmp_walk_format_begin(&opts);
+
+	if (SNMP_MSG_GET == bulkwalk_context->pdu_type)
+	{
+		bulkwalk_context->running = 0;
+
+		if (NULL != response->variables)
+		{
+			ret = snmp_dynamic_process_value(snmp_context, response->variables, error, max_error_len);
+		}
+		else if (ZBX_SNMP_DYNAMIC_GET == snmp_context->dynamic->step)
+		{
+			zbx_strlcpy(error, "Invalid SNMP response: too few variable bindings.", max_error_len);
+			ret = NOTSUPPORTED;
+		}
+
+		goto restore;
+	}
+
+	if (ZBX_SNMP_DISCOVERY == snmp_context->snmp_oid_type)
+	{
+		walk_cb = zbx_snmp_walk_discovery_cb;
+		walk_cb_arg = snmp_context->ddata;
+		snmp_oid = p_oid->str_oid;
+	}
+	else
+	{
+		walk_cb = zbx_snmp_walk_cache_cb;
+		walk_cb_arg = snmp_context;
+		snmp_oid = snmp_context->dynamic->index_oid_translated;
+	}
+
+	if (NULL == response->variables)
+	{
+		zbx_strlcpy(error, "No values received.", max_error_len);
+		ret = NOTSUPPORTED;
+		bulkwalk_context->running = 0;
+		goto restore;
+	}
+
+	for (var = response->variables; NULL != var; var = var->next_variable, vars_num++)
+	{
+		char		oid_index[MAX_STRING_LEN], **str_res = NULL;
+		unsigned char	val_type;
+		AGENT_RESULT	snmp_result;
+
+		/* verify if we are in the same subtree */
+		if (SNMP_ENDOFMIBVIEW == var->type || var->name_length < p_oid->root_oid_len ||
+				0 != memcmp(p_oid->root_oid, var->name, p_oid->root_oid_len * sizeof(oid)))
+		{
+			/* reached the end or past this subtree */
+			bulkwalk_context->running = 0;
+			break;
+		}
+
+		if (SNMP_NOSUCHOBJECT == var->type || SNMP_NOSUCHINSTANCE == var->type)
+		{
+			/* an exception value, so stop */
+			char	*errmsg;
+
+			errmsg = zbx_get_snmp_type_error(var->type);
+			zbx_strlcpy(error, errmsg, max_error_len);
+			zbx_free(errmsg);
+			ret = NOTSUPPORTED;
+			bulkwalk_context->running = 0;
+			break;
+		}
+
+		if (1 == bulkwalk_context->check_oid_increase)	/* typical case */
+		{
+			int	res;
+
+			/* normally devices return OIDs in increasing order, */
+			/* snmp_oid_compare() will return -1 in this case */
+
+			if (-1 != (res = snmp_oid_compare(bulkwalk_context->name, bulkwalk_context->name_length,
+					var->name, var->name_length)))
+			{
+				if (0 == res)	/* got the same OID */
+				{
+					zbx_strlcpy(error, "OID not changing.", max_error_len);
+					ret = NOTSUPPORTED;
+					bulkwalk_context->running = 0;
+					break;
+				}
+
+				/* OID decreased. Disable further checks of increasing */
+				/* and set up a protection against endless looping. */
+
+				bulkwalk_context->check_oid_increase = 0;
+				zbx_detect_loop_init(&bulkwalk_context->oids_seen);
+			}
+		}
+
+		if (0 == bulkwalk_context->check_oid_increase && FAIL == zbx_oid_is_new(&bulkwalk_context->oids_seen,
+				p_oid->root_oid_len, var->name, var->name_length))
+		{
+			zbx_strlcpy(error, "OID loop detected or too many OIDs.", max_error_len);
+			ret = NOTSUPPORTED;
+			bulkwalk_context->running = 0;
+			break;
+		}
+
+		if (SUCCEED != zbx_snmp_choose_index(oid_index, sizeof(oid_index), var->name, var->name_length,
+				bulkwalk_context->root_string_len, bulkwalk_context->root_numeric_len,
+				bulkwalk_context->root_oid))
+		{
+			zbx_snprintf(error, max_error_len, "zbx_snmp_choose_index(): cannot choose appropriate index"
+					" while walking for OID \"%s\".", p_oid->str_oid);
+			ret = NOTSUPPORTED;
+			bulkwalk_context->running = 0;
+			break;
+		}
+
+		zbx_init_agent_result(&snmp_result);
+
+		if (SUCCEED == zbx_snmp_set_result(var, &snmp_result, &val_type, ZBX_ASN_OCTET_STR_HEX))
+		{
+			if (ZBX_ISSET_TEXT(&snmp_result) && ZBX_SNMP_STR_HEX == val_type)
+				zbx_remove_chars(snmp_result.text, "\r\n");
+
+			str_res = ZBX_GET_STR_RESULT(&snmp_result);
+		}
+
+		if (NULL == str_res)
+		{
+			char	**msg;
+
+			msg = ZBX_GET_MSG_RESULT(&snmp_result);
+
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot get index '%s' string value: %s",
+					oid_index, NULL != msg && NULL != *msg ? *msg : "(null)");
+		}
+		else
+			walk_cb(walk_cb_arg, bulkwalk_context->num, snmp_oid, oid_index, snmp_result.str);
+
+		zbx_free_agent_result(&snmp_result);
+
+		bulkwalk_context->vars_num++;
+
+		/* go to next variable */
+		memcpy(bulkwalk_context->name, var->name, var->name_length * sizeof(oid));
+		bulkwalk_context->name_length = var->name_length;
+	}
+
+	if (1 == bulkwalk_context->running)
+		snmp_bulkwalk_restore_repetitions(bulkwalk_context, vars_num);
+restore:
+	snmp_walk_format_end(&opts);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s running:%d", __func__, zbx_result_string(ret),
 			bulkwalk_context->running);
@@ -2667,6 +2896,9 @@ out:
 	return ret;
 }
 
+#undef ZBX_OID_INDEX_STRING
+#undef ZBX_OID_INDEX_NUMERIC
+
 static int	asynch_response(int operation, struct snmp_session *sp, int reqid, struct snmp_pdu *pdu, void *magic)
 {
 	zbx_bulkwalk_context_t	*bulkwalk_context;
@@ -2721,12 +2953,19 @@ static int	asynch_response(int operation, struct snmp_session *sp, int reqid, st
 	{
 		char	error[MAX_STRING_LEN];
 
-		if (SUCCEED != (ret = snmp_bulkwalk_handle_response(stat, pdu, bulkwalk_context, &snmp_context->results,
-				&snmp_context->results_alloc, &snmp_context->results_offset, snmp_context->ssp,
-				&snmp_context->item.interface, snmp_context->snmp_oid_type, error, sizeof(error))))
+		if (ZBX_SNMP_DISCOVERY == snmp_context->snmp_oid_type || ZBX_SNMP_DYNAMIC == snmp_context->snmp_oid_type)
 		{
-			bulkwalk_context->error = zbx_strdup(bulkwalk_context->error, error);
+			ret = snmp_bulkwalk_handle_index_response(stat, pdu, bulkwalk_context, snmp_context, error,
+					sizeof(error));
+		}
+		else
+		{
+			ret = snmp_bulkwalk_handle_response(stat, pdu, bulkwalk_context, snmp_context->ssp,
+					&snmp_context->item.interface, snmp_context->snmp_oid_type, error, sizeof(error));
 		}
+
+		if (SUCCEED != ret)
+			bulkwalk_context->error = zbx_strdup(bulkwalk_context->error, error);
 	}
 	else
 	{
@@ -2756,7 +2995,7 @@ static netsnmp_pdu	*usm_probe_pdu_create(void)
 }
 
 static zbx_bulkwalk_context_t	*snmp_bulkwalk_context_create(zbx_snmp_context_t *snmp_context,
-		int pdu_type, zbx_snmp_oid_t *p_oid)
+		int pdu_type, zbx_snmp_oid_t *p_oid, int num)
 {
 	zbx_bulkwalk_context_t	*bulkwalk_context;
 
@@ -2767,26 +3006,60 @@ static zbx_bulkwalk_context_t	*snmp_bulkwalk_context_create(zbx_snmp_context_t *
 	bulkwalk_context->name_length = p_oid->root_oid_len;
 	bulkwalk_context->pdu_type = pdu_type;
 	bulkwalk_context->running = 1;
+	bulkwalk_context->waiting = 0;
 	bulkwalk_context->vars_num = 0;
+	bulkwalk_context->num = num;
+	bulkwalk_context->max_repetitions = snmp_context->snmp_max_repetitions;
+	bulkwalk_context->max_repetitions_fail = 0;
+	bulkwalk_context->check_oid_increase = 1;
+	bulkwalk_context->root_oid = NULL;
+	bulkwalk_context->results = NULL;
+	bulkwalk_context->results_alloc = 0;
+	bulkwalk_context->results_offset = 0;
 	bulkwalk_context->arg = snmp_context;
 	bulkwalk_context->error = NULL;
 
-	netsnmp_large_fd_set_init(&bulkwalk_context->fdset, FD_SETSIZE);
-
 	return bulkwalk_context;
 }
 
-static void	snmp_bulkwalk_context_free(zbx_bulkwalk_context_t *bulkwalk_context)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reuses finished bulkwalk context for the next request of dynamic  *
+ *          index lookup                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_bulkwalk_context_reset(zbx_bulkwalk_context_t *bulkwalk_context, int pdu_type,
+		zbx_snmp_oid_t *p_oid)
 {
-	netsnmp_large_fd_set_cleanup(&bulkwalk_context->fdset);
-	zbx_free(bulkwalk_context->error);
-	zbx_free(bulkwalk_context);
+	if (0 == bulkwalk_context->check_oid_increase)
+	{
+		zbx_hashset_destroy(&bulkwalk_context->oids_seen);
+		bulkwalk_context->check_oid_increase = 1;
+	}
+
+	bulkwalk_context->p_oid = p_oid;
+	memcpy(bulkwalk_context->name, p_oid->root_oid, p_oid->root_oid_len * sizeof(oid));
+	bulkwalk_context->name_length = p_oid->root_oid_len;
+	bulkwalk_context->pdu_type = pdu_type;
+	bulkwalk_context->running = 1;
+	bulkwalk_context->vars_num = 0;
+}
+
+static void	snmp_bulkwalk_context_free(zbx_bulkwalk_context_t *bulkwalk_context)
+{
+	if (0 == bulkwalk_context->check_oid_increase)
+		zbx_hashset_destroy(&bulkwalk_context->oids_seen);
+
+	zbx_free(bulkwalk_context->root_oid);
+	zbx_free(bulkwalk_context->results);
+	zbx_free(bulkwalk_context->error);
+	zbx_free(bulkwalk_context);
 }
 
-static int	snmp_bulkwalk_add(zbx_snmp_context_t *snmp_context, int *fd, char *error, size_t max_error_len)
+static int	snmp_bulkwalk_send(zbx_snmp_context_t *snmp_context, zbx_bulkwalk_context_t *bulkwalk_context, int *fd,
+		char *error, size_t max_error_len)
 {
 	struct snmp_pdu			*pdu;
-	zbx_bulkwalk_context_t		*bulkwalk_context = snmp_context->bulkwalk_contexts.values[snmp_context->i];
 	struct netsnmp_transport_s	*transport;
 	int				ret, numfds = 0, block = 0;
 	struct timeval			timeout = {.tv_sec = snmp_context->config_timeout};
@@ -2827,7 +3100,7 @@ static int	snmp_bulkwalk_add(zbx_snmp_context_t *snmp_context, int *fd, char *er
 		if (SNMP_MSG_GETBULK == bulkwalk_context->pdu_type)
 		{
 			pdu->non_repeaters = 0;
-			pdu->max_repetitions = snmp_context->snmp_max_repetitions;
+			pdu->max_repetitions = bulkwalk_context->max_repetitions;
 		}
 
 		if (NULL == snmp_add_null_var(pdu, bulkwalk_context->name, bulkwalk_context->name_length))
@@ -2857,9 +3130,9 @@ static int	snmp_bulkwalk_add(zbx_snmp_context_t *snmp_context, int *fd, char *er
 
 	FD_ZERO(&fdset);
 
-	netsnmp_copy_fd_set_to_large_fd_set(&bulkwalk_context->fdset, &fdset);
+	netsnmp_copy_fd_set_to_large_fd_set(&snmp_context->fdset, &fdset);
 
-	if (1 > snmp_sess_select_info2(snmp_context->ssp, &numfds, &bulkwalk_context->fdset, &timeout, &block))
+	if (1 > snmp_sess_select_info2(snmp_context->ssp, &numfds, &snmp_context->fdset, &timeout, &block))
 	{
 		zbx_strlcpy(error, "snmp_sess_select_info2(): cannot get socket.", max_error_len);
 		ret = NETWORK_ERROR;
@@ -2884,7 +3157,179 @@ out:
 	return ret;
 }
 
-static ZBX_THREAD_LOCAL zbx_snmp_format_opts_t	default_opts;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends requests of all OIDs that are still being walked and have   *
+ *          no request in flight, so that OIDs of the same item are walked    *
+ *          concurrently over the same session                                *
+ *                                                                            *
+ * Parameters: snmp_context  - [IN/OUT]                                       *
+ *             fd            - [OUT] session socket                           *
+ *             pending_num   - [OUT] number of OIDs still being walked        *
+ *             error         - [OUT] buffer to store error message            *
+ *             max_error_len - [IN] maximum error message length              *
+ *                                                                            *
+ * Return value: SUCCEED - requests were sent successfully                    *
+ *               NOTSUPPORTED, NETWORK_ERROR, CONFIG_ERROR - otherwise        *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_bulkwalk_send_pending(zbx_snmp_context_t *snmp_context, int *fd, int *pending_num, char *error,
+		size_t max_error_len)
+{
+	int	ret = SUCCEED;
+
+	*pending_num = 0;
+
+	if (1 == snmp_context->probe)
+	{
+		*pending_num = 1;
+
+		return snmp_bulkwalk_send(snmp_context, snmp_context->bulkwalk_contexts.values[0], fd, error,
+				max_error_len);
+	}
+
+	for (int i = 0; i < snmp_context->bulkwalk_contexts.values_num; i++)
+	{
+		zbx_bulkwalk_context_t	*bulkwalk_context = snmp_context->bulkwalk_contexts.values[i];
+
+		if (0 == bulkwalk_context->running)
+		{
+			/* nothing was walked, try to get the OID itself */
+			if (0 != bulkwalk_context->vars_num || SNMP_MSG_GETBULK != bulkwalk_context->pdu_type ||
+					ZBX_SNMP_WALK != snmp_context->snmp_oid_type)
+			{
+				continue;
+			}
+
+			bulkwalk_context->pdu_type = SNMP_MSG_GET;
+			bulkwalk_context->running = 1;
+		}
+
+		(*pending_num)++;
+
+		if (1 == bulkwalk_context->waiting)
+			continue;
+
+		if (SUCCEED != (ret = snmp_bulkwalk_send(snmp_context, bulkwalk_context, fd, error, max_error_len)))
+			break;
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares next request of dynamic index lookup after the previous  *
+ *          one has finished                                                  *
+ *                                                                            *
+ * Parameters: snmp_context  - [IN/OUT]                                       *
+ *             error         - [OUT] buffer to store error message            *
+ *             max_error_len - [IN] maximum error message length              *
+ *                                                                            *
+ * Return value: SUCCEED - next request was prepared                          *
+ *               NOTSUPPORTED, CONFIG_ERROR - otherwise                       *
+ *                                                                            *
+ * Comments: Cached index is verified by getting the value it points to. If   *
+ *           it is not valid or not cached the index table is walked to       *
+ *           rebuild the cache. Once the index is known, item value is        *
+ *           requested.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_dynamic_next_step(zbx_snmp_context_t *snmp_context, char *error, size_t max_error_len)
+{
+	zbx_snmp_dynamic_t	*dynamic = snmp_context->dynamic;
+	zbx_bulkwalk_context_t	*bulkwalk_context = snmp_context->bulkwalk_contexts.values[0];
+	char			oid_str[ZBX_ITEM_SNMP_OID_LEN_MAX];
+	int			pdu_type;
+
+	if (ZBX_SNMP_DYNAMIC_WALK == dynamic->step)
+	{
+		int	found;
+
+		found = cache_get_snmp_index(snmp_context, dynamic->index_oid_translated, dynamic->index_value,
+				&dynamic->index, &dynamic->index_alloc);
+
+		snmp_index_publish(snmp_context, dynamic->index_oid_translated);
+
+		if (SUCCEED != found)
+		{
+			zbx_snprintf(error, max_error_len, "Cannot find index of \"%s\" in \"%s\".",
+					dynamic->index_value, dynamic->index_oid);
+			return NOTSUPPORTED;
+		}
+	}
+	else if (0 == dynamic->index_valid)
+	{
+		/* walk OID tree to rebuild index cache */
+		if (SUCCEED != snmp_bulkwalk_parse_param(dynamic->index_oid_translated, &snmp_context->param_oids,
+				error, max_error_len))
+		{
+			return CONFIG_ERROR;
+		}
+
+		pdu_type = ZBX_IF_SNMP_VERSION_1 == snmp_context->snmp_version ? SNMP_MSG_GETNEXT : SNMP_MSG_GETBULK;
+		snmp_bulkwalk_context_reset(bulkwalk_context, pdu_type,
+				snmp_context->param_oids.values[snmp_context->param_oids.values_num - 1]);
+
+		if (SUCCEED != snmp_bulkwalk_index_init(bulkwalk_context, error, max_error_len))
+			return CONFIG_ERROR;
+
+		cache_del_snmp_index_subtree(snmp_context, dynamic->index_oid_translated);
+		dynamic->step = ZBX_SNMP_DYNAMIC_WALK;
+
+		return SUCCEED;
+	}
+
+	/* ready to construct the final OID with index */
+	zbx_snprintf(oid_str, sizeof(oid_str), "%s.%s", dynamic->value_oid, dynamic->index);
+
+	if (SUCCEED != snmp_bulkwalk_parse_param(oid_str, &snmp_context->param_oids, error, max_error_len))
+		return CONFIG_ERROR;
+
+	snmp_bulkwalk_context_reset(bulkwalk_context, SNMP_MSG_GET,
+			snmp_context->param_oids.values[snmp_context->param_oids.values_num - 1]);
+	dynamic->step = ZBX_SNMP_DYNAMIC_GET;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets item result after all OIDs have been processed               *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_context_set_result(zbx_snmp_context_t *snmp_context)
+{
+	char	*results = NULL;
+	size_t	results_alloc = 0, results_offset = 0;
+
+	switch (snmp_context->snmp_oid_type)
+	{
+		case ZBX_SNMP_DISCOVERY:
+			zbx_snmp_ddata_set_result(snmp_context->ddata, &snmp_context->item.result);
+			break;
+		case ZBX_SNMP_DYNAMIC:
+			/* value was set when received */
+			break;
+		default:
+			for (int i = 0; i < snmp_context->bulkwalk_contexts.values_num; i++)
+			{
+				zbx_bulkwalk_context_t	*bulkwalk_context = snmp_context->bulkwalk_contexts.values[i];
+
+				if (NULL == bulkwalk_context->results)
+					continue;
+
+				if (NULL != results && ZBX_SNMP_WALK == snmp_context->snmp_oid_type)
+					zbx_chrcpy_alloc(&results, &results_alloc, &results_offset, '\n');
+
+				zbx_strcpy_alloc(&results, &results_alloc, &results_offset, bulkwalk_context->results);
+			}
+
+			SET_TEXT_RESULT(&snmp_context->item.result, NULL == results ? zbx_strdup(NULL, "") : results);
+	}
+
+	snmp_context->item.ret = SUCCEED;
+}
 
 void	zbx_set_snmp_bulkwalk_options(const char *progname)
 {
@@ -2904,6 +3349,7 @@ void	zbx_set_snmp_bulkwalk_options(const char *progname)
 	bulk_opts.numeric_ts = 1;
 	bulk_opts.no_print_units = 1;
 	bulk_opts.oid_format = NETSNMP_OID_OUTPUT_NUMERIC;
+	bulk_opts.dont_breakdown_oids = default_opts.dont_breakdown_oids;
 
 	snmp_bulkwalk_set_options(&bulk_opts);
 }
@@ -2919,17 +3365,14 @@ void	zbx_unset_snmp_bulkwalk_options(void)
 
 static int	snmp_task_process(short event, void *data, int *fd, const char *addr, char *dnserr)
 {
-	zbx_bulkwalk_context_t	*bulkwalk_context;
 	zbx_snmp_context_t	*snmp_context = (zbx_snmp_context_t *)data;
 	char			error[MAX_STRING_LEN];
-	int			ret, task_ret = ZBX_ASYNC_TASK_STOP;
+	int			ret, pending_num, task_ret = ZBX_ASYNC_TASK_STOP;
 	zbx_poller_config_t	*poller_config = (zbx_poller_config_t *)snmp_context->arg_action;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() event:%d fd:%d itemid:" ZBX_FS_UI64, __func__, event, *fd,
 			snmp_context->item.itemid);
 
-	bulkwalk_context = snmp_context->bulkwalk_contexts.values[snmp_context->i];
-
 	if (NULL != poller_config && ZBX_PROCESS_STATE_IDLE == poller_config->state)
 	{
 		zbx_update_selfmon_counter(poller_config->info, ZBX_PROCESS_STATE_BUSY);
@@ -2949,7 +3392,18 @@ static int	snmp_task_process(short event, void *data, int *fd, const char *addr,
 	{
 		if (0 != (event & EV_TIMEOUT))
 		{
-			char	buffer[MAX_OID_LEN];
+			char			buffer[MAX_OID_LEN];
+			zbx_bulkwalk_context_t	*bulkwalk_context = snmp_context->bulkwalk_contexts.values[0];
+
+			/* report the first OID that is still being walked */
+			for (int i = 0; i < snmp_context->bulkwalk_contexts.values_num; i++)
+			{
+				if (1 == snmp_context->bulkwalk_contexts.values[i]->running)
+				{
+					bulkwalk_context = snmp_context->bulkwalk_contexts.values[i];
+					break;
+				}
+			}
 
 			snprint_objid(buffer, sizeof(buffer), bulkwalk_context->name, bulkwalk_context->name_length);
 
@@ -2981,7 +3435,7 @@ static int	snmp_task_process(short event, void *data, int *fd, const char *addr,
 			goto stop;
 		}
 
-		if (0 != snmp_sess_read2(snmp_context->ssp, &bulkwalk_context->fdset))
+		if (0 != snmp_sess_read2(snmp_context->ssp, &snmp_context->fdset))
 		{
 			char		*tmp_err_str = NULL;
 
@@ -3030,48 +3484,16 @@ static int	snmp_task_process(short event, void *data, int *fd, const char *addr,
 			snmp_context->probe = 0;
 		}
 
-		if (NULL != bulkwalk_context->error)
+		for (int i = 0; i < snmp_context->bulkwalk_contexts.values_num; i++)
 		{
-			snmp_context->item.ret = NOTSUPPORTED;
-			SET_MSG_RESULT(&snmp_context->item.result, bulkwalk_context->error);
-			bulkwalk_context->error = NULL;
-			goto stop;
-		}
+			zbx_bulkwalk_context_t	*bulkwalk_context = snmp_context->bulkwalk_contexts.values[i];
 
-		if (1 == bulkwalk_context->waiting)
-		{
-			zabbix_log(LOG_LEVEL_DEBUG, "cannot process PDU result for itemid:" ZBX_FS_UI64,
-					snmp_context->item.itemid);
-		}
-
-		if (0 == bulkwalk_context->running)
-		{
-			if (0 == bulkwalk_context->vars_num && SNMP_MSG_GETBULK == bulkwalk_context->pdu_type)
-			{
-				bulkwalk_context->pdu_type = SNMP_MSG_GET;
-			}
-			else
+			if (NULL != bulkwalk_context->error)
 			{
-				snmp_context->i++;
-
-				if (snmp_context->i >= snmp_context->bulkwalk_contexts.values_num)
-				{
-					if (NULL == snmp_context->results)
-						SET_TEXT_RESULT(&snmp_context->item.result, zbx_strdup(NULL, ""));
-					else
-						SET_TEXT_RESULT(&snmp_context->item.result, snmp_context->results);
-
-					snmp_context->results = NULL;
-					snmp_context->item.ret = SUCCEED;
-
-					if (ZABBIX_ASYNC_RESOLVE_REVERSE_DNS_YES == snmp_context->resolve_reverse_dns)
-					{
-						task_ret = ZBX_ASYNC_TASK_RESOLVE_REVERSE;
-						snmp_context->step = ZABBIX_ASYNC_STEP_REVERSE_DNS;
-					}
-
-					goto stop;
-				}
+				snmp_context->item.ret = NOTSUPPORTED;
+				SET_MSG_RESULT(&snmp_context->item.result, bulkwalk_context->error);
+				bulkwalk_context->error = NULL;
+				goto stop;
 			}
 		}
 	}
@@ -3092,13 +3514,39 @@ static int	snmp_task_process(short event, void *data, int *fd, const char *addr,
 		}
 	}
 
-	if (SUCCEED != (ret = snmp_bulkwalk_add(snmp_context, fd, error, sizeof(error))))
+next:
+	if (SUCCEED != (ret = snmp_bulkwalk_send_pending(snmp_context, fd, &pending_num, error, sizeof(error))))
 	{
 		snmp_context->item.ret = ret;
 		SET_MSG_RESULT(&snmp_context->item.result, zbx_dsprintf(NULL, "Get value failed: %s", error));
+		goto stop;
 	}
-	else
+
+	if (0 != pending_num)
+	{
 		task_ret = ZBX_ASYNC_TASK_READ;
+		goto stop;
+	}
+
+	if (ZBX_SNMP_DYNAMIC == snmp_context->snmp_oid_type && ZBX_SNMP_DYNAMIC_GET != snmp_context->dynamic->step)
+	{
+		if (SUCCEED != (ret = snmp_dynamic_next_step(snmp_context, error, sizeof(error))))
+		{
+			snmp_context->item.ret = ret;
+			SET_MSG_RESULT(&snmp_context->item.result, zbx_strdup(NULL, error));
+			goto stop;
+		}
+
+		goto next;
+	}
+
+	snmp_context_set_result(snmp_context);
+
+	if (ZABBIX_ASYNC_RESOLVE_REVERSE_DNS_YES == snmp_context->resolve_reverse_dns)
+	{
+		task_ret = ZBX_ASYNC_TASK_RESOLVE_REVERSE;
+		snmp_context->step = ZABBIX_ASYNC_STEP_REVERSE_DNS;
+	}
 stop:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
@@ -3133,10 +3581,23 @@ void	zbx_async_check_snmp_clean(zbx_snmp_context_t *snmp_context)
 
 	zbx_free(snmp_context->item.key);
 	zbx_free(snmp_context->item.key_orig);
-	zbx_free(snmp_context->results);
 	zbx_free(snmp_context->reverse_dns);
 	zbx_free_agent_result(&snmp_context->item.result);
 
+	if (NULL != snmp_context->ddata)
+	{
+		zbx_snmp_ddata_clean(snmp_context->ddata);
+		zbx_free(snmp_context->ddata);
+	}
+
+	if (NULL != snmp_context->dynamic)
+	{
+		zbx_free(snmp_context->dynamic->index);
+		zbx_free(snmp_context->dynamic);
+	}
+
+	netsnmp_large_fd_set_cleanup(&snmp_context->fdset);
+
 	zbx_vector_bulkwalk_context_clear_ext(&snmp_context->bulkwalk_contexts, snmp_bulkwalk_context_free);
 	zbx_vector_bulkwalk_context_destroy(&snmp_context->bulkwalk_contexts);
 	zbx_vector_snmp_oid_clear_ext(&snmp_context->param_oids, vector_snmp_oid_free);
@@ -3144,6 +3605,144 @@ void	zbx_async_check_snmp_clean(zbx_snmp_context_t *snmp_context)
 	zbx_free(snmp_context);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares walks of all OIDs of SNMP discovery item                 *
+ *                                                                            *
+ * Parameters: snmp_context  - [IN/OUT]                                       *
+ *             snmp_oid      - [IN] discovery key                             *
+ *             pdu_type      - [IN] type of walk requests                     *
+ *             error         - [OUT] buffer to store error message            *
+ *             max_error_len - [IN] maximum error message length              *
+ *                                                                            *
+ * Return value: SUCCEED      - discovery was prepared                        *
+ *               CONFIG_ERROR - invalid discovery key                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_discovery_init(zbx_snmp_context_t *snmp_context, const char *snmp_oid, int pdu_type,
+		char *error, size_t max_error_len)
+{
+	zbx_snmp_ddata_t	ddata;
+
+	if (SUCCEED != zbx_snmp_ddata_init(&ddata, snmp_oid, error, max_error_len))
+		return CONFIG_ERROR;
+
+	snmp_context->ddata = (zbx_snmp_ddata_t *)zbx_malloc(NULL, sizeof(zbx_snmp_ddata_t));
+	*snmp_context->ddata = ddata;
+
+	for (int i = 0; i < ddata.request.nparam / 2; i++)
+	{
+		zbx_bulkwalk_context_t	*bulkwalk_context;
+
+		if (SUCCEED != snmp_bulkwalk_parse_param(ddata.request.params[i * 2 + 1], &snmp_context->param_oids,
+				error, max_error_len))
+		{
+			return CONFIG_ERROR;
+		}
+
+		bulkwalk_context = snmp_bulkwalk_context_create(snmp_context, pdu_type,
+				snmp_context->param_oids.values[i], i);
+
+		zbx_vector_bulkwalk_context_append(&snmp_context->bulkwalk_contexts, bulkwalk_context);
+
+		if (SUCCEED != snmp_bulkwalk_index_init(bulkwalk_context, error, max_error_len))
+			return CONFIG_ERROR;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares lookup of OID with dynamic index                         *
+ *                                                                            *
+ * Parameters: snmp_context  - [IN/OUT]                                       *
+ *             snmp_oid      - [IN] OID with dynamic index                    *
+ *             pdu_type      - [IN] type of index walk requests               *
+ *             error         - [OUT] buffer to store error message            *
+ *             max_error_len - [IN] maximum error message length              *
+ *                                                                            *
+ * Return value: SUCCEED      - lookup was prepared                           *
+ *               CONFIG_ERROR - invalid OID                                   *
+ *                                                                            *
+ * Comments: If index is cached the value it points to is requested first to  *
+ *           verify it, otherwise the index table is walked.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_dynamic_init(zbx_snmp_context_t *snmp_context, const char *snmp_oid, int pdu_type, char *error,
+		size_t max_error_len)
+{
+	AGENT_REQUEST		request;
+	zbx_snmp_dynamic_t	*dynamic;
+	zbx_bulkwalk_context_t	*bulkwalk_context;
+	char			oid_str[ZBX_ITEM_SNMP_OID_LEN_MAX];
+	const char		*pl;
+	int			ret = CONFIG_ERROR;
+
+	zbx_init_agent_request(&request);
+
+	if (SUCCEED != zbx_parse_item_key(snmp_oid, &request) || 3 != request.nparam)
+	{
+		zbx_snprintf(error, max_error_len, "OID \"%s\" contains unsupported parameters.", snmp_oid);
+		goto out;
+	}
+
+	if (0 != strcmp("index", request.params[0]))
+	{
+		zbx_snprintf(error, max_error_len, "Unsupported method \"%s\" in the OID \"%s\".", request.params[0],
+				snmp_oid);
+		goto out;
+	}
+
+	dynamic = snmp_context->dynamic = (zbx_snmp_dynamic_t *)zbx_malloc(NULL, sizeof(zbx_snmp_dynamic_t));
+
+	dynamic->index = NULL;
+	dynamic->index_alloc = 0;
+	dynamic->index_valid = 0;
+
+	zbx_strlcpy(dynamic->index_oid, request.params[1], sizeof(dynamic->index_oid));
+	zbx_snmp_translate(dynamic->index_oid_translated, dynamic->index_oid, sizeof(dynamic->index_oid_translated));
+	zbx_strlcpy(dynamic->index_value, request.params[2], sizeof(dynamic->index_value));
+
+	pl = strchr(snmp_oid, '[');
+	zbx_strlcpy(oid_str, snmp_oid, MIN(sizeof(oid_str), (size_t)(pl - snmp_oid + 1)));
+	zbx_snmp_translate(dynamic->value_oid, oid_str, sizeof(dynamic->value_oid));
+
+	if (SUCCEED == snmp_index_get(snmp_context, dynamic->index_oid_translated, dynamic->index_value,
+			&dynamic->index, &dynamic->index_alloc))
+	{
+		zbx_snprintf(oid_str, sizeof(oid_str), "%s.%s", dynamic->index_oid_translated, dynamic->index);
+		dynamic->step = ZBX_SNMP_DYNAMIC_VERIFY;
+		pdu_type = SNMP_MSG_GET;
+	}
+	else
+	{
+		zbx_strlcpy(oid_str, dynamic->index_oid_translated, sizeof(oid_str));
+		dynamic->step = ZBX_SNMP_DYNAMIC_WALK;
+	}
+
+	if (SUCCEED != snmp_bulkwalk_parse_param(oid_str, &snmp_context->param_oids, error, max_error_len))
+		goto out;
+
+	bulkwalk_context = snmp_bulkwalk_context_create(snmp_context, pdu_type, snmp_context->param_oids.values[0],
+			0);
+	zbx_vector_bulkwalk_context_append(&snmp_context->bulkwalk_contexts, bulkwalk_context);
+
+	if (ZBX_SNMP_DYNAMIC_WALK == dynamic->step)
+	{
+		if (SUCCEED != snmp_bulkwalk_index_init(bulkwalk_context, error, max_error_len))
+			goto out;
+
+		cache_del_snmp_index_subtree(snmp_context, dynamic->index_oid_translated);
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_free_agent_request(&request);
+
+	return ret;
+}
+
 int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_task_clear_cb_t clear_cb,
 		void *arg, void *arg_action, struct event_base *base, struct evdns_base *dnsbase,
 		const char *config_source_ip, zbx_async_resolve_reverse_dns_t resolve_reverse_dns)
@@ -3158,6 +3757,10 @@ int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_ta
 
 	snmp_context = zbx_malloc(NULL, sizeof(zbx_snmp_context_t));
 
+	netsnmp_large_fd_set_init(&snmp_context->fdset, FD_SETSIZE);
+	snmp_context->ddata = NULL;
+	snmp_context->dynamic = NULL;
+
 	snmp_context->resolve_reverse_dns = resolve_reverse_dns;
 	snmp_context->step = ZABBIX_ASYNC_STEP_DEFAULT;
 	snmp_context->reverse_dns = NULL;
@@ -3190,10 +3793,6 @@ int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_ta
 	snmp_context->snmp_max_repetitions = item->snmp_max_repetitions;
 	snmp_context->arg = arg;
 	snmp_context->arg_action = arg_action;
-	snmp_context->results = NULL;
-	snmp_context->results_alloc = 0;
-	snmp_context->results_offset = 0;
-	snmp_context->i = 0;
 
 	snmp_context->snmp_version = item->snmp_version;
 	snmp_context->snmp_community = item->snmp_community;
@@ -3221,6 +3820,18 @@ int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_ta
 		snmp_context->snmp_oid_type = ZBX_SNMP_WALK;
 		pdu_type = ZBX_IF_SNMP_VERSION_1 == item->snmp_version ? SNMP_MSG_GETNEXT : SNMP_MSG_GETBULK;
 	}
+	else if (0 != (ZBX_FLAG_DISCOVERY_RULE & item->flags) ||
+			0 == strncmp(item->snmp_oid, "discovery[", ZBX_CONST_STRLEN("discovery[")))
+	{
+		snmp_context->snmp_oid_type = ZBX_SNMP_DISCOVERY;
+		pdu_type = ZBX_IF_SNMP_VERSION_1 == item->snmp_version ? SNMP_MSG_GETNEXT : SNMP_MSG_GETBULK;
+	}
+	else if (0 != strncmp(item->snmp_oid, "get[", ZBX_CONST_STRLEN("get[")) &&
+			NULL != strchr(item->snmp_oid, '['))
+	{
+		snmp_context->snmp_oid_type = ZBX_SNMP_DYNAMIC;
+		pdu_type = ZBX_IF_SNMP_VERSION_1 == item->snmp_version ? SNMP_MSG_GETNEXT : SNMP_MSG_GETBULK;
+	}
 	else
 	{
 		snmp_context->snmp_oid_type = ZBX_SNMP_GET;
@@ -3236,6 +3847,30 @@ int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_ta
 		goto out;
 	}
 
+	if (ZBX_SNMP_DISCOVERY == snmp_context->snmp_oid_type)
+	{
+		if (SUCCEED != (ret = snmp_discovery_init(snmp_context, item->snmp_oid, pdu_type, error,
+				sizeof(error))))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, error));
+			goto out;
+		}
+
+		goto add_task;
+	}
+
+	if (ZBX_SNMP_DYNAMIC == snmp_context->snmp_oid_type)
+	{
+		if (SUCCEED != (ret = snmp_dynamic_init(snmp_context, item->snmp_oid, pdu_type, error,
+				sizeof(error))))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, error));
+			goto out;
+		}
+
+		goto add_task;
+	}
+
 	if (SUCCEED != zbx_parse_item_key(item->snmp_oid, &request))
 	{
 		SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid SNMP OID: cannot parse parameter."));
@@ -3272,11 +3907,11 @@ int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_ta
 		zbx_bulkwalk_context_t	*bulkwalk_context;
 
 		bulkwalk_context = snmp_bulkwalk_context_create(snmp_context, pdu_type,
-				snmp_context->param_oids.values[i]);
+				snmp_context->param_oids.values[i], i);
 
 		zbx_vector_bulkwalk_context_append(&snmp_context->bulkwalk_contexts, bulkwalk_context);
 	}
-
+add_task:
 	zbx_async_poller_add_task(base, dnsbase, snmp_context->item.interface.addr, snmp_context, item->timeout,
 			snmp_task_process, clear_cb);
 
@@ -3292,202 +3927,6 @@ out:
 	return ret;
 }
 
-static int	zbx_snmp_process_dynamic(zbx_snmp_sess_t ssp, const zbx_dc_item_t *items, AGENT_RESULT *results,
-		int *errcodes, int num, char *error, size_t max_error_len, int *max_succeed, int *min_fail, int bulk,
-		unsigned char poller_type)
-{
-	int		ret, to_walk[ZBX_MAX_SNMP_ITEMS], to_walk_num = 0, to_verify[ZBX_MAX_SNMP_ITEMS],
-			to_verify_num = 0;
-	unsigned char	query_and_ignore_type[ZBX_MAX_SNMP_ITEMS];
-	char		to_verify_oids[ZBX_MAX_SNMP_ITEMS][ZBX_ITEM_SNMP_OID_LEN_MAX],
-			index_oids[ZBX_MAX_SNMP_ITEMS][ZBX_ITEM_SNMP_OID_LEN_MAX],
-			index_values[ZBX_MAX_SNMP_ITEMS][ZBX_ITEM_SNMP_OID_LEN_MAX],
-			oids_translated[ZBX_MAX_SNMP_ITEMS][ZBX_ITEM_SNMP_OID_LEN_MAX];
-	char		*idx = NULL;
-	size_t		idx_alloc = 32;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	idx = (char *)zbx_malloc(idx, idx_alloc);
-
-	/* perform initial item validation */
-
-	for (int i = 0; i < num; i++)
-	{
-		char	method[8];
-
-		if (SUCCEED != errcodes[i])
-			continue;
-
-		if (3 != zbx_num_key_param(items[i].snmp_oid))
-		{
-			SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL, "OID \"%s\" contains unsupported parameters.",
-					items[i].snmp_oid));
-			errcodes[i] = CONFIG_ERROR;
-			continue;
-		}
-
-		zbx_get_key_param(items[i].snmp_oid, 1, method, sizeof(method));
-		zbx_get_key_param(items[i].snmp_oid, 2, index_oids[i], sizeof(index_oids[i]));
-		zbx_get_key_param(items[i].snmp_oid, 3, index_values[i], sizeof(index_values[i]));
-
-		if (0 != strcmp("index", method))
-		{
-			SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL, "Unsupported method \"%s\" in the OID \"%s\".",
-					method, items[i].snmp_oid));
-			errcodes[i] = CONFIG_ERROR;
-			continue;
-		}
-
-		zbx_snmp_translate(oids_translated[i], index_oids[i], sizeof(oids_translated[i]));
-
-		if (SUCCEED == cache_get_snmp_index(&items[i], oids_translated[i], index_values[i], &idx, &idx_alloc))
-		{
-			zbx_snprintf(to_verify_oids[i], sizeof(to_verify_oids[i]), "%s.%s", oids_translated[i], idx);
-
-			to_verify[to_verify_num++] = i;
-			query_and_ignore_type[i] = 1;
-		}
-		else
-		{
-			to_walk[to_walk_num++] = i;
-			query_and_ignore_type[i] = 0;
-		}
-	}
-
-	/* verify that cached indices are still valid */
-
-	if (0 != to_verify_num)
-	{
-		ret = zbx_snmp_get_values(ssp, items, to_verify_oids, results, errcodes, query_and_ignore_type, num, 0,
-				error, max_error_len, max_succeed, min_fail, poller_type);
-
-		if (SUCCEED != ret && NOTSUPPORTED != ret)
-			goto exit;
-
-		for (int i = 0; i < to_verify_num; i++)
-		{
-			int	j = to_verify[i];
-
-			if (SUCCEED != errcodes[j])
-				continue;
-
-			if (NULL == ZBX_GET_STR_RESULT(&results[j]) || 0 != strcmp(results[j].str, index_values[j]))
-			{
-				to_walk[to_walk_num++] = j;
-			}
-			else
-			{
-				/* ready to construct the final OID with index */
-				size_t	len = strlen(oids_translated[j]);
-
-				char	*pl = strchr(items[j].snmp_oid, '[');
-
-				*pl = '\0';
-				zbx_snmp_translate(oids_translated[j], items[j].snmp_oid, sizeof(oids_translated[j]));
-				*pl = '[';
-
-				zbx_strlcat(oids_translated[j], to_verify_oids[j] + len, sizeof(oids_translated[j]));
-			}
-
-			zbx_free_agent_result(&results[j]);
-		}
-	}
-
-	/* walk OID trees to build index cache for cache misses */
-
-	if (0 != to_walk_num)
-	{
-		for (int i = 0; i < to_walk_num; i++)
-		{
-			int	k, j = to_walk[i];
-
-			/* see whether this OID tree was already walked for another item */
-
-			for (k = 0; k < i; k++)
-			{
-				if (0 == strcmp(oids_translated[to_walk[k]], oids_translated[j]))
-					break;
-			}
-
-			if (k != i)
-				continue;
-
-			/* walk */
-
-			cache_del_snmp_index_subtree(&items[j], oids_translated[j]);
-
-			int	errcode = zbx_snmp_walk(ssp, &items[j], oids_translated[j], error, max_error_len,
-					max_succeed, min_fail, num, bulk, zbx_snmp_walk_cache_cb, (void *)&items[j]);
-
-			if (NETWORK_ERROR == errcode)
-			{
-				/* consider a network error as relating to all items passed to */
-				/* this function, including those we did not just try to walk for */
-
-				ret = NETWORK_ERROR;
-				goto exit;
-			}
-
-			if (CONFIG_ERROR == errcode || NOTSUPPORTED == errcode)
-			{
-				/* consider a configuration or "not supported" error as */
-				/* relating only to the items we have just tried to walk for */
-
-				for (k = i; k < to_walk_num; k++)
-				{
-					if (0 == strcmp(oids_translated[to_walk[k]], oids_translated[j]))
-					{
-						SET_MSG_RESULT(&results[to_walk[k]], zbx_strdup(NULL, error));
-						errcodes[to_walk[k]] = errcode;
-					}
-				}
-			}
-		}
-
-		for (int i = 0; i < to_walk_num; i++)
-		{
-			int	j = to_walk[i];
-
-			if (SUCCEED != errcodes[j])
-				continue;
-
-			if (SUCCEED == cache_get_snmp_index(&items[j], oids_translated[j], index_values[j], &idx,
-						&idx_alloc))
-			{
-				/* ready to construct the final OID with index */
-
-				char	*pl = strchr(items[j].snmp_oid, '[');
-
-				*pl = '\0';
-				zbx_snmp_translate(oids_translated[j], items[j].snmp_oid, sizeof(oids_translated[j]));
-				*pl = '[';
-
-				zbx_strlcat(oids_translated[j], ".", sizeof(oids_translated[j]));
-				zbx_strlcat(oids_translated[j], idx, sizeof(oids_translated[j]));
-			}
-			else
-			{
-				SET_MSG_RESULT(&results[j], zbx_dsprintf(NULL,
-						"Cannot find index of \"%s\" in \"%s\".",
-						index_values[j], index_oids[j]));
-				errcodes[j] = NOTSUPPORTED;
-			}
-		}
-	}
-
-	/* query values based on the indices verified and/or determined above */
-
-	ret = zbx_snmp_get_values(ssp, items, oids_translated, results, errcodes, NULL, num, 0, error, max_error_len,
-			max_succeed, min_fail, poller_type);
-exit:
-	zbx_free(idx);
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
-}
-
 static int	zbx_snmp_process_standard(struct snmp_session *ss, const zbx_dc_item_t *items, AGENT_RESULT *results,
 		int *errcodes, int num, char *error, size_t max_error_len, int *max_succeed, int *min_fail,
 		unsigned char poller_type)
@@ -3662,8 +4101,7 @@ void	get_values_snmp(zbx_dc_item_t *items, AGENT_RESULT *results, int *errcodes,
 
 	SNMP_MT_EXECLOCK;
 
-	if (0 == strncmp(items[j].snmp_oid, "walk[", ZBX_CONST_STRLEN("walk[")) ||
-			(0 == strncmp(items[j].snmp_oid, "get[", ZBX_CONST_STRLEN("get["))))
+	if (0 != (ZBX_FLAG_DISCOVERY_RULE & items[j].flags) || NULL != strchr(items[j].snmp_oid, '['))
 	{
 		struct evdns_base	*dnsbase;
 		zbx_snmp_result_t	snmp_result = {.result = &results[j]};
@@ -3720,55 +4158,6 @@ void	get_values_snmp(zbx_dc_item_t *items, AGENT_RESULT *results, int *errcodes,
 		zbx_unset_snmp_bulkwalk_options();
 		goto out;
 	}
-	else if (0 != (ZBX_FLAG_DISCOVERY_RULE & items[j].flags) || 0 == strncmp(items[j].snmp_oid, "discovery[", 10))
-	{
-		int		max_vars;
-		zbx_dc_item_t	*item = &items[j];
-		char		ip_addr[ZBX_INTERFACE_IP_LEN_MAX];
-
-		zbx_getip_by_host(item->interface.addr, ip_addr, sizeof(ip_addr));
-
-		if (NULL == (ssp = zbx_snmp_open_session(item->snmp_version, ip_addr, item->interface.port,
-			item->snmp_community, item->snmpv3_securityname, item->snmpv3_contextname,
-			item->snmpv3_securitylevel, item->snmpv3_authprotocol, item->snmpv3_authpassphrase,
-			item->snmpv3_privprotocol, item->snmpv3_privpassphrase, error, sizeof(error),
-			item->timeout, config_source_ip)))
-		{
-			err = NETWORK_ERROR;
-			goto exit;
-		}
-
-		max_vars = zbx_dc_config_get_suggested_snmp_vars(items[j].interface.interfaceid, &bulk);
-
-		err = zbx_snmp_process_discovery(ssp, &items[j], &results[j], &errcodes[j], error, sizeof(error),
-				&max_succeed, &min_fail, max_vars, bulk);
-
-		zbx_snmp_close_session(ssp);
-	}
-	else if (NULL != strchr(items[j].snmp_oid, '['))
-	{
-		zbx_dc_item_t	*item = &items[j];
-		char		ip_addr[ZBX_INTERFACE_IP_LEN_MAX];
-
-		zbx_getip_by_host(item->interface.addr, ip_addr, sizeof(ip_addr));
-
-		if (NULL == (ssp = zbx_snmp_open_session(item->snmp_version, ip_addr, item->interface.port,
-			item->snmp_community, item->snmpv3_securityname, item->snmpv3_contextname,
-			item->snmpv3_securitylevel, item->snmpv3_authprotocol, item->snmpv3_authpassphrase,
-			item->snmpv3_privprotocol, item->snmpv3_privpassphrase, error, sizeof(error),
-			item->timeout, config_source_ip)))
-		{
-			err = NETWORK_ERROR;
-			goto exit;
-		}
-
-		(void)zbx_dc_config_get_suggested_snmp_vars(items[j].interface.interfaceid, &bulk);
-
-		err = zbx_snmp_process_dynamic(ssp, items + j, results + j, errcodes + j, num - j, error, sizeof(error),
-				&max_succeed, &min_fail, bulk, poller_type);
-
-		zbx_snmp_close_session(ssp);
-	}
 	else
 	{
 		zbx_dc_item_t	*item = &items[j];
@@ -0,0 +1,543 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "snmp_index_cache.h"
+
+#include "zbxpoller.h"
+#include "zbxshmem.h"
+#include "zbxmutexs.h"
+#include "zbxstr.h"
+
+/*
+ * The shared SNMP index cache keeps index tables walked by SNMP pollers for OIDs with dynamic index, so that
+ * a table walked by one poller can be used by all the others.
+ *
+ * The tables are identified by SNMP agent address, port, community/context, security name and the OID of
+ * the table. The cached indexes are still verified before use, the time to live only limits how long tables
+ * of agents that are no longer polled are kept.
+ *
+ * A table is stored after the whole index table has been walked, replacing the previous table. When there is
+ * not enough memory the expired tables are dropped and storing is retried once.
+ */
+
+#define SNMPIDX_TABLE_TTL	SEC_PER_DAY
+
+#define SNMPIDX_TABLES_INIT_SIZE	100
+#define SNMPIDX_MAPPINGS_INIT_SIZE	100
+#define SNMPIDX_STRPOOL_INIT_SIZE	1000
+
+#define REFCOUNT_FIELD_SIZE	sizeof(zbx_uint32_t)
+
+typedef struct
+{
+	const char	*value;
+	const char	*index;
+}
+zbx_snmpidx_mapping_t;
+
+typedef struct
+{
+	const char	*addr;
+	const char	*community_context;
+	const char	*security_name;
+	const char	*oid;
+	unsigned short	port;
+	time_t		lastupdate;
+	zbx_hashset_t	mappings;
+}
+zbx_snmpidx_table_t;
+
+typedef struct
+{
+	zbx_hashset_t			tables;
+	zbx_hashset_t			strpool;
+	zbx_snmp_index_cache_stats_t	stats;
+}
+zbx_snmpidx_cache_t;
+
+static zbx_snmpidx_cache_t	*snmpidx_cache = NULL;
+static zbx_shmem_info_t		*snmpidx_mem = NULL;
+static zbx_mutex_t		snmpidx_lock = ZBX_MUTEX_NULL;
+
+ZBX_SHMEM_FUNC_IMPL(__snmpidx, snmpidx_mem)
+
+#define	LOCK_CACHE	zbx_mutex_lock(snmpidx_lock)
+#define	UNLOCK_CACHE	zbx_mutex_unlock(snmpidx_lock)
+
+static zbx_hash_t	snmpidx_strpool_hash_func(const void *data)
+{
+	return ZBX_DEFAULT_STRING_HASH_FUNC((const char *)data + REFCOUNT_FIELD_SIZE);
+}
+
+static int	snmpidx_strpool_compare_func(const void *d1, const void *d2)
+{
+	return strcmp((const char *)d1 + REFCOUNT_FIELD_SIZE, (const char *)d2 + REFCOUNT_FIELD_SIZE);
+}
+
+static zbx_hash_t	snmpidx_table_hash_func(const void *data)
+{
+	const zbx_snmpidx_table_t	*table = (const zbx_snmpidx_table_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_FUNC(table->addr);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(&table->port, sizeof(table->port), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(table->oid, strlen(table->oid), hash);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(table->community_context, strlen(table->community_context), hash);
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(table->security_name, strlen(table->security_name), hash);
+}
+
+static int	snmpidx_table_compare_func(const void *d1, const void *d2)
+{
+	const zbx_snmpidx_table_t	*table1 = (const zbx_snmpidx_table_t *)d1;
+	const zbx_snmpidx_table_t	*table2 = (const zbx_snmpidx_table_t *)d2;
+	int				ret;
+
+	if (0 != (ret = strcmp(table1->addr, table2->addr)))
+		return ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(table1->port, table2->port);
+
+	if (0 != (ret = strcmp(table1->community_context, table2->community_context)))
+		return ret;
+
+	if (0 != (ret = strcmp(table1->security_name, table2->security_name)))
+		return ret;
+
+	return strcmp(table1->oid, table2->oid);
+}
+
+static zbx_hash_t	snmpidx_mapping_hash_func(const void *data)
+{
+	const zbx_snmpidx_mapping_t	*mapping = (const zbx_snmpidx_mapping_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(mapping->value);
+}
+
+static int	snmpidx_mapping_compare_func(const void *d1, const void *d2)
+{
+	const zbx_snmpidx_mapping_t	*mapping1 = (const zbx_snmpidx_mapping_t *)d1;
+	const zbx_snmpidx_mapping_t	*mapping2 = (const zbx_snmpidx_mapping_t *)d2;
+
+	return strcmp(mapping1->value, mapping2->value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies string to the cache string pool                            *
+ *                                                                            *
+ * Return value: The pointer to the copied string or NULL if there was not    *
+ *               enough space in cache.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*snmpidx_strpool_acquire(const char *str)
+{
+	void	*ptr;
+	size_t	len;
+
+	len = strlen(str) + 1;
+
+	if (NULL == (ptr = zbx_hashset_insert_ext(&snmpidx_cache->strpool, str - REFCOUNT_FIELD_SIZE,
+			REFCOUNT_FIELD_SIZE + len, REFCOUNT_FIELD_SIZE, REFCOUNT_FIELD_SIZE + len,
+			ZBX_HASHSET_UNIQ_FALSE)))
+	{
+		return NULL;
+	}
+
+	(*(zbx_uint32_t *)ptr)++;
+
+	return (const char *)ptr + REFCOUNT_FIELD_SIZE;
+}
+
+static void	snmpidx_strpool_release(const char *str)
+{
+	void	*ptr;
+
+	if (NULL == str)
+		return;
+
+	ptr = (void *)(str - REFCOUNT_FIELD_SIZE);
+
+	if (0 == --(*(zbx_uint32_t *)ptr))
+		zbx_hashset_remove_direct(&snmpidx_cache->strpool, ptr);
+}
+
+static void	snmpidx_table_clear(zbx_snmpidx_table_t *table)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_snmpidx_mapping_t	*mapping;
+
+	zbx_hashset_iter_reset(&table->mappings, &iter);
+	while (NULL != (mapping = (zbx_snmpidx_mapping_t *)zbx_hashset_iter_next(&iter)))
+	{
+		snmpidx_strpool_release(mapping->value);
+		snmpidx_strpool_release(mapping->index);
+	}
+
+	zbx_hashset_clear(&table->mappings);
+}
+
+static void	snmpidx_table_release(zbx_snmpidx_table_t *table)
+{
+	if (NULL != table->mappings.slots)
+	{
+		snmpidx_table_clear(table);
+		zbx_hashset_destroy(&table->mappings);
+	}
+
+	snmpidx_strpool_release(table->addr);
+	snmpidx_strpool_release(table->community_context);
+	snmpidx_strpool_release(table->security_name);
+	snmpidx_strpool_release(table->oid);
+}
+
+static void	snmpidx_table_remove(zbx_snmpidx_table_t *table)
+{
+	snmpidx_table_release(table);
+	zbx_hashset_remove_direct(&snmpidx_cache->tables, table);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes tables that were not updated during time to live          *
+ *                                                                            *
+ * Return value: The number of removed tables.                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmpidx_remove_expired(time_t now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_snmpidx_table_t	*table;
+	int			removed_num = 0;
+
+	zbx_hashset_iter_reset(&snmpidx_cache->tables, &iter);
+	while (NULL != (table = (zbx_snmpidx_table_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (table->lastupdate + SNMPIDX_TABLE_TTL > now)
+			continue;
+
+		snmpidx_table_release(table);
+		zbx_hashset_iter_remove(&iter);
+		removed_num++;
+	}
+
+	snmpidx_cache->stats.expired += (zbx_uint64_t)removed_num;
+
+	return removed_num;
+}
+
+static void	snmpidx_key_to_table(const zbx_snmp_index_key_t *key, zbx_snmpidx_table_t *table)
+{
+	table->addr = key->addr;
+	table->port = key->port;
+	table->community_context = key->community_context;
+	table->security_name = key->security_name;
+	table->oid = key->oid;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stores index table in cache, replacing the old table              *
+ *                                                                            *
+ * Return value: SUCCEED - the table was stored                               *
+ *               FAIL    - not enough space in cache                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmpidx_table_store(const zbx_snmp_index_key_t *key, const zbx_vector_ptr_pair_t *mappings, time_t now)
+{
+	zbx_snmpidx_table_t	*table, table_local;
+
+	snmpidx_key_to_table(key, &table_local);
+
+	if (NULL == (table = (zbx_snmpidx_table_t *)zbx_hashset_search(&snmpidx_cache->tables, &table_local)))
+	{
+		memset(&table_local, 0, sizeof(table_local));
+		table_local.port = key->port;
+
+		if (NULL == (table_local.addr = snmpidx_strpool_acquire(key->addr)) ||
+				NULL == (table_local.community_context =
+				snmpidx_strpool_acquire(key->community_context)) ||
+				NULL == (table_local.security_name = snmpidx_strpool_acquire(key->security_name)) ||
+				NULL == (table_local.oid = snmpidx_strpool_acquire(key->oid)) ||
+				NULL == (table = (zbx_snmpidx_table_t *)zbx_hashset_insert(&snmpidx_cache->tables,
+				&table_local, sizeof(table_local))))
+		{
+			snmpidx_strpool_release(table_local.addr);
+			snmpidx_strpool_release(table_local.community_context);
+			snmpidx_strpool_release(table_local.security_name);
+			snmpidx_strpool_release(table_local.oid);
+
+			return FAIL;
+		}
+
+		zbx_hashset_create_ext(&table->mappings, MAX(SNMPIDX_MAPPINGS_INIT_SIZE, mappings->values_num),
+				snmpidx_mapping_hash_func, snmpidx_mapping_compare_func, NULL,
+				__snmpidx_shmem_malloc_func, __snmpidx_shmem_realloc_func, __snmpidx_shmem_free_func);
+
+		if (NULL == table->mappings.slots)
+			goto fail;
+	}
+	else
+		snmpidx_table_clear(table);
+
+	for (int i = 0; i < mappings->values_num; i++)
+	{
+		zbx_snmpidx_mapping_t	mapping_local;
+
+		if (NULL == (mapping_local.value = snmpidx_strpool_acquire((const char *)mappings->values[i].first)))
+			goto fail;
+
+		if (NULL == (mapping_local.index = snmpidx_strpool_acquire((const char *)mappings->values[i].second)))
+		{
+			snmpidx_strpool_release(mapping_local.value);
+			goto fail;
+		}
+
+		if (NULL == zbx_hashset_insert(&table->mappings, &mapping_local, sizeof(mapping_local)))
+		{
+			snmpidx_strpool_release(mapping_local.value);
+			snmpidx_strpool_release(mapping_local.index);
+			goto fail;
+		}
+	}
+
+	table->lastupdate = now;
+
+	return SUCCEED;
+fail:
+	snmpidx_table_remove(table);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes shared SNMP index cache                               *
+ *                                                                            *
+ * Parameters: cache_size - [IN] cache size, 0 disables the cache             *
+ *             error      - [OUT]                                             *
+ *                                                                            *
+ * Return value: SUCCEED - the cache was initialized successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_snmp_index_cache_init(zbx_uint64_t cache_size, char **error)
+{
+	int	ret = FAIL;
+
+	if (0 == cache_size)
+		return SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (SUCCEED != zbx_mutex_create(&snmpidx_lock, ZBX_MUTEX_SNMP_INDEX, error))
+		goto out;
+
+	if (SUCCEED != zbx_shmem_create(&snmpidx_mem, cache_size, "SNMP index cache size", "SNMPIndexCacheSize", 1,
+			error))
+	{
+		goto out;
+	}
+
+	if (NULL == (snmpidx_cache = (zbx_snmpidx_cache_t *)__snmpidx_shmem_malloc_func(NULL,
+			sizeof(zbx_snmpidx_cache_t))))
+	{
+		*error = zbx_strdup(*error, "cannot allocate SNMP index cache header");
+		goto out;
+	}
+
+	memset(snmpidx_cache, 0, sizeof(zbx_snmpidx_cache_t));
+
+	zbx_hashset_create_ext(&snmpidx_cache->tables, SNMPIDX_TABLES_INIT_SIZE,
+			snmpidx_table_hash_func, snmpidx_table_compare_func, NULL,
+			__snmpidx_shmem_malloc_func, __snmpidx_shmem_realloc_func, __snmpidx_shmem_free_func);
+
+	zbx_hashset_create_ext(&snmpidx_cache->strpool, SNMPIDX_STRPOOL_INIT_SIZE,
+			snmpidx_strpool_hash_func, snmpidx_strpool_compare_func, NULL,
+			__snmpidx_shmem_malloc_func, __snmpidx_shmem_realloc_func, __snmpidx_shmem_free_func);
+
+	if (NULL == snmpidx_cache->tables.slots || NULL == snmpidx_cache->strpool.slots)
+	{
+		*error = zbx_strdup(*error, "cannot allocate SNMP index cache data storage");
+		goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	if (SUCCEED != ret)
+		snmpidx_cache = NULL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: destroys shared SNMP index cache                                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_snmp_index_cache_destroy(void)
+{
+	if (NULL != snmpidx_mem)
+	{
+		zbx_shmem_destroy(snmpidx_mem);
+		snmpidx_mem = NULL;
+		zbx_mutex_destroy(&snmpidx_lock);
+	}
+
+	snmpidx_cache = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if shared SNMP index cache is used                         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_snmp_index_cache_enabled(void)
+{
+	return NULL != snmpidx_cache ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves index that matches value from cached index table        *
+ *                                                                            *
+ * Parameters: key       - [IN] index table identifier                        *
+ *             value     - [IN] value for which to look up index              *
+ *             idx       - [IN/OUT] destination pointer for                   *
+ *                                  heap-(re)allocated index                  *
+ *             idx_alloc - [IN/OUT] size of (re)allocated index               *
+ *                                                                            *
+ * Return value: SUCCEED - idx contains found index                           *
+ *               FAIL    - table is not cached, has expired or does not       *
+ *                         contain index matching value                       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_snmp_index_cache_get(const zbx_snmp_index_key_t *key, const char *value, char **idx, size_t *idx_alloc)
+{
+	zbx_snmpidx_table_t	*table, table_local;
+	zbx_snmpidx_mapping_t	*mapping, mapping_local;
+	size_t			idx_offset = 0;
+	int			ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() OID:'%s' value:'%s'", __func__, key->oid, value);
+
+	snmpidx_key_to_table(key, &table_local);
+	mapping_local.value = value;
+
+	/* statistics are updated also when looking up indexes, so lock cache exclusively */
+	LOCK_CACHE;
+
+	if (NULL == (table = (zbx_snmpidx_table_t *)zbx_hashset_search(&snmpidx_cache->tables, &table_local)))
+	{
+		snmpidx_cache->stats.misses++;
+		goto out;
+	}
+
+	if (table->lastupdate + SNMPIDX_TABLE_TTL <= time(NULL))
+	{
+		snmpidx_table_remove(table);
+		snmpidx_cache->stats.expired++;
+		snmpidx_cache->stats.misses++;
+		goto out;
+	}
+
+	if (NULL == (mapping = (zbx_snmpidx_mapping_t *)zbx_hashset_search(&table->mappings, &mapping_local)))
+	{
+		snmpidx_cache->stats.misses++;
+		goto out;
+	}
+
+	zbx_strcpy_alloc(idx, idx_alloc, &idx_offset, mapping->index);
+	snmpidx_cache->stats.hits++;
+
+	ret = SUCCEED;
+out:
+	UNLOCK_CACHE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s idx:'%s'", __func__, zbx_result_string(ret),
+			SUCCEED == ret ? *idx : "");
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stores walked index table in cache                                *
+ *                                                                            *
+ * Parameters: key      - [IN] index table identifier                         *
+ *             mappings - [IN] value (first), index (second) pairs            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_snmp_index_cache_set(const zbx_snmp_index_key_t *key, const zbx_vector_ptr_pair_t *mappings)
+{
+	time_t	now;
+	int	ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() OID:'%s' mappings:%d", __func__, key->oid, mappings->values_num);
+
+	now = time(NULL);
+
+	LOCK_CACHE;
+
+	if (SUCCEED != (ret = snmpidx_table_store(key, mappings, now)) && 0 != snmpidx_remove_expired(now))
+		ret = snmpidx_table_store(key, mappings, now);
+
+	if (SUCCEED == ret)
+		snmpidx_cache->stats.updates++;
+	else
+		snmpidx_cache->stats.low_memory++;
+
+	UNLOCK_CACHE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets shared SNMP index cache statistics                           *
+ *                                                                            *
+ * Parameters: stats - [OUT] cache statistics                                 *
+ *             mem   - [OUT] cache memory statistics, optional                *
+ *                                                                            *
+ * Return value: SUCCEED - the statistics were retrieved                      *
+ *               FAIL    - the cache is disabled                              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_snmp_index_cache_get_stats(zbx_snmp_index_cache_stats_t *stats, zbx_shmem_stats_t *mem)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_snmpidx_table_t	*table;
+
+	if (NULL == snmpidx_cache)
+		return FAIL;
+
+	LOCK_CACHE;
+
+	*stats = snmpidx_cache->stats;
+	stats->tables_num = (zbx_uint64_t)snmpidx_cache->tables.num_data;
+	stats->mappings_num = 0;
+
+	zbx_hashset_iter_reset(&snmpidx_cache->tables, &iter);
+	while (NULL != (table = (zbx_snmpidx_table_t *)zbx_hashset_iter_next(&iter)))
+		stats->mappings_num += (zbx_uint64_t)table->mappings.num_data;
+
+	if (NULL != mem)
+		zbx_shmem_get_stats(snmpidx_mem, mem);
+
+	UNLOCK_CACHE;
+
+	return SUCCEED;
+}
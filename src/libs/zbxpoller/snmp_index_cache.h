@@ -0,0 +1,35 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_SNMP_INDEX_CACHE_H
+#define ZABBIX_SNMP_INDEX_CACHE_H
+
+#include "zbxalgo.h"
+
+/* identifies index table of SNMP agent as seen by particular user */
+typedef struct
+{
+	const char	*addr;
+	unsigned short	port;
+	const char	*community_context;	/* community (SNMPv1 or v2c) or contextName (SNMPv3) */
+	const char	*security_name;		/* only SNMPv3, empty string in case of other versions */
+	const char	*oid;
+}
+zbx_snmp_index_key_t;
+
+int	zbx_snmp_index_cache_enabled(void);
+int	zbx_snmp_index_cache_get(const zbx_snmp_index_key_t *key, const char *value, char **idx, size_t *idx_alloc);
+void	zbx_snmp_index_cache_set(const zbx_snmp_index_key_t *key, const zbx_vector_ptr_pair_t *mappings);
+
+#endif
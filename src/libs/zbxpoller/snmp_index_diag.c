@@ -0,0 +1,93 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxpoller.h"
+#include "zbxdiag.h"
+#include "zbxalgo.h"
+#include "zbxtime.h"
+#include "zbxjson.h"
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add requested SNMP index cache diagnostic information to json     *
+ *          data                                                              *
+ *                                                                            *
+ * Parameters: jp    - [IN] the request                                       *
+ *             json  - [IN/OUT] the json to update                            *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the information was added successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Only processing time is reported if the shared SNMP index cache  *
+ *           is disabled.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_diag_add_snmpcache_info(const struct zbx_json_parse *jp, struct zbx_json *json, char **error)
+{
+	zbx_vector_diag_map_ptr_t	tops;
+	int				ret;
+	double				time1, time2, time_total = 0;
+	zbx_uint64_t			fields;
+	zbx_diag_map_t			field_map[] = {
+							{"", ZBX_DIAG_SNMPCACHE_SIMPLE},
+							{"stats", ZBX_DIAG_SNMPCACHE_INFO},
+							{"memory", ZBX_DIAG_SNMPCACHE_MEMORY},
+							{NULL, 0}
+						};
+
+	zbx_vector_diag_map_ptr_create(&tops);
+
+	if (SUCCEED == (ret = zbx_diag_parse_request(jp, field_map, &fields, &tops, error)))
+	{
+		zbx_json_addobject(json, ZBX_DIAG_SNMPCACHE);
+
+		if (0 != (fields & ZBX_DIAG_SNMPCACHE_SIMPLE))
+		{
+			zbx_snmp_index_cache_stats_t	stats;
+			zbx_shmem_stats_t		mem;
+			int				enabled;
+
+			time1 = zbx_time();
+			enabled = zbx_snmp_index_cache_get_stats(&stats, &mem);
+			time2 = zbx_time();
+			time_total += time2 - time1;
+
+			if (SUCCEED == enabled)
+			{
+				if (0 != (fields & ZBX_DIAG_SNMPCACHE_INFO))
+				{
+					zbx_json_adduint64(json, "tables", stats.tables_num);
+					zbx_json_adduint64(json, "mappings", stats.mappings_num);
+					zbx_json_adduint64(json, "hits", stats.hits);
+					zbx_json_adduint64(json, "misses", stats.misses);
+					zbx_json_adduint64(json, "expired", stats.expired);
+					zbx_json_adduint64(json, "updates", stats.updates);
+					zbx_json_adduint64(json, "low.memory", stats.low_memory);
+				}
+
+				if (0 != (fields & ZBX_DIAG_SNMPCACHE_MEMORY))
+					zbx_diag_add_mem_stats(json, "memory", &mem);
+			}
+		}
+
+		zbx_json_addfloat(json, "time", time_total);
+		zbx_json_close(json);
+	}
+
+	zbx_vector_diag_map_ptr_clear_ext(&tops, zbx_diag_map_free);
+	zbx_vector_diag_map_ptr_destroy(&tops);
+
+	return ret;
+}
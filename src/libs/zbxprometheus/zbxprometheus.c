@@ -170,6 +170,54 @@ static char	*str_loc_unquote_dyn(const char *src, const zbx_strloc_t *loc)
 	return str;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets interned copy of substring at the specified location         *
+ *                                                                            *
+ * Parameters: strings - [IN/OUT] the interned strings                        *
+ *             src     - [IN] the source string                               *
+ *             loc     - [IN] the substring location                          *
+ *                                                                            *
+ * Return value: The interned substring.                                      *
+ *                                                                            *
+ * Comments: Metric and label names repeat across rows, so the rows parsed    *
+ *           for cache share single copy of each name. The substring is       *
+ *           copied into stack buffer for lookup, memory is allocated only    *
+ *           for new names.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static char	*str_loc_intern(zbx_hashset_t *strings, const char *src, const zbx_strloc_t *loc)
+{
+	char	buffer[ZBX_KIBIBYTE], *str = buffer, **pstr;
+	size_t	len;
+
+	len = loc->r - loc->l + 1;
+
+	if (len >= sizeof(buffer))
+		str = (char *)zbx_malloc(NULL, len + 1);
+
+	memcpy(str, src + loc->l, len);
+	str[len] = '\0';
+
+	if (NULL == (pstr = (char **)zbx_hashset_search(strings, &str)))
+	{
+		char	*dup = (str == buffer ? zbx_strdup(NULL, str) : str);
+
+		pstr = (char **)zbx_hashset_insert(strings, &dup, sizeof(dup));
+	}
+	else if (str != buffer)
+		zbx_free(str);
+
+	return *pstr;
+}
+
+static void	prometheus_string_clear(void *d)
+{
+	char	**str = (char **)d;
+
+	zbx_free(*str);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: unescapes HELP hint                                               *
@@ -787,6 +835,22 @@ static void	prometheus_row_free(zbx_prometheus_row_t *row)
 	zbx_free(row);
 }
 
+static void	prometheus_label_free_interned(zbx_prometheus_label_t *label)
+{
+	zbx_free(label->value);
+	zbx_free(label);
+}
+
+/* frees row with interned metric and label names */
+static void	prometheus_row_free_interned(zbx_prometheus_row_t *row)
+{
+	zbx_free(row->value);
+	zbx_free(row->raw);
+	zbx_vector_prometheus_label_clear_ext(&row->labels, prometheus_label_free_interned);
+	zbx_vector_prometheus_label_destroy(&row->labels);
+	zbx_free(row);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: matches key,value against filter condition                        *
@@ -875,18 +939,19 @@ static int	condition_match_metric_value(const char *pattern, const char *value)
  *                                                                            *
  * Purpose: parses metric labels                                              *
  *                                                                            *
- * Parameters: data   - [IN] the metric data                                  *
- *             pos    - [IN] the starting position in metric data             *
- *             labels - [OUT] the parsed labels                               *
- *             loc    - [OUT] the location of label block                     *
- *             error  - [OUT] the error message                               *
+ * Parameters: data    - [IN] the metric data                                 *
+ *             pos     - [IN] the starting position in metric data            *
+ *             strings - [IN/OUT] the interned strings (optional)             *
+ *             labels  - [OUT] the parsed labels                              *
+ *             loc     - [OUT] the location of label block                    *
+ *             error   - [OUT] the error message                              *
  *                                                                            *
  * Return value: SUCCEED - the labels were parsed successfully                *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	prometheus_metric_parse_labels(const char *data, size_t pos, zbx_vector_prometheus_label_t *labels,
-		zbx_strloc_t *loc, char **error)
+static int	prometheus_metric_parse_labels(const char *data, size_t pos, zbx_hashset_t *strings,
+		zbx_vector_prometheus_label_t *labels, zbx_strloc_t *loc, char **error)
 {
 	zbx_strloc_t		loc_key, loc_value, loc_op;
 	zbx_prometheus_label_t	*label;
@@ -912,7 +977,12 @@ static int	prometheus_metric_parse_labels(const char *data, size_t pos, zbx_vect
 		}
 
 		label = (zbx_prometheus_label_t *)zbx_malloc(NULL, sizeof(zbx_prometheus_label_t));
-		label->name = str_loc_dup(data, &loc_key);
+
+		if (NULL != strings)
+			label->name = str_loc_intern(strings, data, &loc_key);
+		else
+			label->name = str_loc_dup(data, &loc_key);
+
 		label->value = str_loc_unquote_dyn(data, &loc_value);
 		zbx_vector_prometheus_label_append(labels, label);
 
@@ -942,6 +1012,7 @@ static int	prometheus_metric_parse_labels(const char *data, size_t pos, zbx_vect
  * Parameters: filter  - [IN] the prometheus filter                           *
  *             data    - [IN] the metric data                                 *
  *             pos     - [IN] the starting position in metric data            *
+ *             strings - [IN/OUT] the interned strings (optional)             *
  *             prow    - [OUT] the parsed row (NULL if did not match filter)  *
  *             loc_row - [OUT] the location of row in prometheus data         *
  *             error   - [OUT] the error message                              *
@@ -954,7 +1025,7 @@ static int	prometheus_metric_parse_labels(const char *data, size_t pos, zbx_vect
  *                                                                            *
  ******************************************************************************/
 static int	prometheus_parse_row(zbx_prometheus_filter_t *filter, const char *data, size_t pos,
-		zbx_prometheus_row_t **prow, zbx_strloc_t *loc_row, char **error)
+		zbx_hashset_t *strings, zbx_prometheus_row_t **prow, zbx_strloc_t *loc_row, char **error)
 {
 	zbx_strloc_t		loc;
 	zbx_prometheus_row_t	*row;
@@ -974,7 +1045,10 @@ static int	prometheus_parse_row(zbx_prometheus_filter_t *filter, const char *dat
 		goto out;
 	}
 
-	row->metric = str_loc_dup(data, &loc);
+	if (NULL != strings)
+		row->metric = str_loc_intern(strings, data, &loc);
+	else
+		row->metric = str_loc_dup(data, &loc);
 
 	if (NULL != filter->metric)
 	{
@@ -988,7 +1062,7 @@ static int	prometheus_parse_row(zbx_prometheus_filter_t *filter, const char *dat
 
 	if ('{' == data[pos])
 	{
-		if (SUCCEED != prometheus_metric_parse_labels(data, pos, &row->labels, &loc, error))
+		if (SUCCEED != prometheus_metric_parse_labels(data, pos, strings, &row->labels, &loc, error))
 			goto out;
 
 		for (i = 0; i < filter->labels.values_num; i++)
@@ -1057,7 +1131,11 @@ static int	prometheus_parse_row(zbx_prometheus_filter_t *filter, const char *dat
 out:
 	if (FAIL == ret)
 	{
-		prometheus_row_free(row);
+		if (NULL != strings)
+			prometheus_row_free_interned(row);
+		else
+			prometheus_row_free(row);
+
 		*prow = NULL;
 
 		/* match failure, return success with NULL row */
@@ -1292,6 +1370,7 @@ static int	prometheus_parse_hint(zbx_prometheus_filter_t *filter, const char *da
  *                                                                            *
  * Parameters: filter  - [IN] the prometheus filter                           *
  *             data    - [IN] the metric data                                 *
+ *             strings - [IN/OUT] the interned strings (optional)             *
  *             rows    - [OUT] the parsed rows                                *
  *             hints   - [OUT] the TYPE/HELP hint registry (optional)         *
  *             error   - [OUT] the error message                              *
@@ -1300,7 +1379,7 @@ static int	prometheus_parse_hint(zbx_prometheus_filter_t *filter, const char *da
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	prometheus_parse_rows(zbx_prometheus_filter_t *filter, const char *data,
+static int	prometheus_parse_rows(zbx_prometheus_filter_t *filter, const char *data, zbx_hashset_t *strings,
 		zbx_vector_prometheus_row_t *rows, zbx_hashset_t *hints, char **error)
 {
 	size_t			pos = 0;
@@ -1330,7 +1409,7 @@ static int	prometheus_parse_rows(zbx_prometheus_filter_t *filter, const char *da
 			continue;
 		}
 
-		if (SUCCEED != prometheus_parse_row(filter, data, pos, &row, &loc, &errmsg))
+		if (SUCCEED != prometheus_parse_row(filter, data, pos, strings, &row, &loc, &errmsg))
 			goto out;
 
 		if (NULL != row)
@@ -1624,6 +1703,45 @@ static void	prometheus_hint_clear(void *d)
 	zbx_free(hint->type);
 }
 
+static void	prometheus_index_clear(void *d)
+{
+	zbx_prometheus_index_t	*index = (zbx_prometheus_index_t *)d;
+
+	zbx_vector_prometheus_row_destroy(&index->rows);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: indexes cached rows by metric name                                *
+ *                                                                            *
+ * Parameters: prom - [IN/OUT] the prometheus cache                           *
+ *                                                                            *
+ * Comments: Metric names are interned, so rows are indexed by metric name    *
+ *           pointer.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	prometheus_index_metrics(zbx_prometheus_t *prom)
+{
+	int			i;
+	zbx_prometheus_index_t	*index, index_local;
+
+	for (i = 0; i < prom->rows.values_num; i++)
+	{
+		zbx_prometheus_row_t	*row = prom->rows.values[i];
+
+		index_local.value = row->metric;
+
+		if (NULL == (index = (zbx_prometheus_index_t *)zbx_hashset_search(&prom->metrics, &index_local)))
+		{
+			index = (zbx_prometheus_index_t *)zbx_hashset_insert(&prom->metrics, &index_local,
+					sizeof(index_local));
+			zbx_vector_prometheus_row_create(&index->rows);
+		}
+
+		zbx_vector_prometheus_row_append(&index->rows, row);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: parse prometheus input and initialize cache                       *
@@ -1646,6 +1764,12 @@ int	zbx_prometheus_init(zbx_prometheus_t *prom, const char *data, char **error)
 
 	zbx_hashset_create_ext(&prom->hints, 100, prometheus_hint_hash, prometheus_hint_compare, prometheus_hint_clear,
 			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_hashset_create_ext(&prom->strings, 100, ZBX_DEFAULT_STRING_PTR_HASH_FUNC, ZBX_DEFAULT_STR_COMPARE_FUNC,
+			prometheus_string_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_hashset_create_ext(&prom->metrics, 100, ZBX_DEFAULT_PTR_HASH_FUNC, ZBX_DEFAULT_PTR_COMPARE_FUNC,
+			prometheus_index_clear, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
 
 	if (0 != pthread_mutex_init(&prom->index_lock, NULL))
 	{
@@ -1656,9 +1780,11 @@ int	zbx_prometheus_init(zbx_prometheus_t *prom, const char *data, char **error)
 	if (SUCCEED != prometheus_filter_init(&filter, NULL, error))
 		goto out;
 
-	if (FAIL == prometheus_parse_rows(&filter, data, &prom->rows, &prom->hints, error))
+	if (FAIL == prometheus_parse_rows(&filter, data, &prom->strings, &prom->rows, &prom->hints, error))
 		goto out;
 
+	prometheus_index_metrics(prom);
+
 	ret = SUCCEED;
 out:
 	prometheus_filter_clear(&filter);
@@ -1698,9 +1824,13 @@ void	zbx_prometheus_clear(zbx_prometheus_t *prom)
 	zbx_vector_prometheus_label_index_clear_ext(&prom->indexes, prometheus_label_index_free);
 	zbx_vector_prometheus_label_index_destroy(&prom->indexes);
 
-	zbx_vector_prometheus_row_clear_ext(&prom->rows, prometheus_row_free);
+	zbx_hashset_destroy(&prom->metrics);
+
+	zbx_vector_prometheus_row_clear_ext(&prom->rows, prometheus_row_free_interned);
 	zbx_vector_prometheus_row_destroy(&prom->rows);
 
+	zbx_hashset_destroy(&prom->strings);
+
 	pthread_mutex_destroy(&prom->index_lock);
 }
 
@@ -1758,6 +1888,27 @@ static void	prometheus_add_index(zbx_prometheus_t *prom, zbx_prometheus_label_in
 	prometheus_unlock(prom);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get interned copy of the specified string                         *
+ *                                                                            *
+ * Parameters: prom - [IN] the prometheus cache                               *
+ *             str  - [IN] the string                                         *
+ *                                                                            *
+ * Return value: The interned string or NULL if none of the rows has metric   *
+ *               or label name matching the specified string.                 *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*prometheus_get_interned(zbx_prometheus_t *prom, const char *str)
+{
+	char	**pstr;
+
+	if (NULL == (pstr = (char **)zbx_hashset_search(&prom->strings, &str)))
+		return NULL;
+
+	return *pstr;
+}
+
 static zbx_hash_t	prometheus_index_hash_func(const void *d)
 {
 	const zbx_prometheus_index_t	*index = (const zbx_prometheus_index_t *)d;
@@ -1778,7 +1929,7 @@ static int	prometheus_index_compare_func(const void *d1, const void *d2)
  * Purpose: get label from row by the specified name                          *
  *                                                                            *
  * Parameters: row  - [IN] the prometheus row                                 *
- *             name - [IN] the label name                                     *
+ *             name - [IN] the interned label name                            *
  *                                                                            *
  * Return value: The prometheus row label or NULL if no labels matched the    *
  *               specified name.                                              *
@@ -1792,7 +1943,7 @@ static zbx_prometheus_label_t	*prometheus_get_row_label(zbx_prometheus_row_t *ro
 	{
 		zbx_prometheus_label_t	*label = row->labels.values[i];
 
-		if (0 == strcmp(label->name, name))
+		if (label->name == name)
 			return label;
 	}
 
@@ -1821,7 +1972,8 @@ static int	prometheus_get_indexed_rows_by_label(zbx_prometheus_t *prom, zbx_prom
 		zbx_vector_prometheus_row_t **rows)
 {
 	int				i;
-	zbx_prometheus_condition_t	*condition;
+	const char			*name;
+	zbx_prometheus_condition_t	*condition = NULL;
 	zbx_prometheus_label_index_t	*label_index;
 	zbx_prometheus_index_t		*index, index_local;
 
@@ -1836,6 +1988,13 @@ static int	prometheus_get_indexed_rows_by_label(zbx_prometheus_t *prom, zbx_prom
 	if (i == filter->labels.values_num)
 		return FAIL;
 
+	/* label names of all rows are interned, unknown label cannot match any row */
+	if (NULL == (name = prometheus_get_interned(prom, condition->key)))
+	{
+		*rows = NULL;
+		return SUCCEED;
+	}
+
 	if (NULL == (label_index = prometheus_get_index(prom, condition->key)))
 	{
 		label_index = (zbx_prometheus_label_index_t *)zbx_malloc(NULL, sizeof(zbx_prometheus_label_index_t));
@@ -1847,21 +2006,22 @@ static int	prometheus_get_indexed_rows_by_label(zbx_prometheus_t *prom, zbx_prom
 		{
 			zbx_prometheus_row_t	*row = prom->rows.values[i];
 			zbx_prometheus_label_t	*label;
+			zbx_prometheus_index_t	*row_index, row_index_local;
 
-			if (NULL == (label = prometheus_get_row_label(row, label_index->label)))
+			if (NULL == (label = prometheus_get_row_label(row, name)))
 				continue;
 
-			index_local.value = label->value;
+			row_index_local.value = label->value;
 
-			if (NULL == (index = (zbx_prometheus_index_t *)zbx_hashset_search(&label_index->index,
-					&index_local)))
+			if (NULL == (row_index = (zbx_prometheus_index_t *)zbx_hashset_search(&label_index->index,
+					&row_index_local)))
 			{
-				index = (zbx_prometheus_index_t *)zbx_hashset_insert(&label_index->index, &index_local,
-						sizeof(index_local));
-				zbx_vector_prometheus_row_create(&index->rows);
+				row_index = (zbx_prometheus_index_t *)zbx_hashset_insert(&label_index->index,
+						&row_index_local, sizeof(row_index_local));
+				zbx_vector_prometheus_row_create(&row_index->rows);
 			}
 
-			zbx_vector_prometheus_row_append(&index->rows, row);
+			zbx_vector_prometheus_row_append(&row_index->rows, row);
 		}
 
 		prometheus_add_index(prom, label_index);
@@ -1877,6 +2037,81 @@ static int	prometheus_get_indexed_rows_by_label(zbx_prometheus_t *prom, zbx_prom
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get rows matching filter metric name                              *
+ *                                                                            *
+ * Parameters: prom   - [IN] the prometheus cache                             *
+ *             filter - [IN] the filter                                       *
+ *             rows   - [OUT] the rows with matching metric name or NULL if   *
+ *                           there are no matching rows                       *
+ *                                                                            *
+ * Return value: SUCCEED - the matched rows were returned successfully        *
+ *               FAIL    - filter does not contain metric name condition      *
+ *                                                                            *
+ ******************************************************************************/
+static int	prometheus_get_indexed_rows_by_metric(zbx_prometheus_t *prom, zbx_prometheus_filter_t *filter,
+		zbx_vector_prometheus_row_t **rows)
+{
+	zbx_prometheus_index_t	*index, index_local;
+
+	if (NULL == filter->metric || ZBX_PROMETHEUS_CONDITION_OP_EQUAL != filter->metric->op)
+		return FAIL;
+
+	if (NULL == (index_local.value = (char *)prometheus_get_interned(prom, filter->metric->pattern)) ||
+			NULL == (index = (zbx_prometheus_index_t *)zbx_hashset_search(&prom->metrics, &index_local)))
+	{
+		*rows = NULL;
+	}
+	else
+		*rows = &index->rows;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get cached rows to be matched against filter                      *
+ *                                                                            *
+ * Parameters: prom   - [IN] the prometheus cache                             *
+ *             filter - [IN] the filter                                       *
+ *                                                                            *
+ * Return value: The indexed rows containing all rows that can match filter,  *
+ *               all cached rows if filter conditions are not indexed or NULL *
+ *               if no rows can match filter.                                 *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vector_prometheus_row_t	*prometheus_get_filter_rows(zbx_prometheus_t *prom,
+		zbx_prometheus_filter_t *filter)
+{
+	zbx_vector_prometheus_row_t	*rows = &prom->rows, *indexed_rows;
+
+	if (SUCCEED == prometheus_get_indexed_rows_by_metric(prom, filter, &indexed_rows))
+	{
+		if (NULL == indexed_rows)
+			return NULL;
+
+		rows = indexed_rows;
+	}
+
+/* minimum number of rows worth to be indexed by label */
+#define ZBX_PROMETHEUS_INDEX_MIN_ROWS	100
+
+	if (ZBX_PROMETHEUS_INDEX_MIN_ROWS < rows->values_num &&
+			SUCCEED == prometheus_get_indexed_rows_by_label(prom, filter, &indexed_rows))
+	{
+		if (NULL == indexed_rows)
+			return NULL;
+
+		if (indexed_rows->values_num < rows->values_num)
+			rows = indexed_rows;
+	}
+
+#undef ZBX_PROMETHEUS_INDEX_MIN_ROWS
+
+	return rows;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: validate prometheus pattern request and output                    *
@@ -1942,15 +2177,16 @@ int	zbx_prometheus_pattern_ex(zbx_prometheus_t *prom, const char *filter_data, c
 		goto out;
 	}
 
-	zbx_vector_prometheus_row_create(&rows);
-
 	if (SUCCEED != prometheus_validate_request(request, output, error))
-		return FAIL;
+	{
+		prometheus_filter_clear(&filter);
+		goto out;
+	}
 
-	if (SUCCEED != prometheus_get_indexed_rows_by_label(prom, &filter, &prows) || NULL == prows)
-		prows = &prom->rows;
+	zbx_vector_prometheus_row_create(&rows);
 
-	prometheus_filter_rows(prows, &filter, &rows);
+	if (NULL != (prows = prometheus_get_filter_rows(prom, &filter)))
+		prometheus_filter_rows(prows, &filter, &rows);
 
 	if (FAIL == (ret = prometheus_query_rows(&rows, request, output, value, &errmsg)))
 	{
@@ -2003,7 +2239,7 @@ int	zbx_prometheus_pattern(const char *data, const char *filter_data, const char
 	if (SUCCEED != prometheus_validate_request(request, output, error))
 		return FAIL;
 
-	if (FAIL == prometheus_parse_rows(&filter, data, &rows, NULL, error))
+	if (FAIL == prometheus_parse_rows(&filter, data, NULL, &rows, NULL, error))
 		goto cleanup;
 
 	if (FAIL == prometheus_query_rows(&rows, request, output, value, &errmsg))
@@ -2103,7 +2339,7 @@ static void	prometheus_to_json(zbx_vector_prometheus_row_t *rows, zbx_hashset_t
  ******************************************************************************/
 int	zbx_prometheus_to_json_ex(zbx_prometheus_t *prom, const char *filter_data, char **value, char **error)
 {
-	zbx_vector_prometheus_row_t	rows;
+	zbx_vector_prometheus_row_t	rows, *prows;
 	zbx_prometheus_filter_t		filter;
 	char				*errmsg = NULL;
 	int				ret = FAIL;
@@ -2119,7 +2355,8 @@ int	zbx_prometheus_to_json_ex(zbx_prometheus_t *prom, const char *filter_data, c
 
 	zbx_vector_prometheus_row_create(&rows);
 
-	prometheus_filter_rows(&prom->rows, &filter, &rows);
+	if (NULL != (prows = prometheus_get_filter_rows(prom, &filter)))
+		prometheus_filter_rows(prows, &filter, &rows);
 
 	prometheus_to_json(&rows, &prom->hints, value);
 	zbx_vector_prometheus_row_destroy(&rows);
@@ -2165,7 +2402,7 @@ int	zbx_prometheus_to_json(const char *data, const char *filter_data, char **val
 	zbx_hashset_create_ext(&hints, 100, prometheus_hint_hash, prometheus_hint_compare, prometheus_hint_clear,
 			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
 
-	if (FAIL != (ret = prometheus_parse_rows(&filter, data, &rows, &hints, error)))
+	if (FAIL != (ret = prometheus_parse_rows(&filter, data, NULL, &rows, &hints, error)))
 		prometheus_to_json(&rows, &hints, value);
 
 	zbx_hashset_destroy(&hints);
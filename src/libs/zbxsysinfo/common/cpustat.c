@@ -36,6 +36,17 @@ static zbx_mutex_t	cpustats_lock = ZBX_MUTEX_NULL;
 #	define UNLOCK_CPUSTATS
 #endif
 
+#if defined(HAVE_PROC_STAT)
+#define ZBX_CGROUP_FS		"/sys/fs/cgroup"
+#define ZBX_CGROUP_FS_HYBRID	"/sys/fs/cgroup/unified"	/* cgroup v2 mount point in hybrid mode */
+
+/* buffers are kept between collector cycles to avoid allocations */
+static char	*proc_stat_buf = NULL, *cgroup_buf = NULL;
+static size_t	proc_stat_buf_alloc = 0, cgroup_buf_alloc = 0;
+
+static char	*cgroup_cpu_stat = NULL, *cgroup_cpu_max = NULL;
+#endif
+
 #ifdef HAVE_KSTAT_H
 static kstat_ctl_t	*kc = NULL;
 static kid_t		kc_id = 0;
@@ -114,6 +125,151 @@ static int	refresh_kstat(ZBX_CPUS_STAT_DATA *pcpus)
 }
 #endif
 
+#if defined(HAVE_PROC_STAT)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads whole file into buffer which is reused between calls        *
+ *                                                                            *
+ * Parameters: filename  - [IN]                                               *
+ *             buf       - [IN/OUT] buffer, reallocated if too small          *
+ *             buf_alloc - [IN/OUT] allocated buffer size                     *
+ *                                                                            *
+ * Return value: SUCCEED - file contents are read into zero terminated buffer *
+ *               FAIL    - cannot read the file                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	read_stat_file(const char *filename, char **buf, size_t *buf_alloc)
+{
+	int	fd;
+	size_t	offset = 0;
+	ssize_t	n;
+
+	if (-1 == (fd = open(filename, O_RDONLY)))
+		return FAIL;
+
+	if (0 == *buf_alloc)
+	{
+		*buf_alloc = 8 * ZBX_KIBIBYTE;
+		*buf = (char *)zbx_malloc(*buf, *buf_alloc);
+	}
+
+	while (1)
+	{
+		if (offset + 1 == *buf_alloc)
+		{
+			*buf_alloc *= 2;
+			*buf = (char *)zbx_realloc(*buf, *buf_alloc);
+		}
+
+		if (0 >= (n = read(fd, *buf + offset, *buf_alloc - offset - 1)))
+			break;
+
+		offset += (size_t)n;
+	}
+
+	close(fd);
+
+	if (-1 == n)
+		return FAIL;
+
+	(*buf)[offset] = '\0';
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses unsigned decimal number skipping leading spaces            *
+ *                                                                            *
+ * Return value: pointer to the character following the number or NULL if    *
+ *               there is no number                                           *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*parse_stat_uint64(const char *ptr, zbx_uint64_t *value)
+{
+	zbx_uint64_t	num = 0;
+
+	while (' ' == *ptr)
+		ptr++;
+
+	if ('0' > *ptr || '9' < *ptr)
+		return NULL;
+
+	do
+	{
+		num = num * 10 + (zbx_uint64_t)(*ptr - '0');
+	}
+	while ('0' <= *++ptr && '9' >= *ptr);
+
+	*value = num;
+
+	return ptr;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds cgroup v2 statistics files of the control group the agent   *
+ *          runs in                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	init_cgroup_cpu_collector(ZBX_CGROUP_CPU_STAT_DATA *cgroup)
+{
+	char		*line, *path, *end;
+	const char	*mount_point;
+
+	cgroup->available = 0;
+
+	if (0 == access(ZBX_CGROUP_FS "/cgroup.controllers", F_OK))
+		mount_point = ZBX_CGROUP_FS;
+	else if (0 == access(ZBX_CGROUP_FS_HYBRID "/cgroup.controllers", F_OK))
+		mount_point = ZBX_CGROUP_FS_HYBRID;
+	else
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cgroup v2 hierarchy is not mounted, cgroup CPU statistics are not"
+				" available");
+		return;
+	}
+
+	if (SUCCEED != read_stat_file("/proc/self/cgroup", &cgroup_buf, &cgroup_buf_alloc))
+		return;
+
+	/* cgroup v2 hierarchy has the only entry "0::<path>" */
+	for (line = cgroup_buf; NULL != line; line = (NULL != end ? end + 1 : NULL))
+	{
+		if (NULL != (end = strchr(line, '\n')))
+			*end = '\0';
+
+		if (0 == strncmp(line, "0::/", ZBX_CONST_STRLEN("0::/")))
+			break;
+	}
+
+	if (NULL == line)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cgroup v2 hierarchy is not used, cgroup CPU statistics are not available");
+		return;
+	}
+
+	path = line + ZBX_CONST_STRLEN("0::");
+
+	if ('\0' == path[1])
+		path++;		/* root or namespaced group */
+
+	cgroup_cpu_stat = zbx_dsprintf(cgroup_cpu_stat, "%s%s/cpu.stat", mount_point, path);
+	cgroup_cpu_max = zbx_dsprintf(cgroup_cpu_max, "%s%s/cpu.max", mount_point, path);
+
+	if (0 != access(cgroup_cpu_stat, R_OK))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot access \"%s\": %s", cgroup_cpu_stat, zbx_strerror(errno));
+		zbx_free(cgroup_cpu_stat);
+		zbx_free(cgroup_cpu_max);
+		return;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "collecting cgroup CPU statistics from \"%s\"", cgroup_cpu_stat);
+	cgroup->available = 1;
+}
+#endif
+
 int	init_cpu_collector(ZBX_CPUS_STAT_DATA *pcpus)
 {
 	char				*error = NULL;
@@ -284,6 +440,9 @@ clean:
 	}
 #endif	/* HAVE_KSTAT_H */
 
+#if defined(HAVE_PROC_STAT)
+	init_cgroup_cpu_collector(&pcpus->cgroup);
+#endif
 	ret = SUCCEED;
 #endif	/* _WINDOWS */
 
@@ -313,6 +472,14 @@ void	free_cpu_collector(ZBX_CPUS_STAT_DATA *pcpus)
 #ifdef HAVE_KSTAT_H
 	kstat_close(kc);
 	zbx_free(ksp);
+#endif
+#if defined(HAVE_PROC_STAT)
+	zbx_free(proc_stat_buf);
+	zbx_free(cgroup_buf);
+	proc_stat_buf_alloc = 0;
+	cgroup_buf_alloc = 0;
+	zbx_free(cgroup_cpu_stat);
+	zbx_free(cgroup_cpu_max);
 #endif
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -346,12 +513,10 @@ static int	get_cpu_perf_counter_status(zbx_perf_counter_status_t pc_status)
 	return ZBX_CPU_STATUS_OFFLINE;
 }
 #else	/* not _WINDOWS */
-static void	update_cpu_counters(ZBX_SINGLE_CPU_STAT_DATA *cpu, zbx_uint64_t *counter)
+static void	store_cpu_counters(ZBX_SINGLE_CPU_STAT_DATA *cpu, zbx_uint64_t *counter)
 {
 	int	i, index;
 
-	LOCK_CPUSTATS;
-
 	if (ZBX_MAX_COLLECTOR_HISTORY <= (index = cpu->h_first + cpu->h_count))
 		index -= ZBX_MAX_COLLECTOR_HISTORY;
 
@@ -369,10 +534,92 @@ static void	update_cpu_counters(ZBX_SINGLE_CPU_STAT_DATA *cpu, zbx_uint64_t *cou
 	}
 	else
 		cpu->h_status[index] = SYSINFO_RET_FAIL;
+}
 
+static void	update_cpu_counters(ZBX_SINGLE_CPU_STAT_DATA *cpu, zbx_uint64_t *counter)
+{
+	LOCK_CPUSTATS;
+	store_cpu_counters(cpu, counter);
 	UNLOCK_CPUSTATS;
 }
 
+#if defined(HAVE_PROC_STAT)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: collects CPU usage of the control group the agent runs in         *
+ *                                                                            *
+ * Parameters: cgroup    - [IN/OUT] cgroup CPU statistics history             *
+ *             cpu_count - [IN] number of CPUs, used as group limit if it has *
+ *                              no CPU bandwidth limit                        *
+ *                                                                            *
+ * Comments: must be called with CPU statistics locked                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	update_cgroup_cpustats(ZBX_CGROUP_CPU_STAT_DATA *cgroup, int cpu_count)
+{
+	zbx_uint64_t	counter[ZBX_CGROUP_CPU_COUNT], value, period;
+	const char	*ptr;
+	struct timespec	ts;
+	int		i, index, found = 0;
+
+	memset(counter, 0, sizeof(counter));
+
+	if (SUCCEED == read_stat_file(cgroup_cpu_stat, &cgroup_buf, &cgroup_buf_alloc) &&
+			0 == clock_gettime(CLOCK_MONOTONIC, &ts))
+	{
+		counter[ZBX_CGROUP_CPU_CLOCK] = (zbx_uint64_t)ts.tv_sec * 1000000 + (zbx_uint64_t)ts.tv_nsec / 1000;
+		counter[ZBX_CGROUP_CPU_LIMIT] = (zbx_uint64_t)cpu_count * 1000000;
+
+		for (ptr = cgroup_buf; '\0' != *ptr; ptr++)
+		{
+			const char	*name = ptr;
+
+			if (NULL == (ptr = strchr(name, ' ')) || NULL == (ptr = parse_stat_uint64(ptr, &value)))
+				break;
+
+			if (0 == strncmp(name, "usage_usec ", ZBX_CONST_STRLEN("usage_usec ")))
+			{
+				counter[ZBX_CGROUP_CPU_USAGE] = value;
+				found = 1;
+			}
+			else if (0 == strncmp(name, "user_usec ", ZBX_CONST_STRLEN("user_usec ")))
+				counter[ZBX_CGROUP_CPU_USER] = value;
+			else if (0 == strncmp(name, "system_usec ", ZBX_CONST_STRLEN("system_usec ")))
+				counter[ZBX_CGROUP_CPU_SYSTEM] = value;
+			else if (0 == strncmp(name, "nr_periods ", ZBX_CONST_STRLEN("nr_periods ")))
+				counter[ZBX_CGROUP_CPU_PERIODS] = value;
+			else if (0 == strncmp(name, "nr_throttled ", ZBX_CONST_STRLEN("nr_throttled ")))
+				counter[ZBX_CGROUP_CPU_THROTTLED] = value;
+
+			if (NULL == (ptr = strchr(ptr, '\n')))
+				break;
+		}
+
+		/* "cpu.max" contains "<quota> <period>" or "max <period>", it is missing for root group */
+		if (NULL != cgroup_cpu_max && SUCCEED == read_stat_file(cgroup_cpu_max, &cgroup_buf,
+				&cgroup_buf_alloc) && NULL != (ptr = parse_stat_uint64(cgroup_buf, &value)) &&
+				NULL != parse_stat_uint64(ptr, &period) && 0 != period)
+		{
+			if (value * 1000000 / period < counter[ZBX_CGROUP_CPU_LIMIT])
+				counter[ZBX_CGROUP_CPU_LIMIT] = value * 1000000 / period;
+		}
+	}
+
+	if (ZBX_MAX_COLLECTOR_HISTORY <= (index = cgroup->h_first + cgroup->h_count))
+		index -= ZBX_MAX_COLLECTOR_HISTORY;
+
+	if (ZBX_MAX_COLLECTOR_HISTORY > cgroup->h_count)
+		cgroup->h_count++;
+	else if (ZBX_MAX_COLLECTOR_HISTORY == ++cgroup->h_first)
+		cgroup->h_first = 0;
+
+	for (i = 0; i < ZBX_CGROUP_CPU_COUNT; i++)
+		cgroup->h_counter[i][index] = counter[i];
+
+	cgroup->h_status[index] = (0 != found ? SYSINFO_RET_OK : SYSINFO_RET_FAIL);
+}
+#endif
+
 static void	update_cpustats(ZBX_CPUS_STAT_DATA *pcpus)
 {
 	zbx_uint64_t	counter[ZBX_CPU_STATE_COUNT];
@@ -384,68 +631,78 @@ static void	update_cpustats(ZBX_CPUS_STAT_DATA *pcpus)
 		update_cpu_counters(&pcpus->cpu[idx_local], NULL)
 
 #if defined(HAVE_PROC_STAT)
-	int		idx;
-	FILE		*file;
-	char		line[1024];
-	unsigned char	*cpu_status = NULL;
-	const char	*filename = "/proc/stat";
-
-	if (NULL == (file = fopen(filename, "r")))
+	/* order of the CPU states in "/proc/stat" */
+	static const int	proc_stat_states[ZBX_CPU_STATE_COUNT] = {ZBX_CPU_STATE_USER, ZBX_CPU_STATE_NICE,
+					ZBX_CPU_STATE_SYSTEM, ZBX_CPU_STATE_IDLE, ZBX_CPU_STATE_IOWAIT,
+					ZBX_CPU_STATE_INTERRUPT, ZBX_CPU_STATE_SOFTIRQ, ZBX_CPU_STATE_STEAL,
+					ZBX_CPU_STATE_GCPU, ZBX_CPU_STATE_GNICE};
+	int			idx, next_idx = 0;
+	const char		*ptr, *line;
+
+	if (SUCCEED != read_stat_file("/proc/stat", &proc_stat_buf, &proc_stat_buf_alloc))
 	{
-		zbx_error("cannot open [%s]: %s", filename, zbx_strerror(errno));
+		zbx_error("cannot read [/proc/stat]: %s", zbx_strerror(errno));
 		ZBX_SET_CPUS_NOTSUPPORTED();
 		goto exit;
 	}
 
-	cpu_status = (unsigned char *)zbx_malloc(cpu_status, sizeof(unsigned char) * (pcpus->count + 1));
-
-	for (idx = 0; idx <= pcpus->count; idx++)
-		cpu_status[idx] = SYSINFO_RET_FAIL;
+	LOCK_CPUSTATS;
 
-	while (NULL != fgets(line, sizeof(line), file))
+	/* "cpu" lines come first and in the order of CPU numbers, the other lines are skipped */
+	for (line = proc_stat_buf; 0 == strncmp(line, "cpu", 3); line = ptr + 1)
 	{
-		if (0 != strncmp(line, "cpu", 3))
-			continue;
-
-		if ('0' <= line[3] && line[3] <= '9')
+		if (' ' == line[3])
 		{
-			idx = atoi(line + 3) + 1;
-			if (1 > idx || idx > pcpus->count)
-				continue;
-		}
-		else if (' ' == line[3])
 			idx = 0;
+			ptr = line + 3;
+		}
 		else
-			continue;
+		{
+			zbx_uint64_t	cpu_num;
 
-		memset(counter, 0, sizeof(counter));
+			if (NULL == (ptr = parse_stat_uint64(line + 3, &cpu_num)) ||
+					(zbx_uint64_t)pcpus->count <= cpu_num)
+			{
+				idx = -1;
+			}
+			else
+				idx = (int)cpu_num + 1;
+		}
 
-		sscanf(line, "%*s " ZBX_FS_UI64 " " ZBX_FS_UI64 " " ZBX_FS_UI64 " " ZBX_FS_UI64
-				" " ZBX_FS_UI64 " " ZBX_FS_UI64 " " ZBX_FS_UI64 " " ZBX_FS_UI64
-				" " ZBX_FS_UI64 " " ZBX_FS_UI64,
-				&counter[ZBX_CPU_STATE_USER], &counter[ZBX_CPU_STATE_NICE],
-				&counter[ZBX_CPU_STATE_SYSTEM], &counter[ZBX_CPU_STATE_IDLE],
-				&counter[ZBX_CPU_STATE_IOWAIT], &counter[ZBX_CPU_STATE_INTERRUPT],
-				&counter[ZBX_CPU_STATE_SOFTIRQ], &counter[ZBX_CPU_STATE_STEAL],
-				&counter[ZBX_CPU_STATE_GCPU], &counter[ZBX_CPU_STATE_GNICE]);
+		if (next_idx <= idx)
+		{
+			memset(counter, 0, sizeof(counter));
 
-		/* Linux includes guest times in user and nice times */
-		counter[ZBX_CPU_STATE_USER] -= counter[ZBX_CPU_STATE_GCPU];
-		counter[ZBX_CPU_STATE_NICE] -= counter[ZBX_CPU_STATE_GNICE];
+			/* older kernels do not report some of the states */
+			for (int i = 0; i < ZBX_CPU_STATE_COUNT && NULL != ptr; i++)
+			{
+				if (NULL != (ptr = parse_stat_uint64(ptr, &counter[proc_stat_states[i]])))
+					line = ptr;
+			}
 
-		update_cpu_counters(&pcpus->cpu[idx], counter);
-		cpu_status[idx] = SYSINFO_RET_OK;
-	}
-	zbx_fclose(file);
+			/* Linux includes guest times in user and nice times */
+			counter[ZBX_CPU_STATE_USER] -= counter[ZBX_CPU_STATE_GCPU];
+			counter[ZBX_CPU_STATE_NICE] -= counter[ZBX_CPU_STATE_GNICE];
 
-	for (idx = 0; idx <= pcpus->count; idx++)
-	{
-		if (SYSINFO_RET_FAIL == cpu_status[idx])
-			update_cpu_counters(&pcpus->cpu[idx], NULL);
+			/* offline CPUs are not listed */
+			for (; next_idx < idx; next_idx++)
+				store_cpu_counters(&pcpus->cpu[next_idx], NULL);
+
+			store_cpu_counters(&pcpus->cpu[idx], counter);
+			next_idx = idx + 1;
+		}
+
+		if (NULL == (ptr = strchr(line, '\n')))
+			break;
 	}
 
-	zbx_free(cpu_status);
+	for (; next_idx <= pcpus->count; next_idx++)
+		store_cpu_counters(&pcpus->cpu[next_idx], NULL);
 
+	if (0 != pcpus->cgroup.available)
+		update_cgroup_cpustats(&pcpus->cgroup, pcpus->count);
+
+	UNLOCK_CPUSTATS;
 #elif defined(HAVE_SYS_PSTAT_H)
 	struct pst_dynamic	psd;
 	struct pst_processor	psp;
@@ -1055,6 +1312,13 @@ void	collect_cpustat_physical(ZBX_CPUS_UTIL_DATA_AIX *cpus_phys_util)
 
 static ZBX_SINGLE_CPU_STAT_DATA	*get_cpustat_by_num(ZBX_CPUS_STAT_DATA *pcpus, int cpu_num)
 {
+	/* except for Solaris CPU is stored at index of its number + 1 */
+	if (ZBX_CPUNUM_ALL == cpu_num)
+		return &pcpus->cpu[0];
+
+	if (0 <= cpu_num && cpu_num < pcpus->count && pcpus->cpu[cpu_num + 1].cpu_num == cpu_num)
+		return &pcpus->cpu[cpu_num + 1];
+
 	for (int idx = 0; idx <= pcpus->count; idx++)
 	{
 		if (pcpus->cpu[idx].cpu_num == cpu_num)
@@ -1154,6 +1418,110 @@ int	get_cpustat(AGENT_RESULT *result, int cpu_num, int state, int mode)
 	return SYSINFO_RET_OK;
 }
 
+#if defined(HAVE_PROC_STAT)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets CPU utilization of the control group the agent runs in       *
+ *                                                                            *
+ * Parameters: result - [OUT]                                                 *
+ *             state  - [IN] ZBX_CGROUP_CPU_USAGE, ZBX_CGROUP_CPU_USER,       *
+ *                           ZBX_CGROUP_CPU_SYSTEM - percentage of CPU time   *
+ *                           available to the group;                          *
+ *                           ZBX_CGROUP_CPU_THROTTLED - percentage of         *
+ *                           throttled enforcement periods                    *
+ *             mode   - [IN] ZBX_AVG1, ZBX_AVG5 or ZBX_AVG15                  *
+ *                                                                            *
+ ******************************************************************************/
+int	get_cgroup_cpustat(AGENT_RESULT *result, int state, int mode)
+{
+	int				time, idx_curr, idx_base;
+	zbx_uint64_t			counter, total;
+	double				value;
+	ZBX_CGROUP_CPU_STAT_DATA	*cgroup;
+
+	switch (mode)
+	{
+		case ZBX_AVG1:
+			time = SEC_PER_MIN;
+			break;
+		case ZBX_AVG5:
+			time = 5 * SEC_PER_MIN;
+			break;
+		case ZBX_AVG15:
+			time = 15 * SEC_PER_MIN;
+			break;
+		default:
+			return SYSINFO_RET_FAIL;
+	}
+
+	if (0 == cpu_collector_started())
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Collector is not started."));
+		return SYSINFO_RET_FAIL;
+	}
+
+	cgroup = &(get_collector())->cpus.cgroup;
+
+	if (0 == cgroup->available)
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Control group v2 CPU statistics are not available."));
+		return SYSINFO_RET_FAIL;
+	}
+
+	LOCK_CPUSTATS;
+
+	if (2 > cgroup->h_count)
+	{
+		UNLOCK_CPUSTATS;
+		SET_DBL_RESULT(result, 0);
+		return SYSINFO_RET_OK;
+	}
+
+	if (ZBX_MAX_COLLECTOR_HISTORY <= (idx_curr = (cgroup->h_first + cgroup->h_count - 1)))
+		idx_curr -= ZBX_MAX_COLLECTOR_HISTORY;
+
+	if (SYSINFO_RET_FAIL == cgroup->h_status[idx_curr])
+	{
+		UNLOCK_CPUSTATS;
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot obtain control group CPU information."));
+		return SYSINFO_RET_FAIL;
+	}
+
+	if (0 > (idx_base = idx_curr - MIN(cgroup->h_count - 1, time)))
+		idx_base += ZBX_MAX_COLLECTOR_HISTORY;
+
+	while (SYSINFO_RET_OK != cgroup->h_status[idx_base])
+		if (ZBX_MAX_COLLECTOR_HISTORY == ++idx_base)
+			idx_base -= ZBX_MAX_COLLECTOR_HISTORY;
+
+	if (ZBX_CGROUP_CPU_THROTTLED == state)
+	{
+		total = cgroup->h_counter[ZBX_CGROUP_CPU_PERIODS][idx_curr] -
+				cgroup->h_counter[ZBX_CGROUP_CPU_PERIODS][idx_base];
+		value = (double)total;
+	}
+	else
+	{
+		total = cgroup->h_counter[ZBX_CGROUP_CPU_CLOCK][idx_curr] -
+				cgroup->h_counter[ZBX_CGROUP_CPU_CLOCK][idx_base];
+
+		/* current CPU limit applies to the whole interval */
+		value = (double)total * (double)cgroup->h_counter[ZBX_CGROUP_CPU_LIMIT][idx_curr] / 1000000;
+	}
+
+	if (cgroup->h_counter[state][idx_curr] > cgroup->h_counter[state][idx_base])
+		counter = cgroup->h_counter[state][idx_curr] - cgroup->h_counter[state][idx_base];
+	else
+		counter = 0;
+
+	UNLOCK_CPUSTATS;
+
+	SET_DBL_RESULT(result, 0 == total ? 0 : 100. * (double)counter / value);
+
+	return SYSINFO_RET_OK;
+}
+#endif
+
 #ifdef _AIX
 int	get_cpustat_physical(AGENT_RESULT *result, int cpu_num, int state, int mode)
 {
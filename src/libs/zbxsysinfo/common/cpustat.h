@@ -47,10 +47,40 @@ typedef struct
 }
 ZBX_SINGLE_CPU_STAT_DATA;
 
+#if defined(HAVE_PROC_STAT)
+/* counters of cgroup v2 "cpu.stat" and "cpu.max" files of the control group the agent runs in */
+#define ZBX_CGROUP_CPU_USAGE		0	/* CPU time used, microseconds */
+#define ZBX_CGROUP_CPU_USER		1	/* CPU time used in user mode, microseconds */
+#define ZBX_CGROUP_CPU_SYSTEM		2	/* CPU time used in system mode, microseconds */
+#define ZBX_CGROUP_CPU_PERIODS		3	/* number of elapsed bandwidth enforcement periods */
+#define ZBX_CGROUP_CPU_THROTTLED	4	/* number of periods the group was throttled */
+#define ZBX_CGROUP_CPU_CLOCK		5	/* time of measurement, microseconds */
+#define ZBX_CGROUP_CPU_LIMIT		6	/* CPU time available to the group per second, microseconds */
+#define ZBX_CGROUP_CPU_COUNT		7
+
+typedef struct
+{
+	zbx_uint64_t	h_counter[ZBX_CGROUP_CPU_COUNT][ZBX_MAX_COLLECTOR_HISTORY];
+	unsigned char	h_status[ZBX_MAX_COLLECTOR_HISTORY];
+#if (ZBX_MAX_COLLECTOR_HISTORY % 8) > 0
+	unsigned char	padding0[8 - (ZBX_MAX_COLLECTOR_HISTORY % 8)];	/* for 8-byte alignment */
+#endif
+	int		h_first;
+	int		h_count;
+	int		available;	/* 1 if cgroup v2 CPU controller statistics are available */
+	int		padding1;	/* for 8-byte alignment */
+}
+ZBX_CGROUP_CPU_STAT_DATA;
+#endif
+
 typedef struct
 {
 	ZBX_SINGLE_CPU_STAT_DATA	*cpu;
 	int				count;
+#if defined(HAVE_PROC_STAT)
+	int				padding0;	/* for 8-byte alignment */
+	ZBX_CGROUP_CPU_STAT_DATA	cgroup;
+#endif
 }
 ZBX_CPUS_STAT_DATA;
 
@@ -80,6 +110,9 @@ ZBX_CPUS_UTIL_DATA_AIX;
 
 void	collect_cpustat(ZBX_CPUS_STAT_DATA *pcpus);
 int	get_cpustat(AGENT_RESULT *result, int cpu_num, int state, int mode);
+#if defined(HAVE_PROC_STAT)
+int	get_cgroup_cpustat(AGENT_RESULT *result, int state, int mode);
+#endif
 #ifdef _AIX
 void	collect_cpustat_physical(ZBX_CPUS_UTIL_DATA_AIX *cpus_phys_util);
 int	get_cpustat_physical(AGENT_RESULT *result, int cpu_num, int state, int mode);
@@ -82,10 +82,21 @@ static int	queue_directory(zbx_vector_ptr_t *list, char *path, int depth, int ma
 	return FAIL;	/* 'path' did not go into 'list' - don't forget to free 'path' in the caller */
 }
 
+static zbx_hash_t	descriptor_hash(const void *data)
+{
+	const zbx_file_descriptor_t	*file = (const zbx_file_descriptor_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&file->st_ino);
+	hash = ZBX_DEFAULT_UINT64_HASH_ALGO(&file->st_dev, sizeof(file->st_dev), hash);
+
+	return hash;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Compares two zbx_file_descriptor_t values to perform search       *
- *          within descriptor vector.                                         *
+ *          within descriptor hashset.                                        *
  *                                                                            *
  * Parameters: file_a - [IN] file descriptor A                                *
  *             file_b - [IN] file descriptor B                                *
@@ -96,14 +107,112 @@ static int	queue_directory(zbx_vector_ptr_t *list, char *path, int depth, int ma
  ******************************************************************************/
 static int	compare_descriptors(const void *file_a, const void *file_b)
 {
-	const zbx_file_descriptor_t	*fa, *fb;
-
-	fa = *((zbx_file_descriptor_t * const *)file_a);
-	fb = *((zbx_file_descriptor_t * const *)file_b);
+	const zbx_file_descriptor_t	*fa = (const zbx_file_descriptor_t *)file_a;
+	const zbx_file_descriptor_t	*fb = (const zbx_file_descriptor_t *)file_b;
 
 	return (fa->st_ino != fb->st_ino || fa->st_dev != fb->st_dev);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: registers file with multiple hardlinks so that its size is        *
+ *          counted only once                                                 *
+ *                                                                            *
+ * Parameters: descriptors - [IN/OUT] already processed files                 *
+ *             st_dev      - [IN] device                                      *
+ *             st_ino      - [IN] file serial number                          *
+ *                                                                            *
+ * Return value: SUCCEED - file was not processed before,                     *
+ *               FAIL    - file was already processed.                        *
+ *                                                                            *
+ * Comments: hashset is used instead of linear search as directories with     *
+ *           large number of hardlinked files made the check quadratic.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	register_descriptor(zbx_hashset_t *descriptors, zbx_uint64_t st_dev, zbx_uint64_t st_ino)
+{
+	zbx_file_descriptor_t	file_local;
+	int			num;
+
+	file_local.st_dev = st_dev;
+	file_local.st_ino = st_ino;
+
+	num = descriptors->num_data;
+	zbx_hashset_insert(descriptors, &file_local, sizeof(file_local));
+
+	return num != descriptors->num_data ? SUCCEED : FAIL;
+}
+
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: converts stat() file mode to file type mask                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	stat_mode_to_mask(mode_t mode)
+{
+	if (0 != S_ISREG(mode))
+		return ZBX_FT_FILE;
+
+	if (0 != S_ISDIR(mode))
+		return ZBX_FT_DIR;
+
+	if (0 != S_ISLNK(mode))
+		return ZBX_FT_SYM;
+
+	if (0 != S_ISSOCK(mode))
+		return ZBX_FT_SOCK;
+
+	if (0 != S_ISBLK(mode))
+		return ZBX_FT_BDEV;
+
+	if (0 != S_ISCHR(mode))
+		return ZBX_FT_CDEV;
+
+	if (0 != S_ISFIFO(mode))
+		return ZBX_FT_FIFO;
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets file type mask from directory entry without calling lstat()  *
+ *                                                                            *
+ * Return value: file type mask or 0 if the type is not known and lstat()     *
+ *               must be used                                                 *
+ *                                                                            *
+ * Comments: file systems that do not fill d_type report DT_UNKNOWN, and      *
+ *           platforms without d_type do not define DT_UNKNOWN at all.        *
+ *                                                                            *
+ ******************************************************************************/
+static int	dirent_to_mask(const struct dirent *entry)
+{
+#ifdef DT_UNKNOWN
+	switch (entry->d_type)
+	{
+		case DT_REG:
+			return ZBX_FT_FILE;
+		case DT_DIR:
+			return ZBX_FT_DIR;
+		case DT_LNK:
+			return ZBX_FT_SYM;
+		case DT_SOCK:
+			return ZBX_FT_SOCK;
+		case DT_BLK:
+			return ZBX_FT_BDEV;
+		case DT_CHR:
+			return ZBX_FT_CDEV;
+		case DT_FIFO:
+			return ZBX_FT_FIFO;
+	}
+#else
+	ZBX_UNUSED(entry);
+#endif
+	return 0;
+}
+#endif
+
 static int	prepare_common_parameters(const AGENT_REQUEST *request, AGENT_RESULT *result, zbx_regexp_t **regex_incl,
 		zbx_regexp_t **regex_excl, zbx_regexp_t **regex_excl_dir, int *max_depth, char **dir,
 		zbx_stat_t *status, int depth_param, int excl_dir_param, int param_count)
@@ -376,18 +485,6 @@ static void	list_vector_destroy(zbx_vector_ptr_t *list)
 	zbx_vector_ptr_destroy(list);
 }
 
-static void	descriptors_vector_destroy(zbx_vector_ptr_t *descriptors)
-{
-	zbx_file_descriptor_t	*file;
-
-	while (0 < descriptors->values_num)
-	{
-		file = (zbx_file_descriptor_t *)descriptors->values[--descriptors->values_num];
-		zbx_free(file);
-	}
-	zbx_vector_ptr_destroy(descriptors);
-}
-
 /******************************************************************************
  *                                                                            *
  * Different approach is used for Windows implementation as Windows is not    *
@@ -459,10 +556,9 @@ static int	get_file_info_by_handle(wchar_t *wpath, BY_HANDLE_FILE_INFORMATION *l
 	return SUCCEED;
 }
 
-static int	link_processed(DWORD attrib, wchar_t *wpath, zbx_vector_ptr_t *descriptors, char *path)
+static int	link_processed(DWORD attrib, wchar_t *wpath, zbx_hashset_t *descriptors, char *path)
 {
 	BY_HANDLE_FILE_INFORMATION	link_info;
-	zbx_file_descriptor_t		*file;
 	char 				*error;
 
 	/* Behavior like MS file explorer */
@@ -483,18 +579,11 @@ static int	link_processed(DWORD attrib, wchar_t *wpath, zbx_vector_ptr_t *descri
 	if (1 < link_info.nNumberOfLinks)
 	{
 		/* skip file if inode was already processed (multiple hardlinks) */
-		file = (zbx_file_descriptor_t*)zbx_malloc(NULL, sizeof(zbx_file_descriptor_t));
-
-		file->st_dev = link_info.dwVolumeSerialNumber;
-		file->st_ino = DW2UI64(link_info.nFileIndexHigh, link_info.nFileIndexLow);
-
-		if (FAIL != zbx_vector_ptr_search(descriptors, file, compare_descriptors))
+		if (SUCCEED != register_descriptor(descriptors, link_info.dwVolumeSerialNumber,
+				DW2UI64(link_info.nFileIndexHigh, link_info.nFileIndexLow)))
 		{
-			zbx_free(file);
 			return SUCCEED;
 		}
-
-		zbx_vector_ptr_append(descriptors, file);
 	}
 
 	return FAIL;
@@ -505,7 +594,8 @@ static int	vfs_dir_size_local(AGENT_REQUEST *request, AGENT_RESULT *result, HAND
 	char			*dir = NULL;
 	int			mode, max_depth, ret = SYSINFO_RET_FAIL;
 	zbx_uint64_t		size = 0;
-	zbx_vector_ptr_t	list, descriptors;
+	zbx_vector_ptr_t	list;
+	zbx_hashset_t		descriptors;
 	zbx_stat_t		status;
 	zbx_regexp_t		*regex_incl = NULL, *regex_excl = NULL, *regex_excl_dir = NULL;
 	size_t			dir_len;
@@ -519,7 +609,7 @@ static int	vfs_dir_size_local(AGENT_REQUEST *request, AGENT_RESULT *result, HAND
 		goto err1;
 	}
 
-	zbx_vector_ptr_create(&descriptors);
+	zbx_hashset_create(&descriptors, 100, descriptor_hash, compare_descriptors);
 	zbx_vector_ptr_create(&list);
 
 	dir_len = strlen(dir);	/* store this value before giving away pointer ownership */
@@ -670,7 +760,7 @@ skip:
 	ret = SYSINFO_RET_OK;
 err2:
 	list_vector_destroy(&list);
-	descriptors_vector_destroy(&descriptors);
+	zbx_hashset_destroy(&descriptors);
 err1:
 	regex_incl_excl_free(regex_incl, regex_excl, regex_excl_dir);
 
@@ -682,7 +772,8 @@ static int	vfs_dir_size_local(AGENT_REQUEST *request, AGENT_RESULT *result)
 	char			*dir = NULL;
 	int			mode, max_depth, ret = SYSINFO_RET_FAIL;
 	zbx_uint64_t		size = 0;
-	zbx_vector_ptr_t	list, descriptors;
+	zbx_vector_ptr_t	list;
+	zbx_hashset_t		descriptors;
 	zbx_stat_t		status;
 	zbx_regexp_t		*regex_incl = NULL, *regex_excl = NULL, *regex_excl_dir = NULL;
 	size_t			dir_len;
@@ -696,7 +787,7 @@ static int	vfs_dir_size_local(AGENT_REQUEST *request, AGENT_RESULT *result)
 		goto err1;
 	}
 
-	zbx_vector_ptr_create(&descriptors);
+	zbx_hashset_create(&descriptors, 100, descriptor_hash, compare_descriptors);
 	zbx_vector_ptr_create(&list);
 
 	dir_len = strlen(dir);	/* store this value before giving away pointer ownership */
@@ -744,15 +835,34 @@ static int	vfs_dir_size_local(AGENT_REQUEST *request, AGENT_RESULT *result)
 		while (NULL != (entry = readdir(directory)))
 		{
 			char	*path;
+			int	type;
 
 			if (0 == strcmp(entry->d_name, ".") || 0 == strcmp(entry->d_name, ".."))
 				continue;
 
+			type = dirent_to_mask(entry);
+
+			/* entries that will be neither counted nor traversed do not need lstat() */
+			if (0 != type && ZBX_FT_DIR != type && (0 == (type & (ZBX_FT_FILE | ZBX_FT_SYM)) ||
+					0 == filename_matches(entry->d_name, regex_incl, regex_excl)))
+			{
+				continue;
+			}
+
 			path = zbx_dsprintf(NULL, "%s/%s", item->path, entry->d_name);
 
+			/* consider only path relative to path given in first parameter */
+			if (ZBX_FT_DIR == type && NULL != regex_excl_dir &&
+					0 == zbx_regexp_match_precompiled(path + dir_len + 1, regex_excl_dir))
+			{
+				zbx_free(path);
+				continue;
+			}
+
 			if (0 == lstat(path, &status))
 			{
-				if (NULL != regex_excl_dir && 0 != S_ISDIR(status.st_mode))
+				/* directories with known type were already checked against exclusion regexp */
+				if (NULL != regex_excl_dir && ZBX_FT_DIR != type && 0 != S_ISDIR(status.st_mode))
 				{
 					/* consider only path relative to path given in first parameter */
 					if (0 == zbx_regexp_match_precompiled(path + dir_len + 1, regex_excl_dir))
@@ -766,26 +876,13 @@ static int	vfs_dir_size_local(AGENT_REQUEST *request, AGENT_RESULT *result)
 						0 != S_ISDIR(status.st_mode)) &&
 						0 != filename_matches(entry->d_name, regex_incl, regex_excl))
 				{
-					if (0 != S_ISREG(status.st_mode) && 1 < status.st_nlink)
+					/* skip file if inode was already processed (multiple hardlinks) */
+					if (0 != S_ISREG(status.st_mode) && 1 < status.st_nlink &&
+							SUCCEED != register_descriptor(&descriptors,
+							(zbx_uint64_t)status.st_dev, (zbx_uint64_t)status.st_ino))
 					{
-						zbx_file_descriptor_t	*file;
-
-						/* skip file if inode was already processed (multiple hardlinks) */
-						file = (zbx_file_descriptor_t*)zbx_malloc(NULL,
-								sizeof(zbx_file_descriptor_t));
-
-						file->st_dev = status.st_dev;
-						file->st_ino = status.st_ino;
-
-						if (FAIL != zbx_vector_ptr_search(&descriptors, file,
-								compare_descriptors))
-						{
-							zbx_free(file);
-							zbx_free(path);
-							continue;
-						}
-
-						zbx_vector_ptr_append(&descriptors, file);
+						zbx_free(path);
+						continue;
 					}
 
 					if (SIZE_MODE_APPARENT == mode)
@@ -818,7 +915,7 @@ skip:
 	ret = SYSINFO_RET_OK;
 err2:
 	list_vector_destroy(&list);
-	descriptors_vector_destroy(&descriptors);
+	zbx_hashset_destroy(&descriptors);
 err1:
 	regex_incl_excl_free(regex_incl, regex_excl, regex_excl_dir);
 
@@ -864,7 +961,7 @@ static int	vfs_dir_info(AGENT_REQUEST *request, AGENT_RESULT *result, HANDLE tim
 	char			*dir = NULL;
 	int			types, max_depth, ret = SYSINFO_RET_FAIL;
 	zbx_uint64_t		count = 0;
-	zbx_vector_ptr_t	list, descriptors;
+	zbx_vector_ptr_t	list;
 	zbx_stat_t		status;
 	zbx_regexp_t		*regex_incl = NULL, *regex_excl = NULL, *regex_excl_dir = NULL;
 	zbx_uint64_t		min_size = 0, max_size = __UINT64_C(0x7fffffffffffffff);
@@ -882,7 +979,6 @@ static int	vfs_dir_info(AGENT_REQUEST *request, AGENT_RESULT *result, HANDLE tim
 	}
 
 	zbx_json_initarray(&j, ZBX_JSON_STAT_BUF_LEN);
-	zbx_vector_ptr_create(&descriptors);
 	zbx_vector_ptr_create(&list);
 
 	dir_len = strlen(dir);	/* store this value before giving away pointer ownership */
@@ -1028,7 +1124,6 @@ skip:
 	ret = SYSINFO_RET_OK;
 err2:
 	list_vector_destroy(&list);
-	descriptors_vector_destroy(&descriptors);
 	zbx_json_free(&j);
 err1:
 	regex_incl_excl_free(regex_incl, regex_excl, regex_excl_dir);
@@ -1104,6 +1199,7 @@ static int	vfs_dir_info(AGENT_REQUEST *request, AGENT_RESULT *result, int count_
 		while (NULL != (entry = readdir(directory)))
 		{
 			char	*path;
+			int	type, counted, name_matched;
 
 			if (0 == strcmp(entry->d_name, ".") || 0 == strcmp(entry->d_name, ".."))
 				continue;
@@ -1113,46 +1209,50 @@ static int	vfs_dir_info(AGENT_REQUEST *request, AGENT_RESULT *result, int count_
 			else
 				path = zbx_dsprintf(NULL, "%s/%s", item->path, entry->d_name);
 
-			if (0 == lstat(path, &status))
+			/* entries of type known from readdir() which cannot be counted do not need lstat() */
+			if (0 != (type = dirent_to_mask(entry)) && (0 == (types & type) ||
+					0 == filename_matches(entry->d_name, regex_incl, regex_excl)))
 			{
-				if (NULL != regex_excl_dir && 0 != S_ISDIR(status.st_mode))
-				{
-					/* consider only path relative to path given in first parameter */
-					if (0 == zbx_regexp_match_precompiled(path + dir_len + 1, regex_excl_dir))
-					{
-						zbx_free(path);
-						continue;
-					}
-				}
+				counted = 0;
+			}
+			else
+			{
+				name_matched = (0 != type);
 
-				if (0 != filename_matches(entry->d_name, regex_incl, regex_excl) && (
-						(S_ISREG(status.st_mode)  && 0 != (types & ZBX_FT_FILE)) ||
-						(S_ISDIR(status.st_mode)  && 0 != (types & ZBX_FT_DIR)) ||
-						(S_ISLNK(status.st_mode)  && 0 != (types & ZBX_FT_SYM)) ||
-						(S_ISSOCK(status.st_mode) && 0 != (types & ZBX_FT_SOCK)) ||
-						(S_ISBLK(status.st_mode)  && 0 != (types & ZBX_FT_BDEV)) ||
-						(S_ISCHR(status.st_mode)  && 0 != (types & ZBX_FT_CDEV)) ||
-						(S_ISFIFO(status.st_mode) && 0 != (types & ZBX_FT_FIFO))) &&
-						(min_size <= (zbx_uint64_t)status.st_size
-								&& (zbx_uint64_t)status.st_size <= max_size) &&
-						(min_time < status.st_mtime &&
-								status.st_mtime <= max_time))
+				if (0 != lstat(path, &status))
 				{
-					EVALUATE_DIR_ENTITY()
+					zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot process directory entry '%s': %s",
+							__func__, path, zbx_strerror(errno));
+					zbx_free(path);
+					continue;
 				}
 
-				if (!(0 != S_ISDIR(status.st_mode) && SUCCEED == queue_directory(&list, path,
-						item->depth, max_depth)))
+				type = stat_mode_to_mask(status.st_mode);
+
+				counted = (0 != (types & type) && (0 != name_matched ||
+						0 != filename_matches(entry->d_name, regex_incl, regex_excl)) &&
+						(min_size <= (zbx_uint64_t)status.st_size &&
+								(zbx_uint64_t)status.st_size <= max_size) &&
+						(min_time < status.st_mtime && status.st_mtime <= max_time));
+			}
+
+			if (NULL != regex_excl_dir && ZBX_FT_DIR == type)
+			{
+				/* consider only path relative to path given in first parameter */
+				if (0 == zbx_regexp_match_precompiled(path + dir_len + 1, regex_excl_dir))
 				{
 					zbx_free(path);
+					continue;
 				}
 			}
-			else
+
+			if (0 != counted)
 			{
-				zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot process directory entry '%s': %s",
-						__func__, path, zbx_strerror(errno));
-				zbx_free(path);
+				EVALUATE_DIR_ENTITY()
 			}
+
+			if (!(ZBX_FT_DIR == type && SUCCEED == queue_directory(&list, path, item->depth, max_depth)))
+				zbx_free(path);
 		}
 
 		closedir(directory);
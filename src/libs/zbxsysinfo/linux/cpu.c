@@ -122,6 +122,50 @@ int	system_cpu_util(AGENT_REQUEST *request, AGENT_RESULT *result)
 	return get_cpustat(result, cpu_num, state, mode);
 }
 
+int	system_cpu_cgroup_util(AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+	char	*tmp;
+	int	state, mode;
+
+	if (2 < request->nparam)
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Too many parameters."));
+		return SYSINFO_RET_FAIL;
+	}
+
+	tmp = get_rparam(request, 0);
+
+	if (NULL == tmp || '\0' == *tmp || 0 == strcmp(tmp, "total"))
+		state = ZBX_CGROUP_CPU_USAGE;
+	else if (0 == strcmp(tmp, "user"))
+		state = ZBX_CGROUP_CPU_USER;
+	else if (0 == strcmp(tmp, "system"))
+		state = ZBX_CGROUP_CPU_SYSTEM;
+	else if (0 == strcmp(tmp, "throttled"))
+		state = ZBX_CGROUP_CPU_THROTTLED;
+	else
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid first parameter."));
+		return SYSINFO_RET_FAIL;
+	}
+
+	tmp = get_rparam(request, 1);
+
+	if (NULL == tmp || '\0' == *tmp || 0 == strcmp(tmp, "avg1"))
+		mode = ZBX_AVG1;
+	else if (0 == strcmp(tmp, "avg5"))
+		mode = ZBX_AVG5;
+	else if (0 == strcmp(tmp, "avg15"))
+		mode = ZBX_AVG15;
+	else
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+		return SYSINFO_RET_FAIL;
+	}
+
+	return get_cgroup_cpustat(result, state, mode);
+}
+
 int	system_cpu_load(AGENT_REQUEST *request, AGENT_RESULT *result)
 {
 	char	*tmp;
@@ -53,6 +53,7 @@ static zbx_metric_t	parameters_specific[] =
 	{"system.cpu.switches", 	0,		system_cpu_switches,	NULL},
 	{"system.cpu.intr",		0,		system_cpu_intr,	NULL},
 	{"system.cpu.util",		CF_HAVEPARAMS,	system_cpu_util,	"all,user,avg1"},
+	{"system.cpu.cgroup.util",	CF_HAVEPARAMS,	system_cpu_cgroup_util,	"total,avg1"},
 	{"system.cpu.load",		CF_HAVEPARAMS,	system_cpu_load,	"all,avg1"},
 	{"system.cpu.num",		CF_HAVEPARAMS,	system_cpu_num,		"online"},
 	{"system.cpu.discovery",	0,		system_cpu_discovery,	NULL},
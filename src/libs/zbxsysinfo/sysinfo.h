@@ -159,6 +159,7 @@ int	system_cpu_switches(AGENT_REQUEST *request, AGENT_RESULT *result);
 int	system_cpu_intr(AGENT_REQUEST *request, AGENT_RESULT *result);
 int	system_cpu_load(AGENT_REQUEST *request, AGENT_RESULT *result);
 int	system_cpu_util(AGENT_REQUEST *request, AGENT_RESULT *result);
+int	system_cpu_cgroup_util(AGENT_REQUEST *request, AGENT_RESULT *result);
 int	system_cpu_num(AGENT_REQUEST *request, AGENT_RESULT *result);
 int	system_cpu_discovery(AGENT_REQUEST *request, AGENT_RESULT *result);
 int	system_hostname(AGENT_REQUEST *request, AGENT_RESULT *result);
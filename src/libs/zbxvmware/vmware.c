@@ -19,7 +19,9 @@
 
 #if defined(HAVE_LIBXML2) && defined(HAVE_LIBCURL)
 #	include "vmware_hv.h"
+#	include "vmware_vm.h"
 #	include "vmware_ds.h"
+#	include "vmware_changes.h"
 #	include "vmware_event.h"
 #	include "vmware_perfcntr.h"
 #	include "vmware_service_cfglists.h"
@@ -701,6 +703,7 @@ static void	vmware_service_shared_free(zbx_vmware_service_t *service)
 	zbx_vector_vmware_entity_tags_ptr_clear_ext(&service->data_tags.entity_tags, vmware_shared_entity_tags_free);
 	zbx_vector_vmware_entity_tags_ptr_destroy(&service->data_tags.entity_tags);
 	vmware_shared_strfree(service->data_tags.error);
+	vmware_changes_shared_clean(&service->changes);
 
 	vmware_shmem_service_free(service);
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -916,6 +919,62 @@ do											\
 	}										\
 } while(0)
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets cURL options common for all requests to vmware service       *
+ *                                                                            *
+ * Parameters: service               - [IN] vmware service                    *
+ *             easyhandle            - [IN] CURL handle                       *
+ *             page                  - [IN] CURL output buffer                *
+ *             config_source_ip      - [IN]                                   *
+ *             config_vmware_timeout - [IN]                                   *
+ *             error                 - [OUT] error message in case of failure *
+ *                                                                            *
+ * Return value: SUCCEED - options were set successfully                      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	vmware_curl_set_options(const zbx_vmware_service_t *service, CURL *easyhandle, ZBX_HTTPPAGE *page,
+		const char *config_source_ip, int config_vmware_timeout, char **error)
+{
+	CURLoption	opt;
+	CURLcode	err;
+
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_COOKIEFILE, "")) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_FOLLOWLOCATION, 1L)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_WRITEFUNCTION, curl_write_cb)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_WRITEDATA, page)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_PRIVATE, page)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_HEADERFUNCTION,
+					curl_header_cb)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_SSL_VERIFYPEER, 0L)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_POST, 1L)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_URL, service->url)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_TIMEOUT,
+					(long)config_vmware_timeout)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_SSL_VERIFYHOST, 0L)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_ACCEPT_ENCODING, "")))
+	{
+		*error = zbx_dsprintf(*error, "Cannot set cURL option %d: %s.", (int)opt, curl_easy_strerror(err));
+		return FAIL;
+	}
+
+	if (SUCCEED != zbx_curl_setopt_https(easyhandle, error))
+		return FAIL;
+
+	if (NULL != config_source_ip)
+	{
+		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_INTERFACE, config_source_ip)))
+		{
+			*error = zbx_dsprintf(*error, "Cannot set cURL option %d: %s.", (int)opt,
+					curl_easy_strerror(err));
+			return FAIL;
+		}
+	}
+
+	return SUCCEED;
+}
+
 /*******************************************************************************
  *                                                                             *
  * Parameters: service               - [IN] vmware service                     *
@@ -946,8 +1005,6 @@ int	vmware_service_authenticate(zbx_vmware_service_t *service, CURL *easyhandle,
 		ZBX_POST_VSPHERE_FOOTER
 
 	char		xml[MAX_STRING_LEN], *error_object = NULL, *username_esc = NULL, *password_esc = NULL;
-	CURLoption	opt;
-	CURLcode	err;
 	xmlDoc		*doc = NULL;
 	int		ret = FAIL;
 
@@ -963,36 +1020,10 @@ int	vmware_service_authenticate(zbx_vmware_service_t *service, CURL *easyhandle,
 		goto out;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_COOKIEFILE, "")) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_FOLLOWLOCATION, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_WRITEFUNCTION, curl_write_cb)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_WRITEDATA, page)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_PRIVATE, page)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_HEADERFUNCTION,
-					curl_header_cb)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_SSL_VERIFYPEER, 0L)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_POST, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_URL, service->url)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_TIMEOUT,
-					(long)config_vmware_timeout)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_SSL_VERIFYHOST, 0L)) ||
-			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_ACCEPT_ENCODING, "")))
+	if (SUCCEED != vmware_curl_set_options(service, easyhandle, page, config_source_ip, config_vmware_timeout,
+			error))
 	{
-		*error = zbx_dsprintf(*error, "Cannot set cURL option %d: %s.", (int)opt, curl_easy_strerror(err));
-		goto out;
-	}
-
-	if (SUCCEED != zbx_curl_setopt_https(easyhandle, error))
 		goto out;
-
-	if (NULL != config_source_ip)
-	{
-		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_INTERFACE, config_source_ip)))
-		{
-			*error = zbx_dsprintf(*error, "Cannot set cURL option %d: %s.", (int)opt,
-					curl_easy_strerror(err));
-			goto out;
-		}
 	}
 
 	username_esc = zbx_xml_escape_dyn(service->username);
@@ -2515,6 +2546,10 @@ int	vmware_curl_set_header(CURL *easyhandle, int vc_version, struct curl_slist *
  *             config_vmware_timeout - [IN]                                   *
  *             cache_update_period   - [IN]                                   *
  *                                                                            *
+ * Comments: The session is kept open between updates to track inventory      *
+ *           changes, so virtual machines not changed since the previous      *
+ *           update are taken from it instead of being retrieved again.       *
+ *                                                                            *
  ******************************************************************************/
 int	zbx_vmware_service_update(zbx_vmware_service_t *service, const char *config_source_ip,
 		int config_vmware_timeout, int cache_update_period)
@@ -2526,6 +2561,8 @@ int	zbx_vmware_service_update(zbx_vmware_service_t *service, const char *config_
 	zbx_vector_str_t		hvs, dss;
 	zbx_vector_cq_value_ptr_t	dvs_query_values, prop_query_values, cust_query_values;
 	zbx_vmware_alarms_data_t	alarms_data;
+	zbx_vmware_changes_t		changes;
+	zbx_hashset_t			vms;
 	int				ret = FAIL;
 	ZBX_HTTPPAGE			page;	/* 347K/87K */
 	char				msg[MAX_STRING_LEN / 8];
@@ -2557,6 +2594,8 @@ int	zbx_vmware_service_update(zbx_vmware_service_t *service, const char *config_
 			cache_update_period);
 	vmware_service_cust_query_prep(&service->cust_queries, VMWARE_OBJECT_PROPERTY, &prop_query_values,
 			cache_update_period);
+	vmware_changes_dup(&changes, &service->changes);
+	vmware_vm_cache_create(&vms, NULL != changes.version ? service->data : NULL);
 	zbx_vmware_unlock();
 
 	zbx_vector_cq_value_ptr_sort(&prop_query_values, vmware_cq_instance_id_compare);
@@ -2573,8 +2612,19 @@ int	zbx_vmware_service_update(zbx_vmware_service_t *service, const char *config_
 	if (SUCCEED != vmware_curl_set_header(easyhandle, service->major_version, &headers, &data->error))
 		goto clean;
 
-	if (SUCCEED != vmware_service_authenticate(service, easyhandle, &page, config_source_ip, config_vmware_timeout,
-			&data->error))
+	if (NULL != changes.version && (SUCCEED != vmware_curl_set_options(service, easyhandle, &page,
+			config_source_ip, config_vmware_timeout, &data->error) ||
+			SUCCEED != vmware_service_changes_resume(service, easyhandle, &changes, &vms, &data->error)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "Cannot resume tracking of inventory changes: %s.", data->error);
+		zbx_free(data->error);
+		vmware_changes_clean(&changes);
+		vmware_vm_cache_clear(&vms);
+		curl_easy_setopt(easyhandle, CURLOPT_COOKIELIST, "ALL");
+	}
+
+	if (NULL == changes.version && SUCCEED != vmware_service_authenticate(service, easyhandle, &page,
+			config_source_ip, config_vmware_timeout, &data->error))
 	{
 		goto clean;
 	}
@@ -2582,6 +2632,13 @@ int	zbx_vmware_service_update(zbx_vmware_service_t *service, const char *config_
 	if (SUCCEED != vmware_service_initialize(service, easyhandle, &data->error))
 		goto clean;
 
+	if (NULL == changes.version && SUCCEED != vmware_service_changes_track(service, easyhandle, &changes,
+			&data->error))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "Cannot start tracking of inventory changes: %s.", data->error);
+		zbx_free(data->error);
+	}
+
 	/* update headers after VC version detection */
 	if (SUCCEED != vmware_curl_set_header(easyhandle, service->major_version, &headers, &data->error))
 		goto clean;
@@ -2626,7 +2683,7 @@ int	zbx_vmware_service_update(zbx_vmware_service_t *service, const char *config_
 		zbx_vmware_hv_t	hv_local, *hv;
 
 		if (SUCCEED == vmware_service_init_hv(service, easyhandle, hvs.values[i], &data->datastores,
-				&data->resourcepools, &prop_query_values, &alarms_data, &hv_local, &data->error))
+				&data->resourcepools, &prop_query_values, &alarms_data, &vms, &hv_local, &data->error))
 		{
 			if (NULL != (hv = zbx_hashset_search(&data->hvs, &hv_local)))
 			{
@@ -2670,7 +2727,8 @@ int	zbx_vmware_service_update(zbx_vmware_service_t *service, const char *config_
 		goto clean;
 	}
 
-	if (SUCCEED != vmware_service_logout(service, easyhandle, &data->error))
+	/* keep the session with property filter open till the next update */
+	if (NULL == changes.version && SUCCEED != vmware_service_logout(service, easyhandle, &data->error))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "Cannot close vmware connection: %s.", data->error);
 		zbx_free(data->error);
@@ -2700,6 +2758,12 @@ out:
 	vmware_data_shared_free(service->data);
 	service->data = vmware_shmem_data_dup(data);
 
+	/* the changes are already consumed, so tracking cannot be continued after failed update */
+	vmware_changes_shared_clean(&service->changes);
+
+	if (SUCCEED == ret && NULL != changes.version)
+		vmware_changes_shared_dup(&service->changes, &changes);
+
 	service->lastcheck = time(NULL);
 	vmware_service_update_perf_entities(service);
 	vmware_service_copy_cust_query_response(&dvs_query_values);
@@ -2728,6 +2792,9 @@ out:
 	zbx_vector_cq_value_ptr_destroy(&dvs_query_values);
 	zbx_vector_cq_value_ptr_clear_ext(&prop_query_values, zbx_vmware_cq_value_free);
 	zbx_vector_cq_value_ptr_destroy(&prop_query_values);
+	vmware_changes_clean(&changes);
+	vmware_vm_cache_clear(&vms);
+	zbx_hashset_destroy(&vms);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s \tprocessed:" ZBX_FS_SIZE_T " bytes of data. %s", __func__,
 			zbx_result_string(ret), (zbx_fs_size_t)page.alloc, msg);
@@ -0,0 +1,546 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+/*
+ * The inventory change tracking keeps the vSphere session of the configuration update alive between
+ * updates together with a PropertyCollector filter on virtual machine properties. Before the next
+ * update the changes since the last seen data version are requested with WaitForUpdatesEx and applied
+ * to the virtual machines copied from the previous update, so only the changed virtual machines must
+ * be retrieved again. Any failure (expired session, lost collector version etc) drops the tracking
+ * state and the next update retrieves the whole inventory and starts tracking anew.
+ */
+
+#include "vmware_changes.h"
+
+#include "zbxcommon.h"
+
+#if defined(HAVE_LIBXML2) && defined(HAVE_LIBCURL)
+
+#include "vmware_vm.h"
+
+#include "zbxstr.h"
+#include "zbxxml.h"
+#ifdef HAVE_LIBXML2
+#	include <libxml/xpath.h>
+#endif
+
+#define ZBX_VMWARE_CHANGES_OBJECTS_MAX	1000
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees resources allocated to store change tracking state          *
+ *                                                                            *
+ * Parameters: changes - [IN/OUT]                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	vmware_changes_clean(zbx_vmware_changes_t *changes)
+{
+	zbx_free(changes->cookie);
+	zbx_free(changes->filter);
+	zbx_free(changes->version);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies change tracking state from shared memory                   *
+ *                                                                            *
+ * Parameters: dst - [OUT] local change tracking state                        *
+ *             src - [IN] change tracking state in shared memory              *
+ *                                                                            *
+ ******************************************************************************/
+void	vmware_changes_dup(zbx_vmware_changes_t *dst, const zbx_vmware_changes_t *src)
+{
+	dst->cookie = NULL != src->cookie ? zbx_strdup(NULL, src->cookie) : NULL;
+	dst->filter = NULL != src->filter ? zbx_strdup(NULL, src->filter) : NULL;
+	dst->version = NULL != src->version ? zbx_strdup(NULL, src->version) : NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees shared resources allocated to store change tracking state   *
+ *                                                                            *
+ * Parameters: changes - [IN/OUT]                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	vmware_changes_shared_clean(zbx_vmware_changes_t *changes)
+{
+	vmware_shared_strfree(changes->cookie);
+	vmware_shared_strfree(changes->filter);
+	vmware_shared_strfree(changes->version);
+
+	changes->cookie = NULL;
+	changes->filter = NULL;
+	changes->version = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies change tracking state into shared memory                   *
+ *                                                                            *
+ * Parameters: dst - [OUT] change tracking state in shared memory             *
+ *             src - [IN] local change tracking state                         *
+ *                                                                            *
+ ******************************************************************************/
+void	vmware_changes_shared_dup(zbx_vmware_changes_t *dst, const zbx_vmware_changes_t *src)
+{
+	dst->cookie = vmware_shared_strdup(src->cookie);
+	dst->filter = vmware_shared_strdup(src->filter);
+	dst->version = vmware_shared_strdup(src->version);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets session cookies of cURL handle                               *
+ *                                                                            *
+ * Parameters: easyhandle - [IN] CURL handle                                  *
+ *                                                                            *
+ * Return value: cookies in Netscape format separated by new line or NULL     *
+ *                                                                            *
+ ******************************************************************************/
+static char	*vmware_curl_get_cookies(CURL *easyhandle)
+{
+	struct curl_slist	*cookies = NULL;
+	char			*buf = NULL;
+	size_t			alloc = 0, offset = 0;
+
+	if (CURLE_OK != curl_easy_getinfo(easyhandle, CURLINFO_COOKIELIST, &cookies))
+		return NULL;
+
+	for (struct curl_slist *cookie = cookies; NULL != cookie; cookie = cookie->next)
+	{
+		if (0 != offset)
+			zbx_chrcpy_alloc(&buf, &alloc, &offset, '\n');
+
+		zbx_strcpy_alloc(&buf, &alloc, &offset, cookie->data);
+	}
+
+	curl_slist_free_all(cookies);
+
+	return buf;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: restores session cookies of cURL handle                           *
+ *                                                                            *
+ * Parameters: easyhandle - [IN] CURL handle                                  *
+ *             cookies    - [IN] cookies in Netscape format separated by new  *
+ *                               line                                         *
+ *             error      - [OUT] error message in case of failure            *
+ *                                                                            *
+ * Return value: SUCCEED - cookies were restored                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_curl_set_cookies(CURL *easyhandle, const char *cookies, char **error)
+{
+	char		*buf, *cookie, *saveptr = NULL;
+	CURLcode	err;
+	int		ret = SUCCEED;
+
+	buf = zbx_strdup(NULL, cookies);
+
+	for (cookie = strtok_r(buf, "\n", &saveptr); NULL != cookie; cookie = strtok_r(NULL, "\n", &saveptr))
+	{
+		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_COOKIELIST, cookie)))
+		{
+			*error = zbx_dsprintf(*error, "Cannot set cURL option %d: %s.", (int)CURLOPT_COOKIELIST,
+					curl_easy_strerror(err));
+			ret = FAIL;
+			break;
+		}
+	}
+
+	zbx_free(buf);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies virtual machine and folder changes to virtual machine     *
+ *          cache                                                             *
+ *                                                                            *
+ * Parameters: xdoc - [IN] WaitForUpdatesEx response                          *
+ *             vms  - [IN/OUT] virtual machine cache                          *
+ *                                                                            *
+ * Comments: Changed virtual machines which cannot be updated in place are    *
+ *           removed from cache so they will be retrieved again. Folder       *
+ *           changes affect folder path of virtual machines, so the whole     *
+ *           cache is dropped.                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_changes_apply(xmlDoc *xdoc, zbx_hashset_t *vms)
+{
+	xmlXPathContext	*xpathCtx;
+	xmlXPathObject	*xpathObj;
+	xmlNodeSetPtr	nodeset;
+	int		changed = 0, refetched = 0;
+
+	xpathCtx = xmlXPathNewContext(xdoc);
+
+	if (NULL == (xpathObj = xmlXPathEvalExpression(
+			(const xmlChar *)ZBX_XPATH_LN3("returnval", "filterSet", "objectSet"), xpathCtx)))
+	{
+		goto clean;
+	}
+
+	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
+		goto clean;
+
+	nodeset = xpathObj->nodesetval;
+
+	for (int i = 0; i < nodeset->nodeNr && 0 != vms->num_data; i++)
+	{
+		xmlNode		*obj_node;
+		char		*type = NULL, *id = NULL, *kind = NULL;
+		zbx_vmware_vm_t	*vm;
+
+		if (NULL == (obj_node = zbx_xml_node_get(xdoc, nodeset->nodeTab[i], ZBX_XPATH_NN("obj"))) ||
+				NULL == (type = zbx_xml_node_read_prop(obj_node, "type")) ||
+				NULL == (id = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], ZBX_XPATH_NN("obj"))))
+		{
+			goto next;
+		}
+
+		kind = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], ZBX_XPATH_NN("kind"));
+
+		if (0 == strcmp(type, ZBX_VMWARE_SOAP_FOLDER))
+		{
+			if (NULL != kind && 0 == strcmp(kind, "modify"))
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() folder %s was changed, dropping %d cached vms",
+						__func__, id, vms->num_data);
+				vmware_vm_cache_clear(vms);
+			}
+
+			goto next;
+		}
+
+		if (0 != strcmp(type, ZBX_VMWARE_SOAP_VM) || NULL == (vm = vmware_vm_cache_take(vms, id)))
+			goto next;
+
+		changed++;
+
+		if (NULL != kind && 0 == strcmp(kind, "modify") &&
+				NULL == zbx_xml_node_get(xdoc, nodeset->nodeTab[i], ZBX_XPATH_NN("missingSet")))
+		{
+			xmlXPathObject	*changeObj;
+
+			xpathCtx->node = nodeset->nodeTab[i];
+
+			if (NULL != (changeObj = xmlXPathEvalExpression((const xmlChar *)ZBX_XPATH_NN("changeSet"),
+					xpathCtx)))
+			{
+				xmlNodeSetPtr	changes = changeObj->nodesetval;
+
+				for (int j = 0; NULL != vm && NULL != changes && j < changes->nodeNr; j++)
+				{
+					if (SUCCEED != vmware_vm_update_prop(vm, xdoc, changes->nodeTab[j]))
+					{
+						vmware_vm_free(vm);
+						vm = NULL;
+					}
+				}
+
+				xmlXPathFreeObject(changeObj);
+			}
+
+			if (NULL != vm)
+			{
+				zbx_hashset_insert(vms, &vm, sizeof(vm));
+				goto next;
+			}
+		}
+		else
+			vmware_vm_free(vm);
+
+		refetched++;
+next:
+		zbx_free(kind);
+		zbx_free(id);
+		zbx_free(type);
+	}
+clean:
+	xmlXPathFreeObject(xpathObj);
+	xmlXPathFreeContext(xpathCtx);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() changed vms:%d refetched:%d", __func__, changed, refetched);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads property collector updates since the last processed version *
+ *                                                                            *
+ * Parameters: service    - [IN] vmware service                               *
+ *             easyhandle - [IN] CURL handle                                  *
+ *             changes    - [IN/OUT] change tracking state                    *
+ *             vms        - [IN/OUT] virtual machine cache (optional)         *
+ *             error      - [OUT] error message in case of failure            *
+ *                                                                            *
+ * Return value: SUCCEED - all pending updates were read                      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: If vms is NULL the updates are skipped, which is used to consume *
+ *           the initial update with full state of the tracked objects.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_changes_wait(const zbx_vmware_service_t *service, CURL *easyhandle,
+		zbx_vmware_changes_t *changes, zbx_hashset_t *vms, char **error)
+{
+#	define ZBX_POST_VMWARE_WAIT_FOR_UPDATES							\
+		ZBX_POST_VSPHERE_HEADER								\
+		"<ns0:WaitForUpdatesEx>"							\
+			"<ns0:_this type=\"PropertyCollector\">%s</ns0:_this>"			\
+			"<ns0:version>%s</ns0:version>"						\
+			"<ns0:options>"								\
+				"<ns0:maxWaitSeconds>0</ns0:maxWaitSeconds>"			\
+				"<ns0:maxObjectUpdates>%d</ns0:maxObjectUpdates>"		\
+			"</ns0:options>"							\
+		"</ns0:WaitForUpdatesEx>"							\
+		ZBX_POST_VSPHERE_FOOTER
+
+	char	tmp[MAX_STRING_LEN], *version_esc, *version, *value;
+	xmlDoc	*doc = NULL;
+	int	ret = FAIL, pages = 0, truncated = 1;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() version:'%s'", __func__, ZBX_NULL2EMPTY_STR(changes->version));
+
+	while (0 != truncated)
+	{
+		version_esc = zbx_xml_escape_dyn(ZBX_NULL2EMPTY_STR(changes->version));
+		zbx_snprintf(tmp, sizeof(tmp), ZBX_POST_VMWARE_WAIT_FOR_UPDATES,
+				get_vmware_service_objects()[service->type].property_collector, version_esc,
+				ZBX_VMWARE_CHANGES_OBJECTS_MAX);
+		zbx_free(version_esc);
+
+		zbx_xml_free_doc(doc);
+		doc = NULL;
+
+		if (SUCCEED != zbx_soap_post(__func__, easyhandle, tmp, &doc, NULL, error))
+			goto out;
+
+		/* empty result means there are no updates since the requested version */
+		if (NULL == (version = zbx_xml_doc_read_value(doc, ZBX_XPATH_LN2("returnval", "version"))))
+			break;
+
+		zbx_free(changes->version);
+		changes->version = version;
+		pages++;
+
+		if (NULL != vms)
+			vmware_changes_apply(doc, vms);
+
+		value = zbx_xml_doc_read_value(doc, ZBX_XPATH_LN2("returnval", "truncated"));
+		truncated = (NULL != value && 0 == strcmp(value, "true"));
+		zbx_free(value);
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_xml_free_doc(doc);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s version:'%s' pages:%d", __func__, zbx_result_string(ret),
+			ZBX_NULL2EMPTY_STR(changes->version), pages);
+
+	return ret;
+
+#	undef ZBX_POST_VMWARE_WAIT_FOR_UPDATES
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resumes session of the previous configuration update and applies  *
+ *          changes reported since then to virtual machine cache              *
+ *                                                                            *
+ * Parameters: service    - [IN] vmware service                               *
+ *             easyhandle - [IN] CURL handle with options already set         *
+ *             changes    - [IN/OUT] change tracking state                    *
+ *             vms        - [IN/OUT] virtual machine cache                    *
+ *             error      - [OUT] error message in case of failure            *
+ *                                                                            *
+ * Return value: SUCCEED - session is resumed and cache is up to date         *
+ *               FAIL    - session or collector version was lost, the whole   *
+ *                         inventory must be retrieved                        *
+ *                                                                            *
+ ******************************************************************************/
+int	vmware_service_changes_resume(const zbx_vmware_service_t *service, CURL *easyhandle,
+		zbx_vmware_changes_t *changes, zbx_hashset_t *vms, char **error)
+{
+	int	ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() filter:'%s' cached vms:%d", __func__,
+			ZBX_NULL2EMPTY_STR(changes->filter), vms->num_data);
+
+	if (NULL == changes->cookie || NULL == changes->filter || NULL == changes->version)
+	{
+		*error = zbx_strdup(*error, "Change tracking is not initialized.");
+		goto out;
+	}
+
+	if (SUCCEED != vmware_curl_set_cookies(easyhandle, changes->cookie, error))
+		goto out;
+
+	ret = vmware_service_changes_wait(service, easyhandle, changes, vms, error);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s cached vms:%d", __func__, zbx_result_string(ret),
+			vms->num_data);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: starts tracking of inventory changes in the current session       *
+ *                                                                            *
+ * Parameters: service    - [IN] vmware service                               *
+ *             easyhandle - [IN] CURL handle with authenticated session       *
+ *             changes    - [OUT] change tracking state                       *
+ *             error      - [OUT] error message in case of failure            *
+ *                                                                            *
+ * Return value: SUCCEED - property filter was created                        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The filter follows virtual machines of all hypervisors and the   *
+ *           folders. The initial update with full state of objects is        *
+ *           consumed here, so the next update reports only the changes.      *
+ *                                                                            *
+ ******************************************************************************/
+int	vmware_service_changes_track(const zbx_vmware_service_t *service, CURL *easyhandle,
+		zbx_vmware_changes_t *changes, char **error)
+{
+#	define ZBX_POST_VMWARE_CREATE_FILTER							\
+		ZBX_POST_VSPHERE_HEADER								\
+		"<ns0:CreateFilter>"								\
+			"<ns0:_this type=\"PropertyCollector\">%s</ns0:_this>"			\
+			"<ns0:spec>"								\
+				"<ns0:propSet>"							\
+					"<ns0:type>VirtualMachine</ns0:type>"			\
+					"%s"							\
+				"</ns0:propSet>"						\
+				"<ns0:propSet>"							\
+					"<ns0:type>Folder</ns0:type>"				\
+					"<ns0:pathSet>name</ns0:pathSet>"			\
+					"<ns0:pathSet>parent</ns0:pathSet>"			\
+				"</ns0:propSet>"						\
+				"<ns0:objectSet>"						\
+					"<ns0:obj type=\"Folder\">%s</ns0:obj>"			\
+					"<ns0:skip>false</ns0:skip>"				\
+					"<ns0:selectSet xsi:type=\"ns0:TraversalSpec\">"	\
+						"<ns0:name>visitFolders</ns0:name>"		\
+						"<ns0:type>Folder</ns0:type>"			\
+						"<ns0:path>childEntity</ns0:path>"		\
+						"<ns0:skip>false</ns0:skip>"			\
+						"<ns0:selectSet>"				\
+							"<ns0:name>visitFolders</ns0:name>"	\
+						"</ns0:selectSet>"				\
+						"<ns0:selectSet>"				\
+							"<ns0:name>dcToHf</ns0:name>"		\
+						"</ns0:selectSet>"				\
+						"<ns0:selectSet>"				\
+							"<ns0:name>dcToVmf</ns0:name>"		\
+						"</ns0:selectSet>"				\
+						"<ns0:selectSet>"				\
+							"<ns0:name>crToH</ns0:name>"		\
+						"</ns0:selectSet>"				\
+					"</ns0:selectSet>"					\
+					"<ns0:selectSet xsi:type=\"ns0:TraversalSpec\">"	\
+						"<ns0:name>dcToHf</ns0:name>"			\
+						"<ns0:type>Datacenter</ns0:type>"		\
+						"<ns0:path>hostFolder</ns0:path>"		\
+						"<ns0:skip>false</ns0:skip>"			\
+						"<ns0:selectSet>"				\
+							"<ns0:name>visitFolders</ns0:name>"	\
+						"</ns0:selectSet>"				\
+					"</ns0:selectSet>"					\
+					"<ns0:selectSet xsi:type=\"ns0:TraversalSpec\">"	\
+						"<ns0:name>dcToVmf</ns0:name>"			\
+						"<ns0:type>Datacenter</ns0:type>"		\
+						"<ns0:path>vmFolder</ns0:path>"			\
+						"<ns0:skip>false</ns0:skip>"			\
+						"<ns0:selectSet>"				\
+							"<ns0:name>visitFolders</ns0:name>"	\
+						"</ns0:selectSet>"				\
+					"</ns0:selectSet>"					\
+					"<ns0:selectSet xsi:type=\"ns0:TraversalSpec\">"	\
+						"<ns0:name>crToH</ns0:name>"			\
+						"<ns0:type>ComputeResource</ns0:type>"		\
+						"<ns0:path>host</ns0:path>"			\
+						"<ns0:skip>false</ns0:skip>"			\
+						"<ns0:selectSet>"				\
+							"<ns0:name>hToVm</ns0:name>"		\
+						"</ns0:selectSet>"				\
+					"</ns0:selectSet>"					\
+					"<ns0:selectSet xsi:type=\"ns0:TraversalSpec\">"	\
+						"<ns0:name>hToVm</ns0:name>"			\
+						"<ns0:type>HostSystem</ns0:type>"		\
+						"<ns0:path>vm</ns0:path>"			\
+						"<ns0:skip>false</ns0:skip>"			\
+					"</ns0:selectSet>"					\
+				"</ns0:objectSet>"						\
+			"</ns0:spec>"								\
+			"<ns0:partialUpdates>false</ns0:partialUpdates>"			\
+		"</ns0:CreateFilter>"								\
+		ZBX_POST_VSPHERE_FOOTER
+
+	char	*props, *tmp;
+	xmlDoc	*doc = NULL;
+	int	ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	vmware_changes_clean(changes);
+
+	props = vmware_vm_tracked_props();
+	tmp = zbx_dsprintf(NULL, ZBX_POST_VMWARE_CREATE_FILTER,
+			get_vmware_service_objects()[service->type].property_collector, props,
+			get_vmware_service_objects()[service->type].root_folder);
+	zbx_free(props);
+
+	ret = zbx_soap_post(__func__, easyhandle, tmp, &doc, NULL, error);
+	zbx_free(tmp);
+
+	if (SUCCEED != ret)
+		goto out;
+
+	if (NULL == (changes->filter = zbx_xml_doc_read_value(doc, ZBX_XPATH_LN1("returnval"))))
+	{
+		*error = zbx_strdup(*error, "Cannot get property filter id.");
+		ret = FAIL;
+		goto out;
+	}
+
+	if (SUCCEED != (ret = vmware_service_changes_wait(service, easyhandle, changes, NULL, error)))
+		goto out;
+
+	if (NULL == changes->version || NULL == (changes->cookie = vmware_curl_get_cookies(easyhandle)))
+	{
+		*error = zbx_strdup(*error, "Cannot get session state.");
+		ret = FAIL;
+	}
+out:
+	zbx_xml_free_doc(doc);
+
+	if (SUCCEED != ret)
+		vmware_changes_clean(changes);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s filter:'%s'", __func__, zbx_result_string(ret),
+			ZBX_NULL2EMPTY_STR(changes->filter));
+
+	return ret;
+
+#	undef ZBX_POST_VMWARE_CREATE_FILTER
+}
+
+#endif /* defined(HAVE_LIBXML2) && defined(HAVE_LIBCURL) */
@@ -0,0 +1,37 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+#ifndef ZABBIX_VMWARE_CHANGES_H
+#define ZABBIX_VMWARE_CHANGES_H
+
+#include "config.h"
+
+#if defined(HAVE_LIBXML2) && defined(HAVE_LIBCURL)
+
+#include "zbxvmware.h"
+#include "vmware_internal.h"
+
+#include "zbxalgo.h"
+
+void	vmware_changes_clean(zbx_vmware_changes_t *changes);
+void	vmware_changes_dup(zbx_vmware_changes_t *dst, const zbx_vmware_changes_t *src);
+void	vmware_changes_shared_clean(zbx_vmware_changes_t *changes);
+void	vmware_changes_shared_dup(zbx_vmware_changes_t *dst, const zbx_vmware_changes_t *src);
+int	vmware_service_changes_resume(const zbx_vmware_service_t *service, CURL *easyhandle,
+		zbx_vmware_changes_t *changes, zbx_hashset_t *vms, char **error);
+int	vmware_service_changes_track(const zbx_vmware_service_t *service, CURL *easyhandle,
+		zbx_vmware_changes_t *changes, char **error);
+
+#endif	/* defined(HAVE_LIBXML2) && defined(HAVE_LIBCURL) */
+
+#endif	/* ZABBIX_VMWARE_CHANGES_H */
@@ -1209,6 +1209,7 @@ static const char	*vmware_hv_vsan_uuid(zbx_vector_vmware_datastore_ptr_t *dss, z
  *             rpools      - [IN/OUT] vector with all Resource Pools          *
  *             cq_values   - [IN/OUT] vector with custom query entries        *
  *             alarms_data - [IN/OUT] vector with all alarms                  *
+ *             vms         - [IN/OUT] unchanged virtual machines (optional)   *
  *             hv          - [OUT] hypervisor object (must be allocated)      *
  *             error       - [OUT] error message in case of failure           *
  *                                                                            *
@@ -1218,8 +1219,8 @@ static const char	*vmware_hv_vsan_uuid(zbx_vector_vmware_datastore_ptr_t *dss, z
  ******************************************************************************/
 int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandle, const char *id,
 		zbx_vector_vmware_datastore_ptr_t *dss, zbx_vector_vmware_resourcepool_ptr_t *rpools,
-		zbx_vector_cq_value_ptr_t *cq_values, zbx_vmware_alarms_data_t *alarms_data, zbx_vmware_hv_t *hv,
-		char **error)
+		zbx_vector_cq_value_ptr_t *cq_values, zbx_vmware_alarms_data_t *alarms_data, zbx_hashset_t *vms,
+		zbx_vmware_hv_t *hv, char **error)
 {
 #	define ZBX_XPATH_HV_DATASTORES()									\
 		"/*/*/*/*/*/*[local-name()='propSet'][*[local-name()='name'][text()='datastore']]"		\
@@ -1241,7 +1242,7 @@ int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandle, cons
 	char				*value, *cq_prop;
 	int				j, ret;
 	xmlDoc				*details = NULL, *multipath_data = NULL;
-	zbx_vector_str_t		datastores, vms;
+	zbx_vector_str_t		datastores, vm_ids;
 	zbx_vector_cq_value_ptr_t	cqvs;
 	zbx_vector_ptr_pair_t		disks_info;
 
@@ -1254,7 +1255,7 @@ int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandle, cons
 	zbx_vector_vmware_vm_ptr_create(&hv->vms);
 
 	zbx_vector_str_create(&datastores);
-	zbx_vector_str_create(&vms);
+	zbx_vector_str_create(&vm_ids);
 	zbx_vector_ptr_pair_create(&disks_info);
 	zbx_vector_cq_value_ptr_create(&cqvs);
 
@@ -1387,21 +1388,21 @@ int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandle, cons
 	}
 
 	zbx_vector_vmware_dsname_ptr_sort(&hv->dsnames, zbx_vmware_dsname_compare);
-	zbx_xml_read_values(details, ZBX_XPATH_HV_VMS(), &vms);
-	zbx_vector_vmware_vm_ptr_reserve(&hv->vms, (size_t)(vms.values_num + hv->vms.values_alloc));
+	zbx_xml_read_values(details, ZBX_XPATH_HV_VMS(), &vm_ids);
+	zbx_vector_vmware_vm_ptr_reserve(&hv->vms, (size_t)(vm_ids.values_num + hv->vms.values_alloc));
 
-	for (int i = 0; i < vms.values_num; i++)
+	for (int i = 0; i < vm_ids.values_num; i++)
 	{
 		zbx_vmware_vm_t	*vm;
 
-		if (NULL != (vm = vmware_service_create_vm(service, easyhandle, vms.values[i], rpools, cq_values,
-				alarms_data, error)))
+		if (NULL != (vm = vmware_service_create_vm(service, easyhandle, vm_ids.values[i], rpools, cq_values,
+				alarms_data, vms, error)))
 		{
 			zbx_vector_vmware_vm_ptr_append(&hv->vms, vm);
 		}
 		else if (NULL != *error)
 		{
-			zabbix_log(LOG_LEVEL_DEBUG, "Unable initialize vm %s: %s.", vms.values[i], *error);
+			zabbix_log(LOG_LEVEL_DEBUG, "Unable initialize vm %s: %s.", vm_ids.values[i], *error);
 			zbx_free(*error);
 		}
 	}
@@ -1419,8 +1420,8 @@ out:
 	zbx_xml_free_doc(multipath_data);
 	zbx_xml_free_doc(details);
 
-	zbx_vector_str_clear_ext(&vms, zbx_str_free);
-	zbx_vector_str_destroy(&vms);
+	zbx_vector_str_clear_ext(&vm_ids, zbx_str_free);
+	zbx_vector_str_destroy(&vm_ids);
 
 	zbx_vector_str_clear_ext(&datastores, zbx_str_free);
 	zbx_vector_str_destroy(&datastores);
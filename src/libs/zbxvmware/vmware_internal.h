@@ -191,6 +191,8 @@ typedef struct
 }
 ZBX_HTTPPAGE;
 
+int	vmware_curl_set_options(const zbx_vmware_service_t *service, CURL *easyhandle, ZBX_HTTPPAGE *page,
+		const char *config_source_ip, int config_vmware_timeout, char **error);
 int	vmware_service_authenticate(zbx_vmware_service_t *service, CURL *easyhandle, ZBX_HTTPPAGE *page,
 		const char *config_source_ip, int config_vmware_timeout, char **error);
 int	vmware_curl_set_header(CURL *easyhandle, int vc_version, struct curl_slist **headers, char **error);
@@ -25,8 +25,10 @@
 #include "zbxnum.h"
 #include "zbxstr.h"
 #include "zbxxml.h"
+#include "zbxcurl.h"
 #ifdef HAVE_LIBXML2
 #	include <libxml/xpath.h>
+#	include <libxml/parser.h>
 #endif
 
 ZBX_VECTOR_IMPL(uint16, uint16_t)
@@ -663,148 +665,6 @@ void	vmware_service_update_perf_entities(zbx_vmware_service_t *service)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() entities:%d", __func__, service->entities.num_data);
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: updates vmware performance statistics data                        *
- *                                                                            *
- * Parameters: perfdata  - [OUT] performance counter values                   *
- *             xdoc      - [IN] xml document containing performance           *
- *                              counter values for all entities               *
- *             node      - [IN] xml node containing performance counter       *
- *                              values for specified entity                   *
- *                                                                            *
- * Return value: SUCCEED - performance entity data was parsed                 *
- *               FAIL    - performance entity data did not contain valid      *
- *                         values                                             *
- *                                                                            *
- ******************************************************************************/
-static int	vmware_service_process_perf_entity_data(zbx_vmware_perf_data_t *perfdata, xmlDoc *xdoc, xmlNode *node)
-{
-	xmlXPathContext				*xpathCtx;
-	xmlXPathObject				*xpathObj;
-	xmlNodeSetPtr				nodeset;
-	char					*instance, *counter, *value;
-	int					values = 0, ret = FAIL;
-	zbx_vector_vmware_perf_value_ptr_t	*pervalues = &perfdata->values;
-	zbx_vmware_perf_value_t			*perfvalue;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	xpathCtx = xmlXPathNewContext(xdoc);
-	xpathCtx->node = node;
-
-	if (NULL == (xpathObj = xmlXPathEvalExpression((const xmlChar *)"*[local-name()='value']", xpathCtx)))
-		goto out;
-
-	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
-		goto out;
-
-	nodeset = xpathObj->nodesetval;
-	zbx_vector_vmware_perf_value_ptr_reserve(pervalues, (size_t)(nodeset->nodeNr + pervalues->values_alloc));
-
-	for (int i = 0; i < nodeset->nodeNr; i++)
-	{
-		if (NULL == (value = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i],
-				"*[local-name()='value'][text() != '-1'][last()]")))
-		{
-			value = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='value'][last()]");
-		}
-
-		instance = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='id']"
-				"/*[local-name()='instance']");
-		counter = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='id']"
-				"/*[local-name()='counterId']");
-
-		if (NULL != value && NULL != counter)
-		{
-			perfvalue = (zbx_vmware_perf_value_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_value_t));
-
-			ZBX_STR2UINT64(perfvalue->counterid, counter);
-			perfvalue->instance = (NULL != instance ? instance : zbx_strdup(NULL, ""));
-
-			if (0 == strcmp(value, "-1") || SUCCEED != zbx_is_uint64(value, &perfvalue->value))
-			{
-				perfvalue->value = ZBX_MAX_UINT64;
-				zabbix_log(LOG_LEVEL_DEBUG, "PerfCounter inaccessible. type:%s object id:%s "
-						"counter id:" ZBX_FS_UI64 " instance:%s value:%s", perfdata->type,
-						perfdata->id, perfvalue->counterid, perfvalue->instance, value);
-			}
-			else if (FAIL == ret)
-				ret = SUCCEED;
-
-			zbx_vector_vmware_perf_value_ptr_append(pervalues, perfvalue);
-
-			instance = NULL;
-			values++;
-		}
-
-		zbx_free(counter);
-		zbx_free(instance);
-		zbx_free(value);
-	}
-
-out:
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() values:%d", __func__, values);
-
-	return ret;
-}
-
-/******************************************************************************
- *                                                                            *
- * Purpose: updates vmware performance statistics data                        *
- *                                                                            *
- * Parameters: perfdata - [OUT] performance entity data                       *
- *             xdoc     - [IN] performance data xml document                  *
- *                                                                            *
- ******************************************************************************/
-static void	vmware_service_parse_perf_data(zbx_vector_vmware_perf_data_ptr_t *perfdata, xmlDoc *xdoc)
-{
-	xmlXPathContext	*xpathCtx;
-	xmlXPathObject	*xpathObj;
-	xmlNodeSetPtr	nodeset;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	xpathCtx = xmlXPathNewContext(xdoc);
-
-	if (NULL == (xpathObj = xmlXPathEvalExpression((const xmlChar *)"/*/*/*/*", xpathCtx)))
-		goto clean;
-
-	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
-		goto clean;
-
-	nodeset = xpathObj->nodesetval;
-	zbx_vector_vmware_perf_data_ptr_reserve(perfdata, (size_t)(nodeset->nodeNr + perfdata->values_alloc));
-
-	for (int i = 0; i < nodeset->nodeNr; i++)
-	{
-		zbx_vmware_perf_data_t	*data;
-		int			ret = FAIL;
-
-		data = (zbx_vmware_perf_data_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_data_t));
-
-		data->id = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='entity']");
-		data->type = zbx_xml_node_read_value(xdoc, nodeset->nodeTab[i], "*[local-name()='entity']/@type");
-		data->error = NULL;
-		zbx_vector_vmware_perf_value_ptr_create(&data->values);
-
-		if (NULL != data->type && NULL != data->id)
-			ret = vmware_service_process_perf_entity_data(data, xdoc, nodeset->nodeTab[i]);
-
-		if (SUCCEED == ret)
-			zbx_vector_vmware_perf_data_ptr_append(perfdata, data);
-		else
-			vmware_free_perfdata(data);
-	}
-clean:
-	xmlXPathFreeObject(xpathObj);
-	xmlXPathFreeContext(xpathCtx);
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: adds error for specified perf entity                              *
@@ -892,142 +752,758 @@ static void	vmware_service_copy_perf_data(const zbx_vmware_service_t *service,
 
 #define ZBX_XML_DATETIME		26
 
+#define ZBX_VMWARE_PERF_QUERY_ENTITIES_MAX	250	/* entities per performance counter query */
+#define ZBX_VMWARE_PERF_REQUESTS_MAX		4	/* concurrent performance counter queries */
+
+#define ZBX_VMWARE_PERF_XML_NONE		0
+#define ZBX_VMWARE_PERF_XML_ENTITY		1
+#define ZBX_VMWARE_PERF_XML_COUNTERID		2
+#define ZBX_VMWARE_PERF_XML_INSTANCE		3
+#define ZBX_VMWARE_PERF_XML_VALUE		4
+#define ZBX_VMWARE_PERF_XML_FAULTSTRING		5
+
+/* QueryPerf response parser state */
+typedef struct
+{
+	zbx_vector_vmware_perf_data_ptr_t	perfdata;
+
+	/* entity being parsed and whether it has accessible values */
+	zbx_vmware_perf_data_t			*data;
+	int					data_valid;
+
+	/* metric series being parsed, value_valid is the last sample other than -1 */
+	char					*counterid;
+	char					*instance;
+	char					*value;
+	char					*value_valid;
+
+	char					*faultstring;
+	char					*faultdetail;
+
+	int					depth;
+	unsigned char				in_fault;
+	unsigned char				in_detail;
+	unsigned char				in_series;
+	unsigned char				in_id;
+
+	/* text content of the element being read */
+	unsigned char				text_type;
+	int					text_depth;
+	char					*text;
+	size_t					text_alloc;
+	size_t					text_offset;
+}
+zbx_vmware_perf_parser_t;
+
+static void	vmware_perf_parser_init(zbx_vmware_perf_parser_t *parser)
+{
+	memset(parser, 0, sizeof(zbx_vmware_perf_parser_t));
+	zbx_vector_vmware_perf_data_ptr_create(&parser->perfdata);
+}
+
+static void	vmware_perf_parser_series_clear(zbx_vmware_perf_parser_t *parser)
+{
+	zbx_free(parser->counterid);
+	zbx_free(parser->instance);
+	zbx_free(parser->value);
+	zbx_free(parser->value_valid);
+}
+
+static void	vmware_perf_parser_destroy(zbx_vmware_perf_parser_t *parser)
+{
+	vmware_perf_parser_series_clear(parser);
+
+	if (NULL != parser->data)
+		vmware_free_perfdata(parser->data);
+
+	zbx_vector_vmware_perf_data_ptr_clear_ext(&parser->perfdata, vmware_free_perfdata);
+	zbx_vector_vmware_perf_data_ptr_destroy(&parser->perfdata);
+
+	zbx_free(parser->faultstring);
+	zbx_free(parser->faultdetail);
+	zbx_free(parser->text);
+}
+
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieves performance counter values from vmware service          *
+ * Purpose: adds parsed metric series value to performance entity data        *
  *                                                                            *
- * Parameters: service      - [IN] vmware service                             *
- *             easyhandle   - [IN] prepared cURL connection handle            *
- *             entities     - [IN] performance collector entities to retrieve *
- *                                 counters for                               *
- *             counters_max - [IN] maximum number of counters per query       *
- *             perfdata     - [OUT] performance counter values                *
+ * Comments: The last sample value other than -1 is used if the series has    *
+ *           one, otherwise the value is marked as inaccessible.              *
  *                                                                            *
  ******************************************************************************/
-static void	vmware_service_retrieve_perf_counters(zbx_vmware_service_t *service, CURL *easyhandle,
-		zbx_vector_vmware_perf_entity_ptr_t *entities, int counters_max,
-		zbx_vector_vmware_perf_data_ptr_t *perfdata)
+static void	vmware_perf_parser_series_end(zbx_vmware_perf_parser_t *parser)
 {
-	char				*tmp = NULL, *error = NULL;
-	size_t				tmp_alloc = 0, tmp_offset;
-	int				i, j, start_counter = 0;
-	zbx_vmware_perf_entity_t	*entity;
-	xmlDoc				*doc = NULL;
+	zbx_vmware_perf_data_t	*data = parser->data;
+	zbx_vmware_perf_value_t	*perfvalue;
+	const char		*value;
+
+	if (NULL == (value = (NULL != parser->value_valid ? parser->value_valid : parser->value)) ||
+			NULL == parser->counterid)
+	{
+		goto out;
+	}
+
+	perfvalue = (zbx_vmware_perf_value_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_value_t));
+
+	ZBX_STR2UINT64(perfvalue->counterid, parser->counterid);
+	perfvalue->instance = (NULL != parser->instance ? parser->instance : zbx_strdup(NULL, ""));
+	parser->instance = NULL;
+
+	if (0 == strcmp(value, "-1") || SUCCEED != zbx_is_uint64(value, &perfvalue->value))
+	{
+		perfvalue->value = ZBX_MAX_UINT64;
+		zabbix_log(LOG_LEVEL_DEBUG, "PerfCounter inaccessible. type:%s object id:%s "
+				"counter id:" ZBX_FS_UI64 " instance:%s value:%s", ZBX_NULL2EMPTY_STR(data->type),
+				ZBX_NULL2EMPTY_STR(data->id), perfvalue->counterid, perfvalue->instance, value);
+	}
+	else
+		parser->data_valid = 1;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() counters_max:%d", __func__, counters_max);
+	zbx_vector_vmware_perf_value_ptr_append(&data->values, perfvalue);
+out:
+	vmware_perf_parser_series_clear(parser);
+}
+
+static void	vmware_perf_parser_entity_start(zbx_vmware_perf_parser_t *parser)
+{
+	zbx_vmware_perf_data_t	*data;
+
+	data = (zbx_vmware_perf_data_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_data_t));
+	data->id = NULL;
+	data->type = NULL;
+	data->error = NULL;
+	zbx_vector_vmware_perf_value_ptr_create(&data->values);
+
+	parser->data = data;
+	parser->data_valid = 0;
+}
+
+static void	vmware_perf_parser_entity_end(zbx_vmware_perf_parser_t *parser)
+{
+	zbx_vmware_perf_data_t	*data = parser->data;
+
+	if (NULL != data->type && NULL != data->id && 0 != parser->data_valid)
+		zbx_vector_vmware_perf_data_ptr_append(&parser->perfdata, data);
+	else
+		vmware_free_perfdata(data);
 
-	while (0 != entities->values_num)
+	parser->data = NULL;
+}
+
+static void	vmware_perf_parser_text_end(zbx_vmware_perf_parser_t *parser)
+{
+	char	*text;
+
+	text = zbx_strdup(NULL, NULL != parser->text ? parser->text : "");
+	parser->text_offset = 0;
+
+	switch (parser->text_type)
 	{
-		int	counters_num = 0;
+		case ZBX_VMWARE_PERF_XML_ENTITY:
+			zbx_free(parser->data->id);
+			parser->data->id = text;
+			break;
+		case ZBX_VMWARE_PERF_XML_COUNTERID:
+			zbx_free(parser->counterid);
+			parser->counterid = text;
+			break;
+		case ZBX_VMWARE_PERF_XML_INSTANCE:
+			zbx_free(parser->instance);
+			parser->instance = text;
+			break;
+		case ZBX_VMWARE_PERF_XML_VALUE:
+			if (0 != strcmp(text, "-1"))
+			{
+				zbx_free(parser->value_valid);
+				parser->value_valid = zbx_strdup(NULL, text);
+			}
 
-		tmp_offset = 0;
-		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, ZBX_POST_VSPHERE_HEADER);
-		zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:QueryPerf>"
-				"<ns0:_this type=\"PerformanceManager\">%s</ns0:_this>",
-				get_vmware_service_objects()[service->type].performance_manager);
+			zbx_free(parser->value);
+			parser->value = text;
+			break;
+		case ZBX_VMWARE_PERF_XML_FAULTSTRING:
+			zbx_free(parser->faultstring);
+			parser->faultstring = text;
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			zbx_free(text);
+	}
 
-		zbx_vmware_lock();
+	parser->text_type = ZBX_VMWARE_PERF_XML_NONE;
+}
 
-		for (i = entities->values_num - 1; 0 <= i && counters_num < counters_max;)
+static char	*vmware_perf_xml_attribute(int nb_attributes, const xmlChar **attributes, const char *name)
+{
+	/* SAX2 attributes are passed as localname/prefix/URI/value/end tuples */
+	for (int i = 0; i < nb_attributes; i++, attributes += 5)
+	{
+		if (0 == strcmp((const char *)attributes[0], name))
 		{
-			char	*id_esc;
+			return zbx_dsprintf(NULL, "%.*s", (int)(attributes[4] - attributes[3]),
+					(const char *)attributes[3]);
+		}
+	}
 
-			entity = (zbx_vmware_perf_entity_t *)entities->values[i];
+	return NULL;
+}
 
-			id_esc = zbx_xml_escape_dyn(entity->id);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: SAX2 element start handler for QueryPerf response                 *
+ *                                                                            *
+ * Comments: The response elements are identified by depth and local name:    *
+ *             Envelope/Body/QueryPerfResponse/returnval/entity               *
+ *             Envelope/Body/QueryPerfResponse/returnval/value/id/counterId   *
+ *             Envelope/Body/QueryPerfResponse/returnval/value/id/instance    *
+ *             Envelope/Body/QueryPerfResponse/returnval/value/value          *
+ *             Envelope/Body/Fault/faultstring                                *
+ *             Envelope/Body/Fault/detail/<fault name>                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_xml_start(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI,
+		int nb_namespaces, const xmlChar **namespaces, int nb_attributes, int nb_defaulted,
+		const xmlChar **attributes)
+{
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)ctx;
+	const char			*name = (const char *)localname;
+	unsigned char			text_type = ZBX_VMWARE_PERF_XML_NONE;
+
+	ZBX_UNUSED(prefix);
+	ZBX_UNUSED(URI);
+	ZBX_UNUSED(nb_namespaces);
+	ZBX_UNUSED(namespaces);
+	ZBX_UNUSED(nb_defaulted);
 
-			/* add entity performance counter request */
-			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:querySpec>"
-					"<ns0:entity type=\"%s\">%s</ns0:entity>", entity->type, id_esc);
+	parser->depth++;
 
-			zbx_free(id_esc);
+	/* markup inside text values is ignored */
+	if (ZBX_VMWARE_PERF_XML_NONE != parser->text_type)
+		return;
 
-			if (ZBX_VMWARE_PERF_INTERVAL_NONE == entity->refresh)
+	switch (parser->depth)
+	{
+		case 3:
+			if (0 == strcmp(name, "Fault"))
+				parser->in_fault = 1;
+			break;
+		case 4:
+			if (0 != parser->in_fault)
+			{
+				if (0 == strcmp(name, "faultstring"))
+					text_type = ZBX_VMWARE_PERF_XML_FAULTSTRING;
+				else if (0 == strcmp(name, "detail"))
+					parser->in_detail = 1;
+			}
+			else if (0 == strcmp(name, "returnval"))
+				vmware_perf_parser_entity_start(parser);
+			break;
+		case 5:
+			if (0 != parser->in_detail)
+			{
+				if (NULL == parser->faultdetail)
+					parser->faultdetail = zbx_strdup(NULL, name);
+			}
+			else if (NULL != parser->data)
+			{
+				if (0 == strcmp(name, "entity"))
+				{
+					zbx_free(parser->data->type);
+					parser->data->type = vmware_perf_xml_attribute(nb_attributes, attributes, "type");
+					text_type = ZBX_VMWARE_PERF_XML_ENTITY;
+				}
+				else if (0 == strcmp(name, "value"))
+					parser->in_series = 1;
+			}
+			break;
+		case 6:
+			if (0 != parser->in_series)
+			{
+				if (0 == strcmp(name, "id"))
+					parser->in_id = 1;
+				else if (0 == strcmp(name, "value"))
+					text_type = ZBX_VMWARE_PERF_XML_VALUE;
+			}
+			break;
+		case 7:
+			if (0 != parser->in_id)
 			{
-				time_t	st_raw;
-				struct	tm st;
-				char	st_str[ZBX_XML_DATETIME];
+				if (0 == strcmp(name, "counterId"))
+					text_type = ZBX_VMWARE_PERF_XML_COUNTERID;
+				else if (0 == strcmp(name, "instance"))
+					text_type = ZBX_VMWARE_PERF_XML_INSTANCE;
+			}
+			break;
+	}
 
-				/* add startTime for entity performance counter request for decrease xml data load */
-				st_raw = time(NULL) - SEC_PER_HOUR;
-				gmtime_r(&st_raw, &st);
-				strftime(st_str, sizeof(st_str), "%Y-%m-%dT%TZ", &st);
-				zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:startTime>%s</ns0:startTime>",
-						st_str);
+	if (ZBX_VMWARE_PERF_XML_NONE != text_type)
+	{
+		parser->text_type = text_type;
+		parser->text_depth = parser->depth;
+		parser->text_offset = 0;
+
+		if (NULL != parser->text)
+			*parser->text = '\0';
+	}
+}
+
+static void	vmware_perf_xml_end(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI)
+{
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)ctx;
+
+	ZBX_UNUSED(localname);
+	ZBX_UNUSED(prefix);
+	ZBX_UNUSED(URI);
+
+	if (ZBX_VMWARE_PERF_XML_NONE != parser->text_type)
+	{
+		if (parser->text_depth == parser->depth)
+			vmware_perf_parser_text_end(parser);
+
+		parser->depth--;
+		return;
+	}
+
+	switch (parser->depth)
+	{
+		case 3:
+			parser->in_fault = 0;
+			break;
+		case 4:
+			if (NULL != parser->data)
+				vmware_perf_parser_entity_end(parser);
+
+			parser->in_detail = 0;
+			break;
+		case 5:
+			if (0 != parser->in_series)
+			{
+				vmware_perf_parser_series_end(parser);
+				parser->in_series = 0;
 			}
+			break;
+		case 6:
+			parser->in_id = 0;
+			break;
+	}
+
+	parser->depth--;
+}
+
+static void	vmware_perf_xml_characters(void *ctx, const xmlChar *ch, int len)
+{
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)ctx;
+
+	if (ZBX_VMWARE_PERF_XML_NONE != parser->text_type)
+		zbx_strncpy_alloc(&parser->text, &parser->text_alloc, &parser->text_offset, (const char *)ch, len);
+}
+
+#if 21200 > LIBXML_VERSION /* version 2.12.0 */
+static void	vmware_perf_xml_error(void *ctx, xmlErrorPtr error)
+#else
+static void	vmware_perf_xml_error(void *ctx, const xmlError *error)
+#endif
+{
+	/* errors are reported by xmlParseChunk() return value */
+	ZBX_UNUSED(ctx);
+	ZBX_UNUSED(error);
+}
+
+/* QueryPerf request sent concurrently with other requests of the same service */
+typedef struct
+{
+	CURL					*easyhandle;
+	char					*post;
+	xmlParserCtxtPtr			xml;
+	zbx_vmware_perf_parser_t		parser;
+	char					*error;
+
+	/* entities queried by request, used to report errors */
+	zbx_vector_vmware_perf_entity_ptr_t	entities;
+}
+zbx_vmware_perf_request_t;
 
-			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:maxSample>2</ns0:maxSample>");
+static void	vmware_perf_request_set_xml_error(zbx_vmware_perf_request_t *request)
+{
+	const xmlError	*err;
+
+	if (NULL != (err = xmlCtxtGetLastError(request->xml)) && NULL != err->message)
+	{
+		request->error = zbx_dsprintf(request->error, "Received response has no valid XML data: %s",
+				err->message);
+		zbx_rtrim(request->error, "\n");
+	}
+	else
+		request->error = zbx_strdup(request->error, "Received response has no valid XML data.");
+}
+
+static size_t	vmware_perf_request_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+	size_t				r_size = size * nmemb;
+	zbx_vmware_perf_request_t	*request = (zbx_vmware_perf_request_t *)userdata;
+
+	zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP response: %.*s", __func__, (int)r_size, (const char *)ptr);
+
+	if (0 != xmlParseChunk(request->xml, (const char *)ptr, (int)r_size, 0))
+	{
+		vmware_perf_request_set_xml_error(request);
+
+		/* abort transfer */
+		return 0;
+	}
+
+	return r_size;
+}
+
+static void	vmware_perf_request_free(zbx_vmware_perf_request_t *request)
+{
+	if (NULL != request->easyhandle)
+		curl_easy_cleanup(request->easyhandle);
+
+	if (NULL != request->xml)
+		xmlFreeParserCtxt(request->xml);
+
+	vmware_perf_parser_destroy(&request->parser);
+	zbx_vector_vmware_perf_entity_ptr_destroy(&request->entities);
+	zbx_free(request->post);
+	zbx_free(request->error);
+	zbx_free(request);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares connection handle and streaming response parser of       *
+ *          performance counter request                                       *
+ *                                                                            *
+ * Parameters: request    - [IN/OUT]                                          *
+ *             easyhandle - [IN] authenticated cURL connection handle         *
+ *             share      - [IN] cURL share handle with session cookie        *
+ *                                                                            *
+ * Return value: SUCCEED - request is ready to be performed                   *
+ *               FAIL    - otherwise, request->error is set                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_perf_request_prepare(zbx_vmware_perf_request_t *request, CURL *easyhandle, CURLSH *share)
+{
+	static xmlSAXHandler	sax;
+	CURLoption		opt;
+	CURLcode		err;
+
+	if (XML_SAX2_MAGIC != sax.initialized)
+	{
+		sax.initialized = XML_SAX2_MAGIC;
+		sax.startElementNs = vmware_perf_xml_start;
+		sax.endElementNs = vmware_perf_xml_end;
+		sax.characters = vmware_perf_xml_characters;
+		sax.serror = vmware_perf_xml_error;
+	}
+
+	if (NULL == (request->xml = xmlCreatePushParserCtxt(&sax, &request->parser, NULL, 0, NULL)))
+	{
+		request->error = zbx_strdup(request->error, "cannot create XML parser");
+		return FAIL;
+	}
+
+	/* session cookie, connection and other options are taken from the authenticated handle */
+	if (NULL == (request->easyhandle = curl_easy_duphandle(easyhandle)))
+	{
+		request->error = zbx_strdup(request->error, "cannot initialize cURL library");
+		return FAIL;
+	}
+
+	if (CURLE_OK != (err = curl_easy_setopt(request->easyhandle, opt = CURLOPT_SHARE, share)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->easyhandle, opt = CURLOPT_WRITEFUNCTION,
+					vmware_perf_request_write_cb)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->easyhandle, opt = CURLOPT_WRITEDATA, request)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->easyhandle, opt = CURLOPT_PRIVATE, request)) ||
+			CURLE_OK != (err = curl_easy_setopt(request->easyhandle, opt = CURLOPT_POSTFIELDS,
+					request->post)))
+	{
+		request->error = zbx_dsprintf(request->error, "Cannot set cURL option %d: %s.", (int)opt,
+				curl_easy_strerror(err));
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates performance counter request for entities at the end of    *
+ *          the list                                                          *
+ *                                                                            *
+ * Parameters: service       - [IN] vmware service                            *
+ *             entities      - [IN/OUT] performance collector entities, the   *
+ *                                      entities with all counters queried    *
+ *                                      are removed from the list             *
+ *             counters_max  - [IN] maximum number of counters per query      *
+ *             start_counter - [IN/OUT] first counter to query of the last    *
+ *                                      entity in the list                    *
+ *                                                                            *
+ * Return value: created request                                              *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vmware_perf_request_t	*vmware_perf_request_create(const zbx_vmware_service_t *service,
+		zbx_vector_vmware_perf_entity_ptr_t *entities, int counters_max, int *start_counter)
+{
+	zbx_vmware_perf_request_t	*request;
+	size_t				post_alloc = 0, post_offset = 0;
+	int				j, counters_num = 0;
+
+	request = (zbx_vmware_perf_request_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_request_t));
+	memset(request, 0, sizeof(zbx_vmware_perf_request_t));
+	vmware_perf_parser_init(&request->parser);
+	zbx_vector_vmware_perf_entity_ptr_create(&request->entities);
+
+	zbx_strcpy_alloc(&request->post, &post_alloc, &post_offset, ZBX_POST_VSPHERE_HEADER);
+	zbx_snprintf_alloc(&request->post, &post_alloc, &post_offset, "<ns0:QueryPerf>"
+			"<ns0:_this type=\"PerformanceManager\">%s</ns0:_this>",
+			get_vmware_service_objects()[service->type].performance_manager);
+
+	zbx_vmware_lock();
+
+	while (0 != entities->values_num && counters_num < counters_max &&
+			ZBX_VMWARE_PERF_QUERY_ENTITIES_MAX > request->entities.values_num)
+	{
+		zbx_vmware_perf_entity_t	*entity;
+		char				*id_esc;
+
+		entity = entities->values[entities->values_num - 1];
+		zbx_vector_vmware_perf_entity_ptr_append(&request->entities, entity);
+
+		id_esc = zbx_xml_escape_dyn(entity->id);
+
+		/* add entity performance counter request */
+		zbx_snprintf_alloc(&request->post, &post_alloc, &post_offset, "<ns0:querySpec>"
+				"<ns0:entity type=\"%s\">%s</ns0:entity>", entity->type, id_esc);
+
+		zbx_free(id_esc);
+
+		if (ZBX_VMWARE_PERF_INTERVAL_NONE == entity->refresh)
+		{
+			time_t	st_raw;
+			struct	tm st;
+			char	st_str[ZBX_XML_DATETIME];
+
+			/* add startTime for entity performance counter request for decrease xml data load */
+			st_raw = time(NULL) - SEC_PER_HOUR;
+			gmtime_r(&st_raw, &st);
+			strftime(st_str, sizeof(st_str), "%Y-%m-%dT%TZ", &st);
+			zbx_snprintf_alloc(&request->post, &post_alloc, &post_offset,
+					"<ns0:startTime>%s</ns0:startTime>", st_str);
+		}
+
+		zbx_snprintf_alloc(&request->post, &post_alloc, &post_offset, "<ns0:maxSample>2</ns0:maxSample>");
+
+		for (j = *start_counter; j < entity->counters.values_num && counters_num < counters_max; j++)
+		{
+			zbx_vmware_perf_counter_t	*counter;
+
+			counter = (zbx_vmware_perf_counter_t *)entity->counters.values[j];
 
-			for (j = start_counter; j < entity->counters.values_num && counters_num < counters_max; j++)
+			if (0 != (counter->state & ZBX_VMWARE_COUNTER_CUSTOM) &&
+					0 == (counter->state & ZBX_VMWARE_COUNTER_ACCEPTABLE))
 			{
-				zbx_vmware_perf_counter_t	*counter;
+				continue;
+			}
 
-				counter = (zbx_vmware_perf_counter_t *)entity->counters.values[j];
+			zbx_snprintf_alloc(&request->post, &post_alloc, &post_offset,
+					"<ns0:metricId><ns0:counterId>" ZBX_FS_UI64
+					"</ns0:counterId><ns0:instance>%s</ns0:instance></ns0:metricId>",
+					counter->counterid, NULL == counter->query_instance ?
+					entity->query_instance : counter->query_instance);
 
-				if (0 != (counter->state & ZBX_VMWARE_COUNTER_CUSTOM) &&
-						0 == (counter->state & ZBX_VMWARE_COUNTER_ACCEPTABLE))
-				{
-					continue;
-				}
+			counter->state |= ZBX_VMWARE_COUNTER_UPDATING;
+
+			counters_num++;
+		}
+
+		if (ZBX_VMWARE_PERF_INTERVAL_NONE != entity->refresh)
+		{
+			zbx_snprintf_alloc(&request->post, &post_alloc, &post_offset,
+					"<ns0:intervalId>%d</ns0:intervalId>", entity->refresh);
+		}
+
+		zbx_snprintf_alloc(&request->post, &post_alloc, &post_offset, "</ns0:querySpec>");
+
+		if (j == entity->counters.values_num)
+		{
+			*start_counter = 0;
+			zbx_vector_vmware_perf_entity_ptr_remove_noorder(entities, entities->values_num - 1);
+		}
+		else
+			*start_counter = j;
+	}
+
+	zbx_vmware_unlock();
+
+	zbx_strcpy_alloc(&request->post, &post_alloc, &post_offset, "</ns0:QueryPerf>");
+	zbx_strcpy_alloc(&request->post, &post_alloc, &post_offset, ZBX_POST_VSPHERE_FOOTER);
+
+	zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP request: %s", __func__, request->post);
+
+	return request;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finishes parsing of performance counter request response and      *
+ *          collects its results                                              *
+ *                                                                            *
+ * Parameters: request  - [IN] performance counter request, freed by this     *
+ *                             function                                       *
+ *             result   - [IN] cURL transfer result                           *
+ *             perfdata - [OUT] performance counter values                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_request_complete(zbx_vmware_perf_request_t *request, CURLcode result,
+		zbx_vector_vmware_perf_data_ptr_t *perfdata)
+{
+	zbx_vmware_perf_parser_t	*parser = &request->parser;
+
+	if (NULL == request->error)
+	{
+		if (CURLE_OK != result)
+			request->error = zbx_strdup(NULL, curl_easy_strerror(result));
+		else if (0 != xmlParseChunk(request->xml, NULL, 0, 1))
+			vmware_perf_request_set_xml_error(request);
+		else if (NULL != parser->faultstring && '\0' != *parser->faultstring)
+			request->error = zbx_strdup(NULL, parser->faultstring);
+		else if (NULL != parser->faultdetail)
+			request->error = zbx_strdup(NULL, parser->faultdetail);
+	}
+
+	if (NULL != request->error)
+	{
+		for (int i = 0; i < request->entities.values_num; i++)
+		{
+			zbx_vmware_perf_entity_t	*entity = request->entities.values[i];
+
+			vmware_perf_data_add_error(perfdata, entity->type, entity->id, request->error);
+		}
+	}
+	else
+	{
+		zbx_vector_vmware_perf_data_ptr_append_array(perfdata, parser->perfdata.values,
+				parser->perfdata.values_num);
+		zbx_vector_vmware_perf_data_ptr_clear(&parser->perfdata);
+	}
+
+	vmware_perf_request_free(request);
+}
 
-				zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset,
-						"<ns0:metricId><ns0:counterId>" ZBX_FS_UI64
-						"</ns0:counterId><ns0:instance>%s</ns0:instance></ns0:metricId>",
-						counter->counterid, NULL == counter->query_instance ?
-						entity->query_instance : counter->query_instance);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves performance counter values from vmware service          *
+ *                                                                            *
+ * Parameters: service      - [IN] vmware service                             *
+ *             easyhandle   - [IN] authenticated cURL connection handle       *
+ *             share        - [IN] cURL share handle used by easyhandle       *
+ *             entities     - [IN] performance collector entities to retrieve *
+ *                                 counters for                               *
+ *             counters_max - [IN] maximum number of counters per query       *
+ *             perfdata     - [OUT] performance counter values                *
+ *                                                                            *
+ * Comments: Entities are split into several queries which are sent           *
+ *           concurrently. Responses are parsed while they are received       *
+ *           without building xml document of the whole response.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_service_retrieve_perf_counters(zbx_vmware_service_t *service, CURL *easyhandle,
+		CURLSH *share, zbx_vector_vmware_perf_entity_ptr_t *entities, int counters_max,
+		zbx_vector_vmware_perf_data_ptr_t *perfdata)
+{
+	zbx_vmware_perf_request_t	*requests[ZBX_VMWARE_PERF_REQUESTS_MAX], *request;
+	CURLM				*multi = NULL;
+	CURLMcode			merr;
+	CURLMsg				*msg;
+	int				requests_num = 0, start_counter = 0, running, msgs_left, fds, i;
 
-				counter->state |= ZBX_VMWARE_COUNTER_UPDATING;
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() counters_max:%d entities:%d", __func__, counters_max,
+			entities->values_num);
 
-				counters_num++;
+	/* without curl_multi_wait() queries are sent one after another */
+	if (SUCCEED == zbx_curl_good_for_elasticsearch(NULL) && NULL == (multi = curl_multi_init()))
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot initialize cURL multi session", __func__);
+
+	while (0 != entities->values_num || 0 != requests_num)
+	{
+		while (0 != entities->values_num && ((NULL == multi && 0 == requests_num) ||
+				(NULL != multi && ZBX_VMWARE_PERF_REQUESTS_MAX > requests_num)))
+		{
+			request = vmware_perf_request_create(service, entities, counters_max, &start_counter);
+
+			if (SUCCEED != vmware_perf_request_prepare(request, easyhandle, share))
+			{
+				vmware_perf_request_complete(request, CURLE_OK, perfdata);
+				continue;
 			}
 
-			if (j == entity->counters.values_num)
+			if (NULL == multi)
 			{
-				start_counter = 0;
-				i--;
+				vmware_perf_request_complete(request, curl_easy_perform(request->easyhandle), perfdata);
+				continue;
 			}
-			else
-				start_counter = j;
 
-			if (ZBX_VMWARE_PERF_INTERVAL_NONE != entity->refresh)
+			if (CURLM_OK != (merr = curl_multi_add_handle(multi, request->easyhandle)))
 			{
-				zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:intervalId>%d</ns0:intervalId>",
-					entity->refresh);
+				request->error = zbx_dsprintf(NULL, "cannot add cURL handle: %s",
+						curl_multi_strerror(merr));
+				vmware_perf_request_complete(request, CURLE_OK, perfdata);
+				continue;
 			}
 
-			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "</ns0:querySpec>");
+			requests[requests_num++] = request;
 		}
 
-		zbx_vmware_unlock();
-		zbx_xml_free_doc(doc);
-		doc = NULL;
+		if (0 == requests_num)
+			continue;
 
-		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, "</ns0:QueryPerf>");
-		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, ZBX_POST_VSPHERE_FOOTER);
+		if (CURLM_OK != (merr = curl_multi_perform(multi, &running)))
+		{
+			/* fail pending queries and send the rest one after another */
+			for (i = 0; i < requests_num; i++)
+			{
+				curl_multi_remove_handle(multi, requests[i]->easyhandle);
+				requests[i]->error = zbx_dsprintf(NULL, "cannot perform request: %s",
+						curl_multi_strerror(merr));
+				vmware_perf_request_complete(requests[i], CURLE_OK, perfdata);
+			}
 
-		zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP request: %s", __func__, tmp);
+			requests_num = 0;
+			curl_multi_cleanup(multi);
+			multi = NULL;
+			continue;
+		}
 
-		if (SUCCEED != zbx_soap_post(__func__, easyhandle, tmp, &doc, NULL, &error))
+		while (NULL != (msg = curl_multi_info_read(multi, &msgs_left)))
 		{
-			for (j = i + 1; j < entities->values_num; j++)
+			if (CURLMSG_DONE != msg->msg)
+				continue;
+
+			for (i = 0; i < requests_num && requests[i]->easyhandle != msg->easy_handle; i++)
+				;
+
+			if (i == requests_num)
 			{
-				entity = (zbx_vmware_perf_entity_t *)entities->values[j];
-				vmware_perf_data_add_error(perfdata, entity->type, entity->id, error);
+				THIS_SHOULD_NEVER_HAPPEN;
+				continue;
 			}
 
-			zbx_free(error);
-			break;
-		}
+			request = requests[i];
+			requests[i] = requests[--requests_num];
 
-		/* parse performance data into local memory */
-		vmware_service_parse_perf_data(perfdata, doc);
+			curl_multi_remove_handle(multi, request->easyhandle);
+			vmware_perf_request_complete(request, msg->data.result, perfdata);
+		}
 
-		while (entities->values_num > i + 1)
-			zbx_vector_vmware_perf_entity_ptr_remove_noorder(entities, entities->values_num - 1);
+		if (0 != running)
+			zbx_curl_multi_wait(multi, SEC_PER_MIN * 1000, &fds);
 	}
 
-	zbx_free(tmp);
-	zbx_xml_free_doc(doc);
+	if (NULL != multi)
+		curl_multi_cleanup(multi);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -1252,6 +1728,7 @@ int	zbx_vmware_service_update_perf(zbx_vmware_service_t *service, const char *co
 {
 #define INIT_PERF_XML_SIZE	200 * ZBX_KIBIBYTE
 	CURL					*easyhandle = NULL;
+	CURLSH					*share = NULL;
 	CURLoption				opt;
 	CURLcode				err;
 	struct curl_slist			*headers = NULL;
@@ -1279,13 +1756,24 @@ int	zbx_vmware_service_update_perf(zbx_vmware_service_t *service, const char *co
 		goto out;
 	}
 
+	/* session cookie is shared with connections of concurrent performance counter queries */
+	if (NULL == (share = curl_share_init()) ||
+			CURLSHE_OK != curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE) ||
+			CURLSHE_OK != curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) ||
+			CURLSHE_OK != curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION))
+	{
+		error = zbx_strdup(error, "cannot initialize cURL share interface");
+		goto clean;
+	}
+
 	page.alloc = INIT_PERF_XML_SIZE;
 	page.data = (char *)zbx_malloc(NULL, page.alloc);
 	headers = curl_slist_append(headers, ZBX_XML_HEADER1_V4);
 	headers = curl_slist_append(headers, ZBX_XML_HEADER2);
 	headers = curl_slist_append(headers, ZBX_XML_HEADER3);
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_HTTPHEADER, headers)))
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_HTTPHEADER, headers)) ||
+			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_SHARE, share)))
 	{
 		error = zbx_dsprintf(error, "Cannot set cURL option %d: %s.", (int)opt, curl_easy_strerror(err));
 		goto clean;
@@ -1415,9 +1903,10 @@ int	zbx_vmware_service_update_perf(zbx_vmware_service_t *service, const char *co
 
 	zbx_vmware_unlock();
 
-	vmware_service_retrieve_perf_counters(service, easyhandle, &entities, ZBX_MAXQUERYMETRICS_UNLIMITED, &perfdata);
-	vmware_service_retrieve_perf_counters(service, easyhandle, &hist_entities, service->data->max_query_metrics,
+	vmware_service_retrieve_perf_counters(service, easyhandle, share, &entities, ZBX_MAXQUERYMETRICS_UNLIMITED,
 			&perfdata);
+	vmware_service_retrieve_perf_counters(service, easyhandle, share, &hist_entities,
+			service->data->max_query_metrics, &perfdata);
 
 	if (SUCCEED != vmware_service_logout(service, easyhandle, &error))
 	{
@@ -1429,6 +1918,11 @@ int	zbx_vmware_service_update_perf(zbx_vmware_service_t *service, const char *co
 clean:
 	curl_slist_free_all(headers);
 	curl_easy_cleanup(easyhandle);
+
+	/* share can be released only after all handles using it are cleaned up */
+	if (NULL != share)
+		curl_share_cleanup(share);
+
 	zbx_free(page.data);
 out:
 	zbx_vmware_lock();
@@ -183,6 +183,92 @@ void	vmware_vm_free(zbx_vmware_vm_t *vm)
 	zbx_free(vm);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies object properties list                                     *
+ *                                                                            *
+ * Parameters: src       - [IN] properties list                               *
+ *             props_num - [IN] number of properties in list                  *
+ *                                                                            *
+ * Return value: duplicated object properties list                            *
+ *                                                                            *
+ ******************************************************************************/
+static char	**vmware_props_dup(char ** const src, int props_num)
+{
+	char	**props;
+
+	if (NULL == src)
+		return NULL;
+
+	props = (char **)zbx_malloc(NULL, sizeof(char *) * props_num);
+
+	for (int i = 0; i < props_num; i++)
+		props[i] = NULL != src[i] ? zbx_strdup(NULL, src[i]) : NULL;
+
+	return props;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies virtual machine object from shared memory                  *
+ *                                                                            *
+ * Parameters: src - [IN] virtual machine object in shared memory             *
+ *                                                                            *
+ * Return value: duplicated virtual machine object                            *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vmware_vm_t	*vmware_vm_dup(const zbx_vmware_vm_t *src)
+{
+	zbx_vmware_vm_t	*vm = (zbx_vmware_vm_t *)zbx_malloc(NULL, sizeof(zbx_vmware_vm_t));
+
+	zbx_vector_vmware_dev_ptr_create(&vm->devs);
+	zbx_vector_vmware_fs_ptr_create(&vm->file_systems);
+	zbx_vector_vmware_custom_attr_ptr_create(&vm->custom_attrs);
+	zbx_vector_str_create(&vm->alarm_ids);
+	zbx_vector_vmware_dev_ptr_reserve(&vm->devs, (size_t)src->devs.values_num);
+	zbx_vector_vmware_fs_ptr_reserve(&vm->file_systems, (size_t)src->file_systems.values_num);
+	zbx_vector_vmware_custom_attr_ptr_reserve(&vm->custom_attrs, (size_t)src->custom_attrs.values_num);
+
+	vm->uuid = zbx_strdup(NULL, src->uuid);
+	vm->id = zbx_strdup(NULL, src->id);
+	vm->props = vmware_props_dup(src->props, ZBX_VMWARE_VMPROPS_NUM);
+	vm->snapshot_count = src->snapshot_count;
+
+	for (int i = 0; i < src->devs.values_num; i++)
+	{
+		zbx_vmware_dev_t	*dev = (zbx_vmware_dev_t *)zbx_malloc(NULL, sizeof(zbx_vmware_dev_t));
+
+		dev->type = src->devs.values[i]->type;
+		dev->instance = NULL != src->devs.values[i]->instance ?
+				zbx_strdup(NULL, src->devs.values[i]->instance) : NULL;
+		dev->label = NULL != src->devs.values[i]->label ? zbx_strdup(NULL, src->devs.values[i]->label) : NULL;
+		dev->props = vmware_props_dup(src->devs.values[i]->props, ZBX_VMWARE_DEV_PROPS_NUM);
+		zbx_vector_vmware_dev_ptr_append(&vm->devs, dev);
+	}
+
+	for (int i = 0; i < src->file_systems.values_num; i++)
+	{
+		zbx_vmware_fs_t	*fs = (zbx_vmware_fs_t *)zbx_malloc(NULL, sizeof(zbx_vmware_fs_t));
+
+		fs->path = zbx_strdup(NULL, src->file_systems.values[i]->path);
+		fs->capacity = src->file_systems.values[i]->capacity;
+		fs->free_space = src->file_systems.values[i]->free_space;
+		zbx_vector_vmware_fs_ptr_append(&vm->file_systems, fs);
+	}
+
+	for (int i = 0; i < src->custom_attrs.values_num; i++)
+	{
+		zbx_vmware_custom_attr_t	*ca;
+
+		ca = (zbx_vmware_custom_attr_t *)zbx_malloc(NULL, sizeof(zbx_vmware_custom_attr_t));
+		ca->name = zbx_strdup(NULL, src->custom_attrs.values[i]->name);
+		ca->value = zbx_strdup(NULL, src->custom_attrs.values[i]->value);
+		zbx_vector_vmware_custom_attr_ptr_append(&vm->custom_attrs, ca);
+	}
+
+	return vm;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: gets list of ip for virtual machine network interface             *
@@ -457,9 +543,13 @@ clean:
  *                                                                            *
  * Parameters: vm      - [OUT]                                                *
  *             details - [IN] xml document containing virtual machine data    *
+ *             node    - [IN] guest.disk property value node (optional)       *
+ *                                                                            *
+ * Comments: If node is NULL the guest.disk property is searched in the whole *
+ *           document.                                                        *
  *                                                                            *
  ******************************************************************************/
-static void	vmware_vm_get_file_systems(zbx_vmware_vm_t *vm, xmlDoc *details)
+static void	vmware_vm_get_file_systems(zbx_vmware_vm_t *vm, xmlDoc *details, xmlNode *node)
 {
 #	define ZBX_XPATH_VM_GUESTDISKS()									\
 		"/*/*/*/*/*/*[local-name()='propSet'][*[local-name()='name'][text()='guest.disk']]"		\
@@ -468,12 +558,19 @@ static void	vmware_vm_get_file_systems(zbx_vmware_vm_t *vm, xmlDoc *details)
 	xmlXPathContext	*xpathCtx;
 	xmlXPathObject	*xpathObj;
 	xmlNodeSetPtr	nodeset;
+	const char	*xpath = ZBX_XPATH_VM_GUESTDISKS();
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	xpathCtx = xmlXPathNewContext(details);
 
-	if (NULL == (xpathObj = xmlXPathEvalExpression((const xmlChar *)ZBX_XPATH_VM_GUESTDISKS(), xpathCtx)))
+	if (NULL != node)
+	{
+		xpathCtx->node = node;
+		xpath = ZBX_XPATH_NN("GuestDiskInfo");
+	}
+
+	if (NULL == (xpathObj = xmlXPathEvalExpression((const xmlChar *)xpath, xpathCtx)))
 		goto clean;
 
 	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
@@ -1008,6 +1105,252 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if property value can be replaced with value reported by   *
+ *          property collector without retrieving the whole virtual machine   *
+ *                                                                            *
+ * Parameters: index - [IN] property index in vm_propmap                      *
+ *                                                                            *
+ * Return value: SUCCEED - property value is stored as is                     *
+ *               FAIL    - property value is derived from other data          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_vm_prop_is_plain(int index)
+{
+	switch (index)
+	{
+		case ZBX_VMWARE_VMPROP_FOLDER:
+		case ZBX_VMWARE_VMPROP_SNAPSHOT:
+		case ZBX_VMWARE_VMPROP_DATASTOREID:
+		case ZBX_VMWARE_VMPROP_RESOURCEPOOL:
+			return FAIL;
+		default:
+			return SUCCEED;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: builds list of virtual machine properties tracked by property     *
+ *          collector filter                                                  *
+ *                                                                            *
+ * Return value: soap pathSet elements, must be freed by the caller           *
+ *                                                                            *
+ * Comments: Changes of plain properties and guest disks are applied to the   *
+ *           cached virtual machine directly, changes of the other properties *
+ *           cause the virtual machine to be retrieved again.                 *
+ *                                                                            *
+ ******************************************************************************/
+char	*vmware_vm_tracked_props(void)
+{
+	const char	*props[] = {"guest.disk", "guest.net", "config.changeVersion", "layoutEx.timestamp",
+					"snapshot", "customValue", "triggeredAlarmState", "parent", "datastore",
+					"resourcePool", NULL};
+	char		*buf = NULL;
+	size_t		alloc = 0, offset = 0;
+
+	for (int i = 0; i < ZBX_VMWARE_VMPROPS_NUM; i++)
+	{
+		if (SUCCEED == vmware_vm_prop_is_plain(i))
+			zbx_snprintf_alloc(&buf, &alloc, &offset, "<ns0:pathSet>%s</ns0:pathSet>", vm_propmap[i].name);
+	}
+
+	for (int i = 0; NULL != props[i]; i++)
+		zbx_snprintf_alloc(&buf, &alloc, &offset, "<ns0:pathSet>%s</ns0:pathSet>", props[i]);
+
+	return buf;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies property change reported by property collector to cached  *
+ *          virtual machine                                                   *
+ *                                                                            *
+ * Parameters: vm     - [IN/OUT] cached virtual machine                       *
+ *             xdoc   - [IN] xml document with property collector updates     *
+ *             change - [IN] changeSet node                                   *
+ *                                                                            *
+ * Return value: SUCCEED - change was applied                                 *
+ *               FAIL    - virtual machine must be retrieved again            *
+ *                                                                            *
+ ******************************************************************************/
+int	vmware_vm_update_prop(zbx_vmware_vm_t *vm, xmlDoc *xdoc, xmlNode *change)
+{
+	char	*name, *op;
+	xmlNode	*val = NULL;
+	xmlChar	*value;
+	int	ret = FAIL;
+
+	if (NULL == (name = zbx_xml_node_read_value(xdoc, change, ZBX_XPATH_NN("name"))))
+		return FAIL;
+
+	if (NULL != (op = zbx_xml_node_read_value(xdoc, change, ZBX_XPATH_NN("op"))) && 0 == strcmp(op, "assign"))
+		val = zbx_xml_node_get(xdoc, change, ZBX_XPATH_NN("val"));
+
+	if (0 == strcmp(name, "guest.disk"))
+	{
+		zbx_vector_vmware_fs_ptr_clear_ext(&vm->file_systems, vmware_fs_free);
+
+		if (NULL != val)
+			vmware_vm_get_file_systems(vm, xdoc, val);
+
+		ret = SUCCEED;
+		goto out;
+	}
+
+	for (int i = 0; i < ZBX_VMWARE_VMPROPS_NUM; i++)
+	{
+		if (SUCCEED != vmware_vm_prop_is_plain(i) || 0 != strcmp(vm_propmap[i].name, name))
+			continue;
+
+		zbx_free(vm->props[i]);
+
+		if (NULL != val && NULL != (value = xmlNodeListGetString(xdoc, val->xmlChildrenNode, 1)))
+		{
+			vm->props[i] = zbx_strdup(NULL, (const char *)value);
+			xmlFree(value);
+		}
+
+		ret = SUCCEED;
+		break;
+	}
+out:
+	zabbix_log(LOG_LEVEL_TRACE, "%s() vmid:%s %s %s:%s", __func__, vm->id, ZBX_NULL2EMPTY_STR(op), name,
+			zbx_result_string(ret));
+	zbx_free(op);
+	zbx_free(name);
+
+	return ret;
+}
+
+static zbx_hash_t	vmware_vm_id_hash(const void *data)
+{
+	const zbx_vmware_vm_t	*vm = *(const zbx_vmware_vm_t * const *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(vm->id, strlen(vm->id), ZBX_DEFAULT_HASH_SEED);
+}
+
+static int	vmware_vm_id_compare(const void *d1, const void *d2)
+{
+	const zbx_vmware_vm_t	*vm1 = *(const zbx_vmware_vm_t * const *)d1;
+	const zbx_vmware_vm_t	*vm2 = *(const zbx_vmware_vm_t * const *)d2;
+
+	return strcmp(vm1->id, vm2->id);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies virtual machines of previous service update that can be    *
+ *          reused if property collector reports no changes for them          *
+ *                                                                            *
+ * Parameters: vms  - [OUT] virtual machine cache                             *
+ *             data - [IN] service data in shared memory (optional)           *
+ *                                                                            *
+ * Comments: Virtual machines with triggered alarms are not cached, they are  *
+ *           always retrieved to collect alarm details.                       *
+ *           VMware lock must be locked with zbx_vmware_lock() function       *
+ *           before calling this function.                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	vmware_vm_cache_create(zbx_hashset_t *vms, zbx_vmware_data_t *data)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_vmware_hv_t		*hv;
+
+	zbx_hashset_create(vms, NULL != data ? (size_t)data->vms_index.num_data : 0, vmware_vm_id_hash,
+			vmware_vm_id_compare);
+
+	if (NULL == data)
+		return;
+
+	zbx_hashset_iter_reset(&data->hvs, &iter);
+
+	while (NULL != (hv = (zbx_vmware_hv_t *)zbx_hashset_iter_next(&iter)))
+	{
+		for (int i = 0; i < hv->vms.values_num; i++)
+		{
+			zbx_vmware_vm_t	*vm;
+
+			if (0 != hv->vms.values[i]->alarm_ids.values_num)
+				continue;
+
+			vm = vmware_vm_dup(hv->vms.values[i]);
+			zbx_hashset_insert(vms, &vm, sizeof(vm));
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets cached virtual machine                                       *
+ *                                                                            *
+ * Parameters: vms - [IN/OUT] virtual machine cache                           *
+ *             id  - [IN] virtual machine id                                  *
+ *                                                                            *
+ * Return value: virtual machine removed from cache or NULL if not found      *
+ *                                                                            *
+ ******************************************************************************/
+zbx_vmware_vm_t	*vmware_vm_cache_take(zbx_hashset_t *vms, const char *id)
+{
+	zbx_vmware_vm_t	vm_local, *vm = &vm_local, **pvm;
+
+	vm_local.id = (char *)id;
+
+	if (NULL == (pvm = (zbx_vmware_vm_t **)zbx_hashset_search(vms, &vm)))
+		return NULL;
+
+	vm = *pvm;
+	zbx_hashset_remove_direct(vms, pvm);
+
+	return vm;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes all virtual machines from cache                           *
+ *                                                                            *
+ * Parameters: vms - [IN/OUT] virtual machine cache                           *
+ *                                                                            *
+ ******************************************************************************/
+void	vmware_vm_cache_clear(zbx_hashset_t *vms)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_vmware_vm_t		**pvm;
+
+	zbx_hashset_iter_reset(vms, &iter);
+
+	while (NULL != (pvm = (zbx_vmware_vm_t **)zbx_hashset_iter_next(&iter)))
+		vmware_vm_free(*pvm);
+
+	zbx_hashset_clear(vms);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: counts virtual machine in its resource pool                       *
+ *                                                                            *
+ * Parameters: vm     - [IN] virtual machine                                  *
+ *             rpools - [IN/OUT] vector with all Resource Pools               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_vm_resourcepool_count(const zbx_vmware_vm_t *vm, zbx_vector_vmware_resourcepool_ptr_t *rpools)
+{
+	int				i;
+	zbx_vmware_resourcepool_t	rpool_cmp;
+
+	if (NULL == vm->props[ZBX_VMWARE_VMPROP_RESOURCEPOOL])
+		return;
+
+	rpool_cmp.id = vm->props[ZBX_VMWARE_VMPROP_RESOURCEPOOL];
+
+	if (FAIL != (i = zbx_vector_vmware_resourcepool_ptr_bsearch(rpools, &rpool_cmp,
+			ZBX_DEFAULT_STR_PTR_COMPARE_FUNC)))
+	{
+		rpools->values[i]->vm_num += 1;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: creates virtual machine object                                    *
@@ -1018,6 +1361,7 @@ out:
  *             rpools       - [IN/OUT] vector with all Resource Pools         *
  *             cq_values    - [IN/OUT] vector with custom query entries       *
  *             alarms_data  - [IN/OUT] all alarms with cache                  *
+ *             vms          - [IN/OUT] unchanged virtual machines (optional)  *
  *             error        - [OUT] error message in case of failure          *
  *                                                                            *
  * Return value: The created virtual machine object or NULL if an error was   *
@@ -1026,7 +1370,7 @@ out:
  ******************************************************************************/
 zbx_vmware_vm_t	*vmware_service_create_vm(zbx_vmware_service_t *service, CURL *easyhandle,
 		const char *id, zbx_vector_vmware_resourcepool_ptr_t *rpools, zbx_vector_cq_value_ptr_t *cq_values,
-		zbx_vmware_alarms_data_t *alarms_data, char **error)
+		zbx_vmware_alarms_data_t *alarms_data, zbx_hashset_t *vms, char **error)
 {
 #	define ZBX_XPATH_VM_UUID()										\
 		"/*/*/*/*/*/*[local-name()='propSet'][*[local-name()='name'][text()='config.uuid']]"		\
@@ -1045,14 +1389,24 @@ zbx_vmware_vm_t	*vmware_service_create_vm(zbx_vmware_service_t *service, CURL *e
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() vmid:'%s'", __func__, id);
 
+	zbx_vector_cq_value_ptr_create(&cqvs);
+	cq_prop = vmware_cq_prop_soap_request(cq_values, ZBX_VMWARE_SOAP_VM, id, &cqvs);
+
+	/* custom query properties are not tracked for changes, such virtual machine is always retrieved */
+	if (0 == cqvs.values_num && NULL != vms && NULL != (vm = vmware_vm_cache_take(vms, id)))
+	{
+		zbx_str_free(cq_prop);
+		vmware_vm_resourcepool_count(vm, rpools);
+		ret = SUCCEED;
+		goto out;
+	}
+
 	vm = (zbx_vmware_vm_t *)zbx_malloc(NULL, sizeof(zbx_vmware_vm_t));
 	memset(vm, 0, sizeof(zbx_vmware_vm_t));
 
 	zbx_vector_vmware_dev_ptr_create(&vm->devs);
 	zbx_vector_vmware_fs_ptr_create(&vm->file_systems);
 	zbx_vector_vmware_custom_attr_ptr_create(&vm->custom_attrs);
-	zbx_vector_cq_value_ptr_create(&cqvs);
-	cq_prop = vmware_cq_prop_soap_request(cq_values, ZBX_VMWARE_SOAP_VM, id, &cqvs);
 	ret = vmware_service_get_vm_data(service, easyhandle, id, vm_propmap, ZBX_VMWARE_VMPROPS_NUM, cq_prop,
 			&details, error);
 	zbx_str_free(cq_prop);
@@ -1097,23 +1451,11 @@ zbx_vmware_vm_t	*vmware_service_create_vm(zbx_vmware_service_t *service, CURL *e
 				"\"size\":0,\"uniquesize\":0}");
 	}
 
-	if (NULL != vm->props[ZBX_VMWARE_VMPROP_RESOURCEPOOL])
-	{
-		int				i;
-		zbx_vmware_resourcepool_t	rpool_cmp;
-
-		rpool_cmp.id = vm->props[ZBX_VMWARE_VMPROP_RESOURCEPOOL];
-
-		if (FAIL != (i = zbx_vector_vmware_resourcepool_ptr_bsearch(rpools, &rpool_cmp,
-				ZBX_DEFAULT_STR_PTR_COMPARE_FUNC)))
-		{
-			rpools->values[i]->vm_num += 1;
-		}
-	}
+	vmware_vm_resourcepool_count(vm, rpools);
 
 	vmware_vm_get_nic_devices(vm, details);
 	vmware_vm_get_disk_devices(vm, details);
-	vmware_vm_get_file_systems(vm, details);
+	vmware_vm_get_file_systems(vm, details, NULL);
 	vmware_vm_get_custom_attrs(vm, details);
 
 	if (0 != cqvs.values_num)
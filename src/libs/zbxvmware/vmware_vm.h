@@ -25,7 +25,12 @@ void	vmware_vm_shared_free(zbx_vmware_vm_t *vm);
 void	vmware_vm_free(zbx_vmware_vm_t *vm);
 zbx_vmware_vm_t	*vmware_service_create_vm(zbx_vmware_service_t *service, CURL *easyhandle,
 		const char *id, zbx_vector_vmware_resourcepool_ptr_t *rpools, zbx_vector_cq_value_ptr_t *cq_values,
-		zbx_vmware_alarms_data_t *alarms_data, char **error);
+		zbx_vmware_alarms_data_t *alarms_data, zbx_hashset_t *vms, char **error);
+char	*vmware_vm_tracked_props(void);
+int	vmware_vm_update_prop(zbx_vmware_vm_t *vm, xmlDoc *xdoc, xmlNode *change);
+void	vmware_vm_cache_create(zbx_hashset_t *vms, zbx_vmware_data_t *data);
+zbx_vmware_vm_t	*vmware_vm_cache_take(zbx_hashset_t *vms, const char *id);
+void	vmware_vm_cache_clear(zbx_hashset_t *vms);
 
 #endif	/* defined(HAVE_LIBXML2) && defined(HAVE_LIBCURL) */
 
@@ -13,6 +13,7 @@
 **/
 
 #include "active_checks.h"
+#include "active_spool.h"
 
 #include "../agent_conf/agent_conf.h"
 #include "../logfiles/logfiles.h"
@@ -105,6 +106,13 @@ static ZBX_THREAD_LOCAL zbx_vector_persistent_inactive_t	persistent_inactive_vec
 
 static ZBX_THREAD_LOCAL int	history_upload = ZBX_HISTORY_UPLOAD_ENABLED;
 
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+#define ZBX_SPOOL_SEND_MAX	10	/* maximum number of spooled requests sent at once */
+
+static ZBX_THREAD_LOCAL zbx_active_spool_t	spool;		/* values that could not be sent to server */
+static ZBX_THREAD_LOCAL time_t			spool_nextsend;
+#endif
+
 typedef struct
 {
 	zbx_uint64_t	id;
@@ -981,10 +989,11 @@ static int	check_response(const char *response)
 	return ret;
 }
 
+static void	add_metric_results(struct zbx_json *json);
+
 static int	format_metric_results(struct zbx_json *json, int now, int config_buffer_send, int config_buffer_size)
 {
-	active_buffer_element_t	*el;
-	int			i, ret = FAIL;
+	int	ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -1005,6 +1014,19 @@ static int	format_metric_results(struct zbx_json *json, int now, int config_buff
 	if (0 == buffer.count)
 		goto ret;
 
+	add_metric_results(json);
+	ret = SUCCEED;
+ret:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+static void	add_metric_results(struct zbx_json *json)
+{
+	active_buffer_element_t	*el;
+	int			i;
+
 	zbx_json_addarray(json, ZBX_PROTO_TAG_DATA);
 
 	for (i = 0; i < buffer.count; i++)
@@ -1050,11 +1072,6 @@ static int	format_metric_results(struct zbx_json *json, int now, int config_buff
 	}
 
 	zbx_json_close(json);
-	ret = SUCCEED;
-ret:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
-
-	return ret;
 }
 
 static int	format_command_results(struct zbx_json *json)
@@ -1090,32 +1107,42 @@ static int	format_command_results(struct zbx_json *json)
 	return SUCCEED;
 }
 
-static void	clear_metric_results(zbx_vector_addr_ptr_t *addrs, zbx_vector_pre_persistent_t *prep_vec, int now,
-		int ret)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees buffered values after they were delivered to server or     *
+ *          stored in spool                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	free_metric_results(zbx_vector_pre_persistent_t *prep_vec, int now)
 {
 	int			i;
 	active_buffer_element_t	*el;
 
-	if (SUCCEED == ret)
-	{
 #if !defined(_WINDOWS) && !defined(__MINGW32__)
-		zbx_write_persistent_files(prep_vec);
-		zbx_clean_pre_persistent_elements(prep_vec);
+	zbx_write_persistent_files(prep_vec);
+	zbx_clean_pre_persistent_elements(prep_vec);
 #else
-		ZBX_UNUSED(prep_vec);
+	ZBX_UNUSED(prep_vec);
 #endif
-		/* free buffer */
-		for (i = 0; i < buffer.count; i++)
-		{
-			el = &buffer.data[i];
+	for (i = 0; i < buffer.count; i++)
+	{
+		el = &buffer.data[i];
 
-			zbx_free(el->value);
-			zbx_free(el->source);
-		}
-		buffer.count = 0;
-		buffer.pcount = 0;
+		zbx_free(el->value);
+		zbx_free(el->source);
+	}
+	buffer.count = 0;
+	buffer.pcount = 0;
+
+	buffer.lastsent = now;
+}
 
-		buffer.lastsent = now;
+static void	clear_metric_results(zbx_vector_addr_ptr_t *addrs, zbx_vector_pre_persistent_t *prep_vec, int now,
+		int ret)
+{
+	if (SUCCEED == ret)
+	{
+		free_metric_results(prep_vec, now);
 
 		if (0 != buffer.first_error)
 		{
@@ -1148,6 +1175,129 @@ static char	*connect_callback(void *data)
 	return json->buffer;
 }
 
+static void	add_agent_data_header(struct zbx_json *json, const char *config_hostname)
+{
+	zbx_json_addstring(json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_AGENT_DATA, ZBX_JSON_TYPE_STRING);
+	zbx_json_addstring(json, ZBX_PROTO_TAG_SESSION, session_token, ZBX_JSON_TYPE_STRING);
+	zbx_json_addstring(json, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
+	zbx_json_addint64(json, ZBX_PROTO_TAG_VARIANT, ZBX_PROGRAM_VARIANT_AGENT);
+	zbx_json_addstring(json, ZBX_PROTO_TAG_HOST, config_hostname, ZBX_JSON_TYPE_STRING);
+}
+
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves buffered values to spool when buffer is full               *
+ *                                                                            *
+ * Comments: Values stay in buffer if it still has free space or the spool    *
+ *           size limit is reached. In the latter case active checks are not  *
+ *           processed until the buffer is sent.                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	spool_metric_results(zbx_vector_pre_persistent_t *prep_vec, const char *config_hostname,
+		int config_buffer_size)
+{
+	struct zbx_json	json;
+	char		*error = NULL;
+
+	if (NULL == spool.prefix || 0 == buffer.count)
+		return;
+
+	if (config_buffer_size > buffer.count && config_buffer_size / 2 > buffer.pcount)
+		return;
+
+	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+	add_agent_data_header(&json, config_hostname);
+	add_metric_results(&json);
+
+	if (SUCCEED == zbx_active_spool_write(&spool, json.buffer, &error))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%d values moved to spool, spool size " ZBX_FS_UI64, buffer.count,
+				spool.size);
+		free_metric_results(prep_vec, (int)time(NULL));
+	}
+	else
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot move values to spool: %s", error);
+		zbx_free(error);
+	}
+
+	zbx_json_free(&json);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends spooled values to server in the order they were spooled     *
+ *                                                                            *
+ * Return value: SUCCEED - spool is empty                                     *
+ *               FAIL    - spool still has unsent values                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	send_spool(zbx_vector_addr_ptr_t *addrs, const zbx_config_tls_t *config_tls, int config_timeout,
+		const char *config_source_ip, int config_buffer_send)
+{
+	int		i, ret = SUCCEED, level;
+	char		*request, *data = NULL;
+	struct zbx_json	json;
+
+	if (time(NULL) < spool_nextsend || ZBX_HISTORY_UPLOAD_ENABLED != history_upload)
+		return FAIL;
+
+	for (i = 0; SUCCEED == ret && ZBX_SPOOL_SEND_MAX > i; i++)
+	{
+		if (SUCCEED != zbx_active_spool_read(&spool, &request))
+			break;
+
+		/* clock and ns are added by connect_callback() */
+		zbx_json_init_with(&json, request);
+		zbx_free(request);
+
+		level = 0 == buffer.first_error ? LOG_LEVEL_WARNING : LOG_LEVEL_DEBUG;
+
+		ret = zbx_comms_exchange_with_redirect(config_source_ip, addrs, 60, config_timeout, 0, level,
+				config_tls, json.buffer, connect_callback, &json, &data, NULL);
+
+		if (SUCCEED == ret)
+		{
+			if (NULL == data || SUCCEED != check_response(data))
+				ret = FAIL;
+
+			zbx_free(data);
+		}
+
+		if (SUCCEED == ret)
+			zbx_active_spool_remove(&spool);
+
+		zbx_json_free(&json);
+	}
+
+	if (SUCCEED != ret)
+	{
+		if (0 == buffer.first_error)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "Active check data upload started to fail");
+			buffer.first_error = (int)time(NULL);
+		}
+
+		spool_nextsend = time(NULL) + config_buffer_send;
+
+		return FAIL;
+	}
+
+	if (0 == ZBX_ACTIVE_SPOOL_IS_EMPTY(&spool))
+		return FAIL;
+
+	if (0 != buffer.first_error)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "active check data upload to [%s:%hu] is working again",
+				((zbx_addr_t *)addrs->values[0])->ip, ((zbx_addr_t *)addrs->values[0])->port);
+		buffer.first_error = 0;
+	}
+
+	return SUCCEED;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: sends value stored in buffer to Zabbix server                     *
@@ -1174,7 +1324,8 @@ static int	send_buffer(zbx_vector_addr_ptr_t *addrs, zbx_vector_pre_persistent_t
 		const zbx_config_tls_t *config_tls, int config_timeout, const char *config_source_ip,
 		const char *config_hostname, int config_buffer_send, int config_buffer_size)
 {
-	int			ret = SUCCEED, ret_metrics, ret_commands, now, level;
+	int			ret = SUCCEED, ret_metrics = FAIL, ret_commands, now, level, spool_failed = 0,
+				timeout;
 	char			*data = NULL;
 	struct zbx_json		json;
 
@@ -1184,23 +1335,31 @@ static int	send_buffer(zbx_vector_addr_ptr_t *addrs, zbx_vector_pre_persistent_t
 
 	now = (int)time(NULL);
 
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	if (0 == ZBX_ACTIVE_SPOOL_IS_EMPTY(&spool) && SUCCEED != send_spool(addrs, config_tls, config_timeout,
+			config_source_ip, config_buffer_send))
+	{
+		/* spooled values must reach server before the buffered ones, command results are not spooled */
+		spool_metric_results(prep_vec, config_hostname, config_buffer_size);
+		spool_failed = 1;
+	}
+#endif
 	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
-	zbx_json_addstring(&json, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_AGENT_DATA, ZBX_JSON_TYPE_STRING);
-	zbx_json_addstring(&json, ZBX_PROTO_TAG_SESSION, session_token, ZBX_JSON_TYPE_STRING);
-	zbx_json_addstring(&json, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
-	zbx_json_addint64(&json, ZBX_PROTO_TAG_VARIANT, ZBX_PROGRAM_VARIANT_AGENT);
-	zbx_json_addstring(&json, ZBX_PROTO_TAG_HOST, config_hostname, ZBX_JSON_TYPE_STRING);
+	add_agent_data_header(&json, config_hostname);
+
+	if (0 == spool_failed)
+		ret_metrics = format_metric_results(&json, now, config_buffer_send, config_buffer_size);
 
-	ret_metrics = format_metric_results(&json, now, config_buffer_send, config_buffer_size);
 	ret_commands = format_command_results(&json);
 
 	if (FAIL == ret_metrics && FAIL == ret_commands)
 		goto ret;
 
 	level = 0 == buffer.first_error ? LOG_LEVEL_WARNING : LOG_LEVEL_DEBUG;
+	timeout = SUCCEED == ret_metrics ? MIN(buffer.count * config_timeout, 60) : config_timeout;
 
-	ret = zbx_comms_exchange_with_redirect(config_source_ip, addrs, MIN(buffer.count * config_timeout, 60),
-			config_timeout, 0, level, config_tls, json.buffer, connect_callback, &json, &data, NULL);
+	ret = zbx_comms_exchange_with_redirect(config_source_ip, addrs, timeout, config_timeout, 0, level, config_tls,
+			json.buffer, connect_callback, &json, &data, NULL);
 
 	if (SUCCEED == ret)
 	{
@@ -1220,8 +1379,16 @@ static int	send_buffer(zbx_vector_addr_ptr_t *addrs, zbx_vector_pre_persistent_t
 
 	if (SUCCEED == ret && SUCCEED == ret_commands)
 		zbx_vector_command_result_ptr_clear_ext(&command_results, free_command_result);
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	if (SUCCEED != ret)
+		spool_metric_results(prep_vec, config_hostname, config_buffer_size);
+#endif
 ret:
 	zbx_json_free(&json);
+
+	if (0 != spool_failed)
+		ret = FAIL;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1877,6 +2044,22 @@ ZBX_THREAD_ENTRY(active_checks_thread, args)
 #endif
 	init_active_metrics(activechks_args_in->config_buffer_size);
 
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	if (NULL != activechks_args_in->config_buffer_spool_dir)
+	{
+		char	*error = NULL;
+
+		if (SUCCEED != zbx_active_spool_open(&spool, activechks_args_in->config_buffer_spool_dir,
+				activechk_args.addrs.values[0]->ip, activechk_args.addrs.values[0]->port,
+				config_hostname, activechks_args_in->config_buffer_spool_size, &error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot open active check data spool, values will be kept in"
+					" memory only: %s", error);
+			zbx_free(error);
+		}
+	}
+#endif
+
 #ifndef _WINDOWS
 	zbx_set_sigusr_handler(zbx_active_checks_sigusr_handler);
 #endif
@@ -2000,6 +2183,10 @@ ZBX_THREAD_ENTRY(active_checks_thread, args)
 
 	zbx_free(session_token);
 
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+	zbx_active_spool_close(&spool);
+#endif
+
 #ifdef _WINDOWS
 	zbx_vector_addr_ptr_clear_ext(&activechk_args.addrs, (zbx_clean_func_t)zbx_addr_free);
 	zbx_vector_addr_ptr_destroy(&activechk_args.addrs);
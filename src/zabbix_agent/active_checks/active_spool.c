@@ -0,0 +1,491 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "active_spool.h"
+
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+
+#include "../logfiles/persistent_state.h"
+
+#include "zbxlog.h"
+#include "zbxstr.h"
+#include "zbxnum.h"
+#include "zbxfile.h"
+#include "zbxcompress.h"
+
+/* Spool consists of append-only segment files named <prefix>_<sequence number>. Each segment holds records */
+/* of one agent data request, every record is prefixed with zbx_spool_record_t header. Segments are removed */
+/* when all their records are sent.                                                                         */
+
+#define ZBX_SPOOL_SIGNATURE		"ZBXS"
+#define ZBX_SPOOL_SIGNATURE_LEN		4
+#define ZBX_SPOOL_FLAG_COMPRESSED	0x01
+
+#define ZBX_SPOOL_SEGMENT_SIZE		(4 * ZBX_MEBIBYTE)
+#define ZBX_SPOOL_TMP_SUFFIX		".tmp"
+
+typedef struct
+{
+	char		signature[ZBX_SPOOL_SIGNATURE_LEN];
+	zbx_uint32_t	flags;
+	zbx_uint64_t	data_size;	/* uncompressed data size */
+	zbx_uint64_t	payload_size;	/* size of the data following the header */
+}
+zbx_spool_record_t;
+
+static char	*spool_segment_name(const zbx_active_spool_t *spool, zbx_uint64_t seq)
+{
+	return zbx_dsprintf(NULL, "%s_" ZBX_FS_UI64, spool->prefix, seq);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds existing segments left by previous agent run                *
+ *                                                                            *
+ ******************************************************************************/
+static int	spool_scan(zbx_active_spool_t *spool, const char *dir_name, char **error)
+{
+	DIR		*dir;
+	struct dirent	*entry;
+	const char	*base;
+	size_t		base_len;
+	zbx_uint64_t	seq, min_seq = ZBX_MAX_UINT64, max_seq = 0;
+
+	if (NULL == (dir = opendir(dir_name)))
+	{
+		*error = zbx_dsprintf(*error, "cannot open directory \"%s\": %s", dir_name, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	base = strrchr(spool->prefix, '/') + 1;
+	base_len = strlen(base);
+
+	while (NULL != (entry = readdir(dir)))
+	{
+		char		*path;
+		const char	*tmp;
+		zbx_stat_t	st;
+
+		if (0 != strncmp(entry->d_name, base, base_len) || '_' != entry->d_name[base_len])
+			continue;
+
+		path = zbx_dsprintf(NULL, "%s/%s", dir_name, entry->d_name);
+
+		if (SUCCEED != zbx_is_uint64(entry->d_name + base_len + 1, &seq))
+		{
+			/* segment that was being created when agent stopped */
+			if (NULL != (tmp = strstr(entry->d_name + base_len + 1, ZBX_SPOOL_TMP_SUFFIX)) &&
+					'\0' == tmp[ZBX_CONST_STRLEN(ZBX_SPOOL_TMP_SUFFIX)])
+			{
+				unlink(path);
+			}
+
+			zbx_free(path);
+			continue;
+		}
+
+		if (0 == zbx_stat(path, &st))
+		{
+			spool->size += (zbx_uint64_t)st.st_size;
+
+			if (seq < min_seq)
+				min_seq = seq;
+
+			if (seq >= max_seq)
+			{
+				max_seq = seq;
+				spool->last_size = (zbx_uint64_t)st.st_size;
+			}
+		}
+
+		zbx_free(path);
+	}
+
+	closedir(dir);
+
+	if (ZBX_MAX_UINT64 != min_seq)
+	{
+		spool->first_seq = min_seq;
+		spool->next_seq = max_seq + 1;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: opens spool for data sent by active checks of the specified host  *
+ *          to the specified server                                           *
+ *                                                                            *
+ * Parameters: spool     - [OUT]                                              *
+ *             base_path - [IN] spool directory                               *
+ *             server    - [IN] server address                                *
+ *             port      - [IN] server port                                   *
+ *             hostname  - [IN] host name the data is sent for                *
+ *             max_size  - [IN] maximum total size of spool segments          *
+ *             error     - [OUT] error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - spool is opened                                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: segments left by previous agent run are picked up so their data  *
+ *           is sent before new values.                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_active_spool_open(zbx_active_spool_t *spool, const char *base_path, const char *server,
+		unsigned short port, const char *hostname, zbx_uint64_t max_size, char **error)
+{
+	char	*server_dir, *name;
+	int	ret;
+
+	memset(spool, 0, sizeof(zbx_active_spool_t));
+
+	if (NULL == (server_dir = zbx_create_persistent_server_directory(base_path, server, port, error)))
+		return FAIL;
+
+	/* several hosts can send data to the same server - segment names are derived from host name */
+	name = zbx_dsprintf(NULL, "spool:%s", hostname);
+	spool->prefix = zbx_make_persistent_file_name(server_dir, name);
+	spool->max_size = max_size;
+	zbx_free(name);
+
+	if (SUCCEED != (ret = spool_scan(spool, server_dir, error)))
+	{
+		zbx_free(spool->prefix);
+	}
+	else if (0 == ZBX_ACTIVE_SPOOL_IS_EMPTY(spool))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "found " ZBX_FS_UI64 " bytes of unsent active check data in \"%s\"",
+				spool->size, server_dir);
+	}
+
+	zbx_free(server_dir);
+
+	return ret;
+}
+
+void	zbx_active_spool_close(zbx_active_spool_t *spool)
+{
+	zbx_free(spool->prefix);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends agent data request to spool                               *
+ *                                                                            *
+ * Parameters: spool - [IN/OUT]                                               *
+ *             data  - [IN] agent data request                                *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - data was written to spool                          *
+ *               FAIL    - spool is full or cannot be written                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_active_spool_write(zbx_active_spool_t *spool, const char *data, char **error)
+{
+	zbx_spool_record_t	record;
+	char			*compressed = NULL, *segment, *buf;
+	const char		*payload;
+	size_t			compressed_size, size;
+	int			fd, ret = FAIL, new_segment;
+
+	memcpy(record.signature, ZBX_SPOOL_SIGNATURE, ZBX_SPOOL_SIGNATURE_LEN);
+	record.data_size = strlen(data);
+
+	if (SUCCEED == zbx_compress(data, (size_t)record.data_size, &compressed, &compressed_size))
+	{
+		record.flags = ZBX_SPOOL_FLAG_COMPRESSED;
+		record.payload_size = compressed_size;
+		payload = compressed;
+	}
+	else
+	{
+		record.flags = 0;
+		record.payload_size = record.data_size;
+		payload = data;
+	}
+
+	size = sizeof(record) + (size_t)record.payload_size;
+
+	if (spool->size + size > spool->max_size)
+	{
+		*error = zbx_dsprintf(*error, "spool size limit of " ZBX_FS_UI64 " bytes is reached",
+				spool->max_size);
+		goto out;
+	}
+
+	buf = (char *)zbx_malloc(NULL, size);
+	memcpy(buf, &record, sizeof(record));
+	memcpy(buf + sizeof(record), payload, (size_t)record.payload_size);
+
+	new_segment = (ZBX_ACTIVE_SPOOL_IS_EMPTY(spool) || ZBX_SPOOL_SEGMENT_SIZE <= spool->last_size);
+
+	if (0 != new_segment)
+	{
+		char	*tmp_name;
+
+		/* new segments are written under temporary name so that incomplete segments are not sent */
+		segment = spool_segment_name(spool, spool->next_seq);
+		tmp_name = zbx_dsprintf(NULL, "%s" ZBX_SPOOL_TMP_SUFFIX, segment);
+
+		if (-1 == (fd = open(tmp_name, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)))
+		{
+			*error = zbx_dsprintf(*error, "cannot create file \"%s\": %s", tmp_name, zbx_strerror(errno));
+		}
+		else if (SUCCEED != zbx_write_all(fd, buf, size))
+		{
+			*error = zbx_dsprintf(*error, "cannot write to file \"%s\": %s", tmp_name, zbx_strerror(errno));
+			close(fd);
+			unlink(tmp_name);
+		}
+		else if (0 != close(fd) || 0 != rename(tmp_name, segment))
+		{
+			*error = zbx_dsprintf(*error, "cannot create file \"%s\": %s", segment, zbx_strerror(errno));
+			unlink(tmp_name);
+		}
+		else
+		{
+			spool->next_seq++;
+			spool->last_size = size;
+			ret = SUCCEED;
+		}
+
+		zbx_free(tmp_name);
+	}
+	else
+	{
+		segment = spool_segment_name(spool, spool->next_seq - 1);
+
+		if (-1 == (fd = open(segment, O_WRONLY | O_APPEND)))
+		{
+			*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", segment, zbx_strerror(errno));
+		}
+		else
+		{
+			if (SUCCEED != zbx_write_all(fd, buf, size))
+			{
+				*error = zbx_dsprintf(*error, "cannot write to file \"%s\": %s", segment,
+						zbx_strerror(errno));
+
+				/* cut off partially written record */
+				if (0 != ftruncate(fd, (off_t)spool->last_size))
+				{
+					zabbix_log(LOG_LEVEL_WARNING, "cannot truncate file \"%s\": %s", segment,
+							zbx_strerror(errno));
+				}
+			}
+			else
+			{
+				spool->last_size += size;
+				ret = SUCCEED;
+			}
+
+			close(fd);
+		}
+	}
+
+	if (SUCCEED == ret)
+		spool->size += size;
+
+	zbx_free(segment);
+	zbx_free(buf);
+out:
+	zbx_free(compressed);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes the oldest segment regardless of unsent records           *
+ *                                                                            *
+ ******************************************************************************/
+static void	spool_drop_segment(zbx_active_spool_t *spool)
+{
+	char		*segment;
+	zbx_stat_t	st;
+
+	segment = spool_segment_name(spool, spool->first_seq);
+
+	if (0 == zbx_stat(segment, &st))
+	{
+		if (spool->size >= (zbx_uint64_t)st.st_size)
+			spool->size -= (zbx_uint64_t)st.st_size;
+		else
+			spool->size = 0;
+	}
+
+	if (0 != unlink(segment) && ENOENT != errno)
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove file \"%s\": %s", segment, zbx_strerror(errno));
+
+	zbx_free(segment);
+
+	spool->first_seq++;
+	spool->read_offset = 0;
+
+	if (0 != ZBX_ACTIVE_SPOOL_IS_EMPTY(spool))
+	{
+		spool->size = 0;
+		spool->last_size = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads record at the current read offset of the oldest segment     *
+ *                                                                            *
+ * Return value: SUCCEED - record was read                                    *
+ *               FAIL    - no more valid records in the segment               *
+ *                                                                            *
+ ******************************************************************************/
+static int	spool_read_record(zbx_active_spool_t *spool, const char *segment, char **data)
+{
+	zbx_spool_record_t	record;
+	int			fd, ret = FAIL;
+	char			*payload = NULL;
+	ssize_t			n;
+
+	if (-1 == (fd = open(segment, O_RDONLY)))
+	{
+		if (ENOENT != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot open file \"%s\": %s", segment,
+					zbx_strerror(errno));
+		}
+
+		return FAIL;
+	}
+
+	if ((off_t)-1 == lseek(fd, (off_t)spool->read_offset, SEEK_SET))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot set position in file \"%s\": %s", segment, zbx_strerror(errno));
+		goto out;
+	}
+
+	if (0 == (n = read(fd, &record, sizeof(record))))
+		goto out;	/* all records were read */
+
+	if (sizeof(record) != (size_t)n || 0 != memcmp(record.signature, ZBX_SPOOL_SIGNATURE,
+			ZBX_SPOOL_SIGNATURE_LEN) || ZBX_MAX_RECV_DATA_SIZE < record.data_size ||
+			ZBX_MAX_RECV_DATA_SIZE < record.payload_size)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid record at offset " ZBX_FS_UI64 " in file \"%s\", discarding"
+				" the rest of the file", spool->read_offset, segment);
+		goto out;
+	}
+
+	payload = (char *)zbx_malloc(NULL, (size_t)record.payload_size);
+
+	if ((ssize_t)record.payload_size != (n = read(fd, payload, (size_t)record.payload_size)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "truncated record at offset " ZBX_FS_UI64 " in file \"%s\",",
+				spool->read_offset, segment);
+		goto out;
+	}
+
+	*data = (char *)zbx_malloc(NULL, (size_t)record.data_size + 1);
+
+	if (0 != (ZBX_SPOOL_FLAG_COMPRESSED & record.flags))
+	{
+		size_t	size = (size_t)record.data_size;
+
+		if (SUCCEED != zbx_uncompress(payload, (size_t)record.payload_size, *data, &size) ||
+				size != (size_t)record.data_size)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot uncompress record at offset " ZBX_FS_UI64 " in file"
+					" \"%s\": %s", spool->read_offset, segment, zbx_compress_strerror());
+			zbx_free(*data);
+			goto out;
+		}
+	}
+	else
+		memcpy(*data, payload, (size_t)record.data_size);
+
+	(*data)[record.data_size] = '\0';
+
+	spool->read_size = sizeof(record) + record.payload_size;
+	ret = SUCCEED;
+out:
+	zbx_free(payload);
+	close(fd);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads the oldest unsent agent data request from spool             *
+ *                                                                            *
+ * Parameters: spool - [IN/OUT]                                               *
+ *             data  - [OUT] agent data request, must be freed by caller      *
+ *                                                                            *
+ * Return value: SUCCEED - request was read                                   *
+ *               FAIL    - spool is empty                                     *
+ *                                                                            *
+ * Comments: Unreadable segments are discarded. The record stays in spool     *
+ *           until zbx_active_spool_remove() is called.                       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_active_spool_read(zbx_active_spool_t *spool, char **data)
+{
+	while (0 == ZBX_ACTIVE_SPOOL_IS_EMPTY(spool))
+	{
+		char	*segment;
+		int	ret;
+
+		segment = spool_segment_name(spool, spool->first_seq);
+		ret = spool_read_record(spool, segment, data);
+		zbx_free(segment);
+
+		if (SUCCEED == ret)
+			return SUCCEED;
+
+		spool_drop_segment(spool);
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes the record returned by zbx_active_spool_read() after it   *
+ *          was sent                                                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_active_spool_remove(zbx_active_spool_t *spool)
+{
+	spool->read_offset += spool->read_size;
+	spool->read_size = 0;
+
+	/* appending to the newest segment continues until it grows over segment size limit, so it can be */
+	/* fully sent only if it is the only one left and then it is removed as well                       */
+	if (spool->first_seq + 1 == spool->next_seq)
+	{
+		if (spool->read_offset >= spool->last_size)
+			spool_drop_segment(spool);
+	}
+	else
+	{
+		char		*segment;
+		zbx_stat_t	st;
+
+		segment = spool_segment_name(spool, spool->first_seq);
+
+		if (0 != zbx_stat(segment, &st) || spool->read_offset >= (zbx_uint64_t)st.st_size)
+			spool_drop_segment(spool);
+
+		zbx_free(segment);
+	}
+}
+#endif
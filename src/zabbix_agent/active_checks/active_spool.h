@@ -0,0 +1,45 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_ACTIVE_SPOOL_H
+#define ZABBIX_ACTIVE_SPOOL_H
+
+#include "zbxcommon.h"
+
+/* on-disk spool of active check data that could not be sent to server */
+typedef struct
+{
+	char		*prefix;	/* segment file name prefix, NULL when spooling is disabled */
+	zbx_uint64_t	max_size;	/* maximum total size of segment files */
+	zbx_uint64_t	size;		/* current total size of segment files */
+	zbx_uint64_t	first_seq;	/* sequence number of the oldest segment */
+	zbx_uint64_t	next_seq;	/* sequence number following the newest segment */
+	zbx_uint64_t	last_size;	/* size of the newest segment which new records are appended to */
+	zbx_uint64_t	read_offset;	/* offset of the oldest unsent record in the oldest segment */
+	zbx_uint64_t	read_size;	/* size of the last read record */
+}
+zbx_active_spool_t;
+
+#define ZBX_ACTIVE_SPOOL_IS_EMPTY(spool)	((spool)->first_seq == (spool)->next_seq)
+
+#if !defined(_WINDOWS) && !defined(__MINGW32__)
+int	zbx_active_spool_open(zbx_active_spool_t *spool, const char *base_path, const char *server,
+		unsigned short port, const char *hostname, zbx_uint64_t max_size, char **error);
+void	zbx_active_spool_close(zbx_active_spool_t *spool);
+int	zbx_active_spool_write(zbx_active_spool_t *spool, const char *data, char **error);
+int	zbx_active_spool_read(zbx_active_spool_t *spool, char **data);
+void	zbx_active_spool_remove(zbx_active_spool_t *spool);
+#endif
+
+#endif	/* ZABBIX_ACTIVE_SPOOL_H */
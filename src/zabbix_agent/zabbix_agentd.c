@@ -48,6 +48,10 @@ ZBX_GET_CONFIG_VAR2(char*, const char *, zbx_config_source_ip, NULL)
 static int	config_log_level = LOG_LEVEL_WARNING;
 static int	zbx_config_buffer_size = 100;
 static int	zbx_config_buffer_send = 5;
+#ifndef _WINDOWS
+static char		*zbx_config_buffer_spool_dir = NULL;
+static zbx_uint64_t	zbx_config_buffer_spool_size = 64 * ZBX_MEBIBYTE;
+#endif
 static int	zbx_config_max_lines_per_second	= 20;
 static int	zbx_config_eventlog_max_lines_per_second = 20;
 static char	*config_load_module_path = NULL;
@@ -843,6 +847,10 @@ static int	add_serveractive_host_cb(const zbx_vector_addr_ptr_t *addrs, zbx_vect
 		config_active_args[forks].config_host_interface_item = zbx_config_host_interface_item;
 		config_active_args[forks].config_buffer_send = zbx_config_buffer_send;
 		config_active_args[forks].config_buffer_size = zbx_config_buffer_size;
+#ifndef _WINDOWS
+		config_active_args[forks].config_buffer_spool_dir = zbx_config_buffer_spool_dir;
+		config_active_args[forks].config_buffer_spool_size = zbx_config_buffer_spool_size;
+#endif
 		config_active_args[forks].config_eventlog_max_lines_per_second =
 				zbx_config_eventlog_max_lines_per_second;
 		config_active_args[forks].config_max_lines_per_second = zbx_config_max_lines_per_second;
@@ -955,6 +963,10 @@ static void	zbx_load_config(int requirement, ZBX_TASK_EX *task)
 		{"BufferSend",			&zbx_config_buffer_send,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			SEC_PER_HOUR},
 #ifndef _WINDOWS
+		{"BufferSpoolDir",		&zbx_config_buffer_spool_dir,		ZBX_CFG_TYPE_STRING,
+				ZBX_CONF_PARM_OPT,	0,			0},
+		{"BufferSpoolSize",		&zbx_config_buffer_spool_size,		ZBX_CFG_TYPE_UINT64,
+				ZBX_CONF_PARM_OPT,	ZBX_MEBIBYTE,		__UINT64_C(64) * ZBX_GIBIBYTE},
 		{"PidFile",			&config_pid_file,			ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
 #endif
@@ -19,6 +19,7 @@
 #include "zbxtime.h"
 #include "zbxproxybuffer.h"
 #include "zbxpreproc.h"
+#include "zbxpoller.h"
 #include "zbxjson.h"
 
 #define ZBX_DIAG_PROXYBUFFER_MEMORY	0x00000001
@@ -97,6 +98,8 @@ int	diag_add_section_info(const char *section, const struct zbx_json_parse *jp,
 		ret = zbx_diag_add_historycache_info(jp, json, error);
 	else if (0 == strcmp(section, ZBX_DIAG_PROXYBUFFER))
 		ret = diag_add_proxybuffer_info(jp, json, error);
+	else if (0 == strcmp(section, ZBX_DIAG_SNMPCACHE))
+		ret = zbx_diag_add_snmpcache_info(jp, json, error);
 	else if (0 == strcmp(section, ZBX_DIAG_PREPROCESSING))
 		ret = zbx_diag_add_preproc_info(jp, json, error);
 	else if (0 == strcmp(section, ZBX_DIAG_LOCKS))
@@ -110,7 +110,7 @@ static const char	*help_message[] = {
 	"                                   target is not specified",
 	"      " ZBX_SNMP_CACHE_RELOAD "          Reload SNMP cache",
 	"      " ZBX_DIAGINFO "=section           Log internal diagnostic information of the",
-	"                                 section (historycache, preprocessing, locks) or",
+	"                                 section (historycache, preprocessing, locks, snmpcache) or",
 	"                                 everything if section is not specified",
 	"      " ZBX_PROF_ENABLE "=target         Enable profiling, affects all processes if",
 	"                                   target is not specified",
@@ -276,6 +276,8 @@ static zbx_uint64_t	config_history_cache_size	= 16 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_index_cache_size	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_trends_cache_size	= 0;
 static zbx_uint64_t	config_vmware_cache_size	= 8 * ZBX_MEBIBYTE;
+static zbx_uint64_t	config_snmp_index_cache_size	= 0;
+static char		*config_conf_cache_snapshot_file	= NULL;
 
 static int	config_unreachable_period		= 45;
 static int	config_unreachable_delay		= 15;
@@ -341,7 +343,8 @@ static const zbx_events_funcs_t	events_cbs = {
 	.clean_events_cb		= NULL,
 	.reset_event_recovery_cb	= NULL,
 	.export_events_cb		= NULL,
-	.events_update_itservices_cb	= NULL
+	.events_update_itservices_cb	= NULL,
+	.events_update_problem_index_cb	= NULL
 };
 
 typedef struct
@@ -692,6 +695,13 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 	/* because they have non-zero default values */
 #endif
 
+	if (0 != config_snmp_index_cache_size && 128 * ZBX_KIBIBYTE > config_snmp_index_cache_size)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"SNMPIndexCacheSize\" configuration parameter must be either 0"
+				" or greater than 128KB");
+		err = 1;
+	}
+
 	if (SUCCEED != zbx_validate_log_parameters(task, &log_file_cfg))
 		err = 1;
 
@@ -893,6 +903,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	0,			1},
 		{"CacheSize",			&config_conf_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"CacheSnapshotFile",		&config_conf_cache_snapshot_file,	ZBX_CFG_TYPE_STRING,
+				ZBX_CONF_PARM_OPT,	0,			0},
 		{"HistoryCacheSize",		&config_history_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&config_history_index_cache_size,	ZBX_CFG_TYPE_UINT64,
@@ -1012,6 +1024,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	256 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"VMwareTimeout",		&config_vmware_timeout,			ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			300},
+		{"SNMPIndexCacheSize",		&config_snmp_index_cache_size,		ZBX_CFG_TYPE_UINT64,
+				ZBX_CONF_PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
 		{"AllowRoot",			&config_allow_root,			ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	0,			1},
 		{"User",			&config_user,				ZBX_CFG_TYPE_STRING,
@@ -1174,6 +1188,8 @@ static void	zbx_on_exit(int ret, void *on_exit_args)
 	/* free vmware support */
 	zbx_vmware_destroy();
 
+	zbx_snmp_index_cache_destroy();
+
 	zbx_free_selfmon_collector();
 	free_proxy_history_lock(zbx_program_type);
 
@@ -1668,7 +1684,7 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	if (SUCCEED != zbx_init_configuration_cache(get_zbx_program_type, get_config_forks, config_conf_cache_size,
-			config_hostname, &error))
+			config_hostname, config_conf_cache_snapshot_file, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize configuration cache: %s", error);
 		zbx_free(error);
@@ -1689,6 +1705,13 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 
+	if (SUCCEED != zbx_snmp_index_cache_init(config_snmp_index_cache_size, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize SNMP index cache: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	if (SUCCEED != zbx_vault_token_from_env_get(&(zbx_config_vault.token), &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize vault token: %s", error);
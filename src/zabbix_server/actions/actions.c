@@ -133,127 +133,432 @@ static void	get_object_ids(const zbx_vector_db_event_t *esc_events, zbx_vector_u
 
 /******************************************************************************
  *                                                                            *
- * Parameters: esc_events - [IN]     events to check                          *
- *             condition  - [IN/OUT] Condition for matching, outputs          *
- *                                   event ids that match condition.          *
+ * Purpose: mapping between discovered triggers and their prototypes          *
+ *                                                                            *
+ * Parameters: sql           - [IN/OUT] allocated sql query                   *
+ *             sql_alloc     - [IN/OUT] how much bytes allocated              *
+ *             objectids_tmp - [IN/OUT] uses to allocate query                *
  *                                                                            *
- * Return value: SUCCEED - supported operator                                 *
- *               NOTSUPPORTED - not supported operator                        *
  *                                                                            *
  ******************************************************************************/
-static int	check_host_group_condition(const zbx_vector_db_event_t *esc_events, zbx_condition_t *condition)
+static void	trigger_parents_sql_alloc(char **sql, size_t *sql_alloc, zbx_vector_uint64_t *objectids_tmp)
 {
-	char			*sql = NULL;
-	size_t			sql_alloc = 0, sql_offset = 0;
-	zbx_db_result_t		result;
-	zbx_db_row_t		row;
-	zbx_vector_uint64_t	objectids, groupids;
-	zbx_uint64_t		condition_value;
+	size_t	sql_offset = 0;
 
-	if (ZBX_CONDITION_OPERATOR_EQUAL != condition->op && ZBX_CONDITION_OPERATOR_NOT_EQUAL != condition->op)
-		return NOTSUPPORTED;
+	zbx_snprintf_alloc(sql, sql_alloc, &sql_offset,
+			"select triggerid,parent_triggerid"
+			" from trigger_discovery"
+			" where");
 
-	ZBX_STR2UINT64(condition_value, condition->value);
+	zbx_db_add_condition_alloc(sql, sql_alloc, &sql_offset, "triggerid", objectids_tmp->values,
+			objectids_tmp->values_num);
+}
 
-	zbx_vector_uint64_create(&objectids);
-	zbx_vector_uint64_create(&groupids);
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies objects to pair for hierarchy checks                       *
+ *                                                                            *
+ * Parameters: objectids       [IN]                                           *
+ *             objectids_pair  [OUT] - objectids will be copied here          *
+ *                                                                            *
+ ******************************************************************************/
+static void	objectids_to_pair(zbx_vector_uint64_t *objectids, zbx_vector_uint64_pair_t *objectids_pair)
+{
+	zbx_vector_uint64_pair_reserve(objectids_pair, objectids->values_num);
 
-	get_object_ids(esc_events, &objectids);
-	zbx_dc_get_nested_hostgroupids(&condition_value, 1, &groupids);
+	for (int i = 0; i < objectids->values_num; i++)
+	{
+		zbx_uint64_pair_t	pair = {objectids->values[i], objectids->values[i]};
 
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-		"select distinct f.triggerid"
-		" from hosts_groups hg,hosts h,items i,functions f"
-		" where hg.hostid=h.hostid"
-			" and h.hostid=i.hostid"
-			" and i.itemid=f.itemid"
-			" and");
-
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "f.triggerid",
-			objectids.values, objectids.values_num);
+		zbx_vector_uint64_pair_append(objectids_pair, pair);
+	}
+}
 
-	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and");
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "hg.groupid", groupids.values, groupids.values_num);
+/* trigger data resolved once per event batch and shared by trigger event conditions */
+#define ZBX_ACTION_TRIGGER_HOSTS	0x01
+#define ZBX_ACTION_TRIGGER_TEMPLATES	0x02
 
-	result = zbx_db_select("%s", sql);
+typedef struct
+{
+	zbx_uint64_t		triggerid;
+	int			flags;
+	/* hosts of the trigger functions */
+	zbx_vector_uint64_t	hostids;
+	/* the trigger and the template triggers it was inherited from */
+	zbx_vector_uint64_t	templateids;
+	/* hosts of the template triggers the trigger (or its prototype) was inherited from */
+	zbx_vector_uint64_t	template_hostids;
+}
+zbx_action_trigger_t;
 
-	while (NULL != (row = zbx_db_fetch(result)))
-	{
-		zbx_uint64_t	objectid;
+typedef struct
+{
+	zbx_hashset_t	triggers;
+}
+zbx_action_triggers_t;
 
-		ZBX_STR2UINT64(objectid, row[0]);
-		if (ZBX_CONDITION_OPERATOR_NOT_EQUAL == condition->op)
-		{
-			int	index;
+static void	action_trigger_clean(void *data)
+{
+	zbx_action_trigger_t	*trigger = (zbx_action_trigger_t *)data;
 
-			if (FAIL != (index = zbx_vector_uint64_search(&objectids, objectid,
-					ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
-			{
-				zbx_vector_uint64_remove_noorder(&objectids, index);
-			}
-		}
-		else
-			add_condition_match(esc_events, condition, objectid, EVENT_OBJECT_TRIGGER);
+	zbx_vector_uint64_destroy(&trigger->hostids);
+	zbx_vector_uint64_destroy(&trigger->templateids);
+	zbx_vector_uint64_destroy(&trigger->template_hostids);
+}
 
-	}
-	zbx_db_free_result(result);
+static void	action_triggers_init(zbx_action_triggers_t *triggers)
+{
+	zbx_hashset_create_ext(&triggers->triggers, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			action_trigger_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+}
 
-	if (ZBX_CONDITION_OPERATOR_NOT_EQUAL == condition->op)
+static void	action_triggers_destroy(zbx_action_triggers_t *triggers)
+{
+	zbx_hashset_destroy(&triggers->triggers);
+}
+
+static zbx_action_trigger_t	*action_triggers_add(zbx_action_triggers_t *triggers, zbx_uint64_t triggerid)
+{
+	zbx_action_trigger_t	*trigger;
+
+	if (NULL == (trigger = (zbx_action_trigger_t *)zbx_hashset_search(&triggers->triggers, &triggerid)))
 	{
-		int	i;
+		zbx_action_trigger_t	trigger_local = {.triggerid = triggerid};
 
-		for (i = 0; i < objectids.values_num; i++)
-			add_condition_match(esc_events, condition, objectids.values[i], EVENT_OBJECT_TRIGGER);
+		trigger = (zbx_action_trigger_t *)zbx_hashset_insert(&triggers->triggers, &trigger_local,
+				sizeof(trigger_local));
+
+		zbx_vector_uint64_create(&trigger->hostids);
+		zbx_vector_uint64_create(&trigger->templateids);
+		zbx_vector_uint64_create(&trigger->template_hostids);
 	}
 
-	zbx_vector_uint64_destroy(&groupids);
-	zbx_vector_uint64_destroy(&objectids);
-	zbx_free(sql);
+	return trigger;
+}
 
-	return SUCCEED;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolves hosts of event triggers from configuration cache         *
+ *                                                                            *
+ * Parameters: triggers   - [IN/OUT] resolved trigger data                    *
+ *             esc_events - [IN] trigger events                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	action_triggers_get_hosts(zbx_action_triggers_t *triggers, const zbx_vector_db_event_t *esc_events)
+{
+	zbx_vector_uint64_t	functionids;
+
+	zbx_vector_uint64_create(&functionids);
+
+	for (int i = 0; i < esc_events->values_num; i++)
+	{
+		const zbx_db_event	*event = esc_events->values[i];
+		zbx_action_trigger_t	*trigger;
+
+		trigger = action_triggers_add(triggers, event->objectid);
+
+		if (0 != (trigger->flags & ZBX_ACTION_TRIGGER_HOSTS))
+			continue;
+
+		trigger->flags |= ZBX_ACTION_TRIGGER_HOSTS;
+
+		/* trigger was removed after the event was generated */
+		if (NULL == event->trigger.expression || NULL == event->trigger.recovery_expression)
+			continue;
+
+		zbx_db_trigger_get_all_functionids(&event->trigger, &functionids);
+		zbx_dc_get_hostids_by_functionids(&functionids, &trigger->hostids);
+		zbx_vector_uint64_clear(&functionids);
+	}
+
+	zbx_vector_uint64_destroy(&functionids);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: mapping between discovered triggers and their prototypes          *
+ * Purpose: resolves template hierarchy of event triggers                     *
  *                                                                            *
- * Parameters: sql           - [IN/OUT] allocated sql query                   *
- *             sql_alloc     - [IN/OUT] how much bytes allocated              *
- *             objectids_tmp - [IN/OUT] uses to allocate query                *
+ * Parameters: triggers   - [IN/OUT] resolved trigger data                    *
+ *             esc_events - [IN] trigger events                               *
  *                                                                            *
+ * Comments: Template triggers are not stored in configuration cache, so the  *
+ *           hierarchy is selected from database - one query per template     *
+ *           level for all triggers of the batch instead of separate queries  *
+ *           for each condition.                                              *
  *                                                                            *
  ******************************************************************************/
-static void	trigger_parents_sql_alloc(char **sql, size_t *sql_alloc, zbx_vector_uint64_t *objectids_tmp)
+static void	action_triggers_get_templates(zbx_action_triggers_t *triggers, const zbx_vector_db_event_t *esc_events)
 {
-	size_t	sql_offset = 0;
+	char				*sql = NULL;
+	size_t				sql_alloc = 0, sql_offset;
+	zbx_db_result_t			result;
+	zbx_db_row_t			row;
+	zbx_vector_uint64_t		triggerids, pending, template_triggerids;
+	zbx_vector_uint64_pair_t	parents, templates, template_hosts;
+	zbx_hashset_t			known;
+	zbx_uint64_pair_t		pair;
 
-	zbx_snprintf_alloc(sql, sql_alloc, &sql_offset,
-			"select triggerid,parent_triggerid"
-			" from trigger_discovery"
-			" where");
+	zbx_vector_uint64_create(&triggerids);
 
-	zbx_db_add_condition_alloc(sql, sql_alloc, &sql_offset, "triggerid", objectids_tmp->values,
-			objectids_tmp->values_num);
+	for (int i = 0; i < esc_events->values_num; i++)
+	{
+		zbx_action_trigger_t	*trigger;
+
+		trigger = action_triggers_add(triggers, esc_events->values[i]->objectid);
+
+		if (0 != (trigger->flags & ZBX_ACTION_TRIGGER_TEMPLATES))
+			continue;
+
+		trigger->flags |= ZBX_ACTION_TRIGGER_TEMPLATES;
+		zbx_vector_uint64_append(&triggerids, trigger->triggerid);
+	}
+
+	if (0 == triggerids.values_num)
+	{
+		zbx_vector_uint64_destroy(&triggerids);
+		return;
+	}
+
+	zbx_vector_uint64_sort(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_vector_uint64_create(&pending);
+	zbx_vector_uint64_create(&template_triggerids);
+	zbx_vector_uint64_pair_create(&parents);
+	zbx_vector_uint64_pair_create(&templates);
+	zbx_vector_uint64_pair_create(&template_hosts);
+	zbx_hashset_create(&known, (size_t)triggerids.values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	/* discovered triggers inherit templates through their prototypes */
+	trigger_parents_sql_alloc(&sql, &sql_alloc, &triggerids);
+
+	result = zbx_db_select("%s", sql);
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		ZBX_STR2UINT64(pair.first, row[0]);
+		ZBX_STR2UINT64(pair.second, row[1]);
+		zbx_vector_uint64_pair_append(&parents, pair);
+	}
+	zbx_db_free_result(result);
+
+	zbx_vector_uint64_pair_sort(&parents, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_vector_uint64_append_array(&pending, triggerids.values, triggerids.values_num);
+
+	for (int i = 0; i < parents.values_num; i++)
+		zbx_vector_uint64_append(&pending, parents.values[i].second);
+
+	zbx_vector_uint64_sort(&pending, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&pending, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (int i = 0; i < pending.values_num; i++)
+		zbx_hashset_insert(&known, &pending.values[i], sizeof(zbx_uint64_t));
+
+	/* select template trigger chains level by level */
+	while (0 != pending.values_num)
+	{
+		sql_offset = 0;
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+				"select triggerid,templateid"
+				" from triggers"
+				" where templateid is not null"
+					" and");
+		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "triggerid", pending.values,
+				pending.values_num);
+
+		zbx_vector_uint64_clear(&pending);
+
+		result = zbx_db_select("%s", sql);
+
+		while (NULL != (row = zbx_db_fetch(result)))
+		{
+			ZBX_STR2UINT64(pair.first, row[0]);
+			ZBX_STR2UINT64(pair.second, row[1]);
+			zbx_vector_uint64_pair_append(&templates, pair);
+			zbx_vector_uint64_append(&template_triggerids, pair.second);
+
+			if (NULL == zbx_hashset_search(&known, &pair.second))
+			{
+				zbx_hashset_insert(&known, &pair.second, sizeof(zbx_uint64_t));
+				zbx_vector_uint64_append(&pending, pair.second);
+			}
+		}
+		zbx_db_free_result(result);
+
+		zbx_vector_uint64_sort(&pending, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	zbx_vector_uint64_pair_sort(&templates, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	if (0 != template_triggerids.values_num)
+	{
+		zbx_vector_uint64_sort(&template_triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&template_triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		sql_offset = 0;
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset,
+				"select distinct f.triggerid,i.hostid"
+				" from functions f,items i"
+				" where f.itemid=i.itemid"
+					" and");
+		zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "f.triggerid", template_triggerids.values,
+				template_triggerids.values_num);
+
+		result = zbx_db_select("%s", sql);
+
+		while (NULL != (row = zbx_db_fetch(result)))
+		{
+			ZBX_STR2UINT64(pair.first, row[0]);
+			ZBX_STR2UINT64(pair.second, row[1]);
+			zbx_vector_uint64_pair_append(&template_hosts, pair);
+		}
+		zbx_db_free_result(result);
+
+		zbx_vector_uint64_pair_sort(&template_hosts, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	for (int i = 0; i < triggerids.values_num; i++)
+	{
+		zbx_action_trigger_t	*trigger;
+		int			index;
+
+		trigger = (zbx_action_trigger_t *)zbx_hashset_search(&triggers->triggers, &triggerids.values[i]);
+
+		/* the trigger and its template triggers */
+		pair.first = trigger->triggerid;
+
+		do
+		{
+			zbx_vector_uint64_append(&trigger->templateids, pair.first);
+
+			if (FAIL == (index = zbx_vector_uint64_pair_bsearch(&templates, pair,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+			{
+				break;
+			}
+
+			pair.first = templates.values[index].second;
+		}
+		while (FAIL == zbx_vector_uint64_search(&trigger->templateids, pair.first,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC));
+
+		/* hosts of the template triggers of the trigger or its prototype */
+		pair.first = trigger->triggerid;
+
+		if (FAIL != (index = zbx_vector_uint64_pair_bsearch(&parents, pair, ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+			pair.first = parents.values[index].second;
+
+		for (int level = 0; level < templates.values_num; level++)
+		{
+			if (FAIL == (index = zbx_vector_uint64_pair_bsearch(&templates, pair,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+			{
+				break;
+			}
+
+			pair.first = templates.values[index].second;
+
+			if (FAIL == (index = zbx_vector_uint64_pair_bsearch(&template_hosts, pair,
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
+			{
+				continue;
+			}
+
+			while (0 < index && template_hosts.values[index - 1].first == pair.first)
+				index--;
+
+			for (; index < template_hosts.values_num && template_hosts.values[index].first == pair.first;
+					index++)
+			{
+				zbx_vector_uint64_append(&trigger->template_hostids, template_hosts.values[index].second);
+			}
+		}
+
+		zbx_vector_uint64_sort(&trigger->templateids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort(&trigger->template_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&trigger->template_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	zbx_hashset_destroy(&known);
+	zbx_vector_uint64_pair_destroy(&template_hosts);
+	zbx_vector_uint64_pair_destroy(&templates);
+	zbx_vector_uint64_pair_destroy(&parents);
+	zbx_vector_uint64_destroy(&template_triggerids);
+	zbx_vector_uint64_destroy(&pending);
+	zbx_vector_uint64_destroy(&triggerids);
+	zbx_free(sql);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: copies objects to pair for hierarchy checks                       *
+ * Parameters: esc_events - [IN]     events to check                          *
+ *             condition  - [IN/OUT] Condition for matching, outputs          *
+ *                                   event ids that match condition.          *
+ *             triggers   - [IN/OUT] resolved trigger data                    *
  *                                                                            *
- * Parameters: objectids       [IN]                                           *
- *             objectids_pair  [OUT] - objectids will be copied here          *
+ * Return value: SUCCEED - supported operator                                 *
+ *               NOTSUPPORTED - not supported operator                        *
  *                                                                            *
  ******************************************************************************/
-static void	objectids_to_pair(zbx_vector_uint64_t *objectids, zbx_vector_uint64_pair_t *objectids_pair)
+static int	check_host_group_condition(const zbx_vector_db_event_t *esc_events, zbx_condition_t *condition,
+		zbx_action_triggers_t *triggers)
 {
-	zbx_vector_uint64_pair_reserve(objectids_pair, objectids->values_num);
+	zbx_vector_uint64_t	hostids, group_hostids;
+	zbx_uint64_t		condition_value;
 
-	for (int i = 0; i < objectids->values_num; i++)
+	if (ZBX_CONDITION_OPERATOR_EQUAL != condition->op && ZBX_CONDITION_OPERATOR_NOT_EQUAL != condition->op)
+		return NOTSUPPORTED;
+
+	ZBX_STR2UINT64(condition_value, condition->value);
+
+	zbx_vector_uint64_create(&hostids);
+	zbx_vector_uint64_create(&group_hostids);
+
+	action_triggers_get_hosts(triggers, esc_events);
+
+	for (int i = 0; i < esc_events->values_num; i++)
 	{
-		zbx_uint64_pair_t	pair = {objectids->values[i], objectids->values[i]};
+		const zbx_action_trigger_t	*trigger;
 
-		zbx_vector_uint64_pair_append(objectids_pair, pair);
+		trigger = (const zbx_action_trigger_t *)zbx_hashset_search(&triggers->triggers,
+				&esc_events->values[i]->objectid);
+
+		zbx_vector_uint64_append_array(&hostids, trigger->hostids.values, trigger->hostids.values_num);
 	}
+
+	zbx_vector_uint64_sort(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_uniq(&hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_dc_get_hostgroup_hostids(condition_value, &hostids, &group_hostids);
+
+	for (int i = 0; i < esc_events->values_num; i++)
+	{
+		const zbx_db_event		*event = esc_events->values[i];
+		const zbx_action_trigger_t	*trigger;
+		int				ret = FAIL;
+
+		trigger = (const zbx_action_trigger_t *)zbx_hashset_search(&triggers->triggers, &event->objectid);
+
+		for (int j = 0; j < trigger->hostids.values_num && SUCCEED != ret; j++)
+		{
+			if (FAIL != zbx_vector_uint64_bsearch(&group_hostids, trigger->hostids.values[j],
+					ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+			{
+				ret = SUCCEED;
+			}
+		}
+
+		if ((SUCCEED == ret) == (ZBX_CONDITION_OPERATOR_EQUAL == condition->op))
+			zbx_vector_uint64_append(&condition->eventids, event->eventid);
+	}
+
+	zbx_vector_uint64_destroy(&group_hostids);
+	zbx_vector_uint64_destroy(&hostids);
+
+	return SUCCEED;
 }
 
 /********************************************************************************
@@ -397,60 +702,38 @@ static void	check_object_hierarchy(int object, const zbx_vector_db_event_t *esc_
  * Parameters: esc_events - [IN] events to check                              *
  *             condition  - [IN/OUT] Condition for matching, outputs          *
  *                                   event ids that match condition.          *
+ *             triggers   - [IN/OUT] resolved trigger data                    *
  *                                                                            *
  * Return value: SUCCEED - supported operator                                 *
  *               NOTSUPPORTED - not supported operator                        *
  *                                                                            *
  ******************************************************************************/
-static int	check_host_template_condition(const zbx_vector_db_event_t *esc_events, zbx_condition_t *condition)
+static int	check_host_template_condition(const zbx_vector_db_event_t *esc_events, zbx_condition_t *condition,
+		zbx_action_triggers_t *triggers)
 {
-	char				*sql = NULL;
-	size_t				sql_alloc = 0;
-	zbx_db_result_t			result;
-	zbx_db_row_t			row;
-	zbx_uint64_t			condition_value;
-	zbx_vector_uint64_t		objectids;
-	zbx_vector_uint64_pair_t	objectids_pair;
+	zbx_uint64_t	condition_value;
 
 	if (ZBX_CONDITION_OPERATOR_EQUAL != condition->op && ZBX_CONDITION_OPERATOR_NOT_EQUAL != condition->op)
 		return NOTSUPPORTED;
 
-	zbx_vector_uint64_create(&objectids);
-	zbx_vector_uint64_pair_create(&objectids_pair);
-
-	get_object_ids(esc_events, &objectids);
-	objectids_to_pair(&objectids, &objectids_pair);
-
 	ZBX_STR2UINT64(condition_value, condition->value);
 
-	trigger_parents_sql_alloc(&sql, &sql_alloc, &objectids);
-
-	result = zbx_db_select("%s", sql);
+	action_triggers_get_templates(triggers, esc_events);
 
-	while (NULL != (row = zbx_db_fetch(result)))
+	for (int i = 0; i < esc_events->values_num; i++)
 	{
-		zbx_uint64_pair_t	pair;
-		int			i;
-
-		ZBX_STR2UINT64(pair.first, row[0]);
+		const zbx_db_event		*event = esc_events->values[i];
+		const zbx_action_trigger_t	*trigger;
+		int				ret;
 
-		if (FAIL != (i = zbx_vector_uint64_pair_search(&objectids_pair, pair, ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
-			ZBX_STR2UINT64(objectids_pair.values[i].second, row[1]);
-	}
-	zbx_db_free_result(result);
+		trigger = (const zbx_action_trigger_t *)zbx_hashset_search(&triggers->triggers, &event->objectid);
 
-	check_object_hierarchy(EVENT_OBJECT_TRIGGER, esc_events, &objectids, &objectids_pair, condition,
-			condition_value,
-			"select distinct t.triggerid,t.templateid,i.hostid"
-				" from items i,functions f,triggers t"
-				" where i.itemid=f.itemid"
-					" and f.triggerid=t.templateid"
-					" and",
-			"t.triggerid");
+		ret = zbx_vector_uint64_bsearch(&trigger->template_hostids, condition_value,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	zbx_vector_uint64_destroy(&objectids);
-	zbx_vector_uint64_pair_destroy(&objectids_pair);
-	zbx_free(sql);
+		if ((FAIL != ret) == (ZBX_CONDITION_OPERATOR_EQUAL == condition->op))
+			zbx_vector_uint64_append(&condition->eventids, event->eventid);
+	}
 
 	return SUCCEED;
 }
@@ -460,59 +743,42 @@ static int	check_host_template_condition(const zbx_vector_db_event_t *esc_events
  * Parameters: esc_events - [IN] events to check                              *
  *             condition  - [IN/OUT] Condition for matching, outputs          *
  *                                   event ids that match condition.          *
+ *             triggers   - [IN/OUT] resolved trigger data                    *
  *                                                                            *
  * Return value: SUCCEED - supported operator                                 *
  *               NOTSUPPORTED - not supported operator                        *
  *                                                                            *
  ******************************************************************************/
-static int	check_host_condition(const zbx_vector_db_event_t *esc_events, zbx_condition_t *condition)
+static int	check_host_condition(const zbx_vector_db_event_t *esc_events, zbx_condition_t *condition,
+		zbx_action_triggers_t *triggers)
 {
-	char			*sql = NULL;
-	const char		*operation;
-	size_t			sql_alloc = 0, sql_offset = 0;
-	zbx_db_result_t		result;
-	zbx_db_row_t		row;
-	zbx_vector_uint64_t	objectids;
-	zbx_uint64_t		condition_value;
+	zbx_uint64_t	condition_value;
 
-	if (ZBX_CONDITION_OPERATOR_EQUAL == condition->op)
-		operation = " and";
-	else if (ZBX_CONDITION_OPERATOR_NOT_EQUAL == condition->op)
-		operation = " and not";
-	else
+	if (ZBX_CONDITION_OPERATOR_EQUAL != condition->op && ZBX_CONDITION_OPERATOR_NOT_EQUAL != condition->op)
 		return NOTSUPPORTED;
 
 	ZBX_STR2UINT64(condition_value, condition->value);
 
-	zbx_vector_uint64_create(&objectids);
-
-	get_object_ids(esc_events, &objectids);
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-			"select distinct f.triggerid"
-			" from items i,functions f"
-			" where i.itemid=f.itemid"
-				"%s i.hostid=" ZBX_FS_UI64
-				" and",
-			operation,
-			condition_value);
+	action_triggers_get_hosts(triggers, esc_events);
 
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "f.triggerid", objectids.values,
-			objectids.values_num);
-
-	result = zbx_db_select("%s", sql);
-
-	while (NULL != (row = zbx_db_fetch(result)))
+	for (int i = 0; i < esc_events->values_num; i++)
 	{
-		zbx_uint64_t	objectid;
+		const zbx_db_event		*event = esc_events->values[i];
+		const zbx_action_trigger_t	*trigger;
 
-		ZBX_STR2UINT64(objectid, row[0]);
-		add_condition_match(esc_events, condition, objectid, EVENT_OBJECT_TRIGGER);
-	}
-	zbx_db_free_result(result);
+		trigger = (const zbx_action_trigger_t *)zbx_hashset_search(&triggers->triggers, &event->objectid);
 
-	zbx_vector_uint64_destroy(&objectids);
-	zbx_free(sql);
+		/* not equal matches triggers having functions of any other host */
+		for (int j = 0; j < trigger->hostids.values_num; j++)
+		{
+			if ((trigger->hostids.values[j] == condition_value) ==
+					(ZBX_CONDITION_OPERATOR_EQUAL == condition->op))
+			{
+				zbx_vector_uint64_append(&condition->eventids, event->eventid);
+				break;
+			}
+		}
+	}
 
 	return SUCCEED;
 }
@@ -522,54 +788,39 @@ static int	check_host_condition(const zbx_vector_db_event_t *esc_events, zbx_con
  * Parameters: esc_events - [IN] events to check                              *
  *             condition  - [IN/OUT] Condition for matching, outputs          *
  *                                   event ids that match condition.          *
+ *             triggers   - [IN/OUT] resolved trigger data                    *
  *                                                                            *
  * Return value: SUCCEED - supported operator                                 *
  *               NOTSUPPORTED - not supported operator                        *
  *                                                                            *
  ******************************************************************************/
-static int	check_trigger_id_condition(const zbx_vector_db_event_t *esc_events, zbx_condition_t *condition)
+static int	check_trigger_id_condition(const zbx_vector_db_event_t *esc_events, zbx_condition_t *condition,
+		zbx_action_triggers_t *triggers)
 {
-	zbx_uint64_t			condition_value;
-	zbx_vector_uint64_t		objectids;
-	zbx_vector_uint64_pair_t	objectids_pair;
+	zbx_uint64_t	condition_value;
 
 	if (ZBX_CONDITION_OPERATOR_EQUAL != condition->op && ZBX_CONDITION_OPERATOR_NOT_EQUAL != condition->op)
 		return NOTSUPPORTED;
 
 	ZBX_STR2UINT64(condition_value, condition->value);
 
-	zbx_vector_uint64_create(&objectids);
-	zbx_vector_uint64_pair_create(&objectids_pair);
+	action_triggers_get_templates(triggers, esc_events);
 
 	for (int i = 0; i < esc_events->values_num; i++)
 	{
-		const zbx_db_event	*event = esc_events->values[i];
+		const zbx_db_event		*event = esc_events->values[i];
+		const zbx_action_trigger_t	*trigger;
+		int				ret;
 
-		if (event->objectid == condition_value)
-		{
-			if (ZBX_CONDITION_OPERATOR_EQUAL == condition->op)
-				zbx_vector_uint64_append(&condition->eventids, event->eventid);
-		}
-		else
-			zbx_vector_uint64_append(&objectids, event->objectid);
-	}
+		trigger = (const zbx_action_trigger_t *)zbx_hashset_search(&triggers->triggers, &event->objectid);
 
-	if (0 != objectids.values_num)
-	{
-		zbx_vector_uint64_uniq(&objectids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
-		objectids_to_pair(&objectids, &objectids_pair);
+		ret = zbx_vector_uint64_bsearch(&trigger->templateids, condition_value,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-		check_object_hierarchy(EVENT_OBJECT_TRIGGER, esc_events, &objectids, &objectids_pair, condition,
-				condition_value,
-				"select triggerid,templateid,templateid"
-					" from triggers"
-					" where templateid is not null and",
-					"triggerid");
+		if ((FAIL != ret) == (ZBX_CONDITION_OPERATOR_EQUAL == condition->op))
+			zbx_vector_uint64_append(&condition->eventids, event->eventid);
 	}
 
-	zbx_vector_uint64_destroy(&objectids);
-	zbx_vector_uint64_pair_destroy(&objectids_pair);
-
 	return SUCCEED;
 }
 
@@ -859,11 +1110,13 @@ static void	check_condition_event_tag_value(const zbx_vector_db_event_t *esc_eve
  * Parameters: esc_event - [IN] trigger events to check                       *
  *                              (event->source == EVENT_SOURCE_TRIGGERS)      *
  *             condition - [IN] condition for matching                        *
+ *             triggers  - [IN/OUT] trigger data resolved for the events      *
  *                                                                            *
  * Return value: SUCCEED - matches, FAIL - otherwise                          *
  *                                                                            *
  ******************************************************************************/
-static void	check_trigger_condition(const zbx_vector_db_event_t *esc_events, zbx_condition_t *condition)
+static void	check_trigger_condition(const zbx_vector_db_event_t *esc_events, zbx_condition_t *condition,
+		zbx_action_triggers_t *triggers)
 {
 	int	ret;
 
@@ -872,16 +1125,16 @@ static void	check_trigger_condition(const zbx_vector_db_event_t *esc_events, zbx
 	switch (condition->conditiontype)
 	{
 		case ZBX_CONDITION_TYPE_HOST_GROUP:
-			ret = check_host_group_condition(esc_events, condition);
+			ret = check_host_group_condition(esc_events, condition, triggers);
 			break;
 		case ZBX_CONDITION_TYPE_HOST_TEMPLATE:
-			ret = check_host_template_condition(esc_events, condition);
+			ret = check_host_template_condition(esc_events, condition, triggers);
 			break;
 		case ZBX_CONDITION_TYPE_HOST:
-			ret = check_host_condition(esc_events, condition);
+			ret = check_host_condition(esc_events, condition, triggers);
 			break;
 		case ZBX_CONDITION_TYPE_TRIGGER:
-			ret = check_trigger_id_condition(esc_events, condition);
+			ret = check_trigger_id_condition(esc_events, condition, triggers);
 			break;
 		case ZBX_CONDITION_TYPE_EVENT_NAME:
 			ret = check_event_name_condition(esc_events, condition);
@@ -2477,9 +2730,11 @@ static void	check_internal_condition(const zbx_vector_db_event_t *esc_events, zb
  *             source     - [IN] specific event source that needs checking    *
  *             condition  - [IN/OUT] Condition for matching, outputs          *
  *                                   event ids that match condition.          *
+ *             triggers   - [IN/OUT] trigger data resolved for the events     *
  *                                                                            *
  ******************************************************************************/
-static void	check_events_condition(const zbx_vector_db_event_t *esc_events, int source, zbx_condition_t *condition)
+static void	check_events_condition(const zbx_vector_db_event_t *esc_events, int source, zbx_condition_t *condition,
+		zbx_action_triggers_t *triggers)
 {
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() actionid:" ZBX_FS_UI64 " conditionid:" ZBX_FS_UI64 " cond.value:'%s'"
 			" cond.value2:'%s'", __func__, condition->actionid, condition->conditionid,
@@ -2488,7 +2743,7 @@ static void	check_events_condition(const zbx_vector_db_event_t *esc_events, int
 	switch (source)
 	{
 		case EVENT_SOURCE_TRIGGERS:
-			check_trigger_condition(esc_events, condition);
+			check_trigger_condition(esc_events, condition, triggers);
 			break;
 		case EVENT_SOURCE_DISCOVERY:
 			check_discovery_condition(esc_events, condition);
@@ -2522,19 +2777,22 @@ int	check_action_condition(zbx_db_event *event, zbx_condition_t *condition)
 {
 	int			ret;
 	zbx_vector_db_event_t	esc_events;
+	zbx_action_triggers_t	triggers;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() actionid:" ZBX_FS_UI64 " conditionid:" ZBX_FS_UI64 " cond.value:'%s'"
 			" cond.value2:'%s'", __func__, condition->actionid, condition->conditionid,
 			ZBX_NULL2STR(condition->value), ZBX_NULL2STR(condition->value2));
 
 	zbx_vector_db_event_create(&esc_events);
+	action_triggers_init(&triggers);
 
 	zbx_vector_db_event_append(&esc_events, event);
 
-	check_events_condition(&esc_events, event->source, condition);
+	check_events_condition(&esc_events, event->source, condition, &triggers);
 
 	ret = 0 != condition->eventids.values_num ? SUCCEED : FAIL;
 
+	action_triggers_destroy(&triggers);
 	zbx_vector_db_event_destroy(&esc_events);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
@@ -3082,6 +3340,270 @@ static void	prepare_actions_conditions_eval(zbx_vector_action_eval_ptr_t *action
 	}
 }
 
+/* compiled actions, kept between event batches and rebuilt when actions are changed in configuration cache */
+typedef struct
+{
+	zbx_uint64_t			revision;
+	int				initialized;
+	zbx_vector_action_eval_ptr_t	actions;
+	zbx_hashset_t			uniq_conditions[EVENT_SOURCE_COUNT];
+	/* actions indexed by event source */
+	zbx_vector_action_eval_ptr_t	source_actions[EVENT_SOURCE_COUNT];
+	/* trigger actions indexed by trigger severities they can match */
+	zbx_vector_action_eval_ptr_t	severity_actions[TRIGGER_SEVERITY_COUNT];
+}
+zbx_action_set_t;
+
+static zbx_action_set_t	action_set;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets trigger severities matching trigger severity condition       *
+ *                                                                            *
+ * Parameters: condition - [IN]                                               *
+ *                                                                            *
+ * Return value: bitmask of matching severities                               *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	condition_get_severity_mask(const zbx_condition_t *condition)
+{
+	unsigned char	condition_value = (unsigned char)atoi(condition->value), mask = 0;
+
+	for (unsigned char severity = 0; severity < TRIGGER_SEVERITY_COUNT; severity++)
+	{
+		int	match;
+
+		switch (condition->op)
+		{
+			case ZBX_CONDITION_OPERATOR_EQUAL:
+				match = severity == condition_value;
+				break;
+			case ZBX_CONDITION_OPERATOR_NOT_EQUAL:
+				match = severity != condition_value;
+				break;
+			case ZBX_CONDITION_OPERATOR_MORE_EQUAL:
+				match = severity >= condition_value;
+				break;
+			case ZBX_CONDITION_OPERATOR_LESS_EQUAL:
+				match = severity <= condition_value;
+				break;
+			default:
+				return 0;
+		}
+
+		if (0 != match)
+			mask |= (unsigned char)(1 << severity);
+	}
+
+	return mask;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets trigger severities that can match trigger action             *
+ *                                                                            *
+ * Parameters: action - [IN]                                                  *
+ *                                                                            *
+ * Return value: bitmask of severities                                        *
+ *                                                                            *
+ * Comments: Only actions with 'and' and 'and/or' evaluation types are        *
+ *           limited by their trigger severity conditions, other actions can  *
+ *           match events of any severity.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	action_get_severity_mask(const zbx_action_eval_t *action)
+{
+	unsigned char	all = (unsigned char)((1 << TRIGGER_SEVERITY_COUNT) - 1), mask;
+	int		found = FAIL;
+
+	switch (action->evaltype)
+	{
+		case ZBX_CONDITION_EVAL_TYPE_AND_OR:
+			mask = 0;
+			break;
+		case ZBX_CONDITION_EVAL_TYPE_AND:
+			mask = all;
+			break;
+		default:
+			return all;
+	}
+
+	for (int i = 0; i < action->conditions.values_num; i++)
+	{
+		const zbx_condition_t	*condition = action->conditions.values[i];
+
+		if (ZBX_CONDITION_TYPE_TRIGGER_SEVERITY != condition->conditiontype)
+			continue;
+
+		/* conditions of the same type are OR'ed in 'and/or' evaluation */
+		if (ZBX_CONDITION_EVAL_TYPE_AND_OR == action->evaltype)
+			mask |= condition_get_severity_mask(condition);
+		else
+			mask &= condition_get_severity_mask(condition);
+
+		found = SUCCEED;
+	}
+
+	return SUCCEED == found ? mask : all;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees compiled actions                                            *
+ *                                                                            *
+ * Parameters: set - [IN] compiled actions                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	action_set_clear(zbx_action_set_t *set)
+{
+	for (int i = 0; i < EVENT_SOURCE_COUNT; i++)
+	{
+		conditions_eval_clean(&set->uniq_conditions[i]);
+		zbx_hashset_clear(&set->uniq_conditions[i]);
+		zbx_vector_action_eval_ptr_clear(&set->source_actions[i]);
+	}
+
+	for (int i = 0; i < TRIGGER_SEVERITY_COUNT; i++)
+		zbx_vector_action_eval_ptr_clear(&set->severity_actions[i]);
+
+	zbx_vector_action_eval_ptr_clear_ext(&set->actions, zbx_action_eval_free);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets compiled actions, rebuilding them if actions were changed    *
+ *          in configuration cache                                            *
+ *                                                                            *
+ * Return value: compiled actions                                             *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_action_set_t	*action_set_get(void)
+{
+	zbx_vector_action_eval_ptr_t	actions;
+
+	if (0 == action_set.initialized)
+	{
+		for (int i = 0; i < EVENT_SOURCE_COUNT; i++)
+		{
+			zbx_hashset_create(&action_set.uniq_conditions[i], 0, uniq_conditions_hash_func,
+					uniq_conditions_compare_func);
+			zbx_vector_action_eval_ptr_create(&action_set.source_actions[i]);
+		}
+
+		for (int i = 0; i < TRIGGER_SEVERITY_COUNT; i++)
+			zbx_vector_action_eval_ptr_create(&action_set.severity_actions[i]);
+
+		zbx_vector_action_eval_ptr_create(&action_set.actions);
+		action_set.initialized = 1;
+	}
+
+	zbx_vector_action_eval_ptr_create(&actions);
+
+	if (SUCCEED == zbx_dc_config_history_sync_get_actions_eval_by_revision(&actions,
+			ZBX_ACTION_OPCLASS_NORMAL | ZBX_ACTION_OPCLASS_RECOVERY, &action_set.revision))
+	{
+		action_set_clear(&action_set);
+		prepare_actions_conditions_eval(&actions, action_set.uniq_conditions);
+
+		for (int i = 0; i < actions.values_num; i++)
+		{
+			zbx_action_eval_t	*action = actions.values[i];
+
+			zbx_vector_action_eval_ptr_append(&action_set.actions, action);
+
+			if (EVENT_SOURCE_COUNT <= action->eventsource)
+				continue;
+
+			zbx_vector_action_eval_ptr_append(&action_set.source_actions[action->eventsource], action);
+
+			if (EVENT_SOURCE_TRIGGERS == action->eventsource)
+			{
+				unsigned char	mask = action_get_severity_mask(action);
+
+				for (int j = 0; j < TRIGGER_SEVERITY_COUNT; j++)
+				{
+					if (0 != (mask & (1 << j)))
+						zbx_vector_action_eval_ptr_append(&action_set.severity_actions[j], action);
+				}
+			}
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() compiled %d actions, revision:" ZBX_FS_UI64, __func__,
+				action_set.actions.values_num, action_set.revision);
+	}
+
+	zbx_vector_action_eval_ptr_destroy(&actions);
+
+	return &action_set;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets actions that can match the event                             *
+ *                                                                            *
+ * Parameters: set   - [IN] compiled actions                                  *
+ *             event - [IN]                                                   *
+ *                                                                            *
+ * Return value: actions to check or NULL if there are no actions for event   *
+ *               source                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_vector_action_eval_ptr_t	*action_set_get_event_actions(const zbx_action_set_t *set,
+		const zbx_db_event *event)
+{
+	if (EVENT_SOURCE_COUNT <= (size_t)event->source)
+		return NULL;
+
+	if (EVENT_SOURCE_TRIGGERS == event->source && TRIGGER_SEVERITY_COUNT > event->trigger.priority)
+		return &set->severity_actions[event->trigger.priority];
+
+	return &set->source_actions[event->source];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets unique conditions of the actions that can match the events   *
+ *                                                                            *
+ * Parameters: set        - [IN] compiled actions                             *
+ *             esc_events - [IN] events of the same source                    *
+ *             conditions - [OUT] the conditions to check, conditions are     *
+ *                                shared between actions of the same source   *
+ *                                                                            *
+ ******************************************************************************/
+static void	action_set_get_conditions(const zbx_action_set_t *set, const zbx_vector_db_event_t *esc_events,
+		zbx_vector_condition_ptr_t *conditions)
+{
+	/* severity action lists already added, the last bit is for all source actions */
+	int	added = 0;
+
+	for (int i = 0; i < esc_events->values_num; i++)
+	{
+		const zbx_vector_action_eval_ptr_t	*actions;
+		const zbx_db_event			*event = esc_events->values[i];
+		int					bit = TRIGGER_SEVERITY_COUNT;
+
+		if (EVENT_SOURCE_TRIGGERS == event->source && TRIGGER_SEVERITY_COUNT > event->trigger.priority)
+			bit = event->trigger.priority;
+
+		if (0 != (added & (1 << bit)))
+			continue;
+
+		added |= 1 << bit;
+
+		if (NULL == (actions = action_set_get_event_actions(set, event)))
+			continue;
+
+		for (int j = 0; j < actions->values_num; j++)
+		{
+			zbx_vector_condition_ptr_append_array(conditions, actions->values[j]->conditions.values,
+					actions->values[j]->conditions.values_num);
+		}
+	}
+
+	zbx_vector_condition_ptr_sort(conditions, ZBX_DEFAULT_PTR_COMPARE_FUNC);
+	zbx_vector_condition_ptr_uniq(conditions, ZBX_DEFAULT_PTR_COMPARE_FUNC);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes all actions of each event in list                       *
@@ -3095,12 +3617,11 @@ static void	prepare_actions_conditions_eval(zbx_vector_action_eval_ptr_t *action
 void	process_actions(zbx_vector_db_event_t *events, const zbx_vector_uint64_pair_t *closed_events,
 		zbx_vector_escalation_new_ptr_t *escalations)
 {
-	zbx_vector_action_eval_ptr_t	actions;
+	zbx_action_set_t		*set;
 	zbx_vector_uint64_pair_t	rec_escalations;
-	zbx_hashset_t			uniq_conditions[EVENT_SOURCE_COUNT];
 	zbx_vector_db_event_t		esc_events[EVENT_SOURCE_COUNT];
-	zbx_hashset_iter_t		iter;
-	zbx_condition_t			*condition;
+	zbx_vector_condition_ptr_t	conditions, source_conditions;
+	zbx_action_triggers_t		triggers;
 	zbx_dc_um_handle_t		*um_handle;
 	zbx_vector_escalation_new_ptr_t *new_escalations = escalations, local_escalations, local_rec_escalations;
 
@@ -3114,20 +3635,19 @@ void	process_actions(zbx_vector_db_event_t *events, const zbx_vector_uint64_pair
 
 	zbx_vector_escalation_new_ptr_create(&local_rec_escalations);
 	zbx_vector_uint64_pair_create(&rec_escalations);
+	zbx_vector_condition_ptr_create(&conditions);
+	zbx_vector_condition_ptr_create(&source_conditions);
+	action_triggers_init(&triggers);
 
 	for (int i = 0; i < EVENT_SOURCE_COUNT; i++)
-	{
-		zbx_hashset_create(&uniq_conditions[i], 0, uniq_conditions_hash_func, uniq_conditions_compare_func);
 		zbx_vector_db_event_create(&esc_events[i]);
-	}
 
-	zbx_vector_action_eval_ptr_create(&actions);
-	zbx_dc_config_history_sync_get_actions_eval(&actions, ZBX_ACTION_OPCLASS_NORMAL | ZBX_ACTION_OPCLASS_RECOVERY);
-	prepare_actions_conditions_eval(&actions, uniq_conditions);
+	set = action_set_get();
 	get_escalation_events(events, esc_events);
 
 	um_handle = zbx_dc_open_user_macros();
 
+	/* check only conditions of the actions that can match the events, each condition once for all events */
 	for (int i = 0; i < EVENT_SOURCE_COUNT; i++)
 	{
 		if (0 == esc_events[i].values_num)
@@ -3135,10 +3655,14 @@ void	process_actions(zbx_vector_db_event_t *events, const zbx_vector_uint64_pair
 
 		zbx_vector_db_event_sort(&esc_events[i], compare_events);
 
-		zbx_hashset_iter_reset(&uniq_conditions[i], &iter);
+		action_set_get_conditions(set, &esc_events[i], &source_conditions);
 
-		while (NULL != (condition = (zbx_condition_t *)zbx_hashset_iter_next(&iter)))
-			check_events_condition(&esc_events[i], i, condition);
+		for (int j = 0; j < source_conditions.values_num; j++)
+			check_events_condition(&esc_events[i], i, source_conditions.values[j], &triggers);
+
+		zbx_vector_condition_ptr_append_array(&conditions, source_conditions.values,
+				source_conditions.values_num);
+		zbx_vector_condition_ptr_clear(&source_conditions);
 	}
 
 	zbx_dc_close_user_macros(um_handle);
@@ -3148,17 +3672,18 @@ void	process_actions(zbx_vector_db_event_t *events, const zbx_vector_uint64_pair
 	/*    operations) for events that match action conditions.                                                   */
 	for (int i = 0; i < events->values_num; i++)
 	{
-		zbx_db_event	*event;
+		const zbx_vector_action_eval_ptr_t	*actions;
+		zbx_db_event				*event;
 
 		if (FAIL == is_escalation_event((event = events->values[i])))
 			continue;
 
-		for (int j = 0; j < actions.values_num; j++)
-		{
-			zbx_action_eval_t	*action = actions.values[j];
+		if (NULL == (actions = action_set_get_event_actions(set, event)))
+			continue;
 
-			if (action->eventsource != event->source)
-				continue;
+		for (int j = 0; j < actions->values_num; j++)
+		{
+			zbx_action_eval_t	*action = actions->values[j];
 
 			if (SUCCEED == check_action_conditions(event->eventid, action))
 			{
@@ -3181,15 +3706,16 @@ void	process_actions(zbx_vector_db_event_t *events, const zbx_vector_uint64_pair
 		}
 	}
 
+	/* condition results are valid only for the current events */
+	for (int i = 0; i < conditions.values_num; i++)
+		zbx_vector_uint64_clear(&conditions.values[i]->eventids);
+
 	for (int i = 0; i < EVENT_SOURCE_COUNT; i++)
-	{
 		zbx_vector_db_event_destroy(&esc_events[i]);
-		conditions_eval_clean(&uniq_conditions[i]);
-		zbx_hashset_destroy(&uniq_conditions[i]);
-	}
 
-	zbx_vector_action_eval_ptr_clear_ext(&actions, zbx_action_eval_free);
-	zbx_vector_action_eval_ptr_destroy(&actions);
+	action_triggers_destroy(&triggers);
+	zbx_vector_condition_ptr_destroy(&source_conditions);
+	zbx_vector_condition_ptr_destroy(&conditions);
 
 	/* 3. Find recovered escalations and store escalationids in 'rec_escalation' by OK eventids. */
 	if (0 != closed_events->values_num)
@@ -3389,6 +3915,7 @@ int	process_actions_by_acknowledgments(const zbx_vector_ack_task_ptr_t *ack_task
 	zbx_condition_t			*condition;
 	zbx_dc_um_handle_t		*um_handle;
 	zbx_vector_db_event_t		events;
+	zbx_action_triggers_t		triggers;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -3430,6 +3957,7 @@ int	process_actions_by_acknowledgments(const zbx_vector_ack_task_ptr_t *ack_task
 	}
 
 	um_handle = zbx_dc_open_user_macros();
+	action_triggers_init(&triggers);
 
 	for (int i = 0; i < EVENT_SOURCE_COUNT; i++)
 	{
@@ -3441,9 +3969,10 @@ int	process_actions_by_acknowledgments(const zbx_vector_ack_task_ptr_t *ack_task
 		zbx_hashset_iter_reset(&uniq_conditions[i], &iter);
 
 		while (NULL != (condition = (zbx_condition_t *)zbx_hashset_iter_next(&iter)))
-			check_events_condition(&esc_events[i], i, condition);
+			check_events_condition(&esc_events[i], i, condition, &triggers);
 	}
 
+	action_triggers_destroy(&triggers);
 	zbx_dc_close_user_macros(um_handle);
 
 	for (int i = 0; i < eventids.values_num; i++)
@@ -1494,6 +1494,9 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 				}
 				while (ZBX_DB_DOWN == txn_error);
 
+				if (ZBX_DB_OK == txn_error && NULL != events_cbs->events_update_problem_index_cb)
+					events_cbs->events_update_problem_index_cb();
+
 				if (ZBX_DB_OK == txn_error && NULL != events_cbs->events_update_itservices_cb)
 					events_cbs->events_update_itservices_cb();
 			}
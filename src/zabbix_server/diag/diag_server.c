@@ -21,6 +21,7 @@
 #include "zbxalerter.h"
 #include "zbxtime.h"
 #include "zbxpreproc.h"
+#include "zbxpoller.h"
 #include "zbxalgo.h"
 #include "zbxshmem.h"
 #include "zbxjson.h"
@@ -543,6 +544,8 @@ int	diag_add_section_info(const char *section, const struct zbx_json_parse *jp,
 	}
 	else if (0 == strcmp(section, ZBX_DIAG_CONNECTOR))
 		ret = zbx_diag_add_connector_info(jp, json, error);
+	else if (0 == strcmp(section, ZBX_DIAG_SNMPCACHE))
+		ret = zbx_diag_add_snmpcache_info(jp, json, error);
 	else
 		*error = zbx_dsprintf(*error, "Unsupported diagnostics section: %s", section);
 
@@ -109,6 +109,31 @@ ZBX_PTR_VECTOR_IMPL(tag_filter_ptr, zbx_tag_filter_t*)
 ZBX_PTR_VECTOR_DECL(db_escalation_ptr, zbx_db_escalation*)
 ZBX_PTR_VECTOR_IMPL(db_escalation_ptr, zbx_db_escalation*)
 
+/* scheduled escalation check */
+typedef struct
+{
+	zbx_uint64_t	escalationid;
+	int		nextcheck;
+}
+zbx_escalation_schedule_entry_t;
+
+/* in-memory schedule of escalations handled by escalator process, ordered by nextcheck */
+typedef struct
+{
+	/* zbx_escalation_schedule_entry_t, indexed by escalationid */
+	zbx_hashset_t		entries;
+
+	/* entries ordered by nextcheck, keyed by escalationid */
+	zbx_binary_heap_t	queue;
+
+	/* the largest escalation identifier read from database */
+	zbx_uint64_t		lastid;
+
+	/* time of the next full schedule reload */
+	int			resync_time;
+}
+zbx_escalation_schedule_t;
+
 static void	zbx_tag_filter_free(zbx_tag_filter_t *tag_filter)
 {
 	zbx_free(tag_filter->tag);
@@ -3212,6 +3237,7 @@ static int	process_db_escalations(int now, int *nextcheck, zbx_vector_db_escalat
 				zbx_vector_uint64_append(&escalationids, escalation->escalationid);
 				continue;
 			case ZBX_ESCALATION_DELETE:
+				escalation->status = ESCALATION_STATUS_COMPLETED;
 				zbx_vector_uint64_append(&escalationids, escalation->escalationid);
 				continue;
 			case ZBX_ESCALATION_SKIP:
@@ -3422,140 +3448,347 @@ out:
 #undef ZBX_DIFF_ESCALATION_UPDATE_STATUS
 #undef ZBX_DIFF_ESCALATION_UPDATE
 
-/********************************************************************************
- *                                                                              *
- * Purpose: Executes escalation steps and recovery operations;                  *
- *          postpones escalations during maintenance and due to trigger dep.;   *
- *          deletes completed escalations from the database;                    *
- *          cancels escalations due to changed configuration, etc.              *
- *                                                                              *
- * Parameters: now                     - [IN] current time                      *
- *             nextcheck               - [IN/OUT] time of next invocation       *
- *             escalation_source       - [IN] type of escalations to be handled *
- *             default_timezone        - [IN]                                   *
- *             process_num             - [IN] process number                    *
- *             config_timeout          - [IN]                                   *
- *             config_trapper_timeout  - [IN]                                   *
- *             config_source_ip        - [IN]                                   *
- *             config_ssh_key_location - [IN]                                   *
- *             get_config_forks        - [IN]                                   *
- *             program_type            - [IN]                                   *
- *             escalationids           - [IN]                                   *
- *             triggerids              - [IN]                                   *
- *                                                                              *
- * Return value: count of deleted escalations                                   *
- *                                                                              *
- * Comments: actions.c:process_actions() creates pseudo-escalations also for    *
- *           EVENT_SOURCE_DISCOVERY, EVENT_SOURCE_AUTOREGISTRATION events,      *
- *           this function handles message and command operations for these     *
- *           events while host, group, template operations are handled          *
- *           in process_actions().                                              *
- *                                                                              *
- ********************************************************************************/
-static int	process_escalations(int now, int *nextcheck, unsigned int escalation_source,
-		const char *default_timezone, int process_num, int config_timeout, int config_trapper_timeout,
-		const char *config_source_ip, const char *config_ssh_key_location,
-		zbx_get_config_forks_f get_config_forks, int config_enable_global_scripts, unsigned char program_type,
-		zbx_vector_uint64_t *escalationids, zbx_vector_uint64_t *triggerids)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compares escalation schedule entries by nextcheck                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	escalation_schedule_compare(const void *d1, const void *d2)
 {
-	int				ret = 0;
-	zbx_db_result_t			result;
-	zbx_db_row_t			row;
-	char				*filter = NULL;
-	size_t				filter_alloc = 0, filter_offset = 0;
-	zbx_vector_db_escalation_ptr_t	escalations;
-	zbx_vector_uint64_t		actionids, eventids, problem_eventids;
-	zbx_db_escalation		*escalation;
+	const zbx_binary_heap_elem_t		*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t		*e2 = (const zbx_binary_heap_elem_t *)d2;
+	const zbx_escalation_schedule_entry_t	*s1 = (const zbx_escalation_schedule_entry_t *)e1->data;
+	const zbx_escalation_schedule_entry_t	*s2 = (const zbx_escalation_schedule_entry_t *)e2->data;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	ZBX_RETURN_IF_NOT_EQUAL(s1->nextcheck, s2->nextcheck);
+	ZBX_RETURN_IF_NOT_EQUAL(s1->escalationid, s2->escalationid);
 
-	zbx_vector_db_escalation_ptr_create(&escalations);
-	zbx_vector_uint64_create(&actionids);
-	zbx_vector_uint64_create(&eventids);
-	zbx_vector_uint64_create(&problem_eventids);
+	return 0;
+}
+
+static void	escalation_schedule_init(zbx_escalation_schedule_t *schedule)
+{
+	zbx_hashset_create(&schedule->entries, 1000, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_binary_heap_create(&schedule->queue, escalation_schedule_compare, ZBX_BINARY_HEAP_OPTION_DIRECT);
+	schedule->lastid = 0;
+	schedule->resync_time = 0;
+}
+
+static void	escalation_schedule_destroy(zbx_escalation_schedule_t *schedule)
+{
+	zbx_binary_heap_destroy(&schedule->queue);
+	zbx_hashset_destroy(&schedule->entries);
+}
 
-	if (((NULL != escalationids) && (NULL != triggerids)) && ((0 != escalationids->values_num) ||
-			(0 != triggerids->values_num)))
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds escalation to schedule or updates its nextcheck              *
+ *                                                                            *
+ * Parameters: schedule     - [IN/OUT]                                        *
+ *             escalationid - [IN]                                            *
+ *             nextcheck    - [IN] time when the escalation must be checked   *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_schedule_set(zbx_escalation_schedule_t *schedule, zbx_uint64_t escalationid, int nextcheck)
+{
+	zbx_escalation_schedule_entry_t	*entry, entry_local;
+	zbx_binary_heap_elem_t		elem;
+
+	if (NULL == (entry = (zbx_escalation_schedule_entry_t *)zbx_hashset_search(&schedule->entries,
+			&escalationid)))
 	{
-		zbx_db_add_condition_alloc(&filter, &filter_alloc, &filter_offset, "escalationid",
-				escalationids->values, escalationids->values_num);
-		zbx_strcpy_alloc(&filter, &filter_alloc, &filter_offset, " and ");
-		zbx_db_add_condition_alloc(&filter, &filter_alloc, &filter_offset, "triggerid",
-				triggerids->values, triggerids->values_num);
+		entry_local.escalationid = escalationid;
+		entry_local.nextcheck = nextcheck;
+		entry = (zbx_escalation_schedule_entry_t *)zbx_hashset_insert(&schedule->entries, &entry_local,
+				sizeof(entry_local));
+
+		elem.key = escalationid;
+		elem.data = (void *)entry;
+		zbx_binary_heap_insert(&schedule->queue, &elem);
+
+		return;
+	}
+
+	if (entry->nextcheck == nextcheck)
+		return;
+
+	entry->nextcheck = nextcheck;
+
+	elem.key = escalationid;
+	elem.data = (void *)entry;
+	zbx_binary_heap_update_direct(&schedule->queue, &elem);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: synchronizes escalation schedule with escalations table           *
+ *                                                                            *
+ * Parameters: schedule - [IN/OUT]                                            *
+ *             now      - [IN] current time                                   *
+ *             filter   - [IN] escalations handled by this process            *
+ *                                                                            *
+ * Comments: The schedule is fully reloaded on startup and then periodically  *
+ *           to pick up changes done by other processes without notifying     *
+ *           escalator. Between reloads only escalations with identifiers     *
+ *           above the last seen one or already due escalations are read,     *
+ *           which are primary key and nextcheck index range scans. Due       *
+ *           escalations cover the ones committed out of identifier order,    *
+ *           for example acknowledgement escalations created by task manager. *
+ *           New and recovered trigger escalations are also added by          *
+ *           escalator notifications from history syncers.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_schedule_sync(zbx_escalation_schedule_t *schedule, int now, const char *filter)
+{
+#define ZBX_ESCALATION_SCHEDULE_RESYNC_PERIOD	(10 * SEC_PER_MIN)
+
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+	zbx_uint64_t	escalationid, lastid;
+	int		num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (schedule->resync_time <= now)
+	{
+		zbx_binary_heap_clear(&schedule->queue);
+		zbx_hashset_clear(&schedule->entries);
+
+		schedule->lastid = 0;
+		schedule->resync_time = now + ZBX_ESCALATION_SCHEDULE_RESYNC_PERIOD;
+
+		result = zbx_db_select("select escalationid,nextcheck from escalations where %s", filter);
 	}
 	else
 	{
+		result = zbx_db_select("select escalationid,nextcheck from escalations where %s and (escalationid>"
+				ZBX_FS_UI64 " or nextcheck<=%d)", filter, schedule->lastid, now);
+	}
 
-		/* Selection of escalations to be processed:                                                          */
-		/*                                                                                                    */
-		/* e - row in escalations table, E - escalations table, S - ordered* set of escalations to be proc.   */
-		/*                                                                                                    */
-		/* ZBX_ESCALATION_SOURCE_TRIGGER: S = {e in E | e.triggerid    mod process_num == 0}                  */
-		/* ZBX_ESCALATION_SOURCE_ITEM::   S = {e in E | e.itemid       mod process_num == 0}                  */
-		/* ZBX_ESCALATION_SOURCE_DEFAULT: S = {e in E | e.escalationid mod process_num == 0}                  */
-		/*                                                                                                    */
-		/* Note that each escalator always handles all escalations from the same triggers and items.          */
-		/* The rest of the escalations (e.g. not trigger or item based) are spread evenly between escalators. */
-		/*                                                                                                    */
-		/* * by e.actionid, e.triggerid, e.itemid, e.escalationid                                             */
-		switch (escalation_source)
-		{
-			case ZBX_ESCALATION_SOURCE_TRIGGER:
-				zbx_strcpy_alloc(&filter, &filter_alloc, &filter_offset, "triggerid is not null");
-
-				if (1 < get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR))
-				{
-					zbx_snprintf_alloc(&filter, &filter_alloc, &filter_offset,
-							" and " ZBX_SQL_MOD(triggerid, %d) "=%d",
-							get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR), process_num - 1);
-				}
+	lastid = schedule->lastid;
 
-				break;
-			case ZBX_ESCALATION_SOURCE_ITEM:
-				zbx_strcpy_alloc(&filter, &filter_alloc, &filter_offset, "triggerid is null and"
-						" itemid is not null");
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		ZBX_STR2UINT64(escalationid, row[0]);
 
-				if (1 < get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR))
-				{
-					zbx_snprintf_alloc(&filter, &filter_alloc, &filter_offset,
-							" and " ZBX_SQL_MOD(itemid, %d) "=%d",
-							get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR), process_num - 1);
-				}
-				break;
+		/* do not move already scheduled escalations, they are rescheduled after processing */
+		if (NULL == zbx_hashset_search(&schedule->entries, &escalationid))
+		{
+			escalation_schedule_set(schedule, escalationid, atoi(row[1]));
+			num++;
+		}
 
-			case ZBX_ESCALATION_SOURCE_SERVICE:
-				zbx_strcpy_alloc(&filter, &filter_alloc, &filter_offset,
-						"triggerid is null and itemid is null and serviceid is not null");
+		if (escalationid > lastid)
+			lastid = escalationid;
+	}
+	zbx_db_free_result(result);
 
-				if (1 < get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR))
-				{
-					zbx_snprintf_alloc(&filter, &filter_alloc, &filter_offset,
-							" and " ZBX_SQL_MOD(serviceid, %d) "=%d",
-							get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR), process_num - 1);
-				}
+	schedule->lastid = lastid;
 
-				break;
-			case ZBX_ESCALATION_SOURCE_DEFAULT:
-				zbx_strcpy_alloc(&filter, &filter_alloc, &filter_offset,
-						"triggerid is null and itemid is null and serviceid is null");
-				if (1 < get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR))
-				{
-					zbx_snprintf_alloc(&filter, &filter_alloc, &filter_offset,
-							" and " ZBX_SQL_MOD(escalationid, %d) "=%d",
-							get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR), process_num - 1);
-				}
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() added:%d scheduled:%d", __func__, num,
+			schedule->entries.num_data);
 
-				break;
-		}
+#undef ZBX_ESCALATION_SCHEDULE_RESYNC_PERIOD
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes escalations that must be checked now from schedule        *
+ *                                                                            *
+ * Parameters: schedule      - [IN/OUT]                                       *
+ *             now           - [IN] current time                              *
+ *             escalationids - [OUT] due escalations                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_schedule_pop_due(zbx_escalation_schedule_t *schedule, int now,
+		zbx_vector_uint64_t *escalationids)
+{
+	while (SUCCEED != zbx_binary_heap_empty(&schedule->queue))
+	{
+		zbx_binary_heap_elem_t		*elem;
+		zbx_escalation_schedule_entry_t	*entry;
+
+		elem = zbx_binary_heap_find_min(&schedule->queue);
+		entry = (zbx_escalation_schedule_entry_t *)elem->data;
+
+		if (entry->nextcheck > now)
+			break;
+
+		zbx_vector_uint64_append(escalationids, entry->escalationid);
+
+		zbx_binary_heap_remove_min(&schedule->queue);
+		zbx_hashset_remove_direct(&schedule->entries, entry);
 	}
 
+	zbx_vector_uint64_sort(escalationids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns time of the earliest scheduled escalation check           *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_schedule_get_nextcheck(const zbx_escalation_schedule_t *schedule, int *nextcheck)
+{
+	const zbx_escalation_schedule_entry_t	*entry;
+
+	if (SUCCEED == zbx_binary_heap_empty(&schedule->queue))
+		return;
+
+	entry = (const zbx_escalation_schedule_entry_t *)zbx_binary_heap_find_min(&schedule->queue)->data;
+
+	if (entry->nextcheck < *nextcheck)
+		*nextcheck = entry->nextcheck;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reschedules processed escalations, completed escalations are      *
+ *          deleted from database and are not scheduled anymore               *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_schedule_update(zbx_escalation_schedule_t *schedule, int now,
+		const zbx_vector_db_escalation_ptr_t *escalations)
+{
+	for (int i = 0; i < escalations->values_num; i++)
+	{
+		const zbx_db_escalation	*escalation = escalations->values[i];
+
+		if (ESCALATION_STATUS_COMPLETED == escalation->status)
+			continue;
+
+		/* skipped escalations are checked again in the next CONFIG_ESCALATOR_FREQUENCY period */
+		escalation_schedule_set(schedule, escalation->escalationid, MAX(escalation->nextcheck,
+				now + CONFIG_ESCALATOR_FREQUENCY));
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds filter of escalations handled by the escalator process       *
+ *                                                                            *
+ * Parameters: escalation_source - [IN] type of escalations to be handled     *
+ *             process_num       - [IN] process number                        *
+ *             get_config_forks  - [IN]                                       *
+ *             filter            - [OUT]                                      *
+ *             filter_alloc      - [IN/OUT]                                   *
+ *             filter_offset     - [IN/OUT]                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	escalation_add_source_filter(unsigned int escalation_source, int process_num,
+		zbx_get_config_forks_f get_config_forks, char **filter, size_t *filter_alloc, size_t *filter_offset)
+{
+	/* Selection of escalations to be processed:                                                          */
+	/*                                                                                                    */
+	/* e - row in escalations table, E - escalations table, S - ordered* set of escalations to be proc.   */
+	/*                                                                                                    */
+	/* ZBX_ESCALATION_SOURCE_TRIGGER: S = {e in E | e.triggerid    mod process_num == 0}                  */
+	/* ZBX_ESCALATION_SOURCE_ITEM::   S = {e in E | e.itemid       mod process_num == 0}                  */
+	/* ZBX_ESCALATION_SOURCE_DEFAULT: S = {e in E | e.escalationid mod process_num == 0}                  */
+	/*                                                                                                    */
+	/* Note that each escalator always handles all escalations from the same triggers and items.          */
+	/* The rest of the escalations (e.g. not trigger or item based) are spread evenly between escalators. */
+	/*                                                                                                    */
+	/* * by e.actionid, e.triggerid, e.itemid, e.escalationid                                             */
+	switch (escalation_source)
+	{
+		case ZBX_ESCALATION_SOURCE_TRIGGER:
+			zbx_strcpy_alloc(filter, filter_alloc, filter_offset, "triggerid is not null");
+
+			if (1 < get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR))
+			{
+				zbx_snprintf_alloc(filter, filter_alloc, filter_offset,
+						" and " ZBX_SQL_MOD(triggerid, %d) "=%d",
+						get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR), process_num - 1);
+			}
+
+			break;
+		case ZBX_ESCALATION_SOURCE_ITEM:
+			zbx_strcpy_alloc(filter, filter_alloc, filter_offset, "triggerid is null and"
+					" itemid is not null");
+
+			if (1 < get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR))
+			{
+				zbx_snprintf_alloc(filter, filter_alloc, filter_offset,
+						" and " ZBX_SQL_MOD(itemid, %d) "=%d",
+						get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR), process_num - 1);
+			}
+			break;
+
+		case ZBX_ESCALATION_SOURCE_SERVICE:
+			zbx_strcpy_alloc(filter, filter_alloc, filter_offset,
+					"triggerid is null and itemid is null and serviceid is not null");
+
+			if (1 < get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR))
+			{
+				zbx_snprintf_alloc(filter, filter_alloc, filter_offset,
+						" and " ZBX_SQL_MOD(serviceid, %d) "=%d",
+						get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR), process_num - 1);
+			}
+
+			break;
+		case ZBX_ESCALATION_SOURCE_DEFAULT:
+			zbx_strcpy_alloc(filter, filter_alloc, filter_offset,
+					"triggerid is null and itemid is null and serviceid is null");
+			if (1 < get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR))
+			{
+				zbx_snprintf_alloc(filter, filter_alloc, filter_offset,
+						" and " ZBX_SQL_MOD(escalationid, %d) "=%d",
+						get_config_forks(ZBX_PROCESS_TYPE_ESCALATOR), process_num - 1);
+			}
+
+			break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: selects escalations matching filter and processes the due ones    *
+ *          in batches                                                        *
+ *                                                                            *
+ * Parameters: now                     - [IN] current time                    *
+ *             nextcheck               - [IN/OUT] time of next invocation     *
+ *             filter                  - [IN] escalation selection condition  *
+ *             schedule                - [IN/OUT] escalation schedule,        *
+ *                                                optional                    *
+ *             default_timezone        - [IN]                                 *
+ *             config_timeout          - [IN]                                 *
+ *             config_trapper_timeout  - [IN]                                 *
+ *             config_source_ip        - [IN]                                 *
+ *             config_ssh_key_location - [IN]                                 *
+ *             get_config_forks        - [IN]                                 *
+ *             program_type            - [IN]                                 *
+ *                                                                            *
+ * Return value: count of deleted escalations                                 *
+ *                                                                            *
+ * Comments: When schedule is set the escalations that are not due yet are    *
+ *           rescheduled and processed escalations are rescheduled by their   *
+ *           new nextcheck.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_escalations_by_filter(int now, int *nextcheck, const char *filter,
+		zbx_escalation_schedule_t *schedule, const char *default_timezone, int config_timeout,
+		int config_trapper_timeout, const char *config_source_ip, const char *config_ssh_key_location,
+		zbx_get_config_forks_f get_config_forks, int config_enable_global_scripts, unsigned char program_type)
+{
+	int				ret = 0;
+	zbx_db_result_t			result;
+	zbx_db_row_t			row;
+	zbx_vector_db_escalation_ptr_t	escalations;
+	zbx_vector_uint64_t		actionids, eventids, problem_eventids;
+	zbx_db_escalation		*escalation;
+
+	zbx_vector_db_escalation_ptr_create(&escalations);
+	zbx_vector_uint64_create(&actionids);
+	zbx_vector_uint64_create(&eventids);
+	zbx_vector_uint64_create(&problem_eventids);
+
 	result = zbx_db_select("select escalationid,actionid,triggerid,eventid,r_eventid,nextcheck,esc_step,status,"
 					"itemid,acknowledgeid,servicealarmid,serviceid"
 				" from escalations"
-				" where %s and nextcheck<=%d"
+				" where %s"
 				" order by actionid,triggerid,itemid," ZBX_SQL_SORT_ASC("r_eventid") ",escalationid",
-				filter, now + CONFIG_ESCALATOR_FREQUENCY);
-	zbx_free(filter);
+				filter);
 
 	while (NULL != (row = zbx_db_fetch(result)) && ZBX_IS_RUNNING())
 	{
@@ -3568,6 +3801,14 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 		/* skip escalations that must be checked in next CONFIG_ESCALATOR_FREQUENCY period */
 		if (esc_nextcheck > now)
 		{
+			if (NULL != schedule)
+			{
+				zbx_uint64_t	escalationid;
+
+				ZBX_STR2UINT64(escalationid, row[0]);
+				escalation_schedule_set(schedule, escalationid, esc_nextcheck);
+			}
+
 			if (esc_nextcheck < *nextcheck)
 				*nextcheck = esc_nextcheck;
 
@@ -3601,6 +3842,10 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 			ret += process_db_escalations(now, nextcheck, &escalations, &eventids, &problem_eventids,
 					&actionids, default_timezone, config_timeout, config_trapper_timeout,
 					config_source_ip, config_ssh_key_location, get_config_forks, config_enable_global_scripts, program_type);
+
+			if (NULL != schedule)
+				escalation_schedule_update(schedule, now, &escalations);
+
 			zbx_vector_db_escalation_ptr_clear_ext(&escalations,
 					(void (*)(zbx_db_escalation *))zbx_ptr_free);
 			zbx_vector_uint64_clear(&actionids);
@@ -3617,6 +3862,10 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 		ret += process_db_escalations(now, nextcheck, &escalations, &eventids, &problem_eventids,
 				&actionids, default_timezone, config_timeout, config_trapper_timeout,
 				config_source_ip, config_ssh_key_location, get_config_forks, config_enable_global_scripts, program_type);
+
+		if (NULL != schedule)
+			escalation_schedule_update(schedule, now, &escalations);
+
 		zbx_vector_db_escalation_ptr_clear_ext(&escalations, (void (*)(zbx_db_escalation *))zbx_ptr_free);
 	}
 
@@ -3625,6 +3874,97 @@ static int	process_escalations(int now, int *nextcheck, unsigned int escalation_
 	zbx_vector_uint64_destroy(&eventids);
 	zbx_vector_uint64_destroy(&problem_eventids);
 
+	return ret;
+}
+
+/********************************************************************************
+ *                                                                              *
+ * Purpose: Executes escalation steps and recovery operations;                  *
+ *          postpones escalations during maintenance and due to trigger dep.;   *
+ *          deletes completed escalations from the database;                    *
+ *          cancels escalations due to changed configuration, etc.              *
+ *                                                                              *
+ * Parameters: now                     - [IN] current time                      *
+ *             nextcheck               - [IN/OUT] time of next invocation       *
+ *             escalation_source       - [IN] type of escalations to be handled *
+ *             default_timezone        - [IN]                                   *
+ *             process_num             - [IN] process number                    *
+ *             config_timeout          - [IN]                                   *
+ *             config_trapper_timeout  - [IN]                                   *
+ *             config_source_ip        - [IN]                                   *
+ *             config_ssh_key_location - [IN]                                   *
+ *             get_config_forks        - [IN]                                   *
+ *             program_type            - [IN]                                   *
+ *             schedule                - [IN/OUT] escalation schedule, optional *
+ *                                                                              *
+ * Return value: count of deleted escalations                                   *
+ *                                                                              *
+ * Comments: actions.c:process_actions() creates pseudo-escalations also for    *
+ *           EVENT_SOURCE_DISCOVERY, EVENT_SOURCE_AUTOREGISTRATION events,      *
+ *           this function handles message and command operations for these     *
+ *           events while host, group, template operations are handled          *
+ *           in process_actions().                                              *
+ *                                                                              *
+ *           When schedule is set the due escalations are taken from the        *
+ *           in-memory schedule and read from database by their identifiers,    *
+ *           otherwise escalations table is scanned by nextcheck.               *
+ *                                                                              *
+ ********************************************************************************/
+static int	process_escalations(int now, int *nextcheck, unsigned int escalation_source,
+		const char *default_timezone, int process_num, int config_timeout, int config_trapper_timeout,
+		const char *config_source_ip, const char *config_ssh_key_location,
+		zbx_get_config_forks_f get_config_forks, int config_enable_global_scripts, unsigned char program_type,
+		zbx_escalation_schedule_t *schedule)
+{
+	int			ret = 0;
+	char			*filter = NULL;
+	size_t			filter_alloc = 0, filter_offset = 0;
+	zbx_vector_uint64_t	escalationids;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	escalation_add_source_filter(escalation_source, process_num, get_config_forks, &filter, &filter_alloc,
+			&filter_offset);
+
+	if (NULL == schedule)
+	{
+		zbx_snprintf_alloc(&filter, &filter_alloc, &filter_offset, " and nextcheck<=%d",
+				now + CONFIG_ESCALATOR_FREQUENCY);
+
+		ret = process_escalations_by_filter(now, nextcheck, filter, NULL, default_timezone, config_timeout,
+				config_trapper_timeout, config_source_ip, config_ssh_key_location, get_config_forks,
+				config_enable_global_scripts, program_type);
+		goto out;
+	}
+
+#define ZBX_ESCALATIONS_SELECT_BATCH	1000
+
+	zbx_vector_uint64_create(&escalationids);
+
+	escalation_schedule_sync(schedule, now, filter);
+	escalation_schedule_pop_due(schedule, now, &escalationids);
+
+	for (int i = 0; i < escalationids.values_num && ZBX_IS_RUNNING(); i += ZBX_ESCALATIONS_SELECT_BATCH)
+	{
+		int	batch_num = MIN(ZBX_ESCALATIONS_SELECT_BATCH, escalationids.values_num - i);
+
+		filter_offset = 0;
+		zbx_db_add_condition_alloc(&filter, &filter_alloc, &filter_offset, "escalationid",
+				escalationids.values + i, batch_num);
+
+		ret += process_escalations_by_filter(now, nextcheck, filter, schedule, default_timezone,
+				config_timeout, config_trapper_timeout, config_source_ip, config_ssh_key_location,
+				get_config_forks, config_enable_global_scripts, program_type);
+	}
+
+	escalation_schedule_get_nextcheck(schedule, nextcheck);
+
+	zbx_vector_uint64_destroy(&escalationids);
+
+#undef ZBX_ESCALATIONS_SELECT_BATCH
+out:
+	zbx_free(filter);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return ret;	/* performance metric */
@@ -3652,6 +3992,7 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 	zbx_uint32_t			rtc_msgs[] = {ZBX_RTC_ESCALATOR_NOTIFY};
 	zbx_ipc_async_socket_t		rtc;
 	zbx_ipc_socket_t		alerter;
+	zbx_escalation_schedule_t	schedule;
 	char				*error = NULL;
 
 	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(info->program_type),
@@ -3678,6 +4019,8 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 	zbx_rtc_subscribe(process_type, process_num, rtc_msgs, ARRSIZE(rtc_msgs), escalator_args_in->config_timeout,
 			&rtc);
 
+	escalation_schedule_init(&schedule);
+
 	while (ZBX_IS_RUNNING())
 	{
 		int			now, nextcheck, ret;
@@ -3685,14 +4028,10 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 		zbx_config_t		cfg;
 		zbx_uint32_t		rtc_cmd;
 		time_t			wait_start_time;
-		zbx_vector_uint64_t	escalationids, triggerids;
 
 #		define STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not */
 						/* faster than once in STAT_INTERVAL seconds */
 
-		zbx_vector_uint64_create(&escalationids);
-		zbx_vector_uint64_create(&triggerids);
-
 		sec = zbx_time();
 		zbx_update_env(get_process_type_string(process_type), sec);
 
@@ -3713,12 +4052,12 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 
 			ptr += zbx_deserialize_value(ptr, &notify_size);
 
+			/* new and recovered trigger escalations must be checked right away */
 			for (zbx_uint32_t i = 0; i < notify_size; i++)
 			{
 				ptr += zbx_deserialize_value(ptr, &escalationid);
-				zbx_vector_uint64_append(&escalationids, escalationid);
 				ptr += zbx_deserialize_value(ptr, &triggerid);
-				zbx_vector_uint64_append(&triggerids, triggerid);
+				escalation_schedule_set(&schedule, escalationid, 0);
 			}
 
 			zbx_free(rtc_data);
@@ -3729,26 +4068,22 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 				cfg.default_timezone, process_num, escalator_args_in->config_timeout,
 				escalator_args_in->config_trapper_timeout, escalator_args_in->config_source_ip,
 				escalator_args_in->config_ssh_key_location, escalator_args_in->get_process_forks_cb_arg,
-				escalator_args_in->config_enable_global_scripts, info->program_type, &escalationids,
-				&triggerids);
+				escalator_args_in->config_enable_global_scripts, info->program_type, &schedule);
 		escalations_count += process_escalations(time(NULL), &nextcheck, ZBX_ESCALATION_SOURCE_ITEM,
 				cfg.default_timezone, process_num, escalator_args_in->config_timeout,
 				escalator_args_in->config_trapper_timeout, escalator_args_in->config_source_ip,
 				escalator_args_in->config_ssh_key_location, escalator_args_in->get_process_forks_cb_arg,
-				escalator_args_in->config_enable_global_scripts, info->program_type, NULL, NULL);
+				escalator_args_in->config_enable_global_scripts, info->program_type, NULL);
 		escalations_count += process_escalations(time(NULL), &nextcheck, ZBX_ESCALATION_SOURCE_SERVICE,
 				cfg.default_timezone, process_num, escalator_args_in->config_timeout,
 				escalator_args_in->config_trapper_timeout, escalator_args_in->config_source_ip,
 				escalator_args_in->config_ssh_key_location, escalator_args_in->get_process_forks_cb_arg,
-				escalator_args_in->config_enable_global_scripts, info->program_type, NULL, NULL);
+				escalator_args_in->config_enable_global_scripts, info->program_type, NULL);
 		escalations_count += process_escalations(time(NULL), &nextcheck, ZBX_ESCALATION_SOURCE_DEFAULT,
 				cfg.default_timezone, process_num, escalator_args_in->config_timeout,
 				escalator_args_in->config_trapper_timeout, escalator_args_in->config_source_ip,
 				escalator_args_in->config_ssh_key_location, escalator_args_in->get_process_forks_cb_arg,
-				escalator_args_in->config_enable_global_scripts, info->program_type, NULL, NULL);
-
-		zbx_vector_uint64_destroy(&escalationids);
-		zbx_vector_uint64_destroy(&triggerids);
+				escalator_args_in->config_enable_global_scripts, info->program_type, NULL);
 
 		if (0 != notify)
 			(void)zbx_ipc_socket_write(&alerter, ZBX_IPC_ALERTER_SYNC_ALERTS, NULL, 0);
@@ -3814,6 +4149,7 @@ ZBX_THREAD_ENTRY(escalator_thread, args)
 #		undef STAT_INTERVAL
 	}
 end_loop:
+	escalation_schedule_destroy(&schedule);
 	zbx_ipc_socket_close(&alerter);
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
 
@@ -13,6 +13,7 @@
 **/
 
 #include "events.h"
+#include "problem_index.h"
 
 #include "../db_lengths_constants.h"
 #include "../actions/actions.h"
@@ -47,16 +48,6 @@ typedef struct
 }
 zbx_event_recovery_t;
 
-/* problem event, used to cache open problems for recovery attempts */
-typedef struct
-{
-	zbx_uint64_t		eventid;
-	zbx_uint64_t		triggerid;
-
-	zbx_vector_tags_ptr_t	tags;
-}
-zbx_event_problem_t;
-
 typedef enum
 {
 	CORRELATION_MATCH = 0,
@@ -661,35 +652,15 @@ static zbx_db_event	*get_event_by_source_object_id(int source, int object, zbx_u
  ******************************************************************************/
 static int	correlation_match_event_hostgroup(const zbx_db_event *event, zbx_uint64_t groupid)
 {
-	zbx_db_result_t		result;
-	int			ret = FAIL;
-	zbx_vector_uint64_t	groupids;
-	char			*sql = NULL;
-	size_t			sql_alloc = 0, sql_offset = 0;
-
-	zbx_vector_uint64_create(&groupids);
-	zbx_dc_get_nested_hostgroupids(&groupid, 1, &groupids);
-
-	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
-			"select hg.groupid"
-				" from hstgrp g,hosts_groups hg,items i,functions f"
-				" where f.triggerid=" ZBX_FS_UI64
-				" and i.itemid=f.itemid"
-				" and hg.hostid=i.hostid"
-				" and",
-				event->objectid);
+	int			ret;
+	zbx_vector_uint64_t	functionids;
 
-	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "hg.groupid", groupids.values,
-			groupids.values_num);
+	zbx_vector_uint64_create(&functionids);
 
-	result = zbx_db_select("%s", sql);
+	zbx_db_trigger_get_all_functionids(&event->trigger, &functionids);
+	ret = zbx_dc_check_functions_hostgroup(&functionids, groupid);
 
-	if (NULL != zbx_db_fetch(result))
-		ret = SUCCEED;
-
-	zbx_db_free_result(result);
-	zbx_free(sql);
-	zbx_vector_uint64_destroy(&groupids);
+	zbx_vector_uint64_destroy(&functionids);
 
 	return ret;
 }
@@ -1079,6 +1050,228 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if the correlation condition matches the old event        *
+ *                                                                            *
+ * Parameters: condition - [IN] correlation condition to check                *
+ *             event     - [IN] new event                                     *
+ *             tags      - [IN] old event tags                                *
+ *             tags_num  - [IN] number of old event tags                      *
+ *                                                                            *
+ * Return value: "1" - correlation condition matches old event                *
+ *               "0" - otherwise                                              *
+ *                                                                            *
+ * Comments: Matching mirrors the sql filters created by                      *
+ *           correlation_condition_get_event_filter() function.               *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*correlation_condition_match_old_event(const zbx_corr_condition_t *condition,
+		const zbx_db_event *event, const zbx_tag_t *tags, int tags_num)
+{
+	const zbx_corr_condition_tag_value_t	*cond;
+	unsigned char				op;
+	int					negate = 0;
+
+	switch (condition->type)
+	{
+		case ZBX_CORR_CONDITION_OLD_EVENT_TAG:
+			for (int i = 0; i < tags_num; i++)
+			{
+				if (0 == strcmp(tags[i].tag, condition->data.tag.tag))
+					return "1";
+			}
+			break;
+
+		case ZBX_CORR_CONDITION_OLD_EVENT_TAG_VALUE:
+			cond = &condition->data.tag_value;
+
+			/* negative operators match events not having the tag with matching value */
+			switch (op = cond->op)
+			{
+				case ZBX_CONDITION_OPERATOR_NOT_EQUAL:
+					op = ZBX_CONDITION_OPERATOR_EQUAL;
+					negate = 1;
+					break;
+				case ZBX_CONDITION_OPERATOR_NOT_LIKE:
+					op = ZBX_CONDITION_OPERATOR_LIKE;
+					negate = 1;
+					break;
+			}
+
+			for (int i = 0; i < tags_num; i++)
+			{
+				if (0 == strcmp(tags[i].tag, cond->tag) &&
+						SUCCEED == zbx_strmatch_condition(tags[i].value, cond->value, op))
+				{
+					return (0 == negate ? "1" : "0");
+				}
+			}
+
+			return (0 == negate ? "0" : "1");
+
+		case ZBX_CORR_CONDITION_EVENT_TAG_PAIR:
+			for (int i = 0; i < tags_num; i++)
+			{
+				if (0 != strcmp(tags[i].tag, condition->data.tag_pair.oldtag))
+					continue;
+
+				for (int j = 0; j < event->tags.values_num; j++)
+				{
+					const zbx_tag_t	*tag = event->tags.values[j];
+
+					if (0 == strcmp(tag->tag, condition->data.tag_pair.newtag) &&
+							0 == strcmp(tag->value, tags[i].value))
+					{
+						return "1";
+					}
+				}
+			}
+			break;
+	}
+
+	return "0";
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares correlation rule expression to match old events          *
+ *                                                                            *
+ * Parameters: correlation - [IN] correlation rule                            *
+ *             event       - [IN] new event                                   *
+ *             tags        - [OUT] names of old event tags used by conditions *
+ *                                                                            *
+ * Return value: the correlation formula with new event conditions replaced   *
+ *               by their values or NULL if the formula references unknown    *
+ *               condition                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static char	*correlation_get_old_event_expression(const zbx_correlation_t *correlation,
+		const zbx_db_event *event, zbx_vector_str_t *tags)
+{
+	char			*expression;
+	zbx_token_t		token;
+	int			pos = 0;
+	zbx_uint64_t		conditionid;
+	zbx_strloc_t		*loc;
+	zbx_corr_condition_t	*condition;
+
+	expression = zbx_strdup(NULL, correlation->formula);
+
+	for (; SUCCEED == zbx_token_find(expression, pos, &token, ZBX_TOKEN_SEARCH_BASIC); pos++)
+	{
+		if (ZBX_TOKEN_OBJECTID != token.type)
+			continue;
+
+		loc = &token.data.objectid.name;
+
+		if (SUCCEED != zbx_is_uint64_n(expression + loc->l, loc->r - loc->l + 1, &conditionid))
+			continue;
+
+		if (NULL == (condition = (zbx_corr_condition_t *)zbx_hashset_search(&correlation_rules.conditions,
+				&conditionid)))
+		{
+			zbx_vector_str_clear(tags);
+			zbx_free(expression);
+			return NULL;
+		}
+
+		switch (condition->type)
+		{
+			case ZBX_CORR_CONDITION_NEW_EVENT_TAG:
+			case ZBX_CORR_CONDITION_NEW_EVENT_TAG_VALUE:
+			case ZBX_CORR_CONDITION_NEW_EVENT_HOSTGROUP:
+				zbx_replace_string(&expression, token.loc.l, &token.loc.r,
+						correlation_condition_match_new_event(condition, event, SUCCEED));
+				break;
+			case ZBX_CORR_CONDITION_OLD_EVENT_TAG:
+				zbx_vector_str_append(tags, condition->data.tag.tag);
+				break;
+			case ZBX_CORR_CONDITION_OLD_EVENT_TAG_VALUE:
+				zbx_vector_str_append(tags, condition->data.tag_value.tag);
+				break;
+			case ZBX_CORR_CONDITION_EVENT_TAG_PAIR:
+				zbx_vector_str_append(tags, condition->data.tag_pair.oldtag);
+				break;
+		}
+
+		pos = token.loc.r;
+	}
+
+	zbx_vector_str_sort(tags, ZBX_DEFAULT_STR_COMPARE_FUNC);
+	zbx_vector_str_uniq(tags, ZBX_DEFAULT_STR_COMPARE_FUNC);
+
+	return expression;
+}
+
+/* old event filter, used to match open problems in problem index */
+typedef struct
+{
+	const char		*expression;
+	const zbx_db_event	*event;
+}
+zbx_corr_old_event_filter_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if the old event matches correlation rule expression       *
+ *                                                                            *
+ * Parameters: tags     - [IN] old event tags                                 *
+ *             tags_num - [IN] number of old event tags                       *
+ *             data     - [IN] old event filter                               *
+ *                                                                            *
+ * Return value: SUCCEED - the old event matches correlation rule             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	correlation_match_old_event(const zbx_tag_t *tags, int tags_num, void *data)
+{
+	const zbx_corr_old_event_filter_t	*filter = (const zbx_corr_old_event_filter_t *)data;
+	char					*expression, error[256];
+	zbx_token_t				token;
+	int					pos = 0, ret = FAIL;
+	zbx_uint64_t				conditionid;
+	zbx_strloc_t				*loc;
+	const zbx_corr_condition_t		*condition;
+	double					result;
+
+	if ('\0' == *filter->expression)
+		return SUCCEED;
+
+	expression = zbx_strdup(NULL, filter->expression);
+
+	for (; SUCCEED == zbx_token_find(expression, pos, &token, ZBX_TOKEN_SEARCH_BASIC); pos++)
+	{
+		if (ZBX_TOKEN_OBJECTID != token.type)
+			continue;
+
+		loc = &token.data.objectid.name;
+
+		if (SUCCEED != zbx_is_uint64_n(expression + loc->l, loc->r - loc->l + 1, &conditionid))
+			continue;
+
+		if (NULL == (condition = (const zbx_corr_condition_t *)zbx_hashset_search(
+				&correlation_rules.conditions, &conditionid)))
+		{
+			goto out;
+		}
+
+		zbx_replace_string(&expression, token.loc.l, &token.loc.r,
+				correlation_condition_match_old_event(condition, filter->event, tags, tags_num));
+		pos = token.loc.r;
+	}
+
+	if (SUCCEED == zbx_evaluate(&result, expression, error, sizeof(error), NULL) &&
+			SUCCEED == zbx_double_compare(result, 1))
+	{
+		ret = SUCCEED;
+	}
+out:
+	zbx_free(expression);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: execute correlation operations for the new event and matched      *
@@ -1147,6 +1340,68 @@ static void	correlation_execute_operations(const zbx_correlation_t *correlation,
 #undef ZBX_CORR_OPERATION_CLOSE_OLD
 #undef ZBX_CORR_OPERATION_CLOSE_NEW
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds open problems matching correlation rules in problem index   *
+ *          and executes correlation operations                               *
+ *                                                                            *
+ * Parameters: event    - [IN/OUT] new event                                  *
+ *             corr_old - [IN] correlation rules depending on old events      *
+ *                                                                            *
+ * Return value: SUCCEED - the problems were matched using problem index      *
+ *               FAIL    - problem index is not available                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	correlate_event_by_problem_index(zbx_db_event *event, const zbx_vector_ptr_t *corr_old)
+{
+	int				ret = SUCCEED;
+	zbx_vector_str_t		tags;
+	zbx_vector_uint64_pair_t	matches;
+
+	zbx_vector_str_create(&tags);
+	zbx_vector_uint64_pair_create(&matches);
+
+	for (int i = 0; i < corr_old->values_num && SUCCEED == ret; i++)
+	{
+		const zbx_correlation_t		*correlation = (const zbx_correlation_t *)corr_old->values[i];
+		zbx_corr_old_event_filter_t	filter;
+		char				*expression;
+
+		if (NULL == (expression = correlation_get_old_event_expression(correlation, event, &tags)))
+			continue;
+
+		filter.expression = expression;
+		filter.event = event;
+
+		/* Old events without any of the tags used in conditions either all match or all don't match */
+		/* the rule. In the first case all open problems must be checked, otherwise only problems    */
+		/* having the used tags can match.                                                           */
+		if (SUCCEED == correlation_match_old_event(NULL, 0, &filter))
+			ret = zbx_problem_index_match(NULL, correlation_match_old_event, &filter, &matches);
+		else
+			ret = zbx_problem_index_match(&tags, correlation_match_old_event, &filter, &matches);
+
+		for (int j = 0; j < matches.values_num; j++)
+		{
+			/* check if this event is not already recovered by another correlation rule */
+			if (NULL != zbx_hashset_search(&correlation_cache, &matches.values[j].first))
+				continue;
+
+			correlation_execute_operations(correlation, event, matches.values[j].first,
+					matches.values[j].second);
+		}
+
+		zbx_vector_uint64_pair_clear(&matches);
+		zbx_vector_str_clear(&tags);
+		zbx_free(expression);
+	}
+
+	zbx_vector_uint64_pair_destroy(&matches);
+	zbx_vector_str_destroy(&tags);
+
+	return ret;
+}
+
 /* specifies correlation execution scope */
 typedef enum
 {
@@ -1181,8 +1436,9 @@ zbx_problem_state_t;
  *           The global event correlation matching is done in two parts:      *
  *             1) exclude correlations that can't possibly match the event    *
  *                based on new event tag/value/group conditions               *
- *             2) assemble sql statement to select problems/correlations      *
- *                based on the rest correlation conditions                    *
+ *             2) match open problems in problem index or assemble sql        *
+ *                statement to select problems/correlations based on the      *
+ *                rest correlation conditions                                 *
  *                                                                            *
  ******************************************************************************/
 static void	correlate_event_by_global_rules(zbx_db_event *event, zbx_problem_state_t *problem_state)
@@ -1227,16 +1483,27 @@ static void	correlate_event_by_global_rules(zbx_db_event *event, zbx_problem_sta
 			if (ZBX_PROBLEM_STATE_UNKNOWN == *problem_state)
 			{
 				zbx_db_result_t	result;
+				int		problems_num;
 
-				result = zbx_db_select_n("select eventid from problem"
-						" where r_eventid is null and source="
-						ZBX_STR(EVENT_SOURCE_TRIGGERS), 1);
-
-				if (NULL == zbx_db_fetch(result))
-					*problem_state = ZBX_PROBLEM_STATE_RESOLVED;
+				if (SUCCEED == zbx_problem_index_get_problems_num(&problems_num))
+				{
+					if (0 == problems_num)
+						*problem_state = ZBX_PROBLEM_STATE_RESOLVED;
+					else
+						*problem_state = ZBX_PROBLEM_STATE_OPEN;
+				}
 				else
-					*problem_state = ZBX_PROBLEM_STATE_OPEN;
-				zbx_db_free_result(result);
+				{
+					result = zbx_db_select_n("select eventid from problem"
+							" where r_eventid is null and source="
+							ZBX_STR(EVENT_SOURCE_TRIGGERS), 1);
+
+					if (NULL == zbx_db_fetch(result))
+						*problem_state = ZBX_PROBLEM_STATE_RESOLVED;
+					else
+						*problem_state = ZBX_PROBLEM_STATE_OPEN;
+					zbx_db_free_result(result);
+				}
 			}
 
 			if (ZBX_PROBLEM_STATE_RESOLVED == *problem_state)
@@ -1262,13 +1529,14 @@ static void	correlate_event_by_global_rules(zbx_db_event *event, zbx_problem_sta
 			correlation_execute_operations((zbx_correlation_t *)corr_new.values[i], event, 0, 0);
 	}
 
-	if (0 != corr_old.values_num)
+	/* Process correlations that matches new event and either uses old events in conditions */
+	/* or has operations involving old events. Open problems are matched in problem index,  */
+	/* falling back to problem table when the index is not available.                       */
+	if (0 != corr_old.values_num && SUCCEED != correlate_event_by_problem_index(event, &corr_old))
 	{
 		zbx_db_result_t	result;
 		zbx_db_row_t	row;
 
-		/* Process correlations that matches new event and either uses old events in conditions */
-		/* or has operations involving old events.                                              */
 
 		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "select p.eventid,p.objectid,c.correlationid"
 								" from correlation c,problem p"
@@ -2033,6 +2301,52 @@ void	zbx_events_update_itservices(void)
 	zbx_free(data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates problem index with created and recovered trigger problems *
+ *                                                                            *
+ * Comments: Must be called after events are committed to database and       *
+ *           before source triggers are unlocked.                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_events_update_problem_index(void)
+{
+	zbx_vector_db_event_t	problems;
+	zbx_vector_uint64_t	r_eventids;
+	zbx_hashset_iter_t	iter;
+	zbx_event_recovery_t	*recovery;
+
+	zbx_vector_db_event_create(&problems);
+	zbx_vector_uint64_create(&r_eventids);
+
+	for (int i = 0; i < events.values_num; i++)
+	{
+		zbx_db_event	*event = events.values[i];
+
+		if (EVENT_SOURCE_TRIGGERS != event->source || 0 == (event->flags & ZBX_FLAGS_DB_EVENT_CREATE))
+			continue;
+
+		if (EVENT_OBJECT_TRIGGER != event->object || TRIGGER_VALUE_PROBLEM != event->value)
+			continue;
+
+		zbx_vector_db_event_append(&problems, event);
+	}
+
+	zbx_hashset_iter_reset(&event_recovery, &iter);
+	while (NULL != (recovery = (zbx_event_recovery_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (EVENT_SOURCE_TRIGGERS != recovery->r_event->source)
+			continue;
+
+		zbx_vector_uint64_append(&r_eventids, recovery->eventid);
+	}
+
+	zbx_problem_index_update(&problems, &r_eventids);
+
+	zbx_vector_uint64_destroy(&r_eventids);
+	zbx_vector_db_event_destroy(&problems);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: adds event suppress data for problem events matching active       *
@@ -2397,6 +2711,12 @@ static void	get_open_problems(const zbx_vector_uint64_t *triggerids, zbx_vector_
 	int			index;
 	zbx_vector_uint64_t	eventids;
 
+	if (SUCCEED == zbx_problem_index_get_by_triggerids(triggerids, problems))
+	{
+		zbx_vector_ptr_sort(problems, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
+		return;
+	}
+
 	zbx_vector_uint64_create(&eventids);
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
@@ -2979,6 +3299,7 @@ int	zbx_close_problem(zbx_uint64_t triggerid, zbx_uint64_t eventid, zbx_uint64_t
 
 			zbx_dc_config_triggers_apply_changes(&trigger_diff);
 
+			zbx_events_update_problem_index();
 			zbx_events_update_itservices();
 
 			zbx_vector_connector_filter_create(&connector_filters_events);
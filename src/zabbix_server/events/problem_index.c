@@ -0,0 +1,921 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "problem_index.h"
+
+#include "zbxshmem.h"
+#include "zbxmutexs.h"
+#include "zbxdb.h"
+#include "zbxstr.h"
+#include "zbxnum.h"
+
+/*
+ * The problem index keeps open trigger problems in shared memory so that event recovery and
+ * global correlation can find matching problems without querying problem/problem_tag tables.
+ *
+ * The problems are indexed by:
+ *   1) event identifier - problems hashset
+ *   2) source trigger   - triggers hashset, referencing doubly linked list of trigger problems
+ *   3) tag name         - tags hashset, referencing doubly linked list of problem tag links
+ *
+ * The index is loaded from database during server startup before history syncers are started
+ * and is updated after committing transactions that create or recover trigger problems.
+ * Tags added to problems by webhook media types are added by alert syncer after committing
+ * them to database.
+ * Problems of deleted triggers are removed by trigger housekeeper after deleting them from
+ * database.
+ *
+ * When the cache runs out of memory the index is dropped and problems are again read from
+ * database until server is restarted.
+ */
+
+#define PI_STATE_EMPTY		0	/* index is not loaded */
+#define PI_STATE_READY		1	/* index is loaded and can be used */
+#define PI_STATE_DISABLED	2	/* index was dropped because of low memory */
+
+#define PI_PROBLEMS_INIT_SIZE	1000
+#define PI_TRIGGERS_INIT_SIZE	1000
+#define PI_TAGS_INIT_SIZE	100
+#define PI_STRPOOL_INIT_SIZE	1000
+
+#define REFCOUNT_FIELD_SIZE	sizeof(zbx_uint32_t)
+
+typedef struct zbx_pi_problem	zbx_pi_problem_t;
+
+/* link of problem tag in the tag name list */
+typedef struct zbx_pi_tag_link
+{
+	zbx_pi_problem_t	*problem;
+	struct zbx_pi_tag_link	*prev;
+	struct zbx_pi_tag_link	*next;
+}
+zbx_pi_tag_link_t;
+
+struct zbx_pi_problem
+{
+	zbx_uint64_t		eventid;
+	zbx_uint64_t		triggerid;
+	zbx_tag_t		*tags;		/* tag names and values are stored in string pool */
+	zbx_pi_tag_link_t	*links;		/* tag name list links, one per tag */
+	int			tags_num;
+	zbx_pi_problem_t	*prev;		/* previous problem of the same trigger */
+	zbx_pi_problem_t	*next;		/* next problem of the same trigger */
+};
+
+typedef struct
+{
+	zbx_uint64_t		triggerid;
+	zbx_pi_problem_t	*problems;
+}
+zbx_pi_trigger_t;
+
+typedef struct
+{
+	const char		*name;
+	zbx_pi_tag_link_t	*links;
+}
+zbx_pi_tag_t;
+
+typedef struct
+{
+	zbx_hashset_t	problems;
+	zbx_hashset_t	triggers;
+	zbx_hashset_t	tags;
+	zbx_hashset_t	strpool;
+	int		state;
+}
+zbx_pi_cache_t;
+
+static zbx_pi_cache_t	*pi_cache = NULL;
+static zbx_shmem_info_t	*pi_mem = NULL;
+static zbx_rwlock_t	pi_lock = ZBX_RWLOCK_NULL;
+
+ZBX_SHMEM_FUNC_IMPL(__pi, pi_mem)
+
+#define	RDLOCK_CACHE	zbx_rwlock_rdlock(pi_lock)
+#define	WRLOCK_CACHE	zbx_rwlock_wrlock(pi_lock)
+#define	UNLOCK_CACHE	zbx_rwlock_unlock(pi_lock)
+
+static zbx_hash_t	pi_strpool_hash_func(const void *data)
+{
+	return ZBX_DEFAULT_STRING_HASH_FUNC((const char *)data + REFCOUNT_FIELD_SIZE);
+}
+
+static int	pi_strpool_compare_func(const void *d1, const void *d2)
+{
+	return strcmp((const char *)d1 + REFCOUNT_FIELD_SIZE, (const char *)d2 + REFCOUNT_FIELD_SIZE);
+}
+
+static zbx_hash_t	pi_tag_hash_func(const void *data)
+{
+	const zbx_pi_tag_t	*tag = (const zbx_pi_tag_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(tag->name);
+}
+
+static int	pi_tag_compare_func(const void *d1, const void *d2)
+{
+	const zbx_pi_tag_t	*tag1 = (const zbx_pi_tag_t *)d1;
+	const zbx_pi_tag_t	*tag2 = (const zbx_pi_tag_t *)d2;
+
+	return strcmp(tag1->name, tag2->name);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies string to the cache string pool                            *
+ *                                                                            *
+ * Return value: The pointer to the copied string or NULL if there was not    *
+ *               enough space in cache.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static char	*pi_strpool_acquire(const char *str)
+{
+	void	*ptr;
+	size_t	len;
+
+	len = strlen(str) + 1;
+
+	if (NULL == (ptr = zbx_hashset_insert_ext(&pi_cache->strpool, str - REFCOUNT_FIELD_SIZE,
+			REFCOUNT_FIELD_SIZE + len, REFCOUNT_FIELD_SIZE, REFCOUNT_FIELD_SIZE + len,
+			ZBX_HASHSET_UNIQ_FALSE)))
+	{
+		return NULL;
+	}
+
+	(*(zbx_uint32_t *)ptr)++;
+
+	return (char *)ptr + REFCOUNT_FIELD_SIZE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: releases string from the cache string pool                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	pi_strpool_release(char *str)
+{
+	void	*ptr;
+
+	if (NULL == str)
+		return;
+
+	ptr = str - REFCOUNT_FIELD_SIZE;
+
+	if (0 == --(*(zbx_uint32_t *)ptr))
+		zbx_hashset_remove_direct(&pi_cache->strpool, ptr);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes all problems from index                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	pi_clear(void)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_pi_problem_t	*problem;
+
+	zbx_hashset_iter_reset(&pi_cache->problems, &iter);
+	while (NULL != (problem = (zbx_pi_problem_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL != problem->tags)
+			__pi_shmem_free_func(problem->tags);
+
+		if (NULL != problem->links)
+			__pi_shmem_free_func(problem->links);
+	}
+
+	zbx_hashset_clear(&pi_cache->problems);
+	zbx_hashset_clear(&pi_cache->triggers);
+	zbx_hashset_clear(&pi_cache->tags);
+	zbx_hashset_clear(&pi_cache->strpool);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: drops index when cache runs out of memory                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	pi_disable(void)
+{
+	pi_clear();
+	pi_cache->state = PI_STATE_DISABLED;
+
+	zabbix_log(LOG_LEVEL_WARNING, "problem cache is out of memory, open problems will be read from"
+			" database until server is restarted; consider increasing ProblemCacheSize configuration"
+			" parameter");
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: moves problem tag name list link to new location                  *
+ *                                                                            *
+ * Parameters: link     - [IN] new link location                              *
+ *             link_old - [IN] old link location                              *
+ *             name     - [IN] tag name                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	pi_tag_link_move(zbx_pi_tag_link_t *link, const zbx_pi_tag_link_t *link_old, const char *name)
+{
+	*link = *link_old;
+
+	if (NULL != link->next)
+		link->next->prev = link;
+
+	if (NULL != link->prev)
+	{
+		link->prev->next = link;
+	}
+	else
+	{
+		zbx_pi_tag_t	tag_local, *pi_tag;
+
+		tag_local.name = name;
+
+		if (NULL != (pi_tag = (zbx_pi_tag_t *)zbx_hashset_search(&pi_cache->tags, &tag_local)))
+			pi_tag->links = link;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds tags to indexed problem                                      *
+ *                                                                            *
+ * Parameters: problem - [IN] indexed problem                                 *
+ *             tags    - [IN] tags to add                                     *
+ *                                                                            *
+ * Return value: SUCCEED - the tags were added                                *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	pi_problem_add_tags(zbx_pi_problem_t *problem, const zbx_vector_tags_ptr_t *tags)
+{
+	zbx_tag_t		*problem_tags;
+	zbx_pi_tag_link_t	*links;
+	int			tags_num;
+
+	if (0 == tags->values_num)
+		return SUCCEED;
+
+	tags_num = problem->tags_num + tags->values_num;
+
+	if (NULL == (problem_tags = (zbx_tag_t *)__pi_shmem_malloc_func(NULL, sizeof(zbx_tag_t) * (size_t)tags_num)))
+		return FAIL;
+
+	if (NULL == (links = (zbx_pi_tag_link_t *)__pi_shmem_malloc_func(NULL,
+			sizeof(zbx_pi_tag_link_t) * (size_t)tags_num)))
+	{
+		__pi_shmem_free_func(problem_tags);
+		return FAIL;
+	}
+
+	/* tag name lists reference problem tag links, so existing links must be moved to the new array */
+	for (int i = 0; i < problem->tags_num; i++)
+	{
+		problem_tags[i] = problem->tags[i];
+		pi_tag_link_move(&links[i], &problem->links[i], problem->tags[i].tag);
+	}
+
+	if (NULL != problem->tags)
+		__pi_shmem_free_func(problem->tags);
+
+	if (NULL != problem->links)
+		__pi_shmem_free_func(problem->links);
+
+	problem->tags = problem_tags;
+	problem->links = links;
+
+	for (int i = 0; i < tags->values_num; i++)
+	{
+		zbx_tag_t		*tag = &problem->tags[problem->tags_num];
+		zbx_pi_tag_link_t	*link = &problem->links[problem->tags_num];
+		zbx_pi_tag_t		tag_local, *pi_tag;
+
+		if (NULL == (tag->tag = pi_strpool_acquire(tags->values[i]->tag)))
+			return FAIL;
+
+		if (NULL == (tag->value = pi_strpool_acquire(tags->values[i]->value)))
+		{
+			pi_strpool_release(tag->tag);
+			return FAIL;
+		}
+
+		problem->tags_num++;
+
+		tag_local.name = tag->tag;
+		tag_local.links = NULL;
+
+		if (NULL == (pi_tag = (zbx_pi_tag_t *)zbx_hashset_insert(&pi_cache->tags, &tag_local,
+				sizeof(tag_local))))
+		{
+			return FAIL;
+		}
+
+		link->problem = problem;
+		link->prev = NULL;
+
+		if (NULL != (link->next = pi_tag->links))
+			pi_tag->links->prev = link;
+
+		pi_tag->links = link;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds problem to index                                             *
+ *                                                                            *
+ * Parameters: eventid   - [IN] problem event identifier                      *
+ *             triggerid - [IN] source trigger identifier                     *
+ *             tags      - [IN] problem tags                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the problem was added or already was in index      *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	pi_problem_add(zbx_uint64_t eventid, zbx_uint64_t triggerid, const zbx_vector_tags_ptr_t *tags)
+{
+	zbx_pi_problem_t	problem_local, *problem;
+	zbx_pi_trigger_t	trigger_local, *trigger;
+
+	if (NULL != zbx_hashset_search(&pi_cache->problems, &eventid))
+		return SUCCEED;
+
+	memset(&problem_local, 0, sizeof(problem_local));
+	problem_local.eventid = eventid;
+	problem_local.triggerid = triggerid;
+
+	if (NULL == (problem = (zbx_pi_problem_t *)zbx_hashset_insert(&pi_cache->problems, &problem_local,
+			sizeof(problem_local))))
+	{
+		return FAIL;
+	}
+
+	trigger_local.triggerid = triggerid;
+	trigger_local.problems = NULL;
+
+	if (NULL == (trigger = (zbx_pi_trigger_t *)zbx_hashset_insert(&pi_cache->triggers, &trigger_local,
+			sizeof(trigger_local))))
+	{
+		return FAIL;
+	}
+
+	if (NULL != (problem->next = trigger->problems))
+		trigger->problems->prev = problem;
+
+	trigger->problems = problem;
+
+	return pi_problem_add_tags(problem, tags);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes problem from index                                        *
+ *                                                                            *
+ * Parameters: eventid - [IN] problem event identifier                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	pi_problem_remove(zbx_uint64_t eventid)
+{
+	zbx_pi_problem_t	*problem;
+
+	if (NULL == (problem = (zbx_pi_problem_t *)zbx_hashset_search(&pi_cache->problems, &eventid)))
+		return;
+
+	if (NULL != problem->next)
+		problem->next->prev = problem->prev;
+
+	if (NULL != problem->prev)
+	{
+		problem->prev->next = problem->next;
+	}
+	else
+	{
+		zbx_pi_trigger_t	*trigger;
+
+		if (NULL != (trigger = (zbx_pi_trigger_t *)zbx_hashset_search(&pi_cache->triggers,
+				&problem->triggerid)))
+		{
+			if (NULL == (trigger->problems = problem->next))
+				zbx_hashset_remove_direct(&pi_cache->triggers, trigger);
+		}
+	}
+
+	for (int i = 0; i < problem->tags_num; i++)
+	{
+		zbx_pi_tag_link_t	*link = &problem->links[i];
+
+		if (NULL != link->next)
+			link->next->prev = link->prev;
+
+		if (NULL != link->prev)
+		{
+			link->prev->next = link->next;
+		}
+		else
+		{
+			zbx_pi_tag_t	tag_local, *pi_tag;
+
+			tag_local.name = problem->tags[i].tag;
+
+			if (NULL != (pi_tag = (zbx_pi_tag_t *)zbx_hashset_search(&pi_cache->tags, &tag_local)))
+			{
+				if (NULL == (pi_tag->links = link->next))
+					zbx_hashset_remove_direct(&pi_cache->tags, pi_tag);
+			}
+		}
+
+		pi_strpool_release(problem->tags[i].tag);
+		pi_strpool_release(problem->tags[i].value);
+	}
+
+	if (NULL != problem->tags)
+		__pi_shmem_free_func(problem->tags);
+
+	if (NULL != problem->links)
+		__pi_shmem_free_func(problem->links);
+
+	zbx_hashset_remove_direct(&pi_cache->problems, problem);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes problem index                                         *
+ *                                                                            *
+ * Parameters: problem_cache_size - [IN] cache size, 0 disables the index     *
+ *             error              - [OUT]                                     *
+ *                                                                            *
+ * Return value: SUCCEED - the index was initialized successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_problem_index_init(zbx_uint64_t problem_cache_size, char **error)
+{
+	int	ret = FAIL;
+
+	if (0 == problem_cache_size)
+		return SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (SUCCEED != zbx_rwlock_create(&pi_lock, ZBX_RWLOCK_PROBLEM_INDEX, error))
+		goto out;
+
+	if (SUCCEED != zbx_shmem_create(&pi_mem, problem_cache_size, "problem cache size", "ProblemCacheSize", 1,
+			error))
+	{
+		goto out;
+	}
+
+	if (NULL == (pi_cache = (zbx_pi_cache_t *)__pi_shmem_malloc_func(NULL, sizeof(zbx_pi_cache_t))))
+	{
+		*error = zbx_strdup(*error, "cannot allocate problem cache header");
+		goto out;
+	}
+
+	memset(pi_cache, 0, sizeof(zbx_pi_cache_t));
+
+	zbx_hashset_create_ext(&pi_cache->problems, PI_PROBLEMS_INIT_SIZE,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			__pi_shmem_malloc_func, __pi_shmem_realloc_func, __pi_shmem_free_func);
+
+	zbx_hashset_create_ext(&pi_cache->triggers, PI_TRIGGERS_INIT_SIZE,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			__pi_shmem_malloc_func, __pi_shmem_realloc_func, __pi_shmem_free_func);
+
+	zbx_hashset_create_ext(&pi_cache->tags, PI_TAGS_INIT_SIZE, pi_tag_hash_func, pi_tag_compare_func, NULL,
+			__pi_shmem_malloc_func, __pi_shmem_realloc_func, __pi_shmem_free_func);
+
+	zbx_hashset_create_ext(&pi_cache->strpool, PI_STRPOOL_INIT_SIZE, pi_strpool_hash_func,
+			pi_strpool_compare_func, NULL,
+			__pi_shmem_malloc_func, __pi_shmem_realloc_func, __pi_shmem_free_func);
+
+	if (NULL == pi_cache->problems.slots || NULL == pi_cache->triggers.slots || NULL == pi_cache->tags.slots ||
+			NULL == pi_cache->strpool.slots)
+	{
+		*error = zbx_strdup(*error, "cannot allocate problem cache data storage");
+		goto out;
+	}
+
+	pi_cache->state = PI_STATE_EMPTY;
+
+	ret = SUCCEED;
+out:
+	if (SUCCEED != ret)
+		pi_cache = NULL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: destroys problem index                                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_problem_index_destroy(void)
+{
+	if (NULL != pi_mem)
+	{
+		zbx_shmem_destroy(pi_mem);
+		pi_mem = NULL;
+		zbx_rwlock_destroy(&pi_lock);
+	}
+
+	pi_cache = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads open trigger problems from database                         *
+ *                                                                            *
+ * Comments: This function must be called before processes updating problem   *
+ *           table are started. Problem updates committed before the index    *
+ *           is loaded are ignored by zbx_problem_index_update(), the load    *
+ *           holds the cache lock until all open problems are read.           *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_problem_index_load(void)
+{
+	zbx_db_result_t		result;
+	zbx_db_row_t		row;
+	zbx_uint64_t		eventid, triggerid = 0, last_eventid = 0;
+	zbx_vector_tags_ptr_t	tags;
+	int			ret = SUCCEED;
+
+	if (NULL == pi_cache)
+		return;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_vector_tags_ptr_create(&tags);
+
+	WRLOCK_CACHE;
+
+	if (PI_STATE_EMPTY != pi_cache->state)
+		goto out;
+
+	result = zbx_db_select(
+			"select p.eventid,p.objectid,pt.tag,pt.value"
+			" from problem p"
+			" left join problem_tag pt"
+				" on p.eventid=pt.eventid"
+			" where p.source=%d"
+				" and p.object=%d"
+				" and p.r_eventid is null"
+			" order by p.eventid",
+			EVENT_SOURCE_TRIGGERS, EVENT_OBJECT_TRIGGER);
+
+	if (NULL == result)
+	{
+		ret = FAIL;
+		goto out;
+	}
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		ZBX_STR2UINT64(eventid, row[0]);
+
+		if (eventid != last_eventid)
+		{
+			if (0 != last_eventid && SUCCEED != (ret = pi_problem_add(last_eventid, triggerid, &tags)))
+				break;
+
+			zbx_vector_tags_ptr_clear_ext(&tags, zbx_free_tag);
+			last_eventid = eventid;
+			ZBX_STR2UINT64(triggerid, row[1]);
+		}
+
+		if (SUCCEED != zbx_db_is_null(row[2]))
+		{
+			zbx_tag_t	*tag;
+
+			tag = (zbx_tag_t *)zbx_malloc(NULL, sizeof(zbx_tag_t));
+			tag->tag = zbx_strdup(NULL, row[2]);
+			tag->value = zbx_strdup(NULL, row[3]);
+			zbx_vector_tags_ptr_append(&tags, tag);
+		}
+	}
+	zbx_db_free_result(result);
+
+	if (SUCCEED == ret && 0 != last_eventid)
+		ret = pi_problem_add(last_eventid, triggerid, &tags);
+
+	if (SUCCEED != ret)
+	{
+		pi_disable();
+		goto out;
+	}
+
+	pi_cache->state = PI_STATE_READY;
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "loaded %d open problems into problem cache",
+			pi_cache->problems.num_data);
+out:
+	UNLOCK_CACHE;
+
+	zbx_vector_tags_ptr_clear_ext(&tags, zbx_free_tag);
+	zbx_vector_tags_ptr_destroy(&tags);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: applies committed problem changes to index                        *
+ *                                                                            *
+ * Parameters: problems   - [IN] created trigger problem events               *
+ *             r_eventids - [IN] recovered problem event identifiers          *
+ *                                                                            *
+ * Comments: This function must be called after the transaction creating or   *
+ *           recovering problems is committed and before the source triggers  *
+ *           are unlocked.                                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_problem_index_update(const zbx_vector_db_event_t *problems, const zbx_vector_uint64_t *r_eventids)
+{
+	if (NULL == pi_cache || (0 == problems->values_num && 0 == r_eventids->values_num))
+		return;
+
+	WRLOCK_CACHE;
+
+	if (PI_STATE_READY == pi_cache->state)
+	{
+		int	i;
+
+		for (i = 0; i < problems->values_num; i++)
+		{
+			const zbx_db_event	*event = problems->values[i];
+
+			if (SUCCEED != pi_problem_add(event->eventid, event->objectid, &event->tags))
+			{
+				pi_disable();
+				goto out;
+			}
+		}
+
+		/* problems can be created and recovered in the same transaction, so remove them last */
+		for (i = 0; i < r_eventids->values_num; i++)
+			pi_problem_remove(r_eventids->values[i]);
+	}
+out:
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes deleted problems from index                               *
+ *                                                                            *
+ * Parameters: eventids - [IN] deleted problem event identifiers              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_problem_index_remove(const zbx_vector_uint64_t *eventids)
+{
+	if (NULL == pi_cache || 0 == eventids->values_num)
+		return;
+
+	WRLOCK_CACHE;
+
+	if (PI_STATE_READY == pi_cache->state)
+	{
+		for (int i = 0; i < eventids->values_num; i++)
+			pi_problem_remove(eventids->values[i]);
+	}
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds tags to indexed problem                                      *
+ *                                                                            *
+ * Parameters: eventid - [IN] problem event identifier                        *
+ *             tags    - [IN] tags added to problem                           *
+ *                                                                            *
+ * Comments: This function must be called after the transaction adding        *
+ *           problem tags is committed.                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_problem_index_add_tags(zbx_uint64_t eventid, const zbx_vector_tags_ptr_t *tags)
+{
+	zbx_pi_problem_t	*problem;
+
+	if (NULL == pi_cache || 0 == tags->values_num)
+		return;
+
+	WRLOCK_CACHE;
+
+	if (PI_STATE_READY == pi_cache->state &&
+			NULL != (problem = (zbx_pi_problem_t *)zbx_hashset_search(&pi_cache->problems, &eventid)) &&
+			SUCCEED != pi_problem_add_tags(problem, tags))
+	{
+		pi_disable();
+	}
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets number of open trigger problems                              *
+ *                                                                            *
+ * Parameters: problems_num - [OUT]                                           *
+ *                                                                            *
+ * Return value: SUCCEED - the number of problems was returned                *
+ *               FAIL    - problem index is not available                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_problem_index_get_problems_num(int *problems_num)
+{
+	int	ret = FAIL;
+
+	if (NULL == pi_cache)
+		return FAIL;
+
+	RDLOCK_CACHE;
+
+	if (PI_STATE_READY == pi_cache->state)
+	{
+		*problems_num = pi_cache->problems.num_data;
+		ret = SUCCEED;
+	}
+
+	UNLOCK_CACHE;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets open problems created by the specified triggers              *
+ *                                                                            *
+ * Parameters: triggerids - [IN] trigger identifiers                          *
+ *             problems   - [OUT] open problems (zbx_event_problem_t)         *
+ *                                                                            *
+ * Return value: SUCCEED - the problems were returned                         *
+ *               FAIL    - problem index is not available                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_problem_index_get_by_triggerids(const zbx_vector_uint64_t *triggerids, zbx_vector_ptr_t *problems)
+{
+	int	ret = FAIL;
+
+	if (NULL == pi_cache)
+		return FAIL;
+
+	RDLOCK_CACHE;
+
+	if (PI_STATE_READY != pi_cache->state)
+		goto out;
+
+	for (int i = 0; i < triggerids->values_num; i++)
+	{
+		const zbx_pi_trigger_t	*trigger;
+		const zbx_pi_problem_t	*pi_problem;
+
+		if (NULL == (trigger = (const zbx_pi_trigger_t *)zbx_hashset_search(&pi_cache->triggers,
+				&triggerids->values[i])))
+		{
+			continue;
+		}
+
+		for (pi_problem = trigger->problems; NULL != pi_problem; pi_problem = pi_problem->next)
+		{
+			zbx_event_problem_t	*problem;
+
+			problem = (zbx_event_problem_t *)zbx_malloc(NULL, sizeof(zbx_event_problem_t));
+			problem->eventid = pi_problem->eventid;
+			problem->triggerid = pi_problem->triggerid;
+			zbx_vector_tags_ptr_create(&problem->tags);
+
+			if (0 != pi_problem->tags_num)
+				zbx_vector_tags_ptr_reserve(&problem->tags, (size_t)pi_problem->tags_num);
+
+			for (int j = 0; j < pi_problem->tags_num; j++)
+			{
+				zbx_tag_t	*tag;
+
+				tag = (zbx_tag_t *)zbx_malloc(NULL, sizeof(zbx_tag_t));
+				tag->tag = zbx_strdup(NULL, pi_problem->tags[j].tag);
+				tag->value = zbx_strdup(NULL, pi_problem->tags[j].value);
+				zbx_vector_tags_ptr_append(&problem->tags, tag);
+			}
+
+			zbx_vector_ptr_append(problems, problem);
+		}
+	}
+
+	ret = SUCCEED;
+out:
+	UNLOCK_CACHE;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: finds open problems matching the specified filter                 *
+ *                                                                            *
+ * Parameters: tags     - [IN] tag names, only problems having at least one   *
+ *                             of the tags are checked. NULL to check all     *
+ *                             open problems.                                 *
+ *             match_cb - [IN] callback to check if problem matches filter    *
+ *             data     - [IN] callback data                                  *
+ *             matches  - [OUT] matching problem event identifier (first) and *
+ *                              source trigger identifier (second) pairs      *
+ *                                                                            *
+ * Return value: SUCCEED - the index was searched                             *
+ *               FAIL    - problem index is not available                     *
+ *                                                                            *
+ * Comments: The callback is executed while cache is locked, it must not      *
+ *           access other caches or database.                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_problem_index_match(const zbx_vector_str_t *tags, zbx_problem_index_match_func_t match_cb, void *data,
+		zbx_vector_uint64_pair_t *matches)
+{
+	int			ret = FAIL;
+	zbx_hashset_t		checked;
+	zbx_uint64_pair_t	pair;
+	zbx_pi_problem_t	*problem;
+
+	if (NULL == pi_cache)
+		return FAIL;
+
+	zbx_hashset_create(&checked, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	RDLOCK_CACHE;
+
+	if (PI_STATE_READY != pi_cache->state)
+		goto out;
+
+	if (NULL == tags)
+	{
+		zbx_hashset_iter_t	iter;
+
+		zbx_hashset_iter_reset(&pi_cache->problems, &iter);
+		while (NULL != (problem = (zbx_pi_problem_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (SUCCEED != match_cb(problem->tags, problem->tags_num, data))
+				continue;
+
+			pair.first = problem->eventid;
+			pair.second = problem->triggerid;
+			zbx_vector_uint64_pair_append(matches, pair);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < tags->values_num; i++)
+		{
+			zbx_pi_tag_t		tag_local, *pi_tag;
+			const zbx_pi_tag_link_t	*link;
+
+			tag_local.name = tags->values[i];
+
+			if (NULL == (pi_tag = (zbx_pi_tag_t *)zbx_hashset_search(&pi_cache->tags, &tag_local)))
+				continue;
+
+			for (link = pi_tag->links; NULL != link; link = link->next)
+			{
+				problem = link->problem;
+
+				/* problem can have several tags with the same name or match several tag names */
+				if (NULL != zbx_hashset_search(&checked, &problem->eventid))
+					continue;
+
+				zbx_hashset_insert(&checked, &problem->eventid, sizeof(problem->eventid));
+
+				if (SUCCEED != match_cb(problem->tags, problem->tags_num, data))
+					continue;
+
+				pair.first = problem->eventid;
+				pair.second = problem->triggerid;
+				zbx_vector_uint64_pair_append(matches, pair);
+			}
+		}
+	}
+
+	ret = SUCCEED;
+out:
+	UNLOCK_CACHE;
+
+	zbx_hashset_destroy(&checked);
+
+	return ret;
+}
@@ -0,0 +1,47 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_PROBLEM_INDEX_H
+#define ZABBIX_PROBLEM_INDEX_H
+
+#include "zbxdbhigh.h"
+#include "zbxalgo.h"
+
+/* problem event, used to cache open problems for recovery attempts */
+typedef struct
+{
+	zbx_uint64_t		eventid;
+	zbx_uint64_t		triggerid;
+
+	zbx_vector_tags_ptr_t	tags;
+}
+zbx_event_problem_t;
+
+/* returns SUCCEED if open problem with the specified tags matches the filter */
+typedef int	(*zbx_problem_index_match_func_t)(const zbx_tag_t *tags, int tags_num, void *data);
+
+int	zbx_problem_index_init(zbx_uint64_t problem_cache_size, char **error);
+void	zbx_problem_index_destroy(void);
+void	zbx_problem_index_load(void);
+
+void	zbx_problem_index_update(const zbx_vector_db_event_t *problems, const zbx_vector_uint64_t *r_eventids);
+void	zbx_problem_index_remove(const zbx_vector_uint64_t *eventids);
+void	zbx_problem_index_add_tags(zbx_uint64_t eventid, const zbx_vector_tags_ptr_t *tags);
+
+int	zbx_problem_index_get_problems_num(int *problems_num);
+int	zbx_problem_index_get_by_triggerids(const zbx_vector_uint64_t *triggerids, zbx_vector_ptr_t *problems);
+int	zbx_problem_index_match(const zbx_vector_str_t *tags, zbx_problem_index_match_func_t match_cb, void *data,
+		zbx_vector_uint64_pair_t *matches);
+
+#endif
@@ -15,6 +15,7 @@
 #include "housekeeper_server.h"
 
 #include "history_compress.h"
+#include "partition_housekeeper.h"
 
 #include "zbxtimekeeper.h"
 #include "zbxlog.h"
@@ -1149,26 +1150,39 @@ static int	housekeeping_sessions(int now, int config_max_hk_delete)
 	return deleted;
 }
 
-static int	housekeeping_services(int now, int config_max_hk_delete)
+static int	housekeeping_services(int now, int config_max_hk_delete, int *partitions)
 {
 	static zbx_hk_rule_t	rule = {"service_alarms", "servicealarmid", "", HK_MIN_CLOCK_UNDEFINED,
 			&cfg.hk.services_mode, &cfg.hk.services};
 
-	if (ZBX_HK_OPTION_ENABLED == cfg.hk.services_mode)
-		return housekeeping_process_rule(now, config_max_hk_delete, &rule);
+	if (ZBX_HK_OPTION_ENABLED != cfg.hk.services_mode)
+		return 0;
 
-	return 0;
+	if (SUCCEED == hk_partitions_is_managed(rule.table))
+	{
+		*partitions += hk_partitions_drop(rule.table, now - cfg.hk.services);
+		return 0;
+	}
+
+	return housekeeping_process_rule(now, config_max_hk_delete, &rule);
 }
 
-static int	housekeeping_audit(int now, int config_max_hk_delete)
+static int	housekeeping_audit(int now, int config_max_hk_delete, int *partitions)
 {
 	static zbx_hk_rule_t	rule = {"auditlog", "auditid", "", HK_MIN_CLOCK_UNDEFINED, &cfg.hk.audit_mode,
 			&cfg.hk.audit};
 
-	if (ZBX_HK_MODE_DISABLED != cfg.hk.audit_mode)
-		return housekeeping_process_rule(now, config_max_hk_delete, &rule);
+	if (ZBX_HK_MODE_DISABLED == cfg.hk.audit_mode)
+		return 0;
 
-	return 0;
+	/* TimescaleDB hypertable chunks are dropped by housekeeping_process_rule() in partition mode */
+	if (ZBX_HK_MODE_PARTITION != cfg.hk.audit_mode && SUCCEED == hk_partitions_is_managed(rule.table))
+	{
+		*partitions += hk_partitions_drop(rule.table, now - cfg.hk.audit);
+		return 0;
+	}
+
+	return housekeeping_process_rule(now, config_max_hk_delete, &rule);
 }
 
 static int	housekeeping_autoreg_host(int config_max_housekeeper_delete)
@@ -1243,7 +1257,80 @@ static int	housekeeping_autoreg_host(int config_max_housekeeper_delete)
 	return deleted;
 }
 
-static int	housekeeping_events(int now, int config_max_hk_delete)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets the oldest clock of rows selected by query                   *
+ *                                                                            *
+ * Return value: the oldest clock or 'limit' if there are no older rows       *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_min_clock_get(int limit, const char *fmt, ...)
+{
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+	va_list		args;
+	char		*sql;
+	int		min_clock = limit;
+
+	va_start(args, fmt);
+	sql = zbx_dvsprintf(NULL, fmt, args);
+	va_end(args);
+
+	result = zbx_db_select("%s", sql);
+
+	if (NULL != (row = zbx_db_fetch(result)) && SUCCEED != zbx_db_is_null(row[0]))
+		min_clock = MIN(limit, atoi(row[0]));
+
+	zbx_db_free_result(result);
+	zbx_free(sql);
+
+	return min_clock;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: drops expired partitions of partitioned events and alerts tables  *
+ *                                                                            *
+ * Parameters: now        - [IN] current timestamp                            *
+ *             partitions - [OUT] number of dropped partitions                *
+ *                                                                            *
+ * Return value: timestamp before which events are removed by dropping        *
+ *               partitions or 0 if events table is not partitioned           *
+ *                                                                            *
+ * Comments: Partition holds events of all sources, so only the longest       *
+ *           storage period can be applied. Partitions having events of       *
+ *           existing problems or causes of symptom events are kept, which    *
+ *           is what row-wise housekeeping does for single events.            *
+ *                                                                            *
+ ******************************************************************************/
+static int	housekeeping_events_partitions(int now, int *partitions)
+{
+	int	period, drop_before;
+
+	if (SUCCEED != hk_partitions_is_managed("events"))
+		return 0;
+
+	period = MAX(cfg.hk.events_trigger, cfg.hk.events_internal);
+	period = MAX(period, cfg.hk.events_discovery);
+	period = MAX(period, cfg.hk.events_autoreg);
+	period = MAX(period, cfg.hk.events_service);
+
+	drop_before = hk_min_clock_get(now - period, "select min(clock) from problem");
+	drop_before = hk_min_clock_get(drop_before,
+			"select min(e.clock)"
+			" from event_symptom es"
+				" join events e on es.cause_eventid=e.eventid");
+
+	*partitions += hk_partitions_drop("events", drop_before);
+
+	/* alerts are removed together with their events */
+	if (SUCCEED == hk_partitions_is_managed("alerts"))
+		*partitions += hk_partitions_drop("alerts", drop_before);
+
+	return drop_before;
+}
+
+static int	housekeeping_events(int now, int config_max_hk_delete, int *partitions)
 {
 #define ZBX_HK_EVENT_RULE		" and not exists(" \
 						"select null" \
@@ -1290,21 +1377,30 @@ static int	housekeeping_events(int now, int config_max_hk_delete)
 		{0}
 	};
 
-	int		deleted = 0;
+	int		deleted = 0, dropped_before;
 	zbx_hk_rule_t	*rule;
 
 	if (ZBX_HK_OPTION_ENABLED != cfg.hk.events_mode)
 		return 0;
 
+	dropped_before = housekeeping_events_partitions(now, partitions);
+
 	for (rule = rules; NULL != rule->table; rule++)
+	{
+		/* Skip the rule only if dropping partitions removed all its expired events. Partitions */
+		/* can be kept by old open problems, then the rest is removed row by row.               */
+		if (0 != dropped_before && now - *rule->phistory <= dropped_before)
+			continue;
+
 		deleted += housekeeping_process_rule(now, config_max_hk_delete, rule);
+	}
 
 	return deleted;
 #undef ZBX_HK_EVENT_RULE
 #undef ZBX_HK_TRIGGER_EVENT_RULE
 }
 
-static int	housekeeping_problems(int now, int config_max_hk_delete)
+static int	housekeeping_problems(int now, int config_max_hk_delete, int *partitions)
 {
 	int			deleted = 0;
 	zbx_vector_uint64_t	ids_uint64;
@@ -1313,6 +1409,25 @@ static int	housekeeping_problems(int now, int config_max_hk_delete)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() now:%d", __func__, now);
 
+	/* drop partitions with resolved problems only, the rest is removed row by row */
+	if (SUCCEED == hk_partitions_is_managed("problem"))
+	{
+		int	drop_before;
+
+		drop_before = hk_min_clock_get(now - SEC_PER_DAY,
+				"select min(p1.clock)"
+				" from problem p1"
+				" where p1.r_clock=0"
+					" or p1.r_clock>=%d"
+					" or exists ("
+						"select null"
+						" from problem p2"
+						" where p1.eventid=p2.cause_eventid"
+					")", now - SEC_PER_DAY);
+
+		*partitions += hk_partitions_drop("problem", drop_before);
+	}
+
 	zbx_vector_uint64_create(&ids_uint64);
 
 	zbx_snprintf(buffer, sizeof(buffer),
@@ -1432,6 +1547,8 @@ ZBX_THREAD_ENTRY(housekeeper_thread, args)
 	}
 
 	hk_history_compression_init();
+	hk_partitions_init(housekeeper_args_in->config_housekeeping_partitions,
+			housekeeper_args_in->config_housekeeping_partitions_ahead);
 
 	zbx_rtc_subscribe(process_type, process_num, rtc_msgs, ARRSIZE(rtc_msgs), housekeeper_args_in->config_timeout,
 			&rtc);
@@ -1502,6 +1619,12 @@ ZBX_THREAD_ENTRY(housekeeper_thread, args)
 
 		zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_HOUSEKEEPER | ZBX_CONFIG_FLAGS_DB_EXTENSION);
 
+#if defined(HAVE_POSTGRESQL)
+		hk_partitions_update(tsdb_version);
+#else
+		hk_partitions_update(0);
+#endif
+
 		if (0 == strcmp(cfg.db.extension, ZBX_DB_EXTENSION_TIMESCALEDB))
 		{
 			zbx_setproctitle("%s [synchronizing history and trends compression settings]",
@@ -1512,22 +1635,26 @@ ZBX_THREAD_ENTRY(housekeeper_thread, args)
 		zbx_setproctitle("%s [removing old history and trends]",
 				get_process_type_string(process_type));
 		sec = zbx_time();
-		int	d_history_and_trends = housekeeping_history_and_trends(now);
+		int	d_history_and_trends = housekeeping_history_and_trends(now), d_partitions = 0;
 
 		zbx_setproctitle("%s [removing old problems]", get_process_type_string(process_type));
-		int	d_problems = housekeeping_problems(now, housekeeper_args_in->config_housekeeping_frequency);
+		int	d_problems = housekeeping_problems(now, housekeeper_args_in->config_housekeeping_frequency,
+				&d_partitions);
 
 		zbx_setproctitle("%s [removing old events]", get_process_type_string(process_type));
-		int	d_events = housekeeping_events(now, housekeeper_args_in->config_housekeeping_frequency);
+		int	d_events = housekeeping_events(now, housekeeper_args_in->config_housekeeping_frequency,
+				&d_partitions);
 
 		zbx_setproctitle("%s [removing old sessions]", get_process_type_string(process_type));
 		int	d_sessions = housekeeping_sessions(now, housekeeper_args_in->config_housekeeping_frequency);
 
 		zbx_setproctitle("%s [removing old service alarms]", get_process_type_string(process_type));
-		int	d_services = housekeeping_services(now, housekeeper_args_in->config_housekeeping_frequency);
+		int	d_services = housekeeping_services(now, housekeeper_args_in->config_housekeeping_frequency,
+				&d_partitions);
 
 		zbx_setproctitle("%s [removing old audit log items]", get_process_type_string(process_type));
-		int	d_audit = housekeeping_audit(now, housekeeper_args_in->config_housekeeping_frequency);
+		int	d_audit = housekeeping_audit(now, housekeeper_args_in->config_housekeeping_frequency,
+				&d_partitions);
 
 		zbx_setproctitle("%s [removing old autoreg_hosts]", get_process_type_string(process_type));
 		int	d_autoreg_host = housekeeping_autoreg_host(housekeeper_args_in->config_max_housekeeper_delete);
@@ -1537,13 +1664,17 @@ ZBX_THREAD_ENTRY(housekeeper_thread, args)
 
 		zbx_setproctitle("%s [removing deleted items data]", get_process_type_string(process_type));
 		int	d_cleanup = housekeeping_cleanup(housekeeper_args_in->config_housekeeping_frequency);
+
+		zbx_setproctitle("%s [creating partitions]", get_process_type_string(process_type));
+		hk_partitions_create_ahead(now);
 		sec = zbx_time() - sec;
 
 		zabbix_log(LOG_LEVEL_WARNING, "%s [deleted %d hist/trends, %d items/triggers, %d events, %d problems,"
-				" %d sessions, %d alarms, %d audit, %d autoreg_host, %d records in " ZBX_FS_DBL
-				" sec, %s]",
+				" %d sessions, %d alarms, %d audit, %d autoreg_host, %d records, dropped %d partitions"
+				" in " ZBX_FS_DBL " sec, %s]",
 				get_process_type_string(process_type), d_history_and_trends, d_cleanup, d_events,
-				d_problems, d_sessions, d_services, d_audit, d_autoreg_host, records, sec, sleeptext);
+				d_problems, d_sessions, d_services, d_audit, d_autoreg_host, records, d_partitions, sec,
+				sleeptext);
 
 		zbx_config_clean(&cfg);
 
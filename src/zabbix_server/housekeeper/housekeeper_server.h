@@ -23,6 +23,8 @@ typedef struct
 	int				config_timeout;
 	int				config_housekeeping_frequency;
 	int				config_max_housekeeper_delete;
+	int				config_housekeeping_partitions;
+	int				config_housekeeping_partitions_ahead;
 }
 zbx_thread_housekeeper_args;
 
@@ -0,0 +1,617 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "partition_housekeeper.h"
+
+#include "zbxcommon.h"
+
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+
+#include "zbxdb.h"
+#include "zbxdbhigh.h"
+#include "zbxalgo.h"
+#include "zbxnum.h"
+#include "zbxstr.h"
+
+#define HK_PARTITION_TYPE_NONE		0
+#define HK_PARTITION_TYPE_RANGE		1	/* native range partitioning by clock */
+#define HK_PARTITION_TYPE_HYPERTABLE	2	/* TimescaleDB hypertable */
+
+/* upper limit of created partitions per table and housekeeping cycle */
+#define HK_PARTITION_CREATE_MAX		100
+
+typedef struct
+{
+	const char	*table;
+	unsigned char	type;
+}
+zbx_hk_partition_table_t;
+
+/* tables whose row-wise housekeeping is replaced by dropping partitions when they are partitioned by clock */
+static zbx_hk_partition_table_t	partition_tables[] = {
+	{"events",		HK_PARTITION_TYPE_NONE},
+	{"problem",		HK_PARTITION_TYPE_NONE},
+	{"alerts",		HK_PARTITION_TYPE_NONE},
+	{"auditlog",		HK_PARTITION_TYPE_NONE},
+	{"service_alarms",	HK_PARTITION_TYPE_NONE},
+	{NULL}
+};
+
+typedef struct
+{
+	char	*name;
+	int	lower;	/* inclusive lower bound, INT_MIN if unbounded */
+	int	upper;	/* exclusive upper bound, INT_MAX if unbounded */
+}
+zbx_hk_partition_t;
+
+ZBX_PTR_VECTOR_DECL(hk_partition_ptr, zbx_hk_partition_t *)
+ZBX_PTR_VECTOR_IMPL(hk_partition_ptr, zbx_hk_partition_t *)
+
+static int	partitions_enabled = 0;
+static int	partitions_create_ahead = 0;
+
+static void	hk_partition_free(zbx_hk_partition_t *partition)
+{
+	zbx_free(partition->name);
+	zbx_free(partition);
+}
+
+static int	hk_partition_compare_by_upper(const void *d1, const void *d2)
+{
+	const zbx_hk_partition_t	*p1 = *(const zbx_hk_partition_t * const *)d1;
+	const zbx_hk_partition_t	*p2 = *(const zbx_hk_partition_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(p1->upper, p2->upper);
+
+	return 0;
+}
+
+static zbx_hk_partition_table_t	*hk_partition_table_get(const char *table)
+{
+	for (zbx_hk_partition_table_t *ptable = partition_tables; NULL != ptable->table; ptable++)
+	{
+		if (0 == strcmp(ptable->table, table))
+			return ptable;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks that partition name can be used in SQL without quoting     *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partition_name_validate(const char *name)
+{
+	for (const char *ptr = name; '\0' != *ptr; ptr++)
+	{
+		if (0 == isalnum((unsigned char)*ptr) && '_' != *ptr && '$' != *ptr)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "partition \"%s\" is not managed by housekeeper: unsupported"
+					" characters in its name", name);
+			return FAIL;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses partition bound value                                      *
+ *                                                                            *
+ * Parameters: str     - [IN] bound value, possibly quoted                    *
+ *             unbound - [IN] value to use for MINVALUE/MAXVALUE              *
+ *             value   - [OUT]                                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partition_bound_parse(const char *str, int unbound, int *value)
+{
+	char	buf[ZBX_MAX_UINT64_LEN + 2];
+	size_t	len;
+
+	if ('\'' == *str)
+		str++;
+
+	if (0 == strncmp(str, "MINVALUE", ZBX_CONST_STRLEN("MINVALUE")) ||
+			0 == strncmp(str, "MAXVALUE", ZBX_CONST_STRLEN("MAXVALUE")))
+	{
+		*value = unbound;
+		return SUCCEED;
+	}
+
+	for (len = 0; ('-' == str[len] && 0 == len) || 0 != isdigit((unsigned char)str[len]); len++)
+		;
+
+	if (0 == len || sizeof(buf) <= len)
+		return FAIL;
+
+	memcpy(buf, str, len);
+	buf[len] = '\0';
+
+	return zbx_is_int(buf, value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets range partitions of table sorted by their upper bound        *
+ *                                                                            *
+ * Comments: default partitions and partitions with unrecognized bounds are   *
+ *           skipped.                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_partitions_get(const char *table, zbx_vector_hk_partition_ptr_t *partitions)
+{
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+
+#if defined(HAVE_POSTGRESQL)
+	result = zbx_db_select(
+			"select c.relname,pg_get_expr(c.relpartbound,c.oid)"
+			" from pg_inherits i"
+				" join pg_class c on c.oid=i.inhrelid"
+				" join pg_class p on p.oid=i.inhparent"
+				" join pg_namespace n on n.oid=p.relnamespace"
+			" where p.relname='%s'"
+				" and n.nspname='%s'",
+			table, zbx_db_get_schema_esc());
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		const char		*from, *to;
+		int			lower, upper;
+		zbx_hk_partition_t	*partition;
+
+		/* bound expression is in format "FOR VALUES FROM (<lower>) TO (<upper>)" */
+		if (NULL == (from = strstr(row[1], "FROM (")) || NULL == (to = strstr(from, ") TO (")))
+			continue;
+
+		if (SUCCEED != hk_partition_bound_parse(from + ZBX_CONST_STRLEN("FROM ("), INT_MIN, &lower) ||
+				SUCCEED != hk_partition_bound_parse(to + ZBX_CONST_STRLEN(") TO ("), INT_MAX, &upper))
+		{
+			continue;
+		}
+
+		if (SUCCEED != hk_partition_name_validate(row[0]))
+			continue;
+
+		partition = (zbx_hk_partition_t *)zbx_malloc(NULL, sizeof(zbx_hk_partition_t));
+		partition->name = zbx_strdup(NULL, row[0]);
+		partition->lower = lower;
+		partition->upper = upper;
+		zbx_vector_hk_partition_ptr_append(partitions, partition);
+	}
+	zbx_db_free_result(result);
+#else
+	int	lower = INT_MIN;
+
+	result = zbx_db_select(
+			"select partition_name,partition_description"
+			" from information_schema.partitions"
+			" where table_schema=database()"
+				" and table_name='%s'"
+				" and partition_name is not null"
+			" order by partition_ordinal_position",
+			table);
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		int			upper;
+		zbx_hk_partition_t	*partition;
+
+		if (SUCCEED != hk_partition_bound_parse(row[1], INT_MAX, &upper) ||
+				SUCCEED != hk_partition_name_validate(row[0]))
+		{
+			lower = INT_MIN;
+			continue;
+		}
+
+		partition = (zbx_hk_partition_t *)zbx_malloc(NULL, sizeof(zbx_hk_partition_t));
+		partition->name = zbx_strdup(NULL, row[0]);
+		partition->lower = lower;
+		partition->upper = upper;
+		zbx_vector_hk_partition_ptr_append(partitions, partition);
+
+		lower = upper;
+	}
+	zbx_db_free_result(result);
+#endif
+	zbx_vector_hk_partition_ptr_sort(partitions, hk_partition_compare_by_upper);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes partition housekeeping                                *
+ *                                                                            *
+ * Parameters: enabled      - [IN] 1 - drop partitions of partitioned tables  *
+ *                                 instead of deleting rows                   *
+ *             create_ahead - [IN] number of future partitions to create      *
+ *                                                                            *
+ ******************************************************************************/
+void	hk_partitions_init(int enabled, int create_ahead)
+{
+	partitions_enabled = enabled;
+	partitions_create_ahead = create_ahead;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: detects which of housekept tables are partitioned by clock        *
+ *                                                                            *
+ * Parameters: tsdb_version - [IN] TimescaleDB version, 0 if not installed    *
+ *                                                                            *
+ ******************************************************************************/
+void	hk_partitions_update(int tsdb_version)
+{
+	zbx_db_result_t		result;
+	zbx_db_row_t		row;
+	zbx_hk_partition_table_t	*ptable;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	for (ptable = partition_tables; NULL != ptable->table; ptable++)
+		ptable->type = HK_PARTITION_TYPE_NONE;
+
+	if (0 == partitions_enabled)
+		goto out;
+
+	for (ptable = partition_tables; NULL != ptable->table; ptable++)
+	{
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%s'%s'", 0 == sql_offset ? "" : ",",
+				ptable->table);
+	}
+
+#if defined(HAVE_POSTGRESQL)
+	result = zbx_db_select(
+			"select c.relname"
+			" from pg_partitioned_table pt"
+				" join pg_class c on c.oid=pt.partrelid"
+				" join pg_namespace n on n.oid=c.relnamespace"
+			" where n.nspname='%s'"
+				" and pg_get_partkeydef(c.oid)='RANGE (clock)'"
+				" and c.relname in (%s)",
+			zbx_db_get_schema_esc(), sql);
+#else
+	ZBX_UNUSED(tsdb_version);
+
+	result = zbx_db_select(
+			"select distinct table_name"
+			" from information_schema.partitions"
+			" where table_schema=database()"
+				" and partition_method in ('RANGE','RANGE COLUMNS')"
+				" and replace(partition_expression,'`','')='clock'"
+				" and table_name in (%s)",
+			sql);
+#endif
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		if (NULL != (ptable = hk_partition_table_get(row[0])))
+			ptable->type = HK_PARTITION_TYPE_RANGE;
+	}
+	zbx_db_free_result(result);
+
+#if defined(HAVE_POSTGRESQL)
+	if (0 < tsdb_version)
+	{
+		result = zbx_db_select(
+				"select hypertable_name"
+				" from timescaledb_information.hypertables"
+				" where hypertable_schema='%s'"
+					" and hypertable_name in (%s)",
+				zbx_db_get_schema_esc(), sql);
+
+		while (NULL != (row = zbx_db_fetch(result)))
+		{
+			if (NULL != (ptable = hk_partition_table_get(row[0])))
+				ptable->type = HK_PARTITION_TYPE_HYPERTABLE;
+		}
+		zbx_db_free_result(result);
+	}
+#endif
+	zbx_free(sql);
+
+	for (ptable = partition_tables; NULL != ptable->table; ptable++)
+	{
+		if (HK_PARTITION_TYPE_NONE != ptable->type)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() table:%s is partitioned, type:%d", __func__, ptable->table,
+					(int)ptable->type);
+		}
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if table data is removed by dropping partitions            *
+ *                                                                            *
+ ******************************************************************************/
+int	hk_partitions_is_managed(const char *table)
+{
+	const zbx_hk_partition_table_t	*ptable;
+
+	if (NULL == (ptable = hk_partition_table_get(table)) || HK_PARTITION_TYPE_NONE == ptable->type)
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: drops table partitions containing only data older than specified  *
+ *          timestamp                                                         *
+ *                                                                            *
+ * Parameters: table       - [IN]                                             *
+ *             drop_before - [IN] partitions with upper bound not exceeding   *
+ *                                this timestamp are dropped                  *
+ *                                                                            *
+ * Return value: number of dropped partitions                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	hk_partitions_drop(const char *table, int drop_before)
+{
+	const zbx_hk_partition_table_t	*ptable;
+	int				dropped = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() table:%s drop_before:%d", __func__, table, drop_before);
+
+	if (NULL == (ptable = hk_partition_table_get(table)))
+		goto out;
+
+	if (HK_PARTITION_TYPE_HYPERTABLE == ptable->type)
+	{
+		zbx_db_result_t	result;
+
+		if (NULL == (result = zbx_db_select("select drop_chunks(relation=>'%s',older_than=>%d)", table,
+				drop_before)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot drop chunks for %s", table);
+			goto out;
+		}
+
+		while (NULL != zbx_db_fetch(result))
+			dropped++;
+
+		zbx_db_free_result(result);
+	}
+	else if (HK_PARTITION_TYPE_RANGE == ptable->type)
+	{
+		zbx_vector_hk_partition_ptr_t	partitions;
+		int				drop_num;
+
+		zbx_vector_hk_partition_ptr_create(&partitions);
+		hk_partitions_get(table, &partitions);
+
+		for (drop_num = 0; drop_num < partitions.values_num; drop_num++)
+		{
+			if (partitions.values[drop_num]->upper > drop_before)
+				break;
+		}
+#if defined(HAVE_MYSQL)
+		/* MySQL does not allow dropping all partitions of a table */
+		if (drop_num == partitions.values_num)
+			drop_num--;
+
+		if (0 < drop_num)
+		{
+			char	*sql = NULL;
+			size_t	sql_alloc = 0, sql_offset = 0;
+
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "alter table %s drop partition", table);
+
+			for (int i = 0; i < drop_num; i++)
+			{
+				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%c%s", 0 == i ? ' ' : ',',
+						partitions.values[i]->name);
+			}
+
+			if (ZBX_DB_OK <= zbx_db_execute("%s", sql))
+				dropped = drop_num;
+
+			zbx_free(sql);
+		}
+#else
+		for (int i = 0; i < drop_num; i++)
+		{
+			if (ZBX_DB_OK > zbx_db_execute("drop table %s.%s", zbx_db_get_schema_esc(),
+					partitions.values[i]->name))
+			{
+				break;
+			}
+
+			dropped++;
+		}
+#endif
+		zbx_vector_hk_partition_ptr_clear_ext(&partitions, hk_partition_free);
+		zbx_vector_hk_partition_ptr_destroy(&partitions);
+	}
+
+	if (0 != dropped)
+		zabbix_log(LOG_LEVEL_DEBUG, "dropped %d partitions of table %s", dropped, table);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, dropped);
+
+	return dropped;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates partitions ahead for range partitioned table              *
+ *                                                                            *
+ * Parameters: table - [IN]                                                   *
+ *             now   - [IN] current timestamp                                 *
+ *                                                                            *
+ * Return value: number of created partitions                                 *
+ *                                                                            *
+ * Comments: New partitions have the same width as the newest existing        *
+ *           bounded partition (one day if it cannot be determined) and are   *
+ *           named by their lower bound in UTC: <table>_pYYYYMMDDHH on        *
+ *           PostgreSQL and pYYYYMMDDHH on MySQL.                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partitions_create_table(const char *table, int now)
+{
+	zbx_vector_hk_partition_ptr_t	partitions;
+	const zbx_hk_partition_t	*last = NULL, *maxvalue = NULL;
+	int				width = SEC_PER_DAY, lower, target, created = 0;
+
+	zbx_vector_hk_partition_ptr_create(&partitions);
+	hk_partitions_get(table, &partitions);
+
+	for (int i = 0; i < partitions.values_num; i++)
+	{
+		if (INT_MAX == partitions.values[i]->upper)
+			maxvalue = partitions.values[i];
+		else
+			last = partitions.values[i];
+	}
+
+#if defined(HAVE_POSTGRESQL)
+	/* new ranges would overlap with partition without upper bound */
+	if (NULL != maxvalue)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot create partitions ahead for table %s: partition %s has no upper"
+				" bound", table, maxvalue->name);
+		goto out;
+	}
+#endif
+	if (NULL != last)
+	{
+		if (INT_MIN != last->lower)
+			width = MAX(last->upper - last->lower, SEC_PER_HOUR);
+
+		lower = last->upper;
+	}
+	else
+		lower = now - now % SEC_PER_DAY;
+
+	target = now + partitions_create_ahead * width;
+
+	while (lower < target && HK_PARTITION_CREATE_MAX > created)
+	{
+		char		suffix[16];
+		time_t		clock = (time_t)lower;
+		struct tm	tm;
+		int		rc;
+
+		gmtime_r(&clock, &tm);
+		strftime(suffix, sizeof(suffix), "p%Y%m%d%H", &tm);
+
+#if defined(HAVE_POSTGRESQL)
+		rc = zbx_db_execute("create table %s.%s_%s partition of %s.%s for values from (%d) to (%d)",
+				zbx_db_get_schema_esc(), table, suffix, zbx_db_get_schema_esc(), table, lower,
+				lower + width);
+#else
+		if (NULL != maxvalue)
+		{
+			rc = zbx_db_execute("alter table %s reorganize partition %s into"
+					" (partition %s values less than (%d),partition %s values less than maxvalue)",
+					table, maxvalue->name, suffix, lower + width, maxvalue->name);
+		}
+		else
+		{
+			rc = zbx_db_execute("alter table %s add partition (partition %s values less than (%d))",
+					table, suffix, lower + width);
+		}
+#endif
+		if (ZBX_DB_OK > rc)
+			break;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "created partition %s of table %s for range [%d,%d)", suffix, table,
+				lower, lower + width);
+
+		lower += width;
+		created++;
+	}
+#if defined(HAVE_POSTGRESQL)
+out:
+#endif
+	zbx_vector_hk_partition_ptr_clear_ext(&partitions, hk_partition_free);
+	zbx_vector_hk_partition_ptr_destroy(&partitions);
+
+	return created;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates partitions ahead for all range partitioned tables         *
+ *                                                                            *
+ * Parameters: now - [IN] current timestamp                                   *
+ *                                                                            *
+ * Return value: number of created partitions                                 *
+ *                                                                            *
+ * Comments: TimescaleDB creates chunks automatically.                        *
+ *                                                                            *
+ ******************************************************************************/
+int	hk_partitions_create_ahead(int now)
+{
+	int	created = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() now:%d", __func__, now);
+
+	if (0 == partitions_create_ahead)
+		goto out;
+
+	for (const zbx_hk_partition_table_t *ptable = partition_tables; NULL != ptable->table; ptable++)
+	{
+		if (HK_PARTITION_TYPE_RANGE == ptable->type)
+			created += hk_partitions_create_table(ptable->table, now);
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, created);
+
+	return created;
+}
+
+#else
+
+void	hk_partitions_init(int enabled, int create_ahead)
+{
+	ZBX_UNUSED(enabled);
+	ZBX_UNUSED(create_ahead);
+}
+
+void	hk_partitions_update(int tsdb_version)
+{
+	ZBX_UNUSED(tsdb_version);
+}
+
+int	hk_partitions_is_managed(const char *table)
+{
+	ZBX_UNUSED(table);
+
+	return FAIL;
+}
+
+int	hk_partitions_drop(const char *table, int drop_before)
+{
+	ZBX_UNUSED(table);
+	ZBX_UNUSED(drop_before);
+
+	return 0;
+}
+
+int	hk_partitions_create_ahead(int now)
+{
+	ZBX_UNUSED(now);
+
+	return 0;
+}
+
+#endif
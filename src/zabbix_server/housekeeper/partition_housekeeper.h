@@ -0,0 +1,24 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_PARTITION_HOUSEKEEPER_H
+#define ZABBIX_PARTITION_HOUSEKEEPER_H
+
+void	hk_partitions_init(int enabled, int create_ahead);
+void	hk_partitions_update(int tsdb_version);
+int	hk_partitions_is_managed(const char *table);
+int	hk_partitions_drop(const char *table, int drop_before);
+int	hk_partitions_create_ahead(int now);
+
+#endif
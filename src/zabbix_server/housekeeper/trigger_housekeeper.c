@@ -14,6 +14,8 @@
 
 #include "housekeeper_server.h"
 
+#include "../events/problem_index.h"
+
 #include "zbxtimekeeper.h"
 #include "zbxthreads.h"
 #include "zbxlog.h"
@@ -101,7 +103,10 @@ static int	housekeep_problems_without_triggers(void)
 			zabbix_log(LOG_LEVEL_WARNING, "Failed to delete a problem without a trigger");
 		}
 		else
+		{
 			deleted = ids.values_num;
+			zbx_problem_index_remove(&ids);
+		}
 
 		housekeep_service_problems(&ids);
 	}
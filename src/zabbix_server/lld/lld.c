@@ -28,6 +28,7 @@
 #include "zbxtime.h"
 
 ZBX_PTR_VECTOR_IMPL(lld_condition_ptr, lld_condition_t*)
+ZBX_VECTOR_IMPL(lld_condition_ref, lld_condition_ref_t)
 ZBX_PTR_VECTOR_IMPL(lld_item_link_ptr, zbx_lld_item_link_t*)
 ZBX_PTR_VECTOR_IMPL(lld_override_ptr, zbx_lld_override_t*)
 ZBX_PTR_VECTOR_IMPL(lld_row_ptr, zbx_lld_row_t*)
@@ -86,6 +87,9 @@ static void	lld_condition_free(lld_condition_t *condition)
 	zbx_regexp_clean_expressions(&condition->regexps);
 	zbx_vector_expression_destroy(&condition->regexps);
 
+	if (NULL != condition->regexp_compiled)
+		zbx_regexp_free(condition->regexp_compiled);
+
 	zbx_free(condition->macro);
 	zbx_free(condition->regexp);
 	zbx_free(condition);
@@ -120,6 +124,7 @@ static int	lld_condition_compare_by_macro(const void *cond1, const void *cond2)
 static void	lld_filter_init(zbx_lld_filter_t *filter)
 {
 	zbx_vector_lld_condition_ptr_create(&filter->conditions);
+	zbx_vector_lld_condition_ref_create(&filter->condition_refs);
 	filter->expression = NULL;
 	filter->evaltype = ZBX_CONDITION_EVAL_TYPE_AND_OR;
 }
@@ -133,6 +138,7 @@ static void	lld_filter_clean(zbx_lld_filter_t *filter)
 {
 	zbx_free(filter->expression);
 	lld_conditions_free(&filter->conditions);
+	zbx_vector_lld_condition_ref_destroy(&filter->condition_refs);
 }
 
 static int	lld_filter_condition_add(zbx_vector_lld_condition_ptr_t *conditions, const char *id, const char *macro,
@@ -145,6 +151,8 @@ static int	lld_filter_condition_add(zbx_vector_lld_condition_ptr_t *conditions,
 	condition->macro = zbx_strdup(NULL, macro);
 	condition->regexp = zbx_strdup(NULL, regexp);
 	condition->op = (unsigned char)atoi(op);
+	condition->regexp_compiled = NULL;
+	condition->macro_index = -1;
 
 	zbx_vector_expression_create(&condition->regexps);
 
@@ -165,6 +173,21 @@ static int	lld_filter_condition_add(zbx_vector_lld_condition_ptr_t *conditions,
 	{
 		zbx_substitute_simple_macros(NULL, NULL, NULL, NULL, NULL, NULL, item, NULL, NULL, NULL, NULL, NULL,
 				&condition->regexp, ZBX_MACRO_TYPE_LLD_FILTER, NULL, 0);
+
+		/* compile regular expression once instead of doing it for every LLD row, */
+		/* invalid expressions are reported when the condition is evaluated       */
+		if ((ZBX_CONDITION_OPERATOR_REGEXP == condition->op ||
+				ZBX_CONDITION_OPERATOR_NOT_REGEXP == condition->op) && '\0' != *condition->regexp)
+		{
+			char	*err = NULL;
+
+			if (SUCCEED != zbx_regexp_compile(condition->regexp, &condition->regexp_compiled, &err))
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "cannot compile LLD filter regular expression \"%s\": %s",
+						condition->regexp, err);
+				zbx_free(err);
+			}
+		}
 	}
 
 	return SUCCEED;
@@ -208,13 +231,185 @@ static int	lld_filter_load(zbx_lld_filter_t *filter, zbx_uint64_t lld_ruleid, co
 	return ret;
 }
 
+#define LLD_ROW_MACRO_UNRESOLVED	0
+#define LLD_ROW_MACRO_RESOLVED		1
+#define LLD_ROW_MACRO_MISSING		2
+
+/* values of macros referenced by filter conditions, resolved once per LLD row */
+typedef struct
+{
+	zbx_vector_str_t	macros;		/* macro names, condition macro_index refers to this vector */
+	char			**values;	/* macro values of the current row */
+	unsigned char		*states;	/* macro value resolution states of the current row */
+}
+lld_row_macros_t;
+
+static void	lld_row_macros_init(lld_row_macros_t *row_macros)
+{
+	zbx_vector_str_create(&row_macros->macros);
+	row_macros->values = NULL;
+	row_macros->states = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: assigns macro value slots to filter conditions                    *
+ *                                                                            *
+ * Parameters: row_macros - [IN/OUT] row macro cache                          *
+ *             filter     - [IN/OUT] LLD filter                               *
+ *                                                                            *
+ * Comments: conditions of all filters (rule and override filters) share the  *
+ *           same slots, so every macro is extracted from row at most once.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_row_macros_register(lld_row_macros_t *row_macros, zbx_lld_filter_t *filter)
+{
+	for (int i = 0; i < filter->conditions.values_num; i++)
+	{
+		lld_condition_t	*condition = filter->conditions.values[i];
+
+		if (FAIL == (condition->macro_index = zbx_vector_str_search(&row_macros->macros, condition->macro,
+				ZBX_DEFAULT_STR_COMPARE_FUNC)))
+		{
+			condition->macro_index = row_macros->macros.values_num;
+			zbx_vector_str_append(&row_macros->macros, condition->macro);
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocates macro value slots after all filters are registered      *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_row_macros_prepare(lld_row_macros_t *row_macros)
+{
+	if (0 == row_macros->macros.values_num)
+		return;
+
+	row_macros->values = (char **)zbx_calloc(NULL, (size_t)row_macros->macros.values_num, sizeof(char *));
+	row_macros->states = (unsigned char *)zbx_calloc(NULL, (size_t)row_macros->macros.values_num,
+			sizeof(unsigned char));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resets cached macro values before processing next LLD row         *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_row_macros_reset(lld_row_macros_t *row_macros)
+{
+	for (int i = 0; i < row_macros->macros.values_num; i++)
+	{
+		if (LLD_ROW_MACRO_RESOLVED == row_macros->states[i])
+			zbx_free(row_macros->values[i]);
+
+		row_macros->states[i] = LLD_ROW_MACRO_UNRESOLVED;
+	}
+}
+
+static void	lld_row_macros_destroy(lld_row_macros_t *row_macros)
+{
+	if (NULL != row_macros->states)
+		lld_row_macros_reset(row_macros);
+
+	zbx_free(row_macros->values);
+	zbx_free(row_macros->states);
+
+	/* macro names are owned by filter conditions */
+	zbx_vector_str_destroy(&row_macros->macros);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets macro value of the current LLD row, extracting it from row   *
+ *          data on first request                                             *
+ *                                                                            *
+ * Parameters: row_macros      - [IN/OUT] row macro cache                     *
+ *             index           - [IN] macro slot index                        *
+ *             jp_row          - [IN] LLD data row                            *
+ *             lld_macro_paths - [IN] use JSON path to extract from jp_row    *
+ *                                                                            *
+ * Return value: macro value or NULL if row has no value for the macro        *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*lld_row_macros_get(lld_row_macros_t *row_macros, int index,
+		const struct zbx_json_parse *jp_row, const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths)
+{
+	if (LLD_ROW_MACRO_UNRESOLVED == row_macros->states[index])
+	{
+		if (SUCCEED == zbx_lld_macro_value_by_name(jp_row, lld_macro_paths,
+				row_macros->macros.values[index], &row_macros->values[index]))
+		{
+			row_macros->states[index] = LLD_ROW_MACRO_RESOLVED;
+		}
+		else
+		{
+			zbx_free(row_macros->values[index]);
+			row_macros->states[index] = LLD_ROW_MACRO_MISSING;
+		}
+	}
+
+	return row_macros->values[index];
+}
+
+static int	lld_condition_ref_compare_by_offset(const void *d1, const void *d2)
+{
+	const lld_condition_ref_t	*ref1 = (const lld_condition_ref_t *)d1;
+	const lld_condition_ref_t	*ref2 = (const lld_condition_ref_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(ref1->offset, ref2->offset);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares filter for evaluation over LLD rows                      *
+ *                                                                            *
+ * Parameters: filter     - [IN/OUT] LLD filter                               *
+ *             row_macros - [IN/OUT] row macro cache                          *
+ *                                                                            *
+ * Comments: custom expression is split into condition references here, so    *
+ *           the per row evaluation only concatenates condition results.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_filter_compile(zbx_lld_filter_t *filter, lld_row_macros_t *row_macros)
+{
+	lld_row_macros_register(row_macros, filter);
+
+	zbx_vector_lld_condition_ref_clear(&filter->condition_refs);
+
+	if (ZBX_CONDITION_EVAL_TYPE_EXPRESSION != filter->evaltype || NULL == filter->expression)
+		return;
+
+	for (int i = 0; i < filter->conditions.values_num; i++)
+	{
+		char			id[ZBX_MAX_UINT64_LEN + 2];
+		const char		*p;
+		lld_condition_ref_t	ref;
+
+		ref.len = (size_t)zbx_snprintf(id, sizeof(id), "{" ZBX_FS_UI64 "}", filter->conditions.values[i]->id);
+		ref.index = i;
+
+		for (p = strstr(filter->expression, id); NULL != p; p = strstr(p + ref.len, id))
+		{
+			ref.offset = (size_t)(p - filter->expression);
+			zbx_vector_lld_condition_ref_append(&filter->condition_refs, ref);
+		}
+	}
+
+	zbx_vector_lld_condition_ref_sort(&filter->condition_refs, lld_condition_ref_compare_by_offset);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: checks if LLD data passes filter evaluation                       *
  *                                                                            *
- * Parameters: jp_row          - [IN] LLD data row                            *
+ * Parameters: condition       - [IN] LLD filter condition                    *
+ *             row_macros      - [IN/OUT] macro values of jp_row              *
+ *             jp_row          - [IN] LLD data row                            *
  *             lld_macro_paths - [IN] use JSON path to extract from jp_row    *
- *             condition       - [IN] LLD filter condition                    *
  *             result          - [OUT] result of evaluation                   *
  *             err_msg         - [OUT]                                        *
  *                                                                            *
@@ -222,14 +417,14 @@ static int	lld_filter_load(zbx_lld_filter_t *filter, zbx_uint64_t lld_ruleid, co
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	filter_condition_match(const struct zbx_json_parse *jp_row,
-		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, const lld_condition_t *condition, int *result,
-		char **err_msg)
+static int	filter_condition_match(const lld_condition_t *condition, lld_row_macros_t *row_macros,
+		const struct zbx_json_parse *jp_row, const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths,
+		int *result, char **err_msg)
 {
-	char	*value = NULL;
-	int	ret = SUCCEED;
+	const char	*value;
+	int		ret = SUCCEED;
 
-	if (SUCCEED == zbx_lld_macro_value_by_name(jp_row, lld_macro_paths, condition->macro, &value))
+	if (NULL != (value = lld_row_macros_get(row_macros, condition->macro_index, jp_row, lld_macro_paths)))
 	{
 		if (ZBX_CONDITION_OPERATOR_NOT_EXIST == condition->op)
 		{
@@ -241,7 +436,15 @@ static int	filter_condition_match(const struct zbx_json_parse *jp_row,
 		}
 		else
 		{
-			switch (zbx_regexp_match_ex(&condition->regexps, value, condition->regexp, ZBX_CASE_SENSITIVE))
+			int	match;
+
+			if (NULL != condition->regexp_compiled)
+				match = zbx_regexp_match_precompiled2(value, condition->regexp_compiled, NULL);
+			else
+				match = zbx_regexp_match_ex(&condition->regexps, value, condition->regexp,
+						ZBX_CASE_SENSITIVE);
+
+			switch (match)
 			{
 				case ZBX_REGEXP_MATCH:
 					*result = (ZBX_CONDITION_OPERATOR_REGEXP == condition->op ? 1 : 0);
@@ -275,16 +478,79 @@ static int	filter_condition_match(const struct zbx_json_parse *jp_row,
 		}
 	}
 
-	zbx_free(value);
-
 	return ret;
 }
 
+#define LLD_FILTER_UNKNOWN	-1
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: evaluates filter condition into 1, 0 or unknown result            *
+ *                                                                            *
+ * Comments: the error message of unknown result is appended to errmsgs and   *
+ *           its index is returned in unknown_idx.                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	filter_condition_evaluate(const lld_condition_t *condition, lld_row_macros_t *row_macros,
+		const struct zbx_json_parse *jp_row, const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths,
+		zbx_vector_str_t *errmsgs, int *unknown_idx)
+{
+	int	res;
+	char	*errmsg = NULL;
+
+	if (SUCCEED == filter_condition_match(condition, row_macros, jp_row, lld_macro_paths, &res, &errmsg))
+		return res;
+
+	*unknown_idx = errmsgs->values_num;
+	zbx_vector_str_append(errmsgs, errmsg);
+
+	return LLD_FILTER_UNKNOWN;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: combines two condition results with "and"/"or" operator using     *
+ *          the same unknown value propagation rules as zbx_evaluate()        *
+ *                                                                            *
+ * Parameters: res     - [IN/OUT] left operand and result                     *
+ *             res_idx - [IN/OUT] error message index of unknown result       *
+ *             op      - [IN] right operand                                   *
+ *             op_idx  - [IN] error message index of unknown right operand    *
+ *             is_and  - [IN] 1 - "and" operator, 0 - "or" operator           *
+ *                                                                            *
+ ******************************************************************************/
+static void	filter_result_combine(int *res, int *res_idx, int op, int op_idx, int is_and)
+{
+	/* 0 dominates "and", 1 dominates "or" */
+	int	dominant = (0 == is_and);
+
+	if (LLD_FILTER_UNKNOWN == *res)
+	{
+		if (LLD_FILTER_UNKNOWN == op)
+			*res_idx = op_idx;
+		else if (dominant == op)
+			*res = dominant;
+	}
+	else if (LLD_FILTER_UNKNOWN == op)
+	{
+		if (dominant != *res)
+		{
+			*res = LLD_FILTER_UNKNOWN;
+			*res_idx = op_idx;
+		}
+	}
+	else if (0 != is_and)
+		*res = (0 != *res && 0 != op);
+	else
+		*res = (0 != *res || 0 != op);
+}
+
 /****************************************************************************************
  *                                                                                      *
  * Purpose: checks if LLD data passes filter evaluation by and/or/andor rules           *
  *                                                                                      *
  * Parameters: filter          - [IN] LLD filter                                        *
+ *             row_macros      - [IN/OUT] macro values of jp_row                        *
  *             jp_row          - [IN] LLD data row                                      *
  *             lld_macro_paths - [IN] use JSON path to extract from jp_row              *
  *             info            - [OUT] warning description                              *
@@ -292,16 +558,19 @@ static int	filter_condition_match(const struct zbx_json_parse *jp_row,
  * Return value: SUCCEED - LLD data passed filter evaluation                            *
  *               FAIL    - otherwise                                                    *
  *                                                                                      *
+ * Comments: The conditions are combined directly instead of building and parsing       *
+ *           "(a or b) and (c)" expression for every row. Evaluation stops as soon as   *
+ *           the result cannot change - the remaining conditions can only affect which  *
+ *           error is reported for unknown result, which is not possible at that point. *
+ *                                                                                      *
  ****************************************************************************************/
-static int	filter_evaluate_and_or_andor(const zbx_lld_filter_t *filter, const struct zbx_json_parse *jp_row,
-		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, char **info)
+static int	filter_evaluate_and_or_andor(const zbx_lld_filter_t *filter, lld_row_macros_t *row_macros,
+		const struct zbx_json_parse *jp_row, const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths,
+		char **info)
 {
-	int			ret = SUCCEED, error_num = 0, res;
-	double			result;
-	lld_condition_t		*condition;
-	char			*lastmacro = NULL, *ops[] = {NULL, "and", "or"}, error[256], *expression = NULL,
-				*errmsg = NULL;
-	size_t			expression_alloc = 0, expression_offset = 0;
+	int			ret, res = LLD_FILTER_UNKNOWN, res_idx = -1, group = LLD_FILTER_UNKNOWN,
+				group_idx = -1, first = 1;
+	char			error[256];
 	zbx_vector_str_t	errmsgs;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -310,67 +579,66 @@ static int	filter_evaluate_and_or_andor(const zbx_lld_filter_t *filter, const st
 
 	for (int i = 0; i < filter->conditions.values_num; i++)
 	{
-		condition = filter->conditions.values[i];
+		const lld_condition_t	*condition = filter->conditions.values[i];
+		int			op, op_idx = -1;
 
-		switch (filter->evaltype)
+		if (ZBX_CONDITION_EVAL_TYPE_AND_OR == filter->evaltype)
 		{
-			case ZBX_CONDITION_EVAL_TYPE_AND_OR:
-				if (NULL == lastmacro)
-				{
-					zbx_chrcpy_alloc(&expression, &expression_alloc, &expression_offset, '(');
-				}
-				else if (0 != strcmp(lastmacro, condition->macro))
-				{
-					zbx_strcpy_alloc(&expression, &expression_alloc, &expression_offset, ") and (");
-				}
-				else
-					zbx_strcpy_alloc(&expression, &expression_alloc, &expression_offset, " or ");
+			/* conditions are sorted by macro, conditions of the same macro form "or" group */
+			if (0 == i || 0 != strcmp(filter->conditions.values[i - 1]->macro, condition->macro))
+			{
+				group = filter_condition_evaluate(condition, row_macros, jp_row, lld_macro_paths,
+						&errmsgs, &group_idx);
+			}
+			else if (1 != group)
+			{
+				op = filter_condition_evaluate(condition, row_macros, jp_row, lld_macro_paths,
+						&errmsgs, &op_idx);
+				filter_result_combine(&group, &group_idx, op, op_idx, 0);
+			}
 
-				lastmacro = condition->macro;
-				break;
-			case ZBX_CONDITION_EVAL_TYPE_AND:
-			case ZBX_CONDITION_EVAL_TYPE_OR:
-				if (0 != i)
-				{
-					zbx_chrcpy_alloc(&expression, &expression_alloc, &expression_offset, ' ');
-					zbx_strcpy_alloc(&expression, &expression_alloc, &expression_offset,
-							ops[filter->evaltype]);
-					zbx_chrcpy_alloc(&expression, &expression_alloc, &expression_offset, ' ');
-				}
-				break;
-			default:
-				*info = zbx_strdcatf(*info, "Cannot accurately apply filter: invalid condition "
-						"type \"%d\".\n", filter->evaltype);
-				goto out;
+			if (i + 1 < filter->conditions.values_num &&
+					0 == strcmp(filter->conditions.values[i + 1]->macro, condition->macro))
+			{
+				continue;
+			}
+
+			op = group;
+			op_idx = group_idx;
+		}
+		else
+		{
+			op = filter_condition_evaluate(condition, row_macros, jp_row, lld_macro_paths, &errmsgs,
+					&op_idx);
 		}
 
-		if (SUCCEED == (ret = filter_condition_match(jp_row, lld_macro_paths, condition, &res, &errmsg)))
+		if (1 == first)
 		{
-			zbx_snprintf_alloc(&expression, &expression_alloc, &expression_offset, "%d", res);
+			res = op;
+			res_idx = op_idx;
+			first = 0;
 		}
 		else
+			filter_result_combine(&res, &res_idx, op, op_idx, ZBX_CONDITION_EVAL_TYPE_OR != filter->evaltype);
+
+		if ((ZBX_CONDITION_EVAL_TYPE_OR == filter->evaltype && 1 == res) ||
+				(ZBX_CONDITION_EVAL_TYPE_OR != filter->evaltype && 0 == res))
 		{
-			zbx_snprintf_alloc(&expression, &expression_alloc, &expression_offset, ZBX_UNKNOWN_STR "%d",
-					error_num++);
-			zbx_vector_str_append(&errmsgs, errmsg);
-			errmsg = NULL;
+			break;
 		}
 	}
 
-	if (ZBX_CONDITION_EVAL_TYPE_AND_OR == filter->evaltype)
-		zbx_chrcpy_alloc(&expression, &expression_alloc, &expression_offset, ')');
-
-	if (SUCCEED == zbx_evaluate(&result, expression, error, sizeof(error), &errmsgs))
+	if (LLD_FILTER_UNKNOWN != res)
 	{
-		ret = (SUCCEED != zbx_double_compare(result, 0) ? SUCCEED : FAIL);
+		ret = (0 != res ? SUCCEED : FAIL);
 	}
 	else
 	{
+		zbx_snprintf(error, sizeof(error), "Cannot evaluate expression: \"%s\".", errmsgs.values[res_idx]);
 		*info = zbx_strdcat(*info, error);
 		ret = FAIL;
 	}
-out:
-	zbx_free(expression);
+
 	zbx_vector_str_clear_ext(&errmsgs, zbx_str_free);
 	zbx_vector_str_destroy(&errmsgs);
 
@@ -384,6 +652,7 @@ out:
  * Purpose: checks if LLD data passes filter evaluation by custom expression  *
  *                                                                            *
  * Parameters: filter          - [IN] LLD filter                              *
+ *             row_macros      - [IN/OUT] macro values of jp_row              *
  *             jp_row          - [IN] LLD data row                            *
  *             lld_macro_paths - [IN] use JSON path to extract from jp_row    *
  *             err_msg         - [OUT]                                        *
@@ -392,60 +661,62 @@ out:
  *               FAIL    - otherwise                                          *
  *                                                                            *
  * Comments: 1) replace {item_condition} references with action condition     *
- *              evaluation results (1 or 0)                                   *
+ *              evaluation results (1 or 0), reference positions are found    *
+ *              by lld_filter_compile()                                       *
  *           2) call zbx_evaluate() to calculate final result                 *
  *                                                                            *
  ******************************************************************************/
-static int	filter_evaluate_expression(const zbx_lld_filter_t *filter, const struct zbx_json_parse *jp_row,
-		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, char **err_msg)
+static int	filter_evaluate_expression(const zbx_lld_filter_t *filter, lld_row_macros_t *row_macros,
+		const struct zbx_json_parse *jp_row, const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths,
+		char **err_msg)
 {
-	int			ret, res, error_num = 0;
-	char			*expression = NULL, id[ZBX_MAX_UINT64_LEN + 2], *p, error[256], value[16],
-				*errmsg = NULL;
+	int			ret, *results;
+	char			*expression = NULL, error[256];
 	double			result;
 	zbx_vector_str_t	errmsgs;
-	size_t			expression_alloc = 0, expression_offset = 0, id_len, value_len;
+	size_t			expression_alloc = 0, expression_offset = 0, pos = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() expression:%s", __func__, filter->expression);
 
-	zbx_strcpy_alloc(&expression, &expression_alloc, &expression_offset, filter->expression);
-
-	/* include trailing zero */
-	expression_offset++;
-
 	zbx_vector_str_create(&errmsgs);
 
+	results = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)filter->conditions.values_num);
+
+	/* evaluate all conditions in their order to keep unknown value indexes stable */
 	for (int i = 0; i < filter->conditions.values_num; i++)
 	{
-		const lld_condition_t	*condition = filter->conditions.values[i];
+		int	unknown_idx = -1;
 
-		if (SUCCEED == filter_condition_match(jp_row, lld_macro_paths, condition, &res, &errmsg))
+		if (LLD_FILTER_UNKNOWN == (results[i] = filter_condition_evaluate(filter->conditions.values[i],
+				row_macros, jp_row, lld_macro_paths, &errmsgs, &unknown_idx)))
 		{
-			zbx_snprintf(value, sizeof(value), "%d", res);
-		}
-		else
-		{
-			zbx_snprintf(value, sizeof(value), ZBX_UNKNOWN_STR "%d", error_num++);
-			zbx_vector_str_append(&errmsgs, errmsg);
-			errmsg = NULL;
+			results[i] = -2 - unknown_idx;
 		}
+	}
 
-		zbx_snprintf(id, sizeof(id), "{" ZBX_FS_UI64 "}", condition->id);
+	for (int i = 0; i < filter->condition_refs.values_num; i++)
+	{
+		const lld_condition_ref_t	*ref = &filter->condition_refs.values[i];
 
-		value_len = strlen(value);
-		id_len = strlen(id);
+		zbx_strncpy_alloc(&expression, &expression_alloc, &expression_offset, filter->expression + pos,
+				ref->offset - pos);
 
-		for (p = strstr(expression, id); NULL != p; p = strstr(p, id))
+		if (0 <= results[ref->index])
 		{
-			size_t	id_pos = p - expression;
-
-			zbx_replace_mem_dyn(&expression, &expression_alloc, &expression_offset, id_pos, id_len,
-					value, value_len);
-
-			p = expression + id_pos + value_len;
+			zbx_chrcpy_alloc(&expression, &expression_alloc, &expression_offset,
+					0 != results[ref->index] ? '1' : '0');
 		}
+		else
+		{
+			zbx_snprintf_alloc(&expression, &expression_alloc, &expression_offset, ZBX_UNKNOWN_STR "%d",
+					-2 - results[ref->index]);
+		}
+
+		pos = ref->offset + ref->len;
 	}
 
+	zbx_strcpy_alloc(&expression, &expression_alloc, &expression_offset, filter->expression + pos);
+
 	if (SUCCEED == zbx_evaluate(&result, expression, error, sizeof(error), &errmsgs))
 	{
 		ret = (SUCCEED != zbx_double_compare(result, 0) ? SUCCEED : FAIL);
@@ -456,6 +727,7 @@ static int	filter_evaluate_expression(const zbx_lld_filter_t *filter, const stru
 		ret = FAIL;
 	}
 
+	zbx_free(results);
 	zbx_free(expression);
 	zbx_vector_str_clear_ext(&errmsgs, zbx_str_free);
 	zbx_vector_str_destroy(&errmsgs);
@@ -465,11 +737,15 @@ static int	filter_evaluate_expression(const zbx_lld_filter_t *filter, const stru
 	return ret;
 }
 
+#undef LLD_FILTER_UNKNOWN
+
 /******************************************************************************
  *                                                                            *
  * Purpose: checks if LLD data passes filter evaluation                       *
  *                                                                            *
- * Parameters: filter          - [IN] LLD filter                              *
+ * Parameters: filter          - [IN] LLD filter, prepared by                 *
+ *                                    lld_filter_compile()                    *
+ *             row_macros      - [IN/OUT] macro values of jp_row              *
  *             jp_row          - [IN] LLD data row                            *
  *             lld_macro_paths - [IN] use JSON path to extract from jp_row    *
  *             info            - [OUT] warning description                    *
@@ -478,8 +754,9 @@ static int	filter_evaluate_expression(const zbx_lld_filter_t *filter, const stru
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	filter_evaluate(const zbx_lld_filter_t *filter, const struct zbx_json_parse *jp_row,
-		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, char **info)
+static int	filter_evaluate(const zbx_lld_filter_t *filter, lld_row_macros_t *row_macros,
+		const struct zbx_json_parse *jp_row, const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths,
+		char **info)
 {
 	if (0 == filter->conditions.values_num)
 		return SUCCEED;
@@ -489,9 +766,9 @@ static int	filter_evaluate(const zbx_lld_filter_t *filter, const struct zbx_json
 		case ZBX_CONDITION_EVAL_TYPE_AND_OR:
 		case ZBX_CONDITION_EVAL_TYPE_AND:
 		case ZBX_CONDITION_EVAL_TYPE_OR:
-			return filter_evaluate_and_or_andor(filter, jp_row, lld_macro_paths, info);
+			return filter_evaluate_and_or_andor(filter, row_macros, jp_row, lld_macro_paths, info);
 		case ZBX_CONDITION_EVAL_TYPE_EXPRESSION:
-			return filter_evaluate_expression(filter, jp_row, lld_macro_paths, info);
+			return filter_evaluate_expression(filter, row_macros, jp_row, lld_macro_paths, info);
 	}
 
 	return FAIL;
@@ -564,6 +841,34 @@ static int	lld_override_conditions_load(zbx_vector_lld_override_ptr_t *overrides
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compiles regular expressions of override operation conditions,    *
+ *          which are matched against every discovered object name            *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_override_operations_compile(zbx_lld_override_t *override)
+{
+	if (0 == override->override_operations.values_num)
+		return;
+
+	override->operation_regexps = (zbx_regexp_t **)zbx_calloc(override->operation_regexps,
+			(size_t)override->override_operations.values_num, sizeof(zbx_regexp_t *));
+
+	for (int i = 0; i < override->override_operations.values_num; i++)
+	{
+		const zbx_lld_override_operation_t	*op = override->override_operations.values[i];
+		char					*err = NULL;
+
+		if (ZBX_CONDITION_OPERATOR_REGEXP != op->operator && ZBX_CONDITION_OPERATOR_NOT_REGEXP != op->operator)
+			continue;
+
+		/* on failure the condition falls back to zbx_regexp_match(), which fails the same way */
+		if (SUCCEED != zbx_regexp_compile(op->value, &override->operation_regexps[i], &err))
+			zbx_free(err);
+	}
+}
+
 static void	lld_override_operations_load(zbx_vector_lld_override_ptr_t *overrides,
 		const zbx_vector_uint64_t *overrideids, char **sql, size_t *sql_alloc)
 {
@@ -594,6 +899,9 @@ static void	lld_override_operations_load(zbx_vector_lld_override_ptr_t *override
 
 	zbx_vector_lld_override_operation_destroy(&ops);
 
+	for (int i = 0; i < overrides->values_num; i++)
+		lld_override_operations_compile(overrides->values[i]);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -681,6 +989,7 @@ static int	lld_overrides_load(zbx_vector_lld_override_ptr_t *overrides, zbx_uint
 		override->stop = (unsigned char)atoi(row[4]);
 
 		zbx_vector_lld_override_operation_create(&override->override_operations);
+		override->operation_regexps = NULL;
 
 		zbx_vector_lld_override_ptr_append(overrides, override);
 		zbx_vector_uint64_append(&overrideids, override->overrideid);
@@ -712,20 +1021,41 @@ static void	lld_override_free(zbx_lld_override_t *override)
 {
 	lld_filter_clean(&override->filter);
 
+	if (NULL != override->operation_regexps)
+	{
+		for (int i = 0; i < override->override_operations.values_num; i++)
+		{
+			if (NULL != override->operation_regexps[i])
+				zbx_regexp_free(override->operation_regexps[i]);
+		}
+
+		zbx_free(override->operation_regexps);
+	}
+
 	zbx_vector_lld_override_operation_clear_ext(&override->override_operations, zbx_lld_override_operation_free);
 	zbx_vector_lld_override_operation_destroy(&override->override_operations);
 	zbx_free(override);
 }
 
-static int	regexp_strmatch_condition(const char *value, const char *pattern, unsigned char op)
+#define LLD_OVERRIDE_OPERATION_REGEXP(override, index)						\
+		(NULL != (override)->operation_regexps ? (override)->operation_regexps[index] : NULL)
+
+static int	regexp_strmatch_condition(const char *value, const char *pattern, const zbx_regexp_t *regexp,
+		unsigned char op)
 {
 	switch (op)
 	{
 		case ZBX_CONDITION_OPERATOR_REGEXP:
+			if (NULL != regexp)
+				return ZBX_REGEXP_MATCH == zbx_regexp_match_precompiled2(value, regexp, NULL) ? SUCCEED : FAIL;
+
 			if (NULL != zbx_regexp_match(value, pattern, NULL))
 				return SUCCEED;
 			break;
 		case ZBX_CONDITION_OPERATOR_NOT_REGEXP:
+			if (NULL != regexp)
+				return ZBX_REGEXP_MATCH != zbx_regexp_match_precompiled2(value, regexp, NULL) ? SUCCEED : FAIL;
+
 			if (NULL == zbx_regexp_match(value, pattern, NULL))
 				return SUCCEED;
 			break;
@@ -759,7 +1089,7 @@ void	lld_override_item(const zbx_vector_lld_override_ptr_t *overrides, const cha
 					name);
 
 			if (FAIL == regexp_strmatch_condition(name, override_operation->value,
-					override_operation->operator))
+					LLD_OVERRIDE_OPERATION_REGEXP(override, j), override_operation->operator))
 			{
 				zabbix_log(LOG_LEVEL_TRACE, "%s():FAIL", __func__);
 				continue;
@@ -826,7 +1156,7 @@ void	lld_override_trigger(const zbx_vector_lld_override_ptr_t *overrides, const
 					name);
 
 			if (FAIL == regexp_strmatch_condition(name, override_operation->value,
-					override_operation->operator))
+					LLD_OVERRIDE_OPERATION_REGEXP(override, j), override_operation->operator))
 			{
 				zabbix_log(LOG_LEVEL_TRACE, "%s():FAIL", __func__);
 				continue;
@@ -888,7 +1218,7 @@ void	lld_override_host(const zbx_vector_lld_override_ptr_t *overrides, const cha
 					name);
 
 			if (FAIL == regexp_strmatch_condition(name, override_operation->value,
-					override_operation->operator))
+					LLD_OVERRIDE_OPERATION_REGEXP(override, j), override_operation->operator))
 			{
 				zabbix_log(LOG_LEVEL_TRACE, "%s():FAIL", __func__);
 				continue;
@@ -951,7 +1281,7 @@ void	lld_override_graph(const zbx_vector_lld_override_ptr_t *overrides, const ch
 					name);
 
 			if (FAIL == regexp_strmatch_condition(name, override_operation->value,
-					override_operation->operator))
+					LLD_OVERRIDE_OPERATION_REGEXP(override, j), override_operation->operator))
 			{
 				zabbix_log(LOG_LEVEL_TRACE, "%s():FAIL", __func__);
 				continue;
@@ -981,7 +1311,7 @@ int	lld_validate_item_override_no_discover(const zbx_vector_lld_override_ptr_t *
 
 			if (ZBX_LLD_OVERRIDE_OP_OBJECT_ITEM == override_operation->operationtype &&
 					SUCCEED == regexp_strmatch_condition(name, override_operation->value,
-					override_operation->operator))
+					LLD_OVERRIDE_OPERATION_REGEXP(override, j), override_operation->operator))
 			{
 				return ZBX_PROTOTYPE_NO_DISCOVER == override_operation->discover ? FAIL : SUCCEED;
 			}
@@ -991,6 +1321,8 @@ int	lld_validate_item_override_no_discover(const zbx_vector_lld_override_ptr_t *
 	return ZBX_PROTOTYPE_NO_DISCOVER == override_default ? FAIL : SUCCEED;
 }
 
+#undef LLD_OVERRIDE_OPERATION_REGEXP
+
 static int	lld_rows_get(const char *value, zbx_lld_filter_t *filter, zbx_vector_lld_row_ptr_t *lld_rows,
 		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, const zbx_vector_lld_override_ptr_t *overrides,
 		char **info, char **error)
@@ -999,9 +1331,12 @@ static int	lld_rows_get(const char *value, zbx_lld_filter_t *filter, zbx_vector_
 	const char		*p;
 	zbx_lld_row_t		*lld_row;
 	int			ret = FAIL;
+	lld_row_macros_t	row_macros;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	lld_row_macros_init(&row_macros);
+
 	if (SUCCEED != zbx_json_open(value, &jp))
 	{
 		*error = zbx_dsprintf(*error, "Invalid discovery rule value: %s", zbx_json_strerror());
@@ -1019,13 +1354,24 @@ static int	lld_rows_get(const char *value, zbx_lld_filter_t *filter, zbx_vector_
 		goto out;
 	}
 
+	/* prepare filters once, so that every macro is extracted from row only once */
+	/* regardless of how many rule and override conditions are referring to it  */
+	lld_filter_compile(filter, &row_macros);
+
+	for (int i = 0; i < overrides->values_num; i++)
+		lld_filter_compile(&overrides->values[i]->filter, &row_macros);
+
+	lld_row_macros_prepare(&row_macros);
+
 	p = NULL;
 	while (NULL != (p = zbx_json_next(&jp_array, p)))
 	{
 		if (FAIL == zbx_json_brackets_open(p, &jp_row))
 			continue;
 
-		if (SUCCEED != filter_evaluate(filter, &jp_row, lld_macro_paths, info))
+		lld_row_macros_reset(&row_macros);
+
+		if (SUCCEED != filter_evaluate(filter, &row_macros, &jp_row, lld_macro_paths, info))
 			continue;
 
 		lld_row = (zbx_lld_row_t *)zbx_malloc(NULL, sizeof(zbx_lld_row_t));
@@ -1041,7 +1387,7 @@ static int	lld_rows_get(const char *value, zbx_lld_filter_t *filter, zbx_vector_
 		{
 			zbx_lld_override_t	*override = overrides->values[i];
 
-			if (SUCCEED != filter_evaluate(&override->filter, &jp_row, lld_macro_paths, info))
+			if (SUCCEED != filter_evaluate(&override->filter, &row_macros, &jp_row, lld_macro_paths, info))
 				continue;
 
 			zbx_vector_lld_override_ptr_append(&lld_row->overrides, override);
@@ -1055,6 +1401,8 @@ static int	lld_rows_get(const char *value, zbx_lld_filter_t *filter, zbx_vector_
 
 	ret = SUCCEED;
 out:
+	lld_row_macros_destroy(&row_macros);
+
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE))
 	{
 		for (int i = 0; i < lld_rows->values_num; i++)
@@ -1091,18 +1439,163 @@ static void	lld_row_free(zbx_lld_row_t *lld_row)
 	zbx_free(lld_row);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates 64-bit hash of data chained with the previous hash     *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lld_hash64(const void *data, size_t len, zbx_uint64_t hash)
+{
+	return (zbx_uint64_t)zbx_hash_modfnv(data, len, (zbx_hash_t)hash) << 32 |
+			zbx_hash_modfnv(data, len, (zbx_hash_t)(hash >> 32) ^ 0x9e3779b9);
+}
+
+static zbx_uint64_t	lld_hash64_str(const char *str, zbx_uint64_t hash)
+{
+	if (NULL == str)
+		str = "";
+
+	/* include terminating zero to separate adjacent strings */
+	return lld_hash64(str, strlen(str) + 1, hash);
+}
+
+static zbx_uint64_t	lld_filter_hash(const zbx_lld_filter_t *filter, zbx_uint64_t hash)
+{
+	hash = lld_hash64(&filter->evaltype, sizeof(filter->evaltype), hash);
+	hash = lld_hash64_str(filter->expression, hash);
+
+	for (int i = 0; i < filter->conditions.values_num; i++)
+	{
+		const lld_condition_t	*condition = filter->conditions.values[i];
+
+		hash = lld_hash64(&condition->id, sizeof(condition->id), hash);
+		hash = lld_hash64_str(condition->macro, hash);
+		hash = lld_hash64_str(condition->regexp, hash);
+		hash = lld_hash64(&condition->op, sizeof(condition->op), hash);
+	}
+
+	return hash;
+}
+
+static zbx_uint64_t	lld_lifetime_hash(const zbx_lld_lifetime_t *lifetime, zbx_uint64_t hash)
+{
+	hash = lld_hash64(&lifetime->type, sizeof(lifetime->type), hash);
+
+	/* duration is set only for 'after' lifetime type */
+	if (ZBX_LLD_LIFETIME_TYPE_AFTER == lifetime->type)
+		hash = lld_hash64(&lifetime->duration, sizeof(lifetime->duration), hash);
+
+	return hash;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates hash of LLD row which does not depend on the order of  *
+ *          its fields                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lld_row_hash(const struct zbx_json_parse *jp_row)
+{
+	const char	*p, *next, *end;
+	zbx_uint64_t	hash = 0;
+
+	for (p = zbx_json_next(jp_row, NULL); NULL != p; p = next)
+	{
+		end = (NULL == (next = zbx_json_next(jp_row, p)) ? jp_row->end : next);
+
+		while (end > p && (',' == end[-1] || 0 != isspace((unsigned char)end[-1])))
+			end--;
+
+		/* field hashes are summed, so the same fields in any order give the same row hash */
+		hash += lld_hash64(p, (size_t)(end - p), 0);
+	}
+
+	return hash;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates fingerprint of filtered LLD rows and the discovery     *
+ *          rule settings they were produced with                             *
+ *                                                                            *
+ * Comments: Row hashes are sorted before being combined, so reordering of    *
+ *           rows or their fields does not change the fingerprint.            *
+ *           Zero fingerprint is reserved for 'unknown'.                      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lld_rows_fingerprint(const zbx_vector_lld_row_ptr_t *lld_rows, const zbx_lld_filter_t *filter,
+		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, const zbx_vector_lld_override_ptr_t *overrides,
+		const zbx_lld_lifetime_t *lifetime, const zbx_lld_lifetime_t *enabled_lifetime)
+{
+	zbx_uint64_t		hash;
+	zbx_vector_uint64_t	row_hashes;
+
+	hash = lld_filter_hash(filter, 0);
+
+	for (int i = 0; i < lld_macro_paths->values_num; i++)
+	{
+		hash = lld_hash64_str(lld_macro_paths->values[i]->lld_macro, hash);
+		hash = lld_hash64_str(lld_macro_paths->values[i]->path, hash);
+	}
+
+	for (int i = 0; i < overrides->values_num; i++)
+	{
+		const zbx_lld_override_t	*override = overrides->values[i];
+
+		hash = lld_hash64(&override->overrideid, sizeof(override->overrideid), hash);
+		hash = lld_hash64(&override->step, sizeof(override->step), hash);
+		hash = lld_hash64(&override->stop, sizeof(override->stop), hash);
+		hash = lld_filter_hash(&override->filter, hash);
+	}
+
+	hash = lld_lifetime_hash(lifetime, hash);
+	hash = lld_lifetime_hash(enabled_lifetime, hash);
+
+	zbx_vector_uint64_create(&row_hashes);
+	zbx_vector_uint64_reserve(&row_hashes, (size_t)lld_rows->values_num);
+
+	for (int i = 0; i < lld_rows->values_num; i++)
+		zbx_vector_uint64_append(&row_hashes, lld_row_hash(&lld_rows->values[i]->jp_row));
+
+	zbx_vector_uint64_sort(&row_hashes, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	hash = lld_hash64(&row_hashes.values_num, sizeof(row_hashes.values_num), hash);
+	hash = lld_hash64(row_hashes.values, sizeof(zbx_uint64_t) * (size_t)row_hashes.values_num, hash);
+
+	zbx_vector_uint64_destroy(&row_hashes);
+
+	return 0 != hash ? hash : 1;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: adds or updates items, triggers and graphs for discovery item     *
  *                                                                            *
- * Parameters: lld_ruleid - [IN] discovery rule id from database              *
- *             value      - [IN] received value from agent                    *
- *             error      - [OUT] Error or informational message. Will be set *
- *                               to empty string on successful discovery      *
- *                               without additional information.              *
+ * Parameters: lld_ruleid  - [IN] discovery rule id from database             *
+ *             value       - [IN] received value from agent                   *
+ *             mode        - [IN] value processing mode (ZBX_LLD_PROCESS_*)   *
+ *             lastcheck   - [IN] lastcheck of objects discovered by value    *
+ *                                partitions (not used for the whole value)   *
+ *             fingerprint - [IN/OUT] fingerprint of the last processed value *
+ *                                    (0 if unknown), set to fingerprint of   *
+ *                                    this value or 0 on failure              *
+ *             error       - [OUT] Error or informational message. Will be    *
+ *                                 set to empty string on successful          *
+ *                                 discovery without additional information.  *
+ *                                                                            *
+ * Comments: If the value fingerprint matches the last processed one, rows    *
+ *           are not reconciled with database and error is left unchanged.    *
+ *                                                                            *
+ *           Value partitions add or update only discovered items, triggers   *
+ *           and graphs, as objects discovered by other partitions would be   *
+ *           considered lost. Hosts share host groups between rows and are    *
+ *           processed by the merge pass over the whole value, which also     *
+ *           processes lost items, triggers and graphs not checked by any     *
+ *           partition since lastcheck.                                       *
  *                                                                            *
  ******************************************************************************/
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error)
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, unsigned char mode, int lastcheck,
+		zbx_uint64_t *fingerprint, char **error)
 {
 #define LIFETIME_DURATION_GET(lt, lt_str)									\
 	do													\
@@ -1129,7 +1622,7 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	zbx_db_result_t			result;
 	zbx_db_row_t			row;
-	zbx_uint64_t			hostid;
+	zbx_uint64_t			hostid, fingerprint_new;
 	char				*discovery_key = NULL, *info = NULL;
 	int				errcode, ret = SUCCEED;
 	zbx_vector_lld_macro_path_ptr_t	lld_macro_paths;
@@ -1140,13 +1633,19 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 	zbx_config_t			cfg;
 	zbx_dc_um_handle_t		*um_handle;
 	zbx_vector_lld_override_ptr_t	overrides;
-	zbx_vector_lld_row_ptr_t	lld_rows;
+	zbx_vector_lld_row_ptr_t	lld_rows, merge_rows, *object_rows;
+	zbx_uint64_t			last_fingerprint = *fingerprint;
+	zbx_lld_lifetime_t		*plifetime;
+	int				discovered_since;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " mode:%d", __func__, lld_ruleid, (int)mode);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64, __func__, lld_ruleid);
+	*fingerprint = 0;
 
 	um_handle = zbx_dc_open_user_macros();
 
 	zbx_vector_lld_row_ptr_create(&lld_rows);
+	zbx_vector_lld_row_ptr_create(&merge_rows);
 	zbx_vector_lld_macro_path_ptr_create(&lld_macro_paths);
 	zbx_vector_lld_override_ptr_create(&overrides);
 
@@ -1209,42 +1708,77 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 		goto out;
 	}
 
+	if (last_fingerprint == (fingerprint_new = lld_rows_fingerprint(&lld_rows, &filter, &lld_macro_paths,
+			&overrides, &lifetime, &enabled_lifetime)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "skipping unchanged value of discovery rule \"%s:%s\"",
+				zbx_host_string(hostid), discovery_key);
+		*fingerprint = fingerprint_new;
+		goto out;
+	}
+
 	*error = zbx_strdup(*error, "");
 
-	now = time(NULL);
+	plifetime = &lifetime;
+	object_rows = &lld_rows;
+	discovered_since = 0;
+
+	switch (mode)
+	{
+		case ZBX_LLD_PROCESS_PARTITION:
+			now = lastcheck;
+			plifetime = NULL;
+
+			/* partition is failed if it was not completed, otherwise its objects would be lost */
+			ret = FAIL;
+			break;
+		case ZBX_LLD_PROCESS_MERGE:
+			now = time(NULL);
+			object_rows = &merge_rows;
+			discovered_since = lastcheck;
+			break;
+		default:
+			now = time(NULL);
+	}
 
 	zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_AUDITLOG_ENABLED | ZBX_CONFIG_FLAGS_AUDITLOG_MODE);
 	zbx_audit_init(cfg.auditlog_enabled, cfg.auditlog_mode, ZBX_AUDIT_LLD_CONTEXT);
 
-	if (SUCCEED != lld_update_items(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, &lifetime,
-			&enabled_lifetime, now))
+	if (SUCCEED != lld_update_items(hostid, lld_ruleid, object_rows, &lld_macro_paths, error, plifetime,
+			&enabled_lifetime, now, discovered_since))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add items because parent host was removed while"
 				" processing lld rule");
 		goto out;
 	}
 
-	lld_item_links_sort(&lld_rows);
+	lld_item_links_sort(object_rows);
 
-	if (SUCCEED != lld_update_triggers(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, &lifetime,
-			&enabled_lifetime, now))
+	if (SUCCEED != lld_update_triggers(hostid, lld_ruleid, object_rows, &lld_macro_paths, error, plifetime,
+			&enabled_lifetime, now, discovered_since))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add triggers because parent host was removed while"
 				" processing lld rule");
 		goto out;
 	}
 
-	if (SUCCEED != lld_update_graphs(hostid, lld_ruleid, &lld_rows, &lld_macro_paths, error, &lifetime, now))
+	if (SUCCEED != lld_update_graphs(hostid, lld_ruleid, object_rows, &lld_macro_paths, error, plifetime, now,
+			discovered_since))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "cannot update/add graphs because parent host was removed while"
 				" processing lld rule");
 		goto out;
 	}
 
-	lld_update_hosts(lld_ruleid, &lld_rows, &lld_macro_paths, error, &lifetime, &enabled_lifetime, now);
+	/* hosts share host groups between rows and are discovered serially */
+	if (ZBX_LLD_PROCESS_PARTITION != mode)
+		lld_update_hosts(lld_ruleid, &lld_rows, &lld_macro_paths, error, &lifetime, &enabled_lifetime, now);
+
+	ret = SUCCEED;
+	*fingerprint = fingerprint_new;
 
 	/* add informative warning to the error message about lack of data for macros used in filter */
-	if (NULL != info)
+	if (NULL != info && ZBX_LLD_PROCESS_PARTITION != mode)
 		*error = zbx_strdcat(*error, info);
 out:
 	zbx_audit_flush(ZBX_AUDIT_LLD_CONTEXT);
@@ -1258,6 +1792,7 @@ out:
 	zbx_vector_lld_override_ptr_destroy(&overrides);
 	zbx_vector_lld_row_ptr_clear_ext(&lld_rows, lld_row_free);
 	zbx_vector_lld_row_ptr_destroy(&lld_rows);
+	zbx_vector_lld_row_ptr_destroy(&merge_rows);
 	zbx_vector_lld_macro_path_ptr_clear_ext(&lld_macro_paths, zbx_lld_macro_path_free);
 	zbx_vector_lld_macro_path_ptr_destroy(&lld_macro_paths);
 
@@ -52,18 +52,33 @@ typedef struct
 	char			*macro;
 	char			*regexp;
 	zbx_vector_expression_t	regexps;
+	zbx_regexp_t		*regexp_compiled;	/* precompiled non-global regular expression */
+	int			macro_index;		/* index of macro value in filter row cache */
 	unsigned char		op;
 }
 lld_condition_t;
 
 ZBX_PTR_VECTOR_DECL(lld_condition_ptr, lld_condition_t*)
 
+/* reference to filter condition in custom filter expression */
+typedef struct
+{
+	size_t	offset;		/* offset of {<condition id>} in expression */
+	size_t	len;		/* length of {<condition id>} */
+	int	index;		/* index of referenced condition */
+}
+lld_condition_ref_t;
+
+ZBX_VECTOR_DECL(lld_condition_ref, lld_condition_ref_t)
+
 /* lld rule filter */
 typedef struct
 {
 	zbx_vector_lld_condition_ptr_t	conditions;
 	char				*expression;
 	int				evaltype;
+	zbx_vector_lld_condition_ref_t	condition_refs;	/* condition references in custom expression, */
+							/* sorted by offset                           */
 }
 zbx_lld_filter_t;
 
@@ -98,6 +113,8 @@ typedef struct
 	zbx_uint64_t				overrideid;
 	zbx_lld_filter_t			filter;
 	zbx_vector_lld_override_operation_t	override_operations;
+	zbx_regexp_t				**operation_regexps;	/* precompiled regular expressions */
+									/* of override_operations          */
 	int					step;
 	unsigned char				stop;
 }
@@ -364,17 +381,18 @@ int	lld_validate_item_override_no_discover(const zbx_vector_lld_override_ptr_t *
 
 int	lld_update_items(zbx_uint64_t hostid, zbx_uint64_t lld_ruleid, zbx_vector_lld_row_ptr_t *lld_rows,
 		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, char **error,
-		const zbx_lld_lifetime_t *lifetime, const zbx_lld_lifetime_t *enabled_lifetime, int lastcheck);
+		const zbx_lld_lifetime_t *lifetime, const zbx_lld_lifetime_t *enabled_lifetime, int lastcheck,
+		int discovered_since);
 
 void	lld_item_links_sort(zbx_vector_lld_row_ptr_t *lld_rows);
 
 int	lld_update_triggers(zbx_uint64_t hostid, zbx_uint64_t lld_ruleid, const zbx_vector_lld_row_ptr_t *lld_rows,
 		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, char **error, zbx_lld_lifetime_t *lifetime,
-		zbx_lld_lifetime_t *enabled_lifetime, int lastcheck);
+		zbx_lld_lifetime_t *enabled_lifetime, int lastcheck, int discovered_since);
 
 int	lld_update_graphs(zbx_uint64_t hostid, zbx_uint64_t lld_ruleid, const zbx_vector_lld_row_ptr_t *lld_rows,
 		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, char **error,
-		const zbx_lld_lifetime_t *lifetime, int lastcheck);
+		const zbx_lld_lifetime_t *lifetime, int lastcheck, int discovered_since);
 
 void	lld_update_hosts(zbx_uint64_t lld_ruleid, const zbx_vector_lld_row_ptr_t *lld_rows,
 		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, char **error, zbx_lld_lifetime_t *lifetime,
@@ -391,12 +409,19 @@ typedef void	(*object_audit_entry_create_f)(int audit_context_mode, int audit_ac
 typedef void	(*object_audit_entry_update_status_f)(int audit_context_mode, zbx_uint64_t objectid, int flags,
 		int status_old, int status_new);
 typedef int	(get_object_status_val)(int status);
+int	lld_object_is_lost(int discovery_flag, int object_lastcheck, int discovered_since);
 void	lld_process_lost_objects(const char *table, const char *table_obj, const char *id_name,
 		zbx_vector_ptr_t *objects, const zbx_lld_lifetime_t *lifetime,
-		const zbx_lld_lifetime_t *enabled_lifetime, int lastcheck, delete_ids_f cb, get_object_info_f cb_info,
-		get_object_status_val cb_status, object_audit_entry_create_f cb_audit_create,
+		const zbx_lld_lifetime_t *enabled_lifetime, int lastcheck, int discovered_since, delete_ids_f cb,
+		get_object_info_f cb_info, get_object_status_val cb_status, object_audit_entry_create_f cb_audit_create,
 		object_audit_entry_update_status_f cb_audit_update_status);
 
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error);
+/* LLD value processing modes, see lld_manager.c for value partitioning */
+#define ZBX_LLD_PROCESS_VALUE		0	/* the whole value */
+#define ZBX_LLD_PROCESS_PARTITION	1	/* value partition - discovered items, triggers and graphs */
+#define ZBX_LLD_PROCESS_MERGE		2	/* the whole value after partitions - hosts and lost objects */
+
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, unsigned char mode, int lastcheck,
+		zbx_uint64_t *fingerprint, char **error);
 
 #endif
@@ -120,15 +120,46 @@ static void	lld_prepare_object_delete(zbx_uint64_t id, const char *name, zbx_vec
 	cb_audit_create(ZBX_AUDIT_LLD_CONTEXT, ZBX_AUDIT_ACTION_DELETE, id, name, (int)ZBX_FLAG_DISCOVERY_CREATED);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if discovered object is lost                               *
+ *                                                                            *
+ * Parameters: discovery_flag   - [IN] non zero if object was discovered by   *
+ *                                     the processed rows                     *
+ *             object_lastcheck - [IN] last time object was discovered        *
+ *             discovered_since - [IN] objects with lastcheck not older than  *
+ *                                     this were discovered by value          *
+ *                                     partitions, 0 if value is processed    *
+ *                                     as a whole                             *
+ *                                                                            *
+ * Return value: SUCCEED - object is lost                                     *
+ *               FAIL    - object was discovered                              *
+ *                                                                            *
+ ******************************************************************************/
+int	lld_object_is_lost(int discovery_flag, int object_lastcheck, int discovered_since)
+{
+	if (0 != discovery_flag)
+		return FAIL;
+
+	if (0 != discovered_since && object_lastcheck >= discovered_since)
+		return FAIL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes lost resources                                          *
  *                                                                            *
+ * Comments: Only discovered objects are updated if lifetime is not set.      *
+ *           Objects with lastcheck not older than discovered_since (if set)  *
+ *           were discovered by value partitions and are not lost.            *
+ *                                                                            *
  ******************************************************************************/
 void	lld_process_lost_objects(const char *table, const char *table_obj, const char *id_name,
 		zbx_vector_ptr_t *objects, const zbx_lld_lifetime_t *lifetime,
-		const zbx_lld_lifetime_t *enabled_lifetime, int lastcheck, delete_ids_f cb, get_object_info_f cb_info,
-		get_object_status_val cb_status, object_audit_entry_create_f cb_audit_create,
+		const zbx_lld_lifetime_t *enabled_lifetime, int lastcheck, int discovered_since, delete_ids_f cb,
+		get_object_info_f cb_info, get_object_status_val cb_status, object_audit_entry_create_f cb_audit_create,
 		object_audit_entry_update_status_f cb_audit_update_status)
 {
 	char				*sql = NULL;
@@ -195,6 +226,12 @@ void	lld_process_lost_objects(const char *table, const char *table_obj, const ch
 			continue;
 		}
 
+		if (NULL == lifetime ||
+				SUCCEED != lld_object_is_lost(discovery_flag, object_lastcheck, discovered_since))
+		{
+			continue;
+		}
+
 		ts = lld_get_lifetime_ts(object_lastcheck, lifetime);
 
 		if (SUCCEED == lld_check_lifetime_elapsed(lastcheck, ts))
@@ -1491,7 +1491,7 @@ static	void	get_graph_info(const void *object, zbx_uint64_t *id, int *discovery_
  ******************************************************************************/
 int	lld_update_graphs(zbx_uint64_t hostid, zbx_uint64_t lld_ruleid, const zbx_vector_lld_row_ptr_t *lld_rows,
 		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, char **error,
-		const zbx_lld_lifetime_t *lifetime, int lastcheck)
+		const zbx_lld_lifetime_t *lifetime, int lastcheck, int discovered_since)
 {
 	int				ret = SUCCEED;
 	zbx_db_result_t			result;
@@ -1561,7 +1561,7 @@ int	lld_update_graphs(zbx_uint64_t hostid, zbx_uint64_t lld_ruleid, const zbx_ve
 				show_work_period, show_triggers, graphtype, show_legend, show_3d, percent_left,
 				percent_right, ymin_type, ymax_type);
 		lld_process_lost_objects("graph_discovery", NULL, "graphid", (zbx_vector_ptr_t *)&graphs, lifetime,
-				NULL, lastcheck, zbx_db_delete_graphs, get_graph_info, NULL,
+				NULL, lastcheck, discovered_since, zbx_db_delete_graphs, get_graph_info, NULL,
 				zbx_audit_graph_create_entry, NULL);
 
 		lld_items_free(&items);
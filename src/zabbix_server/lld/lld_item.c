@@ -4511,7 +4511,8 @@ static void	lld_link_dependent_items(zbx_vector_lld_item_full_ptr_t *items, zbx_
  ******************************************************************************/
 int	lld_update_items(zbx_uint64_t hostid, zbx_uint64_t lld_ruleid, zbx_vector_lld_row_ptr_t *lld_rows,
 		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, char **error,
-		const zbx_lld_lifetime_t *lifetime, const zbx_lld_lifetime_t *enabled_lifetime, int lastcheck)
+		const zbx_lld_lifetime_t *lifetime, const zbx_lld_lifetime_t *enabled_lifetime, int lastcheck,
+		int discovered_since)
 {
 	zbx_vector_lld_item_prototype_ptr_t	item_prototypes;
 	zbx_vector_item_dependence_ptr_t	item_dependencies;
@@ -4568,8 +4569,8 @@ int	lld_update_items(zbx_uint64_t hostid, zbx_uint64_t lld_ruleid, zbx_vector_ll
 	lld_item_links_populate(&item_prototypes, lld_rows, &items_index);
 
 	lld_process_lost_objects("item_discovery", "items", "itemid", (zbx_vector_ptr_t *)&items, lifetime,
-			enabled_lifetime, lastcheck, zbx_db_delete_items, get_item_info, get_item_status_value,
-			zbx_audit_item_create_entry, zbx_audit_item_update_json_update_status);
+			enabled_lifetime, lastcheck, discovered_since, zbx_db_delete_items, get_item_info,
+			get_item_status_value, zbx_audit_item_create_entry, zbx_audit_item_update_json_update_status);
 clean:
 	zbx_hashset_destroy(&items_index);
 
@@ -24,6 +24,7 @@
 #include "zbxipcservice.h"
 #include "zbxstr.h"
 #include "zbxtime.h"
+#include "zbxjson.h"
 
 /*
  * The LLD queue is organized as a queue (rule_queue binary heap) of LLD rules,
@@ -38,15 +39,44 @@
  * values in the list the rule is removed from the index (rule_index hashset),
  * otherwise the rule is enqueued back in LLD queue.
  *
+ * When skipping of unchanged values is enabled, the manager also remembers
+ * fingerprints of the last fully processed rule values. The fingerprint is sent
+ * together with the value and worker skips reconciliation of discovered objects
+ * if the new value has the same fingerprint. Fingerprints older than the skip
+ * period are not sent, forcing full processing at least once per period.
+ *
+ * When partitioning is enabled, rows of a large value can be split between the
+ * current and free workers. Partitions concurrently add or update discovered
+ * items, triggers and graphs, setting their lastcheck to the partitioning time.
+ * After all partitions are finished the whole value is sent as a merge request,
+ * which serially processes discovered hosts (sharing host groups between rows)
+ * and lost items, triggers and graphs - the ones with older lastcheck. If any
+ * partition fails, the whole value is processed as a normal request instead.
+ *
  */
 
 typedef struct
 {
 	zbx_ipc_client_t	*client;
 	zbx_lld_rule_t		*rule;
+
+	/* the fingerprint sent with the value being processed */
+	zbx_uint64_t		fingerprint;
+
+	/* 1 if worker is processing partition of the value */
+	unsigned char		partition;
 }
 zbx_lld_worker_t;
 
+/* fingerprint of the last fully processed LLD rule value */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	fingerprint;
+	int		lastcheck;
+}
+zbx_lld_fingerprint_t;
+
 ZBX_PTR_VECTOR_DECL(lld_worker_ptr, zbx_lld_worker_t*)
 ZBX_PTR_VECTOR_IMPL(lld_worker_ptr, zbx_lld_worker_t*)
 
@@ -73,6 +103,14 @@ typedef struct
 	/* the number of queued LLD rules */
 	zbx_uint64_t			queued_num;
 
+	/* fingerprints of the last fully processed values, indexed by LLD rule id */
+	zbx_hashset_t			fingerprints;
+
+	/* period during which unchanged values are not reprocessed, 0 - disabled */
+	int				skip_period;
+
+	/* minimum number of rows in value partition, 0 - disabled */
+	int				partition_size;
 }
 zbx_lld_manager_t;
 
@@ -125,11 +163,14 @@ static void	lld_rule_clear(zbx_lld_rule_t *rule)
 		rule->head = data->next;
 		lld_data_free(data);
 	}
+
+	zbx_free(rule->partitions_error);
 }
 
 ZBX_PTR_VECTOR_IMPL(lld_rule_info_ptr, zbx_lld_rule_info_t*)
 
-static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f get_config_forks_cb)
+static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f get_config_forks_cb,
+		int skip_period, int partition_size)
 {
 	zbx_lld_worker_t	*worker;
 
@@ -144,6 +185,10 @@ static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f
 			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
 
 	zbx_binary_heap_create(&manager->rule_queue, rule_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
+	zbx_hashset_create(&manager->fingerprints, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	manager->skip_period = skip_period;
+	manager->partition_size = partition_size;
 
 	manager->next_worker_index = 0;
 
@@ -152,6 +197,8 @@ static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f
 		worker = (zbx_lld_worker_t *)zbx_malloc(NULL, sizeof(zbx_lld_worker_t));
 
 		worker->client = NULL;
+		worker->rule = NULL;
+		worker->partition = 0;
 
 		zbx_vector_lld_worker_ptr_append(&manager->workers, worker);
 	}
@@ -254,7 +301,7 @@ static void	lld_queue_rule(zbx_lld_manager_t *manager, zbx_lld_rule_t *rule)
  ******************************************************************************/
 static void	lld_queue_request(zbx_lld_manager_t *manager, const zbx_ipc_message_t *message)
 {
-	zbx_uint64_t	hostid;
+	zbx_uint64_t	hostid, fingerprint;
 	zbx_lld_rule_t	*rule;
 	zbx_lld_data_t	*data;
 
@@ -263,8 +310,8 @@ static void	lld_queue_request(zbx_lld_manager_t *manager, const zbx_ipc_message_
 	data = (zbx_lld_data_t *)zbx_malloc(NULL, sizeof(zbx_lld_data_t));
 	data->next = NULL;
 
-	zbx_lld_deserialize_item_value(message->data, &data->itemid, &hostid, &data->value, &data->ts, &data->meta,
-			&data->lastlogsize, &data->mtime, &data->error);
+	zbx_lld_deserialize_item_value(message->data, &data->itemid, &hostid, &fingerprint, &data->value, &data->ts,
+			&data->meta, &data->lastlogsize, &data->mtime, &data->error);
 
 	if (NULL == (rule = zbx_hashset_search(&manager->rule_index, &hostid)))
 	{
@@ -312,6 +359,191 @@ out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends LLD rule value to worker                                    *
+ *                                                                            *
+ * Parameters: worker - [IN] target worker                                    *
+ *             code   - [IN] message code                                     *
+ *             data   - [IN] queued value                                     *
+ *             value  - [IN] value or its partition to send                   *
+ *                                                                            *
+ * Comments: Partition and merge requests are sent with partition processing  *
+ *           data of the worker's rule.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_send_value(zbx_lld_worker_t *worker, zbx_uint32_t code, const zbx_lld_data_t *data,
+		const char *value)
+{
+	unsigned char	*buf, *value_buf;
+	zbx_uint32_t	buf_len;
+
+	buf_len = zbx_lld_serialize_item_value(&buf, data->itemid, 0, worker->fingerprint, value, &data->ts,
+			data->meta, data->lastlogsize, data->mtime, data->error);
+
+	if (ZBX_IPC_LLD_TASK != code)
+	{
+		value_buf = buf;
+		buf_len = zbx_lld_serialize_partition(&buf, worker->rule->partitions_lastcheck,
+				worker->rule->partitions_error, value_buf, buf_len);
+		zbx_free(value_buf);
+	}
+
+	zbx_ipc_client_send(worker->client, code, buf, buf_len);
+	zbx_free(buf);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: splits LLD value rows into partitions                             *
+ *                                                                            *
+ * Parameters: value          - [IN] LLD rule value                           *
+ *             partition_size - [IN] minimum number of rows in partition      *
+ *             max_num        - [IN] maximum number of partitions             *
+ *             partitions     - [OUT] partition values (JSON arrays)          *
+ *                                                                            *
+ * Return value: SUCCEED - value was split into at least two partitions       *
+ *               FAIL    - value is too small or cannot be parsed             *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_value_split(const char *value, int partition_size, int max_num, zbx_vector_str_t *partitions)
+{
+	struct zbx_json_parse	jp, jp_array;
+	const char		*p, *next, *end;
+	char			*partition = NULL;
+	size_t			partition_alloc = 0, partition_offset = 0;
+	int			rows_num, partition_rows, rows = 0;
+
+	if (SUCCEED != zbx_json_open(value, &jp))
+		return FAIL;
+
+	if ('[' == *jp.start)
+		jp_array = jp;
+	else if (SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_array))
+		return FAIL;
+
+	rows_num = zbx_json_count(&jp_array);
+
+	if (2 > (max_num = MIN(max_num, rows_num / partition_size)))
+		return FAIL;
+
+	partition_rows = (rows_num + max_num - 1) / max_num;
+
+	for (p = zbx_json_next(&jp_array, NULL); NULL != p; p = next)
+	{
+		end = (NULL == (next = zbx_json_next(&jp_array, p)) ? jp_array.end : next);
+
+		while (end > p && (',' == end[-1] || 0 != isspace((unsigned char)end[-1])))
+			end--;
+
+		zbx_chrcpy_alloc(&partition, &partition_alloc, &partition_offset, 0 == rows ? '[' : ',');
+		zbx_strncpy_alloc(&partition, &partition_alloc, &partition_offset, p, (size_t)(end - p));
+
+		if (++rows == partition_rows || NULL == next)
+		{
+			zbx_chrcpy_alloc(&partition, &partition_alloc, &partition_offset, ']');
+			zbx_vector_str_append(partitions, partition);
+
+			partition = NULL;
+			partition_alloc = partition_offset = 0;
+			rows = 0;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends partitions of LLD rule value to the worker and free workers *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             worker  - [IN] target worker                                   *
+ *                                                                            *
+ * Return value: SUCCEED - value partitions were sent                         *
+ *               FAIL    - value must be processed as a whole                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_process_partitions(zbx_lld_manager_t *manager, zbx_lld_worker_t *worker)
+{
+	zbx_lld_rule_t		*rule = worker->rule;
+	zbx_lld_data_t		*data = rule->head;
+	zbx_vector_str_t	partitions;
+	int			ret = FAIL;
+
+	if (0 == manager->partition_size || 0 != worker->fingerprint || NULL != data->error || NULL == data->value ||
+			SUCCEED == zbx_queue_ptr_empty(&manager->free_workers))
+	{
+		return FAIL;
+	}
+
+	zbx_vector_str_create(&partitions);
+
+	if (SUCCEED != lld_value_split(data->value, manager->partition_size,
+			zbx_queue_ptr_values_num(&manager->free_workers) + 1, &partitions))
+	{
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "processing discovery rule:" ZBX_FS_UI64 " in %d partitions", data->itemid,
+			partitions.values_num);
+
+	rule->partitions_num = partitions.values_num;
+	rule->partitions_lastcheck = (int)time(NULL);
+	rule->partitions_failed = 0;
+
+	for (int i = 0; i < partitions.values_num; i++)
+	{
+		zbx_lld_worker_t	*partition_worker;
+
+		if (0 == i)
+			partition_worker = worker;
+		else
+			partition_worker = (zbx_lld_worker_t *)zbx_queue_ptr_pop(&manager->free_workers);
+
+		partition_worker->rule = rule;
+		partition_worker->fingerprint = 0;
+		partition_worker->partition = 1;
+
+		lld_send_value(partition_worker, ZBX_IPC_LLD_PARTITION, data, partitions.values[i]);
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_vector_str_clear_ext(&partitions, zbx_str_free);
+	zbx_vector_str_destroy(&partitions);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets fingerprint of the last fully processed LLD rule value       *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             itemid  - [IN] LLD rule id                                     *
+ *             now     - [IN] current timestamp                               *
+ *                                                                            *
+ * Return value: fingerprint to send with the next value or 0 if the value    *
+ *               must be fully processed                                      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	lld_get_fingerprint(const zbx_lld_manager_t *manager, zbx_uint64_t itemid, int now)
+{
+	const zbx_lld_fingerprint_t	*fp;
+
+	if (0 == manager->skip_period)
+		return 0;
+
+	if (NULL == (fp = (const zbx_lld_fingerprint_t *)zbx_hashset_search(&manager->fingerprints, &itemid)) ||
+			now - fp->lastcheck >= manager->skip_period)
+	{
+		return 0;
+	}
+
+	return fp->fingerprint;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes next LLD request from queue                             *
@@ -323,8 +555,6 @@ out:
 static void	lld_process_next_request(zbx_lld_manager_t *manager, zbx_lld_worker_t *worker)
 {
 	zbx_binary_heap_elem_t	*elem;
-	unsigned char		*buf;
-	zbx_uint32_t		buf_len;
 	zbx_lld_data_t		*data;
 
 	elem = zbx_binary_heap_find_min(&manager->rule_queue);
@@ -332,10 +562,11 @@ static void	lld_process_next_request(zbx_lld_manager_t *manager, zbx_lld_worker_
 	zbx_binary_heap_remove_min(&manager->rule_queue);
 
 	data = worker->rule->head;
-	buf_len = zbx_lld_serialize_item_value(&buf, data->itemid, 0, data->value, &data->ts, data->meta,
-			data->lastlogsize, data->mtime, data->error);
-	zbx_ipc_client_send(worker->client, ZBX_IPC_LLD_TASK, buf, buf_len);
-	zbx_free(buf);
+	worker->fingerprint = lld_get_fingerprint(manager, data->itemid, (int)time(NULL));
+	worker->partition = 0;
+
+	if (SUCCEED != lld_process_partitions(manager, worker))
+		lld_send_value(worker, ZBX_IPC_LLD_TASK, data, data->value);
 }
 
 /******************************************************************************
@@ -356,15 +587,135 @@ static void	lld_process_queue(zbx_lld_manager_t *manager)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: updates fingerprint of the last fully processed LLD rule value    *
+ *                                                                            *
+ * Parameters: manager     - [IN]                                             *
+ *             itemid      - [IN] LLD rule id                                 *
+ *             fingerprint - [IN] fingerprint returned by worker              *
+ *             sent        - [IN] fingerprint sent to worker                  *
+ *             now         - [IN] current timestamp                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_update_fingerprint(zbx_lld_manager_t *manager, zbx_uint64_t itemid, zbx_uint64_t fingerprint,
+		zbx_uint64_t sent, int now)
+{
+	zbx_lld_fingerprint_t	*fp;
+
+	if (0 == fingerprint)
+	{
+		zbx_hashset_remove(&manager->fingerprints, &itemid);
+		return;
+	}
+
+	/* the same fingerprint is returned when processing was skipped */
+	if (fingerprint == sent)
+		return;
+
+	if (NULL == (fp = (zbx_lld_fingerprint_t *)zbx_hashset_search(&manager->fingerprints, &itemid)))
+	{
+		zbx_lld_fingerprint_t	fp_local = {.itemid = itemid};
+
+		fp = (zbx_lld_fingerprint_t *)zbx_hashset_insert(&manager->fingerprints, &fp_local, sizeof(fp_local));
+	}
+
+	fp->fingerprint = fingerprint;
+	fp->lastcheck = now;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes fingerprints that are too old to be used                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_flush_fingerprints(zbx_lld_manager_t *manager, int now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_lld_fingerprint_t	*fp;
+
+	zbx_hashset_iter_reset(&manager->fingerprints, &iter);
+
+	while (NULL != (fp = (zbx_lld_fingerprint_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (now - fp->lastcheck >= manager->skip_period)
+			zbx_hashset_iter_remove(&iter);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes LLD worker 'done' response for value partition          *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             worker  - [IN] worker that processed the partition             *
+ *             message - [IN] message with partition result                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_process_partition_result(zbx_lld_manager_t *manager, zbx_lld_worker_t *worker,
+		const zbx_ipc_message_t *message)
+{
+	zbx_lld_rule_t	*rule = worker->rule;
+	int		result;
+	char		*error;
+
+	worker->rule = NULL;
+	worker->partition = 0;
+
+	zbx_lld_deserialize_partition_result(message->data, &result, &error);
+
+	if (SUCCEED != result)
+		rule->partitions_failed = 1;
+	else if (NULL != error)
+		rule->partitions_error = zbx_strdcat(rule->partitions_error, error);
+
+	zbx_free(error);
+
+	if (0 == --rule->partitions_num)
+	{
+		worker->rule = rule;
+		worker->fingerprint = 0;
+
+		if (0 == rule->partitions_failed)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "partitions of discovery rule:" ZBX_FS_UI64 " have been processed",
+					rule->head->itemid);
+
+			lld_send_value(worker, ZBX_IPC_LLD_MERGE, rule->head, rule->head->value);
+		}
+		else
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot process partitions of discovery rule:" ZBX_FS_UI64
+					", processing the whole value", rule->head->itemid);
+
+			lld_send_value(worker, ZBX_IPC_LLD_TASK, rule->head, rule->head->value);
+		}
+
+		zbx_free(rule->partitions_error);
+
+		return;
+	}
+
+	if (SUCCEED != zbx_binary_heap_empty(&manager->rule_queue))
+		lld_process_next_request(manager, worker);
+	else
+		zbx_queue_ptr_push(&manager->free_workers, worker);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes LLD worker 'done' response                              *
  *                                                                            *
  * Parameters: manager - [IN]                                                 *
  *             client  - [IN] worker's IPC client connection                  *
+ *             message - [IN] message with processed value fingerprint        *
+ *                                                                            *
+ * Return value: SUCCEED - LLD rule value has been processed                  *
+ *               FAIL    - value partition has been processed                 *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client)
+static int	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
 {
 	zbx_lld_worker_t	*worker;
 	zbx_lld_rule_t		*rule;
@@ -374,12 +725,29 @@ static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *cli
 
 	worker = lld_get_worker_by_client(manager, client);
 
+	if (0 != worker->partition)
+	{
+		lld_process_partition_result(manager, worker, message);
+		zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+		return FAIL;
+	}
+
 	zabbix_log(LOG_LEVEL_DEBUG, "discovery rule:" ZBX_FS_UI64 " has been processed", worker->rule->head->itemid);
 
 	rule = worker->rule;
 	worker->rule = NULL;
 
 	data = rule->head;
+
+	if (0 != manager->skip_period && sizeof(zbx_uint64_t) == message->size)
+	{
+		zbx_uint64_t	fingerprint;
+
+		memcpy(&fingerprint, message->data, sizeof(fingerprint));
+		lld_update_fingerprint(manager, data->itemid, fingerprint, worker->fingerprint, (int)time(NULL));
+	}
+
 	rule->head = rule->head->next;
 
 	if (NULL == rule->head)
@@ -401,6 +769,8 @@ static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *cli
 		zbx_queue_ptr_push(&manager->free_workers, worker);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return SUCCEED;
 }
 
 /******************************************************************************
@@ -513,7 +883,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 	char			*error = NULL;
 	zbx_ipc_client_t	*client;
 	zbx_ipc_message_t	*message;
-	double			time_stat, time_now, sec, time_idle = 0;
+	double			time_stat, time_now, sec, time_idle = 0, time_flush;
 	zbx_lld_manager_t	manager;
 	zbx_uint64_t		processed_num = 0;
 	zbx_timespec_t		timeout = {1, 0};
@@ -536,10 +906,12 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 		exit(EXIT_FAILURE);
 	}
 
-	lld_manager_init(&manager, args_in->get_process_forks_cb_arg);
+	lld_manager_init(&manager, args_in->get_process_forks_cb_arg, args_in->skip_unchanged_period,
+			args_in->partition_size);
 
 	/* initialize statistics */
 	time_stat = zbx_time();
+	time_flush = time_stat;
 
 	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
 
@@ -561,6 +933,12 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 			processed_num = 0;
 		}
 
+		if (0 != manager.skip_period && manager.skip_period < time_now - time_flush)
+		{
+			lld_flush_fingerprints(&manager, (int)time_now);
+			time_flush = time_now;
+		}
+
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
 		ret = zbx_ipc_service_recv(&lld_service, &timeout, &client, &message);
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
@@ -583,9 +961,11 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 					lld_process_queue(&manager);
 					break;
 				case ZBX_IPC_LLD_DONE:
-					lld_process_result(&manager, client);
-					processed_num++;
-					manager.queued_num--;
+					if (SUCCEED == lld_process_result(&manager, client, message))
+					{
+						processed_num++;
+						manager.queued_num--;
+					}
 					break;
 				case ZBX_IPC_LLD_QUEUE:
 					zbx_ipc_client_send(client, message->code, (unsigned char *)&manager.queued_num,
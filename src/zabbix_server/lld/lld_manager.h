@@ -50,6 +50,18 @@ typedef struct
 
 	/* the oldest value in queue */
 	zbx_lld_data_t	*head;
+
+	/* the number of oldest value partitions being processed */
+	int		partitions_num;
+
+	/* lastcheck of objects discovered by the oldest value partitions */
+	int		partitions_lastcheck;
+
+	/* 1 if any of the oldest value partitions was not processed completely */
+	unsigned char	partitions_failed;
+
+	/* errors reported by the oldest value partitions */
+	char		*partitions_error;
 }
 zbx_lld_rule_t;
 
@@ -68,6 +80,8 @@ ZBX_PTR_VECTOR_DECL(lld_rule_info_ptr, zbx_lld_rule_info_t*)
 typedef struct
 {
 	zbx_get_config_forks_f	get_process_forks_cb_arg;
+	int			skip_unchanged_period;
+	int			partition_size;
 }
 zbx_thread_lld_manager_args;
 
@@ -19,14 +19,15 @@
 #include "zbxsysinfo.h"
 
 zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
-		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
-		const char *error)
+		zbx_uint64_t fingerprint, const char *value, const zbx_timespec_t *ts, unsigned char meta,
+		zbx_uint64_t lastlogsize, int mtime, const char *error)
 {
 	unsigned char	*ptr;
 	zbx_uint32_t	data_len = 0, value_len, error_len;
 
 	zbx_serialize_prepare_value(data_len, itemid);
 	zbx_serialize_prepare_value(data_len, hostid);
+	zbx_serialize_prepare_value(data_len, fingerprint);
 	zbx_serialize_prepare_str(data_len, value);
 	zbx_serialize_prepare_value(data_len, *ts);
 	zbx_serialize_prepare_str(data_len, error);
@@ -43,6 +44,7 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 	ptr = *data;
 	ptr += zbx_serialize_value(ptr, itemid);
 	ptr += zbx_serialize_value(ptr, hostid);
+	ptr += zbx_serialize_value(ptr, fingerprint);
 	ptr += zbx_serialize_str(ptr, value, value_len);
 	ptr += zbx_serialize_value(ptr, *ts);
 	ptr += zbx_serialize_str(ptr, error, error_len);
@@ -57,13 +59,14 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 }
 
 void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid, zbx_uint64_t *hostid,
-		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
-		char **error)
+		zbx_uint64_t *fingerprint, char **value, zbx_timespec_t *ts, unsigned char *meta,
+		zbx_uint64_t *lastlogsize, int *mtime, char **error)
 {
 	zbx_uint32_t	value_len, error_len;
 
 	data += zbx_deserialize_value(data, itemid);
 	data += zbx_deserialize_value(data, hostid);
+	data += zbx_deserialize_value(data, fingerprint);
 	data += zbx_deserialize_str(data, value, value_len);
 	data += zbx_deserialize_value(data, ts);
 	data += zbx_deserialize_str(data, error, error_len);
@@ -75,6 +78,87 @@ void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *ite
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes partition or merge request by prefixing serialized     *
+ *          item value with partition processing data                         *
+ *                                                                            *
+ * Parameters: data       - [OUT] serialized request                          *
+ *             lastcheck  - [IN] lastcheck of objects discovered by           *
+ *                               partitions                                   *
+ *             error      - [IN] errors reported by partitions (optional)     *
+ *             value_data - [IN] serialized item value                        *
+ *             value_len  - [IN] serialized item value length                 *
+ *                                                                            *
+ * Return value: size of serialized data                                      *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_lld_serialize_partition(unsigned char **data, int lastcheck, const char *error,
+		const unsigned char *value_data, zbx_uint32_t value_len)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0, error_len;
+
+	zbx_serialize_prepare_value(data_len, lastcheck);
+	zbx_serialize_prepare_str(data_len, error);
+
+	*data = (unsigned char *)zbx_malloc(NULL, data_len + value_len);
+
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, lastcheck);
+	ptr += zbx_serialize_str(ptr, error, error_len);
+	memcpy(ptr, value_data, value_len);
+
+	return data_len + value_len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: deserializes partition or merge request                           *
+ *                                                                            *
+ * Parameters: data      - [IN] serialized request                            *
+ *             lastcheck - [OUT] lastcheck of objects discovered by           *
+ *                               partitions                                   *
+ *             error     - [OUT] errors reported by partitions                *
+ *                                                                            *
+ * Return value: serialized item value                                        *
+ *                                                                            *
+ ******************************************************************************/
+const unsigned char	*zbx_lld_deserialize_partition(const unsigned char *data, int *lastcheck, char **error)
+{
+	zbx_uint32_t	error_len;
+
+	data += zbx_deserialize_value(data, lastcheck);
+	data += zbx_deserialize_str(data, error, error_len);
+
+	return data;
+}
+
+zbx_uint32_t	zbx_lld_serialize_partition_result(unsigned char **data, int result, const char *error)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0, error_len;
+
+	zbx_serialize_prepare_value(data_len, result);
+	zbx_serialize_prepare_str(data_len, error);
+
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, result);
+	(void)zbx_serialize_str(ptr, error, error_len);
+
+	return data_len;
+}
+
+void	zbx_lld_deserialize_partition_result(const unsigned char *data, int *result, char **error)
+{
+	zbx_uint32_t	error_len;
+
+	data += zbx_deserialize_value(data, result);
+	(void)zbx_deserialize_str(data, error, error_len);
+}
+
 zbx_uint32_t	zbx_lld_serialize_diag_stats(unsigned char **data, zbx_uint64_t items_num, zbx_uint64_t values_num)
 {
 	unsigned char	*ptr;
@@ -195,7 +279,7 @@ void	zbx_lld_queue_value(zbx_uint64_t itemid, zbx_uint64_t hostid, const char *v
 		exit(EXIT_FAILURE);
 	}
 
-	data_len = zbx_lld_serialize_item_value(&data, itemid, hostid, value, ts, meta, lastlogsize, mtime, error);
+	data_len = zbx_lld_serialize_item_value(&data, itemid, hostid, 0, value, ts, meta, lastlogsize, mtime, error);
 
 	if (FAIL == zbx_ipc_socket_write(&socket, ZBX_IPC_LLD_REQUEST, data, data_len))
 	{
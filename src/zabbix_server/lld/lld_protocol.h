@@ -27,6 +27,8 @@
 
 /* manager -> poller */
 #define ZBX_IPC_LLD_TASK		1100
+#define ZBX_IPC_LLD_PARTITION		1101
+#define ZBX_IPC_LLD_MERGE		1102
 
 /* manager -> poller */
 #define ZBX_IPC_LLD_REQUEST		1200
@@ -47,12 +49,21 @@
 #define ZBX_IPC_LLD_TOP_ITEMS_RESULT	1403
 
 zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
-		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
-		const char *error);
+		zbx_uint64_t fingerprint, const char *value, const zbx_timespec_t *ts, unsigned char meta,
+		zbx_uint64_t lastlogsize, int mtime, const char *error);
 
 void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid, zbx_uint64_t *hostid,
-		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
-		char **error);
+		zbx_uint64_t *fingerprint, char **value, zbx_timespec_t *ts, unsigned char *meta,
+		zbx_uint64_t *lastlogsize, int *mtime, char **error);
+
+zbx_uint32_t	zbx_lld_serialize_partition(unsigned char **data, int lastcheck, const char *error,
+		const unsigned char *value_data, zbx_uint32_t value_len);
+
+const unsigned char	*zbx_lld_deserialize_partition(const unsigned char *data, int *lastcheck, char **error);
+
+zbx_uint32_t	zbx_lld_serialize_partition_result(unsigned char **data, int result, const char *error);
+
+void	zbx_lld_deserialize_partition_result(const unsigned char *data, int *result, char **error);
 
 zbx_uint32_t	zbx_lld_serialize_diag_stats(unsigned char **data, zbx_uint64_t items_num, zbx_uint64_t values_num);
 
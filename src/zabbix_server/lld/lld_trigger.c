@@ -3730,7 +3730,7 @@ static	int	get_trigger_status_value(int status)
  ******************************************************************************/
 int	lld_update_triggers(zbx_uint64_t hostid, zbx_uint64_t lld_ruleid, const zbx_vector_lld_row_ptr_t *lld_rows,
 		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, char **error, zbx_lld_lifetime_t *lifetime,
-		zbx_lld_lifetime_t *enabled_lifetime, int lastcheck)
+		zbx_lld_lifetime_t *enabled_lifetime, int lastcheck, int discovered_since)
 {
 	zbx_vector_lld_trigger_prototype_ptr_t	trigger_prototypes;
 	zbx_vector_lld_trigger_ptr_t		triggers;
@@ -3786,8 +3786,9 @@ int	lld_update_triggers(zbx_uint64_t hostid, zbx_uint64_t lld_ruleid, const zbx_
 	lld_trigger_tags_make(&trigger_prototypes, &triggers, lld_rows, lld_macro_paths, error);
 	ret = lld_triggers_save(hostid, &trigger_prototypes, &triggers);
 	lld_process_lost_objects("trigger_discovery", "triggers", "triggerid", (zbx_vector_ptr_t *)&triggers, lifetime,
-			enabled_lifetime, lastcheck, zbx_db_delete_triggers, get_trigger_info, get_trigger_status_value,
-			zbx_audit_trigger_create_entry, zbx_audit_trigger_update_json_update_status);
+			enabled_lifetime, lastcheck, discovered_since, zbx_db_delete_triggers, get_trigger_info,
+			get_trigger_status_value, zbx_audit_trigger_create_entry,
+			zbx_audit_trigger_update_json_update_status);
 	/* cleaning */
 
 	zbx_vector_lld_item_ptr_clear_ext(&items, lld_item_free);
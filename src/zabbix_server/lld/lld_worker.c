@@ -50,10 +50,20 @@ static void	lld_register_worker(zbx_ipc_socket_t *socket)
  * Purpose: Processes LLD task and updates rule state/error in configuration  *
  *          cache and database.                                               *
  *                                                                            *
- * Parameters: message - [IN] message with LLD request                        *
+ * Parameters: data             - [IN] serialized LLD request                 *
+ *             mode             - [IN] ZBX_LLD_PROCESS_VALUE or               *
+ *                                     ZBX_LLD_PROCESS_MERGE                  *
+ *             lastcheck        - [IN] lastcheck of objects discovered by     *
+ *                                     value partitions                       *
+ *             partitions_error - [IN] errors reported by value partitions    *
+ *                                     (optional)                             *
+ *             fingerprint      - [OUT] fingerprint of the processed value, 0 *
+ *                                      if the value was not processed        *
+ *                                      successfully                          *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_task(const zbx_ipc_message_t *message)
+static void	lld_process_task(const unsigned char *data, unsigned char mode, int lastcheck,
+		const char *partitions_error, zbx_uint64_t *fingerprint)
 {
 	zbx_uint64_t		itemid, hostid, lastlogsize;
 	char			*value, *error;
@@ -65,13 +75,16 @@ static void	lld_process_task(const zbx_ipc_message_t *message)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_lld_deserialize_item_value(message->data, &itemid, &hostid, &value, &ts, &meta, &lastlogsize, &mtime,
+	zbx_lld_deserialize_item_value(data, &itemid, &hostid, fingerprint, &value, &ts, &meta, &lastlogsize, &mtime,
 			&error);
 
 	zbx_dc_config_get_items_by_itemids(&item, &itemid, &errcode, 1);
 
 	if (SUCCEED != errcode)
+	{
+		*fingerprint = 0;
 		goto out;
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "processing discovery rule:" ZBX_FS_UI64, itemid);
 
@@ -79,10 +92,19 @@ static void	lld_process_task(const zbx_ipc_message_t *message)
 
 	if (NULL != error || NULL != value)
 	{
-		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, &error))
+		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, mode, lastcheck, fingerprint,
+				&error))
+		{
 			state = ITEM_STATE_NORMAL;
+
+			if (NULL != partitions_error)
+				error = zbx_strdcat(error, partitions_error);
+		}
 		else
+		{
 			state = ITEM_STATE_NOTSUPPORTED;
+			*fingerprint = 0;
+		}
 
 		if (state != item.state)
 		{
@@ -168,13 +190,64 @@ out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: processes partition of LLD rule value                             *
+ *                                                                            *
+ * Parameters: message - [IN] message with LLD request                        *
+ *             error   - [OUT] errors of discovered objects                   *
+ *                                                                            *
+ * Return value: SUCCEED - partition was processed                            *
+ *               FAIL    - partition was not processed completely             *
+ *                                                                            *
+ * Comments: Rule state and error are updated by the merge pass over the      *
+ *           whole value after all its partitions.                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_process_partition(const zbx_ipc_message_t *message, char **error)
+{
+	zbx_uint64_t		itemid, hostid, fingerprint, lastlogsize;
+	char			*value, *value_error, *partitions_error;
+	zbx_timespec_t		ts;
+	int			mtime, lastcheck, ret = FAIL;
+	unsigned char		meta;
+	const unsigned char	*data;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	data = zbx_lld_deserialize_partition(message->data, &lastcheck, &partitions_error);
+	zbx_lld_deserialize_item_value(data, &itemid, &hostid, &fingerprint, &value, &ts, &meta, &lastlogsize,
+			&mtime, &value_error);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "processing partition of discovery rule:" ZBX_FS_UI64, itemid);
+
+	if (NULL == value_error && NULL != value && SUCCEED != (ret = lld_process_discovery_rule(itemid, value,
+			ZBX_LLD_PROCESS_PARTITION, lastcheck, &fingerprint, error)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot process partition of discovery rule:" ZBX_FS_UI64 ": %s", itemid,
+				ZBX_NULL2EMPTY_STR(*error));
+	}
+
+	zbx_free(value);
+	zbx_free(value_error);
+	zbx_free(partitions_error);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 ZBX_THREAD_ENTRY(lld_worker_thread, args)
 {
 	char			*error = NULL;
 	zbx_ipc_socket_t	lld_socket;
 	zbx_ipc_message_t	message;
 	double			time_stat, time_idle = 0, time_now, time_read;
-	zbx_uint64_t		processed_num = 0;
+	zbx_uint64_t		processed_num = 0, fingerprint;
+	unsigned char		*data;
+	const unsigned char	*value_data;
+	zbx_uint32_t		data_len;
+	int			lastcheck, ret;
 	zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
 	int			server_num = ((zbx_thread_args_t *)args)->info.server_num,
 				process_num = ((zbx_thread_args_t *)args)->info.process_num;
@@ -236,8 +309,24 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 		switch (message.code)
 		{
 			case ZBX_IPC_LLD_TASK:
-				lld_process_task(&message);
-				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, NULL, 0);
+				lld_process_task(message.data, ZBX_LLD_PROCESS_VALUE, 0, NULL, &fingerprint);
+				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, (unsigned char *)&fingerprint,
+						sizeof(fingerprint));
+				processed_num++;
+				break;
+			case ZBX_IPC_LLD_PARTITION:
+				ret = lld_process_partition(&message, &error);
+				data_len = zbx_lld_serialize_partition_result(&data, ret, error);
+				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, data, data_len);
+				zbx_free(data);
+				zbx_free(error);
+				break;
+			case ZBX_IPC_LLD_MERGE:
+				value_data = zbx_lld_deserialize_partition(message.data, &lastcheck, &error);
+				lld_process_task(value_data, ZBX_LLD_PROCESS_MERGE, lastcheck, error, &fingerprint);
+				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, (unsigned char *)&fingerprint,
+						sizeof(fingerprint));
+				zbx_free(error);
 				processed_num++;
 				break;
 		}
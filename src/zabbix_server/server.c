@@ -33,6 +33,7 @@
 #include "lld/lld_worker.h"
 #include "reporter/reporter.h"
 #include "events/events.h"
+#include "events/problem_index.h"
 #include "ha/ha.h"
 #include "rtc/rtc_server.h"
 #include "stats/stats_server.h"
@@ -139,8 +140,8 @@ static const char	*help_message[] = {
 	"      " ZBX_SECRETS_RELOAD "                  Reload secrets from Vault",
 	"      " ZBX_DIAGINFO "=section                Log internal diagnostic information of the",
 	"                                        section (historycache, preprocessing, alerting,",
-	"                                        lld, valuecache, locks, connector) or everything if section is",
-	"                                        not specified",
+	"                                        lld, valuecache, locks, connector, snmpcache) or everything if",
+	"                                        section is not specified",
 	"      " ZBX_PROF_ENABLE "=target              Enable profiling, affects all processes if",
 	"                                        target is not specified",
 	"      " ZBX_PROF_DISABLE "=target             Disable profiling, affects all processes if",
@@ -308,10 +309,15 @@ static char	*config_server		= NULL;		/* not used in zabbix_server, required for
 
 static int	config_housekeeping_frequency	= 1;
 static int	config_max_housekeeper_delete	= 5000;		/* applies for every separate field value */
+static int	config_housekeeping_partitions	= 0;
+static int	config_housekeeping_partitions_ahead	= 3;
 static int	config_confsyncer_frequency	= 10;
 
 static int	config_problemhousekeeping_frequency = 60;
 
+static int	config_lld_skip_unchanged_period	= 0;
+static int	config_lld_partition_size		= 0;
+
 static int	config_vmware_frequency		= 60;
 static int	config_vmware_perf_frequency	= 60;
 static int	config_vmware_timeout		= 10;
@@ -322,7 +328,11 @@ static zbx_uint64_t	config_history_index_cache_size	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_trends_cache_size	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_trend_func_cache_size	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_value_cache_size		= 8 * ZBX_MEBIBYTE;
+static zbx_uint64_t	config_problem_cache_size	= 8 * ZBX_MEBIBYTE;
+static zbx_uint64_t	config_snmp_index_cache_size	= 0;
 static zbx_uint64_t	config_vmware_cache_size	= 8 * ZBX_MEBIBYTE;
+static char		*config_value_cache_snapshot_file	= NULL;
+static char		*config_conf_cache_snapshot_file	= NULL;
 
 static int	config_unreachable_period		= 45;
 static int	config_unreachable_delay		= 15;
@@ -392,7 +402,8 @@ static	const zbx_events_funcs_t	events_cbs = {
 	.clean_events_cb		= zbx_clean_events,
 	.reset_event_recovery_cb	= zbx_reset_event_recovery,
 	.export_events_cb		= zbx_export_events,
-	.events_update_itservices_cb	= zbx_events_update_itservices
+	.events_update_itservices_cb	= zbx_events_update_itservices,
+	.events_update_problem_index_cb	= zbx_events_update_problem_index
 };
 
 typedef struct
@@ -739,6 +750,20 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (0 != config_problem_cache_size && 128 * ZBX_KIBIBYTE > config_problem_cache_size)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"ProblemCacheSize\" configuration parameter must be either 0"
+				" or greater than 128KB");
+		err = 1;
+	}
+
+	if (0 != config_snmp_index_cache_size && 128 * ZBX_KIBIBYTE > config_snmp_index_cache_size)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"SNMPIndexCacheSize\" configuration parameter must be either 0"
+				" or greater than 128KB");
+		err = 1;
+	}
+
 	if (NULL != zbx_config_source_ip && SUCCEED != zbx_is_supported_ip(zbx_config_source_ip))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "invalid \"SourceIP\" configuration parameter: '%s'", zbx_config_source_ip);
@@ -908,6 +933,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	0,			1},
 		{"CacheSize",			&config_conf_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"CacheSnapshotFile",		&config_conf_cache_snapshot_file,	ZBX_CFG_TYPE_STRING,
+				ZBX_CONF_PARM_OPT,	0,			0},
 		{"HistoryCacheSize",		&config_history_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&config_history_index_cache_size,	ZBX_CFG_TYPE_UINT64,
@@ -918,12 +945,22 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	0,			__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"ValueCacheSize",		&config_value_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"ValueCacheSnapshotFile",	&config_value_cache_snapshot_file,	ZBX_CFG_TYPE_STRING,
+				ZBX_CONF_PARM_OPT,	0,			0},
+		{"ProblemCacheSize",		&config_problem_cache_size,		ZBX_CFG_TYPE_UINT64,
+				ZBX_CONF_PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"SNMPIndexCacheSize",		&config_snmp_index_cache_size,		ZBX_CFG_TYPE_UINT64,
+				ZBX_CONF_PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
 		{"CacheUpdateFrequency",	&config_confsyncer_frequency,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			SEC_PER_HOUR},
 		{"HousekeepingFrequency",	&config_housekeeping_frequency,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	0,			24},
 		{"MaxHousekeeperDelete",	&config_max_housekeeper_delete,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	0,			1000000},
+		{"HousekeepingPartitions",	&config_housekeeping_partitions,	ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
+		{"HousekeepingPartitionsAhead",	&config_housekeeping_partitions_ahead,	ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			366},
 		{"TmpDir",			&zbx_config_tmpdir,			ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"FpingLocation",		&zbx_config_fping_location,		ZBX_CFG_TYPE_STRING,
@@ -1087,6 +1124,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 		{"StartLLDProcessors",		&config_forks[ZBX_PROCESS_TYPE_LLDWORKER],
 											ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			100},
+		{"LLDSkipUnchangedPeriod",	&config_lld_skip_unchanged_period,	ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			SEC_PER_DAY},
+		{"LLDPartitionSize",		&config_lld_partition_size,		ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1000000},
 		{"StatsAllowedIP",		&config_stats_allowed_ip,		ZBX_CFG_TYPE_STRING_LIST,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"StartHistoryPollers",		&config_forks[ZBX_PROCESS_TYPE_HISTORYPOLLER],
@@ -1208,9 +1249,23 @@ static void	zbx_on_exit(int ret, void *on_exit_args)
 
 		zbx_free_configuration_cache();
 
+		if (SUCCEED == ret && NULL != config_value_cache_snapshot_file)
+		{
+			if (SUCCEED != zbx_vc_snapshot_write(config_value_cache_snapshot_file, CONFIG_HA_NODE_NAME,
+					&error))
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "cannot write value cache snapshot: %s", error);
+				zbx_free(error);
+			}
+		}
+
 		/* free history value cache */
 		zbx_vc_destroy();
 
+		zbx_problem_index_destroy();
+
+		zbx_snmp_index_cache_destroy();
+
 		zbx_deinit_remote_commands_cache();
 
 		/* free vmware support */
@@ -1519,6 +1574,48 @@ static void	zbx_db_save_server_status(void)
 	zbx_json_free(&json);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads value cache snapshot written on previous shutdown           *
+ *                                                                            *
+ * Comments: The snapshot is valid only if no other HA node has been active   *
+ *           (and could have written history) after it was written, so the    *
+ *           last access time of other non-standby nodes is used as the       *
+ *           minimum snapshot time.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	server_load_value_cache_snapshot(void)
+{
+	char		*error = NULL, *name_esc;
+	int		min_time = 0;
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+
+	name_esc = zbx_db_dyn_escape_string(ZBX_NULL2EMPTY_STR(CONFIG_HA_NODE_NAME));
+
+	result = zbx_db_select("select max(lastaccess) from ha_node where name<>'%s' and status<>%d", name_esc,
+			ZBX_NODE_STATUS_STANDBY);
+
+	zbx_free(name_esc);
+
+	if (NULL == result)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot load value cache snapshot: cannot read HA node status");
+		return;
+	}
+
+	if (NULL != (row = zbx_db_fetch(result)) && SUCCEED != zbx_db_is_null(row[0]))
+		min_time = atoi(row[0]);
+
+	zbx_db_free_result(result);
+
+	if (SUCCEED != zbx_vc_snapshot_load(config_value_cache_snapshot_file, CONFIG_HA_NODE_NAME, min_time, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot load value cache snapshot: %s", error);
+		zbx_free(error);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: initialize shared resources and start processes                   *
@@ -1577,7 +1674,9 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 							zbx_config_tls->key_file, zbx_config_source_ip,
 							zbx_config_webservice_url};
 	zbx_thread_housekeeper_args	housekeeper_args = {&db_version_info, zbx_config_timeout,
-							config_housekeeping_frequency, config_max_housekeeper_delete};
+							config_housekeeping_frequency, config_max_housekeeper_delete,
+							config_housekeeping_partitions,
+							config_housekeeping_partitions_ahead};
 	zbx_thread_server_trigger_housekeeper_args	trigger_housekeeper_args = {zbx_config_timeout,
 							config_problemhousekeeping_frequency};
 	zbx_thread_taskmanager_args	taskmanager_args = {zbx_config_timeout, config_startup_time};
@@ -1602,10 +1701,12 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 									config_ssl_cert_location,
 									config_ssl_key_location};
 	zbx_thread_report_manager_args	report_manager_args = {get_config_forks};
-	zbx_thread_alert_syncer_args	alert_syncer_args = {config_confsyncer_frequency};
+	zbx_thread_alert_syncer_args	alert_syncer_args = {config_confsyncer_frequency,
+							zbx_problem_index_add_tags};
 	zbx_thread_alert_manager_args	alert_manager_args = {get_config_forks, get_zbx_config_alert_scripts_path,
 								zbx_config_dbhigh, zbx_config_source_ip};
-	zbx_thread_lld_manager_args	lld_manager_args = {get_config_forks};
+	zbx_thread_lld_manager_args	lld_manager_args = {get_config_forks, config_lld_skip_unchanged_period,
+							config_lld_partition_size};
 	zbx_thread_connector_manager_args	connector_manager_args = {get_config_forks};
 	zbx_thread_dbsyncer_args		dbsyncer_args = {&events_cbs, config_histsyncer_frequency,
 								zbx_config_timeout, config_history_storage_pipelines};
@@ -1627,7 +1728,7 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 	}
 
 	if (SUCCEED != zbx_init_configuration_cache(get_zbx_program_type, get_config_forks, config_conf_cache_size,
-			NULL, &error))
+			NULL, config_conf_cache_snapshot_file, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize configuration cache: %s", error);
 		zbx_free(error);
@@ -1664,6 +1765,20 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 		return FAIL;
 	}
 
+	if (SUCCEED != zbx_problem_index_init(config_problem_cache_size, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize problem cache: %s", error);
+		zbx_free(error);
+		return FAIL;
+	}
+
+	if (SUCCEED != zbx_snmp_index_cache_init(config_snmp_index_cache_size, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize SNMP index cache: %s", error);
+		zbx_free(error);
+		return FAIL;
+	}
+
 	if (0 != config_forks[ZBX_PROCESS_TYPE_CONNECTORMANAGER])
 		zbx_connector_init();
 
@@ -1772,6 +1887,13 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 				/* update maintenance states */
 				zbx_dc_update_maintenances(MAINTENANCE_TIMER_PENDING);
 
+				/* warm up value cache before history syncers are started */
+				if (NULL != config_value_cache_snapshot_file)
+					server_load_value_cache_snapshot();
+
+				/* load open problems before processes creating events are started */
+				zbx_problem_index_load();
+
 				zbx_db_close();
 				break;
 			case ZBX_PROCESS_TYPE_POLLER:
@@ -2030,6 +2152,8 @@ static void	server_teardown(zbx_rtc_t *rtc, zbx_socket_t *listen_sock)
 		zbx_tcp_unlisten(listen_sock);
 
 	/* destroy shared caches */
+	zbx_snmp_index_cache_destroy();
+	zbx_problem_index_destroy();
 	zbx_tfc_destroy();
 	zbx_vc_destroy();
 	zbx_vmware_destroy();
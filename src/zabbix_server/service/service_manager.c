@@ -622,6 +622,7 @@ static void	sync_services(zbx_service_manager_t *service_manager, int *updated,
 			zbx_vector_service_problem_ptr_create(&service_local.service_problems);
 			zbx_vector_service_rule_ptr_create(&service_local.status_rules);
 			service_local.name = zbx_strdup(NULL, row[3]);
+			service_local.level = -1;
 
 			service = zbx_hashset_insert(&service_manager->services, &service_local, sizeof(service_local));
 
@@ -632,6 +633,7 @@ static void	sync_services(zbx_service_manager_t *service_manager, int *updated,
 			zbx_vector_service_ptr_clear(&service->children);
 			zbx_vector_service_ptr_clear(&service->parents);
 			zbx_vector_service_rule_ptr_clear(&service->status_rules);
+			service->level = -1;
 
 			if (service->status != service_local.status)
 			{
@@ -1549,134 +1551,117 @@ out:
 	return ret;
 }
 
+/* index of service status in children statistics */
+#define ZBX_SERVICE_STATUS_INDEX(status)	((status) - ZBX_SERVICE_STATUS_OK)
+#define ZBX_SERVICE_STATUS_INDEX_NUM		(TRIGGER_SEVERITY_COUNT - ZBX_SERVICE_STATUS_OK)
+
+/* number and weight of not ignored children grouped by their propagated status */
+typedef struct
+{
+	int	num[ZBX_SERVICE_STATUS_INDEX_NUM];
+	int	weight[ZBX_SERVICE_STATUS_INDEX_NUM];
+	int	total_num;
+	int	total_weight;
+}
+zbx_service_children_stats_t;
+
 /******************************************************************************
  *                                                                            *
- * Purpose: gets service status by applying main service status algorithm     *
+ * Purpose: counts not ignored children and their weight by status            *
  *                                                                            *
  * Parameters: service - [IN]                                                 *
+ *             stats   - [OUT] children statistics                            *
  *                                                                            *
- *  Return value: service status                                              *
+ * Comments: Children are iterated once, after that main status and all      *
+ *           status rules can be evaluated without iterating children again. *
  *                                                                            *
  ******************************************************************************/
-int	service_get_main_status(const zbx_service_t *service)
+static void	service_get_children_stats(const zbx_service_t *service, zbx_service_children_stats_t *stats)
 {
-	int	status = ZBX_SERVICE_STATUS_OK, child_status;
+	int	child_status, index;
 
-	switch (service->algorithm)
-	{
-		case ZBX_SERVICE_STATUS_CALC_MOST_CRITICAL_ALL:
-			for (int i = 0; i < service->children.values_num; i++)
-			{
-				zbx_service_t	*child = service->children.values[i];
-
-				if (SUCCEED != service_get_status(child, &child_status))
-					continue;
+	memset(stats, 0, sizeof(zbx_service_children_stats_t));
 
-				if (ZBX_SERVICE_STATUS_OK == child_status)
-				{
-					status = child_status;
-					break;
-				}
+	for (int i = 0; i < service->children.values_num; i++)
+	{
+		zbx_service_t	*child = service->children.values[i];
 
-				if (status < child_status)
-					status = child_status;
-			}
-			break;
-		case ZBX_SERVICE_STATUS_CALC_MOST_CRITICAL_ONE:
-			for (int i = 0; i < service->children.values_num; i++)
-			{
-				zbx_service_t	*child = service->children.values[i];
+		if (SUCCEED != service_get_status(child, &child_status))
+			continue;
 
-				if (SUCCEED != service_get_status(child, &child_status))
-					continue;
+		if (0 > (index = ZBX_SERVICE_STATUS_INDEX(child_status)))
+			index = 0;
+		else if (ZBX_SERVICE_STATUS_INDEX_NUM <= index)
+			index = ZBX_SERVICE_STATUS_INDEX_NUM - 1;
 
-				if (status < child_status)
-					status = child_status;
-			}
-			break;
-		case ZBX_SERVICE_STATUS_CALC_SET_OK:
-			break;
-		default:
-			zabbix_log(LOG_LEVEL_ERR, "unknown calculation algorithm of service status [%d]",
-					service->algorithm);
-			break;
+		stats->num[index]++;
+		stats->weight[index] += child->weight;
+		stats->total_num++;
+		stats->total_weight += child->weight;
 	}
-
-	return status;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: gets children with status greater or equal to specified           *
- *                                                                            *
- * Parameters: service      - [IN]                                            *
- *             status       - [IN] target status                              *
- *             children     - [OUT] children having required status           *
- *             total_weight - [OUT] weight of all not ignored children        *
- *             total_num    - [OUT] number of all not ignored children        *
+ * Purpose: gets number and weight of children with status greater or equal   *
+ *          to specified                                                      *
  *                                                                            *
  ******************************************************************************/
-static void	service_get_children_by_status(const zbx_service_t *service, int status,
-		zbx_vector_service_ptr_t *children, int *total_weight, int *total_num)
+static void	service_stats_get_by_status(const zbx_service_children_stats_t *stats, int status, int *num,
+		int *weight)
 {
-	int	child_status;
-
-	*total_num = 0;
-	*total_weight = 0;
+	*num = 0;
+	*weight = 0;
 
-	for (int i = 0; i < service->children.values_num; i++)
+	for (int i = MAX(0, ZBX_SERVICE_STATUS_INDEX(status)); i < ZBX_SERVICE_STATUS_INDEX_NUM; i++)
 	{
-		zbx_service_t	*child = service->children.values[i];
-
-		if (SUCCEED != service_get_status(child, &child_status))
-			continue;
-
-		(*total_weight) += child->weight;
-		(*total_num)++;
-
-		if (child_status >= status)
-			zbx_vector_service_ptr_append(children, child);
+		*num += stats->num[i];
+		*weight += stats->weight[i];
 	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: gets total weight of all specified services                       *
+ * Purpose: gets service status calculated by its algorithm from children     *
+ *          statistics                                                        *
  *                                                                            *
  ******************************************************************************/
-static int	services_get_weight(const zbx_vector_service_ptr_t *services)
+static int	service_stats_get_main_status(const zbx_service_t *service, const zbx_service_children_stats_t *stats)
 {
-	int	weight = 0;
-
-	for (int i = 0; i < services->values_num; i++)
+	switch (service->algorithm)
 	{
-		zbx_service_t	*service = services->values[i];
-
-		weight += service->weight;
+		case ZBX_SERVICE_STATUS_CALC_MOST_CRITICAL_ALL:
+			if (0 != stats->num[ZBX_SERVICE_STATUS_INDEX(ZBX_SERVICE_STATUS_OK)])
+				break;
+			ZBX_FALLTHROUGH;
+		case ZBX_SERVICE_STATUS_CALC_MOST_CRITICAL_ONE:
+			for (int i = ZBX_SERVICE_STATUS_INDEX_NUM - 1; i > 0; i--)
+			{
+				if (0 != stats->num[i])
+					return i + ZBX_SERVICE_STATUS_OK;
+			}
+			break;
+		case ZBX_SERVICE_STATUS_CALC_SET_OK:
+			break;
+		default:
+			zabbix_log(LOG_LEVEL_ERR, "unknown calculation algorithm of service status [%d]",
+					service->algorithm);
+			break;
 	}
 
-	return weight;
+	return ZBX_SERVICE_STATUS_OK;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: gets service status according to specified rule                   *
- *                                                                            *
- * Parameters: service - [IN]                                                 *
- *             rule    - [IN] service status rule                             *
- *                                                                            *
- *  Return value: service status                                              *
+ * Purpose: gets service status according to specified rule from children     *
+ *          statistics                                                        *
  *                                                                            *
  ******************************************************************************/
-int	service_get_rule_status(const zbx_service_t *service, const zbx_service_rule_t *rule)
+static int	service_stats_get_rule_status(const zbx_service_children_stats_t *stats,
+		const zbx_service_rule_t *rule)
 {
-	zbx_vector_service_ptr_t	children;
-	int				status = ZBX_SERVICE_STATUS_OK, status_limit, total_num, total_weight, weight;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() service:" ZBX_FS_UI64 ", rule:" ZBX_FS_UI64, __func__, service->serviceid,
-			rule->service_ruleid);
-
-	zbx_vector_service_ptr_create(&children);
+	int	status_limit, num, weight;
 
 	switch (rule->type)
 	{
@@ -1694,57 +1679,128 @@ int	service_get_rule_status(const zbx_service_t *service, const zbx_service_rule
 			break;
 		default:
 			THIS_SHOULD_NEVER_HAPPEN;
-			goto out;
+			return ZBX_SERVICE_STATUS_OK;
 	}
 
-	service_get_children_by_status(service, status_limit, &children, &total_weight, &total_num);
+	service_stats_get_by_status(stats, status_limit, &num, &weight);
 
 	switch (rule->type)
 	{
 		case ZBX_SERVICE_STATUS_RULE_TYPE_N_GE:
-			if (children.values_num < rule->limit_value)
-				goto out;
+			if (num < rule->limit_value)
+				return ZBX_SERVICE_STATUS_OK;
 			break;
 		case ZBX_SERVICE_STATUS_RULE_TYPE_NP_GE:
-			if (0 == total_num || children.values_num * 100 / total_num < rule->limit_value)
-				goto out;
+			if (0 == stats->total_num || num * 100 / stats->total_num < rule->limit_value)
+				return ZBX_SERVICE_STATUS_OK;
 			break;
 		case ZBX_SERVICE_STATUS_RULE_TYPE_N_L:
-			if (total_num - children.values_num >= rule->limit_value)
-				goto out;
+			if (stats->total_num - num >= rule->limit_value)
+				return ZBX_SERVICE_STATUS_OK;
 			break;
 		case ZBX_SERVICE_STATUS_RULE_TYPE_NP_L:
-			if (0 == total_num || (total_num - children.values_num) * 100 / total_num >= rule->limit_value)
-				goto out;
+			if (0 == stats->total_num || (stats->total_num - num) * 100 / stats->total_num >=
+					rule->limit_value)
+			{
+				return ZBX_SERVICE_STATUS_OK;
+			}
 			break;
 		case ZBX_SERVICE_STATUS_RULE_TYPE_W_GE:
-			weight = services_get_weight(&children);
 			if (weight < rule->limit_value)
-				goto out;
+				return ZBX_SERVICE_STATUS_OK;
 			break;
 		case ZBX_SERVICE_STATUS_RULE_TYPE_WP_GE:
-			weight = services_get_weight(&children);
-			if (0 == total_weight || weight * 100 / total_weight < rule->limit_value)
-				goto out;
+			if (0 == stats->total_weight || weight * 100 / stats->total_weight < rule->limit_value)
+				return ZBX_SERVICE_STATUS_OK;
 			break;
 		case ZBX_SERVICE_STATUS_RULE_TYPE_W_L:
-			weight = services_get_weight(&children);
-			if (total_weight - weight >= rule->limit_value)
-				goto out;
+			if (stats->total_weight - weight >= rule->limit_value)
+				return ZBX_SERVICE_STATUS_OK;
 			break;
 		case ZBX_SERVICE_STATUS_RULE_TYPE_WP_L:
-			weight = services_get_weight(&children);
-			if (0 == total_weight || (total_weight - weight) * 100 / total_weight >= rule->limit_value)
-				goto out;
+			if (0 == stats->total_weight || (stats->total_weight - weight) * 100 / stats->total_weight >=
+					rule->limit_value)
+			{
+				return ZBX_SERVICE_STATUS_OK;
+			}
 			break;
-		default:
-			THIS_SHOULD_NEVER_HAPPEN;
-			goto out;
 	}
 
-	status = rule->new_status;
-out:
-	zbx_vector_service_ptr_destroy(&children);
+	return rule->new_status;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets service status by applying main service status algorithm     *
+ *                                                                            *
+ * Parameters: service - [IN]                                                 *
+ *                                                                            *
+ *  Return value: service status                                              *
+ *                                                                            *
+ ******************************************************************************/
+int	service_get_main_status(const zbx_service_t *service)
+{
+	zbx_service_children_stats_t	stats;
+
+	service_get_children_stats(service, &stats);
+
+	return service_stats_get_main_status(service, &stats);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets children with status greater or equal to specified           *
+ *                                                                            *
+ * Parameters: service      - [IN]                                            *
+ *             status       - [IN] target status                              *
+ *             children     - [OUT] children having required status           *
+ *             total_weight - [OUT] weight of all not ignored children        *
+ *             total_num    - [OUT] number of all not ignored children        *
+ *                                                                            *
+ ******************************************************************************/
+static void	service_get_children_by_status(const zbx_service_t *service, int status,
+		zbx_vector_service_ptr_t *children, int *total_weight, int *total_num)
+{
+	int	child_status;
+
+	*total_num = 0;
+	*total_weight = 0;
+
+	for (int i = 0; i < service->children.values_num; i++)
+	{
+		zbx_service_t	*child = service->children.values[i];
+
+		if (SUCCEED != service_get_status(child, &child_status))
+			continue;
+
+		(*total_weight) += child->weight;
+		(*total_num)++;
+
+		if (child_status >= status)
+			zbx_vector_service_ptr_append(children, child);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets service status according to specified rule                   *
+ *                                                                            *
+ * Parameters: service - [IN]                                                 *
+ *             rule    - [IN] service status rule                             *
+ *                                                                            *
+ *  Return value: service status                                              *
+ *                                                                            *
+ ******************************************************************************/
+int	service_get_rule_status(const zbx_service_t *service, const zbx_service_rule_t *rule)
+{
+	zbx_service_children_stats_t	stats;
+	int				status;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() service:" ZBX_FS_UI64 ", rule:" ZBX_FS_UI64, __func__, service->serviceid,
+			rule->service_ruleid);
+
+	service_get_children_stats(service, &stats);
+	status = service_stats_get_rule_status(&stats, rule);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() status:%d", __func__, status);
 
@@ -1970,60 +2026,194 @@ void	service_get_rootcause_eventids(const zbx_service_t *parent, zbx_vector_uint
 	zbx_vector_uint64_uniq(eventids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 }
 
+/* service queued for status recalculation after its children were updated */
+typedef struct
+{
+	zbx_service_t	*service;
+	zbx_timespec_t	ts;
+	int		flags;
+	int		level;
+}
+zbx_service_dirty_t;
+
+/* services queued for status recalculation, ordered by their level in service tree */
+typedef struct
+{
+	zbx_hashset_t		services;
+	zbx_binary_heap_t	queue;
+}
+zbx_service_dirty_queue_t;
+
+static zbx_hash_t	service_dirty_hash_func(const void *d)
+{
+	const zbx_service_dirty_t	*dirty = (const zbx_service_dirty_t *)d;
+
+	return ZBX_DEFAULT_UINT64_HASH_FUNC(&dirty->service->serviceid);
+}
+
+static int	service_dirty_compare_func(const void *d1, const void *d2)
+{
+	const zbx_service_dirty_t	*dirty1 = (const zbx_service_dirty_t *)d1;
+	const zbx_service_dirty_t	*dirty2 = (const zbx_service_dirty_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(dirty1->service->serviceid, dirty2->service->serviceid);
+	return 0;
+}
+
+static int	service_dirty_level_compare_func(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+	const zbx_service_dirty_t	*dirty1 = (const zbx_service_dirty_t *)e1->data;
+	const zbx_service_dirty_t	*dirty2 = (const zbx_service_dirty_t *)e2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(dirty1->level, dirty2->level);
+	ZBX_RETURN_IF_NOT_EQUAL(dirty1->service->serviceid, dirty2->service->serviceid);
+	return 0;
+}
+
+static void	service_dirty_queue_init(zbx_service_dirty_queue_t *dirty_queue)
+{
+	zbx_hashset_create(&dirty_queue->services, 100, service_dirty_hash_func, service_dirty_compare_func);
+	zbx_binary_heap_create(&dirty_queue->queue, service_dirty_level_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
+}
+
+static void	service_dirty_queue_destroy(zbx_service_dirty_queue_t *dirty_queue)
+{
+	zbx_binary_heap_destroy(&dirty_queue->queue);
+	zbx_hashset_destroy(&dirty_queue->services);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets service level in service tree - the longest path to a leaf  *
+ *          service                                                           *
+ *                                                                            *
+ * Comments: The level is cached until service links are synchronized again. *
+ *                                                                            *
+ ******************************************************************************/
+static int	service_get_level(zbx_service_t *service)
+{
+	int	level = 0;
+
+	if (-1 != service->level)
+		return service->level;
+
+	/* guard against circular dependencies */
+	service->level = 0;
+
+	for (int i = 0; i < service->children.values_num; i++)
+	{
+		int	child_level = service_get_level(service->children.values[i]) + 1;
+
+		if (child_level > level)
+			level = child_level;
+	}
+
+	service->level = level;
+
+	return level;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: queues parent services for status recalculation                   *
+ *                                                                            *
+ * Parameters: dirty_queue - [IN/OUT]                                         *
+ *             service     - [IN] service with updated status                 *
+ *             ts          - [IN] update timestamp                            *
+ *             flags       - [IN]                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	service_dirty_queue_add_parents(zbx_service_dirty_queue_t *dirty_queue, const zbx_service_t *service,
+		const zbx_timespec_t *ts, int flags)
+{
+	for (int i = 0; i < service->parents.values_num; i++)
+	{
+		zbx_service_dirty_t	dirty_local = {.service = service->parents.values[i]}, *dirty;
+
+		if (NULL == (dirty = (zbx_service_dirty_t *)zbx_hashset_search(&dirty_queue->services,
+				&dirty_local)))
+		{
+			zbx_binary_heap_elem_t	elem;
+
+			dirty_local.ts = *ts;
+			dirty_local.flags = flags;
+			dirty_local.level = service_get_level(dirty_local.service);
+
+			dirty = (zbx_service_dirty_t *)zbx_hashset_insert(&dirty_queue->services, &dirty_local,
+					sizeof(dirty_local));
+
+			elem.key = dirty->service->serviceid;
+			elem.data = (void *)dirty;
+			zbx_binary_heap_insert(&dirty_queue->queue, &elem);
+
+			continue;
+		}
+
+		if (0 > zbx_timespec_compare(&dirty->ts, ts))
+			dirty->ts = *ts;
+
+		dirty->flags |= flags;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
- * Purpose: updates service and its parents statuses                          *
+ * Purpose: updates statuses of queued services and their parents             *
  *                                                                            *
- * Parameters: itservice       - [IN] service to update                       *
- *             ts              - [IN] update timestamp                        *
+ * Parameters: dirty_queue     - [IN/OUT] services to update                  *
  *             alarms          - [OUT] alarms update queue                    *
  *             service_updates - [IN/OUT]                                     *
- *             flags           - [IN]                                         *
- *                                                                            *
  *                                                                            *
  * Comments: This function recalculates service status according to the       *
  *           algorithm and status of the children services. If the status     *
  *           has been changed, an alarm is generated and parent services      *
- *           (up until the root service) are updated too.                     *
+ *           (up until the root service) are queued too.                      *
+ *                                                                            *
+ *           Services are processed from the lowest level upwards, so every   *
+ *           affected service is recalculated only once per batch, after all  *
+ *           its updated children, and only on the paths from the updated     *
+ *           services to the roots.                                           *
  *                                                                            *
  ******************************************************************************/
-static void	its_itservice_update_status(zbx_service_t *itservice, const zbx_timespec_t *ts,
-		zbx_vector_status_update_ptr_t *alarms, zbx_hashset_t *service_updates, int flags)
+static void	its_itservices_update_status(zbx_service_dirty_queue_t *dirty_queue,
+		zbx_vector_status_update_ptr_t *alarms, zbx_hashset_t *service_updates)
 {
-	int	status, rule_status;
-
-	status = service_get_main_status(itservice);
-
-	for (int i = 0; i < itservice->status_rules.values_num; i++)
+	while (SUCCEED != zbx_binary_heap_empty(&dirty_queue->queue))
 	{
-		zbx_service_rule_t	*rule = itservice->status_rules.values[i];
+		zbx_service_children_stats_t	stats;
+		zbx_service_dirty_t		*dirty;
+		zbx_service_t			*itservice;
+		int				status, rule_status;
 
-		if (status < (rule_status = service_get_rule_status(itservice, rule)))
-			status = rule_status;
-	}
+		dirty = (zbx_service_dirty_t *)zbx_binary_heap_find_min(&dirty_queue->queue)->data;
+		zbx_binary_heap_remove_min(&dirty_queue->queue);
 
-	if (itservice->status != status)
-	{
-		zbx_service_update_t	*update;
+		itservice = dirty->service;
 
-		update = update_service(service_updates, itservice, status, ts);
-		update->alarm = its_updates_append(alarms, itservice->serviceid, status, ts->sec);
+		service_get_children_stats(itservice, &stats);
+		status = service_stats_get_main_status(itservice, &stats);
 
-		/* update parent services */
-		for (int i = 0; i < itservice->parents.values_num; i++)
+		for (int i = 0; i < itservice->status_rules.values_num; i++)
 		{
-			its_itservice_update_status(itservice->parents.values[i], ts, alarms,
-					service_updates, flags);
+			zbx_service_rule_t	*rule = itservice->status_rules.values[i];
+
+			if (status < (rule_status = service_stats_get_rule_status(&stats, rule)))
+				status = rule_status;
 		}
-	}
-	else if (0 != (ZBX_FLAG_SERVICE_RECALCULATE & flags))
-	{
-		/* update parent services */
-		for (int i = 0; i < itservice->parents.values_num; i++)
+
+		if (itservice->status != status)
 		{
-			its_itservice_update_status((zbx_service_t *)itservice->parents.values[i], ts, alarms,
-					service_updates, flags);
+			zbx_service_update_t	*update;
+
+			update = update_service(service_updates, itservice, status, &dirty->ts);
+			update->alarm = its_updates_append(alarms, itservice->serviceid, status, dirty->ts.sec);
+
+			service_dirty_queue_add_parents(dirty_queue, itservice, &dirty->ts, dirty->flags);
 		}
+		else if (0 != (ZBX_FLAG_SERVICE_RECALCULATE & dirty->flags))
+			service_dirty_queue_add_parents(dirty_queue, itservice, &dirty->ts, dirty->flags);
 	}
 }
 
@@ -2552,9 +2742,11 @@ static void	db_update_services(zbx_service_manager_t *manager)
 	zbx_vector_service_problem_ptr_t	service_problems_new;
 	zbx_vector_uint64_t			service_problemids;
 	zbx_hashset_t				service_updates;
+	zbx_service_dirty_queue_t		dirty_queue;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	service_dirty_queue_init(&dirty_queue);
 	zbx_vector_status_update_ptr_create(&alarms);
 	zbx_vector_service_problem_ptr_create(&service_problems_new);
 	zbx_vector_uint64_create(&service_problemids);
@@ -2682,24 +2874,15 @@ static void	db_update_services(zbx_service_manager_t *manager)
 			update = update_service(&service_updates, service, status, &ts);
 			update->alarm = its_updates_append(&alarms, service->serviceid, service->status, ts.sec);
 
-			/* update parent services */
-			for (int i = 0; i < service->parents.values_num; i++)
-			{
-				its_itservice_update_status((zbx_service_t *)service->parents.values[i], &ts, &alarms,
-						&service_updates, service_diff->flags);
-			}
+			service_dirty_queue_add_parents(&dirty_queue, service, &ts, service_diff->flags);
 		}
 		else if (0 != (ZBX_FLAG_SERVICE_RECALCULATE & service_diff->flags))
-		{
-			/* update parent services */
-			for (int i = 0; i < service->parents.values_num; i++)
-			{
-				its_itservice_update_status((zbx_service_t *)service->parents.values[i], &ts, &alarms,
-						&service_updates, service_diff->flags);
-			}
-		}
+			service_dirty_queue_add_parents(&dirty_queue, service, &ts, service_diff->flags);
 	}
 
+	/* update parent services */
+	its_itservices_update_status(&dirty_queue, &alarms, &service_updates);
+
 	do
 	{
 		zbx_db_begin();
@@ -2715,6 +2898,7 @@ static void	db_update_services(zbx_service_manager_t *manager)
 	zbx_hashset_destroy(&service_updates);
 	zbx_vector_status_update_ptr_clear_ext(&alarms, zbx_status_update_free);
 	zbx_vector_status_update_ptr_destroy(&alarms);
+	service_dirty_queue_destroy(&dirty_queue);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
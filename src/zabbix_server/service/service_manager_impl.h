@@ -108,6 +108,9 @@ struct zbx_service_s
 	int					weight;
 	int					propagation_rule;
 	int					propagation_value;
+
+	/* the longest path to a leaf service, -1 if not calculated */
+	int					level;
 };
 
 ZBX_PTR_VECTOR_FUNC_DECL(service_ptr, zbx_service_t *)
@@ -36,6 +36,7 @@
 #define ZBX_SNMP_OID_TYPE_MACRO		2
 #define ZBX_SNMP_OID_TYPE_WALK		3
 #define ZBX_SNMP_OID_TYPE_GET		4
+#define ZBX_SNMP_OID_TYPE_DISCOVERY	5
 
 /* defines from dbconfig.c */
 #define ZBX_ITEM_COLLECTED		0x01
@@ -237,6 +238,8 @@ void	zbx_mock_test_entry(void **state)
 				snmpitem->snmp_oid_type = ZBX_SNMP_OID_TYPE_WALK;
 			else if (0 == strncmp(snmpitem->snmp_oid, "get[", ZBX_CONST_STRLEN("get[")))
 				snmpitem->snmp_oid_type = ZBX_SNMP_OID_TYPE_GET;
+			else if (0 == strncmp(snmpitem->snmp_oid, "discovery[", ZBX_CONST_STRLEN("discovery[")))
+				snmpitem->snmp_oid_type = ZBX_SNMP_OID_TYPE_DISCOVERY;
 			else if (NULL != strchr(snmpitem->snmp_oid, '{'))
 				snmpitem->snmp_oid_type = ZBX_SNMP_OID_TYPE_MACRO;
 			else if (NULL != strchr(snmpitem->snmp_oid, '['))
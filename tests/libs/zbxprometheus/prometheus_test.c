@@ -90,7 +90,7 @@ int	zbx_prometheus_row_parse(const char *data, char **metric, zbx_vector_ptr_pai
 		return FAIL;
 	}
 
-	if (FAIL == prometheus_parse_row(&filter, data, 0, &prow, loc, error))
+	if (FAIL == prometheus_parse_row(&filter, data, 0, NULL, &prow, loc, error))
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "failed to parse prometheus row: %s", *error);
 		return FAIL;
@@ -0,0 +1,91 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdata.h"
+#include "zbxcommon.h"
+
+#include "zbxalgo.h"
+
+#include "../../../src/zabbix_server/lld/lld.c"
+#include "../../../src/zabbix_server/lld/lld_manager.c"
+
+#define LLD_RULEID	1
+
+static zbx_uint64_t	value_fingerprint(const char *value, int lifetime_duration)
+{
+	zbx_lld_filter_t		filter;
+	zbx_vector_lld_macro_path_ptr_t	lld_macro_paths;
+	zbx_vector_lld_override_ptr_t	overrides;
+	zbx_vector_lld_row_ptr_t	lld_rows;
+	zbx_lld_lifetime_t		lifetime = {ZBX_LLD_LIFETIME_TYPE_AFTER, lifetime_duration},
+					enabled_lifetime = {ZBX_LLD_LIFETIME_TYPE_NEVER, 0};
+	zbx_uint64_t			fingerprint;
+	char				*info = NULL, *error = NULL;
+
+	lld_filter_init(&filter);
+	zbx_vector_lld_macro_path_ptr_create(&lld_macro_paths);
+	zbx_vector_lld_override_ptr_create(&overrides);
+	zbx_vector_lld_row_ptr_create(&lld_rows);
+
+	if (SUCCEED != lld_rows_get(value, &filter, &lld_rows, &lld_macro_paths, &overrides, &info, &error))
+		fail_msg("Cannot get rows of value \"%s\": %s", value, error);
+
+	fingerprint = lld_rows_fingerprint(&lld_rows, &filter, &lld_macro_paths, &overrides, &lifetime,
+			&enabled_lifetime);
+
+	zbx_mock_assert_uint64_ne("value fingerprint", 0, fingerprint);
+
+	zbx_vector_lld_row_ptr_clear_ext(&lld_rows, lld_row_free);
+	zbx_vector_lld_row_ptr_destroy(&lld_rows);
+	zbx_vector_lld_override_ptr_destroy(&overrides);
+	zbx_vector_lld_macro_path_ptr_destroy(&lld_macro_paths);
+	lld_filter_clean(&filter);
+	zbx_free(info);
+
+	return fingerprint;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_lld_manager_t	manager;
+	zbx_uint64_t		fingerprint, sent;
+	int			processed;
+
+	ZBX_UNUSED(state);
+
+	memset(&manager, 0, sizeof(manager));
+	zbx_hashset_create(&manager.fingerprints, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	manager.skip_period = (int)zbx_mock_get_parameter_uint64("in.skip_period");
+
+	/* the last value is fully processed and its fingerprint is remembered by manager */
+	fingerprint = value_fingerprint(zbx_mock_get_parameter_string("in.value"),
+			(int)zbx_mock_get_parameter_uint64("in.lifetime"));
+	lld_update_fingerprint(&manager, LLD_RULEID, fingerprint, 0,
+			(int)zbx_mock_get_parameter_uint64("in.processed"));
+
+	/* the next value is skipped if its fingerprint matches the one sent to worker */
+	sent = lld_get_fingerprint(&manager, LLD_RULEID, (int)zbx_mock_get_parameter_uint64("in.checked"));
+	fingerprint = value_fingerprint(zbx_mock_get_parameter_string("in.new_value"),
+			(int)zbx_mock_get_parameter_uint64("in.new_lifetime"));
+
+	processed = (sent != fingerprint ? SUCCEED : FAIL);
+
+	zbx_mock_assert_result_eq("new value processing", zbx_mock_str_to_return_code(
+			zbx_mock_get_parameter_string("out.processed")), processed);
+
+	zbx_hashset_destroy(&manager.fingerprints);
+}
@@ -0,0 +1,198 @@
+/*
+** Copyright (C) 2001-2024 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdata.h"
+#include "zbxcommon.h"
+
+#include "zbxalgo.h"
+
+#include "../../../src/zabbix_server/lld/lld.c"
+#include "../../../src/zabbix_server/lld/lld_manager.c"
+
+typedef struct
+{
+	zbx_uint64_t	id;
+	int		lastcheck;
+}
+zbx_mock_lld_object_t;
+
+ZBX_VECTOR_DECL(mock_lld_object, zbx_mock_lld_object_t)
+ZBX_VECTOR_IMPL(mock_lld_object, zbx_mock_lld_object_t)
+
+/* gets sorted ids ({#ID} macro values) of value rows */
+static void	value_get_ids(const char *value, zbx_vector_uint64_t *ids)
+{
+	zbx_lld_filter_t		filter;
+	zbx_vector_lld_macro_path_ptr_t	lld_macro_paths;
+	zbx_vector_lld_override_ptr_t	overrides;
+	zbx_vector_lld_row_ptr_t	lld_rows;
+	char				*info = NULL, *error = NULL, buf[MAX_ID_LEN + 1];
+	zbx_uint64_t			id;
+
+	lld_filter_init(&filter);
+	zbx_vector_lld_macro_path_ptr_create(&lld_macro_paths);
+	zbx_vector_lld_override_ptr_create(&overrides);
+	zbx_vector_lld_row_ptr_create(&lld_rows);
+
+	if (SUCCEED != lld_rows_get(value, &filter, &lld_rows, &lld_macro_paths, &overrides, &info, &error))
+		fail_msg("Cannot get rows of value \"%s\": %s", value, error);
+
+	for (int i = 0; i < lld_rows.values_num; i++)
+	{
+		if (SUCCEED != zbx_json_value_by_name(&lld_rows.values[i]->jp_row, "{#ID}", buf, sizeof(buf), NULL) ||
+				SUCCEED != zbx_is_uint64(buf, &id))
+		{
+			fail_msg("Cannot get {#ID} macro of value \"%s\" row", value);
+		}
+
+		zbx_vector_uint64_append(ids, id);
+	}
+
+	zbx_vector_uint64_sort(ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_vector_lld_row_ptr_clear_ext(&lld_rows, lld_row_free);
+	zbx_vector_lld_row_ptr_destroy(&lld_rows);
+	zbx_vector_lld_override_ptr_destroy(&overrides);
+	zbx_vector_lld_macro_path_ptr_destroy(&lld_macro_paths);
+	lld_filter_clean(&filter);
+	zbx_free(info);
+}
+
+/* gets sorted ids of objects lost after processing rows with the specified ids */
+static void	objects_get_lost(const zbx_vector_mock_lld_object_t *objects, const zbx_vector_uint64_t *row_ids,
+		int discovered_since, zbx_vector_uint64_t *lost)
+{
+	for (int i = 0; i < objects->values_num; i++)
+	{
+		const zbx_mock_lld_object_t	*object = &objects->values[i];
+		int				discovery_flag;
+
+		discovery_flag = (FAIL != zbx_vector_uint64_bsearch(row_ids, object->id,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC));
+
+		if (SUCCEED == lld_object_is_lost(discovery_flag, object->lastcheck, discovered_since))
+			zbx_vector_uint64_append(lost, object->id);
+	}
+
+	zbx_vector_uint64_sort(lost, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char			*value;
+	zbx_mock_handle_t		hobjects, hobject, hlost, hid;
+	zbx_vector_mock_lld_object_t	objects;
+	zbx_vector_uint64_t		row_ids, partition_ids, lost_exp, lost_whole, lost_merged, empty;
+	zbx_vector_str_t		partitions;
+	int				partitions_lastcheck, partitions_num;
+
+	ZBX_UNUSED(state);
+
+	zbx_vector_mock_lld_object_create(&objects);
+	zbx_vector_uint64_create(&row_ids);
+	zbx_vector_uint64_create(&partition_ids);
+	zbx_vector_uint64_create(&lost_exp);
+	zbx_vector_uint64_create(&lost_whole);
+	zbx_vector_uint64_create(&lost_merged);
+	zbx_vector_uint64_create(&empty);
+	zbx_vector_str_create(&partitions);
+
+	value = zbx_mock_get_parameter_string("in.value");
+	partitions_lastcheck = (int)zbx_mock_get_parameter_uint64("in.partitions_lastcheck");
+
+	hobjects = zbx_mock_get_parameter_handle("in.objects");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hobjects, &hobject))
+	{
+		zbx_mock_lld_object_t	object;
+
+		object.id = zbx_mock_get_object_member_uint64(hobject, "id");
+		object.lastcheck = (int)zbx_mock_get_object_member_uint64(hobject, "lastcheck");
+		zbx_vector_mock_lld_object_append(&objects, object);
+	}
+
+	hlost = zbx_mock_get_parameter_handle("out.lost");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hlost, &hid))
+	{
+		zbx_uint64_t	id;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hid, &id))
+			fail_msg("Cannot read lost object id");
+
+		zbx_vector_uint64_append(&lost_exp, id);
+	}
+
+	zbx_vector_uint64_sort(&lost_exp, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	/* the whole value discovers objects of its rows and processes the rest as lost */
+	value_get_ids(value, &row_ids);
+	objects_get_lost(&objects, &row_ids, 0, &lost_whole);
+	zbx_mock_assert_vector_uint64_eq("objects lost by whole value", &lost_exp, &lost_whole);
+
+	if (SUCCEED == lld_value_split(value, (int)zbx_mock_get_parameter_uint64("in.partition_size"),
+			(int)zbx_mock_get_parameter_uint64("in.workers"), &partitions))
+	{
+		partitions_num = partitions.values_num;
+	}
+	else
+		partitions_num = 0;
+
+	zbx_mock_assert_int_eq("number of partitions", (int)zbx_mock_get_parameter_uint64("out.partitions"),
+			partitions_num);
+
+	if (0 != partitions_num)
+	{
+		/* partitions update lastcheck of the objects discovered by their rows */
+		for (int i = 0; i < partitions.values_num; i++)
+		{
+			zbx_vector_uint64_clear(&row_ids);
+			value_get_ids(partitions.values[i], &row_ids);
+
+			for (int j = 0; j < objects.values_num; j++)
+			{
+				if (FAIL != zbx_vector_uint64_bsearch(&row_ids, objects.values[j].id,
+						ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+				{
+					objects.values[j].lastcheck = partitions_lastcheck;
+				}
+			}
+
+			zbx_vector_uint64_append_array(&partition_ids, row_ids.values, row_ids.values_num);
+		}
+
+		/* every row must be processed by exactly one partition */
+		zbx_vector_uint64_clear(&row_ids);
+		value_get_ids(value, &row_ids);
+		zbx_vector_uint64_sort(&partition_ids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_mock_assert_vector_uint64_eq("rows of partitions", &row_ids, &partition_ids);
+
+		/* merge pass has no discovered rows and processes objects not checked by partitions */
+		objects_get_lost(&objects, &empty, partitions_lastcheck, &lost_merged);
+		zbx_mock_assert_vector_uint64_eq("objects lost by partitioned value", &lost_whole, &lost_merged);
+	}
+
+	zbx_vector_str_clear_ext(&partitions, zbx_str_free);
+	zbx_vector_str_destroy(&partitions);
+	zbx_vector_uint64_destroy(&empty);
+	zbx_vector_uint64_destroy(&lost_merged);
+	zbx_vector_uint64_destroy(&lost_whole);
+	zbx_vector_uint64_destroy(&lost_exp);
+	zbx_vector_uint64_destroy(&partition_ids);
+	zbx_vector_uint64_destroy(&row_ids);
+	zbx_vector_mock_lld_object_destroy(&objects);
+}